@@ -510,6 +510,7 @@ static int __kprobes do_page_fault(unsigned long far, unsigned long esr,
 	unsigned int mm_flags = FAULT_FLAG_DEFAULT;
 	unsigned long addr = untagged_addr(far);
 	struct vm_area_struct *vma;
+	bool vma_lock_retried = false;
 	int si_code;
 
 	if (kprobe_page_fault(regs, esr))
@@ -564,6 +565,7 @@ static int __kprobes do_page_fault(unsigned long far, unsigned long esr,
 	if (!(mm_flags & FAULT_FLAG_USER))
 		goto lock_mmap;
 
+retry_vma:
 	vma = lock_vma_under_rcu(mm, addr);
 	if (!vma)
 		goto lock_mmap;
@@ -593,6 +595,15 @@ static int __kprobes do_page_fault(unsigned long far, unsigned long esr,
 			goto no_context;
 		return 0;
 	}
+
+	/* Retry once under the VMA lock if it was only dropped to wait */
+	if (!(fault & VM_FAULT_MMAP_LOCK) && !vma_lock_retried) {
+		vma_lock_retried = true;
+		mm_flags |= FAULT_FLAG_TRIED;
+		goto retry_vma;
+	}
+	if (!(fault & VM_FAULT_MMAP_LOCK))
+		count_vm_vma_lock_event(VMA_LOCK_FALLBACK_RETRY);
 lock_mmap:
 
 retry:
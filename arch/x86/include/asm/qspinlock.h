@@ -34,6 +34,13 @@ extern void __pv_queued_spin_lock_slowpath(struct qspinlock *lock, u32 val);
 extern void __raw_callee_save___pv_queued_spin_unlock(struct qspinlock *lock);
 extern bool nopvspin;
 
+#ifdef CONFIG_NUMA
+/* NUMA-aware slowpath, replaces the native one with numa_spinlock=on */
+#define __ARCH_HAS_CNA_SPINLOCK
+extern void __cna_queued_spin_lock_slowpath(struct qspinlock *lock, u32 val);
+extern void cna_configure_spin_lock_slowpath(void);
+#endif
+
 #define	queued_spin_unlock queued_spin_unlock
 /**
  * queued_spin_unlock - release a queued spinlock
@@ -109,6 +116,10 @@ static inline bool virt_spin_lock(struct qspinlock *lock)
 
 #endif /* CONFIG_PARAVIRT */
 
+#ifndef __ARCH_HAS_CNA_SPINLOCK
+static inline void cna_configure_spin_lock_slowpath(void) { }
+#endif
+
 #include <asm-generic/qspinlock.h>
 
 #endif /* _ASM_X86_QSPINLOCK_H */
@@ -2365,6 +2365,12 @@ void __init arch_cpu_finalize_init(void)
 	*c = boot_cpu_data;
 	c->initialized = true;
 
+	/*
+	 * Pick the spinlock slowpath while only the boot CPU can take locks
+	 * and before the paravirt call sites get patched.
+	 */
+	cna_configure_spin_lock_slowpath();
+
 	alternative_instructions();
 
 	if (IS_ENABLED(CONFIG_X86_64)) {
@@ -1217,6 +1217,7 @@ void do_user_addr_fault(struct pt_regs *regs,
 	struct mm_struct *mm;
 	vm_fault_t fault;
 	unsigned int flags = FAULT_FLAG_DEFAULT;
+	bool vma_lock_retried = false;
 
 	tsk = current;
 	mm = tsk->mm;
@@ -1326,6 +1327,7 @@ void do_user_addr_fault(struct pt_regs *regs,
 	if (!(flags & FAULT_FLAG_USER))
 		goto lock_mmap;
 
+retry_vma:
 	vma = lock_vma_under_rcu(mm, address);
 	if (!vma)
 		goto lock_mmap;
@@ -1355,6 +1357,19 @@ void do_user_addr_fault(struct pt_regs *regs,
 						 ARCH_DEFAULT_PKEY);
 		return;
 	}
+
+	/*
+	 * Unless the handler needs the mmap_lock, it only dropped the VMA
+	 * lock to wait for I/O or for a userfaultfd reply: once that is done
+	 * the retry can usually be satisfied under the VMA lock again.
+	 */
+	if (!(fault & VM_FAULT_MMAP_LOCK) && !vma_lock_retried) {
+		vma_lock_retried = true;
+		flags |= FAULT_FLAG_TRIED;
+		goto retry_vma;
+	}
+	if (!(fault & VM_FAULT_MMAP_LOCK))
+		count_vm_vma_lock_event(VMA_LOCK_FALLBACK_RETRY);
 lock_mmap:
 
 retry:
@@ -105,6 +105,58 @@ int crypto_aead_decrypt(struct aead_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_aead_decrypt);
 
+static int crypto_aead_batch(struct aead_request **reqs, int *errs,
+			     unsigned int nr, bool encrypt)
+{
+	struct crypto_aead *aead;
+	struct aead_alg *alg;
+	void (*batch)(struct aead_request **reqs, int *errs, unsigned int nr);
+	unsigned int i;
+
+	if (!nr)
+		return 0;
+
+	aead = crypto_aead_reqtfm(reqs[0]);
+	for (i = 1; i < nr; i++)
+		if (crypto_aead_reqtfm(reqs[i]) != aead)
+			return -EINVAL;
+
+	if (crypto_aead_get_flags(aead) & CRYPTO_TFM_NEED_KEY)
+		return -ENOKEY;
+
+	alg = crypto_aead_alg(aead);
+	batch = encrypt ? alg->encrypt_batch : alg->decrypt_batch;
+
+	/* a request too short for its tag fails alone, the slow way */
+	for (i = 0; batch && !encrypt && i < nr; i++)
+		if (reqs[i]->cryptlen < crypto_aead_authsize(aead))
+			batch = NULL;
+
+	if (batch) {
+		batch(reqs, errs, nr);
+		return 0;
+	}
+
+	for (i = 0; i < nr; i++)
+		errs[i] = encrypt ? crypto_aead_encrypt(reqs[i]) :
+				    crypto_aead_decrypt(reqs[i]);
+	return 0;
+}
+
+int crypto_aead_encrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr)
+{
+	return crypto_aead_batch(reqs, errs, nr, true);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_encrypt_batch);
+
+int crypto_aead_decrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr)
+{
+	return crypto_aead_batch(reqs, errs, nr, false);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_decrypt_batch);
+
 static void crypto_aead_exit_tfm(struct crypto_tfm *tfm)
 {
 	struct crypto_aead *aead = __crypto_aead_cast(tfm);
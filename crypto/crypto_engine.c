@@ -256,6 +256,27 @@ static int crypto_transfer_request(struct crypto_engine *engine,
 	return ret;
 }
 
+/*
+ * Queue @nr requests under one acquisition of the queue lock and kick the
+ * pump once, @errs[i] gets the result of crypto_enqueue_request().
+ */
+#define crypto_transfer_requests(engine, reqs, errs, nr)		\
+do {									\
+	unsigned long __flags;						\
+	unsigned int __i;						\
+									\
+	spin_lock_irqsave(&(engine)->queue_lock, __flags);		\
+	for (__i = 0; __i < (nr); __i++)				\
+		(errs)[__i] = (engine)->running ?			\
+			crypto_enqueue_request(&(engine)->queue,	\
+					       &(reqs)[__i]->base) :	\
+			-ESHUTDOWN;					\
+	if ((engine)->running && !(engine)->busy)			\
+		kthread_queue_work((engine)->kworker,			\
+				   &(engine)->pump_requests);		\
+	spin_unlock_irqrestore(&(engine)->queue_lock, __flags);	\
+} while (0)
+
 /**
  * crypto_transfer_request_to_engine - transfer one request to list
  * into the engine queue
@@ -281,6 +302,22 @@ int crypto_transfer_aead_request_to_engine(struct crypto_engine *engine,
 }
 EXPORT_SYMBOL_GPL(crypto_transfer_aead_request_to_engine);
 
+/**
+ * crypto_transfer_aead_requests_to_engine - transfer a vector of
+ * aead_requests to list into the engine queue
+ * @engine: the hardware engine
+ * @reqs: the requests need to be listed into the engine queue
+ * @errs: receives the queueing result of each request
+ * @nr: number of requests
+ */
+void crypto_transfer_aead_requests_to_engine(struct crypto_engine *engine,
+					     struct aead_request **reqs,
+					     int *errs, unsigned int nr)
+{
+	crypto_transfer_requests(engine, reqs, errs, nr);
+}
+EXPORT_SYMBOL_GPL(crypto_transfer_aead_requests_to_engine);
+
 /**
  * crypto_transfer_akcipher_request_to_engine - transfer one akcipher_request
  * to list into the engine queue
@@ -333,6 +370,22 @@ int crypto_transfer_skcipher_request_to_engine(struct crypto_engine *engine,
 }
 EXPORT_SYMBOL_GPL(crypto_transfer_skcipher_request_to_engine);
 
+/**
+ * crypto_transfer_skcipher_requests_to_engine - transfer a vector of
+ * skcipher_requests to list into the engine queue
+ * @engine: the hardware engine
+ * @reqs: the requests need to be listed into the engine queue
+ * @errs: receives the queueing result of each request
+ * @nr: number of requests
+ */
+void crypto_transfer_skcipher_requests_to_engine(struct crypto_engine *engine,
+						 struct skcipher_request **reqs,
+						 int *errs, unsigned int nr)
+{
+	crypto_transfer_requests(engine, reqs, errs, nr);
+}
+EXPORT_SYMBOL_GPL(crypto_transfer_skcipher_requests_to_engine);
+
 /**
  * crypto_finalize_aead_request - finalize one aead_request if
  * the request is done
@@ -15,22 +15,58 @@
 #include <linux/slab.h>
 #include <linux/kobject.h>
 #include <linux/cpu.h>
+#include <linux/nodemask.h>
 #include <crypto/pcrypt.h>
 
+/*
+ * By default all tfms of an instance share one reorder pipeline per
+ * direction, so a slow request of one SA holds back the completions of
+ * all others. With per_tfm_order every tfm gets its own padata shell and
+ * only waits for its own requests.
+ *
+ * With numa_local, there are padata instances restricted to the CPUs of
+ * each node in addition to the global ones, and a tfm stays on the node
+ * it was allocated on, for both its parallel and its serial work.
+ */
+static bool per_tfm_order;
+module_param(per_tfm_order, bool, 0644);
+MODULE_PARM_DESC(per_tfm_order, "Order the requests of each tfm separately");
+
+static bool numa_local;
+module_param(numa_local, bool, 0444);
+MODULE_PARM_DESC(numa_local, "Keep a tfm on the CPUs of the node it was allocated on");
+
 static struct padata_instance *pencrypt;
 static struct padata_instance *pdecrypt;
 static struct kset           *pcrypt_kset;
 
+struct pcrypt_node {
+	struct padata_instance *pencrypt;
+	struct padata_instance *pdecrypt;
+};
+
+/* nr_node_ids entries if numa_local is in effect, else NULL */
+static struct pcrypt_node *pcrypt_nodes;
+
+struct pcrypt_shells {
+	struct padata_shell *psenc;
+	struct padata_shell *psdec;
+};
+
 struct pcrypt_instance_ctx {
 	struct crypto_aead_spawn spawn;
 	struct padata_shell *psenc;
 	struct padata_shell *psdec;
+	struct pcrypt_shells *node_shells;
 	atomic_t tfm_count;
 };
 
 struct pcrypt_aead_ctx {
 	struct crypto_aead *child;
 	unsigned int cb_cpu;
+	struct padata_shell *psenc;
+	struct padata_shell *psdec;
+	bool own_shells;
 };
 
 static inline struct pcrypt_instance_ctx *pcrypt_tfm_ictx(
@@ -114,7 +150,10 @@ static int pcrypt_aead_encrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psenc, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ctx->psenc, padata, &ctx->cb_cpu);
+	/* the CPUs of our node are all gone, the global instance has others */
+	if (err == -EINVAL && ctx->psenc != ictx->psenc)
+		err = padata_do_parallel(ictx->psenc, padata, &ctx->cb_cpu);
 	if (!err)
 		return -EINPROGRESS;
 	if (err == -EBUSY)
@@ -163,7 +202,9 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 			       req->cryptlen, req->iv);
 	aead_request_set_ad(creq, req->assoclen);
 
-	err = padata_do_parallel(ictx->psdec, padata, &ctx->cb_cpu);
+	err = padata_do_parallel(ctx->psdec, padata, &ctx->cb_cpu);
+	if (err == -EINVAL && ctx->psdec != ictx->psdec)
+		err = padata_do_parallel(ictx->psdec, padata, &ctx->cb_cpu);
 	if (!err)
 		return -EINPROGRESS;
 	if (err == -EBUSY)
@@ -172,25 +213,62 @@ static int pcrypt_aead_decrypt(struct aead_request *req)
 	return err;
 }
 
+static void pcrypt_free_shells(struct pcrypt_aead_ctx *ctx)
+{
+	if (!ctx->own_shells)
+		return;
+
+	padata_free_shell(ctx->psdec);
+	padata_free_shell(ctx->psenc);
+}
+
 static int pcrypt_aead_init_tfm(struct crypto_aead *tfm)
 {
 	int cpu, cpu_index;
 	struct aead_instance *inst = aead_alg_instance(tfm);
 	struct pcrypt_instance_ctx *ictx = aead_instance_ctx(inst);
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	struct padata_instance *penc = pencrypt, *pdec = pdecrypt;
+	const struct cpumask *cpus = cpu_online_mask;
 	struct crypto_aead *cipher;
+	int node = numa_node_id();
+
+	ctx->psenc = ictx->psenc;
+	ctx->psdec = ictx->psdec;
+	if (ictx->node_shells && ictx->node_shells[node].psenc) {
+		penc = pcrypt_nodes[node].pencrypt;
+		pdec = pcrypt_nodes[node].pdecrypt;
+		ctx->psenc = ictx->node_shells[node].psenc;
+		ctx->psdec = ictx->node_shells[node].psdec;
+		if (cpumask_intersects(cpumask_of_node(node), cpu_online_mask))
+			cpus = cpumask_of_node(node);
+	}
+
+	if (READ_ONCE(per_tfm_order)) {
+		ctx->psenc = padata_alloc_shell(penc);
+		ctx->psdec = padata_alloc_shell(pdec);
+		ctx->own_shells = true;
+		if (!ctx->psenc || !ctx->psdec) {
+			pcrypt_free_shells(ctx);
+			return -ENOMEM;
+		}
+	}
 
+	/* padata_do_parallel() fixes it up if it's not a callback CPU */
 	cpu_index = (unsigned int)atomic_inc_return(&ictx->tfm_count) %
-		    cpumask_weight(cpu_online_mask);
+		    cpumask_weight_and(cpus, cpu_online_mask);
 
-	ctx->cb_cpu = cpumask_first(cpu_online_mask);
+	ctx->cb_cpu = cpumask_first_and(cpus, cpu_online_mask);
 	for (cpu = 0; cpu < cpu_index; cpu++)
-		ctx->cb_cpu = cpumask_next(ctx->cb_cpu, cpu_online_mask);
+		ctx->cb_cpu = cpumask_next_and(ctx->cb_cpu, cpus,
+					       cpu_online_mask);
 
 	cipher = crypto_spawn_aead(&ictx->spawn);
 
-	if (IS_ERR(cipher))
+	if (IS_ERR(cipher)) {
+		pcrypt_free_shells(ctx);
 		return PTR_ERR(cipher);
+	}
 
 	ctx->child = cipher;
 	crypto_aead_set_reqsize(tfm, sizeof(struct pcrypt_request) +
@@ -205,18 +283,54 @@ static void pcrypt_aead_exit_tfm(struct crypto_aead *tfm)
 	struct pcrypt_aead_ctx *ctx = crypto_aead_ctx(tfm);
 
 	crypto_free_aead(ctx->child);
+	pcrypt_free_shells(ctx);
 }
 
 static void pcrypt_free(struct aead_instance *inst)
 {
 	struct pcrypt_instance_ctx *ctx = aead_instance_ctx(inst);
+	int node;
 
 	crypto_drop_aead(&ctx->spawn);
+	if (ctx->node_shells) {
+		for_each_node(node) {
+			padata_free_shell(ctx->node_shells[node].psdec);
+			padata_free_shell(ctx->node_shells[node].psenc);
+		}
+		kfree(ctx->node_shells);
+	}
 	padata_free_shell(ctx->psdec);
 	padata_free_shell(ctx->psenc);
 	kfree(inst);
 }
 
+static int pcrypt_alloc_node_shells(struct pcrypt_instance_ctx *ctx)
+{
+	int node;
+
+	if (!pcrypt_nodes)
+		return 0;
+
+	ctx->node_shells = kcalloc(nr_node_ids, sizeof(*ctx->node_shells),
+				   GFP_KERNEL);
+	if (!ctx->node_shells)
+		return -ENOMEM;
+
+	for_each_node(node) {
+		if (!pcrypt_nodes[node].pencrypt)
+			continue;
+		ctx->node_shells[node].psenc =
+			padata_alloc_shell(pcrypt_nodes[node].pencrypt);
+		ctx->node_shells[node].psdec =
+			padata_alloc_shell(pcrypt_nodes[node].pdecrypt);
+		if (!ctx->node_shells[node].psenc ||
+		    !ctx->node_shells[node].psdec)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static int pcrypt_init_instance(struct crypto_instance *inst,
 				struct crypto_alg *alg)
 {
@@ -257,6 +371,10 @@ static int pcrypt_create_aead(struct crypto_template *tmpl, struct rtattr **tb,
 	if (!ctx->psdec)
 		goto err_free_inst;
 
+	err = pcrypt_alloc_node_shells(ctx);
+	if (err)
+		goto err_free_inst;
+
 	err = crypto_grab_aead(&ctx->spawn, aead_crypto_instance(inst),
 			       crypto_attr_alg_name(tb[1]), 0, mask);
 	if (err)
@@ -335,6 +453,82 @@ static int pcrypt_init_padata(struct padata_instance **pinst, const char *name)
 	return ret;
 }
 
+static void pcrypt_free_nodes(void)
+{
+	int node;
+
+	if (!pcrypt_nodes)
+		return;
+
+	for_each_node(node) {
+		if (pcrypt_nodes[node].pdecrypt)
+			padata_free(pcrypt_nodes[node].pdecrypt);
+		if (pcrypt_nodes[node].pencrypt)
+			padata_free(pcrypt_nodes[node].pencrypt);
+	}
+	kfree(pcrypt_nodes);
+	pcrypt_nodes = NULL;
+}
+
+static int pcrypt_init_node_padata(struct padata_instance **pinst,
+				   const char *prefix, int node,
+				   struct cpumask *mask)
+{
+	char name[16];
+	int ret;
+
+	snprintf(name, sizeof(name), "%s%d", prefix, node);
+	ret = pcrypt_init_padata(pinst, name);
+	if (ret) {
+		*pinst = NULL;
+		return ret;
+	}
+
+	ret = padata_set_cpumask(*pinst, PADATA_CPU_PARALLEL, mask);
+	if (!ret)
+		ret = padata_set_cpumask(*pinst, PADATA_CPU_SERIAL, mask);
+	return ret;
+}
+
+/* The per node instances are optional, failing to set them up isn't fatal */
+static void pcrypt_init_nodes(void)
+{
+	cpumask_var_t mask;
+	int node, ret = -ENOMEM;
+
+	if (!numa_local || num_node_state(N_CPU) < 2)
+		return;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		goto err;
+
+	pcrypt_nodes = kcalloc(nr_node_ids, sizeof(*pcrypt_nodes), GFP_KERNEL);
+	if (!pcrypt_nodes)
+		goto err_free_mask;
+
+	for_each_node_with_cpus(node) {
+		cpumask_copy(mask, cpumask_of_node(node));
+		ret = pcrypt_init_node_padata(&pcrypt_nodes[node].pencrypt,
+					      "pencrypt", node, mask);
+		if (!ret)
+			ret = pcrypt_init_node_padata(&pcrypt_nodes[node].pdecrypt,
+						      "pdecrypt", node, mask);
+		if (ret)
+			break;
+	}
+
+	free_cpumask_var(mask);
+	if (!ret)
+		return;
+	pcrypt_free_nodes();
+	goto err;
+
+err_free_mask:
+	free_cpumask_var(mask);
+err:
+	pr_warn("pcrypt: NUMA local instances disabled: %d\n", ret);
+}
+
 static struct crypto_template pcrypt_tmpl = {
 	.name = "pcrypt",
 	.create = pcrypt_create,
@@ -357,8 +551,14 @@ static int __init pcrypt_init(void)
 	if (err)
 		goto err_deinit_pencrypt;
 
-	return crypto_register_template(&pcrypt_tmpl);
+	pcrypt_init_nodes();
+
+	err = crypto_register_template(&pcrypt_tmpl);
+	if (!err)
+		return 0;
 
+	pcrypt_free_nodes();
+	padata_free(pdecrypt);
 err_deinit_pencrypt:
 	padata_free(pencrypt);
 err_unreg_kset:
@@ -371,6 +571,7 @@ static void __exit pcrypt_exit(void)
 {
 	crypto_unregister_template(&pcrypt_tmpl);
 
+	pcrypt_free_nodes();
 	padata_free(pencrypt);
 	padata_free(pdecrypt);
 
@@ -657,6 +657,56 @@ int crypto_skcipher_decrypt(struct skcipher_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt);
 
+static int crypto_skcipher_batch(struct skcipher_request **reqs, int *errs,
+				 unsigned int nr, bool encrypt)
+{
+	struct crypto_skcipher *tfm;
+	struct skcipher_alg *alg;
+	void (*batch)(struct skcipher_request **reqs, int *errs,
+		      unsigned int nr);
+	unsigned int i;
+
+	if (!nr)
+		return 0;
+
+	tfm = crypto_skcipher_reqtfm(reqs[0]);
+	for (i = 1; i < nr; i++)
+		if (crypto_skcipher_reqtfm(reqs[i]) != tfm)
+			return -EINVAL;
+
+	if (crypto_skcipher_get_flags(tfm) & CRYPTO_TFM_NEED_KEY)
+		return -ENOKEY;
+
+	/* lskcipher algorithms don't have the batch callbacks */
+	alg = crypto_skcipher_alg(tfm);
+	batch = NULL;
+	if (alg->co.base.cra_type == &crypto_skcipher_type)
+		batch = encrypt ? alg->encrypt_batch : alg->decrypt_batch;
+	if (batch) {
+		batch(reqs, errs, nr);
+		return 0;
+	}
+
+	for (i = 0; i < nr; i++)
+		errs[i] = encrypt ? crypto_skcipher_encrypt(reqs[i]) :
+				    crypto_skcipher_decrypt(reqs[i]);
+	return 0;
+}
+
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr)
+{
+	return crypto_skcipher_batch(reqs, errs, nr, true);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_encrypt_batch);
+
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr)
+{
+	return crypto_skcipher_batch(reqs, errs, nr, false);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt_batch);
+
 static int crypto_lskcipher_export(struct skcipher_request *req, void *out)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
@@ -9,6 +9,7 @@
 #include <linux/sched.h>
 #include <linux/fs.h>
 #include <linux/init.h>
+#include <linux/random.h>
 #include "null_blk.h"
 
 #undef pr_fmt
@@ -436,6 +437,11 @@ static int nullb_apply_poll_queues(struct nullb_device *dev,
 
 NULLB_DEVICE_ATTR(size, ulong, NULL);
 NULLB_DEVICE_ATTR(completion_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(read_lat_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(write_lat_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(lat_tail_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(lat_tail_pct, uint, NULL);
+NULLB_DEVICE_ATTR(parallel_units, uint, NULL);
 NULLB_DEVICE_ATTR(submit_queues, uint, nullb_apply_submit_queues);
 NULLB_DEVICE_ATTR(poll_queues, uint, nullb_apply_poll_queues);
 NULLB_DEVICE_ATTR(home_node, uint, NULL);
@@ -458,6 +464,7 @@ NULLB_DEVICE_ATTR(zone_nr_conv, uint, NULL);
 NULLB_DEVICE_ATTR(zone_max_open, uint, NULL);
 NULLB_DEVICE_ATTR(zone_max_active, uint, NULL);
 NULLB_DEVICE_ATTR(zone_append_max_sectors, uint, NULL);
+NULLB_DEVICE_ATTR(zone_append_mbps, uint, NULL);
 NULLB_DEVICE_ATTR(virt_boundary, bool, NULL);
 NULLB_DEVICE_ATTR(no_sched, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tags, bool, NULL);
@@ -584,6 +591,11 @@ CONFIGFS_ATTR_WO(nullb_device_, zone_offline);
 static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_size,
 	&nullb_device_attr_completion_nsec,
+	&nullb_device_attr_read_lat_nsec,
+	&nullb_device_attr_write_lat_nsec,
+	&nullb_device_attr_lat_tail_nsec,
+	&nullb_device_attr_lat_tail_pct,
+	&nullb_device_attr_parallel_units,
 	&nullb_device_attr_submit_queues,
 	&nullb_device_attr_poll_queues,
 	&nullb_device_attr_home_node,
@@ -608,6 +620,7 @@ static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_zone_max_open,
 	&nullb_device_attr_zone_max_active,
 	&nullb_device_attr_zone_append_max_sectors,
+	&nullb_device_attr_zone_append_mbps,
 	&nullb_device_attr_zone_readonly,
 	&nullb_device_attr_zone_offline,
 	&nullb_device_attr_virt_boundary,
@@ -695,12 +708,14 @@ static ssize_t memb_group_features_show(struct config_item *item, char *page)
 	return snprintf(page, PAGE_SIZE,
 			"badblocks,blocking,blocksize,cache_size,fua,"
 			"completion_nsec,discard,home_node,hw_queue_depth,"
-			"irqmode,max_sectors,mbps,memory_backed,no_sched,"
-			"poll_queues,power,queue_mode,shared_tag_bitmap,"
+			"irqmode,lat_tail_nsec,lat_tail_pct,max_sectors,mbps,"
+			"memory_backed,no_sched,parallel_units,poll_queues,"
+			"power,queue_mode,read_lat_nsec,shared_tag_bitmap,"
 			"shared_tags,size,submit_queues,use_per_node_hctx,"
-			"virt_boundary,zoned,zone_capacity,zone_max_active,"
-			"zone_max_open,zone_nr_conv,zone_offline,zone_readonly,"
-			"zone_size,zone_append_max_sectors\n");
+			"virt_boundary,write_lat_nsec,zoned,zone_capacity,"
+			"zone_max_active,zone_max_open,zone_nr_conv,"
+			"zone_offline,zone_readonly,zone_size,"
+			"zone_append_max_sectors,zone_append_mbps\n");
 }
 
 CONFIGFS_ATTR_RO(memb_group_, features);
@@ -808,11 +823,69 @@ static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
+static bool null_lat_model(struct nullb_device *dev)
+{
+	return dev->read_lat_nsec || dev->write_lat_nsec || dev->lat_tail_pct ||
+		dev->parallel_units || dev->zone_append_mbps;
+}
+
+static u64 null_cmd_latency(struct nullb_device *dev, struct request *rq)
+{
+	u64 lat = dev->completion_nsec;
+
+	if (req_op(rq) == REQ_OP_READ && dev->read_lat_nsec)
+		lat = dev->read_lat_nsec;
+	else if (op_is_write(req_op(rq)) && dev->write_lat_nsec)
+		lat = dev->write_lat_nsec;
+
+	if (dev->lat_tail_pct && get_random_u32_below(100) < dev->lat_tail_pct)
+		lat = max_t(u64, lat, dev->lat_tail_nsec);
+	return lat;
+}
+
+/*
+ * Without any of the latency model attributes set, every command completes
+ * completion_nsec after submission. Otherwise each command gets its
+ * per-op (or tail) latency and occupies the internal unit its first page
+ * is striped to for that long, so commands queue up behind each other once
+ * a unit is busy. Zone appends are additionally serialized to at most
+ * zone_append_mbps.
+ */
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	struct nullb_device *dev = cmd->nq->dev;
+	struct nullb *nullb = dev->nullb;
+	struct request *rq;
+	ktime_t kt, now;
+	unsigned long flags;
+
+	if (!null_lat_model(dev)) {
+		kt = dev->completion_nsec;
+		hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
+		return;
+	}
+
+	rq = blk_mq_rq_from_pdu(cmd);
+	now = ktime_get();
+	kt = ktime_add_ns(now, null_cmd_latency(dev, rq));
+
+	spin_lock_irqsave(&nullb->lat_lock, flags);
+	if (nullb->unit_busy) {
+		ktime_t *busy = &nullb->unit_busy[(blk_rq_pos(rq) >>
+				(PAGE_SHIFT - SECTOR_SHIFT)) % dev->parallel_units];
 
-	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
+		kt = ktime_add(kt, ktime_sub(max(*busy, now), now));
+		*busy = kt;
+	}
+	if (req_op(rq) == REQ_OP_ZONE_APPEND && dev->zone_append_mbps) {
+		nullb->append_busy = ktime_add_ns(max(nullb->append_busy, now),
+				div_u64((u64)blk_rq_bytes(rq) * NSEC_PER_SEC,
+					(u64)dev->zone_append_mbps << 20));
+		kt = max(kt, nullb->append_busy);
+	}
+	spin_unlock_irqrestore(&nullb->lat_lock, flags);
+
+	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_ABS);
 }
 
 static void null_complete_rq(struct request *rq)
@@ -1710,6 +1783,7 @@ static void null_del_dev(struct nullb *nullb)
 	kfree(nullb->queues);
 	if (null_cache_active(nullb))
 		null_free_device_storage(nullb->dev, true);
+	kfree(nullb->unit_busy);
 	kfree(nullb);
 	dev->nullb = NULL;
 }
@@ -1849,6 +1923,10 @@ static int null_validate_conf(struct nullb_device *dev)
 	dev->cache_size = min_t(unsigned long, ULONG_MAX / 1024 / 1024,
 						dev->cache_size);
 	dev->mbps = min_t(unsigned int, 1024 * 40, dev->mbps);
+	dev->lat_tail_pct = min_t(unsigned int, 100, dev->lat_tail_pct);
+	if (dev->irqmode != NULL_IRQ_TIMER && null_lat_model(dev))
+		pr_warn("latency model needs irqmode=%d, ignoring it\n",
+			NULL_IRQ_TIMER);
 
 	if (dev->zoned &&
 	    (!dev->zone_size || !is_power_of_2(dev->zone_size))) {
@@ -1910,6 +1988,16 @@ static int null_add_dev(struct nullb_device *dev)
 	dev->nullb = nullb;
 
 	spin_lock_init(&nullb->lock);
+	spin_lock_init(&nullb->lat_lock);
+
+	if (dev->parallel_units) {
+		nullb->unit_busy = kcalloc(dev->parallel_units,
+					   sizeof(*nullb->unit_busy), GFP_KERNEL);
+		if (!nullb->unit_busy) {
+			rv = -ENOMEM;
+			goto out_free_nullb;
+		}
+	}
 
 	rv = setup_queues(nullb);
 	if (rv)
@@ -2000,6 +2088,7 @@ static int null_add_dev(struct nullb_device *dev)
 out_cleanup_queues:
 	kfree(nullb->queues);
 out_free_nullb:
+	kfree(nullb->unit_busy);
 	kfree(nullb);
 	dev->nullb = NULL;
 out:
@@ -76,6 +76,12 @@ struct nullb_device {
 
 	unsigned long size; /* device size in MB */
 	unsigned long completion_nsec; /* time in ns to complete a request */
+	unsigned long read_lat_nsec; /* read latency in ns, overrides completion_nsec */
+	unsigned long write_lat_nsec; /* write latency in ns, overrides completion_nsec */
+	unsigned long lat_tail_nsec; /* latency in ns of the lat_tail_pct slowest requests */
+	unsigned int lat_tail_pct; /* percentage of requests taking lat_tail_nsec */
+	unsigned int parallel_units; /* number of independent internal units */
+	unsigned int zone_append_mbps; /* zone append throughput cap (in MB/s) */
 	unsigned long cache_size; /* disk cache size in MB */
 	unsigned long zone_size; /* zone size in MB if device is zoned */
 	unsigned long zone_capacity; /* zone capacity in MB if device is zoned */
@@ -121,6 +127,11 @@ struct nullb {
 	unsigned long cache_flush_pos;
 	spinlock_t lock;
 
+	/* latency model state, see null_cmd_end_timer() */
+	spinlock_t lat_lock;
+	ktime_t *unit_busy;
+	ktime_t append_busy;
+
 	struct nullb_queue *queues;
 	char disk_name[DISK_NAME_LEN];
 };
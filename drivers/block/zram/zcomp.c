@@ -11,7 +11,11 @@
 #include <linux/sched.h>
 #include <linux/cpu.h>
 #include <linux/crypto.h>
+#include <linux/moduleparam.h>
+#include <linux/sched/mm.h>
+#include <linux/scatterlist.h>
 #include <linux/vmalloc.h>
+#include <crypto/acompress.h>
 
 #include "zcomp.h"
 
@@ -34,6 +38,15 @@ static const char * const backends[] = {
 #endif
 };
 
+/*
+ * acomp driver used to compress batches of pages for writes, e.g. a
+ * hardware accelerator.  It is only used for a zram device whose algorithm
+ * matches, as decompression is always done by the software ->tfm.
+ */
+static char comp_accel[CRYPTO_MAX_ALG_NAME];
+module_param_string(comp_accel, comp_accel, CRYPTO_MAX_ALG_NAME, 0444);
+MODULE_PARM_DESC(comp_accel, "acomp driver for batched write compression");
+
 static void zcomp_strm_free(struct zcomp_strm *zstrm)
 {
 	if (!IS_ERR_OR_NULL(zstrm->tfm))
@@ -139,6 +152,62 @@ int zcomp_compress(struct zcomp_strm *zstrm,
 			zstrm->buffer, dst_len);
 }
 
+struct zcomp_batch {
+	struct acomp_req *req[ZCOMP_BATCH];
+	struct crypto_wait wait[ZCOMP_BATCH];
+	struct scatterlist src[ZCOMP_BATCH];
+	struct scatterlist dst[ZCOMP_BATCH];
+};
+
+/*
+ * Compress @nr pages with comp->acomp, which may run them in parallel.
+ * Each @dst buffer is 2 * PAGE_SIZE of linear memory, see zcomp_compress().
+ * A non-zero @err[i] means that page has to be compressed in software.
+ */
+void zcomp_compress_batch(struct zcomp *comp, struct page **pages,
+		void **dst, unsigned int *dst_len, int *err, unsigned int nr)
+{
+	unsigned int noio_flags = memalloc_noio_save();
+	struct zcomp_batch *b;
+	unsigned int i;
+
+	b = kmalloc(sizeof(*b), GFP_NOIO);
+	if (!b) {
+		for (i = 0; i < nr; i++)
+			err[i] = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < nr; i++) {
+		b->req[i] = acomp_request_alloc(comp->acomp);
+		if (!b->req[i]) {
+			err[i] = -ENOMEM;
+			continue;
+		}
+		crypto_init_wait(&b->wait[i]);
+		sg_init_table(&b->src[i], 1);
+		sg_set_page(&b->src[i], pages[i], PAGE_SIZE, 0);
+		sg_init_one(&b->dst[i], dst[i], PAGE_SIZE * 2);
+		acomp_request_set_params(b->req[i], &b->src[i], &b->dst[i],
+					 PAGE_SIZE, PAGE_SIZE * 2);
+		acomp_request_set_callback(b->req[i],
+					   CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   crypto_req_done, &b->wait[i]);
+		err[i] = crypto_acomp_compress(b->req[i]);
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (!b->req[i])
+			continue;
+		err[i] = crypto_wait_req(err[i], &b->wait[i]);
+		dst_len[i] = b->req[i]->dlen;
+		acomp_request_free(b->req[i]);
+	}
+	kfree(b);
+out:
+	memalloc_noio_restore(noio_flags);
+}
+
 int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst)
 {
@@ -196,9 +265,31 @@ void zcomp_destroy(struct zcomp *comp)
 {
 	cpuhp_state_remove_instance(CPUHP_ZCOMP_PREPARE, &comp->node);
 	free_percpu(comp->stream);
+	if (comp->acomp)
+		crypto_free_acomp(comp->acomp);
 	kfree(comp);
 }
 
+static void zcomp_init_accel(struct zcomp *comp)
+{
+	struct crypto_acomp *tfm;
+
+	if (!comp_accel[0])
+		return;
+
+	tfm = crypto_alloc_acomp(comp_accel, 0, 0);
+	if (IS_ERR(tfm))
+		return;
+	/* the output must be readable by the software decompressor */
+	if (strcmp(crypto_tfm_alg_name(crypto_acomp_tfm(tfm)), comp->name)) {
+		crypto_free_acomp(tfm);
+		return;
+	}
+	pr_info("using %s for batched %s compression\n",
+		crypto_tfm_alg_driver_name(crypto_acomp_tfm(tfm)), comp->name);
+	comp->acomp = tfm;
+}
+
 /*
  * search available compressors for requested algorithm.
  * allocate new zcomp and initialize it. return compressing
@@ -230,5 +321,6 @@ struct zcomp *zcomp_create(const char *alg)
 		kfree(comp);
 		return ERR_PTR(error);
 	}
+	zcomp_init_accel(comp);
 	return comp;
 }
@@ -7,6 +7,9 @@
 #define _ZCOMP_H_
 #include <linux/local_lock.h>
 
+/* max pages compressed by one zcomp_compress_batch() call */
+#define ZCOMP_BATCH	16
+
 struct zcomp_strm {
 	/* The members ->buffer and ->tfm are protected by ->lock. */
 	local_lock_t lock;
@@ -20,6 +23,8 @@ struct zcomp {
 	struct zcomp_strm __percpu *stream;
 	const char *name;
 	struct hlist_node node;
+	/* optional acomp driver for batched write-side compression */
+	struct crypto_acomp *acomp;
 };
 
 int zcomp_cpu_up_prepare(unsigned int cpu, struct hlist_node *node);
@@ -39,4 +44,12 @@ int zcomp_compress(struct zcomp_strm *zstrm,
 int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst);
 
+static inline bool zcomp_can_batch(struct zcomp *comp)
+{
+	return comp->acomp;
+}
+
+void zcomp_compress_batch(struct zcomp *comp, struct page **pages,
+		void **dst, unsigned int *dst_len, int *err, unsigned int nr);
+
 #endif /* _ZCOMP_H_ */
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Sharing of zsmalloc objects between zram slots with identical content.
+ *
+ * Every object stored while dedup is enabled gets a zram_dedup_entry,
+ * indexed by the xxhash of its (compressed) content.  A write whose
+ * compressed data matches an existing entry takes a reference on it
+ * instead of allocating a new object.
+ */
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/xxhash.h>
+
+#include "zram_dedup.h"
+
+void zram_dedup_init(struct zram *zram)
+{
+	spin_lock_init(&zram->dedup_lock);
+	zram->dedup_root = RB_ROOT;
+}
+
+u64 zram_dedup_checksum(const void *mem, unsigned int len)
+{
+	return xxh64(mem, len, 0);
+}
+
+static bool zram_dedup_match(struct zram *zram, struct zram_dedup_entry *entry,
+			     const void *mem, unsigned int len)
+{
+	void *obj;
+	bool match;
+
+	if (entry->len != len)
+		return false;
+
+	obj = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	match = !memcmp(obj, mem, len);
+	zs_unmap_object(zram->mem_pool, entry->handle);
+	return match;
+}
+
+/*
+ * Look for an entry whose object holds exactly @len bytes of @mem and take
+ * a reference on it.  The caller must not have another zsmalloc object
+ * mapped.
+ */
+struct zram_dedup_entry *zram_dedup_get(struct zram *zram, const void *mem,
+					unsigned int len, u64 checksum)
+{
+	struct zram_dedup_entry *entry;
+	struct rb_node *node, *prev;
+
+	spin_lock(&zram->dedup_lock);
+	node = zram->dedup_root.rb_node;
+	while (node) {
+		entry = rb_entry(node, struct zram_dedup_entry, rb_node);
+		if (checksum < entry->checksum)
+			node = node->rb_left;
+		else if (checksum > entry->checksum)
+			node = node->rb_right;
+		else
+			break;
+	}
+
+	/* entries with equal checksums are adjacent, start at the first */
+	while (node && (prev = rb_prev(node)) &&
+	       rb_entry(prev, struct zram_dedup_entry, rb_node)->checksum ==
+			checksum)
+		node = prev;
+
+	for (; node; node = rb_next(node)) {
+		entry = rb_entry(node, struct zram_dedup_entry, rb_node);
+		if (entry->checksum != checksum)
+			break;
+		if (zram_dedup_match(zram, entry, mem, len)) {
+			entry->refcount++;
+			spin_unlock(&zram->dedup_lock);
+			return entry;
+		}
+	}
+	spin_unlock(&zram->dedup_lock);
+	return NULL;
+}
+
+/*
+ * Index the newly stored object @handle.  Returns NULL if no entry could
+ * be allocated, the object is then simply not shared.
+ */
+struct zram_dedup_entry *zram_dedup_add(struct zram *zram,
+					unsigned long handle,
+					unsigned int len, u64 checksum)
+{
+	struct zram_dedup_entry *entry, *e;
+	struct rb_node **link, *parent = NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+	entry->checksum = checksum;
+	entry->handle = handle;
+	entry->len = len;
+	entry->refcount = 1;
+
+	spin_lock(&zram->dedup_lock);
+	link = &zram->dedup_root.rb_node;
+	while (*link) {
+		parent = *link;
+		e = rb_entry(parent, struct zram_dedup_entry, rb_node);
+		if (checksum < e->checksum)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&entry->rb_node, parent, link);
+	rb_insert_color(&entry->rb_node, &zram->dedup_root);
+	spin_unlock(&zram->dedup_lock);
+	return entry;
+}
+
+/*
+ * Drop a slot's reference.  Returns true if it was the last one, in which
+ * case the object has been freed.
+ */
+bool zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry)
+{
+	spin_lock(&zram->dedup_lock);
+	if (--entry->refcount) {
+		spin_unlock(&zram->dedup_lock);
+		return false;
+	}
+	rb_erase(&entry->rb_node, &zram->dedup_root);
+	spin_unlock(&zram->dedup_lock);
+
+	zs_free(zram->mem_pool, entry->handle);
+	kfree(entry);
+	return true;
+}
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/rbtree.h>
+
+#include "zram_drv.h"
+
+/* zsmalloc object shared by all slots that store the same content */
+struct zram_dedup_entry {
+	struct rb_node rb_node;
+	u64 checksum;
+	unsigned long handle;
+	unsigned int len;
+	unsigned int refcount;	/* protected by zram->dedup_lock */
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+	return zram->dedup_enable;
+}
+
+void zram_dedup_init(struct zram *zram);
+u64 zram_dedup_checksum(const void *mem, unsigned int len);
+struct zram_dedup_entry *zram_dedup_get(struct zram *zram, const void *mem,
+					unsigned int len, u64 checksum);
+struct zram_dedup_entry *zram_dedup_add(struct zram *zram,
+					unsigned long handle,
+					unsigned int len, u64 checksum);
+bool zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry);
+#else
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+	return false;
+}
+
+static inline void zram_dedup_init(struct zram *zram) {}
+
+static inline u64 zram_dedup_checksum(const void *mem, unsigned int len)
+{
+	return 0;
+}
+
+static inline struct zram_dedup_entry *zram_dedup_get(struct zram *zram,
+		const void *mem, unsigned int len, u64 checksum)
+{
+	return NULL;
+}
+
+static inline struct zram_dedup_entry *zram_dedup_add(struct zram *zram,
+		unsigned long handle, unsigned int len, u64 checksum)
+{
+	return NULL;
+}
+
+static inline bool zram_dedup_put(struct zram *zram,
+				  struct zram_dedup_entry *entry)
+{
+	return true;
+}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
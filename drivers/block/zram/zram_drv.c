@@ -33,8 +33,10 @@
 #include <linux/debugfs.h>
 #include <linux/cpuhotplug.h>
 #include <linux/part_stat.h>
+#include <linux/kthread.h>
 
 #include "zram_drv.h"
+#include "zram_dedup.h"
 
 static DEFINE_IDR(zram_index_idr);
 /* idr index must be protected */
@@ -84,7 +86,11 @@ static inline struct zram *dev_to_zram(struct device *dev)
 
 static unsigned long zram_get_handle(struct zram *zram, u32 index)
 {
-	return zram->table[index].handle;
+	unsigned long handle = zram->table[index].handle;
+
+	if (zram->table[index].flags & BIT(ZRAM_DEDUP))
+		return ((struct zram_dedup_entry *)handle)->handle;
+	return handle;
 }
 
 static void zram_set_handle(struct zram *zram, u32 index, unsigned long handle)
@@ -585,58 +591,43 @@ static void read_from_bdev_async(struct zram *zram, struct page *page,
 #define HUGE_WRITEBACK			(1<<0)
 #define IDLE_WRITEBACK			(1<<1)
 #define INCOMPRESSIBLE_WRITEBACK	(1<<2)
+#define COLD_WRITEBACK			(1<<3)
 
-static ssize_t writeback_store(struct device *dev,
-		struct device_attribute *attr, const char *buf, size_t len)
+/*
+ * An idle slot is cold once recompression can not shrink it any further:
+ * it was recompressed already, is huge or incompressible, or there is no
+ * secondary algorithm to try.
+ */
+static bool zram_slot_cold(struct zram *zram, u32 index)
+{
+	return zram_test_flag(zram, index, ZRAM_IDLE) &&
+		(zram->num_active_comps < 2 ||
+		 zram_get_priority(zram, index) ||
+		 zram_test_flag(zram, index, ZRAM_HUGE) ||
+		 zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE));
+}
+
+/*
+ * Write back at most @max_wb of the @nr_pages slots starting at @index
+ * which match @mode. Callers should hold the zram init lock in read mode
+ * and have checked that a backing device is set up.
+ */
+static ssize_t zram_writeback_slots(struct zram *zram, int mode,
+				    unsigned long index, unsigned long nr_pages,
+				    unsigned long max_wb)
 {
-	struct zram *zram = dev_to_zram(dev);
-	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
-	unsigned long index = 0;
 	struct bio bio;
 	struct bio_vec bio_vec;
 	struct page *page;
-	ssize_t ret = len;
-	int mode, err;
+	ssize_t ret = 0;
+	int err;
 	unsigned long blk_idx = 0;
 
-	if (sysfs_streq(buf, "idle"))
-		mode = IDLE_WRITEBACK;
-	else if (sysfs_streq(buf, "huge"))
-		mode = HUGE_WRITEBACK;
-	else if (sysfs_streq(buf, "huge_idle"))
-		mode = IDLE_WRITEBACK | HUGE_WRITEBACK;
-	else if (sysfs_streq(buf, "incompressible"))
-		mode = INCOMPRESSIBLE_WRITEBACK;
-	else {
-		if (strncmp(buf, PAGE_WB_SIG, sizeof(PAGE_WB_SIG) - 1))
-			return -EINVAL;
-
-		if (kstrtol(buf + sizeof(PAGE_WB_SIG) - 1, 10, &index) ||
-				index >= nr_pages)
-			return -EINVAL;
-
-		nr_pages = 1;
-		mode = PAGE_WRITEBACK;
-	}
-
-	down_read(&zram->init_lock);
-	if (!init_done(zram)) {
-		ret = -EINVAL;
-		goto release_init_lock;
-	}
-
-	if (!zram->backing_dev) {
-		ret = -ENODEV;
-		goto release_init_lock;
-	}
-
 	page = alloc_page(GFP_KERNEL);
-	if (!page) {
-		ret = -ENOMEM;
-		goto release_init_lock;
-	}
+	if (!page)
+		return -ENOMEM;
 
-	for (; nr_pages != 0; index++, nr_pages--) {
+	for (; nr_pages != 0 && max_wb != 0; index++, nr_pages--) {
 		spin_lock(&zram->wb_limit_lock);
 		if (zram->wb_limit_enable && !zram->bd_wb_limit) {
 			spin_unlock(&zram->wb_limit_lock);
@@ -671,6 +662,8 @@ static ssize_t writeback_store(struct device *dev,
 		if (mode & INCOMPRESSIBLE_WRITEBACK &&
 		    !zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
 			goto next;
+		if (mode & COLD_WRITEBACK && !zram_slot_cold(zram, index))
+			goto next;
 
 		/*
 		 * Clearing ZRAM_UNDER_WB is duty of caller.
@@ -738,6 +731,7 @@ static ssize_t writeback_store(struct device *dev,
 		zram_set_flag(zram, index, ZRAM_WB);
 		zram_set_element(zram, index, blk_idx);
 		blk_idx = 0;
+		max_wb--;
 		atomic64_inc(&zram->stats.pages_stored);
 		spin_lock(&zram->wb_limit_lock);
 		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
@@ -750,6 +744,54 @@ static ssize_t writeback_store(struct device *dev,
 	if (blk_idx)
 		free_block_bdev(zram, blk_idx);
 	__free_page(page);
+
+	return ret;
+}
+
+static ssize_t writeback_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index = 0;
+	ssize_t ret;
+	int mode;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = IDLE_WRITEBACK;
+	else if (sysfs_streq(buf, "huge"))
+		mode = HUGE_WRITEBACK;
+	else if (sysfs_streq(buf, "huge_idle"))
+		mode = IDLE_WRITEBACK | HUGE_WRITEBACK;
+	else if (sysfs_streq(buf, "incompressible"))
+		mode = INCOMPRESSIBLE_WRITEBACK;
+	else {
+		if (strncmp(buf, PAGE_WB_SIG, sizeof(PAGE_WB_SIG) - 1))
+			return -EINVAL;
+
+		if (kstrtol(buf + sizeof(PAGE_WB_SIG) - 1, 10, &index) ||
+				index >= nr_pages)
+			return -EINVAL;
+
+		nr_pages = 1;
+		mode = PAGE_WRITEBACK;
+	}
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram->backing_dev) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	ret = zram_writeback_slots(zram, mode, index, nr_pages, ULONG_MAX);
+	if (!ret)
+		ret = len;
+
 release_init_lock:
 	up_read(&zram->init_lock);
 
@@ -1019,6 +1061,42 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return ret ? ret : len;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t dedup_enable_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	down_read(&zram->init_lock);
+	val = zram->dedup_enable;
+	up_read(&zram->init_lock);
+
+	return sysfs_emit(buf, "%d\n", val);
+}
+
+static ssize_t dedup_enable_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup for initialized device\n");
+		return -EBUSY;
+	}
+	zram->dedup_enable = val;
+	up_write(&zram->init_lock);
+
+	return len;
+}
+#endif
+
 #ifdef CONFIG_ZRAM_MULTI_COMP
 static ssize_t recomp_algorithm_show(struct device *dev,
 				     struct device_attribute *attr,
@@ -1136,7 +1214,7 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -1145,7 +1223,8 @@ static ssize_t mm_stat_show(struct device *dev,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			atomic_long_read(&pool_stats.pages_compacted),
 			(u64)atomic64_read(&zram->stats.huge_pages),
-			(u64)atomic64_read(&zram->stats.huge_pages_since));
+			(u64)atomic64_read(&zram->stats.huge_pages_since),
+			(u64)atomic64_read(&zram->stats.dedup_pages));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1270,6 +1349,17 @@ static void zram_free_page(struct zram *zram, size_t index)
 		goto out;
 	}
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		if (zram_dedup_put(zram, (struct zram_dedup_entry *)
+					 zram->table[index].handle))
+			atomic64_sub(zram_get_obj_size(zram, index),
+				     &zram->stats.compr_data_size);
+		else
+			atomic64_dec(&zram->stats.dedup_pages);
+		goto out;
+	}
+
 	handle = zram_get_handle(zram, index);
 	if (!handle)
 		return;
@@ -1390,6 +1480,57 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	return zram_read_page(zram, bvec->bv_page, index, bio);
 }
 
+static void zram_write_slot(struct zram *zram, u32 index,
+			    unsigned long handle, unsigned int comp_len,
+			    enum zram_pageflags flags, unsigned long element)
+{
+	/*
+	 * Free memory associated with this sector
+	 * before overwriting unused sectors.
+	 */
+	zram_slot_lock(zram, index);
+	zram_free_page(zram, index);
+
+	if (comp_len == PAGE_SIZE) {
+		zram_set_flag(zram, index, ZRAM_HUGE);
+		atomic64_inc(&zram->stats.huge_pages);
+		atomic64_inc(&zram->stats.huge_pages_since);
+	}
+
+	if (flags)
+		zram_set_flag(zram, index, flags);
+	if (flags == ZRAM_SAME) {
+		zram_set_element(zram, index, element);
+	} else {
+		zram_set_handle(zram, index, handle);
+		zram_set_obj_size(zram, index, comp_len);
+	}
+	zram_slot_unlock(zram, index);
+
+	/* Update stats */
+	atomic64_inc(&zram->stats.pages_stored);
+}
+
+/*
+ * Find a stored object with the same content as the compressed data in
+ * @buf, or as @page itself for incompressible pages, and take a reference.
+ */
+static struct zram_dedup_entry *zram_dedup_lookup(struct zram *zram,
+		struct page *page, void *buf, unsigned int comp_len,
+		u64 *checksum)
+{
+	struct zram_dedup_entry *entry;
+	void *mem = buf;
+
+	if (comp_len == PAGE_SIZE)
+		mem = kmap_local_page(page);
+	*checksum = zram_dedup_checksum(mem, comp_len);
+	entry = zram_dedup_get(zram, mem, comp_len, *checksum);
+	if (comp_len == PAGE_SIZE)
+		kunmap_local(mem);
+	return entry;
+}
+
 static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 {
 	int ret = 0;
@@ -1400,6 +1541,8 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	struct zcomp_strm *zstrm;
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
+	struct zram_dedup_entry *entry;
+	u64 checksum = 0;
 
 	mem = kmap_local_page(page);
 	if (page_same_filled(mem, &element)) {
@@ -1426,6 +1569,20 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 
 	if (comp_len >= huge_class_size)
 		comp_len = PAGE_SIZE;
+
+	if (zram_dedup_enabled(zram)) {
+		entry = zram_dedup_lookup(zram, page, zstrm->buffer, comp_len,
+					  &checksum);
+		if (entry) {
+			zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+			/* from the slow path below */
+			zs_free(zram->mem_pool, handle);
+			atomic64_inc(&zram->stats.dedup_pages);
+			zram_write_slot(zram, index, (unsigned long)entry,
+					comp_len, ZRAM_DEDUP, 0);
+			return 0;
+		}
+	}
 	/*
 	 * handle allocation has 2 paths:
 	 * a) fast path is executed with preemption disabled (for
@@ -1487,32 +1644,97 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_dedup_enabled(zram)) {
+		entry = zram_dedup_add(zram, handle, comp_len, checksum);
+		if (entry) {
+			handle = (unsigned long)entry;
+			flags = ZRAM_DEDUP;
+		}
+	}
 out:
-	/*
-	 * Free memory associated with this sector
-	 * before overwriting unused sectors.
-	 */
-	zram_slot_lock(zram, index);
-	zram_free_page(zram, index);
+	zram_write_slot(zram, index, handle, comp_len, flags, element);
+	return ret;
+}
 
-	if (comp_len == PAGE_SIZE) {
-		zram_set_flag(zram, index, ZRAM_HUGE);
-		atomic64_inc(&zram->stats.huge_pages);
-		atomic64_inc(&zram->stats.huge_pages_since);
+/*
+ * Store a page that zcomp_compress_batch() already compressed into @src.
+ * No compression stream is held, so the handle can be allocated with
+ * direct reclaim straight away if the fast path fails.
+ */
+static int zram_write_compressed(struct zram *zram, struct page *page,
+				 u32 index, void *src, unsigned int comp_len)
+{
+	unsigned long alloced_pages;
+	unsigned long handle;
+	unsigned long element = 0;
+	enum zram_pageflags flags = 0;
+	struct zram_dedup_entry *entry;
+	u64 checksum = 0;
+	void *dst, *mem;
+
+	mem = kmap_local_page(page);
+	if (page_same_filled(mem, &element)) {
+		kunmap_local(mem);
+		atomic64_inc(&zram->stats.same_pages);
+		zram_write_slot(zram, index, 0, 0, ZRAM_SAME, element);
+		return 0;
 	}
+	kunmap_local(mem);
 
-	if (flags) {
-		zram_set_flag(zram, index, flags);
-		zram_set_element(zram, index, element);
-	}  else {
-		zram_set_handle(zram, index, handle);
-		zram_set_obj_size(zram, index, comp_len);
+	if (comp_len >= huge_class_size)
+		comp_len = PAGE_SIZE;
+
+	if (zram_dedup_enabled(zram)) {
+		entry = zram_dedup_lookup(zram, page, src, comp_len, &checksum);
+		if (entry) {
+			atomic64_inc(&zram->stats.dedup_pages);
+			zram_write_slot(zram, index, (unsigned long)entry,
+					comp_len, ZRAM_DEDUP, 0);
+			return 0;
+		}
 	}
-	zram_slot_unlock(zram, index);
 
-	/* Update stats */
-	atomic64_inc(&zram->stats.pages_stored);
-	return ret;
+	handle = zs_malloc(zram->mem_pool, comp_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE);
+	if (IS_ERR_VALUE(handle)) {
+		atomic64_inc(&zram->stats.writestall);
+		handle = zs_malloc(zram->mem_pool, comp_len,
+				GFP_NOIO | __GFP_HIGHMEM |
+				__GFP_MOVABLE);
+		if (IS_ERR_VALUE(handle))
+			return PTR_ERR((void *)handle);
+	}
+
+	alloced_pages = zs_get_total_pages(zram->mem_pool);
+	update_used_max(zram, alloced_pages);
+
+	if (zram->limit_pages && alloced_pages > zram->limit_pages) {
+		zs_free(zram->mem_pool, handle);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+	if (comp_len == PAGE_SIZE)
+		src = kmap_local_page(page);
+	memcpy(dst, src, comp_len);
+	if (comp_len == PAGE_SIZE)
+		kunmap_local(src);
+	zs_unmap_object(zram->mem_pool, handle);
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_dedup_enabled(zram)) {
+		entry = zram_dedup_add(zram, handle, comp_len, checksum);
+		if (entry) {
+			handle = (unsigned long)entry;
+			flags = ZRAM_DEDUP;
+		}
+	}
+	zram_write_slot(zram, index, handle, comp_len, flags, 0);
+	return 0;
 }
 
 /*
@@ -1567,6 +1789,10 @@ static int zram_recompress(struct zram *zram, u32 index, struct page *page,
 	void *src, *dst;
 	int ret;
 
+	/* recompressing would give this slot its own, unshared object */
+	if (zram_test_flag(zram, index, ZRAM_DEDUP))
+		return 0;
+
 	handle_old = zram_get_handle(zram, index);
 	if (!handle_old)
 		return -EINVAL;
@@ -1697,18 +1923,74 @@ static int zram_recompress(struct zram *zram, u32 index, struct page *page,
 #define RECOMPRESS_IDLE		(1 << 0)
 #define RECOMPRESS_HUGE		(1 << 1)
 
+/*
+ * Recompress at most @num_recomp_pages slots matching @mode with the
+ * algorithms of priority [@prio, @prio_max). Callers should hold the zram
+ * init lock in read mode.
+ */
+static ssize_t zram_recompress_slots(struct zram *zram, u32 mode,
+				     u32 threshold, u32 prio, u32 prio_max,
+				     u64 num_recomp_pages)
+{
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index;
+	struct page *page;
+	ssize_t ret = 0;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	for (index = 0; index < nr_pages; index++) {
+		int err = 0;
+
+		if (!num_recomp_pages)
+			break;
+
+		zram_slot_lock(zram, index);
+
+		if (!zram_allocated(zram, index))
+			goto next;
+
+		if (mode & RECOMPRESS_IDLE &&
+		    !zram_test_flag(zram, index, ZRAM_IDLE))
+			goto next;
+
+		if (mode & RECOMPRESS_HUGE &&
+		    !zram_test_flag(zram, index, ZRAM_HUGE))
+			goto next;
+
+		if (zram_test_flag(zram, index, ZRAM_WB) ||
+		    zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+		    zram_test_flag(zram, index, ZRAM_SAME) ||
+		    zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
+			goto next;
+
+		err = zram_recompress(zram, index, page, &num_recomp_pages,
+				      threshold, prio, prio_max);
+next:
+		zram_slot_unlock(zram, index);
+		if (err) {
+			ret = err;
+			break;
+		}
+
+		cond_resched();
+	}
+
+	__free_page(page);
+	return ret;
+}
+
 static ssize_t recompress_store(struct device *dev,
 				struct device_attribute *attr,
 				const char *buf, size_t len)
 {
 	u32 prio = ZRAM_SECONDARY_COMP, prio_max = ZRAM_MAX_COMPS;
 	struct zram *zram = dev_to_zram(dev);
-	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
 	char *args, *param, *val, *algo = NULL;
 	u64 num_recomp_pages = ULLONG_MAX;
 	u32 mode = 0, threshold = 0;
-	unsigned long index;
-	struct page *page;
 	ssize_t ret;
 
 	args = skip_spaces(buf);
@@ -1785,56 +2067,145 @@ static ssize_t recompress_store(struct device *dev,
 		}
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
-		ret = -ENOMEM;
-		goto release_init_lock;
-	}
-
-	ret = len;
-	for (index = 0; index < nr_pages; index++) {
-		int err = 0;
-
-		if (!num_recomp_pages)
-			break;
+	ret = zram_recompress_slots(zram, mode, threshold, prio, prio_max,
+				    num_recomp_pages);
+	if (!ret)
+		ret = len;
 
-		zram_slot_lock(zram, index);
+release_init_lock:
+	up_read(&zram->init_lock);
+	return ret;
+}
+#endif
 
-		if (!zram_allocated(zram, index))
-			goto next;
+#ifdef CONFIG_ZRAM_IDLE_POLICY
+/*
+ * Every slot is marked idle at the end of a pass, and accesses clear the
+ * mark again. Slots still idle on the next pass get recompressed with the
+ * secondary algorithms, and slots still idle on the pass after that are
+ * written back, at most idle_policy_wb_budget of them per pass.
+ */
+static void zram_idle_policy_run(struct zram *zram)
+{
+	down_read(&zram->init_lock);
+	if (!init_done(zram))
+		goto out;
 
-		if (mode & RECOMPRESS_IDLE &&
-		    !zram_test_flag(zram, index, ZRAM_IDLE))
-			goto next;
+#ifdef CONFIG_ZRAM_WRITEBACK
+	/* before recompression, which clears ZRAM_IDLE of the slots it did */
+	if (zram->backing_dev && zram->idle_policy_wb_budget)
+		zram_writeback_slots(zram, COLD_WRITEBACK, 0,
+				     zram->disksize >> PAGE_SHIFT,
+				     zram->idle_policy_wb_budget);
+#endif
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	if (zram->num_active_comps > 1)
+		zram_recompress_slots(zram, RECOMPRESS_IDLE, 0,
+				      ZRAM_SECONDARY_COMP, ZRAM_MAX_COMPS,
+				      ULLONG_MAX);
+#endif
+	mark_idle(zram, 0);
+out:
+	up_read(&zram->init_lock);
+}
 
-		if (mode & RECOMPRESS_HUGE &&
-		    !zram_test_flag(zram, index, ZRAM_HUGE))
-			goto next;
+static int zram_idle_policy_thread(void *data)
+{
+	struct zram *zram = data;
+	unsigned int interval;
+	long remaining = 1;
 
-		if (zram_test_flag(zram, index, ZRAM_WB) ||
-		    zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
-		    zram_test_flag(zram, index, ZRAM_SAME) ||
-		    zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE))
-			goto next;
+	for (;;) {
+		interval = READ_ONCE(zram->idle_policy_interval);
+		/* only run once a full interval passed, not on reconfiguration */
+		if (interval && !remaining)
+			zram_idle_policy_run(zram);
 
-		err = zram_recompress(zram, index, page, &num_recomp_pages,
-				      threshold, prio, prio_max);
-next:
-		zram_slot_unlock(zram, index);
-		if (err) {
-			ret = err;
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (kthread_should_stop()) {
+			__set_current_state(TASK_RUNNING);
 			break;
 		}
-
-		cond_resched();
+		remaining = schedule_timeout(interval ? interval * HZ :
+					     MAX_SCHEDULE_TIMEOUT);
 	}
+	return 0;
+}
 
-	__free_page(page);
+static ssize_t idle_policy_interval_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
 
-release_init_lock:
+	return sysfs_emit(buf, "%u\n", READ_ONCE(zram->idle_policy_interval));
+}
+
+static ssize_t idle_policy_interval_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+
+	if (kstrtouint(buf, 10, &val) || val > INT_MAX / HZ)
+		return -EINVAL;
+
+	WRITE_ONCE(zram->idle_policy_interval, val);
+	wake_up_process(zram->idle_policy_task);
+	return len;
+}
+
+static ssize_t idle_policy_wb_budget_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long val;
+
+	down_read(&zram->init_lock);
+	val = zram->idle_policy_wb_budget;
 	up_read(&zram->init_lock);
-	return ret;
+
+	return sysfs_emit(buf, "%lu\n", val);
 }
+
+static ssize_t idle_policy_wb_budget_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long val;
+
+	if (kstrtoul(buf, 10, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	zram->idle_policy_wb_budget = val;
+	up_write(&zram->init_lock);
+
+	return len;
+}
+
+static int zram_idle_policy_start(struct zram *zram, int device_id)
+{
+	struct task_struct *task;
+
+	task = kthread_run(zram_idle_policy_thread, zram, "zram%d_idle",
+			   device_id);
+	if (IS_ERR(task))
+		return PTR_ERR(task);
+	zram->idle_policy_task = task;
+	return 0;
+}
+
+static void zram_idle_policy_stop(struct zram *zram)
+{
+	kthread_stop(zram->idle_policy_task);
+}
+#else
+static int zram_idle_policy_start(struct zram *zram, int device_id)
+{
+	return 0;
+}
+
+static void zram_idle_policy_stop(struct zram *zram) {}
 #endif
 
 static void zram_bio_discard(struct zram *zram, struct bio *bio)
@@ -1905,10 +2276,61 @@ static void zram_bio_read(struct zram *zram, struct bio *bio)
 	bio_endio(bio);
 }
 
+/*
+ * Compress up to ZCOMP_BATCH full pages in one go with the primary
+ * algorithm's acomp driver and store them.  Pages the driver failed on,
+ * or all of them if there is no memory for the output buffers, go
+ * through the regular per-page path instead.
+ */
+static int zram_write_batch(struct zram *zram, struct page **pages,
+			    u32 *indices, unsigned int nr)
+{
+	void *dst[ZCOMP_BATCH];
+	unsigned int dst_len[ZCOMP_BATCH];
+	int err[ZCOMP_BATCH];
+	unsigned int i, nr_buf;
+	int ret = 0;
+
+	for (nr_buf = 0; nr_buf < nr; nr_buf++) {
+		dst[nr_buf] = kmalloc(PAGE_SIZE * 2, GFP_NOIO | __GFP_NOWARN);
+		if (!dst[nr_buf])
+			break;
+	}
+
+	if (nr_buf == nr)
+		zcomp_compress_batch(zram->comps[ZRAM_PRIMARY_COMP], pages,
+				     dst, dst_len, err, nr);
+	else
+		memset(err, 0xff, sizeof(err));
+
+	for (i = 0; i < nr; i++) {
+		if (!err[i])
+			ret = zram_write_compressed(zram, pages[i], indices[i],
+						    dst[i], dst_len[i]);
+		else
+			ret = zram_write_page(zram, pages[i], indices[i]);
+		if (ret < 0)
+			break;
+
+		zram_slot_lock(zram, indices[i]);
+		zram_accessed(zram, indices[i]);
+		zram_slot_unlock(zram, indices[i]);
+	}
+
+	while (nr_buf--)
+		kfree(dst[nr_buf]);
+	return ret;
+}
+
 static void zram_bio_write(struct zram *zram, struct bio *bio)
 {
 	unsigned long start_time = bio_start_io_acct(bio);
 	struct bvec_iter iter = bio->bi_iter;
+	bool batch = zcomp_can_batch(zram->comps[ZRAM_PRIMARY_COMP]) &&
+		     bio->bi_iter.bi_size > PAGE_SIZE;
+	struct page *pages[ZCOMP_BATCH];
+	u32 indices[ZCOMP_BATCH];
+	unsigned int nr = 0;
 
 	do {
 		u32 index = iter.bi_sector >> SECTORS_PER_PAGE_SHIFT;
@@ -1918,12 +2340,27 @@ static void zram_bio_write(struct zram *zram, struct bio *bio)
 
 		bv.bv_len = min_t(u32, bv.bv_len, PAGE_SIZE - offset);
 
-		if (zram_bvec_write(zram, &bv, index, offset, bio) < 0) {
-			atomic64_inc(&zram->stats.failed_writes);
-			bio->bi_status = BLK_STS_IOERR;
-			break;
+		if (batch && !is_partial_io(&bv)) {
+			pages[nr] = bv.bv_page;
+			indices[nr++] = index;
+			bio_advance_iter_single(bio, &iter, bv.bv_len);
+			if (nr < ZCOMP_BATCH && iter.bi_size)
+				continue;
+			if (zram_write_batch(zram, pages, indices, nr) < 0)
+				goto failed;
+			nr = 0;
+			continue;
+		}
+
+		if (nr) {
+			if (zram_write_batch(zram, pages, indices, nr) < 0)
+				goto failed;
+			nr = 0;
 		}
 
+		if (zram_bvec_write(zram, &bv, index, offset, bio) < 0)
+			goto failed;
+
 		zram_slot_lock(zram, index);
 		zram_accessed(zram, index);
 		zram_slot_unlock(zram, index);
@@ -1933,6 +2370,13 @@ static void zram_bio_write(struct zram *zram, struct bio *bio)
 
 	bio_end_io_acct(bio, start_time);
 	bio_endio(bio);
+	return;
+
+failed:
+	atomic64_inc(&zram->stats.failed_writes);
+	bio->bi_status = BLK_STS_IOERR;
+	bio_end_io_acct(bio, start_time);
+	bio_endio(bio);
 }
 
 /*
@@ -2130,6 +2574,9 @@ static const struct block_device_operations zram_devops = {
 	.owner = THIS_MODULE
 };
 
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(dedup_enable);
+#endif
 static DEVICE_ATTR_WO(compact);
 static DEVICE_ATTR_RW(disksize);
 static DEVICE_ATTR_RO(initstate);
@@ -2149,6 +2596,10 @@ static DEVICE_ATTR_RW(writeback_limit_enable);
 static DEVICE_ATTR_RW(recomp_algorithm);
 static DEVICE_ATTR_WO(recompress);
 #endif
+#ifdef CONFIG_ZRAM_IDLE_POLICY
+static DEVICE_ATTR_RW(idle_policy_interval);
+static DEVICE_ATTR_RW(idle_policy_wb_budget);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -2160,6 +2611,9 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_idle.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_dedup_enable.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 	&dev_attr_writeback.attr,
@@ -2175,6 +2629,10 @@ static struct attribute *zram_disk_attrs[] = {
 #ifdef CONFIG_ZRAM_MULTI_COMP
 	&dev_attr_recomp_algorithm.attr,
 	&dev_attr_recompress.attr,
+#endif
+#ifdef CONFIG_ZRAM_IDLE_POLICY
+	&dev_attr_idle_policy_interval.attr,
+	&dev_attr_idle_policy_wb_budget.attr,
 #endif
 	NULL,
 };
@@ -2225,6 +2683,11 @@ static int zram_add(void)
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spin_lock_init(&zram->wb_limit_lock);
 #endif
+	zram_dedup_init(zram);
+
+	ret = zram_idle_policy_start(zram, device_id);
+	if (ret)
+		goto out_free_idr;
 
 	/* gendisk structure */
 	zram->disk = blk_alloc_disk(&lim, NUMA_NO_NODE);
@@ -2232,7 +2695,7 @@ static int zram_add(void)
 		pr_err("Error allocating disk structure for device %d\n",
 			device_id);
 		ret = PTR_ERR(zram->disk);
-		goto out_free_idr;
+		goto out_stop_policy;
 	}
 
 	zram->disk->major = zram_major;
@@ -2261,6 +2724,8 @@ static int zram_add(void)
 
 out_cleanup_disk:
 	put_disk(zram->disk);
+out_stop_policy:
+	zram_idle_policy_stop(zram);
 out_free_idr:
 	idr_remove(&zram_index_idr, device_id);
 out_free_dev:
@@ -2284,6 +2749,7 @@ static int zram_remove(struct zram *zram)
 	mutex_unlock(&zram->disk->open_mutex);
 
 	zram_debugfs_unregister(zram);
+	zram_idle_policy_stop(zram);
 
 	if (claimed) {
 		/*
@@ -130,11 +130,23 @@
  * util to the precomputed util threshold. If it's below, it defaults to the
  * TEO metrics mechanism. If it's above, the closest shallower idle state will
  * be selected instead, as long as is not a polling state.
+ *
+ * Interrupt timings:
+ *
+ * With CONFIG_CPU_IDLE_GOV_TEO_IRQ_TIMINGS and teo.irq_timings set, the
+ * arrival times of the device interrupts are recorded and the next one is
+ * predicted from the recurring intervals of each of them. A predicted
+ * interrupt closer than the closest timer limits the sleep length used for
+ * the timers check, so that a deep idle state is only selected when neither
+ * a timer nor a predictable interrupt is expected within its target
+ * residency.
  */
 
 #include <linux/cpuidle.h>
+#include <linux/interrupt.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/moduleparam.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
 #include <linux/sched/topology.h>
@@ -220,6 +232,67 @@ static bool teo_cpu_is_utilized(int cpu, struct teo_cpu *cpu_data)
 }
 #endif
 
+#ifdef CONFIG_CPU_IDLE_GOV_TEO_IRQ_TIMINGS
+static bool teo_irq_timings __read_mostly;
+static bool teo_irq_timings_ready;
+
+static int teo_irq_timings_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_bool(val, kp);
+
+	/* the boot time setting is applied by teo_irq_timings_init() */
+	if (ret || !teo_irq_timings_ready)
+		return ret;
+
+	if (READ_ONCE(teo_irq_timings))
+		irq_timings_enable();
+	else
+		irq_timings_disable();
+	return 0;
+}
+
+static const struct kernel_param_ops teo_irq_timings_ops = {
+	.set = teo_irq_timings_set,
+	.get = param_get_bool,
+};
+module_param_cb(irq_timings, &teo_irq_timings_ops, &teo_irq_timings, 0644);
+
+static int __init teo_irq_timings_init(void)
+{
+	kernel_param_lock(THIS_MODULE);
+	teo_irq_timings_ready = true;
+	if (teo_irq_timings)
+		irq_timings_enable();
+	kernel_param_unlock(THIS_MODULE);
+	return 0;
+}
+late_initcall(teo_irq_timings_init);
+
+/**
+ * teo_irq_sleep_length - Limit the sleep length to the next predicted IRQ.
+ * @duration_ns: Time till the closest timer event.
+ */
+static s64 teo_irq_sleep_length(s64 duration_ns)
+{
+	u64 now, next;
+
+	if (!READ_ONCE(teo_irq_timings))
+		return duration_ns;
+
+	now = local_clock();
+	next = irq_timings_next_event(now);
+	if (next == U64_MAX || next - now >= duration_ns)
+		return duration_ns;
+
+	return next - now;
+}
+#else
+static s64 teo_irq_sleep_length(s64 duration_ns)
+{
+	return duration_ns;
+}
+#endif
+
 /**
  * teo_update - Update CPU metrics after wakeup.
  * @drv: cpuidle driver containing state data.
@@ -591,6 +664,12 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 	duration_ns = tick_nohz_get_sleep_length(&delta_tick);
 	cpu_data->sleep_length_ns = duration_ns;
 
+	/*
+	 * The metrics keep tracking the timers, only the choice of the state
+	 * takes a predicted interrupt into account.
+	 */
+	duration_ns = teo_irq_sleep_length(duration_ns);
+
 	/*
 	 * If the closest expected timer is before the terget residency of the
 	 * candidate state, a shallower one needs to be found.
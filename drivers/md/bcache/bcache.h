@@ -393,6 +393,13 @@ struct cached_dev {
 	unsigned int		writeback_rate_fp_term_high;
 	unsigned int		writeback_rate_minimum;
 
+	/* max gap in sectors between keys written back in one pass */
+	unsigned int		writeback_merge_gap;
+	/* back off while backing writes are slower than this */
+	unsigned int		writeback_latency_target_us;
+	/* moving average of backing device writeback write latency */
+	unsigned int		writeback_latency_us;
+
 	enum stop_on_failure	stop_when_cache_set_failed;
 #define DEFAULT_CACHED_DEV_ERROR_LIMIT	64
 	atomic_t		io_errors;
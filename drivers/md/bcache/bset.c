@@ -944,6 +944,13 @@ static struct bset_search_iter bset_search_write_set(struct bset_tree *t,
 	while (li + 1 != ri) {
 		unsigned int m = (li + ri) >> 1;
 
+		/*
+		 * Every probe is a different cacheline: start fetching both
+		 * possible next midpoints while this one is compared.
+		 */
+		prefetch(table_to_bkey(t, (li + m) >> 1));
+		prefetch(table_to_bkey(t, (m + ri) >> 1));
+
 		if (bkey_cmp(table_to_bkey(t, m), search) > 0)
 			ri = m;
 		else
@@ -972,17 +979,14 @@ static struct bset_search_iter bset_search_tree(struct bset_tree *t,
 		j = n;
 		f = &t->tree[j];
 
-		if (likely(f->exponent != 127)) {
-			if (f->mantissa >= bfloat_mantissa(search, f))
-				n = j * 2;
-			else
-				n = j * 2 + 1;
-		} else {
-			if (bkey_cmp(tree_to_bkey(t, j), search) > 0)
-				n = j * 2;
-			else
-				n = j * 2 + 1;
-		}
+		/*
+		 * Pick the child without a branch, the outcome is random and
+		 * mispredicting it costs more than the comparison.
+		 */
+		if (likely(f->exponent != 127))
+			n = j * 2 + (f->mantissa < bfloat_mantissa(search, f));
+		else
+			n = j * 2 + (bkey_cmp(tree_to_bkey(t, j), search) <= 0);
 	} while (n < t->size);
 
 	inorder = to_inorder(j, t);
@@ -127,6 +127,9 @@ rw_attribute(writeback_rate_fp_term_mid);
 rw_attribute(writeback_rate_fp_term_high);
 rw_attribute(writeback_rate_minimum);
 read_attribute(writeback_rate_debug);
+rw_attribute(writeback_merge_gap);
+rw_attribute(writeback_latency_target_us);
+read_attribute(writeback_latency_us);
 
 read_attribute(stripe_size);
 read_attribute(partial_stripes_expensive);
@@ -213,6 +216,9 @@ SHOW(__bch_cached_dev)
 	var_print(writeback_rate_fp_term_mid);
 	var_print(writeback_rate_fp_term_high);
 	var_print(writeback_rate_minimum);
+	var_print(writeback_merge_gap);
+	var_print(writeback_latency_target_us);
+	sysfs_print(writeback_latency_us, READ_ONCE(dc->writeback_latency_us));
 
 	if (attr == &sysfs_writeback_rate_debug) {
 		char rate[20];
@@ -351,6 +357,10 @@ STORE(__cached_dev)
 	sysfs_strtoul_clamp(writeback_rate_minimum,
 			    dc->writeback_rate_minimum,
 			    1, UINT_MAX);
+	sysfs_strtoul_clamp(writeback_merge_gap, dc->writeback_merge_gap,
+			    0, UINT_MAX);
+	sysfs_strtoul_clamp(writeback_latency_target_us,
+			    dc->writeback_latency_target_us, 0, UINT_MAX);
 
 	sysfs_strtoul_clamp(io_error_limit, dc->error_limit, 0, INT_MAX);
 
@@ -524,6 +534,9 @@ static struct attribute *bch_cached_dev_attrs[] = {
 	&sysfs_writeback_rate_fp_term_high,
 	&sysfs_writeback_rate_minimum,
 	&sysfs_writeback_rate_debug,
+	&sysfs_writeback_merge_gap,
+	&sysfs_writeback_latency_target_us,
+	&sysfs_writeback_latency_us,
 	&sysfs_io_errors,
 	&sysfs_io_error_limit,
 	&sysfs_io_disable,
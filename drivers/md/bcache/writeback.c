@@ -312,17 +312,34 @@ static void update_writeback_rate(struct work_struct *work)
 static unsigned int writeback_delay(struct cached_dev *dc,
 				    unsigned int sectors)
 {
+	unsigned int delay, target, lat;
+
 	if (test_bit(BCACHE_DEV_DETACHING, &dc->disk.flags) ||
 	    !dc->writeback_percent)
 		return 0;
 
-	return bch_next_delay(&dc->writeback_rate, sectors);
+	delay = bch_next_delay(&dc->writeback_rate, sectors);
+
+	/*
+	 * When writeback writes get slower than the target, foreground I/O
+	 * to the backing device suffers too: stretch the delay after each
+	 * pass by how far over the target they are, unless the cache set is
+	 * idle and we are writing back as fast as possible anyway.
+	 */
+	target = dc->writeback_latency_target_us;
+	lat = READ_ONCE(dc->writeback_latency_us);
+	if (sectors && target && lat > target &&
+	    !atomic_read(&dc->disk.c->at_max_writeback_rate))
+		delay = min_t(u64, (u64)max(delay, 1U) * lat / target, HZ);
+
+	return delay;
 }
 
 struct dirty_io {
 	struct closure		cl;
 	struct cached_dev	*dc;
 	uint16_t		sequence;
+	u64			start_time_ns;
 	struct bio		bio;
 };
 
@@ -395,6 +412,15 @@ static void dirty_endio(struct bio *bio)
 	if (bio->bi_status) {
 		SET_KEY_DIRTY(&w->key, false);
 		bch_count_backing_io_errors(io->dc, bio);
+	} else {
+		struct cached_dev *dc = io->dc;
+		unsigned int lat = min_t(u64, UINT_MAX / 8,
+			div_u64(ktime_get_ns() - io->start_time_ns,
+				NSEC_PER_USEC));
+		unsigned int ewma = READ_ONCE(dc->writeback_latency_us);
+
+		/* racy, but an approximate average is all we need */
+		WRITE_ONCE(dc->writeback_latency_us, ewma - ewma / 8 + lat / 8);
 	}
 
 	closure_put(&io->cl);
@@ -438,6 +464,7 @@ static CLOSURE_CALLBACK(write_dirty)
 		io->bio.bi_iter.bi_sector = KEY_START(&w->key);
 		bio_set_dev(&io->bio, io->dc->bdev);
 		io->bio.bi_end_io	= dirty_endio;
+		io->start_time_ns	= ktime_get_ns();
 
 		/* I/O request sent to backing device */
 		closure_bio_submit(io->dc->disk.c, &io->bio, cl);
@@ -471,6 +498,19 @@ static CLOSURE_CALLBACK(read_dirty_submit)
 	continue_at(cl, write_dirty, io->dc->writeback_write_wq);
 }
 
+static bool writeback_can_merge(struct cached_dev *dc,
+				struct keybuf_key *prev,
+				struct keybuf_key *next)
+{
+	if (!bkey_cmp(&prev->key, &START_KEY(&next->key)))
+		return true;
+
+	return KEY_INODE(&prev->key) == KEY_INODE(&next->key) &&
+		bkey_cmp(&prev->key, &START_KEY(&next->key)) < 0 &&
+		KEY_START(&next->key) - KEY_OFFSET(&prev->key) <=
+			dc->writeback_merge_gap;
+}
+
 static void read_dirty(struct cached_dev *dc)
 {
 	unsigned int delay = 0;
@@ -517,15 +557,13 @@ static void read_dirty(struct cached_dev *dc)
 
 			/*
 			 * Operations are only eligible to be combined
-			 * if they are contiguous.
-			 *
-			 * TODO: add a heuristic willing to fire a
-			 * certain amount of non-contiguous IO per pass,
-			 * so that we can benefit from backing device
-			 * command queueing.
+			 * if they are contiguous, or at most
+			 * writeback_merge_gap sectors apart: the writes are
+			 * issued in order, so the backing device still sees
+			 * a nearly sequential stream it can queue and merge.
 			 */
-			if ((nk != 0) && bkey_cmp(&keys[nk-1]->key,
-						&START_KEY(&next->key)))
+			if ((nk != 0) && !writeback_can_merge(dc, keys[nk-1],
+							      next))
 				break;
 
 			size += KEY_SIZE(&next->key);
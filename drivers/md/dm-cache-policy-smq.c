@@ -14,6 +14,7 @@
 #include <linux/jiffies.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/vmalloc.h>
 #include <linux/math64.h>
 
@@ -794,11 +795,32 @@ static struct entry *get_entry(struct entry_alloc *ea, unsigned int index)
 #define HOTSPOT_UPDATE_PERIOD (HZ)
 #define CACHE_UPDATE_PERIOD (60ul * HZ)
 
+/*
+ * Hits are found with the policy lock held for read and recorded per cpu.
+ * They are applied to the cache queues and stats in batches, next time
+ * the lock is taken for write.
+ */
+#define SMQ_HIT_BATCH 32
+
+struct smq_hit {
+	dm_cblock_t cblock;
+	dm_oblock_t oblock;
+};
+
+struct smq_hit_batch {
+	unsigned int nr;
+	struct smq_hit hits[SMQ_HIT_BATCH];
+};
+
 struct smq_policy {
 	struct dm_cache_policy policy;
 
-	/* protects everything */
-	spinlock_t lock;
+	/*
+	 * Protects everything.  Only the hit path in lookup takes it for
+	 * read, and it may only touch its own cpu's hit batch.
+	 */
+	rwlock_t lock;
+	struct smq_hit_batch __percpu *hits;
 	dm_cblock_t cache_size;
 	sector_t cache_block_size;
 
@@ -1017,6 +1039,36 @@ static void requeue(struct smq_policy *mq, struct entry *e)
 	}
 }
 
+static void flush_hits(struct smq_policy *mq, struct smq_hit_batch *b)
+{
+	unsigned int i;
+	struct entry *e;
+
+	for (i = 0; i < b->nr; i++) {
+		e = get_entry(&mq->cache_alloc, from_cblock(b->hits[i].cblock));
+
+		/*
+		 * The mapping may have been removed, or the cblock reused,
+		 * since the hit was recorded.
+		 */
+		if (!e->allocated || e->oblock != b->hits[i].oblock)
+			continue;
+
+		stats_level_accessed(&mq->cache_stats, e->level);
+		requeue(mq, e);
+	}
+
+	b->nr = 0;
+}
+
+static void flush_all_hits(struct smq_policy *mq)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		flush_hits(mq, per_cpu_ptr(mq->hits, cpu));
+}
+
 static unsigned int default_promote_level(struct smq_policy *mq)
 {
 	/*
@@ -1365,6 +1417,7 @@ static void smq_destroy(struct dm_cache_policy *p)
 	btracker_destroy(mq->bg_work);
 	h_exit(&mq->hotspot_table);
 	h_exit(&mq->table);
+	free_percpu(mq->hits);
 	free_bitset(mq->hotspot_hit_bits);
 	free_bitset(mq->cache_hit_bits);
 	space_exit(&mq->es);
@@ -1382,6 +1435,8 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 
 	*background_work = false;
 
+	flush_hits(mq, this_cpu_ptr(mq->hits));
+
 	e = h_lookup(&mq->table, oblock);
 	if (e) {
 		stats_level_accessed(&mq->cache_stats, e->level);
@@ -1408,6 +1463,32 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 	}
 }
 
+/*
+ * Called with the lock held for read.  Doesn't move the entry to the front
+ * of its hash bucket, the hit is just recorded and applied by flush_hits().
+ * Returns -EAGAIN if the hit batch is full.
+ */
+static int __lookup_hit(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblock)
+{
+	struct smq_hit_batch *b = this_cpu_ptr(mq->hits);
+	unsigned int h = hash_64(from_oblock(oblock), mq->table.hash_bits);
+	struct entry *e, *prev;
+
+	e = __h_lookup(&mq->table, h, oblock, &prev);
+	if (!e)
+		return -ENOENT;
+
+	if (b->nr == SMQ_HIT_BATCH)
+		return -EAGAIN;
+
+	*cblock = infer_cblock(mq, e);
+	b->hits[b->nr].cblock = *cblock;
+	b->hits[b->nr].oblock = oblock;
+	b->nr++;
+
+	return 0;
+}
+
 static int smq_lookup(struct dm_cache_policy *p, dm_oblock_t oblock, dm_cblock_t *cblock,
 		      int data_dir, bool fast_copy,
 		      bool *background_work)
@@ -1416,11 +1497,20 @@ static int smq_lookup(struct dm_cache_policy *p, dm_oblock_t oblock, dm_cblock_t
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	read_lock_irqsave(&mq->lock, flags);
+	r = __lookup_hit(mq, oblock, cblock);
+	read_unlock_irqrestore(&mq->lock, flags);
+
+	if (!r) {
+		*background_work = false;
+		return 0;
+	}
+
+	write_lock_irqsave(&mq->lock, flags);
 	r = __lookup(mq, oblock, cblock,
 		     data_dir, fast_copy,
 		     NULL, background_work);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 
 	return r;
 }
@@ -1435,9 +1525,16 @@ static int smq_lookup_with_work(struct dm_cache_policy *p,
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	read_lock_irqsave(&mq->lock, flags);
+	r = __lookup_hit(mq, oblock, cblock);
+	read_unlock_irqrestore(&mq->lock, flags);
+
+	if (!r)
+		return 0;
+
+	write_lock_irqsave(&mq->lock, flags);
 	r = __lookup(mq, oblock, cblock, data_dir, fast_copy, work, &background_queued);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 
 	return r;
 }
@@ -1449,7 +1546,7 @@ static int smq_get_background_work(struct dm_cache_policy *p, bool idle,
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	write_lock_irqsave(&mq->lock, flags);
 	r = btracker_issue(mq->bg_work, result);
 	if (r == -ENODATA) {
 		if (!clean_target_met(mq, idle)) {
@@ -1457,7 +1554,7 @@ static int smq_get_background_work(struct dm_cache_policy *p, bool idle,
 			r = btracker_issue(mq->bg_work, result);
 		}
 	}
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 
 	return r;
 }
@@ -1519,9 +1616,9 @@ static void smq_complete_background_work(struct dm_cache_policy *p,
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	write_lock_irqsave(&mq->lock, flags);
 	__complete_background_work(mq, work, success);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 }
 
 // in_hash(oblock) -> in_hash(oblock)
@@ -1543,9 +1640,9 @@ static void smq_set_dirty(struct dm_cache_policy *p, dm_cblock_t cblock)
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	write_lock_irqsave(&mq->lock, flags);
 	__smq_set_clear_dirty(mq, cblock, true);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 }
 
 static void smq_clear_dirty(struct dm_cache_policy *p, dm_cblock_t cblock)
@@ -1553,9 +1650,9 @@ static void smq_clear_dirty(struct dm_cache_policy *p, dm_cblock_t cblock)
 	struct smq_policy *mq = to_smq_policy(p);
 	unsigned long flags;
 
-	spin_lock_irqsave(&mq->lock, flags);
+	write_lock_irqsave(&mq->lock, flags);
 	__smq_set_clear_dirty(mq, cblock, false);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 }
 
 static unsigned int random_level(dm_cblock_t cblock)
@@ -1617,9 +1714,9 @@ static dm_cblock_t smq_residency(struct dm_cache_policy *p)
 	unsigned long flags;
 	struct smq_policy *mq = to_smq_policy(p);
 
-	spin_lock_irqsave(&mq->lock, flags);
+	read_lock_irqsave(&mq->lock, flags);
 	r = to_cblock(mq->cache_alloc.nr_allocated);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	read_unlock_irqrestore(&mq->lock, flags);
 
 	return r;
 }
@@ -1629,12 +1726,13 @@ static void smq_tick(struct dm_cache_policy *p, bool can_block)
 	struct smq_policy *mq = to_smq_policy(p);
 	unsigned long flags;
 
-	spin_lock_irqsave(&mq->lock, flags);
+	write_lock_irqsave(&mq->lock, flags);
+	flush_all_hits(mq);
 	mq->tick++;
 	update_sentinels(mq);
 	end_hotspot_period(mq);
 	end_cache_period(mq);
-	spin_unlock_irqrestore(&mq->lock, flags);
+	write_unlock_irqrestore(&mq->lock, flags);
 }
 
 static void smq_allow_migrations(struct dm_cache_policy *p, bool allow)
@@ -1786,8 +1884,14 @@ __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_
 	} else
 		mq->cache_hit_bits = NULL;
 
+	mq->hits = alloc_percpu(struct smq_hit_batch);
+	if (!mq->hits) {
+		DMERR("couldn't allocate hit batches");
+		goto bad_hits;
+	}
+
 	mq->tick = 0;
-	spin_lock_init(&mq->lock);
+	rwlock_init(&mq->lock);
 
 	q_init(&mq->hotspot, &mq->es, NR_HOTSPOT_LEVELS);
 	mq->hotspot.nr_top_levels = 8;
@@ -1826,6 +1930,8 @@ __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_
 bad_alloc_hotspot_table:
 	h_exit(&mq->table);
 bad_alloc_table:
+	free_percpu(mq->hits);
+bad_hits:
 	free_bitset(mq->cache_hit_bits);
 bad_cache_hit_bits:
 	free_bitset(mq->hotspot_hit_bits);
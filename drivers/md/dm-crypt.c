@@ -88,6 +88,8 @@ struct dm_crypt_io {
 
 	struct bvec_iter saved_bi_iter;
 
+	u64 crypt_start_ns;
+
 	struct rb_node rb_node;
 } CRYPTO_MINALIGN_ATTR;
 
@@ -152,11 +154,18 @@ enum cipher_flags {
 /*
  * The fields in here must be read only after initialization.
  */
+/* time spent from starting to finishing the en/decryption of bios */
+struct crypt_latency_stats {
+	u64 nr[2];
+	u64 ns[2];
+};
+
 struct crypt_config {
 	struct dm_dev *dev;
 	sector_t start;
 
 	struct percpu_counter n_allocated_pages;
+	struct crypt_latency_stats __percpu *lat_stats;
 
 	struct workqueue_struct *io_queue;
 	struct workqueue_struct *crypt_queue;
@@ -1994,6 +2003,15 @@ static int dmcrypt_write(void *data)
 	return 0;
 }
 
+static void crypt_account_latency(struct dm_crypt_io *io)
+{
+	struct crypt_latency_stats __percpu *stats = io->cc->lat_stats;
+	int rw = bio_data_dir(io->base_bio);
+
+	this_cpu_inc(stats->nr[rw]);
+	this_cpu_add(stats->ns[rw], ktime_get_ns() - io->crypt_start_ns);
+}
+
 static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 {
 	struct bio *clone = io->ctx.bio_out;
@@ -2002,6 +2020,8 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 	sector_t sector;
 	struct rb_node **rbp, *parent;
 
+	crypt_account_latency(io);
+
 	if (unlikely(io->error)) {
 		crypt_free_buffer_pages(cc, clone);
 		bio_put(clone);
@@ -2104,6 +2124,7 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 	 */
 	crypt_inc_pending(io);
 	crypt_convert_init(cc, ctx, NULL, io->base_bio, sector);
+	io->crypt_start_ns = ktime_get_ns();
 
 	clone = crypt_alloc_buffer(io, io->base_bio->bi_iter.bi_size);
 	if (unlikely(!clone)) {
@@ -2156,6 +2177,8 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 
 static void kcryptd_crypt_read_done(struct dm_crypt_io *io)
 {
+	crypt_account_latency(io);
+
 	if (io->ctx.aead_recheck) {
 		if (!io->error) {
 			io->ctx.bio_in->bi_iter = io->saved_bi_iter;
@@ -2192,6 +2215,7 @@ static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
 	blk_status_t r;
 
 	crypt_inc_pending(io);
+	io->crypt_start_ns = ktime_get_ns();
 
 	if (io->ctx.aead_recheck) {
 		io->ctx.cc_sector = io->sector + cc->iv_offset;
@@ -2787,6 +2811,7 @@ static void crypt_dtr(struct dm_target *ti)
 
 	WARN_ON(percpu_counter_sum(&cc->n_allocated_pages) != 0);
 	percpu_counter_destroy(&cc->n_allocated_pages);
+	free_percpu(cc->lat_stats);
 
 	if (cc->iv_gen_ops && cc->iv_gen_ops->dtr)
 		cc->iv_gen_ops->dtr(cc);
@@ -3277,6 +3302,13 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	if (ret < 0)
 		goto bad;
 
+	cc->lat_stats = alloc_percpu(struct crypt_latency_stats);
+	if (!cc->lat_stats) {
+		ti->error = "Cannot allocate latency statistics";
+		ret = -ENOMEM;
+		goto bad;
+	}
+
 	/* Optional parameters need to be read before cipher constructor */
 	if (argc > 5) {
 		ret = crypt_ctr_optional(ti, argc - 5, &argv[5]);
@@ -3552,9 +3584,25 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 	int num_feature_args = 0;
 
 	switch (type) {
-	case STATUSTYPE_INFO:
-		result[0] = '\0';
+	case STATUSTYPE_INFO: {
+		struct crypt_latency_stats sum = {};
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			struct crypt_latency_stats *stats =
+				per_cpu_ptr(cc->lat_stats, cpu);
+
+			sum.nr[READ] += stats->nr[READ];
+			sum.ns[READ] += stats->ns[READ];
+			sum.nr[WRITE] += stats->nr[WRITE];
+			sum.ns[WRITE] += stats->ns[WRITE];
+		}
+		/* <reads> <read crypt usecs> <writes> <write crypt usecs> */
+		DMEMIT("%llu %llu %llu %llu",
+		       sum.nr[READ], div_u64(sum.ns[READ], NSEC_PER_USEC),
+		       sum.nr[WRITE], div_u64(sum.ns[WRITE], NSEC_PER_USEC));
 		break;
+	}
 
 	case STATUSTYPE_TABLE:
 		DMEMIT("%s ", cc->cipher_string);
@@ -3731,7 +3779,7 @@ static void crypt_io_hints(struct dm_target *ti, struct queue_limits *limits)
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 26, 0},
+	.version = {1, 27, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
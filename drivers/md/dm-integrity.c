@@ -218,6 +218,8 @@ struct dm_integrity_c {
 	int failed;
 
 	struct crypto_shash *internal_hash;
+	/* exported internal_hash state after the fixed salt, if any */
+	u8 *internal_hash_state;
 
 	struct dm_target *ti;
 
@@ -1648,6 +1650,15 @@ static void integrity_sector_checksum(struct dm_integrity_c *ic, sector_t sector
 
 	req->tfm = ic->internal_hash;
 
+	if (ic->internal_hash_state) {
+		r = crypto_shash_import(req, ic->internal_hash_state);
+		if (unlikely(r < 0)) {
+			dm_integrity_io_error(ic, "crypto_shash_import", r);
+			goto failed;
+		}
+		goto salted;
+	}
+
 	r = crypto_shash_init(req);
 	if (unlikely(r < 0)) {
 		dm_integrity_io_error(ic, "crypto_shash_init", r);
@@ -1662,21 +1673,16 @@ static void integrity_sector_checksum(struct dm_integrity_c *ic, sector_t sector
 		}
 	}
 
+salted:
 	r = crypto_shash_update(req, (const __u8 *)&sector_le, sizeof(sector_le));
 	if (unlikely(r < 0)) {
 		dm_integrity_io_error(ic, "crypto_shash_update", r);
 		goto failed;
 	}
 
-	r = crypto_shash_update(req, data, ic->sectors_per_block << SECTOR_SHIFT);
+	r = crypto_shash_finup(req, data, ic->sectors_per_block << SECTOR_SHIFT, result);
 	if (unlikely(r < 0)) {
-		dm_integrity_io_error(ic, "crypto_shash_update", r);
-		goto failed;
-	}
-
-	r = crypto_shash_final(req, result);
-	if (unlikely(r < 0)) {
-		dm_integrity_io_error(ic, "crypto_shash_final", r);
+		dm_integrity_io_error(ic, "crypto_shash_finup", r);
 		goto failed;
 	}
 
@@ -1691,6 +1697,41 @@ static void integrity_sector_checksum(struct dm_integrity_c *ic, sector_t sector
 	get_random_bytes(result, ic->tag_size);
 }
 
+/*
+ * With a fixed HMAC every tag starts by hashing the same salt; hash it once
+ * and import the resulting state in integrity_sector_checksum().  This is
+ * only an optimization, if the state can't be exported the salt is hashed
+ * for every block as before.
+ */
+static int integrity_init_hash_state(struct dm_integrity_c *ic)
+{
+	SHASH_DESC_ON_STACK(req, ic->internal_hash);
+	u8 *state;
+	int r;
+
+	if (!ic->internal_hash || !(ic->sb->flags & cpu_to_le32(SB_FLAG_FIXED_HMAC)))
+		return 0;
+
+	state = kmalloc(crypto_shash_statesize(ic->internal_hash), GFP_KERNEL);
+	if (!state)
+		return -ENOMEM;
+
+	req->tfm = ic->internal_hash;
+	r = crypto_shash_init(req);
+	if (!r)
+		r = crypto_shash_update(req, (__u8 *)&ic->sb->salt, SALT_SIZE);
+	if (!r)
+		r = crypto_shash_export(req, state);
+	shash_desc_zero(req);
+
+	if (r)
+		kfree_sensitive(state);
+	else
+		ic->internal_hash_state = state;
+
+	return 0;
+}
+
 static noinline void integrity_recheck(struct dm_integrity_io *dio, char *checksum)
 {
 	struct bio *bio = dm_bio_from_per_bio_data(dio, sizeof(struct dm_integrity_io));
@@ -4649,6 +4690,12 @@ static int dm_integrity_ctr(struct dm_target *ti, unsigned int argc, char **argv
 		}
 	}
 
+	r = integrity_init_hash_state(ic);
+	if (r) {
+		ti->error = "Cannot allocate hash state";
+		goto bad;
+	}
+
 	if (!ic->internal_hash)
 		dm_integrity_set(ti, ic);
 
@@ -4725,6 +4772,7 @@ static void dm_integrity_dtr(struct dm_target *ti)
 	if (ic->sb)
 		free_pages_exact(ic->sb, SB_SECTORS << SECTOR_SHIFT);
 
+	kfree_sensitive(ic->internal_hash_state);
 	if (ic->internal_hash)
 		crypto_free_shash(ic->internal_hash);
 	free_alg(&ic->internal_hash_alg);
@@ -497,7 +497,12 @@ static int run_complete_job(struct kcopyd_job *job)
 	dm_kcopyd_notify_fn fn = job->fn;
 	struct dm_kcopyd_client *kc = job->kc;
 
-	if (job->pages && job->pages != &zero_page_list)
+	/*
+	 * Sub jobs hand their pages on to the next chunk of the copy,
+	 * segment_complete() releases them.
+	 */
+	if (job->pages && job->pages != &zero_page_list &&
+	    job->master_job == job)
 		kcopyd_put_pages(kc, job->pages);
 	/*
 	 * If this is the master job, the sub jobs have already
@@ -683,7 +688,8 @@ static void dispatch_job(struct kcopyd_job *job)
 	atomic_inc(&kc->nr_jobs);
 	if (unlikely(!job->source.count))
 		push(&kc->callback_jobs, job);
-	else if (job->pages == &zero_page_list)
+	else if (job->pages)
+		/* zeroing, or a sub job that kept its pages */
 		push(&kc->io_jobs, job);
 	else
 		push(&kc->pages_jobs, job);
@@ -699,6 +705,11 @@ static void segment_complete(int read_err, unsigned long write_err,
 	struct kcopyd_job *sub_job = context;
 	struct kcopyd_job *job = sub_job->master_job;
 	struct dm_kcopyd_client *kc = job->kc;
+	struct page_list *pages = sub_job->pages;
+	sector_t prev_count = sub_job->source.count;
+
+	if (pages == &zero_page_list)
+		pages = NULL;
 
 	mutex_lock(&job->lock);
 
@@ -726,10 +737,22 @@ static void segment_complete(int read_err, unsigned long write_err,
 	}
 	mutex_unlock(&job->lock);
 
+	/*
+	 * Reuse the pages of the previous chunk if they are big enough,
+	 * this saves freeing and reallocating them for every chunk of a
+	 * large copy.
+	 */
+	if (pages && (!count || count > prev_count)) {
+		kcopyd_put_pages(kc, pages);
+		pages = NULL;
+	}
+
 	if (count) {
 		int i;
 
 		*sub_job = *job;
+		if (pages)
+			sub_job->pages = pages;
 		sub_job->write_offset = progress;
 		sub_job->source.sector += progress;
 		sub_job->source.count = count;
@@ -771,6 +794,8 @@ static void split_job(struct kcopyd_job *master_job)
 	atomic_set(&master_job->sub_jobs, SPLIT_COUNT);
 	for (i = 0; i < SPLIT_COUNT; i++) {
 		master_job[i + 1].master_job = master_job;
+		master_job[i + 1].pages = NULL;
+		master_job[i + 1].source.count = 0;
 		segment_complete(0, 0u, &master_job[i + 1]);
 	}
 }
@@ -10,6 +10,7 @@
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/device-mapper.h>
+#include <uapi/linux/dm-stats.h>
 
 #include "dm-core.h"
 #include "dm-stats.h"
@@ -932,6 +933,106 @@ static int dm_stats_print(struct dm_stats *stats, int id,
 	return 1;
 }
 
+static size_t dm_stat_record_size(struct dm_stat *s)
+{
+	return struct_size_t(struct dm_stats_area, histogram,
+			     s->n_histogram_entries ? s->n_histogram_entries + 1 : 0);
+}
+
+static void dm_stat_fill_record(struct dm_stat *s, size_t x,
+				struct dm_stats_area *a)
+{
+	struct dm_stat_shared *shared = &s->stat_shared[x];
+	sector_t start = s->start + s->step * x;
+	sector_t end = start + s->step;
+
+	if (unlikely(end > s->end))
+		end = s->end;
+
+	__dm_stat_init_temporary_percpu_totals(shared, s, x);
+
+	a->record_size = dm_stat_record_size(s);
+	a->region_id = s->id;
+	a->start = start;
+	a->len = end - start;
+	a->reads = shared->tmp.ios[READ];
+	a->read_merges = shared->tmp.merges[READ];
+	a->read_sectors = shared->tmp.sectors[READ];
+	a->read_ticks = dm_jiffies_to_msec64(s, shared->tmp.ticks[READ]);
+	a->writes = shared->tmp.ios[WRITE];
+	a->write_merges = shared->tmp.merges[WRITE];
+	a->write_sectors = shared->tmp.sectors[WRITE];
+	a->write_ticks = dm_jiffies_to_msec64(s, shared->tmp.ticks[WRITE]);
+	a->in_flight = dm_stat_in_flight(shared);
+	a->io_ticks = dm_jiffies_to_msec64(s, shared->tmp.io_ticks_total);
+	a->time_in_queue = dm_jiffies_to_msec64(s, shared->tmp.time_in_queue);
+	a->read_io_ticks = dm_jiffies_to_msec64(s, shared->tmp.io_ticks[READ]);
+	a->write_io_ticks = dm_jiffies_to_msec64(s, shared->tmp.io_ticks[WRITE]);
+	if (s->n_histogram_entries)
+		memcpy(a->histogram, shared->tmp.histogram,
+		       (s->n_histogram_entries + 1) * sizeof(unsigned long long));
+}
+
+/*
+ * Read the records described in <uapi/linux/dm-stats.h>, as if all
+ * regions were laid out one after the other, starting at @off.
+ */
+ssize_t dm_stats_read_binary(struct dm_stats *stats, char *buf, loff_t off,
+			     size_t count)
+{
+	struct dm_stats_area *rec = NULL;
+	size_t rec_alloc = 0, copied = 0;
+	struct dm_stat *s;
+	loff_t pos = 0;
+	ssize_t r = 0;
+
+	mutex_lock(&stats->mutex);
+
+	list_for_each_entry(s, &stats->list, list_entry) {
+		size_t rec_size = dm_stat_record_size(s);
+		loff_t region_size = (loff_t)rec_size * s->n_entries;
+		size_t x;
+
+		if (pos + region_size <= off) {
+			pos += region_size;
+			continue;
+		}
+
+		if (rec_size > rec_alloc) {
+			kvfree(rec);
+			rec = kvmalloc(rec_size, GFP_KERNEL);
+			if (!rec) {
+				r = -ENOMEM;
+				goto out;
+			}
+			rec_alloc = rec_size;
+		}
+
+		for (x = div_u64(off + copied - pos, rec_size);
+		     x < s->n_entries && copied < count; x++) {
+			size_t skip = off + copied - (pos + (loff_t)x * rec_size);
+			size_t n = min(rec_size - skip, count - copied);
+
+			dm_stat_fill_record(s, x, rec);
+			memcpy(buf + copied, (char *)rec + skip, n);
+			copied += n;
+
+			cond_resched();
+		}
+
+		if (copied >= count)
+			break;
+		pos += region_size;
+	}
+
+	r = copied;
+out:
+	mutex_unlock(&stats->mutex);
+	kvfree(rec);
+
+	return r;
+}
+
 static int dm_stats_set_aux(struct dm_stats *stats, int id, const char *aux_data)
 {
 	struct dm_stat *s;
@@ -29,6 +29,9 @@ struct mapped_device;
 int dm_stats_message(struct mapped_device *md, unsigned int argc, char **argv,
 		     char *result, unsigned int maxlen);
 
+ssize_t dm_stats_read_binary(struct dm_stats *stats, char *buf, loff_t off,
+			     size_t count);
+
 void dm_stats_account_io(struct dm_stats *stats, unsigned long bi_rw,
 			 sector_t bi_sector, unsigned int bi_sectors, bool end,
 			 unsigned long start_time,
@@ -99,6 +99,23 @@ static ssize_t dm_attr_use_blk_mq_show(struct mapped_device *md, char *buf)
 	return strlen(buf);
 }
 
+static ssize_t stats_read(struct file *filp, struct kobject *kobj,
+			  struct bin_attribute *attr, char *buf,
+			  loff_t off, size_t count)
+{
+	struct mapped_device *md;
+	ssize_t ret;
+
+	md = dm_get_from_kobject(kobj);
+	if (!md)
+		return -EINVAL;
+
+	ret = dm_stats_read_binary(dm_get_stats(md), buf, off, count);
+	dm_put(md);
+
+	return ret;
+}
+
 static DM_ATTR_RO(name);
 static DM_ATTR_RO(uuid);
 static DM_ATTR_RO(suspended);
@@ -113,7 +130,20 @@ static struct attribute *dm_attrs[] = {
 	&dm_attr_rq_based_seq_io_merge_deadline.attr,
 	NULL,
 };
-ATTRIBUTE_GROUPS(dm);
+
+/* binary statistics, see <uapi/linux/dm-stats.h> */
+static BIN_ATTR_ADMIN_RO(stats, 0);
+
+static struct bin_attribute *dm_bin_attrs[] = {
+	&bin_attr_stats,
+	NULL,
+};
+
+static const struct attribute_group dm_group = {
+	.attrs = dm_attrs,
+	.bin_attrs = dm_bin_attrs,
+};
+__ATTRIBUTE_GROUPS(dm);
 
 static const struct sysfs_ops dm_sysfs_ops = {
 	.show	= dm_attr_show,
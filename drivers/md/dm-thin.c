@@ -2178,6 +2178,40 @@ static void __sort_thin_deferred_bios(struct thin_c *tc)
 	__extract_sorted_bios(tc);
 }
 
+/*
+ * Look up the mappings of the next batch of bios without blocking.  Each
+ * lookup that misses the metadata cache queues a prefetch of the missing
+ * btree node, so the metadata reads for the batch are issued together
+ * instead of one at a time as process_bio() gets to each bio.
+ */
+#define THIN_PREFETCH_BATCH 128
+
+static bool prefetch_thin_mapping(struct thin_c *tc, struct bio *bio)
+{
+	struct dm_thin_lookup_result lookup_result;
+
+	if (bio_op(bio) == REQ_OP_DISCARD)
+		return false;
+
+	return dm_thin_find_block(tc->td, get_bio_block(tc, bio), 0,
+				  &lookup_result) == -EWOULDBLOCK;
+}
+
+/* @bio has already been popped off the head of @bios */
+static void prefetch_thin_mappings(struct thin_c *tc, struct bio *bio,
+				   struct bio_list *bios)
+{
+	unsigned int count = 1;
+	bool missed = prefetch_thin_mapping(tc, bio);
+
+	for (bio = bios->head; bio && count < THIN_PREFETCH_BATCH;
+	     bio = bio->bi_next, count++)
+		missed |= prefetch_thin_mapping(tc, bio);
+
+	if (missed)
+		dm_pool_issue_prefetches(tc->pool->pmd);
+}
+
 static void process_thin_deferred_bios(struct thin_c *tc)
 {
 	struct pool *pool = tc->pool;
@@ -2223,6 +2257,9 @@ static void process_thin_deferred_bios(struct thin_c *tc)
 			break;
 		}
 
+		if ((count % THIN_PREFETCH_BATCH) == 0)
+			prefetch_thin_mappings(tc, bio, &bios);
+
 		if (bio_op(bio) == REQ_OP_DISCARD)
 			pool->process_discard(tc, bio);
 		else
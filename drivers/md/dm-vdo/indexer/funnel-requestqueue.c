@@ -7,6 +7,10 @@
 
 #include <linux/atomic.h>
 #include <linux/compiler.h>
+#include <linux/cpumask.h>
+#include <linux/numa.h>
+#include <linux/sched.h>
+#include <linux/topology.h>
 #include <linux/wait.h>
 
 #include "funnel-queue.h"
@@ -57,6 +61,8 @@ struct uds_request_queue {
 	struct funnel_queue *retry_queue;
 	/* The thread id of the worker thread */
 	struct thread *thread;
+	/* The NUMA node the worker runs on, or NUMA_NO_NODE */
+	int node;
 	/* True if the worker was started */
 	bool started;
 	/* When true, requests can be enqueued */
@@ -137,6 +143,9 @@ static void request_queue_worker(void *arg)
 	bool waited = false;
 	long current_batch = 0;
 
+	if (queue->node != NUMA_NO_NODE)
+		set_cpus_allowed_ptr(current, cpumask_of_node(queue->node));
+
 	for (;;) {
 		wait_for_request(queue, dormant, time_batch, &request, &waited);
 		if (likely(request != NULL)) {
@@ -192,7 +201,7 @@ static void request_queue_worker(void *arg)
 }
 
 int uds_make_request_queue(const char *queue_name,
-			   uds_request_queue_processor_fn processor,
+			   uds_request_queue_processor_fn processor, int node,
 			   struct uds_request_queue **queue_ptr)
 {
 	int result;
@@ -203,6 +212,7 @@ int uds_make_request_queue(const char *queue_name,
 		return result;
 
 	queue->processor = processor;
+	queue->node = node;
 	queue->running = true;
 	atomic_set(&queue->dormant, false);
 	init_waitqueue_head(&queue->wait_head);
@@ -6,6 +6,7 @@
 #include "index-session.h"
 
 #include <linux/atomic.h>
+#include <linux/numa.h>
 
 #include "logger.h"
 #include "memory-alloc.h"
@@ -230,7 +231,7 @@ static int __must_check make_empty_index_session(struct uds_index_session **inde
 	mutex_init(&session->load_context.mutex);
 	uds_init_cond(&session->load_context.cond);
 
-	result = uds_make_request_queue("callbackW", &handle_callbacks,
+	result = uds_make_request_queue("callbackW", &handle_callbacks, NUMA_NO_NODE,
 					&session->callback_queue);
 	if (result != UDS_SUCCESS) {
 		vdo_free(session);
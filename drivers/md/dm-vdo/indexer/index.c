@@ -6,6 +6,9 @@
 
 #include "index.h"
 
+#include <linux/nodemask.h>
+#include <linux/numa.h>
+
 #include "logger.h"
 #include "memory-alloc.h"
 
@@ -647,6 +650,28 @@ static void execute_zone_request(struct uds_request *request)
 	index->callback(request);
 }
 
+/*
+ * Spread the zone threads over the online NUMA nodes. The zone which handles a request is chosen
+ * by its record name, so each zone sees a uniform share of the requests; pinning the zones to
+ * different nodes keeps each zone's working set local to the cpus that use it.
+ */
+static int get_zone_node(unsigned int zone_number)
+{
+	unsigned int nodes = num_online_nodes();
+	int node;
+
+	if (nodes <= 1)
+		return NUMA_NO_NODE;
+
+	zone_number %= nodes;
+	for_each_online_node(node) {
+		if (zone_number-- == 0)
+			return node;
+	}
+
+	return NUMA_NO_NODE;
+}
+
 static int initialize_index_queues(struct uds_index *index,
 				   const struct index_geometry *geometry)
 {
@@ -655,14 +680,14 @@ static int initialize_index_queues(struct uds_index *index,
 
 	for (i = 0; i < index->zone_count; i++) {
 		result = uds_make_request_queue("indexW", &execute_zone_request,
-						&index->zone_queues[i]);
+						get_zone_node(i), &index->zone_queues[i]);
 		if (result != UDS_SUCCESS)
 			return result;
 	}
 
 	/* The triage queue is only needed for sparse multi-zone indexes. */
 	if ((index->zone_count > 1) && uds_is_sparse_index_geometry(geometry)) {
-		result = uds_make_request_queue("triageW", &triage_request,
+		result = uds_make_request_queue("triageW", &triage_request, NUMA_NO_NODE,
 						&index->triage_queue);
 		if (result != UDS_SUCCESS)
 			return result;
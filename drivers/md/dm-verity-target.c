@@ -134,6 +134,10 @@ static int verity_hash_update(struct dm_verity *v, struct ahash_request *req,
 
 /*
  * Wrapper for crypto_ahash_init, which handles verity salting.
+ *
+ * If the state after hashing the prepended salt could be exported at
+ * construction time, it is imported instead, so that every block does
+ * not have to start from scratch and rehash the salt.
  */
 static int verity_hash_init(struct dm_verity *v, struct ahash_request *req,
 				struct crypto_wait *wait, bool may_sleep)
@@ -146,6 +150,13 @@ static int verity_hash_init(struct dm_verity *v, struct ahash_request *req,
 		crypto_req_done, (void *)wait);
 	crypto_init_wait(wait);
 
+	if (likely(v->initial_hashstate)) {
+		r = crypto_ahash_import(req, v->initial_hashstate);
+		if (unlikely(r))
+			DMERR("crypto_ahash_import failed: %d", r);
+		return r;
+	}
+
 	r = crypto_wait_req(crypto_ahash_init(req), wait);
 
 	if (unlikely(r < 0)) {
@@ -1033,6 +1044,7 @@ static void verity_dtr(struct dm_target *ti)
 
 	kvfree(v->validated_blocks);
 	kfree(v->salt);
+	kfree(v->initial_hashstate);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
 
@@ -1111,6 +1123,45 @@ static int verity_alloc_zero_digest(struct dm_verity *v)
 	return r;
 }
 
+/*
+ * Precompute the hash state after the prepended salt.  This is purely an
+ * optimization: if the implementation can't export its state, every block
+ * is hashed starting from crypto_ahash_init as before.
+ */
+static int verity_alloc_initial_hashstate(struct dm_verity *v)
+{
+	struct ahash_request *req;
+	struct crypto_wait wait;
+	u8 *state;
+	int r;
+
+	if (!v->salt_size || !v->version)
+		return 0;
+
+	req = kmalloc(v->ahash_reqsize, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	state = kmalloc(crypto_ahash_statesize(v->tfm), GFP_KERNEL);
+	if (!state) {
+		r = -ENOMEM;
+		goto out;
+	}
+
+	if (!verity_hash_init(v, req, &wait, true) &&
+	    !crypto_ahash_export(req, state)) {
+		v->initial_hashstate = state;
+		state = NULL;
+	}
+	r = 0;
+
+	kfree(state);
+out:
+	kfree(req);
+
+	return r;
+}
+
 static inline bool verity_is_verity_mode(const char *arg_name)
 {
 	return (!strcasecmp(arg_name, DM_VERITY_OPT_LOGGING) ||
@@ -1413,6 +1464,12 @@ static int verity_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		}
 	}
 
+	r = verity_alloc_initial_hashstate(v);
+	if (r) {
+		ti->error = "Cannot allocate initial hash state";
+		goto bad;
+	}
+
 	argv += 10;
 	argc -= 10;
 
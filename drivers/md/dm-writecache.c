@@ -128,6 +128,7 @@ struct dm_writecache {
 	unsigned int uncommitted_blocks;
 	unsigned int autocommit_blocks;
 	unsigned int max_writeback_jobs;
+	unsigned int writeback_latency_target_us;
 
 	int error;
 
@@ -174,6 +175,7 @@ struct dm_writecache {
 	bool cleaner_set:1;
 	bool metadata_only:1;
 	bool pause_set:1;
+	bool writeback_latency_set:1;
 
 	unsigned int high_wm_percent_value;
 	unsigned int low_wm_percent_value;
@@ -182,6 +184,8 @@ struct dm_writecache {
 	unsigned int pause_value;
 
 	unsigned int writeback_all;
+	/* moving average of the origin write latency, in nanoseconds */
+	u64 writeback_latency_ns;
 	struct workqueue_struct *writeback_wq;
 	struct work_struct writeback_work;
 	struct work_struct flush_work;
@@ -225,6 +229,7 @@ struct writeback_struct {
 	struct dm_writecache *wc;
 	struct wc_entry **wc_list;
 	unsigned int wc_list_n;
+	u64 start_ns;
 	struct wc_entry *wc_list_inline[WB_LIST_INLINE];
 	struct bio bio;
 };
@@ -235,6 +240,7 @@ struct copy_struct {
 	struct wc_entry *e;
 	unsigned int n_entries;
 	int error;
+	u64 start_ns;
 };
 
 DECLARE_DM_KCOPYD_THROTTLE_WITH_MODULE_PARM(dm_writecache_throttle,
@@ -1679,6 +1685,18 @@ static void writecache_copy_endio(int read_err, unsigned long write_err, void *p
 	raw_spin_unlock_irq(&wc->endio_list_lock);
 }
 
+static void writecache_account_latency(struct dm_writecache *wc, u64 start_ns)
+{
+	u64 lat = ktime_get_ns() - start_ns;
+
+	if (!wc->writeback_latency_target_us)
+		return;
+
+	/* ewma with weight 1/8; updated with wc->lock held */
+	WRITE_ONCE(wc->writeback_latency_ns,
+		   (wc->writeback_latency_ns * 7 + lat) >> 3);
+}
+
 static void __writecache_endio_pmem(struct dm_writecache *wc, struct list_head *list)
 {
 	unsigned int i;
@@ -1693,6 +1711,7 @@ static void __writecache_endio_pmem(struct dm_writecache *wc, struct list_head *
 		if (unlikely(wb->bio.bi_status != BLK_STS_OK))
 			writecache_error(wc, blk_status_to_errno(wb->bio.bi_status),
 					"write error %d", wb->bio.bi_status);
+		writecache_account_latency(wc, wb->start_ns);
 		i = 0;
 		do {
 			e = wb->wc_list[i];
@@ -1729,6 +1748,7 @@ static void __writecache_endio_ssd(struct dm_writecache *wc, struct list_head *l
 
 		if (unlikely(c->error))
 			writecache_error(wc, c->error, "copy error");
+		writecache_account_latency(wc, c->start_ns);
 
 		e = c->e;
 		do {
@@ -1814,12 +1834,37 @@ struct writeback_list {
 	size_t size;
 };
 
+/*
+ * With writeback_latency set, scale the number of writeback jobs down while
+ * the origin is slower than the target, so that background writeback does
+ * not steal its bandwidth from the workload.  Writeback that is needed to
+ * refill the freelist is never slowed down.
+ */
+static size_t writeback_jobs_limit(struct dm_writecache *wc)
+{
+	size_t limit = wc->max_writeback_jobs;
+	u64 target, lat;
+
+	if (likely(!wc->writeback_latency_target_us) ||
+	    unlikely(wc->writeback_all) ||
+	    READ_ONCE(wc->freelist_size) + READ_ONCE(wc->writeback_size) <=
+	    wc->freelist_low_watermark)
+		return limit;
+
+	target = (u64)wc->writeback_latency_target_us * NSEC_PER_USEC;
+	lat = READ_ONCE(wc->writeback_latency_ns);
+	if (lat <= target)
+		return limit;
+
+	return max_t(size_t, div64_u64((u64)limit * target, lat), 1);
+}
+
 static void __writeback_throttle(struct dm_writecache *wc, struct writeback_list *wbl)
 {
 	if (unlikely(wc->max_writeback_jobs)) {
-		if (READ_ONCE(wc->writeback_size) - wbl->size >= wc->max_writeback_jobs) {
+		if (READ_ONCE(wc->writeback_size) - wbl->size >= writeback_jobs_limit(wc)) {
 			wc_lock(wc);
-			while (wc->writeback_size - wbl->size >= wc->max_writeback_jobs)
+			while (wc->writeback_size - wbl->size >= writeback_jobs_limit(wc))
 				writecache_wait_on_freelist(wc);
 			wc_unlock(wc);
 		}
@@ -1845,6 +1890,7 @@ static void __writecache_writeback_pmem(struct dm_writecache *wc, struct writeba
 				       GFP_NOIO, &wc->bio_set);
 		wb = container_of(bio, struct writeback_struct, bio);
 		wb->wc = wc;
+		wb->start_ns = ktime_get_ns();
 		bio->bi_end_io = writecache_writeback_endio;
 		bio->bi_iter.bi_sector = read_original_sector(wc, e);
 
@@ -1917,6 +1963,7 @@ static void __writecache_writeback_ssd(struct dm_writecache *wc, struct writebac
 		c->wc = wc;
 		c->e = e;
 		c->n_entries = e->wc_list_contiguous;
+		c->start_ns = ktime_get_ns();
 
 		while ((n_sectors -= wc->block_size >> SECTOR_SHIFT)) {
 			wbl->size--;
@@ -2241,7 +2288,7 @@ static int writecache_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	struct wc_memory_superblock s;
 
 	static struct dm_arg _args[] = {
-		{0, 18, "Invalid number of feature args"},
+		{0, 20, "Invalid number of feature args"},
 	};
 
 	as.argc = argc;
@@ -2490,6 +2537,16 @@ static int writecache_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 			wc->pause = msecs_to_jiffies(pause_msecs);
 			wc->pause_set = true;
 			wc->pause_value = pause_msecs;
+		} else if (!strcasecmp(string, "writeback_latency") && opt_params >= 1) {
+			unsigned int latency_usecs;
+
+			string = dm_shift_arg(&as), opt_params--;
+			if (sscanf(string, "%u%c", &latency_usecs, &dummy) != 1)
+				goto invalid_optional;
+			if (latency_usecs > 10000000)
+				goto invalid_optional;
+			wc->writeback_latency_target_us = latency_usecs;
+			wc->writeback_latency_set = true;
 		} else {
 invalid_optional:
 			r = -EINVAL;
@@ -2727,6 +2784,8 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 			extra_args++;
 		if (wc->pause_set)
 			extra_args += 2;
+		if (wc->writeback_latency_set)
+			extra_args += 2;
 
 		DMEMIT("%u", extra_args);
 		if (wc->start_sector_set)
@@ -2751,6 +2810,8 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 			DMEMIT(" metadata_only");
 		if (wc->pause_set)
 			DMEMIT(" pause_writeback %u", wc->pause_value);
+		if (wc->writeback_latency_set)
+			DMEMIT(" writeback_latency %u", wc->writeback_latency_target_us);
 		break;
 	case STATUSTYPE_IMA:
 		*result = '\0';
@@ -2760,7 +2821,7 @@ static void writecache_status(struct dm_target *ti, status_type_t type,
 
 static struct target_type writecache_target = {
 	.name			= "writecache",
-	.version		= {1, 6, 0},
+	.version		= {1, 7, 0},
 	.module			= THIS_MODULE,
 	.ctr			= writecache_ctr,
 	.dtr			= writecache_dtr,
@@ -916,6 +916,11 @@ static inline void set_page_attr(struct bitmap *bitmap, int pnum,
 				 enum bitmap_page_attr attr)
 {
 	set_bit((pnum<<2) + attr, bitmap->storage.filemap_attr);
+	if (attr == BITMAP_PAGE_DIRTY || attr == BITMAP_PAGE_NEEDWRITE) {
+		/* pairs with test_and_clear_bit() in md_bitmap_unplug() */
+		smp_mb__before_atomic();
+		set_bit(BITMAP_PAGES_DIRTY, &bitmap->flags);
+	}
 }
 
 static inline void clear_page_attr(struct bitmap *bitmap, int pnum,
@@ -1037,6 +1042,13 @@ void md_bitmap_unplug(struct bitmap *bitmap)
 	if (!md_bitmap_enabled(bitmap))
 		return;
 
+	/*
+	 * Writes to chunks which are dirty already don't set any page attr,
+	 * so don't walk all the pages for them.
+	 */
+	if (!test_and_clear_bit(BITMAP_PAGES_DIRTY, &bitmap->flags))
+		goto out;
+
 	/* look at each page to see if there are any set bits that need to be
 	 * flushed out to disk */
 	for (i = 0; i < bitmap->storage.file_pages; i++) {
@@ -1057,6 +1069,7 @@ void md_bitmap_unplug(struct bitmap *bitmap)
 	if (writing)
 		md_bitmap_wait_writes(bitmap);
 
+out:
 	if (test_bit(BITMAP_WRITE_ERROR, &bitmap->flags))
 		md_bitmap_file_kick(bitmap);
 }
@@ -1477,16 +1490,15 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 			 bw, bitmap->mddev->bitmap_info.max_write_behind);
 	}
 
+	/* take the lock once for all the chunks of the write */
+	spin_lock_irq(&bitmap->counts.lock);
 	while (sectors) {
 		sector_t blocks;
 		bitmap_counter_t *bmc;
 
-		spin_lock_irq(&bitmap->counts.lock);
 		bmc = md_bitmap_get_counter(&bitmap->counts, offset, &blocks, 1);
-		if (!bmc) {
-			spin_unlock_irq(&bitmap->counts.lock);
-			return 0;
-		}
+		if (!bmc)
+			break;
 
 		if (unlikely(COUNTER(*bmc) == COUNTER_MAX)) {
 			DEFINE_WAIT(__wait);
@@ -1499,6 +1511,7 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 			spin_unlock_irq(&bitmap->counts.lock);
 			schedule();
 			finish_wait(&bitmap->overflow_wait, &__wait);
+			spin_lock_irq(&bitmap->counts.lock);
 			continue;
 		}
 
@@ -1513,14 +1526,13 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 
 		(*bmc)++;
 
-		spin_unlock_irq(&bitmap->counts.lock);
-
 		offset += blocks;
 		if (sectors > blocks)
 			sectors -= blocks;
 		else
 			sectors = 0;
 	}
+	spin_unlock_irq(&bitmap->counts.lock);
 	return 0;
 }
 EXPORT_SYMBOL(md_bitmap_startwrite);
@@ -1528,6 +1540,8 @@ EXPORT_SYMBOL(md_bitmap_startwrite);
 void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			unsigned long sectors, int success, int behind)
 {
+	unsigned long flags;
+
 	if (!bitmap)
 		return;
 	if (behind) {
@@ -1538,17 +1552,14 @@ void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			 bitmap->mddev->bitmap_info.max_write_behind);
 	}
 
+	spin_lock_irqsave(&bitmap->counts.lock, flags);
 	while (sectors) {
 		sector_t blocks;
-		unsigned long flags;
 		bitmap_counter_t *bmc;
 
-		spin_lock_irqsave(&bitmap->counts.lock, flags);
 		bmc = md_bitmap_get_counter(&bitmap->counts, offset, &blocks, 0);
-		if (!bmc) {
-			spin_unlock_irqrestore(&bitmap->counts.lock, flags);
-			return;
-		}
+		if (!bmc)
+			break;
 
 		if (success && !bitmap->mddev->degraded &&
 		    bitmap->events_cleared < bitmap->mddev->events) {
@@ -1568,13 +1579,13 @@ void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			md_bitmap_set_pending(&bitmap->counts, offset);
 			bitmap->allclean = 0;
 		}
-		spin_unlock_irqrestore(&bitmap->counts.lock, flags);
 		offset += blocks;
 		if (sectors > blocks)
 			sectors -= blocks;
 		else
 			sectors = 0;
 	}
+	spin_unlock_irqrestore(&bitmap->counts.lock, flags);
 }
 EXPORT_SYMBOL(md_bitmap_endwrite);
 
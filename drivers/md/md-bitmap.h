@@ -116,6 +116,7 @@ typedef __u16 bitmap_counter_t;
 enum bitmap_state {
 	BITMAP_STALE	   = 1,  /* the bitmap file is out of date or had -EIO */
 	BITMAP_WRITE_ERROR = 2, /* A write error has occurred */
+	BITMAP_PAGES_DIRTY = 3, /* some page is DIRTY or NEEDWRITE */
 	BITMAP_HOSTENDIAN  =15,
 };
 
@@ -2132,6 +2132,55 @@ ops_run_reconstruct5(struct stripe_head *sh, struct raid5_percpu *percpu,
 	}
 }
 
+/* stripes per raid6_gen_syndrome_batch() call */
+#define R5_SYNDROME_BATCH	8
+
+/*
+ * Without async_tx offload all syndromes are computed on the CPU anyway, so
+ * for a batch of full stripe writes hand them to lib/raid6 several at a
+ * time rather than going through async_gen_syndrome() for each stripe.
+ */
+static void
+ops_run_reconstruct6_batch(struct stripe_head *head_sh,
+			   struct raid5_percpu *percpu,
+			   struct dma_async_tx_descriptor *tx)
+{
+	size_t len = RAID5_STRIPE_SIZE(head_sh->raid_conf);
+	void **ptrs[R5_SYNDROME_BATCH];
+	struct stripe_head *sh = head_sh;
+	unsigned int *offs = to_addr_offs(sh, percpu);
+	int count, i, j = 0, nr = 0;
+
+	/* the biodrain copies must be done */
+	async_tx_quiesce(&tx);
+
+	do {
+		struct page **blocks = to_addr_page(percpu, j);
+		void **srcs = (void **)to_addr_conv(sh, percpu, j);
+
+		count = set_syndrome_sources(blocks, offs, sh,
+					     SYNDROME_SRC_ALL);
+		for (i = 0; i < count + 2; i++)
+			srcs[i] = blocks[i] ?
+				page_address(blocks[i]) + offs[i] :
+				(void *)raid6_empty_zero_page;
+		ptrs[nr++] = srcs;
+		if (nr == R5_SYNDROME_BATCH) {
+			raid6_gen_syndrome_batch(count + 2, len, ptrs, nr);
+			nr = 0;
+		}
+		j++;
+		sh = list_first_entry(&sh->batch_list, struct stripe_head,
+				      batch_list);
+	} while (sh != head_sh);
+
+	if (nr)
+		raid6_gen_syndrome_batch(count + 2, len, ptrs, nr);
+
+	atomic_inc(&head_sh->count);
+	ops_complete_reconstruct(head_sh);
+}
+
 static void
 ops_run_reconstruct6(struct stripe_head *sh, struct raid5_percpu *percpu,
 		     struct dma_async_tx_descriptor *tx)
@@ -2161,6 +2210,12 @@ ops_run_reconstruct6(struct stripe_head *sh, struct raid5_percpu *percpu,
 		return;
 	}
 
+	if (!IS_ENABLED(CONFIG_ASYNC_TX_DMA) && sh->batch_head &&
+	    sh->reconstruct_state != reconstruct_state_prexor_drain_run) {
+		ops_run_reconstruct6_batch(sh, percpu, tx);
+		return;
+	}
+
 again:
 	blocks = to_addr_page(percpu, j);
 	offs = to_addr_offs(sh, percpu);
@@ -122,6 +122,7 @@ static struct bond_params bonding_defaults;
 static int resend_igmp = BOND_DEFAULT_RESEND_IGMP;
 static int packets_per_slave = 1;
 static int lp_interval = BOND_ALB_DEFAULT_LP_INTERVAL;
+static int tx_flow_table;
 
 module_param(max_bonds, int, 0);
 MODULE_PARM_DESC(max_bonds, "Max number of bonded devices");
@@ -202,6 +203,10 @@ module_param(lp_interval, uint, 0);
 MODULE_PARM_DESC(lp_interval, "The number of seconds between instances where "
 			      "the bonding driver sends learning packets to "
 			      "each slaves peer switch. The default is 1.");
+module_param(tx_flow_table, int, 0);
+MODULE_PARM_DESC(tx_flow_table, "Pin balance-xor and 802.3ad flows to the "
+				"least loaded slave instead of hashing every "
+				"packet; 0 for off (default), 1 for on");
 
 /*----------------------------- Global variables ----------------------------*/
 
@@ -263,6 +268,8 @@ static void bond_uninit(struct net_device *bond_dev);
 static void bond_get_stats(struct net_device *bond_dev,
 			   struct rtnl_link_stats64 *stats);
 static void bond_slave_arr_handler(struct work_struct *work);
+static void bond_flow_rebalance(struct work_struct *work);
+static bool bond_mode_uses_flow_table(const struct bonding *bond);
 static bool bond_time_in_interval(struct bonding *bond, unsigned long last_act,
 				  int mod);
 static void bond_netdev_notify_work(struct work_struct *work);
@@ -4251,6 +4258,7 @@ void bond_work_init_all(struct bonding *bond)
 	INIT_DELAYED_WORK(&bond->arp_work, bond_arp_monitor);
 	INIT_DELAYED_WORK(&bond->ad_work, bond_3ad_state_machine_handler);
 	INIT_DELAYED_WORK(&bond->slave_arr_work, bond_slave_arr_handler);
+	INIT_DELAYED_WORK(&bond->flow_work, bond_flow_rebalance);
 }
 
 static void bond_work_cancel_all(struct bonding *bond)
@@ -4261,6 +4269,7 @@ static void bond_work_cancel_all(struct bonding *bond)
 	cancel_delayed_work_sync(&bond->ad_work);
 	cancel_delayed_work_sync(&bond->mcast_work);
 	cancel_delayed_work_sync(&bond->slave_arr_work);
+	cancel_delayed_work_sync(&bond->flow_work);
 }
 
 static int bond_open(struct net_device *bond_dev)
@@ -4275,6 +4284,12 @@ static int bond_open(struct net_device *bond_dev)
 			return -ENOMEM;
 	}
 
+	if (bond_mode_uses_flow_table(bond) && !bond->flow_tbl) {
+		bond->flow_tbl = kvzalloc(sizeof(*bond->flow_tbl), GFP_KERNEL);
+		if (!bond->flow_tbl)
+			return -ENOMEM;
+	}
+
 	/* reset slave->backup and slave->inactive */
 	if (bond_has_slaves(bond)) {
 		bond_for_each_slave(bond, slave, iter) {
@@ -4302,6 +4317,10 @@ static int bond_open(struct net_device *bond_dev)
 	if (bond->params.miimon)  /* link check interval, in milliseconds. */
 		queue_delayed_work(bond->wq, &bond->mii_work, 0);
 
+	if (bond_mode_uses_flow_table(bond))
+		queue_delayed_work(bond->wq, &bond->flow_work,
+				   BOND_FLOW_REBALANCE_INTERVAL);
+
 	if (bond->params.arp_interval) {  /* arp interval, in milliseconds. */
 		queue_delayed_work(bond->wq, &bond->arp_work, 0);
 		bond->recv_probe = bond_rcv_validate;
@@ -5137,6 +5156,122 @@ int bond_update_slave_arr(struct bonding *bond, struct slave *skipslave)
 	return ret;
 }
 
+static bool bond_mode_uses_flow_table(const struct bonding *bond)
+{
+	return tx_flow_table && (BOND_MODE(bond) == BOND_MODE_8023AD ||
+				 BOND_MODE(bond) == BOND_MODE_XOR);
+}
+
+/* Pick the slave for a flow from the flow table.  A flow stays on its
+ * slave as long as that slave is usable and the flow is not idle for
+ * BOND_FLOW_IDLE, so that link changes only move the flows of the links
+ * which went away.  New, idle and orphaned flows go to the least loaded
+ * slave; the idle gap keeps moving a flow from reordering its packets.
+ */
+static struct slave *bond_flow_slave_get(struct bonding *bond, u32 hash,
+					 unsigned int len,
+					 struct bond_up_slave *slaves,
+					 unsigned int count)
+{
+	struct bond_flow_table *tbl = bond->flow_tbl;
+	struct bond_flow *flow = &tbl->flows[hash & (BOND_FLOW_TABLE_SIZE - 1)];
+	unsigned long now = jiffies;
+	struct slave *slave;
+	unsigned int i, idx;
+	u64 load, min_load;
+	bool idle;
+
+	idle = time_after(now, READ_ONCE(flow->last_used) + BOND_FLOW_IDLE);
+	if (READ_ONCE(flow->hash) != hash) {
+		/* the slot is taken by another active flow */
+		if (!idle)
+			return slaves->arr[hash % count];
+	} else if (!idle) {
+		slave = READ_ONCE(flow->slave);
+		idx = READ_ONCE(flow->slave_idx);
+		if (idx < count && slaves->arr[idx] == slave)
+			goto out;
+		for (i = 0; i < count; i++) {
+			if (slaves->arr[i] == slave) {
+				WRITE_ONCE(flow->slave_idx, i);
+				goto out;
+			}
+		}
+	}
+
+	idx = 0;
+	min_load = U64_MAX;
+	for (i = 0; i < count; i++) {
+		load = READ_ONCE(slaves->arr[i]->tx_flow_load);
+		if (load < min_load) {
+			min_load = load;
+			idx = i;
+		}
+	}
+	slave = slaves->arr[idx];
+	/* account for the new flow until the next rebalance measures it */
+	WRITE_ONCE(slave->tx_flow_load,
+		   min_load + READ_ONCE(tbl->avg_flow_load));
+
+	WRITE_ONCE(flow->hash, hash);
+	WRITE_ONCE(flow->slave, slave);
+	WRITE_ONCE(flow->slave_idx, idx);
+	WRITE_ONCE(flow->bytes, 0);
+out:
+	if (READ_ONCE(flow->last_used) != now)
+		WRITE_ONCE(flow->last_used, now);
+	WRITE_ONCE(flow->bytes, READ_ONCE(flow->bytes) + len);
+	return slave;
+}
+
+/* Periodically measure the load of each slave from the flows pinned to
+ * it.  Placement of new and idle flows in bond_flow_slave_get() uses
+ * these to even out the slaves.
+ */
+static void bond_flow_rebalance(struct work_struct *work)
+{
+	struct bonding *bond = container_of(work, struct bonding,
+					    flow_work.work);
+	struct bond_flow_table *tbl = bond->flow_tbl;
+	struct bond_up_slave *slaves;
+	u64 bytes, load, total = 0;
+	unsigned int i, j, count;
+	unsigned int nr_flows = 0;
+	unsigned long now;
+
+	rcu_read_lock();
+	slaves = rcu_dereference(bond->usable_slaves);
+	count = slaves ? READ_ONCE(slaves->count) : 0;
+	now = jiffies;
+	for (i = 0; i < count; i++) {
+		struct slave *slave = slaves->arr[i];
+
+		load = 0;
+		for (j = 0; j < BOND_FLOW_TABLE_SIZE; j++) {
+			struct bond_flow *flow = &tbl->flows[j];
+
+			if (READ_ONCE(flow->slave) != slave)
+				continue;
+			bytes = READ_ONCE(flow->bytes);
+			WRITE_ONCE(flow->bytes, 0);
+			load += bytes;
+			if (time_before_eq(now, READ_ONCE(flow->last_used) +
+						BOND_FLOW_REBALANCE_INTERVAL))
+				nr_flows++;
+		}
+		/* smooth over two intervals */
+		load = (READ_ONCE(slave->tx_flow_load) + load) / 2;
+		WRITE_ONCE(slave->tx_flow_load, load);
+		total += load;
+	}
+	rcu_read_unlock();
+
+	WRITE_ONCE(tbl->avg_flow_load, nr_flows ? div_u64(total, nr_flows) : 0);
+
+	queue_delayed_work(bond->wq, &bond->flow_work,
+			   BOND_FLOW_REBALANCE_INTERVAL);
+}
+
 static struct slave *bond_xmit_3ad_xor_slave_get(struct bonding *bond,
 						 struct sk_buff *skb,
 						 struct bond_up_slave *slaves)
@@ -5150,6 +5285,9 @@ static struct slave *bond_xmit_3ad_xor_slave_get(struct bonding *bond,
 	if (unlikely(!count))
 		return NULL;
 
+	if (bond->flow_tbl && bond_mode_uses_flow_table(bond))
+		return bond_flow_slave_get(bond, hash, skb->len, slaves, count);
+
 	slave = slaves->arr[hash % count];
 	return slave;
 }
@@ -5853,6 +5991,7 @@ static void bond_destructor(struct net_device *bond_dev)
 		destroy_workqueue(bond->wq);
 
 	free_percpu(bond->rr_tx_counter);
+	kvfree(bond->flow_tbl);
 }
 
 void bond_setup(struct net_device *bond_dev)
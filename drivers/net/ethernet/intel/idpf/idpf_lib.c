@@ -905,8 +905,9 @@ static void idpf_vport_stop(struct idpf_vport *vport)
 
 	vport->link_up = false;
 	idpf_vport_intr_deinit(vport);
-	idpf_vport_intr_rel(vport);
+	/* the Rx page pools reference the NAPI instances in the q_vectors */
 	idpf_vport_queues_rel(vport);
+	idpf_vport_intr_rel(vport);
 	np->state = __IDPF_VPORT_DOWN;
 }
 
@@ -1458,7 +1459,11 @@ static int idpf_vport_open(struct idpf_vport *vport, bool alloc_res)
 intr_deinit:
 	idpf_vport_intr_deinit(vport);
 intr_rel:
+	idpf_vport_queues_rel(vport);
 	idpf_vport_intr_rel(vport);
+
+	return err;
+
 queues_rel:
 	idpf_vport_queues_rel(vport);
 
@@ -581,6 +581,11 @@ static bool idpf_rx_post_init_bufs(struct idpf_queue *bufq, u16 working_set)
  * idpf_rx_create_page_pool - Create a page pool
  * @rxbufq: RX queue to create page pool for
  *
+ * The pool is tied to the NAPI instance refilling the queue, so that pages
+ * freed from that NAPI context are recycled straight into the pool's
+ * lockless cache. The pool must hence be destroyed before the q_vectors are
+ * freed, see idpf_vport_stop().
+ *
  * Returns &page_pool on success, casted -errno on failure
  */
 static struct page_pool *idpf_rx_create_page_pool(struct idpf_queue *rxbufq)
@@ -591,6 +596,8 @@ static struct page_pool *idpf_rx_create_page_pool(struct idpf_queue *rxbufq)
 		.pool_size	= rxbufq->desc_count,
 		.nid		= NUMA_NO_NODE,
 		.dev		= rxbufq->vport->netdev->dev.parent,
+		.napi		= &rxbufq->q_vector->napi,
+		.netdev		= rxbufq->vport->netdev,
 		.max_len	= PAGE_SIZE,
 		.dma_dir	= DMA_FROM_DEVICE,
 		.offset		= 0,
@@ -3449,8 +3456,10 @@ void idpf_vport_intr_rel(struct idpf_vport *vport)
 		q_vector->rx = NULL;
 	}
 
-	/* Clean up the mapping of queues to vectors */
-	for (i = 0; i < vport->num_rxq_grp; i++) {
+	/* Clean up the mapping of queues to vectors, unless the queues are
+	 * already gone.
+	 */
+	for (i = 0; vport->rxq_grps && i < vport->num_rxq_grp; i++) {
 		struct idpf_rxq_group *rx_qgrp = &vport->rxq_grps[i];
 
 		if (idpf_is_queue_model_split(vport->rxq_model))
@@ -3461,13 +3470,17 @@ void idpf_vport_intr_rel(struct idpf_vport *vport)
 				rx_qgrp->singleq.rxqs[j]->q_vector = NULL;
 	}
 
-	if (idpf_is_queue_model_split(vport->txq_model))
-		for (i = 0; i < vport->num_txq_grp; i++)
-			vport->txq_grps[i].complq->q_vector = NULL;
-	else
-		for (i = 0; i < vport->num_txq_grp; i++)
-			for (j = 0; j < vport->txq_grps[i].num_txq; j++)
-				vport->txq_grps[i].txqs[j]->q_vector = NULL;
+	for (i = 0; vport->txq_grps && i < vport->num_txq_grp; i++) {
+		struct idpf_txq_group *tx_qgrp = &vport->txq_grps[i];
+
+		if (idpf_is_queue_model_split(vport->txq_model)) {
+			tx_qgrp->complq->q_vector = NULL;
+			continue;
+		}
+
+		for (j = 0; j < tx_qgrp->num_txq; j++)
+			tx_qgrp->txqs[j]->q_vector = NULL;
+	}
 
 	kfree(vport->q_vectors);
 	vport->q_vectors = NULL;
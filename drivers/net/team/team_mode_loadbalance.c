@@ -34,6 +34,10 @@ typedef struct team_port *lb_select_tx_port_func_t(struct team *,
 
 #define LB_TX_HASHTABLE_SIZE 256 /* hash is a char */
 
+/* in-kernel rebalancing of the hash to port mapping, see lb_tx_rebalance() */
+#define LB_TX_REBALANCE_MAX_MOVES 16 /* per refresh interval */
+#define LB_TX_REBALANCE_TOLERANCE 10 /* in percent of the busiest port */
+
 struct lb_stats {
 	u64 tx_bytes;
 };
@@ -58,6 +62,7 @@ struct lb_priv_ex {
 	struct team *team;
 	struct lb_port_mapping tx_hash_to_port_mapping[LB_TX_HASHTABLE_SIZE];
 	struct sock_fprog_kern *orig_fprog;
+	bool tx_rebalance;
 	struct {
 		unsigned int refresh_interval; /* in tenths of second */
 		struct delayed_work refresh_dw;
@@ -80,6 +85,7 @@ static struct lb_priv *get_lb_priv(struct team *team)
 struct lb_port_priv {
 	struct lb_stats __percpu *pcpu_stats;
 	struct lb_stats_info stats_info;
+	u64 rebalance_load; /* only used by lb_tx_rebalance() */
 };
 
 static struct lb_port_priv *get_lb_port_priv(struct team_port *port)
@@ -459,6 +465,106 @@ static void __lb_one_cpu_stats_add(struct lb_stats *acc_stats,
 	acc_stats->tx_bytes += tmp.tx_bytes;
 }
 
+static u64 lb_hash_interval_bytes(struct lb_priv *lb_priv, unsigned char hash)
+{
+	struct lb_stats_info *s_info = &lb_priv->ex->stats.info[hash];
+
+	return s_info->stats.tx_bytes - s_info->last_stats.tx_bytes;
+}
+
+static struct team_port *lb_htpm_port_locked(struct team *team,
+					     unsigned char hash)
+{
+	struct lb_priv *lb_priv = get_lb_priv(team);
+	struct team_port *port;
+
+	port = rcu_dereference_protected(LB_HTPM_PORT_BY_HASH(lb_priv, hash),
+					 lockdep_is_held(&team->lock));
+	if (port)
+		return port;
+	return team_get_port_by_index(team, team_num_to_port_index(team, hash));
+}
+
+/* Move hashes from the busiest to the least busy port, based on the bytes
+ * each hash transmitted during the last refresh interval.  Each move picks
+ * the hash whose load is closest to half of the gap between the two ports,
+ * and the number of moves is bounded so that only a few flows get
+ * reordered per interval.  Returns true if the mapping was changed.
+ */
+static bool lb_tx_rebalance(struct team *team)
+{
+	struct lb_priv *lb_priv = get_lb_priv(team);
+	struct team_port *port, *max_port, *min_port;
+	lb_select_tx_port_func_t *func;
+	struct lb_port_mapping *pm;
+	u64 bytes, gap, max_load, best_bytes;
+	bool changed = false;
+	int moves, best, i;
+
+	func = rcu_dereference_protected(lb_priv->select_tx_port_func,
+					 lockdep_is_held(&team->lock));
+	if (func != lb_htpm_select_tx_port || team->en_port_count < 2)
+		return false;
+
+	list_for_each_entry(port, &team->port_list, list)
+		get_lb_port_priv(port)->rebalance_load = 0;
+	for (i = 0; i < LB_TX_HASHTABLE_SIZE; i++) {
+		port = lb_htpm_port_locked(team, i);
+		if (port)
+			get_lb_port_priv(port)->rebalance_load +=
+				lb_hash_interval_bytes(lb_priv, i);
+	}
+
+	for (moves = 0; moves < LB_TX_REBALANCE_MAX_MOVES; moves++) {
+		max_port = NULL;
+		min_port = NULL;
+		list_for_each_entry(port, &team->port_list, list) {
+			u64 load = get_lb_port_priv(port)->rebalance_load;
+
+			if (!team_port_enabled(port))
+				continue;
+			if (!max_port ||
+			    load > get_lb_port_priv(max_port)->rebalance_load)
+				max_port = port;
+			if (!min_port ||
+			    load < get_lb_port_priv(min_port)->rebalance_load)
+				min_port = port;
+		}
+		if (!max_port || max_port == min_port)
+			break;
+		max_load = get_lb_port_priv(max_port)->rebalance_load;
+		gap = max_load - get_lb_port_priv(min_port)->rebalance_load;
+		if (!gap || gap * 100 <= max_load * LB_TX_REBALANCE_TOLERANCE)
+			break;
+
+		best = -1;
+		best_bytes = 0;
+		for (i = 0; i < LB_TX_HASHTABLE_SIZE; i++) {
+			if (lb_htpm_port_locked(team, i) != max_port)
+				continue;
+			bytes = lb_hash_interval_bytes(lb_priv, i);
+			/* moving it must shrink the gap */
+			if (!bytes || bytes >= gap)
+				continue;
+			if (best < 0 || abs_diff(2 * bytes, gap) <
+					abs_diff(2 * best_bytes, gap)) {
+				best = i;
+				best_bytes = bytes;
+			}
+		}
+		if (best < 0)
+			break;
+
+		pm = &lb_priv->ex->tx_hash_to_port_mapping[best];
+		rcu_assign_pointer(pm->port, min_port);
+		team_option_inst_set_change(pm->opt_inst_info);
+		get_lb_port_priv(max_port)->rebalance_load -= best_bytes;
+		get_lb_port_priv(min_port)->rebalance_load += best_bytes;
+		changed = true;
+	}
+	return changed;
+}
+
 static void lb_stats_refresh(struct work_struct *work)
 {
 	struct team *team;
@@ -509,6 +615,9 @@ static void lb_stats_refresh(struct work_struct *work)
 		changed |= __lb_stats_info_refresh_check(s_info, team);
 	}
 
+	if (lb_priv_ex->tx_rebalance)
+		changed |= lb_tx_rebalance(team);
+
 	if (changed)
 		team_options_change_check(team);
 
@@ -543,6 +652,23 @@ static int lb_stats_refresh_interval_set(struct team *team,
 	return 0;
 }
 
+static void lb_tx_rebalance_get(struct team *team,
+				struct team_gsetter_ctx *ctx)
+{
+	struct lb_priv *lb_priv = get_lb_priv(team);
+
+	ctx->data.bool_val = lb_priv->ex->tx_rebalance;
+}
+
+static int lb_tx_rebalance_set(struct team *team,
+			       struct team_gsetter_ctx *ctx)
+{
+	struct lb_priv *lb_priv = get_lb_priv(team);
+
+	lb_priv->ex->tx_rebalance = ctx->data.bool_val;
+	return 0;
+}
+
 static const struct team_option lb_options[] = {
 	{
 		.name = "bpf_hash_func",
@@ -584,6 +710,12 @@ static const struct team_option lb_options[] = {
 		.getter = lb_stats_refresh_interval_get,
 		.setter = lb_stats_refresh_interval_set,
 	},
+	{
+		.name = "lb_tx_auto_rebalance",
+		.type = TEAM_OPTION_TYPE_BOOL,
+		.getter = lb_tx_rebalance_get,
+		.setter = lb_tx_rebalance_set,
+	},
 };
 
 static int lb_init(struct team *team)
@@ -3,6 +3,9 @@
  * Copyright (c) 2017-2018 Christoph Hellwig.
  */
 
+/* weight of a new sample in the per-path latency EWMA, as a shift */
+#define NVME_MPATH_LAT_EWMA_SHIFT	3
+
 #include <linux/backing-dev.h>
 #include <linux/moduleparam.h>
 #include <linux/vmalloc.h>
@@ -17,6 +20,7 @@ MODULE_PARM_DESC(multipath,
 static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
+	[NVME_IOPOLICY_LAT]	= "latency",
 };
 
 static int iopolicy = NVME_IOPOLICY_NUMA;
@@ -29,6 +33,8 @@ static int nvme_set_iopolicy(const char *val, const struct kernel_param *kp)
 		iopolicy = NVME_IOPOLICY_NUMA;
 	else if (!strncmp(val, "round-robin", 11))
 		iopolicy = NVME_IOPOLICY_RR;
+	else if (!strncmp(val, "latency", 7))
+		iopolicy = NVME_IOPOLICY_LAT;
 	else
 		return -EINVAL;
 
@@ -43,7 +49,7 @@ static int nvme_get_iopolicy(char *buf, const struct kernel_param *kp)
 module_param_call(iopolicy, nvme_set_iopolicy, nvme_get_iopolicy,
 	&iopolicy, 0644);
 MODULE_PARM_DESC(iopolicy,
-	"Default multipath I/O policy; 'numa' (default) or 'round-robin'");
+	"Default multipath I/O policy; 'numa' (default), 'round-robin' or 'latency'");
 
 void nvme_mpath_default_iopolicy(struct nvme_subsystem *subsys)
 {
@@ -128,6 +134,13 @@ void nvme_mpath_start_request(struct request *rq)
 	struct nvme_ns *ns = rq->q->queuedata;
 	struct gendisk *disk = ns->head->disk;
 
+	if (READ_ONCE(ns->head->subsys->iopolicy) == NVME_IOPOLICY_LAT &&
+	    !(nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE)) {
+		atomic_inc(&ns->nr_active);
+		nvme_req(rq)->flags |= NVME_MPATH_CNT_ACTIVE;
+		nvme_req(rq)->lat_start_ns = ktime_get_ns();
+	}
+
 	if (!blk_queue_io_stat(disk->queue) || blk_rq_is_passthrough(rq))
 		return;
 
@@ -141,6 +154,19 @@ void nvme_mpath_end_request(struct request *rq)
 {
 	struct nvme_ns *ns = rq->q->queuedata;
 
+	if (nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE) {
+		u64 lat = ktime_get_ns() - nvme_req(rq)->lat_start_ns;
+		u64 ewma = READ_ONCE(ns->lat_ewma_ns);
+
+		/* racy updates only lose a sample, which is fine for a hint */
+		if (ewma)
+			ewma += (s64)(lat - ewma) >> NVME_MPATH_LAT_EWMA_SHIFT;
+		else
+			ewma = lat;
+		WRITE_ONCE(ns->lat_ewma_ns, ewma);
+		atomic_dec(&ns->nr_active);
+	}
+
 	if (!(nvme_req(rq)->flags & NVME_MPATH_IO_STATS))
 		return;
 	bdev_end_io_acct(ns->head->disk->part0, req_op(rq),
@@ -334,6 +360,45 @@ static struct nvme_ns *nvme_round_robin_path(struct nvme_ns_head *head,
 	return found;
 }
 
+/*
+ * Pick the usable path with the lowest expected wait, estimated as its
+ * latency EWMA scaled by the requests already in flight on it.  Optimized
+ * paths are always preferred over non-optimized ones.  Paths without a
+ * latency sample yet score lowest so that they are probed.
+ */
+static struct nvme_ns *nvme_latency_path(struct nvme_ns_head *head)
+{
+	u64 min_opt = U64_MAX, min_nonopt = U64_MAX, score;
+	struct nvme_ns *best_opt = NULL, *best_nonopt = NULL, *ns;
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		score = (READ_ONCE(ns->lat_ewma_ns) + 1) *
+			(atomic_read(&ns->nr_active) + 1);
+
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (score < min_opt) {
+				min_opt = score;
+				best_opt = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (score < min_nonopt) {
+				min_nonopt = score;
+				best_nonopt = ns;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return best_opt ? best_opt : best_nonopt;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return nvme_ctrl_state(ns->ctrl) == NVME_CTRL_LIVE &&
@@ -345,6 +410,9 @@ inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 	int node = numa_node_id();
 	struct nvme_ns *ns;
 
+	if (READ_ONCE(head->subsys->iopolicy) == NVME_IOPOLICY_LAT)
+		return nvme_latency_path(head);
+
 	ns = srcu_dereference(head->current_path[node], &head->srcu);
 	if (unlikely(!ns))
 		return __nvme_find_path(head, node);
@@ -21,6 +21,7 @@
 #include <linux/mutex.h>
 #include <linux/once.h>
 #include <linux/pci.h>
+#include <linux/sched/clock.h>
 #include <linux/suspend.h>
 #include <linux/t10-pi.h>
 #include <linux/types.h>
@@ -101,6 +102,12 @@ static unsigned int poll_queues;
 module_param_cb(poll_queues, &io_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
+static unsigned int poll_db_hold_ns;
+module_param(poll_db_hold_ns, uint, 0644);
+MODULE_PARM_DESC(poll_db_hold_ns,
+	"Hold SQ doorbell writes on poll queues for up to this many ns so that "
+	"concurrent submitters share one doorbell. 0 disables holding.");
+
 static bool noacpi;
 module_param(noacpi, bool, 0444);
 MODULE_PARM_DESC(noacpi, "disable acpi bios quirks");
@@ -213,6 +220,12 @@ struct nvme_queue {
 	__le32 *dbbuf_cq_db;
 	__le32 *dbbuf_sq_ei;
 	__le32 *dbbuf_cq_ei;
+	/* poll queues only: when the oldest unannounced SQ entry was queued */
+	u64 sq_db_hold_start;
+	/* protected by sq_lock, read locklessly for sysfs */
+	u64 sq_entries;
+	u64 sq_doorbells;
+	u64 sq_db_mmio;
 	struct completion delete_done;
 };
 
@@ -480,9 +493,39 @@ static inline void nvme_write_sq_db(struct nvme_queue *nvmeq, bool write_sq)
 	}
 
 	if (nvme_dbbuf_update_and_check_event(nvmeq->sq_tail,
-			nvmeq->dbbuf_sq_db, nvmeq->dbbuf_sq_ei))
+			nvmeq->dbbuf_sq_db, nvmeq->dbbuf_sq_ei)) {
 		writel(nvmeq->sq_tail, nvmeq->q_db);
+		nvmeq->sq_db_mmio++;
+	}
 	nvmeq->last_sq_tail = nvmeq->sq_tail;
+	nvmeq->sq_doorbells++;
+}
+
+/*
+ * On poll queues the submitter is going to call nvme_poll() for its request
+ * anyway, so the doorbell for the last entry of a submission can be held
+ * back for a short window and shared with other submitters on the same
+ * queue.  nvme_poll() writes out anything still held.  Must be called with
+ * sq_lock held after the command has been copied.
+ */
+static inline bool nvme_hold_sq_db(struct nvme_queue *nvmeq)
+{
+	unsigned int hold = READ_ONCE(poll_db_hold_ns);
+	u16 first = nvmeq->last_sq_tail + 1;
+	u64 now;
+
+	if (!hold || !test_bit(NVMEQ_POLLED, &nvmeq->flags))
+		return false;
+
+	now = local_clock();
+	if (first == nvmeq->q_depth)
+		first = 0;
+	if (nvmeq->sq_tail == first) {
+		/* this is the only unannounced entry, start a new window */
+		nvmeq->sq_db_hold_start = now;
+		return true;
+	}
+	return now - nvmeq->sq_db_hold_start < hold;
 }
 
 static inline void nvme_sq_copy_cmd(struct nvme_queue *nvmeq,
@@ -492,6 +535,7 @@ static inline void nvme_sq_copy_cmd(struct nvme_queue *nvmeq,
 		absolute_pointer(cmd), sizeof(*cmd));
 	if (++nvmeq->sq_tail == nvmeq->q_depth)
 		nvmeq->sq_tail = 0;
+	nvmeq->sq_entries++;
 }
 
 static void nvme_commit_rqs(struct blk_mq_hw_ctx *hctx)
@@ -896,7 +940,7 @@ static blk_status_t nvme_queue_rq(struct blk_mq_hw_ctx *hctx,
 		return ret;
 	spin_lock(&nvmeq->sq_lock);
 	nvme_sq_copy_cmd(nvmeq, &iod->cmd);
-	nvme_write_sq_db(nvmeq, bd->last);
+	nvme_write_sq_db(nvmeq, bd->last && !nvme_hold_sq_db(nvmeq));
 	spin_unlock(&nvmeq->sq_lock);
 	return BLK_STS_OK;
 }
@@ -910,7 +954,7 @@ static void nvme_submit_cmds(struct nvme_queue *nvmeq, struct request **rqlist)
 
 		nvme_sq_copy_cmd(nvmeq, &iod->cmd);
 	}
-	nvme_write_sq_db(nvmeq, true);
+	nvme_write_sq_db(nvmeq, !nvme_hold_sq_db(nvmeq));
 	spin_unlock(&nvmeq->sq_lock);
 }
 
@@ -1118,6 +1162,11 @@ static int nvme_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
 	struct nvme_queue *nvmeq = hctx->driver_data;
 	bool found;
 
+	/* announce SQ entries held back by nvme_hold_sq_db() */
+	if (READ_ONCE(poll_db_hold_ns) &&
+	    READ_ONCE(nvmeq->sq_tail) != READ_ONCE(nvmeq->last_sq_tail))
+		nvme_commit_rqs(hctx);
+
 	if (!nvme_cqe_pending(nvmeq))
 		return 0;
 
@@ -1580,6 +1629,9 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 
 	nvmeq->sq_tail = 0;
 	nvmeq->last_sq_tail = 0;
+	nvmeq->sq_entries = 0;
+	nvmeq->sq_doorbells = 0;
+	nvmeq->sq_db_mmio = 0;
 	nvmeq->cq_head = 0;
 	nvmeq->cq_phase = 1;
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
@@ -2135,6 +2187,25 @@ static ssize_t hmb_store(struct device *dev, struct device_attribute *attr,
 }
 static DEVICE_ATTR_RW(hmb);
 
+static ssize_t sq_db_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct nvme_dev *ndev = to_nvme_dev(dev_get_drvdata(dev));
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 1; i < ndev->online_queues; i++) {
+		struct nvme_queue *nvmeq = &ndev->queues[i];
+
+		len += sysfs_emit_at(buf, len, "%u %llu %llu %llu\n", nvmeq->qid,
+				     READ_ONCE(nvmeq->sq_entries),
+				     READ_ONCE(nvmeq->sq_doorbells),
+				     READ_ONCE(nvmeq->sq_db_mmio));
+	}
+	return len;
+}
+static DEVICE_ATTR_RO(sq_db_stats);
+
 static umode_t nvme_pci_attrs_are_visible(struct kobject *kobj,
 		struct attribute *a, int n)
 {
@@ -2159,6 +2230,7 @@ static struct attribute *nvme_pci_attrs[] = {
 	&dev_attr_cmbloc.attr,
 	&dev_attr_cmbsz.attr,
 	&dev_attr_hmb.attr,
+	&dev_attr_sq_db_stats.attr,
 	NULL,
 };
 
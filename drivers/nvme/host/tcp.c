@@ -92,6 +92,9 @@ static void nvme_tcp_reclassify_socket(struct socket *sock)
 static void nvme_tcp_reclassify_socket(struct socket *sock) { }
 #endif
 
+/* max command capsules gathered into one sendmsg */
+#define NVME_TCP_CMD_BATCH	16
+
 enum nvme_tcp_send_state {
 	NVME_TCP_SEND_CMD_PDU = 0,
 	NVME_TCP_SEND_H2C_PDU,
@@ -1132,6 +1135,74 @@ static int nvme_tcp_try_send_cmd_pdu(struct nvme_tcp_request *req)
 	return -EAGAIN;
 }
 
+static inline bool nvme_tcp_cmd_batchable(struct nvme_tcp_request *req)
+{
+	return req->state == NVME_TCP_SEND_CMD_PDU && !req->offset &&
+		!nvme_tcp_has_inline_data(req);
+}
+
+/*
+ * Send the command capsule of queue->request together with those of the
+ * requests queued right behind it in a single sendmsg, as long as none of
+ * them carries inline data.  This saves a socket lock round trip per
+ * command for small I/O.  On a short send the partially sent request
+ * becomes queue->request and the rest goes back to the send_list in order.
+ */
+static int nvme_tcp_try_send_cmd_batch(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_request *batch[NVME_TCP_CMD_BATCH], *req;
+	struct bio_vec bvec[NVME_TCP_CMD_BATCH];
+	struct msghdr msg = { .msg_flags = MSG_DONTWAIT | MSG_SPLICE_PAGES, };
+	int len = sizeof(struct nvme_tcp_cmd_pdu) + nvme_tcp_hdgst_len(queue);
+	int nr = 0, sent, ret, i;
+
+	batch[nr++] = queue->request;
+	if (list_empty(&queue->send_list))
+		nvme_tcp_process_req_list(queue);
+	while (nr < NVME_TCP_CMD_BATCH) {
+		req = list_first_entry_or_null(&queue->send_list,
+				struct nvme_tcp_request, entry);
+		if (!req || !nvme_tcp_cmd_batchable(req))
+			break;
+		list_del(&req->entry);
+		batch[nr++] = req;
+	}
+	if (nr == 1)
+		return nvme_tcp_try_send_cmd_pdu(queue->request);
+
+	for (i = 0; i < nr; i++) {
+		struct nvme_tcp_cmd_pdu *pdu = nvme_tcp_req_cmd_pdu(batch[i]);
+
+		if (queue->hdr_digest)
+			nvme_tcp_hdgst(queue->snd_hash, pdu, sizeof(*pdu));
+		bvec_set_virt(&bvec[i], pdu, len);
+	}
+
+	if (nvme_tcp_queue_more(queue))
+		msg.msg_flags |= MSG_MORE;
+	else
+		msg.msg_flags |= MSG_EOR;
+
+	iov_iter_bvec(&msg.msg_iter, ITER_SOURCE, bvec, nr, nr * len);
+	ret = sock_sendmsg(queue->sock, &msg);
+	sent = max(ret, 0);
+
+	/* give back everything after the first request not fully sent */
+	for (i = nr - 1; i > sent / len; i--)
+		list_add(&batch[i]->entry, &queue->send_list);
+	if (ret <= 0)
+		return ret;
+
+	if (sent == nr * len) {
+		nvme_tcp_done_send_req(queue);
+		return 1;
+	}
+	queue->request = batch[sent / len];
+	queue->request->offset = sent % len;
+
+	return -EAGAIN;
+}
+
 static int nvme_tcp_try_send_data_pdu(struct nvme_tcp_request *req)
 {
 	struct nvme_tcp_queue *queue = req->queue;
@@ -1214,7 +1285,11 @@ static int nvme_tcp_try_send(struct nvme_tcp_queue *queue)
 
 	noreclaim_flag = memalloc_noreclaim_save();
 	if (req->state == NVME_TCP_SEND_CMD_PDU) {
-		ret = nvme_tcp_try_send_cmd_pdu(req);
+		if (!nvme_tcp_tls(&queue->ctrl->ctrl) &&
+		    nvme_tcp_cmd_batchable(req))
+			ret = nvme_tcp_try_send_cmd_batch(queue);
+		else
+			ret = nvme_tcp_try_send_cmd_pdu(req);
 		if (ret <= 0)
 			goto done;
 		if (!nvme_tcp_has_inline_data(req))
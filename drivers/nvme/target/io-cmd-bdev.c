@@ -182,10 +182,34 @@ static void nvmet_bio_done(struct bio *bio)
 {
 	struct nvmet_req *req = bio->bi_private;
 
+	if (req->poll_bio) {
+		WRITE_ONCE(req->poll_bio, NULL);
+		atomic_dec(&req->sq->nr_polled);
+	}
 	nvmet_req_complete(req, blk_to_nvme_status(req, bio->bi_status));
 	nvmet_req_bio_put(req, bio);
 }
 
+/*
+ * Poll for the completion of a request submitted with req->use_poll set.
+ * Bios come from SLAB_TYPESAFE_BY_RCU caches or are embedded in the
+ * request, so like iocb_bio_iopoll() this only needs RCU to look at a
+ * bio that may be completing concurrently.
+ */
+int nvmet_bdev_req_poll(struct nvmet_req *req)
+{
+	struct bio *bio;
+	int ret = 0;
+
+	rcu_read_lock();
+	bio = READ_ONCE(req->poll_bio);
+	if (bio)
+		ret = bio_poll(bio, NULL, BLK_POLL_ONESHOT);
+	rcu_read_unlock();
+	return ret;
+}
+EXPORT_SYMBOL_GPL(nvmet_bdev_req_poll);
+
 #ifdef CONFIG_BLK_DEV_INTEGRITY
 static int nvmet_bdev_alloc_bip(struct nvmet_req *req, struct bio *bio,
 				struct sg_mapping_iter *miter)
@@ -273,6 +297,14 @@ static void nvmet_bdev_execute_rw(struct nvmet_req *req)
 	if (is_pci_p2pdma_page(sg_page(req->sg)))
 		opf |= REQ_NOMERGE;
 
+	/*
+	 * Bios split by the block layer lose REQ_POLLED and complete through
+	 * interrupts, so only the last bio of a request needs to be polled.
+	 */
+	if (req->use_poll &&
+	    test_bit(QUEUE_FLAG_POLL, &bdev_get_queue(req->ns->bdev)->queue_flags))
+		opf |= REQ_POLLED;
+
 	sector = nvmet_lba_to_sect(req->ns, req->cmd->rw.slba);
 
 	if (nvmet_use_inline_bvec(req)) {
@@ -326,6 +358,11 @@ static void nvmet_bdev_execute_rw(struct nvmet_req *req)
 		}
 	}
 
+	if (opf & REQ_POLLED) {
+		/* published before submission as others may poll it first */
+		atomic_inc(&req->sq->nr_polled);
+		WRITE_ONCE(req->poll_bio, bio);
+	}
 	submit_bio(bio);
 	blk_finish_plug(&plug);
 }
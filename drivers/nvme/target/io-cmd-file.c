@@ -117,6 +117,8 @@ static void nvmet_file_io_done(struct kiocb *iocb, long ret)
 	nvmet_req_complete(req, status);
 }
 
+static void nvmet_file_rasync_put(struct nvmet_req *req);
+
 static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 {
 	ssize_t nr_bvec = req->sg_cnt;
@@ -172,18 +174,23 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 
 	/*
 	 * A NULL ki_complete ask for synchronous execution, which we want
-	 * for the IOCB_NOWAIT case.
+	 * for the IOCB_NOWAIT and IOCB_WAITQ cases.
 	 */
-	if (!(ki_flags & IOCB_NOWAIT))
+	if (!(ki_flags & (IOCB_NOWAIT | IOCB_WAITQ)))
 		req->f.iocb.ki_complete = nvmet_file_io_done;
+	else if (ki_flags & IOCB_WAITQ)
+		req->f.iocb.ki_waitq = &req->f.wpq;
 
 	ret = nvmet_file_submit_bvec(req, pos, bv_cnt, total_len, ki_flags);
 
 	switch (ret) {
 	case -EIOCBQUEUED:
+		/* buffered read waiting for a folio, see nvmet_file_rasync_wake */
+		if (ki_flags & IOCB_WAITQ)
+			nvmet_file_rasync_put(req);
 		return true;
 	case -EAGAIN:
-		if (WARN_ON_ONCE(!(ki_flags & IOCB_NOWAIT)))
+		if (WARN_ON_ONCE(!(ki_flags & (IOCB_NOWAIT | IOCB_WAITQ))))
 			goto complete;
 		return false;
 	case -EOPNOTSUPP:
@@ -195,6 +202,16 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 		if ((ki_flags & IOCB_NOWAIT))
 			return false;
 		break;
+	default:
+		/*
+		 * Nonblocking buffered I/O stops at the first folio it would
+		 * have to wait for.  Redo the whole command from the worker
+		 * rather than failing it for a short transfer.
+		 */
+		if ((ki_flags & (IOCB_NOWAIT | IOCB_WAITQ)) &&
+		    ret >= 0 && ret < req->transfer_len)
+			return false;
+		break;
 	}
 
 complete:
@@ -215,6 +232,53 @@ static void nvmet_file_submit_buffered_io(struct nvmet_req *req)
 	queue_work(buffered_io_wq, &req->f.work);
 }
 
+/*
+ * The folio wake up can race with the submitter still unwinding from
+ * ->read_iter, so the retry is only queued once both are done with the
+ * iocb.
+ */
+static void nvmet_file_rasync_put(struct nvmet_req *req)
+{
+	if (atomic_dec_and_test(&req->f.rasync_ref))
+		nvmet_file_submit_buffered_io(req);
+}
+
+static int nvmet_file_rasync_wake(struct wait_queue_entry *wait,
+		unsigned int mode, int sync, void *key)
+{
+	struct wait_page_queue *wpq =
+		container_of(wait, struct wait_page_queue, wait);
+
+	if (!wake_page_match(wpq, key))
+		return 0;
+
+	list_del_init(&wait->entry);
+	nvmet_file_rasync_put(wait->private);
+	return 1;
+}
+
+/*
+ * Like io_uring, retry a buffered read that hit an uncached or locked folio
+ * with IOCB_WAITQ, which starts readahead and registers a wake up for the
+ * folio instead of blocking.  The worker only runs once the data is in the
+ * page cache, so it rarely has to block.
+ */
+static bool nvmet_file_try_rasync(struct nvmet_req *req)
+{
+	struct wait_page_queue *wpq = &req->f.wpq;
+
+	if (req->cmd->rw.opcode == nvme_cmd_write ||
+	    !(req->ns->file->f_op->fop_flags & FOP_BUFFER_RASYNC))
+		return false;
+
+	wpq->wait.func = nvmet_file_rasync_wake;
+	wpq->wait.private = req;
+	wpq->wait.flags = 0;
+	INIT_LIST_HEAD(&wpq->wait.entry);
+	atomic_set(&req->f.rasync_ref, 2);
+	return nvmet_file_execute_io(req, IOCB_WAITQ);
+}
+
 static void nvmet_file_execute_rw(struct nvmet_req *req)
 {
 	ssize_t nr_bvec = req->sg_cnt;
@@ -243,7 +307,8 @@ static void nvmet_file_execute_rw(struct nvmet_req *req)
 	if (req->ns->buffered_io) {
 		if (likely(!req->f.mpool_alloc) &&
 		    (req->ns->file->f_mode & FMODE_NOWAIT) &&
-		    nvmet_file_execute_io(req, IOCB_NOWAIT))
+		    (nvmet_file_execute_io(req, IOCB_NOWAIT) ||
+		     nvmet_file_try_rasync(req)))
 			return;
 		nvmet_file_submit_buffered_io(req);
 	} else
@@ -18,6 +18,7 @@
 #include <linux/configfs.h>
 #include <linux/rcupdate.h>
 #include <linux/blkdev.h>
+#include <linux/pagemap.h>
 #include <linux/radix-tree.h>
 #include <linux/t10-pi.h>
 
@@ -109,6 +110,8 @@ struct nvmet_sq {
 	u16			size;
 	u32			sqhd;
 	bool			sqhd_disabled;
+	/* requests waiting on REQ_POLLED backend bios */
+	atomic_t		nr_polled;
 #ifdef CONFIG_NVME_TARGET_AUTH
 	bool			authenticated;
 	struct delayed_work	auth_expired_work;
@@ -377,6 +380,9 @@ struct nvmet_req {
 			struct kiocb            iocb;
 			struct bio_vec          *bvec;
 			struct work_struct      work;
+			/* async buffered read retry, see nvmet_file_try_rasync */
+			struct wait_page_queue	wpq;
+			atomic_t		rasync_ref;
 		} f;
 		struct {
 			struct bio		inline_bio;
@@ -406,6 +412,9 @@ struct nvmet_req {
 	struct device		*p2p_client;
 	u16			error_loc;
 	u64			error_slba;
+	/* set by the transport if it polls the backend via nvmet_bdev_req_poll */
+	bool			use_poll;
+	struct bio		*poll_bio;
 };
 
 #define NVMET_MAX_MPOOL_BVEC		16
@@ -474,6 +483,7 @@ void nvmet_req_uninit(struct nvmet_req *req);
 bool nvmet_check_transfer_len(struct nvmet_req *req, size_t len);
 bool nvmet_check_data_len_lte(struct nvmet_req *req, size_t data_len);
 void nvmet_req_complete(struct nvmet_req *req, u16 status);
+int nvmet_bdev_req_poll(struct nvmet_req *req);
 int nvmet_req_alloc_sgls(struct nvmet_req *req);
 void nvmet_req_free_sgls(struct nvmet_req *req);
 
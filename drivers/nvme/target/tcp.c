@@ -73,6 +73,15 @@ device_param_cb(idle_poll_period_usecs, &set_param_ops,
 MODULE_PARM_DESC(idle_poll_period_usecs,
 		"nvmet tcp io_work poll till idle time period in usecs: Default 0");
 
+/*
+ * Submit reads and writes to backends with polled queues as REQ_POLLED and
+ * reap their completions from io_work instead of waiting for interrupts.
+ */
+static bool backend_poll;
+module_param(backend_poll, bool, 0644);
+MODULE_PARM_DESC(backend_poll,
+		"nvmet tcp io_work polls backend block device completions: Default false");
+
 #ifdef CONFIG_NVME_TARGET_TCP_TLS
 /*
  * TLS handshake timeout
@@ -1081,6 +1090,7 @@ static int nvmet_tcp_done_recv_pdu(struct nvmet_tcp_queue *queue)
 		nvmet_tcp_handle_req_failure(queue, queue->cmd, req);
 		return 0;
 	}
+	req->use_poll = READ_ONCE(backend_poll);
 
 	ret = nvmet_tcp_map_data(queue->cmd);
 	if (unlikely(ret)) {
@@ -1423,6 +1433,18 @@ static bool nvmet_tcp_check_queue_deadline(struct nvmet_tcp_queue *queue,
 	return !time_after(jiffies, queue->poll_end);
 }
 
+static int nvmet_tcp_poll_backend(struct nvmet_tcp_queue *queue)
+{
+	int i, ret = 0;
+
+	if (!atomic_read(&queue->nvme_sq.nr_polled))
+		return 0;
+
+	for (i = 0; i < queue->nr_cmds; i++)
+		ret += nvmet_bdev_req_poll(&queue->cmds[i].req);
+	return ret;
+}
+
 static void nvmet_tcp_io_work(struct work_struct *w)
 {
 	struct nvmet_tcp_queue *queue =
@@ -1445,13 +1467,19 @@ static void nvmet_tcp_io_work(struct work_struct *w)
 		else if (ret < 0)
 			return;
 
+		if (nvmet_tcp_poll_backend(queue) > 0)
+			pending = true;
+
 	} while (pending && ops < NVMET_TCP_IO_WORK_BUDGET);
 
 	/*
 	 * Requeue the worker if idle deadline period is in progress or any
-	 * ops activity was recorded during the do-while loop above.
+	 * ops activity was recorded during the do-while loop above.  Polled
+	 * backend I/O has no interrupt to kick us, so keep going until it
+	 * has all completed.
 	 */
-	if (nvmet_tcp_check_queue_deadline(queue, ops) || pending)
+	if (nvmet_tcp_check_queue_deadline(queue, ops) || pending ||
+	    atomic_read(&queue->nvme_sq.nr_polled))
 		queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &queue->io_work);
 }
 
@@ -1603,6 +1631,11 @@ static void nvmet_tcp_release_queue_work(struct work_struct *w)
 	queue->rcv_state = NVMET_TCP_RECV_ERR;
 
 	nvmet_tcp_uninit_data_in_cmds(queue);
+	/* io_work is gone, reap polled backend I/O before waiting for it */
+	while (atomic_read(&queue->nvme_sq.nr_polled)) {
+		nvmet_tcp_poll_backend(queue);
+		cond_resched();
+	}
 	nvmet_sq_destroy(&queue->nvme_sq);
 	cancel_work_sync(&queue->io_work);
 	nvmet_tcp_free_cmd_data_in_buffers(queue);
@@ -40,6 +40,16 @@ module_param(experimental_zcopytx, int, 0444);
 MODULE_PARM_DESC(experimental_zcopytx, "Enable Zero Copy TX;"
 		                       " 1 -Enable; 0 - Disable");
 
+static int tx_batch = VHOST_NET_BATCH;
+module_param(tx_batch, int, 0644);
+MODULE_PARM_DESC(tx_batch,
+		 "Maximum number of packets handed to the socket in one TX batch (1-256)");
+
+static bool split_workers;
+module_param(split_workers, bool, 0644);
+MODULE_PARM_DESC(split_workers,
+		 "Run the TX and RX virtqueues of a device in separate worker threads");
+
 /* Max number of bytes transferred before requeueing the job.
  * Using this limit prevents one virtqueue from starving others. */
 #define VHOST_NET_WEIGHT 0x80000
@@ -99,6 +109,8 @@ struct vhost_net_ubuf_ref {
 };
 
 #define VHOST_NET_BATCH 64
+/* Upper bound for the tx_batch module parameter */
+#define VHOST_NET_TX_BATCH_MAX 256
 struct vhost_net_buf {
 	void **queue;
 	int tail;
@@ -755,11 +767,15 @@ static void handle_tx_copy(struct vhost_net *net, struct socket *sock)
 	int err;
 	int sent_pkts = 0;
 	bool sock_can_batch = (sock->sk->sk_sndbuf == INT_MAX);
+	int batch = clamp(READ_ONCE(tx_batch), 1, VHOST_NET_TX_BATCH_MAX);
 
 	do {
 		bool busyloop_intr = false;
 
-		if (nvq->done_idx == VHOST_NET_BATCH)
+		/* The batch is also flushed as soon as the ring runs dry,
+		 * so it only grows this large when the guest keeps up.
+		 */
+		if (nvq->done_idx >= batch)
 			vhost_tx_batch(net, nvq, sock, &msg);
 
 		head = get_tx_bufs(net, nvq, &msg, &out, &in, &len,
@@ -1289,7 +1305,7 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 	}
 	n->vqs[VHOST_NET_VQ_RX].rxq.queue = queue;
 
-	xdp = kmalloc_array(VHOST_NET_BATCH, sizeof(*xdp), GFP_KERNEL);
+	xdp = kmalloc_array(VHOST_NET_TX_BATCH_MAX, sizeof(*xdp), GFP_KERNEL);
 	if (!xdp) {
 		kfree(vqs);
 		kvfree(n);
@@ -1318,6 +1334,7 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 		       UIO_MAXIOV + VHOST_NET_BATCH,
 		       VHOST_NET_PKT_WEIGHT, VHOST_NET_WEIGHT, true,
 		       NULL);
+	dev->worker_per_vq = READ_ONCE(split_workers);
 
 	vhost_poll_init(n->poll + VHOST_NET_VQ_TX, handle_tx_net, EPOLLOUT, dev,
 			vqs[VHOST_NET_VQ_TX]);
@@ -551,6 +551,7 @@ void vhost_dev_init(struct vhost_dev *dev,
 	dev->weight = weight;
 	dev->byte_weight = byte_weight;
 	dev->use_worker = use_worker;
+	dev->worker_per_vq = false;
 	dev->msg_handler = msg_handler;
 	init_waitqueue_head(&dev->wait);
 	INIT_LIST_HEAD(&dev->read_list);
@@ -920,7 +921,7 @@ EXPORT_SYMBOL_GPL(vhost_worker_ioctl);
 /* Caller should have device mutex */
 long vhost_dev_set_owner(struct vhost_dev *dev)
 {
-	struct vhost_worker *worker;
+	struct vhost_worker *worker = NULL;
 	int err, i;
 
 	/* Is there an owner already? */
@@ -942,19 +943,22 @@ long vhost_dev_set_owner(struct vhost_dev *dev)
 		 * below since we don't have to worry about vsock queueing
 		 * while we free the worker.
 		 */
-		worker = vhost_worker_create(dev);
-		if (!worker) {
-			err = -ENOMEM;
-			goto err_worker;
-		}
-
-		for (i = 0; i < dev->nvqs; i++)
+		for (i = 0; i < dev->nvqs; i++) {
+			if (!worker || dev->worker_per_vq) {
+				worker = vhost_worker_create(dev);
+				if (!worker) {
+					err = -ENOMEM;
+					goto err_worker;
+				}
+			}
 			__vhost_vq_attach_worker(dev->vqs[i], worker);
+		}
 	}
 
 	return 0;
 
 err_worker:
+	vhost_workers_free(dev);
 	vhost_dev_free_iovecs(dev);
 err_iovecs:
 	vhost_detach_mm(dev);
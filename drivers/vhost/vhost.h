@@ -176,6 +176,8 @@ struct vhost_dev {
 	int byte_weight;
 	struct xarray worker_xa;
 	bool use_worker;
+	/* give every virtqueue its own default worker at VHOST_SET_OWNER */
+	bool worker_per_vq;
 	int (*msg_handler)(struct vhost_dev *dev, u32 asid,
 			   struct vhost_iotlb_msg *msg);
 };
@@ -1707,6 +1707,64 @@ static int virtio_mem_sbm_plug_and_add_mb(struct virtio_mem *vm,
 	return 0;
 }
 
+/*
+ * Maximum number of new, completely plugged memory blocks we plug with a
+ * single request. A request can cover at most U16_MAX device blocks.
+ */
+#define VIRTIO_MEM_SBM_PLUG_BATCH	32
+
+/*
+ * Plug a range of freshly prepared, consecutive memory blocks completely
+ * with a single request and add them to Linux one by one. Saves a device
+ * round trip per memory block when plugging lots of memory.
+ *
+ * Will modify the state of the memory blocks.
+ */
+static int virtio_mem_sbm_plug_and_add_mbs(struct virtio_mem *vm,
+					   unsigned long first_mb_id,
+					   unsigned long nr_mbs,
+					   uint64_t *nb_sb)
+{
+	const unsigned long end_mb_id = first_mb_id + nr_mbs;
+	unsigned long mb_id;
+	int rc, new_state;
+
+	rc = virtio_mem_send_plug_request(vm,
+					  virtio_mem_mb_id_to_phys(first_mb_id),
+					  nr_mbs * memory_block_size_bytes());
+	if (rc)
+		return rc;
+
+	for (mb_id = first_mb_id; mb_id < end_mb_id; mb_id++)
+		virtio_mem_sbm_set_sb_plugged(vm, mb_id, 0,
+					      vm->sbm.sbs_per_mb);
+
+	for (mb_id = first_mb_id; mb_id < end_mb_id; mb_id++) {
+		virtio_mem_sbm_set_mb_state(vm, mb_id,
+					    VIRTIO_MEM_SBM_MB_OFFLINE);
+		rc = virtio_mem_sbm_add_mb(vm, mb_id);
+		if (rc)
+			goto unplug;
+		*nb_sb -= vm->sbm.sbs_per_mb;
+		cond_resched();
+	}
+	return 0;
+unplug:
+	/* Try to unplug everything that didn't make it into Linux. */
+	new_state = VIRTIO_MEM_SBM_MB_UNUSED;
+	if (virtio_mem_send_unplug_request(vm, virtio_mem_mb_id_to_phys(mb_id),
+					   (end_mb_id - mb_id) *
+					   memory_block_size_bytes()))
+		new_state = VIRTIO_MEM_SBM_MB_PLUGGED;
+	for (; mb_id < end_mb_id; mb_id++) {
+		if (new_state == VIRTIO_MEM_SBM_MB_UNUSED)
+			virtio_mem_sbm_set_sb_unplugged(vm, mb_id, 0,
+							vm->sbm.sbs_per_mb);
+		virtio_mem_sbm_set_mb_state(vm, mb_id, new_state);
+	}
+	return rc;
+}
+
 /*
  * Try to plug the desired number of subblocks of a memory block that
  * is already added to Linux.
@@ -1801,12 +1859,40 @@ static int virtio_mem_sbm_plug_request(struct virtio_mem *vm, uint64_t diff)
 
 	/* Try to prepare, plug and add new blocks */
 	while (nb_sb) {
-		if (!virtio_mem_could_add_memory(vm, memory_block_size_bytes()))
-			return -ENOSPC;
+		unsigned long first_mb_id = 0, nr_mbs = 0;
+
+		/* Prepare a run of new blocks we can plug completely. */
+		while (nr_mbs < VIRTIO_MEM_SBM_PLUG_BATCH &&
+		       nb_sb >= (nr_mbs + 1) * vm->sbm.sbs_per_mb &&
+		       (nr_mbs + 1) * memory_block_size_bytes() /
+		       vm->device_block_size <= U16_MAX &&
+		       virtio_mem_could_add_memory(vm, (nr_mbs + 1) *
+						   memory_block_size_bytes())) {
+			if (virtio_mem_sbm_prepare_next_mb(vm, &mb_id))
+				break;
+			if (!nr_mbs)
+				first_mb_id = mb_id;
+			nr_mbs++;
+		}
+		if (nr_mbs > 1) {
+			rc = virtio_mem_sbm_plug_and_add_mbs(vm, first_mb_id,
+							     nr_mbs, &nb_sb);
+			if (rc)
+				return rc;
+			continue;
+		}
 
-		rc = virtio_mem_sbm_prepare_next_mb(vm, &mb_id);
-		if (rc)
-			return rc;
+		if (nr_mbs) {
+			mb_id = first_mb_id;
+		} else {
+			if (!virtio_mem_could_add_memory(vm,
+							 memory_block_size_bytes()))
+				return -ENOSPC;
+
+			rc = virtio_mem_sbm_prepare_next_mb(vm, &mb_id);
+			if (rc)
+				return rc;
+		}
 		rc = virtio_mem_sbm_plug_and_add_mb(vm, mb_id, &nb_sb);
 		if (rc)
 			return rc;
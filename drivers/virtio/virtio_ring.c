@@ -548,14 +548,15 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 				      unsigned int in_sgs,
 				      void *data,
 				      void *ctx,
-				      gfp_t gfp)
+				      gfp_t gfp,
+				      bool publish)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
 	struct scatterlist *sg;
 	struct vring_desc *desc;
 	unsigned int i, n, avail, descs_used, prev, err_idx;
 	int head;
-	bool indirect;
+	bool indirect, wrap;
 
 	START_USE(vq);
 
@@ -687,20 +688,27 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	avail = vq->split.avail_idx_shadow & (vq->split.vring.num - 1);
 	vq->split.vring.avail->ring[avail] = cpu_to_virtio16(_vq->vdev, head);
 
-	/* Descriptors and available array need to be set before we expose the
-	 * new available array entries. */
-	virtio_wmb(vq->weak_barriers);
 	vq->split.avail_idx_shadow++;
-	vq->split.vring.avail->idx = cpu_to_virtio16(_vq->vdev,
-						vq->split.avail_idx_shadow);
 	vq->num_added++;
 
+	/* This is very unlikely, but theoretically possible.  Kick
+	 * just in case. */
+	wrap = unlikely(vq->num_added == (1 << 16) - 1);
+
+	/* Batched adds expose all new entries at once when done, see
+	 * virtqueue_add_inbufs_ctx(). */
+	if (publish || wrap) {
+		/* Descriptors and available array need to be set before we
+		 * expose the new available array entries. */
+		virtio_wmb(vq->weak_barriers);
+		vq->split.vring.avail->idx = cpu_to_virtio16(_vq->vdev,
+						vq->split.avail_idx_shadow);
+	}
+
 	pr_debug("Added buffer head %i to %p\n", head, vq);
 	END_USE(vq);
 
-	/* This is very unlikely, but theoretically possible.  Kick
-	 * just in case. */
-	if (unlikely(vq->num_added == (1 << 16) - 1))
+	if (wrap)
 		virtqueue_kick(_vq);
 
 	return 0;
@@ -731,6 +739,17 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	return -ENOMEM;
 }
 
+static void virtqueue_publish_avail_split(struct vring_virtqueue *vq)
+{
+	START_USE(vq);
+	/* Descriptors and available array need to be set before we expose the
+	 * new available array entries. */
+	virtio_wmb(vq->weak_barriers);
+	vq->split.vring.avail->idx = cpu_to_virtio16(vq->vq.vdev,
+						vq->split.avail_idx_shadow);
+	END_USE(vq);
+}
+
 static bool virtqueue_kick_prepare_split(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -2208,7 +2227,7 @@ static inline int virtqueue_add(struct virtqueue *_vq,
 	return vq->packed_ring ? virtqueue_add_packed(_vq, sgs, total_sg,
 					out_sgs, in_sgs, data, ctx, gfp) :
 				 virtqueue_add_split(_vq, sgs, total_sg,
-					out_sgs, in_sgs, data, ctx, gfp);
+					out_sgs, in_sgs, data, ctx, gfp, true);
 }
 
 /**
@@ -2314,6 +2333,58 @@ int virtqueue_add_inbuf_ctx(struct virtqueue *vq,
 }
 EXPORT_SYMBOL_GPL(virtqueue_add_inbuf_ctx);
 
+/**
+ * virtqueue_add_inbufs_ctx - expose a batch of input buffers to other end
+ * @_vq: the struct virtqueue we're talking about.
+ * @sg: array of @num single entry scatterlists, each one terminated
+ *	(e.g. set up with sg_init_one())
+ * @num: the number of buffers in @sg
+ * @data: the tokens identifying the buffers, one per buffer.
+ * @ctx: extra context for the tokens, one per buffer, or NULL.
+ * @gfp: how to do memory allocations (if necessary).
+ *
+ * Like calling virtqueue_add_inbuf_ctx() @num times, but on a split
+ * ring the new available entries are exposed to the other end with a
+ * single barrier and index update for the whole batch.  Typically used
+ * to refill receive queues with premapped buffers.
+ *
+ * Caller must ensure we don't call this with other virtqueue operations
+ * at the same time (except where noted).
+ *
+ * Returns the number of buffers added, or a negative error (ie. ENOSPC,
+ * ENOMEM, EIO) if the first one could not be added.
+ */
+int virtqueue_add_inbufs_ctx(struct virtqueue *_vq,
+			     struct scatterlist sg[], unsigned int num,
+			     void *data[],
+			     void *ctx[],
+			     gfp_t gfp)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	struct scatterlist *sgp;
+	unsigned int i;
+	int err = 0;
+
+	for (i = 0; i < num; i++) {
+		sgp = &sg[i];
+		if (vq->packed_ring)
+			err = virtqueue_add_packed(_vq, &sgp, 1, 0, 1, data[i],
+						   ctx ? ctx[i] : NULL, gfp);
+		else
+			err = virtqueue_add_split(_vq, &sgp, 1, 0, 1, data[i],
+						  ctx ? ctx[i] : NULL, gfp,
+						  false);
+		if (err)
+			break;
+	}
+
+	if (i && !vq->packed_ring)
+		virtqueue_publish_avail_split(vq);
+
+	return i ? i : err;
+}
+EXPORT_SYMBOL_GPL(virtqueue_add_inbufs_ctx);
+
 /**
  * virtqueue_dma_dev - get the dma dev
  * @_vq: the struct virtqueue we're talking about.
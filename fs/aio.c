@@ -22,6 +22,7 @@
 #include <linux/refcount.h>
 #include <linux/uio.h>
 
+#include <linux/sched/clock.h>
 #include <linux/sched/signal.h>
 #include <linux/fs.h>
 #include <linux/file.h>
@@ -152,12 +153,16 @@ struct kioctx {
 	struct {
 		struct mutex	ring_lock;
 		wait_queue_head_t wait;
+		/* ->completed_seq when the ring was last found empty */
+		unsigned long	drained_seq;
 	} ____cacheline_aligned_in_smp;
 
 	struct {
 		unsigned	tail;
 		unsigned	completed_events;
 		spinlock_t	completion_lock;
+		/* bumped after every event added to the ring */
+		unsigned long	completed_seq;
 	} ____cacheline_aligned_in_smp;
 
 	struct folio		*internal_folios[AIO_RING_PAGES];
@@ -222,6 +227,7 @@ struct aio_kiocb {
 static DEFINE_SPINLOCK(aio_nr_lock);
 static unsigned long aio_nr;		/* current system wide number of aio requests */
 static unsigned long aio_max_nr = 0x10000; /* system wide maximum number of aio requests */
+static unsigned int aio_poll_usecs;	/* io_getevents() spins this long before sleeping */
 /*----end sysctl variables---*/
 #ifdef CONFIG_SYSCTL
 static struct ctl_table aio_sysctls[] = {
@@ -239,6 +245,15 @@ static struct ctl_table aio_sysctls[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_doulongvec_minmax,
 	},
+	{
+		.procname	= "aio-poll-usecs",
+		.data		= &aio_poll_usecs,
+		.maxlen		= sizeof(aio_poll_usecs),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_INT_MAX,
+	},
 };
 
 static void __init aio_sysctl_init(void)
@@ -1171,6 +1186,9 @@ static void aio_complete(struct aio_kiocb *iocb)
 	ring->tail = tail;
 	flush_dcache_folio(ctx->ring_folios[0]);
 
+	smp_wmb();	/* make tail visible before the sequence, see aio_ring_empty() */
+	WRITE_ONCE(ctx->completed_seq, ctx->completed_seq + 1);
+
 	ctx->completed_events++;
 	if (ctx->completed_events > 1)
 		refill_reqs_available(ctx, head, tail);
@@ -1224,14 +1242,28 @@ static inline void iocb_put(struct aio_kiocb *iocb)
  *	Pull an event off of the ioctx's event ring.  Returns the number of
  *	events fetched
  */
+/*
+ * Lockless check for pollers: nothing was completed since the ring was last
+ * drained by aio_read_events_ring().  Events reaped by userspace directly
+ * don't matter here, they only make the ring emptier.
+ */
+static inline bool aio_ring_empty(struct kioctx *ctx)
+{
+	return READ_ONCE(ctx->completed_seq) == READ_ONCE(ctx->drained_seq);
+}
+
 static long aio_read_events_ring(struct kioctx *ctx,
 				 struct io_event __user *event, long nr)
 {
 	struct aio_ring *ring;
 	unsigned head, tail, pos;
+	unsigned long seq;
 	long ret = 0;
 	int copy_ret;
 
+	if (aio_ring_empty(ctx))
+		return 0;
+
 	/*
 	 * The mutex can block and wake us up and that will cause
 	 * wait_event_interruptible_hrtimeout() to schedule without sleeping
@@ -1241,6 +1273,10 @@ static long aio_read_events_ring(struct kioctx *ctx,
 	sched_annotate_sleep();
 	mutex_lock(&ctx->ring_lock);
 
+	/* pairs with the smp_wmb() in aio_complete() */
+	seq = READ_ONCE(ctx->completed_seq);
+	smp_rmb();
+
 	/* Access to ->ring_folios here is protected by ctx->ring_lock. */
 	ring = folio_address(ctx->ring_folios[0]);
 	head = ring->head;
@@ -1254,8 +1290,10 @@ static long aio_read_events_ring(struct kioctx *ctx,
 
 	pr_debug("h%u t%u m%u\n", head, tail, ctx->nr_events);
 
-	if (head == tail)
+	if (head == tail) {
+		WRITE_ONCE(ctx->drained_seq, seq);
 		goto out;
+	}
 
 	head %= ctx->nr_events;
 	tail %= ctx->nr_events;
@@ -1293,6 +1331,8 @@ static long aio_read_events_ring(struct kioctx *ctx,
 	ring = folio_address(ctx->ring_folios[0]);
 	ring->head = head;
 	flush_dcache_folio(ctx->ring_folios[0]);
+	if (head == tail)
+		WRITE_ONCE(ctx->drained_seq, seq);
 
 	pr_debug("%li  h%u t%u\n", ret, head, tail);
 out:
@@ -1344,6 +1384,28 @@ static long read_events(struct kioctx *ctx, long min_nr, long nr,
 	if (until == 0 || ret < 0 || ret >= min_nr)
 		return ret;
 
+	if (READ_ONCE(aio_poll_usecs)) {
+		u64 poll_ns = (u64)READ_ONCE(aio_poll_usecs) * NSEC_PER_USEC;
+		u64 start = local_clock(), elapsed;
+
+		if (until != KTIME_MAX)
+			poll_ns = min_t(u64, poll_ns, until);
+		do {
+			if (!aio_ring_empty(ctx) &&
+			    aio_read_events(ctx, min_nr, nr, event, &ret))
+				return ret;
+			cpu_relax();
+			elapsed = local_clock() - start;
+		} while (elapsed < poll_ns && !need_resched() &&
+			 !signal_pending(current));
+
+		if (until != KTIME_MAX) {
+			if (elapsed >= until)
+				return ret;
+			until -= elapsed;
+		}
+	}
+
 	hrtimer_init_sleeper_on_stack(&t, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	if (until != KTIME_MAX) {
 		hrtimer_set_expires_range_ns(&t.timer, until, current->timer_slack_ns);
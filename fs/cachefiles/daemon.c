@@ -29,6 +29,7 @@ static ssize_t cachefiles_daemon_write(struct file *, const char __user *,
 				       size_t, loff_t *);
 static __poll_t cachefiles_daemon_poll(struct file *,
 					   struct poll_table_struct *);
+static int cachefiles_daemon_uring_cmd(struct io_uring_cmd *, unsigned int);
 static int cachefiles_daemon_frun(struct cachefiles_cache *, char *);
 static int cachefiles_daemon_fcull(struct cachefiles_cache *, char *);
 static int cachefiles_daemon_fstop(struct cachefiles_cache *, char *);
@@ -53,6 +54,7 @@ const struct file_operations cachefiles_daemon_fops = {
 	.read		= cachefiles_daemon_read,
 	.write		= cachefiles_daemon_write,
 	.poll		= cachefiles_daemon_poll,
+	.uring_cmd	= cachefiles_daemon_uring_cmd,
 	.llseek		= noop_llseek,
 };
 
@@ -158,7 +160,7 @@ void cachefiles_flush_reqs(struct cachefiles_cache *cache)
 	xa_lock(xa);
 	xa_for_each(xa, index, req) {
 		req->error = -EIO;
-		complete(&req->done);
+		complete_all(&req->done);
 		__xa_erase(xa, index);
 	}
 	xa_unlock(xa);
@@ -271,6 +273,23 @@ static ssize_t cachefiles_daemon_read(struct file *file, char __user *_buffer,
 		return cachefiles_do_daemon_read(cache, _buffer, buflen);
 }
 
+/*
+ * Fetch and complete on-demand requests in bulk through io_uring.
+ */
+static int cachefiles_daemon_uring_cmd(struct io_uring_cmd *ioucmd,
+				       unsigned int issue_flags)
+{
+	struct cachefiles_cache *cache = ioucmd->file->private_data;
+
+	if (!test_bit(CACHEFILES_READY, &cache->flags))
+		return -EINVAL;
+
+	if (!cachefiles_in_ondemand_mode(cache))
+		return -EOPNOTSUPP;
+
+	return cachefiles_ondemand_uring_cmd(cache, ioucmd);
+}
+
 /*
  * Take a command from cachefilesd, parse it and act on it.
  */
@@ -53,6 +53,7 @@ enum cachefiles_object_state {
 struct cachefiles_ondemand_info {
 	struct work_struct		ondemand_work;
 	int				ondemand_id;
+	unsigned long			read_req_id;	/* last READ request + 1, for merging */
 	enum cachefiles_object_state	state;
 	struct cachefiles_object	*object;
 	spinlock_t			lock;
@@ -303,6 +304,9 @@ extern bool cachefiles_commit_tmpfile(struct cachefiles_cache *cache,
 extern ssize_t cachefiles_ondemand_daemon_read(struct cachefiles_cache *cache,
 					char __user *_buffer, size_t buflen);
 
+extern int cachefiles_ondemand_uring_cmd(struct cachefiles_cache *cache,
+					 struct io_uring_cmd *ioucmd);
+
 extern int cachefiles_ondemand_copen(struct cachefiles_cache *cache,
 				     char *args);
 
@@ -349,6 +353,12 @@ static inline ssize_t cachefiles_ondemand_daemon_read(struct cachefiles_cache *c
 	return -EOPNOTSUPP;
 }
 
+static inline int cachefiles_ondemand_uring_cmd(struct cachefiles_cache *cache,
+						struct io_uring_cmd *ioucmd)
+{
+	return -EOPNOTSUPP;
+}
+
 static inline int cachefiles_ondemand_init_object(struct cachefiles_object *object)
 {
 	return 0;
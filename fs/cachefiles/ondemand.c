@@ -1,8 +1,13 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #include <linux/anon_inodes.h>
+#include <linux/io_uring/cmd.h>
+#include <linux/sizes.h>
 #include <linux/uio.h>
 #include "internal.h"
 
+/* Longest range adjacent READ requests are merged into */
+#define CACHEFILES_ONDEMAND_MERGE_MAX	SZ_1M
+
 struct ondemand_anon_file {
 	struct file *file;
 	int fd;
@@ -95,35 +100,52 @@ static loff_t cachefiles_ondemand_fd_llseek(struct file *filp, loff_t pos,
 	return vfs_llseek(file, pos, whence);
 }
 
-static long cachefiles_ondemand_fd_ioctl(struct file *filp, unsigned int ioctl,
-					 unsigned long id)
+/*
+ * Complete READ request @id with @error.  The request must belong to @object,
+ * or to any object of the cache if @object is NULL.
+ */
+static int cachefiles_ondemand_complete_read(struct cachefiles_cache *cache,
+					     struct cachefiles_object *object,
+					     unsigned long id, int error)
 {
-	struct cachefiles_object *object = filp->private_data;
-	struct cachefiles_cache *cache = object->volume->cache;
 	struct cachefiles_req *req;
 	XA_STATE(xas, &cache->reqs, id);
 
-	if (ioctl != CACHEFILES_IOC_READ_COMPLETE)
+	if (error > 0 || error < -MAX_ERRNO)
 		return -EINVAL;
 
-	if (!test_bit(CACHEFILES_ONDEMAND_MODE, &cache->flags))
-		return -EOPNOTSUPP;
-
 	xa_lock(&cache->reqs);
 	req = xas_load(&xas);
 	if (!req || req->msg.opcode != CACHEFILES_OP_READ ||
-	    req->object != object) {
+	    (object && req->object != object)) {
 		xa_unlock(&cache->reqs);
 		return -EINVAL;
 	}
 	xas_store(&xas, NULL);
 	xa_unlock(&cache->reqs);
 
-	trace_cachefiles_ondemand_cread(object, id);
-	complete(&req->done);
+	trace_cachefiles_ondemand_cread(req->object, id);
+	req->error = error;
+	/* Merged readers wait on the same request */
+	complete_all(&req->done);
 	return 0;
 }
 
+static long cachefiles_ondemand_fd_ioctl(struct file *filp, unsigned int ioctl,
+					 unsigned long id)
+{
+	struct cachefiles_object *object = filp->private_data;
+	struct cachefiles_cache *cache = object->volume->cache;
+
+	if (ioctl != CACHEFILES_IOC_READ_COMPLETE)
+		return -EINVAL;
+
+	if (!test_bit(CACHEFILES_ONDEMAND_MODE, &cache->flags))
+		return -EOPNOTSUPP;
+
+	return cachefiles_ondemand_complete_read(cache, object, id, 0);
+}
+
 static const struct file_operations cachefiles_ondemand_fd_fops = {
 	.owner		= THIS_MODULE,
 	.release	= cachefiles_ondemand_fd_release,
@@ -389,7 +411,7 @@ static inline bool cachefiles_ondemand_finish_req(struct cachefiles_req *req,
 		return false;
 
 	req->error = err;
-	complete(&req->done);
+	complete_all(&req->done);
 	return true;
 }
 
@@ -462,6 +484,75 @@ ssize_t cachefiles_ondemand_daemon_read(struct cachefiles_cache *cache,
 	return ret ? ret : n;
 }
 
+/*
+ * Copy as many requests as fit into the daemon's buffer, each aligned to
+ * CACHEFILES_MSG_ALIGN.  Requests that fail to be delivered are completed
+ * with the error by cachefiles_ondemand_daemon_read(), so a partial batch
+ * only has to report what it did copy.
+ */
+static int cachefiles_ondemand_fetch(struct cachefiles_cache *cache,
+				     char __user *buf, size_t len,
+				     unsigned int nr)
+{
+	size_t off = 0;
+	unsigned int i;
+	ssize_t n;
+
+	for (i = 0; !nr || i < nr; i++) {
+		n = cachefiles_ondemand_daemon_read(cache, buf + off, len - off);
+		if (n <= 0) {
+			if (!off)
+				return n;
+			break;
+		}
+		off += ALIGN(n, CACHEFILES_MSG_ALIGN);
+		if (off >= len)
+			break;
+	}
+
+	return min(off, len);
+}
+
+static int cachefiles_ondemand_complete_reads(struct cachefiles_cache *cache,
+				const struct cachefiles_read_done __user *done,
+				unsigned int nr)
+{
+	struct cachefiles_read_done rd;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < nr; i++) {
+		if (copy_from_user(&rd, &done[i], sizeof(rd))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = cachefiles_ondemand_complete_read(cache, NULL, rd.msg_id,
+							rd.error);
+		if (ret)
+			break;
+	}
+
+	return i ? i : ret;
+}
+
+int cachefiles_ondemand_uring_cmd(struct cachefiles_cache *cache,
+				  struct io_uring_cmd *ioucmd)
+{
+	const struct cachefiles_uring_cmd *cmd = io_uring_sqe_cmd(ioucmd->sqe);
+	void __user *buf = u64_to_user_ptr(READ_ONCE(cmd->buf));
+	u32 len = min_t(u32, READ_ONCE(cmd->len), INT_MAX);
+	u32 nr = READ_ONCE(cmd->nr);
+
+	switch (ioucmd->cmd_op) {
+	case CACHEFILES_URING_CMD_FETCH:
+		return cachefiles_ondemand_fetch(cache, buf, len, nr);
+	case CACHEFILES_URING_CMD_READ_COMPLETE:
+		return cachefiles_ondemand_complete_reads(cache, buf, nr);
+	default:
+		return -ENOTTY;
+	}
+}
+
 typedef int (*init_req_fn)(struct cachefiles_req *req, void *private);
 
 static int cachefiles_ondemand_send_req(struct cachefiles_object *object,
@@ -541,6 +632,8 @@ static int cachefiles_ondemand_send_req(struct cachefiles_object *object,
 		xas_store(&xas, req);
 		xas_clear_mark(&xas, XA_FREE_MARK);
 		xas_set_mark(&xas, CACHEFILES_REQ_NEW);
+		if (opcode == CACHEFILES_OP_READ && !xas_error(&xas))
+			object->ondemand->read_req_id = xas.xa_index + 1;
 		xas_unlock(&xas);
 	} while (xas_nomem(&xas, GFP_KERNEL));
 
@@ -694,10 +787,72 @@ void cachefiles_ondemand_deinit_obj_info(struct cachefiles_object *object)
 	object->ondemand = NULL;
 }
 
+/*
+ * Fold a read into the last READ request of the object if the daemon hasn't
+ * picked that up yet and the ranges touch, so that the many small reads of
+ * a lazily loaded image reach the daemon as fewer, larger ones.  Returns the
+ * request with a reference held, or NULL.
+ */
+static struct cachefiles_req *
+cachefiles_ondemand_merge_read(struct cachefiles_object *object,
+			       loff_t pos, size_t len)
+{
+	struct cachefiles_cache *cache = object->volume->cache;
+	unsigned long id = object->ondemand->read_req_id;
+	struct cachefiles_read *load;
+	struct cachefiles_req *req;
+	u64 start, end;
+
+	if (!id--)
+		return NULL;
+
+	xa_lock(&cache->reqs);
+	req = xa_load(&cache->reqs, id);
+	/* Once the mark is gone the daemon may be copying the message */
+	if (!req || req->object != object ||
+	    req->msg.opcode != CACHEFILES_OP_READ ||
+	    !xa_get_mark(&cache->reqs, id, CACHEFILES_REQ_NEW))
+		goto none;
+
+	load = (void *)req->msg.data;
+	if (pos > load->off + load->len || pos + len < load->off)
+		goto none;
+
+	start = min_t(u64, pos, load->off);
+	end = max_t(u64, pos + len, load->off + load->len);
+	if (end - start > CACHEFILES_ONDEMAND_MERGE_MAX)
+		goto none;
+
+	load->off = start;
+	load->len = end - start;
+	refcount_inc(&req->ref);
+	xa_unlock(&cache->reqs);
+	trace_cachefiles_ondemand_read(object, &req->msg, load);
+	return req;
+none:
+	xa_unlock(&cache->reqs);
+	return NULL;
+}
+
 int cachefiles_ondemand_read(struct cachefiles_object *object,
 			     loff_t pos, size_t len)
 {
 	struct cachefiles_read_ctx read_ctx = {pos, len};
+	struct cachefiles_req *req;
+	int ret;
+
+	req = cachefiles_ondemand_merge_read(object, pos, len);
+	if (req) {
+		ret = wait_for_completion_killable(&req->done);
+		if (!ret)
+			ret = req->error;
+		else
+			ret = -EINTR;
+		cachefiles_req_put(req);
+		/* The owner of the request was killed, not us: go on our own */
+		if (ret != -EINTR || fatal_signal_pending(current))
+			return ret;
+	}
 
 	return cachefiles_ondemand_send_req(object, CACHEFILES_OP_READ,
 			sizeof(struct cachefiles_read),
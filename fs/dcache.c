@@ -32,6 +32,8 @@
 #include <linux/bit_spinlock.h>
 #include <linux/rculist_bl.h>
 #include <linux/list_lru.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include "internal.h"
 #include "mount.h"
 
@@ -96,13 +98,61 @@ EXPORT_SYMBOL(dotdot_name);
  * information, yet avoid using a prime hash-size or similar.
  */
 
-static unsigned int d_hash_shift __ro_after_init;
+struct d_hash_table {
+	struct hlist_bl_head	*buckets;
+	unsigned int		shift;
+	/* while growing: buckets below this index have moved to ->future */
+	unsigned int		migrated;
+	struct d_hash_table __rcu *future;
+	bool			boot;		/* from alloc_large_system_hash() */
+};
 
-static struct hlist_bl_head *dentry_hashtable __ro_after_init;
+static struct d_hash_table d_hash_boot = { .boot = true };
+static struct d_hash_table __rcu *dentry_hashtable = RCU_INITIALIZER(&d_hash_boot);
 
+/*
+ * Lookups and hash chain modifications happen under rcu_read_lock() or
+ * ->d_lock, either of which keeps the current table alive.
+ */
 static inline struct hlist_bl_head *d_hash(unsigned int hash)
 {
-	return dentry_hashtable + (hash >> d_hash_shift);
+	struct d_hash_table *t = rcu_dereference_check(dentry_hashtable, 1);
+	struct d_hash_table *f = rcu_dereference_check(t->future, 1);
+	unsigned int i = hash >> t->shift;
+
+	if (unlikely(f) && i < smp_load_acquire(&t->migrated))
+		return f->buckets + (hash >> f->shift);
+	return t->buckets + i;
+}
+
+/*
+ * Lock the chain @hash lives on.  While the table grows that is the old
+ * bucket, and, once it has been migrated, the new one nested inside it.
+ */
+static struct hlist_bl_head *d_hash_lock(unsigned int hash,
+					 struct hlist_bl_head **outer)
+{
+	struct d_hash_table *t = rcu_dereference_check(dentry_hashtable, 1);
+	struct hlist_bl_head *b = t->buckets + (hash >> t->shift);
+	struct d_hash_table *f;
+
+	*outer = NULL;
+	hlist_bl_lock(b);
+	f = rcu_dereference_check(t->future, 1);
+	if (likely(!f) || (hash >> t->shift) >= t->migrated)
+		return b;
+	*outer = b;
+	b = f->buckets + (hash >> f->shift);
+	hlist_bl_lock(b);
+	return b;
+}
+
+static inline void d_hash_unlock(struct hlist_bl_head *b,
+				 struct hlist_bl_head *outer)
+{
+	hlist_bl_unlock(b);
+	if (outer)
+		hlist_bl_unlock(outer);
 }
 
 #define IN_LOOKUP_SHIFT 10
@@ -127,6 +177,17 @@ struct dentry_stat_t {
 static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
 static DEFINE_PER_CPU(long, nr_dentry_negative);
+static DEFINE_PER_CPU(long, nr_dentry_hashed);
+
+static long get_nr_dentry_hashed(void)
+{
+	int i;
+	long sum = 0;
+
+	for_each_possible_cpu(i)
+		sum += per_cpu(nr_dentry_hashed, i);
+	return sum < 0 ? 0 : sum;
+}
 
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 /* Statistics gathering. */
@@ -183,6 +244,28 @@ static int proc_nr_dentry(struct ctl_table *table, int write, void *buffer,
 	return proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
 }
 
+/* "<buckets> <hashed dentries> <average chain length>" */
+static int proc_dentry_hash_state(struct ctl_table *table, int write,
+				  void *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct ctl_table fake_table = { .maxlen = 64 };
+	unsigned long nr_buckets, nr_hashed, avg;
+	struct d_hash_table *t;
+	char buf[64];
+
+	rcu_read_lock();
+	t = rcu_dereference(dentry_hashtable);
+	nr_buckets = 1UL << (32 - t->shift);
+	rcu_read_unlock();
+	nr_hashed = get_nr_dentry_hashed();
+	avg = nr_hashed * 100 / nr_buckets;
+
+	snprintf(buf, sizeof(buf), "%lu\t%lu\t%lu.%02lu", nr_buckets,
+		 nr_hashed, avg / 100, avg % 100);
+	fake_table.data = buf;
+	return proc_dostring(&fake_table, write, buffer, lenp, ppos);
+}
+
 static struct ctl_table fs_dcache_sysctls[] = {
 	{
 		.procname	= "dentry-state",
@@ -191,6 +274,11 @@ static struct ctl_table fs_dcache_sysctls[] = {
 		.mode		= 0444,
 		.proc_handler	= proc_nr_dentry,
 	},
+	{
+		.procname	= "dentry-hash-state",
+		.mode		= 0444,
+		.proc_handler	= proc_dentry_hash_state,
+	},
 };
 
 static int __init init_fs_dcache_sysctls(void)
@@ -486,20 +574,24 @@ static void d_lru_shrink_move(struct list_lru_one *lru, struct dentry *dentry,
 
 static void ___d_drop(struct dentry *dentry)
 {
-	struct hlist_bl_head *b;
+	struct hlist_bl_head *b, *outer;
 	/*
 	 * Hashed dentries are normally on the dentry hashtable,
 	 * with the exception of those newly allocated by
 	 * d_obtain_root, which are always IS_ROOT:
 	 */
-	if (unlikely(IS_ROOT(dentry)))
+	if (unlikely(IS_ROOT(dentry))) {
 		b = &dentry->d_sb->s_roots;
-	else
-		b = d_hash(dentry->d_name.hash);
+		hlist_bl_lock(b);
+		__hlist_bl_del(&dentry->d_hash);
+		hlist_bl_unlock(b);
+		return;
+	}
 
-	hlist_bl_lock(b);
+	b = d_hash_lock(dentry->d_name.hash, &outer);
 	__hlist_bl_del(&dentry->d_hash);
-	hlist_bl_unlock(b);
+	this_cpu_dec(nr_dentry_hashed);
+	d_hash_unlock(b, outer);
 }
 
 void __d_drop(struct dentry *dentry)
@@ -508,6 +600,9 @@ void __d_drop(struct dentry *dentry)
 		___d_drop(dentry);
 		dentry->d_hash.pprev = NULL;
 		write_seqcount_invalidate(&dentry->d_seq);
+		/* it may be freed after this, stop trusting walk cache entries */
+		if (unlikely(dentry->d_flags & DCACHE_WALK_CACHED))
+			atomic_inc(&dentry->d_sb->s_walk_gen);
 	}
 }
 EXPORT_SYMBOL(__d_drop);
@@ -2277,7 +2372,7 @@ EXPORT_SYMBOL(d_lookup);
 struct dentry *__d_lookup(const struct dentry *parent, const struct qstr *name)
 {
 	unsigned int hash = name->hash;
-	struct hlist_bl_head *b = d_hash(hash);
+	struct hlist_bl_head *b;
 	struct hlist_bl_node *node;
 	struct dentry *found = NULL;
 	struct dentry *dentry;
@@ -2303,7 +2398,7 @@ struct dentry *__d_lookup(const struct dentry *parent, const struct qstr *name)
 	 * See Documentation/filesystems/path-lookup.txt for more details.
 	 */
 	rcu_read_lock();
-	
+	b = d_hash(hash);
 	hlist_bl_for_each_entry_rcu(dentry, node, b, d_hash) {
 
 		if (dentry->d_name.hash != hash)
@@ -2397,11 +2492,12 @@ EXPORT_SYMBOL(d_delete);
 
 static void __d_rehash(struct dentry *entry)
 {
-	struct hlist_bl_head *b = d_hash(entry->d_name.hash);
+	struct hlist_bl_head *b, *outer;
 
-	hlist_bl_lock(b);
+	b = d_hash_lock(entry->d_name.hash, &outer);
 	hlist_bl_add_head_rcu(&entry->d_hash, b);
-	hlist_bl_unlock(b);
+	this_cpu_inc(nr_dentry_hashed);
+	d_hash_unlock(b, outer);
 }
 
 /**
@@ -3100,6 +3196,98 @@ void d_tmpfile(struct file *file, struct inode *inode)
 }
 EXPORT_SYMBOL(d_tmpfile);
 
+/*
+ * Grow the hash table once the hashed dentries outnumber its buckets by
+ * D_HASH_GROW_LOAD.  Buckets are migrated in batches under rename_lock,
+ * the same way d_move() moves dentries between chains, so the lookups that
+ * can't live with a false negative (d_lookup(), d_alloc_parallel()) retry.
+ */
+#define D_HASH_GROW_LOAD	2
+#define D_HASH_MAX_BITS		31
+#define D_HASH_MIGRATE_BATCH	1024
+#define D_HASH_CHECK_INTERVAL	(10 * HZ)
+
+static void d_hash_resize_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(d_hash_resize_work, d_hash_resize_fn);
+
+static void d_hash_migrate(struct d_hash_table *t, struct d_hash_table *f)
+{
+	unsigned int nr = 1U << (32 - t->shift);
+	unsigned int i = 0;
+
+	while (i < nr) {
+		unsigned int end = min(i + D_HASH_MIGRATE_BATCH, nr);
+
+		write_seqlock(&rename_lock);
+		for (; i < end; i++) {
+			struct hlist_bl_head *b = t->buckets + i;
+			struct hlist_bl_node *node;
+
+			hlist_bl_lock(b);
+			while ((node = hlist_bl_first(b)) != NULL) {
+				struct dentry *dentry;
+				struct hlist_bl_head *nb;
+
+				dentry = hlist_bl_entry(node, struct dentry, d_hash);
+				nb = f->buckets + (dentry->d_name.hash >> f->shift);
+				__hlist_bl_del(node);
+				hlist_bl_lock(nb);
+				hlist_bl_add_head_rcu(node, nb);
+				hlist_bl_unlock(nb);
+			}
+			smp_store_release(&t->migrated, i + 1);
+			hlist_bl_unlock(b);
+		}
+		write_sequnlock(&rename_lock);
+		cond_resched();
+	}
+}
+
+static void d_hash_resize_fn(struct work_struct *work)
+{
+	struct d_hash_table *t = rcu_dereference_protected(dentry_hashtable, 1);
+	unsigned long nr_hashed = get_nr_dentry_hashed();
+	unsigned int bits = 32 - t->shift;
+	struct d_hash_table *f;
+
+	if (bits >= D_HASH_MAX_BITS ||
+	    nr_hashed <= ((unsigned long)D_HASH_GROW_LOAD << bits))
+		goto out;
+
+	f = kzalloc(sizeof(*f), GFP_KERNEL);
+	if (!f)
+		goto out;
+	bits = min_t(unsigned int, order_base_2(nr_hashed), D_HASH_MAX_BITS);
+	f->buckets = vmalloc_huge(sizeof(struct hlist_bl_head) << bits,
+				  GFP_KERNEL | __GFP_ZERO | __GFP_NOWARN);
+	if (!f->buckets) {
+		kfree(f);
+		goto out;
+	}
+	f->shift = 32 - bits;
+
+	rcu_assign_pointer(t->future, f);
+	d_hash_migrate(t, f);
+	rcu_assign_pointer(dentry_hashtable, f);
+	synchronize_rcu();
+	pr_info("Dentry cache hash table grown to %u entries\n", 1U << bits);
+	if (!t->boot) {
+		vfree(t->buckets);
+		kfree(t);
+	}
+out:
+	queue_delayed_work(system_unbound_wq, &d_hash_resize_work,
+			   D_HASH_CHECK_INTERVAL);
+}
+
+static int __init d_hash_resize_init(void)
+{
+	queue_delayed_work(system_unbound_wq, &d_hash_resize_work,
+			   D_HASH_CHECK_INTERVAL);
+	return 0;
+}
+late_initcall(d_hash_resize_init);
+
 static __initdata unsigned long dhash_entries;
 static int __init set_dhash_entries(char *str)
 {
@@ -3118,17 +3306,17 @@ static void __init dcache_init_early(void)
 	if (hashdist)
 		return;
 
-	dentry_hashtable =
+	d_hash_boot.buckets =
 		alloc_large_system_hash("Dentry cache",
 					sizeof(struct hlist_bl_head),
 					dhash_entries,
 					13,
 					HASH_EARLY | HASH_ZERO,
-					&d_hash_shift,
+					&d_hash_boot.shift,
 					NULL,
 					0,
 					0);
-	d_hash_shift = 32 - d_hash_shift;
+	d_hash_boot.shift = 32 - d_hash_boot.shift;
 }
 
 static void __init dcache_init(void)
@@ -3146,17 +3334,17 @@ static void __init dcache_init(void)
 	if (!hashdist)
 		return;
 
-	dentry_hashtable =
+	d_hash_boot.buckets =
 		alloc_large_system_hash("Dentry cache",
 					sizeof(struct hlist_bl_head),
 					dhash_entries,
 					13,
 					HASH_ZERO,
-					&d_hash_shift,
+					&d_hash_boot.shift,
 					NULL,
 					0,
 					0);
-	d_hash_shift = 32 - d_hash_shift;
+	d_hash_boot.shift = 32 - d_hash_boot.shift;
 }
 
 /* SLAB cache for __getname() consumers */
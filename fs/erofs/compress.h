@@ -98,4 +98,18 @@ int z_erofs_deflate_decompress(struct z_erofs_decompress_req *rq,
 			       struct page **pagepool);
 int z_erofs_zstd_decompress(struct z_erofs_decompress_req *rq,
 			    struct page **pgpl);
+
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+void z_erofs_crypto_setup(struct super_block *sb, unsigned int alg);
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl);
+#else
+static inline void z_erofs_crypto_setup(struct super_block *sb,
+					unsigned int alg) {}
+static inline int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+					    struct page **pgpl)
+{
+	return -EOPNOTSUPP;
+}
+#endif
 #endif
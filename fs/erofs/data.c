@@ -394,6 +394,9 @@ static ssize_t erofs_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 		return iomap_dio_rw(iocb, to, &erofs_iomap_ops,
 				    NULL, 0, NULL, 0);
 	}
+	if (erofs_is_fscache_mode(inode->i_sb) &&
+	    test_opt(&EROFS_I_SB(inode)->opt, SHARE_CACHE))
+		return erofs_fscache_share_read_iter(iocb, to);
 	return filemap_read(iocb, to, 0);
 }
 
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <linux/scatterlist.h>
+#include <crypto/acompress.h>
+#include "compress.h"
+
+struct z_erofs_crypto {
+	char driver[CRYPTO_MAX_ALG_NAME];
+	struct crypto_acomp *tfm;
+};
+
+static struct z_erofs_crypto z_erofs_crypto[Z_EROFS_COMPRESSION_MAX];
+static DEFINE_MUTEX(z_erofs_crypto_mutex);
+
+module_param_string(deflate_accel,
+		    z_erofs_crypto[Z_EROFS_COMPRESSION_DEFLATE].driver,
+		    CRYPTO_MAX_ALG_NAME, 0444);
+module_param_string(zstd_accel,
+		    z_erofs_crypto[Z_EROFS_COMPRESSION_ZSTD].driver,
+		    CRYPTO_MAX_ALG_NAME, 0444);
+
+void z_erofs_crypto_exit(void)
+{
+	int i;
+
+	for (i = 0; i < Z_EROFS_COMPRESSION_MAX; ++i) {
+		if (z_erofs_crypto[i].tfm)
+			crypto_free_acomp(z_erofs_crypto[i].tfm);
+		z_erofs_crypto[i].tfm = NULL;
+	}
+}
+
+/* bind the acomp driver configured for @alg, if any, on first use */
+void z_erofs_crypto_setup(struct super_block *sb, unsigned int alg)
+{
+	struct z_erofs_crypto *c = &z_erofs_crypto[alg];
+	struct crypto_acomp *tfm;
+
+	if (!c->driver[0] || READ_ONCE(c->tfm))
+		return;
+
+	mutex_lock(&z_erofs_crypto_mutex);
+	if (!c->tfm) {
+		tfm = crypto_alloc_acomp(c->driver, 0, 0);
+		if (IS_ERR(tfm)) {
+			erofs_err(sb, "failed to allocate acomp %s: %ld, using software %s",
+				  c->driver, PTR_ERR(tfm),
+				  erofs_decompressors[alg].name);
+			c->driver[0] = '\0';
+		} else {
+			erofs_info(sb, "using acomp %s for %s",
+				   crypto_tfm_alg_driver_name(crypto_acomp_tfm(tfm)),
+				   erofs_decompressors[alg].name);
+			WRITE_ONCE(c->tfm, tfm);
+		}
+	}
+	mutex_unlock(&z_erofs_crypto_mutex);
+}
+
+static int __z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+				       struct crypto_acomp *tfm,
+				       unsigned int nrpages_in,
+				       unsigned int nrpages_out)
+{
+	struct sg_table st_src, st_dst;
+	struct acomp_req *req;
+	DECLARE_CRYPTO_WAIT(wait);
+	int err;
+
+	req = acomp_request_alloc(tfm);
+	if (!req)
+		return -ENOMEM;
+
+	err = sg_alloc_table_from_pages_segment(&st_src, rq->in, nrpages_in,
+			rq->pageofs_in, rq->inputsize, UINT_MAX, rq->gfp);
+	if (err)
+		goto failed_src;
+	err = sg_alloc_table_from_pages_segment(&st_dst, rq->out, nrpages_out,
+			rq->pageofs_out, rq->outputsize, UINT_MAX, rq->gfp);
+	if (err)
+		goto failed_dst;
+
+	acomp_request_set_params(req, st_src.sgl, st_dst.sgl,
+				 rq->inputsize, rq->outputsize);
+	/*
+	 * No CRYPTO_TFM_REQ_MAY_BACKLOG: if the accelerator queue is full the
+	 * request is rejected with -EBUSY and software decompression is used
+	 * instead of waiting for the device.
+	 */
+	acomp_request_set_callback(req, 0, crypto_req_done, &wait);
+	err = crypto_acomp_decompress(req);
+	if (err != -EBUSY)
+		err = crypto_wait_req(err, &wait);
+	if (!err && req->dlen != rq->outputsize)
+		err = -EIO;
+
+	sg_free_table(&st_dst);
+failed_dst:
+	sg_free_table(&st_src);
+failed_src:
+	acomp_request_free(req);
+	return err;
+}
+
+/*
+ * Try to decompress @rq with the configured acomp driver.  Returns
+ * -EOPNOTSUPP if the caller should fall back to software decompression.
+ */
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl)
+{
+	const unsigned int nrpages_out =
+		PAGE_ALIGN(rq->pageofs_out + rq->outputsize) >> PAGE_SHIFT;
+	struct crypto_acomp *tfm = READ_ONCE(z_erofs_crypto[rq->alg].tfm);
+	unsigned int nrpages_in, i, j;
+	u8 *kin;
+	int err;
+
+	/* partial decoding needs a stream which can stop at outputsize */
+	if (!tfm || rq->partial_decoding)
+		return -EOPNOTSUPP;
+
+	kin = kmap_local_page(*rq->in);
+	err = z_erofs_fixup_insize(rq, kin + rq->pageofs_in,
+			min_t(unsigned int, rq->inputsize,
+			      rq->sb->s_blocksize - rq->pageofs_in));
+	kunmap_local(kin);
+	if (err)
+		return err;
+	nrpages_in = PAGE_ALIGN(rq->pageofs_in + rq->inputsize) >> PAGE_SHIFT;
+
+	for (i = 0; i < nrpages_out; ++i) {
+		if (rq->out[i])
+			continue;
+		rq->out[i] = erofs_allocpage(pgpl, rq->gfp);
+		if (!rq->out[i])
+			return -ENOMEM;
+		set_page_private(rq->out[i], Z_EROFS_SHORTLIVED_PAGE);
+	}
+
+	/* the device reads and writes concurrently, so don't decompress inplace */
+	for (j = 0; j < nrpages_in; ++j) {
+		struct page *tmppage;
+
+		for (i = 0; i < nrpages_out; ++i)
+			if (rq->out[i] == rq->in[j])
+				break;
+		if (i >= nrpages_out)
+			continue;
+		tmppage = erofs_allocpage(pgpl, rq->gfp);
+		if (!tmppage)
+			return -ENOMEM;
+		set_page_private(tmppage, Z_EROFS_SHORTLIVED_PAGE);
+		copy_highpage(tmppage, rq->in[j]);
+		rq->in[j] = tmppage;
+	}
+
+	err = __z_erofs_crypto_decompress(rq, tfm, nrpages_in, nrpages_out);
+	if (err == -ENOMEM)
+		return err;
+	/* let the software decompressor retry and report corrupted data */
+	return err ? -EOPNOTSUPP : 0;
+}
@@ -89,6 +89,7 @@ int z_erofs_load_deflate_config(struct super_block *sb,
 		inited = true;
 	}
 	mutex_unlock(&deflate_resize_mutex);
+	z_erofs_crypto_setup(sb, Z_EROFS_COMPRESSION_DEFLATE);
 	erofs_info(sb, "EXPERIMENTAL DEFLATE feature in use. Use at your own risk!");
 	return 0;
 failed:
@@ -111,6 +112,10 @@ int z_erofs_deflate_decompress(struct z_erofs_decompress_req *rq,
 	bool bounced = false;
 	int no = -1, ni = 0, j = 0, zerr, err;
 
+	err = z_erofs_crypto_decompress(rq, pgpl);
+	if (err != -EOPNOTSUPP)
+		return err;
+
 	/* 1. get the exact DEFLATE compressed size */
 	kin = kmap_local_page(*rq->in);
 	err = z_erofs_fixup_insize(rq, kin + rq->pageofs_in,
@@ -94,6 +94,7 @@ int z_erofs_load_zstd_config(struct super_block *sb,
 
 	/* in case 2 z_erofs_load_zstd_config() race to avoid deadlock */
 	mutex_lock(&zstd_resize_mutex);
+	z_erofs_crypto_setup(sb, Z_EROFS_COMPRESSION_ZSTD);
 	if (z_erofs_zstd_max_dictsize >= dict_size) {
 		mutex_unlock(&zstd_resize_mutex);
 		return 0;
@@ -152,6 +153,10 @@ int z_erofs_zstd_decompress(struct z_erofs_decompress_req *rq,
 	bool bounced = false;
 	int no = -1, ni = 0, j = 0, zerr, err;
 
+	err = z_erofs_crypto_decompress(rq, pgpl);
+	if (err != -EOPNOTSUPP)
+		return err;
+
 	/* 1. get the exact compressed size */
 	kin = kmap_local_page(*rq->in);
 	err = z_erofs_fixup_insize(rq, kin + rq->pageofs_in,
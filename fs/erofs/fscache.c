@@ -373,6 +373,105 @@ static void erofs_fscache_readahead(struct readahead_control *rac)
 	erofs_fscache_req_put(req);
 }
 
+static size_t erofs_fscache_share_copy(struct erofs_map_dev *mdev,
+				       size_t count, struct iov_iter *to,
+				       int *err)
+{
+	struct address_space *mapping = mdev->m_fscache->inode->i_mapping;
+	erofs_off_t pa = mdev->m_pa;
+	size_t done = 0;
+
+	while (done < count) {
+		struct folio *folio;
+		size_t ofs, len, copied;
+
+		folio = read_mapping_folio(mapping, pa >> PAGE_SHIFT, NULL);
+		if (IS_ERR(folio)) {
+			*err = PTR_ERR(folio);
+			break;
+		}
+		ofs = offset_in_folio(folio, pa);
+		len = min_t(size_t, folio_size(folio) - ofs, count - done);
+		copied = copy_folio_to_iter(folio, ofs, len, to);
+		folio_put(folio);
+		done += copied;
+		pa += copied;
+		if (copied < len) {
+			*err = -EFAULT;
+			break;
+		}
+	}
+	return done;
+}
+
+/*
+ * With share_cache, file data is read through the page cache of the blob
+ * inodes instead of the file's own mapping.  Blobs are named by their digest
+ * and their inodes live in the pseudo mount shared by the whole domain, so
+ * chunks which several images reference from the same blob are only cached
+ * once.
+ */
+ssize_t erofs_fscache_share_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct inode *inode = file_inode(iocb->ki_filp);
+	struct super_block *sb = inode->i_sb;
+	const loff_t isize = i_size_read(inode);
+	ssize_t done = 0;
+	int err = 0;
+
+	while (iov_iter_count(to) && iocb->ki_pos < isize) {
+		struct erofs_map_blocks map = { .m_la = iocb->ki_pos };
+		loff_t pos = iocb->ki_pos;
+		size_t count, copied;
+
+		err = erofs_map_blocks(inode, &map);
+		if (err)
+			break;
+		count = min_t(loff_t, iov_iter_count(to), isize - pos);
+		count = min_t(loff_t, count, map.m_la + map.m_llen - pos);
+		if (!count) {
+			err = -EFSCORRUPTED;
+			break;
+		}
+
+		if (map.m_flags & EROFS_MAP_META) {
+			struct erofs_buf buf = __EROFS_BUF_INITIALIZER;
+			void *src;
+
+			src = erofs_read_metabuf(&buf, sb, map.m_pa, EROFS_KMAP);
+			if (IS_ERR(src)) {
+				err = PTR_ERR(src);
+				break;
+			}
+			copied = copy_to_iter(src + (pos - map.m_la), count, to);
+			erofs_put_metabuf(&buf);
+		} else if (!(map.m_flags & EROFS_MAP_MAPPED)) {
+			copied = iov_iter_zero(count, to);
+		} else {
+			struct erofs_map_dev mdev = {
+				.m_deviceid = map.m_deviceid,
+				.m_pa = map.m_pa,
+			};
+
+			err = erofs_map_dev(sb, &mdev);
+			if (err)
+				break;
+			mdev.m_pa += pos - map.m_la;
+			copied = erofs_fscache_share_copy(&mdev, count, to, &err);
+		}
+		iocb->ki_pos += copied;
+		done += copied;
+		if (copied < count) {
+			if (!err)
+				err = -EFAULT;
+			break;
+		}
+		cond_resched();
+	}
+	file_accessed(iocb->ki_filp);
+	return done ? done : err;
+}
+
 static const struct address_space_operations erofs_fscache_meta_aops = {
 	.read_folio = erofs_fscache_meta_read_folio,
 };
@@ -185,6 +185,7 @@ struct erofs_sb_info {
 #define EROFS_MOUNT_POSIX_ACL		0x00000020
 #define EROFS_MOUNT_DAX_ALWAYS		0x00000040
 #define EROFS_MOUNT_DAX_NEVER		0x00000080
+#define EROFS_MOUNT_SHARE_CACHE		0x00000100
 
 #define clear_opt(opt, option)	((opt)->mount_opt &= ~EROFS_MOUNT_##option)
 #define set_opt(opt, option)	((opt)->mount_opt |= EROFS_MOUNT_##option)
@@ -507,6 +508,12 @@ static inline int z_erofs_zstd_init(void) { return 0; }
 static inline int z_erofs_zstd_exit(void) { return 0; }
 #endif	/* !CONFIG_EROFS_FS_ZIP_ZSTD */
 
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+void z_erofs_crypto_exit(void);
+#else
+static inline void z_erofs_crypto_exit(void) {}
+#endif	/* !CONFIG_EROFS_FS_ZIP_ACCEL */
+
 #ifdef CONFIG_EROFS_FS_ONDEMAND
 int erofs_fscache_register_fs(struct super_block *sb);
 void erofs_fscache_unregister_fs(struct super_block *sb);
@@ -516,6 +523,7 @@ struct erofs_fscache *erofs_fscache_register_cookie(struct super_block *sb,
 void erofs_fscache_unregister_cookie(struct erofs_fscache *fscache);
 struct bio *erofs_fscache_bio_alloc(struct erofs_map_dev *mdev);
 void erofs_fscache_submit_bio(struct bio *bio);
+ssize_t erofs_fscache_share_read_iter(struct kiocb *iocb, struct iov_iter *to);
 #else
 static inline int erofs_fscache_register_fs(struct super_block *sb)
 {
@@ -535,6 +543,11 @@ static inline void erofs_fscache_unregister_cookie(struct erofs_fscache *fscache
 }
 static inline struct bio *erofs_fscache_bio_alloc(struct erofs_map_dev *mdev) { return NULL; }
 static inline void erofs_fscache_submit_bio(struct bio *bio) {}
+static inline ssize_t erofs_fscache_share_read_iter(struct kiocb *iocb,
+						    struct iov_iter *to)
+{
+	return -EOPNOTSUPP;
+}
 #endif
 
 #define EFSCORRUPTED    EUCLEAN         /* Filesystem is corrupted */
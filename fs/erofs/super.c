@@ -392,6 +392,7 @@ enum {
 	Opt_device,
 	Opt_fsid,
 	Opt_domain_id,
+	Opt_share_cache,
 	Opt_err
 };
 
@@ -418,6 +419,7 @@ static const struct fs_parameter_spec erofs_fs_parameters[] = {
 	fsparam_string("device",	Opt_device),
 	fsparam_string("fsid",		Opt_fsid),
 	fsparam_string("domain_id",	Opt_domain_id),
+	fsparam_flag("share_cache",	Opt_share_cache),
 	{}
 };
 
@@ -525,9 +527,13 @@ static int erofs_fc_parse_param(struct fs_context *fc,
 		if (!sbi->domain_id)
 			return -ENOMEM;
 		break;
+	case Opt_share_cache:
+		set_opt(&sbi->opt, SHARE_CACHE);
+		break;
 #else
 	case Opt_fsid:
 	case Opt_domain_id:
+	case Opt_share_cache:
 		errorfc(fc, "%s option not supported", erofs_fs_parameters[opt].name);
 		break;
 #endif
@@ -596,6 +602,11 @@ static int erofs_fc_fill_super(struct super_block *sb, struct fs_context *fc)
 		if (err)
 			return err;
 
+		if (test_opt(&sbi->opt, SHARE_CACHE) && !sbi->domain_id) {
+			erofs_info(sb, "share_cache needs a shared domain_id, ignored");
+			clear_opt(&sbi->opt, SHARE_CACHE);
+		}
+
 		err = super_setup_bdi(sb);
 		if (err)
 			return err;
@@ -907,6 +918,7 @@ static void __exit erofs_module_exit(void)
 
 	erofs_exit_sysfs();
 	z_erofs_exit_zip_subsystem();
+	z_erofs_crypto_exit();
 	z_erofs_zstd_exit();
 	z_erofs_deflate_exit();
 	z_erofs_lzma_exit();
@@ -958,6 +970,8 @@ static int erofs_show_options(struct seq_file *seq, struct dentry *root)
 		seq_printf(seq, ",fsid=%s", sbi->fsid);
 	if (sbi->domain_id)
 		seq_printf(seq, ",domain_id=%s", sbi->domain_id);
+	if (test_opt(opt, SHARE_CACHE))
+		seq_puts(seq, ",share_cache");
 #endif
 	return 0;
 }
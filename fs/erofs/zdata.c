@@ -1325,6 +1325,16 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 	return err;
 }
 
+static void z_erofs_decompress_one(struct z_erofs_decompress_backend *be,
+				   bool eio)
+{
+	z_erofs_decompress_pcluster(be, eio ? -EIO : 0);
+	if (z_erofs_is_inline_pcluster(be->pcl))
+		z_erofs_free_pcluster(be->pcl);
+	else
+		erofs_workgroup_put(&be->pcl->obj);
+}
+
 static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 				     struct page **pagepool)
 {
@@ -1341,15 +1351,130 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 
 		be.pcl = container_of(owned, struct z_erofs_pcluster, next);
 		owned = READ_ONCE(be.pcl->next);
+		z_erofs_decompress_one(&be, io->eio);
+	}
+}
 
-		z_erofs_decompress_pcluster(&be, io->eio ? -EIO : 0);
-		if (z_erofs_is_inline_pcluster(be.pcl))
-			z_erofs_free_pcluster(be.pcl);
-		else
-			erofs_workgroup_put(&be.pcl->obj);
+#ifdef CONFIG_EROFS_FS_PCPU_KTHREAD
+/* pclusters per helper worker when splitting a background queue */
+#define Z_EROFS_SPLIT_BATCH		4
+#define Z_EROFS_SPLIT_MAX_HELPERS	16
+
+struct z_erofs_split_helper {
+	struct kthread_work work;
+	struct z_erofs_decompress_split *split;
+};
+
+/*
+ * A background queue shared by the worker which received it and some idle
+ * per-CPU workers. Everyone pops pclusters from the same chain, so faster
+ * workers simply take more of them.
+ */
+struct z_erofs_decompress_split {
+	spinlock_t lock;
+	z_erofs_next_pcluster_t head;
+	struct super_block *sb;
+	refcount_t ref;
+	bool eio;
+	struct z_erofs_split_helper helpers[];
+};
+
+static struct z_erofs_pcluster *
+z_erofs_split_pop(struct z_erofs_decompress_split *split)
+{
+	struct z_erofs_pcluster *pcl = NULL;
+
+	spin_lock(&split->lock);
+	if (split->head != Z_EROFS_PCLUSTER_TAIL) {
+		DBG_BUGON(split->head == Z_EROFS_PCLUSTER_NIL);
+		pcl = container_of(split->head, struct z_erofs_pcluster, next);
+		split->head = READ_ONCE(pcl->next);
 	}
+	spin_unlock(&split->lock);
+	return pcl;
 }
 
+static void z_erofs_split_run(struct z_erofs_decompress_split *split)
+{
+	struct page *pagepool = NULL;
+	struct z_erofs_decompress_backend be = {
+		.sb = split->sb,
+		.pagepool = &pagepool,
+		.decompressed_secondary_bvecs =
+			LIST_HEAD_INIT(be.decompressed_secondary_bvecs),
+	};
+
+	while ((be.pcl = z_erofs_split_pop(split)))
+		z_erofs_decompress_one(&be, split->eio);
+	erofs_release_pages(&pagepool);
+	if (refcount_dec_and_test(&split->ref))
+		kfree(split);
+}
+
+static void z_erofs_split_work(struct kthread_work *work)
+{
+	z_erofs_split_run(container_of(work, struct z_erofs_split_helper,
+				       work)->split);
+}
+
+/* share a long background queue with other per-CPU workers */
+static bool z_erofs_decompress_split(struct z_erofs_decompressqueue *io)
+{
+	unsigned int nr = 0, nr_helpers, queued = 0, this_cpu, cpu;
+	struct z_erofs_decompress_split *split;
+	struct kthread_worker *worker;
+	z_erofs_next_pcluster_t owned;
+
+	nr_helpers = min(num_online_cpus() - 1, Z_EROFS_SPLIT_MAX_HELPERS);
+	for (owned = io->head; owned != Z_EROFS_PCLUSTER_TAIL &&
+	     nr < (nr_helpers + 1) * Z_EROFS_SPLIT_BATCH; ++nr)
+		owned = READ_ONCE(container_of(owned, struct z_erofs_pcluster,
+					       next)->next);
+	if (nr < 2 * Z_EROFS_SPLIT_BATCH)
+		return false;
+	nr_helpers = min(nr_helpers, nr / Z_EROFS_SPLIT_BATCH - 1);
+
+	/* don't recurse into reclaim from the decompression worker */
+	split = kmalloc(struct_size(split, helpers, nr_helpers),
+			GFP_NOWAIT | __GFP_NOWARN);
+	if (!split)
+		return false;
+	spin_lock_init(&split->lock);
+	split->head = io->head;
+	split->sb = io->sb;
+	split->eio = io->eio;
+	refcount_set(&split->ref, 1);
+
+	rcu_read_lock();
+	this_cpu = raw_smp_processor_id();
+	for_each_cpu_wrap(cpu, cpu_online_mask, this_cpu + 1) {
+		struct z_erofs_split_helper *h;
+
+		if (queued >= nr_helpers)
+			break;
+		if (cpu == this_cpu)
+			continue;
+		worker = rcu_dereference(z_erofs_pcpu_workers[cpu]);
+		if (!worker)
+			continue;
+		h = &split->helpers[queued++];
+		h->split = split;
+		kthread_init_work(&h->work, z_erofs_split_work);
+		refcount_inc(&split->ref);
+		kthread_queue_work(worker, &h->work);
+	}
+	rcu_read_unlock();
+
+	z_erofs_split_run(split);
+	return true;
+}
+#else
+static inline bool z_erofs_decompress_split(struct z_erofs_decompressqueue *io)
+{
+	return false;
+}
+#endif
+
 static void z_erofs_decompressqueue_work(struct work_struct *work)
 {
 	struct z_erofs_decompressqueue *bgq =
@@ -1357,8 +1482,10 @@ static void z_erofs_decompressqueue_work(struct work_struct *work)
 	struct page *pagepool = NULL;
 
 	DBG_BUGON(bgq->head == Z_EROFS_PCLUSTER_TAIL);
-	z_erofs_decompress_queue(bgq, &pagepool);
-	erofs_release_pages(&pagepool);
+	if (!z_erofs_decompress_split(bgq)) {
+		z_erofs_decompress_queue(bgq, &pagepool);
+		erofs_release_pages(&pagepool);
+	}
 	kvfree(bgq);
 }
 
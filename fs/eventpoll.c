@@ -46,9 +46,13 @@
  *
  * 1) epnested_mutex (mutex)
  * 2) ep->mtx (mutex)
- * 3) ep->lock (rwlock)
+ * 3) shard->mtx (mutex, EPOLL_SHARDED only)
+ * 4) shard->lock (rwlock)
  *
- * The acquire order is the one listed above, from 1 to 3.
+ * The acquire order is the one listed above, from 1 to 4.
+ * Every eventpoll has at least one "struct ep_shard" holding a ready list
+ * and the lock protecting it, "ep->lock" below refers to the lock of the
+ * shard an item belongs to.
  * We need a rwlock (ep->lock) because we manipulate objects
  * from inside the poll callback, that might be triggered from
  * a wake_up() that in turn might be called from IRQ context.
@@ -80,6 +84,12 @@
  * Events that require holding "epnested_mutex" are very rare, while for
  * normal operations the epoll private "ep->mtx" will guarantee
  * a better scalability.
+ * With EPOLL_SHARDED the ready list is split into per-CPU shards and
+ * the event transfer loop only takes the "shard->mtx" of the shard it
+ * harvests, so that waiters on different CPUs don't serialize on "ep->mtx".
+ * To keep items stable against the transfer loop, epoll_ctl() and
+ * eventpoll_release_file() take the item's "shard->mtx" as well, nested
+ * inside "ep->mtx".
  */
 
 /* Epoll private bits inside the event mask */
@@ -93,6 +103,9 @@
 /* Maximum number of nesting allowed inside epoll sets */
 #define EP_MAX_NESTS 4
 
+/* Maximum number of ready list shards of an EPOLL_SHARDED instance */
+#define EP_MAX_SHARDS 64
+
 #define EP_MAX_EVENTS (INT_MAX / sizeof(struct epoll_event))
 
 #define EP_UNACTIVE_PTR ((void *) -1L)
@@ -155,6 +168,9 @@ struct epitem {
 	 */
 	bool dying;
 
+	/* Index of the ready list shard this item is queued on */
+	u16 shard;
+
 	/* List containing poll wait queues */
 	struct eppoll_entry *pwqlist;
 
@@ -171,6 +187,32 @@ struct epitem {
 	struct epoll_event event;
 };
 
+/*
+ * A ready list together with its lock. An eventpoll has a single one unless
+ * it was created with EPOLL_SHARDED, in which case items are spread over
+ * per-CPU shards based on the CPU that added them.
+ */
+struct ep_shard {
+	/* Lock which protects rdllist and ovflist */
+	rwlock_t lock;
+
+	/* List of ready file descriptors */
+	struct list_head rdllist;
+
+	/*
+	 * This is a single linked list that chains all the "struct epitem" that
+	 * happened while transferring ready events to userspace w/out
+	 * holding ->lock.
+	 */
+	struct epitem *ovflist;
+
+	/*
+	 * EPOLL_SHARDED only, held during the event collection loop of this
+	 * shard instead of "struct eventpoll"->mtx.
+	 */
+	struct mutex mtx;
+} ____cacheline_aligned_in_smp;
+
 /*
  * This structure is stored inside the "private_data" member of the file
  * structure and represents the main data structure for the eventpoll
@@ -191,22 +233,13 @@ struct eventpoll {
 	/* Wait queue used by file->poll() */
 	wait_queue_head_t poll_wait;
 
-	/* List of ready file descriptors */
-	struct list_head rdllist;
-
-	/* Lock which protects rdllist and ovflist */
-	rwlock_t lock;
+	/* Ready lists, more than one only for EPOLL_SHARDED */
+	struct ep_shard *shards;
+	unsigned int nr_shards;
 
 	/* RB tree root used to store monitored fd structs */
 	struct rb_root_cached rbr;
 
-	/*
-	 * This is a single linked list that chains all the "struct epitem" that
-	 * happened while transferring ready events to userspace w/out
-	 * holding ->lock.
-	 */
-	struct epitem *ovflist;
-
 	/* wakeup_source used when ep_send_events or __ep_eventpoll_poll is running */
 	struct wakeup_source *ws;
 
@@ -378,6 +411,39 @@ static inline struct epitem *ep_item_from_wait(wait_queue_entry_t *p)
 	return container_of(p, struct eppoll_entry, wait)->base;
 }
 
+static inline bool ep_is_sharded(struct eventpoll *ep)
+{
+	return ep->nr_shards > 1;
+}
+
+static inline struct ep_shard *ep_item_shard(struct epitem *epi)
+{
+	return &epi->ep->shards[epi->shard];
+}
+
+/* The shard new items are added to and waiters harvest first */
+static inline unsigned int ep_local_shard(struct eventpoll *ep)
+{
+	return raw_smp_processor_id() % ep->nr_shards;
+}
+
+/*
+ * Sharded waiters don't add themselves to ep->wq under the shard locks, see
+ * ep_poll(), so we need a barrier to pair with the one on the waiter side.
+ */
+static inline bool ep_wq_active(struct eventpoll *ep)
+{
+	if (ep_is_sharded(ep))
+		return wq_has_sleeper(&ep->wq);
+	return waitqueue_active(&ep->wq);
+}
+
+static inline bool ep_shard_events_available(struct ep_shard *sh)
+{
+	return !list_empty_careful(&sh->rdllist) ||
+		READ_ONCE(sh->ovflist) != EP_UNACTIVE_PTR;
+}
+
 /**
  * ep_events_available - Checks if ready events might be available.
  *
@@ -388,8 +454,13 @@ static inline struct epitem *ep_item_from_wait(wait_queue_entry_t *p)
  */
 static inline int ep_events_available(struct eventpoll *ep)
 {
-	return !list_empty_careful(&ep->rdllist) ||
-		READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR;
+	unsigned int i;
+
+	for (i = 0; i < ep->nr_shards; i++) {
+		if (ep_shard_events_available(&ep->shards[i]))
+			return 1;
+	}
+	return 0;
 }
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
@@ -420,7 +491,7 @@ static bool busy_loop_ep_timeout(unsigned long start_time,
 
 static bool ep_busy_loop_on(struct eventpoll *ep)
 {
-	return !!ep->busy_poll_usecs || net_busy_loop_on();
+	return !!READ_ONCE(ep->busy_poll_usecs) || net_busy_loop_on();
 }
 
 static bool ep_busy_loop_end(void *p, unsigned long start_time)
@@ -455,7 +526,7 @@ static bool ep_busy_loop(struct eventpoll *ep, int nonblock)
 		 * it back in when we have moved a socket with a valid NAPI
 		 * ID onto the ready list.
 		 */
-		ep->napi_id = 0;
+		WRITE_ONCE(ep->napi_id, 0);
 		return false;
 	}
 	return false;
@@ -488,11 +559,14 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 	 *	or
 	 * Nothing to do if we already have this ID
 	 */
-	if (napi_id < MIN_NAPI_ID || napi_id == ep->napi_id)
+	if (napi_id < MIN_NAPI_ID || napi_id == READ_ONCE(ep->napi_id))
 		return;
 
-	/* record NAPI ID for use in next busy poll */
-	ep->napi_id = napi_id;
+	/*
+	 * record NAPI ID for use in next busy poll, callbacks of different
+	 * EPOLL_SHARDED shards may race here, last one wins
+	 */
+	WRITE_ONCE(ep->napi_id, napi_id);
 }
 
 static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
@@ -664,13 +738,15 @@ static void ep_unregister_pollwait(struct eventpoll *ep, struct epitem *epi)
 	}
 }
 
-/* call only when ep->mtx is held */
+/* call only when ep->mtx or the item's shard->mtx is held */
 static inline struct wakeup_source *ep_wakeup_source(struct epitem *epi)
 {
-	return rcu_dereference_check(epi->ws, lockdep_is_held(&epi->ep->mtx));
+	return rcu_dereference_check(epi->ws,
+				     lockdep_is_held(&epi->ep->mtx) ||
+				     lockdep_is_held(&ep_item_shard(epi)->mtx));
 }
 
-/* call only when ep->mtx is held */
+/* call only when ep->mtx or the item's shard->mtx is held */
 static inline void ep_pm_stay_awake(struct epitem *epi)
 {
 	struct wakeup_source *ws = ep_wakeup_source(epi);
@@ -698,38 +774,38 @@ static inline void ep_pm_stay_awake_rcu(struct epitem *epi)
 
 
 /*
- * ep->mutex needs to be held because we could be hit by
- * eventpoll_release_file() and epoll_ctl().
+ * ep->mutex (or sh->mtx for EPOLL_SHARDED) needs to be held because we could
+ * be hit by eventpoll_release_file() and epoll_ctl().
  */
-static void ep_start_scan(struct eventpoll *ep, struct list_head *txlist)
+static void ep_start_scan(struct ep_shard *sh, struct list_head *txlist)
 {
 	/*
 	 * Steal the ready list, and re-init the original one to the
-	 * empty list. Also, set ep->ovflist to NULL so that events
+	 * empty list. Also, set sh->ovflist to NULL so that events
 	 * happening while looping w/out locks, are not lost. We cannot
-	 * have the poll callback to queue directly on ep->rdllist,
+	 * have the poll callback to queue directly on sh->rdllist,
 	 * because we want the "sproc" callback to be able to do it
 	 * in a lockless way.
 	 */
 	lockdep_assert_irqs_enabled();
-	write_lock_irq(&ep->lock);
-	list_splice_init(&ep->rdllist, txlist);
-	WRITE_ONCE(ep->ovflist, NULL);
-	write_unlock_irq(&ep->lock);
+	write_lock_irq(&sh->lock);
+	list_splice_init(&sh->rdllist, txlist);
+	WRITE_ONCE(sh->ovflist, NULL);
+	write_unlock_irq(&sh->lock);
 }
 
-static void ep_done_scan(struct eventpoll *ep,
+static void ep_done_scan(struct eventpoll *ep, struct ep_shard *sh,
 			 struct list_head *txlist)
 {
 	struct epitem *epi, *nepi;
 
-	write_lock_irq(&ep->lock);
+	write_lock_irq(&sh->lock);
 	/*
 	 * During the time we spent inside the "sproc" callback, some
 	 * other events might have been queued by the poll callback.
 	 * We re-insert them inside the main ready-list here.
 	 */
-	for (nepi = READ_ONCE(ep->ovflist); (epi = nepi) != NULL;
+	for (nepi = READ_ONCE(sh->ovflist); (epi = nepi) != NULL;
 	     nepi = epi->next, epi->next = EP_UNACTIVE_PTR) {
 		/*
 		 * We need to check if the item is already in the list.
@@ -742,29 +818,29 @@ static void ep_done_scan(struct eventpoll *ep,
 			 * ->ovflist is LIFO, so we have to reverse it in order
 			 * to keep in FIFO.
 			 */
-			list_add(&epi->rdllink, &ep->rdllist);
+			list_add(&epi->rdllink, &sh->rdllist);
 			ep_pm_stay_awake(epi);
 		}
 	}
 	/*
-	 * We need to set back ep->ovflist to EP_UNACTIVE_PTR, so that after
+	 * We need to set back sh->ovflist to EP_UNACTIVE_PTR, so that after
 	 * releasing the lock, events will be queued in the normal way inside
-	 * ep->rdllist.
+	 * sh->rdllist.
 	 */
-	WRITE_ONCE(ep->ovflist, EP_UNACTIVE_PTR);
+	WRITE_ONCE(sh->ovflist, EP_UNACTIVE_PTR);
 
 	/*
 	 * Quickly re-inject items left on "txlist".
 	 */
-	list_splice(txlist, &ep->rdllist);
+	list_splice(txlist, &sh->rdllist);
 	__pm_relax(ep->ws);
 
-	if (!list_empty(&ep->rdllist)) {
-		if (waitqueue_active(&ep->wq))
+	if (!list_empty(&sh->rdllist)) {
+		if (ep_wq_active(ep))
 			wake_up(&ep->wq);
 	}
 
-	write_unlock_irq(&ep->lock);
+	write_unlock_irq(&sh->lock);
 }
 
 static void ep_get(struct eventpoll *ep)
@@ -786,6 +862,11 @@ static bool ep_refcount_dec_and_test(struct eventpoll *ep)
 
 static void ep_free(struct eventpoll *ep)
 {
+	unsigned int i;
+
+	for (i = 0; i < ep->nr_shards; i++)
+		mutex_destroy(&ep->shards[i].mtx);
+	kfree(ep->shards);
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
@@ -805,6 +886,7 @@ static bool __ep_remove(struct eventpoll *ep, struct epitem *epi, bool force)
 	struct file *file = epi->ffd.file;
 	struct epitems_head *to_free;
 	struct hlist_head *head;
+	struct ep_shard *sh;
 
 	lockdep_assert_irqs_enabled();
 
@@ -837,12 +919,21 @@ static bool __ep_remove(struct eventpoll *ep, struct epitem *epi, bool force)
 
 	rb_erase_cached(&epi->rbn, &ep->rbr);
 
-	write_lock_irq(&ep->lock);
+	/*
+	 * For EPOLL_SHARDED, a concurrent ep_send_events() might have the item
+	 * on its private list and be polling the file, wait for it.
+	 */
+	sh = ep_item_shard(epi);
+	if (ep_is_sharded(ep))
+		mutex_lock(&sh->mtx);
+	write_lock_irq(&sh->lock);
 	if (ep_is_linked(epi))
 		list_del_init(&epi->rdllink);
-	write_unlock_irq(&ep->lock);
+	write_unlock_irq(&sh->lock);
 
 	wakeup_source_unregister(ep_wakeup_source(epi));
+	if (ep_is_sharded(ep))
+		mutex_unlock(&sh->mtx);
 	/*
 	 * At this point it is safe to free the eventpoll item. Use the union
 	 * field epi->rcu, since we are trying to minimize the size of
@@ -948,6 +1039,7 @@ static __poll_t __ep_eventpoll_poll(struct file *file, poll_table *wait, int dep
 	struct epitem *epi, *tmp;
 	poll_table pt;
 	__poll_t res = 0;
+	unsigned int i;
 
 	init_poll_funcptr(&pt, NULL);
 
@@ -956,25 +1048,34 @@ static __poll_t __ep_eventpoll_poll(struct file *file, poll_table *wait, int dep
 
 	/*
 	 * Proceed to find out if wanted events are really available inside
-	 * the ready list.
+	 * the ready lists.
 	 */
 	mutex_lock_nested(&ep->mtx, depth);
-	ep_start_scan(ep, &txlist);
-	list_for_each_entry_safe(epi, tmp, &txlist, rdllink) {
-		if (ep_item_poll(epi, &pt, depth + 1)) {
-			res = EPOLLIN | EPOLLRDNORM;
-			break;
-		} else {
-			/*
-			 * Item has been dropped into the ready list by the poll
-			 * callback, but it's not actually ready, as far as
-			 * caller requested events goes. We can remove it here.
-			 */
-			__pm_relax(ep_wakeup_source(epi));
-			list_del_init(&epi->rdllink);
+	for (i = 0; i < ep->nr_shards && !res; i++) {
+		struct ep_shard *sh = &ep->shards[i];
+
+		if (ep_is_sharded(ep))
+			mutex_lock_nested(&sh->mtx, depth);
+		ep_start_scan(sh, &txlist);
+		list_for_each_entry_safe(epi, tmp, &txlist, rdllink) {
+			if (ep_item_poll(epi, &pt, depth + 1)) {
+				res = EPOLLIN | EPOLLRDNORM;
+				break;
+			} else {
+				/*
+				 * Item has been dropped into the ready list by
+				 * the poll callback, but it's not actually
+				 * ready, as far as caller requested events
+				 * goes. We can remove it here.
+				 */
+				__pm_relax(ep_wakeup_source(epi));
+				list_del_init(&epi->rdllink);
+			}
 		}
+		ep_done_scan(ep, sh, &txlist);
+		if (ep_is_sharded(ep))
+			mutex_unlock(&sh->mtx);
 	}
-	ep_done_scan(ep, &txlist);
 	mutex_unlock(&ep->mtx);
 	return res;
 }
@@ -1114,21 +1215,33 @@ void eventpoll_release_file(struct file *file)
 	spin_unlock(&file->f_lock);
 }
 
-static int ep_alloc(struct eventpoll **pep)
+static int ep_alloc(struct eventpoll **pep, unsigned int nr_shards)
 {
 	struct eventpoll *ep;
+	unsigned int i;
 
 	ep = kzalloc(sizeof(*ep), GFP_KERNEL);
 	if (unlikely(!ep))
 		return -ENOMEM;
+	ep->shards = kcalloc(nr_shards, sizeof(*ep->shards), GFP_KERNEL);
+	if (unlikely(!ep->shards)) {
+		kfree(ep);
+		return -ENOMEM;
+	}
+	ep->nr_shards = nr_shards;
 
 	mutex_init(&ep->mtx);
-	rwlock_init(&ep->lock);
 	init_waitqueue_head(&ep->wq);
 	init_waitqueue_head(&ep->poll_wait);
-	INIT_LIST_HEAD(&ep->rdllist);
+	for (i = 0; i < nr_shards; i++) {
+		struct ep_shard *sh = &ep->shards[i];
+
+		rwlock_init(&sh->lock);
+		INIT_LIST_HEAD(&sh->rdllist);
+		sh->ovflist = EP_UNACTIVE_PTR;
+		mutex_init(&sh->mtx);
+	}
 	ep->rbr = RB_ROOT_CACHED;
-	ep->ovflist = EP_UNACTIVE_PTR;
 	ep->user = get_current_user();
 	refcount_set(&ep->refcount, 1);
 
@@ -1264,14 +1377,14 @@ static inline bool list_add_tail_lockless(struct list_head *new,
 }
 
 /*
- * Chains a new epi entry to the tail of the ep->ovflist in a lockless way,
- * i.e. multiple CPUs are allowed to call this function concurrently.
+ * Chains a new epi entry to the tail of the shard ->ovflist in a lockless
+ * way, i.e. multiple CPUs are allowed to call this function concurrently.
  *
  * Return: %false if epi element has been already chained, %true otherwise.
  */
 static inline bool chain_epi_lockless(struct epitem *epi)
 {
-	struct eventpoll *ep = epi->ep;
+	struct ep_shard *sh = ep_item_shard(epi);
 
 	/* Fast preliminary check */
 	if (epi->next != EP_UNACTIVE_PTR)
@@ -1282,7 +1395,7 @@ static inline bool chain_epi_lockless(struct epitem *epi)
 		return false;
 
 	/* Atomically exchange tail */
-	epi->next = xchg(&ep->ovflist, epi);
+	epi->next = xchg(&sh->ovflist, epi);
 
 	return true;
 }
@@ -1310,11 +1423,12 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	int pwake = 0;
 	struct epitem *epi = ep_item_from_wait(wait);
 	struct eventpoll *ep = epi->ep;
+	struct ep_shard *sh = ep_item_shard(epi);
 	__poll_t pollflags = key_to_poll(key);
 	unsigned long flags;
 	int ewake = 0;
 
-	read_lock_irqsave(&ep->lock, flags);
+	read_lock_irqsave(&sh->lock, flags);
 
 	ep_set_busy_poll_napi_id(epi);
 
@@ -1342,12 +1456,12 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * semantics). All the events that happen during that period of time are
 	 * chained in ep->ovflist and requeued later on.
 	 */
-	if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
+	if (READ_ONCE(sh->ovflist) != EP_UNACTIVE_PTR) {
 		if (chain_epi_lockless(epi))
 			ep_pm_stay_awake_rcu(epi);
 	} else if (!ep_is_linked(epi)) {
 		/* In the usual case, add event to ready list. */
-		if (list_add_tail_lockless(&epi->rdllink, &ep->rdllist))
+		if (list_add_tail_lockless(&epi->rdllink, &sh->rdllist))
 			ep_pm_stay_awake_rcu(epi);
 	}
 
@@ -1355,7 +1469,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * Wake up ( if active ) both the eventpoll wait list and the ->poll()
 	 * wait list.
 	 */
-	if (waitqueue_active(&ep->wq)) {
+	if (ep_wq_active(ep)) {
 		if ((epi->event.events & EPOLLEXCLUSIVE) &&
 					!(pollflags & POLLFREE)) {
 			switch (pollflags & EPOLLINOUT_BITS) {
@@ -1378,7 +1492,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 		pwake++;
 
 out_unlock:
-	read_unlock_irqrestore(&ep->lock, flags);
+	read_unlock_irqrestore(&sh->lock, flags);
 
 	/* We have to call this outside the lock */
 	if (pwake)
@@ -1623,6 +1737,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	struct epitem *epi;
 	struct ep_pqueue epq;
 	struct eventpoll *tep = NULL;
+	struct ep_shard *sh;
 
 	if (is_file_epoll(tfile))
 		tep = tfile->private_data;
@@ -1645,6 +1760,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	ep_set_ffd(&epi->ffd, tfile, fd);
 	epi->event = *event;
 	epi->next = EP_UNACTIVE_PTR;
+	epi->shard = ep_local_shard(ep);
 
 	if (tep)
 		mutex_lock_nested(&tep->mtx, 1);
@@ -1712,24 +1828,29 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	}
 
 	/* We have to drop the new item inside our item list to keep track of it */
-	write_lock_irq(&ep->lock);
+	sh = ep_item_shard(epi);
+	if (ep_is_sharded(ep))
+		mutex_lock(&sh->mtx);
+	write_lock_irq(&sh->lock);
 
 	/* record NAPI ID of new item if present */
 	ep_set_busy_poll_napi_id(epi);
 
 	/* If the file is already "ready" we drop it inside the ready list */
 	if (revents && !ep_is_linked(epi)) {
-		list_add_tail(&epi->rdllink, &ep->rdllist);
+		list_add_tail(&epi->rdllink, &sh->rdllist);
 		ep_pm_stay_awake(epi);
 
 		/* Notify waiting tasks that events are available */
-		if (waitqueue_active(&ep->wq))
+		if (ep_wq_active(ep))
 			wake_up(&ep->wq);
 		if (waitqueue_active(&ep->poll_wait))
 			pwake++;
 	}
 
-	write_unlock_irq(&ep->lock);
+	write_unlock_irq(&sh->lock);
+	if (ep_is_sharded(ep))
+		mutex_unlock(&sh->mtx);
 
 	/* We have to call this outside the lock */
 	if (pwake)
@@ -1745,6 +1866,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 		     const struct epoll_event *event)
 {
+	struct ep_shard *sh = ep_item_shard(epi);
 	int pwake = 0;
 	poll_table pt;
 
@@ -1752,6 +1874,13 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 
 	init_poll_funcptr(&pt, NULL);
 
+	/*
+	 * For EPOLL_SHARDED, ep_send_events() of the item's shard doesn't hold
+	 * "mtx" and might be rewriting the EPOLLONESHOT mask under us.
+	 */
+	if (ep_is_sharded(ep))
+		mutex_lock(&sh->mtx);
+
 	/*
 	 * Set the new event interest mask before calling f_op->poll();
 	 * otherwise we might miss an event that happens between the
@@ -1793,19 +1922,21 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 	 * list, push it inside.
 	 */
 	if (ep_item_poll(epi, &pt, 1)) {
-		write_lock_irq(&ep->lock);
+		write_lock_irq(&sh->lock);
 		if (!ep_is_linked(epi)) {
-			list_add_tail(&epi->rdllink, &ep->rdllist);
+			list_add_tail(&epi->rdllink, &sh->rdllist);
 			ep_pm_stay_awake(epi);
 
 			/* Notify waiting tasks that events are available */
-			if (waitqueue_active(&ep->wq))
+			if (ep_wq_active(ep))
 				wake_up(&ep->wq);
 			if (waitqueue_active(&ep->poll_wait))
 				pwake++;
 		}
-		write_unlock_irq(&ep->lock);
+		write_unlock_irq(&sh->lock);
 	}
+	if (ep_is_sharded(ep))
+		mutex_unlock(&sh->mtx);
 
 	/* We have to call this outside the lock */
 	if (pwake)
@@ -1814,30 +1945,25 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 	return 0;
 }
 
-static int ep_send_events(struct eventpoll *ep,
-			  struct epoll_event __user *events, int maxevents)
+/*
+ * Must be called with "mtx" held, or the shard's "mtx" for EPOLL_SHARDED.
+ */
+static int __ep_send_events(struct eventpoll *ep, struct ep_shard *sh,
+			    struct epoll_event __user *events, int maxevents)
 {
 	struct epitem *epi, *tmp;
 	LIST_HEAD(txlist);
 	poll_table pt;
 	int res = 0;
 
-	/*
-	 * Always short-circuit for fatal signals to allow threads to make a
-	 * timely exit without the chance of finding more events available and
-	 * fetching repeatedly.
-	 */
-	if (fatal_signal_pending(current))
-		return -EINTR;
-
 	init_poll_funcptr(&pt, NULL);
 
-	mutex_lock(&ep->mtx);
-	ep_start_scan(ep, &txlist);
+	ep_start_scan(sh, &txlist);
 
 	/*
 	 * We can loop without lock because we are passed a task private list.
-	 * Items cannot vanish during the loop we are holding ep->mtx.
+	 * Items cannot vanish during the loop we are holding ep->mtx (or
+	 * sh->mtx, which ep_remove() takes as well for EPOLL_SHARDED).
 	 */
 	list_for_each_entry_safe(epi, tmp, &txlist, rdllink) {
 		struct wakeup_source *ws;
@@ -1866,7 +1992,8 @@ static int ep_send_events(struct eventpoll *ep,
 
 		/*
 		 * If the event mask intersect the caller-requested one,
-		 * deliver the event to userspace. Again, we are holding ep->mtx,
+		 * deliver the event to userspace. Again, we are holding ep->mtx
+		 * (or sh->mtx),
 		 * so no operations coming from userspace can change the item.
 		 */
 		revents = ep_item_poll(epi, &pt, 1);
@@ -1891,18 +2018,77 @@ static int ep_send_events(struct eventpoll *ep,
 			 * the ready list, so that the next call to
 			 * epoll_wait() will check again the events
 			 * availability. At this point, no one can insert
-			 * into ep->rdllist besides us. The epoll_ctl()
+			 * into sh->rdllist besides us. The epoll_ctl()
 			 * callers are locked out by
 			 * ep_send_events() holding "mtx" and the
-			 * poll callback will queue them in ep->ovflist.
+			 * poll callback will queue them in sh->ovflist.
 			 */
-			list_add_tail(&epi->rdllink, &ep->rdllist);
+			list_add_tail(&epi->rdllink, &sh->rdllist);
 			ep_pm_stay_awake(epi);
 		}
 	}
-	ep_done_scan(ep, &txlist);
-	mutex_unlock(&ep->mtx);
+	ep_done_scan(ep, sh, &txlist);
+
+	return res;
+}
+
+/*
+ * EPOLL_SHARDED: harvest the shard local to this CPU first, and only steal
+ * from the other shards if it has nothing to offer. Shards that are being
+ * harvested by someone else are skipped, unless they're the only ones with
+ * events left, so that we don't spin in ep_poll() while events are pending.
+ */
+static int ep_send_sharded_events(struct eventpoll *ep,
+				  struct epoll_event __user *events,
+				  int maxevents)
+{
+	unsigned int i, local = ep_local_shard(ep);
+	struct ep_shard *busy = NULL;
+	int res;
+
+	for (i = 0; i < ep->nr_shards; i++) {
+		struct ep_shard *sh = &ep->shards[(local + i) % ep->nr_shards];
+
+		if (!ep_shard_events_available(sh))
+			continue;
+		if (!mutex_trylock(&sh->mtx)) {
+			if (!busy)
+				busy = sh;
+			continue;
+		}
+		res = __ep_send_events(ep, sh, events, maxevents);
+		mutex_unlock(&sh->mtx);
+		if (res)
+			return res;
+	}
 
+	if (!busy)
+		return 0;
+	mutex_lock(&busy->mtx);
+	res = __ep_send_events(ep, busy, events, maxevents);
+	mutex_unlock(&busy->mtx);
+	return res;
+}
+
+static int ep_send_events(struct eventpoll *ep,
+			  struct epoll_event __user *events, int maxevents)
+{
+	int res;
+
+	/*
+	 * Always short-circuit for fatal signals to allow threads to make a
+	 * timely exit without the chance of finding more events available and
+	 * fetching repeatedly.
+	 */
+	if (fatal_signal_pending(current))
+		return -EINTR;
+
+	if (ep_is_sharded(ep))
+		return ep_send_sharded_events(ep, events, maxevents);
+
+	mutex_lock(&ep->mtx);
+	res = __ep_send_events(ep, ep->shards, events, maxevents);
+	mutex_unlock(&ep->mtx);
 	return res;
 }
 
@@ -1946,6 +2132,79 @@ static int ep_autoremove_wake_function(struct wait_queue_entry *wq_entry,
 	return ret;
 }
 
+/*
+ * ep->wq is protected by ep->lock, unless the eventpoll is sharded: wakers
+ * only hold the lock of their own shard, so the wait queue lock is used.
+ */
+static void ep_wait_lock(struct eventpoll *ep)
+{
+	if (ep_is_sharded(ep))
+		spin_lock_irq(&ep->wq.lock);
+	else
+		write_lock_irq(&ep->shards->lock);
+}
+
+static void ep_wait_unlock(struct eventpoll *ep)
+{
+	if (ep_is_sharded(ep))
+		spin_unlock_irq(&ep->wq.lock);
+	else
+		write_unlock_irq(&ep->shards->lock);
+}
+
+static int ep_prepare_wait(struct eventpoll *ep, wait_queue_entry_t *wait)
+{
+	int eavail;
+
+	write_lock_irq(&ep->shards->lock);
+	/*
+	 * Barrierless variant, waitqueue_active() is called under
+	 * the same lock on wakeup ep_poll_callback() side, so it
+	 * is safe to avoid an explicit barrier.
+	 */
+	__set_current_state(TASK_INTERRUPTIBLE);
+
+	/*
+	 * Do the final check under the lock. ep_start/done_scan()
+	 * plays with two lists (->rdllist and ->ovflist) and there
+	 * is always a race when both lists are empty for short
+	 * period of time although events are pending, so lock is
+	 * important.
+	 */
+	eavail = ep_events_available(ep);
+	if (!eavail)
+		__add_wait_queue_exclusive(&ep->wq, wait);
+
+	write_unlock_irq(&ep->shards->lock);
+	return eavail;
+}
+
+/*
+ * We can't take every shard lock here, so queue ourselves first and check
+ * the ready lists afterwards. set_current_state() pairs with the barrier in
+ * ep_wq_active() on the wakeup side: either the waker sees us on ep->wq, or
+ * we see its item. ep_done_scan() may still leave all lists empty for a
+ * moment, but it rechecks ep->wq once it has re-injected the items.
+ */
+static int ep_prepare_sharded_wait(struct eventpoll *ep,
+				   wait_queue_entry_t *wait)
+{
+	int eavail;
+
+	spin_lock_irq(&ep->wq.lock);
+	__add_wait_queue_exclusive(&ep->wq, wait);
+	set_current_state(TASK_INTERRUPTIBLE);
+	spin_unlock_irq(&ep->wq.lock);
+
+	eavail = ep_events_available(ep);
+	if (eavail) {
+		spin_lock_irq(&ep->wq.lock);
+		__remove_wait_queue(&ep->wq, wait);
+		spin_unlock_irq(&ep->wq.lock);
+	}
+	return eavail;
+}
+
 /**
  * ep_poll - Retrieves ready events, and delivers them to the caller-supplied
  *           event buffer.
@@ -2037,26 +2296,10 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		init_wait(&wait);
 		wait.func = ep_autoremove_wake_function;
 
-		write_lock_irq(&ep->lock);
-		/*
-		 * Barrierless variant, waitqueue_active() is called under
-		 * the same lock on wakeup ep_poll_callback() side, so it
-		 * is safe to avoid an explicit barrier.
-		 */
-		__set_current_state(TASK_INTERRUPTIBLE);
-
-		/*
-		 * Do the final check under the lock. ep_start/done_scan()
-		 * plays with two lists (->rdllist and ->ovflist) and there
-		 * is always a race when both lists are empty for short
-		 * period of time although events are pending, so lock is
-		 * important.
-		 */
-		eavail = ep_events_available(ep);
-		if (!eavail)
-			__add_wait_queue_exclusive(&ep->wq, &wait);
-
-		write_unlock_irq(&ep->lock);
+		if (ep_is_sharded(ep))
+			eavail = ep_prepare_sharded_wait(ep, &wait);
+		else
+			eavail = ep_prepare_wait(ep, &wait);
 
 		if (!eavail)
 			timed_out = !schedule_hrtimeout_range(to, slack,
@@ -2071,7 +2314,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		eavail = 1;
 
 		if (!list_empty_careful(&wait.entry)) {
-			write_lock_irq(&ep->lock);
+			ep_wait_lock(ep);
 			/*
 			 * If the thread timed out and is not on the wait queue,
 			 * it means that the thread was woken up after its
@@ -2082,7 +2325,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			if (timed_out)
 				eavail = list_empty(&wait.entry);
 			__remove_wait_queue(&ep->wq, &wait);
-			write_unlock_irq(&ep->lock);
+			ep_wait_unlock(ep);
 		}
 	}
 }
@@ -2173,16 +2416,21 @@ static int do_epoll_create(int flags)
 	int error, fd;
 	struct eventpoll *ep = NULL;
 	struct file *file;
+	unsigned int nr_shards = 1;
 
 	/* Check the EPOLL_* constant for consistency.  */
 	BUILD_BUG_ON(EPOLL_CLOEXEC != O_CLOEXEC);
+	BUILD_BUG_ON(EPOLL_SHARDED & O_CLOEXEC);
 
-	if (flags & ~EPOLL_CLOEXEC)
+	if (flags & ~(EPOLL_CLOEXEC | EPOLL_SHARDED))
 		return -EINVAL;
+	if (flags & EPOLL_SHARDED)
+		nr_shards = min_t(unsigned int, num_possible_cpus(),
+				  EP_MAX_SHARDS);
 	/*
 	 * Create the internal data structure ("struct eventpoll").
 	 */
-	error = ep_alloc(&ep);
+	error = ep_alloc(&ep, nr_shards);
 	if (error < 0)
 		return error;
 	/*
@@ -2200,11 +2448,6 @@ static int do_epoll_create(int flags)
 		error = PTR_ERR(file);
 		goto out_free_fd;
 	}
-#ifdef CONFIG_NET_RX_BUSY_POLL
-	ep->busy_poll_usecs = 0;
-	ep->busy_poll_budget = 0;
-	ep->prefer_busy_poll = false;
-#endif
 	ep->file = file;
 	fd_install(fd, file);
 	return fd;
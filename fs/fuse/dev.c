@@ -211,6 +211,14 @@ static void fuse_dev_wake_and_unlock(struct fuse_iqueue *fiq)
 __releases(fiq->lock)
 {
 	wake_up(&fiq->waitq);
+	/* bound readers look at the common queue too */
+	if (unlikely(fiq->nodes)) {
+		int nid;
+
+		for_each_node(nid)
+			if (fiq->nodes[nid].nr_readers)
+				wake_up(&fiq->nodes[nid].waitq);
+	}
 	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
 	spin_unlock(&fiq->lock);
 }
@@ -222,13 +230,46 @@ const struct fuse_iqueue_ops fuse_dev_fiq_ops = {
 };
 EXPORT_SYMBOL_GPL(fuse_dev_fiq_ops);
 
+/*
+ * Prefer the queue of the local node, else any node queue with readers.
+ * Without bound readers requests go on fiq->pending as usual.
+ */
+static struct fuse_iqueue_node *fuse_iqueue_node_pick(struct fuse_iqueue *fiq)
+{
+	struct fuse_iqueue_node *nodes = fiq->nodes;
+	int nid;
+
+	if (likely(!nodes))
+		return NULL;
+
+	nid = numa_node_id();
+	if (nodes[nid].nr_readers)
+		return &nodes[nid];
+	for_each_node(nid)
+		if (nodes[nid].nr_readers)
+			return &nodes[nid];
+	return NULL;
+}
+
 static void queue_request_and_unlock(struct fuse_iqueue *fiq,
 				     struct fuse_req *req)
 __releases(fiq->lock)
 {
+	struct fuse_iqueue_node *iqn = fuse_iqueue_node_pick(fiq);
+
 	req->in.h.len = sizeof(struct fuse_in_header) +
 		fuse_len_args(req->args->in_numargs,
 			      (struct fuse_arg *) req->args->in_args);
+	req->iqn = iqn;
+	if (iqn) {
+		spin_lock(&iqn->lock);
+		list_add_tail(&req->list, &iqn->pending);
+		spin_unlock(&iqn->lock);
+		spin_unlock(&fiq->lock);
+		wake_up(&iqn->waitq);
+		kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
+		return;
+	}
 	list_add_tail(&req->list, &fiq->pending);
 	fiq->ops->wake_pending_and_unlock(fiq);
 }
@@ -388,15 +429,24 @@ static void request_wait_answer(struct fuse_req *req)
 		if (!err)
 			return;
 
+		struct fuse_iqueue_node *iqn;
+
 		spin_lock(&fiq->lock);
+		iqn = req->iqn;
+		if (iqn)
+			spin_lock(&iqn->lock);
 		/* Request is not yet in userspace, bail out */
 		if (test_bit(FR_PENDING, &req->flags)) {
 			list_del(&req->list);
+			if (iqn)
+				spin_unlock(&iqn->lock);
 			spin_unlock(&fiq->lock);
 			__fuse_put_request(req);
 			req->out.h.error = -EINTR;
 			return;
 		}
+		if (iqn)
+			spin_unlock(&iqn->lock);
 		spin_unlock(&fiq->lock);
 	}
 
@@ -1038,6 +1088,45 @@ static int request_pending(struct fuse_iqueue *fiq)
 		forget_pending(fiq);
 }
 
+/*
+ * Take the next request off the node queue of a bound device.  Returns NULL
+ * when the common queue needs attention (or the connection went away), in
+ * which case the caller takes fiq->lock and looks there.
+ */
+static struct fuse_req *fuse_dev_node_wait(struct fuse_iqueue *fiq,
+					   struct fuse_iqueue_node *iqn,
+					   bool nonblock)
+{
+	struct fuse_req *req;
+	int err;
+
+	for (;;) {
+		/* lockless hint, rechecked under fiq->lock by the caller */
+		if (!READ_ONCE(fiq->connected) || request_pending(fiq))
+			return NULL;
+
+		spin_lock(&iqn->lock);
+		req = list_first_entry_or_null(&iqn->pending, struct fuse_req,
+					       list);
+		if (req) {
+			clear_bit(FR_PENDING, &req->flags);
+			list_del_init(&req->list);
+		}
+		spin_unlock(&iqn->lock);
+		if (req)
+			return req;
+
+		if (nonblock)
+			return ERR_PTR(-EAGAIN);
+		err = wait_event_interruptible_exclusive(iqn->waitq,
+				!READ_ONCE(fiq->connected) ||
+				!list_empty(&iqn->pending) ||
+				request_pending(fiq));
+		if (err)
+			return ERR_PTR(err);
+	}
+}
+
 /*
  * Transfer an interrupt request to userspace
  *
@@ -1208,6 +1297,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	struct fuse_conn *fc = fud->fc;
 	struct fuse_iqueue *fiq = &fc->iq;
 	struct fuse_pqueue *fpq = &fud->pq;
+	struct fuse_iqueue_node *iqn;
 	struct fuse_req *req;
 	struct fuse_args *args;
 	unsigned reqsize;
@@ -1233,11 +1323,23 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 
  restart:
 	for (;;) {
+		iqn = READ_ONCE(fud->iqn);
+		if (iqn) {
+			req = fuse_dev_node_wait(fiq, iqn,
+						 file->f_flags & O_NONBLOCK);
+			if (IS_ERR(req))
+				return PTR_ERR(req);
+			if (req)
+				goto got_req;
+		}
+
 		spin_lock(&fiq->lock);
 		if (!fiq->connected || request_pending(fiq))
 			break;
 		spin_unlock(&fiq->lock);
 
+		if (iqn)
+			continue;
 		if (file->f_flags & O_NONBLOCK)
 			return -EAGAIN;
 		err = wait_event_interruptible_exclusive(fiq->waitq,
@@ -1270,6 +1372,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	list_del_init(&req->list);
 	spin_unlock(&fiq->lock);
 
+got_req:
 	args = req->args;
 	reqsize = req->in.h.len;
 
@@ -1813,6 +1916,7 @@ static void fuse_resend(struct fuse_conn *fc)
 	spin_unlock(&fc->lock);
 
 	list_for_each_entry_safe(req, next, &to_queue, list) {
+		req->iqn = NULL;
 		set_bit(FR_PENDING, &req->flags);
 		clear_bit(FR_SENT, &req->flags);
 		/* mark the request as resend request */
@@ -2117,18 +2221,22 @@ static __poll_t fuse_dev_poll(struct file *file, poll_table *wait)
 {
 	__poll_t mask = EPOLLOUT | EPOLLWRNORM;
 	struct fuse_iqueue *fiq;
+	struct fuse_iqueue_node *iqn;
 	struct fuse_dev *fud = fuse_get_dev(file);
 
 	if (!fud)
 		return EPOLLERR;
 
 	fiq = &fud->fc->iq;
+	iqn = READ_ONCE(fud->iqn);
 	poll_wait(file, &fiq->waitq, wait);
+	if (iqn)
+		poll_wait(file, &iqn->waitq, wait);
 
 	spin_lock(&fiq->lock);
 	if (!fiq->connected)
 		mask = EPOLLERR;
-	else if (request_pending(fiq))
+	else if (request_pending(fiq) || (iqn && !list_empty(&iqn->pending)))
 		mask |= EPOLLIN | EPOLLRDNORM;
 	spin_unlock(&fiq->lock);
 
@@ -2230,6 +2338,20 @@ void fuse_abort_conn(struct fuse_conn *fc)
 		list_for_each_entry(req, &fiq->pending, list)
 			clear_bit(FR_PENDING, &req->flags);
 		list_splice_tail_init(&fiq->pending, &to_end);
+		if (fiq->nodes) {
+			int nid;
+
+			for_each_node(nid) {
+				struct fuse_iqueue_node *iqn = &fiq->nodes[nid];
+
+				spin_lock(&iqn->lock);
+				list_for_each_entry(req, &iqn->pending, list)
+					clear_bit(FR_PENDING, &req->flags);
+				list_splice_tail_init(&iqn->pending, &to_end);
+				spin_unlock(&iqn->lock);
+				wake_up_all(&iqn->waitq);
+			}
+		}
 		while (forget_pending(fiq))
 			kfree(fuse_dequeue_forget(fiq, 1, NULL));
 		wake_up_all(&fiq->waitq);
@@ -2253,6 +2375,30 @@ void fuse_wait_aborted(struct fuse_conn *fc)
 	wait_event(fc->blocked_waitq, atomic_read(&fc->num_waiting) == 0);
 }
 
+/* The last reader of a node queue hands its requests to the common queue */
+static void fuse_dev_unbind_node(struct fuse_dev *fud)
+{
+	struct fuse_iqueue *fiq = &fud->fc->iq;
+	struct fuse_iqueue_node *iqn = fud->iqn;
+	struct fuse_req *req;
+	bool moved = false;
+
+	spin_lock(&fiq->lock);
+	fud->iqn = NULL;
+	if (!--iqn->nr_readers) {
+		spin_lock(&iqn->lock);
+		list_for_each_entry(req, &iqn->pending, list)
+			req->iqn = NULL;
+		moved = !list_empty(&iqn->pending);
+		list_splice_tail_init(&iqn->pending, &fiq->pending);
+		spin_unlock(&iqn->lock);
+	}
+	if (moved)
+		fiq->ops->wake_pending_and_unlock(fiq);
+	else
+		spin_unlock(&fiq->lock);
+}
+
 int fuse_dev_release(struct inode *inode, struct file *file)
 {
 	struct fuse_dev *fud = fuse_get_dev(file);
@@ -2263,6 +2409,9 @@ int fuse_dev_release(struct inode *inode, struct file *file)
 		LIST_HEAD(to_end);
 		unsigned int i;
 
+		if (fud->iqn)
+			fuse_dev_unbind_node(fud);
+
 		spin_lock(&fpq->lock);
 		WARN_ON(!list_empty(&fpq->io));
 		for (i = 0; i < FUSE_PQ_HASH_SIZE; i++)
@@ -2377,6 +2526,61 @@ static long fuse_dev_ioctl_backing_close(struct file *file, __u32 __user *argp)
 	return fuse_backing_close(fud->fc, backing_id);
 }
 
+static long fuse_dev_ioctl_bind_node(struct file *file, __s32 __user *argp)
+{
+	struct fuse_dev *fud = fuse_get_dev(file);
+	struct fuse_iqueue_node *nodes;
+	struct fuse_iqueue *fiq;
+	int nid, err;
+
+	if (!fud)
+		return -EPERM;
+
+	fiq = &fud->fc->iq;
+	if (fiq->ops != &fuse_dev_fiq_ops)
+		return -EOPNOTSUPP;
+
+	if (get_user(nid, argp))
+		return -EFAULT;
+	if (nid == NUMA_NO_NODE)
+		nid = numa_node_id();
+	if (nid < 0 || nid >= nr_node_ids || !node_possible(nid))
+		return -EINVAL;
+
+	if (!READ_ONCE(fiq->nodes)) {
+		int i;
+
+		nodes = kcalloc(nr_node_ids, sizeof(*nodes), GFP_KERNEL);
+		if (!nodes)
+			return -ENOMEM;
+		for (i = 0; i < nr_node_ids; i++) {
+			spin_lock_init(&nodes[i].lock);
+			init_waitqueue_head(&nodes[i].waitq);
+			INIT_LIST_HEAD(&nodes[i].pending);
+		}
+
+		spin_lock(&fiq->lock);
+		if (!fiq->nodes)
+			swap(fiq->nodes, nodes);
+		spin_unlock(&fiq->lock);
+		kfree(nodes);
+	}
+
+	spin_lock(&fiq->lock);
+	if (!fiq->connected) {
+		err = -ENOTCONN;
+	} else if (fud->iqn) {
+		err = -EBUSY;
+	} else {
+		fud->iqn = &fiq->nodes[nid];
+		fud->iqn->nr_readers++;
+		err = 0;
+	}
+	spin_unlock(&fiq->lock);
+
+	return err;
+}
+
 static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
@@ -2392,6 +2596,9 @@ static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 	case FUSE_DEV_IOC_BACKING_CLOSE:
 		return fuse_dev_ioctl_backing_close(file, argp);
 
+	case FUSE_DEV_IOC_BIND_NODE:
+		return fuse_dev_ioctl_bind_node(file, argp);
+
 	default:
 		return -ENOTTY;
 	}
@@ -1660,6 +1660,18 @@ static int fuse_dir_open(struct inode *inode, struct file *file)
 		 */
 		if (ff->open_flags & (FOPEN_STREAM | FOPEN_NONSEEKABLE))
 			nonseekable_open(inode, file);
+
+		/* Serve readdir from a backing directory */
+		if (IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) &&
+		    (ff->open_flags & FOPEN_PASSTHROUGH)) {
+			err = fuse_passthrough_opendir(inode, file);
+			if (err) {
+				pr_debug("failed to open directory in passthrough mode (err=%i).\n",
+					 err);
+				fuse_release_common(file, true);
+				err = -EIO;
+			}
+		}
 	}
 
 	return err;
@@ -435,6 +435,9 @@ struct fuse_req {
 
 	/** fuse_mount this request belongs to */
 	struct fuse_mount *fm;
+
+	/** Node queue this request is pending on, protected by fiq->lock */
+	struct fuse_iqueue_node *iqn;
 };
 
 struct fuse_iqueue;
@@ -475,6 +478,25 @@ struct fuse_iqueue_ops {
 /** /dev/fuse input queue operations */
 extern const struct fuse_iqueue_ops fuse_dev_fiq_ops;
 
+/**
+ * Per NUMA node input queue.  Devices bound to a node with
+ * FUSE_DEV_IOC_BIND_NODE read requests queued on that node from here
+ * instead of contending on fiq->lock and fiq->waitq.
+ */
+struct fuse_iqueue_node {
+	/** Protects @pending, nests inside fiq->lock */
+	spinlock_t lock;
+
+	/** Bound readers are waiting on this */
+	wait_queue_head_t waitq;
+
+	/** The list of pending requests */
+	struct list_head pending;
+
+	/** Number of bound devices, protected by fiq->lock */
+	unsigned int nr_readers;
+} ____cacheline_aligned_in_smp;
+
 struct fuse_iqueue {
 	/** Connection established */
 	unsigned connected;
@@ -509,6 +531,9 @@ struct fuse_iqueue {
 
 	/** Device-specific state */
 	void *priv;
+
+	/** Node queues, nr_node_ids of them once a device binds to one */
+	struct fuse_iqueue_node *nodes;
 };
 
 #define FUSE_PQ_HASH_BITS 8
@@ -540,6 +565,9 @@ struct fuse_dev {
 
 	/** list entry on fc->devices */
 	struct list_head entry;
+
+	/** Node queue this device reads from, if bound */
+	struct fuse_iqueue_node *iqn;
 };
 
 enum fuse_dax_mode {
@@ -1471,5 +1499,7 @@ ssize_t fuse_passthrough_splice_write(struct pipe_inode_info *pipe,
 				      struct file *out, loff_t *ppos,
 				      size_t len, unsigned int flags);
 ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma);
+int fuse_passthrough_opendir(struct inode *inode, struct file *file);
+int fuse_passthrough_readdir(struct file *file, struct dir_context *ctx);
 
 #endif /* _FS_FUSE_I_H */
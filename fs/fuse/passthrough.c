@@ -140,6 +140,53 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return backing_file_mmap(backing_file, vma, &ctx);
 }
 
+struct fuse_passthrough_dir_ctx {
+	struct dir_context ctx;
+	struct dir_context *caller;
+};
+
+static bool fuse_passthrough_filldir(struct dir_context *ctx, const char *name,
+				     int namelen, loff_t offset, u64 ino,
+				     unsigned int d_type)
+{
+	struct fuse_passthrough_dir_ctx *pctx =
+		container_of(ctx, struct fuse_passthrough_dir_ctx, ctx);
+
+	return pctx->caller->actor(pctx->caller, name, namelen, offset, ino,
+				   d_type);
+}
+
+int fuse_passthrough_readdir(struct file *file, struct dir_context *ctx)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *backing_file = fuse_file_passthrough(ff);
+	struct fuse_passthrough_dir_ctx pctx = {
+		.ctx.actor = fuse_passthrough_filldir,
+		.caller = ctx,
+	};
+	const struct cred *old_cred;
+	int err = 0;
+
+	pr_debug("%s: backing_file=0x%p, pos=%lld\n", __func__,
+		 backing_file, ctx->pos);
+
+	old_cred = override_creds(ff->cred);
+	if (backing_file->f_pos != ctx->pos) {
+		loff_t res = vfs_llseek(backing_file, ctx->pos, SEEK_SET);
+
+		if (res < 0)
+			err = res;
+	}
+	if (!err) {
+		err = iterate_dir(backing_file, &pctx.ctx);
+		ctx->pos = backing_file->f_pos;
+	}
+	revert_creds(old_cred);
+	fuse_file_accessed(file);
+
+	return err;
+}
+
 struct fuse_backing *fuse_backing_get(struct fuse_backing *fb)
 {
 	if (fb && refcount_inc_not_zero(&fb->count))
@@ -234,7 +281,8 @@ int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map)
 		goto out;
 
 	res = -EOPNOTSUPP;
-	if (!file->f_op->read_iter || !file->f_op->write_iter)
+	if (d_is_dir(file->f_path.dentry) ? !file->f_op->iterate_shared :
+	    (!file->f_op->read_iter || !file->f_op->write_iter))
 		goto out_fput;
 
 	backing_sb = file_inode(file)->i_sb;
@@ -324,6 +372,13 @@ struct fuse_backing *fuse_passthrough_open(struct file *file,
 	if (!fb)
 		goto out;
 
+	/* Directories are backed by directories, files by files */
+	err = -EINVAL;
+	if (S_ISDIR(inode->i_mode) != d_is_dir(fb->file->f_path.dentry)) {
+		fuse_backing_put(fb);
+		goto out;
+	}
+
 	/* Allocate backing file per fuse file to store fuse path */
 	backing_file = backing_file_open(&file->f_path, file->f_flags,
 					 &fb->file->f_path, fb->cred);
@@ -343,6 +398,30 @@ struct fuse_backing *fuse_passthrough_open(struct file *file,
 	return err ? ERR_PTR(err) : fb;
 }
 
+/*
+ * Setup readdir passthrough to a backing directory.  Unlike files, the
+ * inode does not keep the backing: there is no io mode to arbitrate and
+ * the backing file opened for @file holds everything readdir needs.
+ */
+int fuse_passthrough_opendir(struct inode *inode, struct file *file)
+{
+	struct fuse_file *ff = file->private_data;
+	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct fuse_backing *fb;
+
+	if (!fc->passthrough || !ff->args ||
+	    (ff->open_flags & FOPEN_CACHE_DIR))
+		return -EINVAL;
+
+	fb = fuse_passthrough_open(file, inode,
+				   ff->args->open_outarg.backing_id);
+	if (IS_ERR(fb))
+		return PTR_ERR(fb);
+
+	fuse_backing_put(fb);
+	return 0;
+}
+
 void fuse_passthrough_release(struct fuse_file *ff, struct fuse_backing *fb)
 {
 	pr_debug("%s: fb=0x%p, backing_file=0x%p\n", __func__,
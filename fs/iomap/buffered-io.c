@@ -576,6 +576,31 @@ bool iomap_is_partially_uptodate(struct folio *folio, size_t from, size_t count)
 }
 EXPORT_SYMBOL_GPL(iomap_is_partially_uptodate);
 
+/*
+ * Streaming writers often issue writes much smaller than the largest folio
+ * the mapping supports.  If a write starts right where an existing folio
+ * ends, ramp up the way readahead does and suggest twice the size of that
+ * folio, so sequential writes quickly end up in the largest folios.
+ */
+static size_t iomap_write_folio_size(struct iomap_iter *iter, loff_t pos,
+		size_t len)
+{
+	struct address_space *mapping = iter->inode->i_mapping;
+	size_t max = mapping_max_folio_size(mapping);
+	struct folio *prev;
+
+	if (len >= max || !pos || offset_in_page(pos))
+		return len;
+
+	prev = filemap_get_folio(mapping, (pos >> PAGE_SHIFT) - 1);
+	if (IS_ERR(prev))
+		return len;
+	if (folio_pos(prev) + folio_size(prev) == pos)
+		len = max(len, min(2 * folio_size(prev), max));
+	folio_put(prev);
+	return len;
+}
+
 /**
  * iomap_get_folio - get a folio reference for writing
  * @iter: iteration structure
@@ -588,13 +613,20 @@ EXPORT_SYMBOL_GPL(iomap_is_partially_uptodate);
 struct folio *iomap_get_folio(struct iomap_iter *iter, loff_t pos, size_t len)
 {
 	fgf_t fgp = FGP_WRITEBEGIN | FGP_NOFS;
+	struct folio *folio;
 
 	if (iter->flags & IOMAP_NOWAIT)
 		fgp |= FGP_NOWAIT;
+	if (mapping_large_folio_support(iter->inode->i_mapping))
+		len = iomap_write_folio_size(iter, pos, len);
 	fgp |= fgf_set_order(len);
 
-	return __filemap_get_folio(iter->inode->i_mapping, pos >> PAGE_SHIFT,
+	folio = __filemap_get_folio(iter->inode->i_mapping, pos >> PAGE_SHIFT,
 			fgp, mapping_gfp_mask(iter->inode->i_mapping));
+	if (!IS_ERR(folio))
+		trace_iomap_write_folio(iter->inode, folio_pos(folio),
+				folio_size(folio));
+	return folio;
 }
 EXPORT_SYMBOL_GPL(iomap_get_folio);
 
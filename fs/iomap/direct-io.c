@@ -52,6 +52,28 @@ struct iomap_dio {
 	};
 };
 
+/*
+ * Keep the last freed dio around on each CPU, as small sync and polled direct
+ * I/O tends to allocate one right after another is completed.  The dio may be
+ * freed from bio completion context, so only use irq-safe per-CPU operations.
+ */
+static DEFINE_PER_CPU(struct iomap_dio *, iomap_dio_cache);
+
+static struct iomap_dio *iomap_dio_alloc(void)
+{
+	struct iomap_dio *dio = this_cpu_xchg(iomap_dio_cache, NULL);
+
+	if (dio)
+		return dio;
+	return kmalloc(sizeof(*dio), GFP_KERNEL);
+}
+
+static void iomap_dio_free(struct iomap_dio *dio)
+{
+	if (this_cpu_cmpxchg(iomap_dio_cache, NULL, dio) != NULL)
+		kfree(dio);
+}
+
 static struct bio *iomap_dio_alloc_bio(const struct iomap_iter *iter,
 		struct iomap_dio *dio, unsigned short nr_vecs, blk_opf_t opf)
 {
@@ -128,7 +150,7 @@ ssize_t iomap_dio_complete(struct iomap_dio *dio)
 			ret += dio->done_before;
 	}
 	trace_iomap_dio_complete(iocb, dio->error, ret);
-	kfree(dio);
+	iomap_dio_free(dio);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(iomap_dio_complete);
@@ -561,7 +583,7 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	if (!iomi.len)
 		return NULL;
 
-	dio = kmalloc(sizeof(*dio), GFP_KERNEL);
+	dio = iomap_dio_alloc();
 	if (!dio)
 		return ERR_PTR(-ENOMEM);
 
@@ -732,7 +754,7 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	return dio;
 
 out_free_dio:
-	kfree(dio);
+	iomap_dio_free(dio);
 	if (ret)
 		return ERR_PTR(ret);
 	return NULL;
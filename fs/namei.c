@@ -586,6 +586,8 @@ struct nameidata {
 	int		dfd;
 	vfsuid_t	dir_vfsuid;
 	umode_t		dir_mode;
+	struct path	wc_start;	/* walk cache candidate, see */
+	const char	*wc_name;	/* walk_cache_record() */
 } __randomize_layout;
 
 #define ND_ROOT_PRESET 1
@@ -1766,6 +1768,7 @@ static const char *pick_link(struct nameidata *nd, struct path *link,
 			path_put(link);
 		return ERR_PTR(error);
 	}
+	nd->wc_name = NULL;
 	last = nd->stack + nd->depth++;
 	last->link = *link;
 	clear_delayed_call(&last->done);
@@ -2238,6 +2241,221 @@ static inline u64 hash_name(const void *salt, const char *name)
 
 #endif
 
+/*
+ * Path walk cache.
+ *
+ * On mounts with MOUNT_ATTR_WALKCACHE, remember the dentries an RCU walk
+ * went through for everything but the last component of a pathname, keyed
+ * by (mount, starting dentry, prefix string).  A later walk of the same
+ * prefix from the same place revalidates the recorded chain by d_seq and
+ * redoes the permission checks for it instead of hashing and looking up
+ * every component again; the last component is always looked up normally.
+ *
+ * Only plain directories are recorded: walks through "..", symlinks or
+ * mountpoints aren't cached and neither are dentries with ->d_revalidate()
+ * or ->d_hash().  The entries hold no references.  Renames and drops bump
+ * d_seq, and __d_drop() of a recorded dentry bumps ->s_walk_gen, which
+ * invalidates every entry of that superblock before the dentry can be freed.
+ * Entries are purged when their mount goes away.
+ */
+#define WALK_CACHE_BITS		12
+#define WALK_CACHE_MAX_DEPTH	16
+#define WALK_CACHE_MAX_LEN	256
+
+struct walk_cache_entry {
+	struct rcu_head		rcu;
+	struct vfsmount		*mnt;
+	struct dentry		*start;
+	unsigned int		gen;
+	unsigned short		depth;
+	unsigned short		len;
+	struct {
+		struct dentry	*dentry;
+		unsigned int	seq;
+	} path[WALK_CACHE_MAX_DEPTH];
+	char			name[];
+};
+
+static struct walk_cache_entry __rcu *walk_cache[1 << WALK_CACHE_BITS];
+static bool walk_cache_used;
+
+static inline unsigned int walk_cache_hash(struct vfsmount *mnt,
+		struct dentry *start, const char *name, unsigned int len)
+{
+	return hash_32(full_name_hash(start, name, len) ^ hash_ptr(mnt, 32),
+		       WALK_CACHE_BITS);
+}
+
+/* length of @name up to the slashes in front of its last component */
+static unsigned int walk_prefix_len(const char *name)
+{
+	const char *end = name + strlen(name);
+
+	while (end > name && end[-1] == '/')
+		end--;
+	while (end > name && end[-1] != '/')
+		end--;
+	while (end > name && end[-1] == '/')
+		end--;
+	return end - name;
+}
+
+static bool walk_cache_lookup(struct nameidata *nd, struct mnt_idmap *idmap,
+			      const char **pname)
+{
+	const char *name = *pname;
+	unsigned int len = walk_prefix_len(name);
+	struct dentry *start = nd->path.dentry;
+	struct super_block *sb = start->d_sb;
+	struct walk_cache_entry *e;
+	struct dentry *dentry = NULL;
+	struct inode *inode = NULL;
+	unsigned int gen, seq = 0, i;
+
+	if (!len || len > WALK_CACHE_MAX_LEN)
+		return false;
+
+	gen = atomic_read(&sb->s_walk_gen);
+	smp_rmb();
+	e = rcu_dereference(walk_cache[walk_cache_hash(nd->path.mnt, start,
+						       name, len)]);
+	if (!e || e->gen != gen || e->mnt != nd->path.mnt ||
+	    e->start != start || e->len != len || memcmp(e->name, name, len))
+		return false;
+
+	if (inode_permission(idmap, nd->inode, MAY_EXEC|MAY_NOT_BLOCK))
+		return false;
+	for (i = 0; i < e->depth; i++) {
+		dentry = e->path[i].dentry;
+		seq = raw_seqcount_begin(&dentry->d_seq);
+		if (seq != e->path[i].seq)
+			return false;
+		inode = READ_ONCE(dentry->d_inode);
+		if (unlikely(!inode || !d_can_lookup(dentry) ||
+			     d_managed(dentry)))
+			return false;
+		/* the last one is checked by link_path_walk() itself */
+		if (i + 1 < e->depth &&
+		    inode_permission(idmap, inode, MAY_EXEC|MAY_NOT_BLOCK))
+			return false;
+		if (read_seqcount_retry(&dentry->d_seq, seq))
+			return false;
+	}
+	smp_rmb();
+	if (atomic_read(&sb->s_walk_gen) != gen)
+		return false;
+
+	nd->path.dentry = dentry;
+	nd->inode = inode;
+	nd->seq = seq;
+	nd->state &= ~ND_JUMPED;
+	name += len;
+	while (*name == '/')
+		name++;
+	*pname = name;
+	return true;
+}
+
+static void walk_cache_record(struct nameidata *nd)
+{
+	const char *name = nd->wc_name, *p;
+	struct dentry *start = nd->wc_start.dentry;
+	struct dentry *dentry = nd->path.dentry, *parent = NULL;
+	unsigned int len, depth = 0, gen, i, idx;
+	struct walk_cache_entry *e, *old;
+
+	nd->wc_name = NULL;
+	if (!(nd->flags & LOOKUP_RCU) || nd->path.mnt != nd->wc_start.mnt)
+		return;
+	len = walk_prefix_len(name);
+	if (!len || len > WALK_CACHE_MAX_LEN)
+		return;
+
+	e = kmalloc(struct_size(e, name, len), GFP_NOWAIT | __GFP_NOWARN);
+	if (!e)
+		return;
+	gen = atomic_read(&start->d_sb->s_walk_gen);
+	smp_rmb();
+
+	/* walk the components backwards, matching them against ->d_parent */
+	for (p = name + len; p > name; ) {
+		const char *end = p;
+		unsigned int clen;
+		bool ok;
+
+		while (p > name && p[-1] != '/')
+			p--;
+		clen = end - p;
+		while (p > name && p[-1] == '/')
+			p--;
+		if (clen == 1 && end[-1] == '.')
+			continue;
+
+		if (depth == WALK_CACHE_MAX_DEPTH || dentry == start)
+			goto fail;
+		spin_lock(&dentry->d_lock);
+		ok = !d_unhashed(dentry) && d_can_lookup(dentry) &&
+		     !(dentry->d_flags & (DCACHE_MANAGED_DENTRY |
+					  DCACHE_OP_REVALIDATE |
+					  DCACHE_OP_HASH)) &&
+		     dentry->d_name.len == clen &&
+		     !memcmp(dentry->d_name.name, end - clen, clen);
+		if (ok) {
+			dentry->d_flags |= DCACHE_WALK_CACHED;
+			e->path[depth].dentry = dentry;
+			e->path[depth].seq = raw_seqcount_begin(&dentry->d_seq);
+			depth++;
+			parent = dentry->d_parent;
+		}
+		spin_unlock(&dentry->d_lock);
+		if (!ok)
+			goto fail;
+		dentry = parent;
+	}
+	if (dentry != start || !depth)
+		goto fail;
+
+	for (i = 0; i < depth / 2; i++)
+		swap(e->path[i], e->path[depth - 1 - i]);
+	e->mnt = nd->path.mnt;
+	e->start = start;
+	e->gen = gen;
+	e->depth = depth;
+	e->len = len;
+	memcpy(e->name, name, len);
+
+	if (!READ_ONCE(walk_cache_used))
+		WRITE_ONCE(walk_cache_used, true);
+	idx = walk_cache_hash(e->mnt, start, name, len);
+	old = unrcu_pointer(xchg(&walk_cache[idx], RCU_INITIALIZER(e)));
+	if (old)
+		kfree_rcu(old, rcu);
+	return;
+fail:
+	kfree(e);
+}
+
+/* called before @mnt is freed, entries pointing to it must be gone by then */
+void walk_cache_purge(struct vfsmount *mnt)
+{
+	struct walk_cache_entry *e;
+	unsigned int i;
+
+	if (!READ_ONCE(walk_cache_used))
+		return;
+
+	rcu_read_lock();
+	for (i = 0; i < ARRAY_SIZE(walk_cache); i++) {
+		e = rcu_dereference(walk_cache[i]);
+		if (!e || e->mnt != mnt)
+			continue;
+		if (cmpxchg(&walk_cache[i], RCU_INITIALIZER(e), NULL) ==
+		    RCU_INITIALIZER(e))
+			kfree_rcu(e, rcu);
+	}
+	rcu_read_unlock();
+}
+
 /*
  * Name resolution.
  * This is the basic name resolution function, turning a pathname into
@@ -2262,6 +2480,14 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 		return 0;
 	}
 
+	nd->wc_name = NULL;
+	if (unlikely(READ_ONCE(nd->path.mnt->mnt_flags) & MNT_WALKCACHE) &&
+	    (nd->flags & LOOKUP_RCU) && !nd->depth &&
+	    !walk_cache_lookup(nd, mnt_idmap(nd->path.mnt), &name)) {
+		nd->wc_start = nd->path;
+		nd->wc_name = name;
+	}
+
 	/* At this point we know we have a real path component. */
 	for(;;) {
 		struct mnt_idmap *idmap;
@@ -2282,6 +2508,7 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 				if (name[1] == '.') {
 					type = LAST_DOTDOT;
 					nd->state |= ND_JUMPED;
+					nd->wc_name = NULL;
 				}
 				break;
 			case 1:
@@ -2318,6 +2545,8 @@ static int link_path_walk(const char *name, struct nameidata *nd)
 OK:
 			/* pathname or trailing symlink, done */
 			if (!depth) {
+				if (unlikely(nd->wc_name))
+					walk_cache_record(nd);
 				nd->dir_vfsuid = i_uid_into_vfsuid(idmap, nd->inode);
 				nd->dir_mode = nd->inode->i_mode;
 				nd->flags &= ~LOOKUP_PARENT;
@@ -1263,6 +1263,7 @@ static void cleanup_mnt(struct mount *mnt)
 		mntput(&m->mnt);
 	}
 	fsnotify_vfsmount_delete(&mnt->mnt);
+	walk_cache_purge(&mnt->mnt);
 	dput(mnt->mnt.mnt_root);
 	deactivate_super(mnt->mnt.mnt_sb);
 	mnt_free_id(mnt);
@@ -3909,7 +3910,7 @@ SYSCALL_DEFINE5(mount, char __user *, dev_name, char __user *, dir_name,
 #define FSMOUNT_VALID_FLAGS                                                    \
 	(MOUNT_ATTR_RDONLY | MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV |            \
 	 MOUNT_ATTR_NOEXEC | MOUNT_ATTR__ATIME | MOUNT_ATTR_NODIRATIME |       \
-	 MOUNT_ATTR_NOSYMFOLLOW)
+	 MOUNT_ATTR_NOSYMFOLLOW | MOUNT_ATTR_WALKCACHE)
 
 #define MOUNT_SETATTR_VALID_FLAGS (FSMOUNT_VALID_FLAGS | MOUNT_ATTR_IDMAP)
 
@@ -3932,6 +3933,8 @@ static unsigned int attr_flags_to_mnt_flags(u64 attr_flags)
 		mnt_flags |= MNT_NODIRATIME;
 	if (attr_flags & MOUNT_ATTR_NOSYMFOLLOW)
 		mnt_flags |= MNT_NOSYMFOLLOW;
+	if (attr_flags & MOUNT_ATTR_WALKCACHE)
+		mnt_flags |= MNT_WALKCACHE;
 
 	return mnt_flags;
 }
@@ -4738,6 +4741,8 @@ static u64 mnt_to_attr_flags(struct vfsmount *mnt)
 		attr_flags |= MOUNT_ATTR_NODIRATIME;
 	if (mnt_flags & MNT_NOSYMFOLLOW)
 		attr_flags |= MOUNT_ATTR_NOSYMFOLLOW;
+	if (mnt_flags & MNT_WALKCACHE)
+		attr_flags |= MOUNT_ATTR_WALKCACHE;
 
 	if (mnt_flags & MNT_NOATIME)
 		attr_flags |= MOUNT_ATTR_NOATIME;
@@ -140,6 +140,34 @@ static void netfs_cache_expand_readahead(struct netfs_io_request *rreq,
 		cres->ops->expand_readahead(cres, _start, _len, i_size);
 }
 
+/*
+ * If the file is being cached, optionally round the readahead out to large
+ * aligned chunks so that the data the netfs downloads, and thus copies to the
+ * cache, runs ahead of what the application has read so far.
+ */
+static void netfs_cache_prefetch(struct netfs_io_request *rreq)
+{
+	unsigned long long chunk, start, end;
+	unsigned int kb = READ_ONCE(netfs_cache_prefetch_kb);
+
+	if (!kb || rreq->origin != NETFS_READAHEAD ||
+	    !fscache_resources_valid(&rreq->cache_resources))
+		return;
+
+	chunk = max_t(unsigned long long, rounddown_pow_of_two(kb) * 1024,
+		      PAGE_SIZE);
+	start = round_down(rreq->start, chunk);
+	end = min(round_up(rreq->start + rreq->len, chunk),
+		  round_up(rreq->i_size, PAGE_SIZE));
+	if (end <= rreq->start + rreq->len && start == rreq->start)
+		return;
+
+	netfs_stat(&netfs_n_rh_prefetch);
+	end = max(end, rreq->start + rreq->len);
+	rreq->start = start;
+	rreq->len = end - start;
+}
+
 static void netfs_rreq_expand(struct netfs_io_request *rreq,
 			      struct readahead_control *ractl)
 {
@@ -154,6 +182,8 @@ static void netfs_rreq_expand(struct netfs_io_request *rreq,
 	if (rreq->netfs_ops->expand_readahead)
 		rreq->netfs_ops->expand_readahead(rreq);
 
+	netfs_cache_prefetch(rreq);
+
 	/* Expand the request if the cache wants it to start earlier.  Note
 	 * that the expansion may get further extended if the VM wishes to
 	 * insert THPs and the preferred start and/or end wind up in the middle
@@ -35,6 +35,7 @@ int netfs_begin_read(struct netfs_io_request *rreq, bool sync);
  * main.c
  */
 extern unsigned int netfs_debug;
+extern unsigned int netfs_cache_prefetch_kb;
 extern struct list_head netfs_io_requests;
 extern spinlock_t netfs_proc_lock;
 extern mempool_t netfs_request_pool;
@@ -98,6 +99,7 @@ static inline void netfs_see_request(struct netfs_io_request *rreq,
 #ifdef CONFIG_NETFS_STATS
 extern atomic_t netfs_n_rh_dio_read;
 extern atomic_t netfs_n_rh_readahead;
+extern atomic_t netfs_n_rh_prefetch;
 extern atomic_t netfs_n_rh_read_folio;
 extern atomic_t netfs_n_rh_rreq;
 extern atomic_t netfs_n_rh_sreq;
@@ -126,6 +128,8 @@ extern atomic_t netfs_n_wh_upload_failed;
 extern atomic_t netfs_n_wh_write;
 extern atomic_t netfs_n_wh_write_done;
 extern atomic_t netfs_n_wh_write_failed;
+extern atomic_t netfs_n_wh_write_batch;
+extern atomic_t netfs_n_wh_write_batched;
 
 int netfs_stats_show(struct seq_file *m, void *v);
 
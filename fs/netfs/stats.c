@@ -11,6 +11,7 @@
 
 atomic_t netfs_n_rh_dio_read;
 atomic_t netfs_n_rh_readahead;
+atomic_t netfs_n_rh_prefetch;
 atomic_t netfs_n_rh_read_folio;
 atomic_t netfs_n_rh_rreq;
 atomic_t netfs_n_rh_sreq;
@@ -39,6 +40,8 @@ atomic_t netfs_n_wh_upload_failed;
 atomic_t netfs_n_wh_write;
 atomic_t netfs_n_wh_write_done;
 atomic_t netfs_n_wh_write_failed;
+atomic_t netfs_n_wh_write_batch;
+atomic_t netfs_n_wh_write_batched;
 
 int netfs_stats_show(struct seq_file *m, void *v)
 {
@@ -74,6 +77,11 @@ int netfs_stats_show(struct seq_file *m, void *v)
 		   atomic_read(&netfs_n_wh_write),
 		   atomic_read(&netfs_n_wh_write_done),
 		   atomic_read(&netfs_n_wh_write_failed));
+	seq_printf(m, "Netfs  : PF=%u\n",
+		   atomic_read(&netfs_n_rh_prefetch));
+	seq_printf(m, "Netfs  : BA=%u ba=%u\n",
+		   atomic_read(&netfs_n_wh_write_batch),
+		   atomic_read(&netfs_n_wh_write_batched));
 	seq_printf(m, "Netfs  : rr=%u sr=%u wsc=%u\n",
 		   atomic_read(&netfs_n_rh_rreq),
 		   atomic_read(&netfs_n_rh_sreq),
@@ -34,8 +34,12 @@
 #include <linux/fs.h>
 #include <linux/mm.h>
 #include <linux/pagemap.h>
+#include <linux/blkdev.h>
 #include "internal.h"
 
+/* Maximum number of subrequests gathered into one cross-inode write batch */
+#define NETFS_WRITE_BATCH_MAX	32
+
 /*
  * Kill all dirty folios in the event of an unrecoverable error, starting with
  * a locked folio we've already obtained from writeback_iter().
@@ -205,6 +209,97 @@ static void netfs_prepare_write(struct netfs_io_request *wreq,
 	stream->construct = subreq;
 }
 
+#ifdef CONFIG_BLOCK
+/*
+ * Upload subrequests gathered under the caller's plug (writeback plugs around
+ * each pass over a superblock's dirty inodes), so that filesystems that can
+ * send compound requests get the small writes of many inodes in one go.
+ */
+struct netfs_write_batch {
+	struct blk_plug_cb	cb;		/* cb.data is the superblock */
+	struct work_struct	work;
+	struct list_head	subreqs;
+	unsigned int		nr;
+};
+
+static void netfs_write_batch_flush(struct netfs_write_batch *batch)
+{
+	struct netfs_io_subrequest *subreq;
+	LIST_HEAD(subreqs);
+
+	if (!batch->nr)
+		return;
+	list_splice_init(&batch->subreqs, &subreqs);
+	batch->nr = 0;
+
+	subreq = list_first_entry(&subreqs, struct netfs_io_subrequest, batch_link);
+	netfs_stat(&netfs_n_wh_write_batch);
+	subreq->rreq->netfs_ops->issue_write_batch(&subreqs);
+	WARN_ON_ONCE(!list_empty(&subreqs));
+}
+
+static void netfs_write_batch_worker(struct work_struct *work)
+{
+	struct netfs_write_batch *batch =
+		container_of(work, struct netfs_write_batch, work);
+
+	netfs_write_batch_flush(batch);
+	kfree(batch);
+}
+
+static void netfs_write_batch_unplug(struct blk_plug_cb *cb, bool from_schedule)
+{
+	struct netfs_write_batch *batch =
+		container_of(cb, struct netfs_write_batch, cb);
+
+	/* We're about to sleep, so the batch mustn't wait for us. */
+	if (from_schedule) {
+		INIT_WORK(&batch->work, netfs_write_batch_worker);
+		queue_work(system_unbound_wq, &batch->work);
+		return;
+	}
+	netfs_write_batch_flush(batch);
+	kfree(batch);
+}
+
+/*
+ * Add an upload subrequest to the current cross-inode batch rather than
+ * issuing it, if the filesystem supports that and the caller is plugged.
+ */
+static bool netfs_write_batch_add(struct netfs_io_stream *stream,
+				  struct netfs_io_subrequest *subreq)
+{
+	struct netfs_io_request *wreq = subreq->rreq;
+	struct netfs_write_batch *batch;
+	struct blk_plug_cb *cb;
+
+	if (!wreq->netfs_ops->issue_write_batch ||
+	    stream->source != NETFS_UPLOAD_TO_SERVER ||
+	    wreq->origin != NETFS_WRITEBACK)
+		return false;
+
+	cb = blk_check_plugged(netfs_write_batch_unplug, wreq->inode->i_sb,
+			       sizeof(*batch));
+	if (!cb)
+		return false;
+
+	batch = container_of(cb, struct netfs_write_batch, cb);
+	if (!batch->nr)
+		INIT_LIST_HEAD(&batch->subreqs);
+	list_add_tail(&subreq->batch_link, &batch->subreqs);
+	netfs_stat(&netfs_n_wh_write_batched);
+	if (++batch->nr >= NETFS_WRITE_BATCH_MAX)
+		netfs_write_batch_flush(batch);
+	return true;
+}
+#else
+static bool netfs_write_batch_add(struct netfs_io_stream *stream,
+				  struct netfs_io_subrequest *subreq)
+{
+	return false;
+}
+#endif
+
 /*
  * Set the I/O iterator for the filesystem/cache to use and dispatch the I/O
  * operation.  The operation may be asynchronous and should call
@@ -234,6 +329,8 @@ static void netfs_do_issue_write(struct netfs_io_stream *stream,
 	}
 
 	trace_netfs_sreq(subreq, netfs_sreq_trace_submit);
+	if (netfs_write_batch_add(stream, subreq))
+		return;
 	stream->issue_write(subreq);
 }
 
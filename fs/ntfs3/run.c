@@ -23,6 +23,49 @@ struct ntfs_run {
 	CLST lcn; /* Logical cluster number. */
 };
 
+/*
+ * run_set_hint - Remember the run a lookup ended in.
+ *
+ * Only a cache: it is checked against the runs before use, so it may be
+ * written under a shared lock and goes stale harmlessly when runs change.
+ */
+static inline void run_set_hint(const struct runs_tree *run, size_t index)
+{
+	WRITE_ONCE(((struct runs_tree *)run)->hint, index);
+}
+
+/*
+ * run_lookup_hint - Check the run of the last lookup and the one after it.
+ *
+ * Sequential reads of a fragmented file walk the runs in order, so most
+ * lookups end here without touching the binary search.
+ */
+static inline bool run_lookup_hint(const struct runs_tree *run, CLST vcn,
+				   size_t *index)
+{
+	size_t idx = READ_ONCE(run->hint);
+	const struct ntfs_run *r;
+
+	if (idx >= run->count)
+		return false;
+
+	r = run->runs + idx;
+	if (vcn < r->vcn)
+		return false;
+
+	if (vcn >= r->vcn + r->len) {
+		if (++idx >= run->count)
+			return false;
+		r++;
+		if (vcn < r->vcn || vcn >= r->vcn + r->len)
+			return false;
+		run_set_hint(run, idx);
+	}
+
+	*index = idx;
+	return true;
+}
+
 /*
  * run_lookup - Lookup the index of a MCB entry that is first <= vcn.
  *
@@ -41,6 +84,9 @@ static bool run_lookup(const struct runs_tree *run, CLST vcn, size_t *index)
 		return false;
 	}
 
+	if (run_lookup_hint(run, vcn, index))
+		return true;
+
 	min_idx = 0;
 	max_idx = run->count - 1;
 
@@ -64,6 +110,7 @@ static bool run_lookup(const struct runs_tree *run, CLST vcn, size_t *index)
 
 	if (vcn >= r->vcn) {
 		*index = max_idx;
+		run_set_hint(run, max_idx);
 		return true;
 	}
 
@@ -79,6 +126,7 @@ static bool run_lookup(const struct runs_tree *run, CLST vcn, size_t *index)
 			min_idx = mid_idx + 1;
 		} else {
 			*index = mid_idx;
+			run_set_hint(run, mid_idx);
 			return true;
 		}
 	} while (min_idx <= max_idx);
@@ -19,6 +19,7 @@
 #include <linux/fdtable.h>
 #include <linux/ratelimit.h>
 #include <linux/exportfs.h>
+#include <linux/fadvise.h>
 #include "overlayfs.h"
 
 #define OVL_COPY_UP_CHUNK_SIZE (1 << 20)
@@ -254,6 +255,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool copy_range;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -281,6 +283,17 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	if (old_file->f_mode & FMODE_LSEEK)
 		skip_hole = true;
 
+	/*
+	 * The whole file could not be cloned, but copy_file_range() may still
+	 * clone block aligned ranges or offload the copy (e.g. server side
+	 * copy), so prefer it over a page cache copy while it keeps working.
+	 */
+	copy_range = file_inode(old_file)->i_sb == file_inode(new_file)->i_sb ||
+		     new_file->f_op->copy_file_range;
+
+	/* The lower file is read once from start to end */
+	vfs_fadvise(old_file, 0, len, POSIX_FADV_SEQUENTIAL);
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		ssize_t bytes;
@@ -331,6 +344,20 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 		if (error)
 			break;
 
+		if (copy_range) {
+			bytes = vfs_copy_file_range(old_file, old_pos,
+						    new_file, new_pos,
+						    this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+				len -= bytes;
+				continue;
+			}
+			/* no offload for this pair of files, use splice */
+			copy_range = false;
+		}
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
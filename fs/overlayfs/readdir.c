@@ -13,8 +13,14 @@
 #include <linux/security.h>
 #include <linux/cred.h>
 #include <linux/ratelimit.h>
+#include <linux/module.h>
 #include "overlayfs.h"
 
+static bool ovl_readdir_cache_keep;
+module_param_named(readdir_cache_keep, ovl_readdir_cache_keep, bool, 0644);
+MODULE_PARM_DESC(readdir_cache_keep,
+		 "Keep merged directory caches until the inode is evicted");
+
 struct ovl_cache_entry {
 	unsigned int len;
 	unsigned int type;
@@ -31,6 +37,7 @@ struct ovl_cache_entry {
 
 struct ovl_dir_cache {
 	long refcount;
+	bool pinned;	/* the inode holds a reference */
 	u64 version;
 	struct list_head entries;
 	struct rb_root root;
@@ -254,6 +261,22 @@ static void ovl_cache_put(struct ovl_dir_file *od, struct inode *inode)
 	}
 }
 
+/* Detach the merged dir cache from the inode, dropping its pin if any */
+static void ovl_cache_unpin(struct inode *inode)
+{
+	struct ovl_dir_cache *cache = ovl_dir_cache(inode);
+
+	ovl_set_dir_cache(inode, NULL);
+	if (cache && cache->pinned) {
+		cache->pinned = false;
+		WARN_ON(cache->refcount <= 0);
+		if (!--cache->refcount) {
+			ovl_cache_free(&cache->entries);
+			kfree(cache);
+		}
+	}
+}
+
 static bool ovl_fill_merge(struct dir_context *ctx, const char *name,
 			  int namelen, loff_t offset, u64 ino,
 			  unsigned int d_type)
@@ -409,7 +432,7 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 		cache->refcount++;
 		return cache;
 	}
-	ovl_set_dir_cache(d_inode(dentry), NULL);
+	ovl_cache_unpin(inode);
 
 	cache = kzalloc(sizeof(struct ovl_dir_cache), GFP_KERNEL);
 	if (!cache)
@@ -427,6 +450,15 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 	}
 
 	cache->version = ovl_inode_version_get(inode);
+	/*
+	 * Lower layers cannot change and all changes to the upper dir made
+	 * through overlayfs bump the version, so the cache may be kept
+	 * around for the next open.
+	 */
+	if (ovl_readdir_cache_keep) {
+		cache->pinned = true;
+		cache->refcount++;
+	}
 	ovl_set_dir_cache(inode, cache);
 
 	return cache;
@@ -121,8 +121,9 @@ static void anon_pipe_buf_release(struct pipe_inode_info *pipe,
 	 * If nobody else uses this page, and we don't already have a
 	 * temporary page, let's keep track of it as a one-deep
 	 * allocation cache. (Otherwise just release our reference to it)
+	 * Only order-0 pages are cached, see pipe_write().
 	 */
-	if (page_count(page) == 1 && !pipe->tmp_page)
+	if (page_count(page) == 1 && !pipe->tmp_page && !PageCompound(page))
 		pipe->tmp_page = page;
 	else
 		put_page(page);
@@ -133,7 +134,8 @@ static bool anon_pipe_buf_try_steal(struct pipe_inode_info *pipe,
 {
 	struct page *page = buf->page;
 
-	if (page_count(page) != 1)
+	/* stealers expect a single page */
+	if (page_count(page) != 1 || PageCompound(page))
 		return false;
 	memcg_kmem_uncharge_page(page, 0);
 	__SetPageLocked(page);
@@ -424,6 +426,55 @@ static inline bool pipe_writable(const struct pipe_inode_info *pipe)
 		!READ_ONCE(pipe->readers);
 }
 
+/*
+ * Large writes get buffers of up to PAGE_ALLOC_COSTLY_ORDER, cutting down on
+ * the number of slots and page references per byte moved through the pipe.
+ * Since a pipe is limited by its number of slots, only use a large buffer
+ * while the memory held by the pipe stays within what it could hold with
+ * order-0 buffers. The remaining slots may still be filled with order-0
+ * pages after that, so a pipe never holds more than twice its size.
+ */
+static struct page *pipe_alloc_buf_page(struct pipe_inode_info *pipe,
+					size_t len)
+{
+	unsigned int mask = pipe->ring_size - 1;
+	size_t size = (size_t)pipe->max_usage << PAGE_SHIFT;
+	unsigned int tail, order;
+	struct page *page;
+	size_t used = 0;
+
+	if (len < 2 * PAGE_SIZE)
+		goto order0;
+
+	order = min_t(unsigned int, ilog2(len >> PAGE_SHIFT),
+		      PAGE_ALLOC_COSTLY_ORDER);
+	for (tail = pipe->tail; tail != pipe->head; tail++) {
+		struct pipe_buffer *buf = &pipe->bufs[tail & mask];
+
+		if (buf->ops == &anon_pipe_buf_ops)
+			used += page_size(buf->page);
+		else
+			used += PAGE_SIZE;
+	}
+	while (order && used + (PAGE_SIZE << order) > size)
+		order--;
+	if (!order)
+		goto order0;
+
+	/* large buffers are lowmem, so kmap() users see them contiguous */
+	page = alloc_pages(GFP_USER | __GFP_ACCOUNT | __GFP_COMP |
+			   __GFP_NORETRY | __GFP_NOWARN, order);
+	if (page)
+		return page;
+order0:
+	page = pipe->tmp_page;
+	if (page) {
+		pipe->tmp_page = NULL;
+		return page;
+	}
+	return alloc_page(GFP_HIGHUSER | __GFP_ACCOUNT);
+}
+
 static ssize_t
 pipe_write(struct kiocb *iocb, struct iov_iter *from)
 {
@@ -477,7 +528,7 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 		int offset = buf->offset + buf->len;
 
 		if ((buf->flags & PIPE_BUF_FLAG_CAN_MERGE) &&
-		    offset + chars <= PAGE_SIZE) {
+		    offset + chars <= page_size(buf->page)) {
 			ret = pipe_buf_confirm(pipe, buf);
 			if (ret)
 				goto out;
@@ -506,16 +557,15 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 		if (!pipe_full(head, pipe->tail, pipe->max_usage)) {
 			unsigned int mask = pipe->ring_size - 1;
 			struct pipe_buffer *buf;
-			struct page *page = pipe->tmp_page;
-			int copied;
-
-			if (!page) {
-				page = alloc_page(GFP_HIGHUSER | __GFP_ACCOUNT);
-				if (unlikely(!page)) {
-					ret = ret ? : -ENOMEM;
-					break;
-				}
-				pipe->tmp_page = page;
+			struct page *page;
+			size_t copied;
+
+			/* packets are at most a page, keep them that way */
+			page = pipe_alloc_buf_page(pipe, is_packetized(filp) ?
+						   0 : iov_iter_count(from));
+			if (unlikely(!page)) {
+				ret = ret ? : -ENOMEM;
+				break;
 			}
 
 			/* Allocate a slot in the ring in advance and attach an
@@ -535,10 +585,11 @@ pipe_write(struct kiocb *iocb, struct iov_iter *from)
 				buf->flags = PIPE_BUF_FLAG_PACKET;
 			else
 				buf->flags = PIPE_BUF_FLAG_CAN_MERGE;
-			pipe->tmp_page = NULL;
 
-			copied = copy_page_from_iter(page, 0, PAGE_SIZE, from);
-			if (unlikely(copied < PAGE_SIZE && iov_iter_count(from))) {
+			copied = copy_page_from_iter(page, 0, page_size(page),
+						     from);
+			if (unlikely(copied < page_size(page) &&
+				     iov_iter_count(from))) {
 				if (!ret)
 					ret = -EFAULT;
 				break;
@@ -72,6 +72,7 @@
 #include <linux/io.h>
 #include <linux/mm.h>
 #include <linux/hugetlb.h>
+#include <linux/khugepaged.h>
 #include <linux/pagemap.h>
 #include <linux/swap.h>
 #include <linux/smp.h>
@@ -424,6 +425,7 @@ static inline void task_thp_status(struct seq_file *m, struct mm_struct *mm)
 	if (thp_enabled)
 		thp_enabled = !test_bit(MMF_DISABLE_THP, &mm->flags);
 	seq_printf(m, "THP_enabled:\t%d\n", thp_enabled);
+	khugepaged_show_mm_stats(m, mm);
 }
 
 static inline void task_untag_mask(struct seq_file *m, struct mm_struct *mm)
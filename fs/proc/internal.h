@@ -171,6 +171,13 @@ extern struct inode *proc_pid_make_inode(struct super_block *, struct task_struc
 extern void pid_update_inode(struct task_struct *, struct inode *);
 extern int pid_delete_dentry(const struct dentry *);
 extern int proc_pid_readdir(struct file *, struct dir_context *);
+struct tgid_iter {
+	unsigned int tgid;
+	struct task_struct *task;
+};
+extern struct tgid_iter next_tgid(struct pid_namespace *, struct tgid_iter);
+extern bool has_pid_permissions(struct proc_fs_info *, struct task_struct *,
+				enum proc_hidepid);
 struct dentry *proc_pid_lookup(struct dentry *, unsigned int);
 extern loff_t mem_lseek(struct file *, loff_t, int);
 
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * /proc/pidstats - fixed layout per-process statistics for all visible
+ * thread groups in a single file, see include/uapi/linux/pidstats.h.
+ */
+#include <linux/cred.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/pid_namespace.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/sched/cputime.h>
+#include <linux/sched/mm.h>
+#include <linux/sched/signal.h>
+#include <linux/sched/task.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/threads.h>
+#include <linux/time_namespace.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/pidstats.h>
+#include "internal.h"
+
+#define PIDSTATS_NR_FIELDS	17
+
+struct pidstats_private {
+	struct pid_namespace	*ns;
+	struct proc_fs_info	*fs_info;
+	u64			mask;
+};
+
+static struct task_struct *pidstats_next_task(struct seq_file *m,
+					      struct task_struct *prev,
+					      loff_t *pos)
+{
+	struct pidstats_private *p = m->private;
+	struct tgid_iter iter = { .task = prev };
+
+	if (*pos >= PID_MAX_LIMIT) {
+		if (prev)
+			put_task_struct(prev);
+		return NULL;
+	}
+
+	iter.tgid = *pos;
+	for (iter = next_tgid(p->ns, iter);
+	     iter.task;
+	     iter.tgid += 1, iter = next_tgid(p->ns, iter)) {
+		/* the same check proc_pid_permission() does for stat */
+		if (has_pid_permissions(p->fs_info, iter.task, HIDEPID_NO_ACCESS))
+			break;
+		cond_resched();
+	}
+	*pos = iter.tgid;
+	return iter.task;
+}
+
+static void *pidstats_start(struct seq_file *m, loff_t *pos)
+{
+	return pidstats_next_task(m, NULL, pos);
+}
+
+static void *pidstats_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	++*pos;
+	return pidstats_next_task(m, v, pos);
+}
+
+static void pidstats_stop(struct seq_file *m, void *v)
+{
+	if (v)
+		put_task_struct(v);
+}
+
+static void pidstats_faults(struct task_struct *task, u64 *min_flt,
+			    u64 *maj_flt)
+{
+	struct signal_struct *sig = task->signal;
+	unsigned int seq = 1;
+	unsigned long flags;
+	struct task_struct *t;
+
+	do {
+		seq++; /* 2 on the 1st/lockless path, otherwise odd */
+		flags = read_seqbegin_or_lock_irqsave(&sig->stats_lock, &seq);
+
+		*min_flt = sig->min_flt;
+		*maj_flt = sig->maj_flt;
+		rcu_read_lock();
+		__for_each_thread(sig, t) {
+			*min_flt += t->min_flt;
+			*maj_flt += t->maj_flt;
+		}
+		rcu_read_unlock();
+	} while (need_seqretry(&sig->stats_lock, seq));
+	done_seqretry_irqrestore(&sig->stats_lock, seq, flags);
+}
+
+static int pidstats_show(struct seq_file *m, void *v)
+{
+	struct pidstats_private *p = m->private;
+	struct task_struct *task = v;
+	struct pidstats_record rec = { 0 };
+	u64 values[PIDSTATS_NR_FIELDS];
+	u64 mask = READ_ONCE(p->mask);
+	u64 ppid = 0, num_threads = 0, uid = 0, gid = 0;
+	u64 utime = 0, stime = 0, min_flt = 0, maj_flt = 0;
+	u64 vsize = 0, rss = 0;
+	unsigned int n = 0;
+
+	if (mask & (PIDSTATS_PPID | PIDSTATS_NUM_THREADS)) {
+		unsigned long flags;
+
+		if (lock_task_sighand(task, &flags)) {
+			num_threads = get_nr_threads(task);
+			ppid = task_tgid_nr_ns(task->real_parent, p->ns);
+			unlock_task_sighand(task, &flags);
+		}
+	}
+	if (mask & (PIDSTATS_UID | PIDSTATS_GID)) {
+		struct user_namespace *user_ns = seq_user_ns(m);
+		const struct cred *cred;
+
+		rcu_read_lock();
+		cred = __task_cred(task);
+		uid = from_kuid_munged(user_ns, cred->uid);
+		gid = from_kgid_munged(user_ns, cred->gid);
+		rcu_read_unlock();
+	}
+	if (mask & (PIDSTATS_UTIME | PIDSTATS_STIME))
+		thread_group_cputime_adjusted(task, &utime, &stime);
+	if (mask & (PIDSTATS_MIN_FLT | PIDSTATS_MAJ_FLT))
+		pidstats_faults(task, &min_flt, &maj_flt);
+	if (mask & (PIDSTATS_VSIZE | PIDSTATS_RSS)) {
+		struct mm_struct *mm = get_task_mm(task);
+
+		if (mm) {
+			vsize = task_vsize(mm);
+			rss = (u64)get_mm_rss(mm) << PAGE_SHIFT;
+			mmput(mm);
+		}
+	}
+
+#define PIDSTATS_PUT(bit, val)			\
+	do {					\
+		if (mask & (bit))		\
+			values[n++] = (val);	\
+	} while (0)
+
+	PIDSTATS_PUT(PIDSTATS_PPID, ppid);
+	PIDSTATS_PUT(PIDSTATS_STATE, task_state_to_char(task));
+	PIDSTATS_PUT(PIDSTATS_UID, uid);
+	PIDSTATS_PUT(PIDSTATS_GID, gid);
+	PIDSTATS_PUT(PIDSTATS_NUM_THREADS, num_threads);
+	PIDSTATS_PUT(PIDSTATS_PRIORITY, (s64)task_prio(task));
+	PIDSTATS_PUT(PIDSTATS_NICE, (s64)task_nice(task));
+	PIDSTATS_PUT(PIDSTATS_UTIME, utime);
+	PIDSTATS_PUT(PIDSTATS_STIME, stime);
+	PIDSTATS_PUT(PIDSTATS_START_TIME,
+		     timens_add_boottime_ns(task->start_boottime));
+	PIDSTATS_PUT(PIDSTATS_MIN_FLT, min_flt);
+	PIDSTATS_PUT(PIDSTATS_MAJ_FLT, maj_flt);
+	PIDSTATS_PUT(PIDSTATS_VSIZE, vsize);
+	PIDSTATS_PUT(PIDSTATS_RSS, rss);
+	PIDSTATS_PUT(PIDSTATS_NVCSW, task->nvcsw);
+	PIDSTATS_PUT(PIDSTATS_NIVCSW, task->nivcsw);
+	PIDSTATS_PUT(PIDSTATS_PROCESSOR, task_cpu(task));
+#undef PIDSTATS_PUT
+
+	rec.size = sizeof(rec) + n * sizeof(u64);
+	rec.pid = task_tgid_nr_ns(task, p->ns);
+	rec.mask = mask;
+	seq_write(m, &rec, sizeof(rec));
+	seq_write(m, values, n * sizeof(u64));
+	return 0;
+}
+
+static const struct seq_operations pidstats_seq_ops = {
+	.start	= pidstats_start,
+	.next	= pidstats_next,
+	.stop	= pidstats_stop,
+	.show	= pidstats_show,
+};
+
+static int pidstats_open(struct inode *inode, struct file *file)
+{
+	struct pidstats_private *p;
+
+	BUILD_BUG_ON(PIDSTATS_ALL != (1ULL << PIDSTATS_NR_FIELDS) - 1);
+
+	p = __seq_open_private(file, &pidstats_seq_ops, sizeof(*p));
+	if (!p)
+		return -ENOMEM;
+	p->ns = proc_pid_ns(inode->i_sb);
+	p->fs_info = proc_sb_info(inode->i_sb);
+	p->mask = PIDSTATS_ALL;
+	return 0;
+}
+
+static ssize_t pidstats_write(struct file *file, const char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	struct pidstats_private *p = ((struct seq_file *)file->private_data)->private;
+	u64 mask;
+
+	if (count != sizeof(mask))
+		return -EINVAL;
+	if (copy_from_user(&mask, buf, sizeof(mask)))
+		return -EFAULT;
+	if (!mask || (mask & ~PIDSTATS_ALL))
+		return -EINVAL;
+	WRITE_ONCE(p->mask, mask);
+	return count;
+}
+
+static const struct proc_ops pidstats_proc_ops = {
+	.proc_flags	= PROC_ENTRY_PERMANENT,
+	.proc_open	= pidstats_open,
+	.proc_read	= seq_read,
+	.proc_write	= pidstats_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= seq_release_private,
+};
+
+static int __init proc_pidstats_init(void)
+{
+	proc_create("pidstats", 0666, NULL, &pidstats_proc_ops);
+	return 0;
+}
+fs_initcall(proc_pidstats_init);
@@ -104,6 +104,28 @@ struct poll_table_page {
 #define POLL_TABLE_FULL(table) \
 	((unsigned long)((table)->entry+1) > PAGE_SIZE + (unsigned long)(table))
 
+/*
+ * Tasks calling poll()/select() in a loop on more fds than fit in the
+ * inline entries allocate and free the same table page every time; keep
+ * one around per CPU.
+ */
+static DEFINE_PER_CPU(struct poll_table_page *, poll_table_cache);
+
+static struct poll_table_page *poll_table_page_alloc(void)
+{
+	struct poll_table_page *table = this_cpu_xchg(poll_table_cache, NULL);
+
+	if (table)
+		return table;
+	return (struct poll_table_page *) __get_free_page(GFP_KERNEL);
+}
+
+static void poll_table_page_free(struct poll_table_page *table)
+{
+	if (this_cpu_cmpxchg(poll_table_cache, NULL, table))
+		free_page((unsigned long) table);
+}
+
 /*
  * Ok, Peter made a complicated, but straightforward multiple_wait() function.
  * I have rewritten this, taking some shortcuts: This code may not be easy to
@@ -153,7 +175,7 @@ void poll_freewait(struct poll_wqueues *pwq)
 		} while (entry > p->entries);
 		old = p;
 		p = p->next;
-		free_page((unsigned long) old);
+		poll_table_page_free(old);
 	}
 }
 EXPORT_SYMBOL(poll_freewait);
@@ -168,7 +190,7 @@ static struct poll_table_entry *poll_get_entry(struct poll_wqueues *p)
 	if (!table || POLL_TABLE_FULL(table)) {
 		struct poll_table_page *new_table;
 
-		new_table = (struct poll_table_page *) __get_free_page(GFP_KERNEL);
+		new_table = poll_table_page_alloc();
 		if (!new_table) {
 			p->error = -ENOMEM;
 			return NULL;
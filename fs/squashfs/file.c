@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -529,6 +530,86 @@ static int squashfs_readahead_fragment(struct page **page,
 	return error;
 }
 
+/*
+ * Maximum number of datablocks a single readahead call reads and decompresses
+ * in parallel, each on its own (per-CPU) decompressor.
+ */
+#define SQUASHFS_RA_MAX_BLOCKS	8
+
+struct squashfs_ra_block {
+	struct work_struct	work;
+	struct inode		*inode;
+	struct page		**pages;
+	unsigned int		nr_pages;
+	unsigned int		expected;
+	u64			block;
+	int			bsize;
+	bool			last;
+};
+
+static void squashfs_readahead_block(struct squashfs_ra_block *rab)
+{
+	struct inode *inode = rab->inode;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	struct squashfs_page_actor *actor;
+	struct page *last_page = NULL;
+	int i, res = -ENOMEM;
+
+	actor = squashfs_page_actor_init_special(msblk, rab->pages,
+						 rab->nr_pages, rab->expected);
+	if (actor) {
+		res = squashfs_read_data(inode->i_sb, rab->block, rab->bsize,
+					 NULL, actor);
+		last_page = squashfs_page_actor_free(actor);
+	}
+
+	if (res == rab->expected) {
+		int bytes;
+
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = res % PAGE_SIZE;
+		if (rab->last && bytes && last_page)
+			memzero_page(last_page, bytes, PAGE_SIZE - bytes);
+
+		for (i = 0; i < rab->nr_pages; i++) {
+			flush_dcache_page(rab->pages[i]);
+			SetPageUptodate(rab->pages[i]);
+		}
+	}
+
+	for (i = 0; i < rab->nr_pages; i++) {
+		unlock_page(rab->pages[i]);
+		put_page(rab->pages[i]);
+	}
+}
+
+static void squashfs_readahead_work(struct work_struct *work)
+{
+	squashfs_readahead_block(container_of(work, struct squashfs_ra_block,
+					      work));
+}
+
+/*
+ * Read and decompress the batched datablocks.  All but the last one are
+ * handed to the unbound workqueue, the last one is done by the caller.
+ */
+static void squashfs_readahead_flush(struct squashfs_ra_block *rab,
+				     unsigned int nr)
+{
+	unsigned int i;
+
+	if (!nr)
+		return;
+
+	for (i = 0; i < nr - 1; i++) {
+		INIT_WORK(&rab[i].work, squashfs_readahead_work);
+		queue_work(system_unbound_wq, &rab[i].work);
+	}
+	squashfs_readahead_block(&rab[nr - 1]);
+	for (i = 0; i < nr - 1; i++)
+		flush_work(&rab[i].work);
+}
+
 static void squashfs_readahead(struct readahead_control *ractl)
 {
 	struct inode *inode = ractl->mapping->host;
@@ -537,26 +618,34 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
 	loff_t start = readahead_pos(ractl) & ~mask;
 	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
-	unsigned int nr_pages = 0;
-	struct page **pages;
+	struct squashfs_ra_block *rab;
+	unsigned int nr_pages = 0, nr_blocks, nr = 0;
+	struct page **pages, **page_array;
 	int i;
 	loff_t file_end = i_size_read(inode) >> msblk->block_log;
-	unsigned int max_pages = 1UL << shift;
+	unsigned int max_pages = 1UL << shift, block_pages = max_pages;
 
 	readahead_expand(ractl, start, (len | mask) + 1);
 
-	pages = kmalloc_array(max_pages, sizeof(void *), GFP_KERNEL);
-	if (!pages)
-		return;
+	nr_blocks = clamp_t(unsigned int, min_t(unsigned int,
+			    msblk->max_thread_num, num_online_cpus()),
+			    1, SQUASHFS_RA_MAX_BLOCKS);
+	nr_blocks = min_t(unsigned int, nr_blocks,
+			  DIV_ROUND_UP(readahead_count(ractl), block_pages));
+
+	rab = kcalloc(nr_blocks, sizeof(*rab), GFP_KERNEL);
+	page_array = kmalloc_array(nr_blocks * block_pages, sizeof(void *),
+				   GFP_KERNEL);
+	if (!rab || !page_array)
+		goto out;
 
 	for (;;) {
 		pgoff_t index;
 		int res, bsize;
 		u64 block = 0;
 		unsigned int expected;
-		struct page *last_page;
 
+		pages = page_array + nr * block_pages;
 		expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
 			    msblk->block_size;
@@ -588,45 +677,33 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (bsize == 0)
 			goto skip_pages;
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							 expected);
-		if (!actor)
-			goto skip_pages;
-
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-
-		last_page = squashfs_page_actor_free(actor);
-
-		if (res == expected) {
-			int bytes;
-
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (index == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
-
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
-		}
-
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
+		rab[nr] = (struct squashfs_ra_block) {
+			.inode = inode,
+			.pages = pages,
+			.nr_pages = nr_pages,
+			.expected = expected,
+			.block = block,
+			.bsize = bsize,
+			.last = index == file_end,
+		};
+		if (++nr == nr_blocks) {
+			squashfs_readahead_flush(rab, nr);
+			nr = 0;
 		}
 	}
 
-	kfree(pages);
-	return;
+	squashfs_readahead_flush(rab, nr);
+	goto out;
 
 skip_pages:
 	for (i = 0; i < nr_pages; i++) {
 		unlock_page(pages[i]);
 		put_page(pages[i]);
 	}
-	kfree(pages);
+	squashfs_readahead_flush(rab, nr);
+out:
+	kfree(page_array);
+	kfree(rab);
 }
 
 const struct address_space_operations squashfs_aops = {
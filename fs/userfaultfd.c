@@ -32,6 +32,9 @@
 #include <linux/swapops.h>
 #include <linux/miscdevice.h>
 #include <linux/uio.h>
+#include <linux/eventfd.h>
+#include <linux/kthread.h>
+#include <linux/workqueue.h>
 
 static int sysctl_unprivileged_userfaultfd __read_mostly;
 
@@ -1748,6 +1751,204 @@ static int userfaultfd_copy(struct userfaultfd_ctx *ctx,
 	return ret;
 }
 
+/*
+ * Handle one entry of a UFFDIO_COPY_VEC vector.  The caller holds a
+ * reference on ctx->mm.  Returns the number of bytes copied or mapped,
+ * or a negative error.
+ */
+static __s64 userfaultfd_copy_vec_one(struct userfaultfd_ctx *ctx,
+				      struct uffdio_copy *uffdio_copy,
+				      bool cont)
+{
+	struct userfaultfd_wake_range range;
+	uffd_flags_t flags = 0;
+	__s64 ret;
+
+	if (atomic_read(&ctx->mmap_changing))
+		return -EAGAIN;
+
+	if (!cont) {
+		ret = validate_unaligned_range(ctx->mm, uffdio_copy->src,
+					       uffdio_copy->len);
+		if (ret)
+			return ret;
+	}
+	ret = validate_range(ctx->mm, uffdio_copy->dst, uffdio_copy->len);
+	if (ret)
+		return ret;
+
+	if (uffdio_copy->mode & ~(UFFDIO_COPY_MODE_DONTWAKE|UFFDIO_COPY_MODE_WP))
+		return -EINVAL;
+	if (uffdio_copy->mode & UFFDIO_COPY_MODE_WP)
+		flags |= MFILL_ATOMIC_WP;
+
+	if (cont)
+		ret = mfill_atomic_continue(ctx, uffdio_copy->dst,
+					    uffdio_copy->len, flags);
+	else
+		ret = mfill_atomic_copy(ctx, uffdio_copy->dst, uffdio_copy->src,
+					uffdio_copy->len, flags);
+	if (ret <= 0)
+		return ret;
+
+	range.len = ret;
+	if (!(uffdio_copy->mode & UFFDIO_COPY_MODE_DONTWAKE)) {
+		range.start = uffdio_copy->dst;
+		wake_userfault(ctx, &range);
+	}
+	return ret;
+}
+
+/*
+ * Process the entries of a vector, writing back the result of each one.
+ * Returns the number of entries completely processed, or -EFAULT.
+ */
+static __s64 userfaultfd_copy_vec_run(struct userfaultfd_ctx *ctx,
+				      struct uffdio_copy __user *vec,
+				      __u64 nr, bool cont)
+{
+	struct uffdio_copy uffdio_copy;
+	__s64 ret;
+	__u64 i;
+
+	for (i = 0; i < nr; i++) {
+		if (copy_from_user(&uffdio_copy, &vec[i],
+				   /* don't copy "copy" last field */
+				   sizeof(uffdio_copy)-sizeof(__s64)))
+			return -EFAULT;
+
+		ret = userfaultfd_copy_vec_one(ctx, &uffdio_copy, cont);
+		if (unlikely(put_user(ret, &vec[i].copy)))
+			return -EFAULT;
+		if (ret != uffdio_copy.len)
+			break;
+		cond_resched();
+	}
+
+	return i;
+}
+
+struct userfaultfd_copy_vec_work {
+	struct work_struct work;
+	struct userfaultfd_ctx *ctx;
+	/* mm of the task that queued the vector, for the source buffers */
+	struct mm_struct *mm;
+	struct uffdio_copy_vec __user *user;
+	struct uffdio_copy __user *vec;
+	__u64 nr;
+	bool cont;
+	struct eventfd_ctx *done;
+};
+
+static void userfaultfd_copy_vec_work_fn(struct work_struct *work)
+{
+	struct userfaultfd_copy_vec_work *cw = container_of(work,
+					struct userfaultfd_copy_vec_work, work);
+	struct userfaultfd_ctx *ctx = cw->ctx;
+	__s64 copied;
+
+	kthread_use_mm(cw->mm);
+	if (mmget_not_zero(ctx->mm)) {
+		copied = userfaultfd_copy_vec_run(ctx, cw->vec, cw->nr,
+						  cw->cont);
+		mmput(ctx->mm);
+	} else {
+		copied = -ESRCH;
+	}
+	put_user(copied, &cw->user->copied);
+	kthread_unuse_mm(cw->mm);
+
+	eventfd_signal(cw->done);
+	eventfd_ctx_put(cw->done);
+	mmput(cw->mm);
+	userfaultfd_ctx_put(ctx);
+	kfree(cw);
+}
+
+static int userfaultfd_copy_vec_async(struct userfaultfd_ctx *ctx,
+				      struct uffdio_copy_vec *uffdio_copy_vec,
+				      struct uffdio_copy_vec __user *user)
+{
+	struct userfaultfd_copy_vec_work *cw;
+	struct eventfd_ctx *done;
+
+	done = eventfd_ctx_fdget(uffdio_copy_vec->eventfd);
+	if (IS_ERR(done))
+		return PTR_ERR(done);
+
+	cw = kmalloc(sizeof(*cw), GFP_KERNEL);
+	if (!cw) {
+		eventfd_ctx_put(done);
+		return -ENOMEM;
+	}
+
+	mmget(current->mm);
+	userfaultfd_ctx_get(ctx);
+	cw->ctx = ctx;
+	cw->mm = current->mm;
+	cw->user = user;
+	cw->vec = u64_to_user_ptr(uffdio_copy_vec->vec);
+	cw->nr = uffdio_copy_vec->nr;
+	cw->cont = uffdio_copy_vec->mode & UFFDIO_COPY_VEC_MODE_CONTINUE;
+	cw->done = done;
+	INIT_WORK(&cw->work, userfaultfd_copy_vec_work_fn);
+	queue_work(system_unbound_wq, &cw->work);
+
+	return 0;
+}
+
+static int userfaultfd_copy_vec(struct userfaultfd_ctx *ctx,
+				unsigned long arg)
+{
+	__s64 ret;
+	struct uffdio_copy_vec uffdio_copy_vec;
+	struct uffdio_copy_vec __user *user_uffdio_copy_vec;
+	bool cont;
+
+	user_uffdio_copy_vec = (struct uffdio_copy_vec __user *) arg;
+
+	ret = -EFAULT;
+	if (copy_from_user(&uffdio_copy_vec, user_uffdio_copy_vec,
+			   /* don't copy "copied" last field */
+			   sizeof(uffdio_copy_vec)-sizeof(__s64)))
+		goto out;
+
+	ret = -EINVAL;
+	if (uffdio_copy_vec.mode & ~(UFFDIO_COPY_VEC_MODE_CONTINUE |
+				     UFFDIO_COPY_VEC_MODE_ASYNC))
+		goto out;
+	if (uffdio_copy_vec.pad || !uffdio_copy_vec.nr ||
+	    uffdio_copy_vec.nr > UFFDIO_COPY_VEC_MAX)
+		goto out;
+	cont = uffdio_copy_vec.mode & UFFDIO_COPY_VEC_MODE_CONTINUE;
+
+	ret = -EFAULT;
+	if (!access_ok(u64_to_user_ptr(uffdio_copy_vec.vec),
+		       uffdio_copy_vec.nr * sizeof(struct uffdio_copy)))
+		goto out;
+
+	if (uffdio_copy_vec.mode & UFFDIO_COPY_VEC_MODE_ASYNC)
+		return userfaultfd_copy_vec_async(ctx, &uffdio_copy_vec,
+						  user_uffdio_copy_vec);
+
+	/* A single mm reference covers the whole vector */
+	if (mmget_not_zero(ctx->mm)) {
+		ret = userfaultfd_copy_vec_run(ctx,
+				u64_to_user_ptr(uffdio_copy_vec.vec),
+				uffdio_copy_vec.nr, cont);
+		mmput(ctx->mm);
+	} else {
+		return -ESRCH;
+	}
+	if (ret < 0)
+		goto out;
+	if (unlikely(put_user(ret, &user_uffdio_copy_vec->copied)))
+		return -EFAULT;
+	ret = ret == uffdio_copy_vec.nr ? 0 : -EAGAIN;
+out:
+	return ret;
+}
+
 static int userfaultfd_zeropage(struct userfaultfd_ctx *ctx,
 				unsigned long arg)
 {
@@ -2142,6 +2343,9 @@ static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 	case UFFDIO_POISON:
 		ret = userfaultfd_poison(ctx, arg);
 		break;
+	case UFFDIO_COPY_VEC:
+		ret = userfaultfd_copy_vec(ctx, arg);
+		break;
 	}
 	return ret;
 }
@@ -119,6 +119,8 @@ struct aead_request {
  * @setkey: see struct skcipher_alg
  * @encrypt: see struct skcipher_alg
  * @decrypt: see struct skcipher_alg
+ * @encrypt_batch: see struct skcipher_alg
+ * @decrypt_batch: see struct skcipher_alg
  * @ivsize: see struct skcipher_alg
  * @chunksize: see struct skcipher_alg
  * @init: Initialize the cryptographic transformation object. This function
@@ -134,7 +136,8 @@ struct aead_request {
  *	  @init.
  * @base: Definition of a generic crypto cipher algorithm.
  *
- * All fields except @ivsize is mandatory and must be filled.
+ * All fields except @ivsize, @encrypt_batch and @decrypt_batch are mandatory
+ * and must be filled.
  */
 struct aead_alg {
 	int (*setkey)(struct crypto_aead *tfm, const u8 *key,
@@ -142,6 +145,10 @@ struct aead_alg {
 	int (*setauthsize)(struct crypto_aead *tfm, unsigned int authsize);
 	int (*encrypt)(struct aead_request *req);
 	int (*decrypt)(struct aead_request *req);
+	void (*encrypt_batch)(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
+	void (*decrypt_batch)(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
 	int (*init)(struct crypto_aead *tfm);
 	void (*exit)(struct crypto_aead *tfm);
 
@@ -381,6 +388,34 @@ int crypto_aead_encrypt(struct aead_request *req);
  */
 int crypto_aead_decrypt(struct aead_request *req);
 
+/**
+ * crypto_aead_encrypt_batch() - encrypt a vector of requests
+ * @reqs: the aead_request handles, all on the same cipher handle
+ * @errs: receives the result of each request
+ * @nr: number of requests
+ *
+ * Submit @nr requests at once, see crypto_skcipher_encrypt_batch().
+ *
+ * Return: 0 if the requests were submitted; -EINVAL if they don't share a
+ *	   cipher handle, or -ENOKEY, in which case none was submitted
+ */
+int crypto_aead_encrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
+
+/**
+ * crypto_aead_decrypt_batch() - decrypt a vector of requests
+ * @reqs: the aead_request handles, all on the same cipher handle
+ * @errs: receives the result of each request, -EBADMSG for those failing
+ *	  authentication
+ * @nr: number of requests
+ *
+ * The decryption counterpart of crypto_aead_encrypt_batch().
+ *
+ * Return: see crypto_aead_encrypt_batch()
+ */
+int crypto_aead_decrypt_batch(struct aead_request **reqs, int *errs,
+			      unsigned int nr);
+
 /**
  * DOC: Asynchronous AEAD Request Handle
  *
@@ -53,6 +53,9 @@ struct skcipher_engine_alg {
 
 int crypto_transfer_aead_request_to_engine(struct crypto_engine *engine,
 					   struct aead_request *req);
+void crypto_transfer_aead_requests_to_engine(struct crypto_engine *engine,
+					     struct aead_request **reqs,
+					     int *errs, unsigned int nr);
 int crypto_transfer_akcipher_request_to_engine(struct crypto_engine *engine,
 					       struct akcipher_request *req);
 int crypto_transfer_hash_request_to_engine(struct crypto_engine *engine,
@@ -61,6 +64,9 @@ int crypto_transfer_kpp_request_to_engine(struct crypto_engine *engine,
 					  struct kpp_request *req);
 int crypto_transfer_skcipher_request_to_engine(struct crypto_engine *engine,
 					       struct skcipher_request *req);
+void crypto_transfer_skcipher_requests_to_engine(struct crypto_engine *engine,
+						 struct skcipher_request **reqs,
+						 int *errs, unsigned int nr);
 void crypto_finalize_aead_request(struct crypto_engine *engine,
 				  struct aead_request *req, int err);
 void crypto_finalize_akcipher_request(struct crypto_engine *engine,
@@ -119,6 +119,13 @@ struct skcipher_alg_common SKCIPHER_ALG_COMMON;
  *	     be called in parallel with the same transformation object.
  * @decrypt: Decrypt a single block. This is a reverse counterpart to @encrypt
  *	     and the conditions are exactly the same.
+ * @encrypt_batch: Optional. Encrypt a vector of requests on the same
+ *		   transformation object in one call, storing what @encrypt
+ *		   would have returned for each request in the matching
+ *		   entry of the error vector. This allows drivers to set up
+ *		   the hardware queue or the SIMD unit once for the whole
+ *		   batch. Without it, batches are split into @encrypt calls.
+ * @decrypt_batch: Optional. The @decrypt counterpart of @encrypt_batch.
  * @export: Export partial state of the transformation. This function dumps the
  *	    entire state of the ongoing transformation into a provided block of
  *	    data so it can be @import 'ed back later on. This is useful in case
@@ -146,13 +153,18 @@ struct skcipher_alg_common SKCIPHER_ALG_COMMON;
  * 	      in parallel. Should be a multiple of chunksize.
  * @co: see struct skcipher_alg_common
  *
- * All fields except @ivsize are mandatory and must be filled.
+ * All fields except @ivsize, @encrypt_batch and @decrypt_batch are mandatory
+ * and must be filled.
  */
 struct skcipher_alg {
 	int (*setkey)(struct crypto_skcipher *tfm, const u8 *key,
 	              unsigned int keylen);
 	int (*encrypt)(struct skcipher_request *req);
 	int (*decrypt)(struct skcipher_request *req);
+	void (*encrypt_batch)(struct skcipher_request **reqs, int *errs,
+			      unsigned int nr);
+	void (*decrypt_batch)(struct skcipher_request **reqs, int *errs,
+			      unsigned int nr);
 	int (*export)(struct skcipher_request *req, void *out);
 	int (*import)(struct skcipher_request *req, const void *in);
 	int (*init)(struct crypto_skcipher *tfm);
@@ -705,6 +717,36 @@ int crypto_skcipher_encrypt(struct skcipher_request *req);
  */
 int crypto_skcipher_decrypt(struct skcipher_request *req);
 
+/**
+ * crypto_skcipher_encrypt_batch() - encrypt a vector of requests
+ * @reqs: the skcipher_request handles, all on the same cipher handle
+ * @errs: receives the result of each request
+ * @nr: number of requests
+ *
+ * Submit @nr requests at once. @errs[i] is set to what
+ * crypto_skcipher_encrypt() would have returned for @reqs[i]: 0 if the
+ * request completed, -EINPROGRESS or -EBUSY if its completion callback will
+ * be invoked, or another error. Requests are not ordered against each other.
+ *
+ * Return: 0 if the requests were submitted; -EINVAL if they don't share a
+ *	   cipher handle, or -ENOKEY, in which case none was submitted
+ */
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr);
+
+/**
+ * crypto_skcipher_decrypt_batch() - decrypt a vector of requests
+ * @reqs: the skcipher_request handles, all on the same cipher handle
+ * @errs: receives the result of each request
+ * @nr: number of requests
+ *
+ * The decryption counterpart of crypto_skcipher_encrypt_batch().
+ *
+ * Return: see crypto_skcipher_encrypt_batch()
+ */
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs, int *errs,
+				  unsigned int nr);
+
 /**
  * crypto_skcipher_export() - export partial state
  * @req: reference to the skcipher_request handle that holds all information
@@ -120,10 +120,13 @@ int bdi_set_strict_limit(struct backing_dev_info *bdi, unsigned int strict_limit
  *				should contribute to accounting
  * BDI_CAP_WRITEBACK_ACCT:	Automatically account writeback pages
  * BDI_CAP_STRICTLIMIT:		Keep number of dirty pages below bdi threshold
+ * BDI_CAP_RA_HISTORY:		Seed readahead of new opens from the inode's
+ *				previous access pattern
  */
 #define BDI_CAP_WRITEBACK		(1 << 0)
 #define BDI_CAP_WRITEBACK_ACCT		(1 << 1)
 #define BDI_CAP_STRICTLIMIT		(1 << 2)
+#define BDI_CAP_RA_HISTORY		(1 << 3)
 
 extern struct backing_dev_info noop_backing_dev_info;
 
@@ -113,6 +113,10 @@ struct ceph_messenger {
 	 */
 	u32 global_seq;
 	spinlock_t global_seq_lock;
+
+	/* plain (msgr2 crc mode) data receive, see debugfs */
+	atomic64_t rx_data_bytes;
+	atomic64_t rx_data_batches;
 };
 
 enum ceph_msg_data_type {
@@ -395,6 +399,8 @@ struct ceph_connection_v2_info {
 	struct iov_iter in_iter;
 	struct kvec in_kvecs[5];  /* recvmsg */
 	struct bio_vec in_bvec;  /* recvmsg (in_cursor) */
+	struct bio_vec in_data_bvecs[16];  /* recvmsg (in_cursor, batched) */
+	int in_data_bvec_cnt;
 	int in_kvec_cnt;
 	int in_state;  /* IN_S_* */
 
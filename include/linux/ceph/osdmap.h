@@ -41,6 +41,8 @@ int ceph_spg_compare(const struct ceph_spg *lhs, const struct ceph_spg *rhs);
 							will set FULL too */
 #define CEPH_POOL_FLAG_NEARFULL		(1ULL << 11) /* pool is nearfull */
 
+struct ceph_pg_acting_cache;
+
 struct ceph_pg_pool_info {
 	struct rb_node node;
 	s64 id;
@@ -57,6 +59,9 @@ struct ceph_pg_pool_info {
 	u64 flags; /* CEPH_POOL_FLAG_* */
 	char *name;
 
+	/* up/acting sets of recently mapped PGs, see osdmap.c */
+	struct ceph_pg_acting_cache *acting_cache;
+
 	bool was_full;  /* for handle_one_map() */
 };
 
@@ -171,8 +171,19 @@ struct cgroup_subsys_state {
 	struct list_head sibling;
 	struct list_head children;
 
-	/* flush target list anchored at cgrp->rstat_css_list */
-	struct list_head rstat_css_node;
+	/*
+	 * Per-cpu links of the updated tree, see css_rstat_updated().  Only
+	 * the self css of a cgroup and the csses of the subsystems which
+	 * implement ->css_rstat_flush() have them.
+	 */
+	struct css_rstat_cpu __percpu *rstat_cpu;
+
+	/*
+	 * A singly-linked list of csses to be rstat flushed.  This is a
+	 * scratch field to be used exclusively by css_rstat_flush_locked()
+	 * and protected by the rstat lock of the css's subsystem.
+	 */
+	struct cgroup_subsys_state *rstat_flush_next;
 
 	/*
 	 * PI: Subsys-unique ID.  0 is unused and root is always 1.  The
@@ -328,10 +339,32 @@ struct cgroup_base_stat {
  * become very expensive.  By propagating selectively, increasing reading
  * frequency decreases the cost of each read.
  *
- * This struct hosts both the fields which implement the above -
- * updated_children and updated_next - and the fields which track basic
- * resource statistics on top of it - bsync, bstat and last_bstat.
+ * Each subsystem implementing ->css_rstat_flush() has its own updated tree
+ * of csses, protected by its own locks, and so has cgroup::self for the
+ * basic resource statistics and the bpf collectors.  Flushing one of them
+ * neither walks nor blocks the others.
+ *
+ * css_rstat_cpu hosts the fields which implement the above -
+ * updated_children and updated_next.  cgroup_rstat_cpu hosts the fields
+ * which track basic resource statistics on top of it - bsync, bstat and
+ * last_bstat.
  */
+struct css_rstat_cpu {
+	/*
+	 * Child csses with stat updates on this cpu since the last read
+	 * are linked on the parent's ->updated_children through
+	 * ->updated_next.
+	 *
+	 * In addition to being more compact, singly-linked list pointing
+	 * to the css makes it unnecessary for each per-cpu struct to
+	 * point back to the associated css.
+	 *
+	 * Protected by the per-cpu rstat lock of the css's subsystem.
+	 */
+	struct cgroup_subsys_state *updated_children;	/* terminated by self */
+	struct cgroup_subsys_state *updated_next;	/* NULL iff not on the list */
+};
+
 struct cgroup_rstat_cpu {
 	/*
 	 * ->bsync protects ->bstat.  These are the only fields which get
@@ -359,20 +392,6 @@ struct cgroup_rstat_cpu {
 	 * deltas to propagate to the per-cpu subtree_bstat.
 	 */
 	struct cgroup_base_stat last_subtree_bstat;
-
-	/*
-	 * Child cgroups with stat updates on this cpu since the last read
-	 * are linked on the parent's ->updated_children through
-	 * ->updated_next.
-	 *
-	 * In addition to being more compact, singly-linked list pointing
-	 * to the cgroup makes it unnecessary for each per-cpu struct to
-	 * point back to the associated cgroup.
-	 *
-	 * Protected by per-cpu cgroup_rstat_cpu_lock.
-	 */
-	struct cgroup *updated_children;	/* terminated by self cgroup */
-	struct cgroup *updated_next;		/* NULL iff not on the list */
 };
 
 struct cgroup_freezer_state {
@@ -494,22 +513,14 @@ struct cgroup {
 
 	/* per-cpu recursive resource statistics */
 	struct cgroup_rstat_cpu __percpu *rstat_cpu;
-	struct list_head rstat_css_list;
 
 	/*
-	 * Add padding to separate the read mostly rstat_cpu and
-	 * rstat_css_list into a different cacheline from the following
-	 * rstat_flush_next and *bstat fields which can have frequent updates.
+	 * Add padding to separate the read mostly rstat_cpu into a
+	 * different cacheline from the following *bstat fields which can
+	 * have frequent updates.
 	 */
 	CACHELINE_PADDING(_pad_);
 
-	/*
-	 * A singly-linked list of cgroup structures to be rstat flushed.
-	 * This is a scratch field to be used exclusively by
-	 * cgroup_rstat_flush_locked() and protected by cgroup_rstat_lock.
-	 */
-	struct cgroup	*rstat_flush_next;
-
 	/* cgroup basic resource statistics */
 	struct cgroup_base_stat last_bstat;
 	struct cgroup_base_stat bstat;
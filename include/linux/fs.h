@@ -457,6 +457,8 @@ extern const struct address_space_operations empty_aops;
  * @i_private_lock: For use by the owner of the address_space.
  * @i_private_list: For use by the owner of the address_space.
  * @i_private_data: For use by the owner of the address_space.
+ * @ra_hist_size: Readahead window a sequential reader last ramped up to.
+ * @ra_hist_stride: Distance in pages between the reads of a strided reader.
  */
 struct address_space {
 	struct inode		*host;
@@ -478,6 +480,9 @@ struct address_space {
 	struct list_head	i_private_list;
 	struct rw_semaphore	i_mmap_rwsem;
 	void *			i_private_data;
+	/* readahead history kept across opens, see BDI_CAP_RA_HISTORY */
+	unsigned int		ra_hist_size;
+	unsigned int		ra_hist_stride;
 } __attribute__((aligned(sizeof(long)))) __randomize_layout;
 	/*
 	 * On most architectures that alignment is already the case; but
@@ -1295,6 +1300,7 @@ struct super_block {
 	const char *s_subtype;
 
 	const struct dentry_operations *s_d_op; /* default d_op for dentries */
+	atomic_t		s_walk_gen;	/* see walk_cache_lookup() */
 
 	struct shrinker *s_shrink;	/* per-sb shrinker handle */
 
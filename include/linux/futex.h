@@ -24,6 +24,9 @@ struct task_struct;
  *	mapped on a file (reference on the underlying inode)
  *  10 : Shared futex (PTHREAD_PROCESS_SHARED)
  *       (but private mapping on an mm, and reference taken on it)
+ *
+ * node selects the per node hash the key lives in, see futex_hash(). It is
+ * not part of the hash nor of the match.
 */
 
 #define FUT_OFF_INODE    1 /* We set bit 0 if key has a reference on inode */
@@ -34,6 +37,7 @@ union futex_key {
 		u64 i_seq;
 		unsigned long pgoff;
 		unsigned int offset;
+		unsigned int node;
 	} shared;
 	struct {
 		union {
@@ -42,15 +46,17 @@ union futex_key {
 		};
 		unsigned long address;
 		unsigned int offset;
+		unsigned int node;
 	} private;
 	struct {
 		u64 ptr;
 		unsigned long word;
 		unsigned int offset;
+		unsigned int node;
 	} both;
 };
 
-#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL } }
+#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL, .node = FUTEX_NO_NODE } }
 
 #ifdef CONFIG_FUTEX
 enum {
@@ -90,4 +96,13 @@ static inline long do_futex(u32 __user *uaddr, int op, u32 val,
 }
 #endif
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/* Called from mm_init() and __mmput() respectively */
+void futex_mm_init(struct mm_struct *mm);
+void futex_hash_free(struct mm_struct *mm);
+#else
+static inline void futex_mm_init(struct mm_struct *mm) { }
+static inline void futex_hash_free(struct mm_struct *mm) { }
+#endif
+
 #endif
@@ -53,6 +53,8 @@ struct io_wq_work {
 	unsigned flags;
 	/* place it here instead of io_kiocb as it fills padding and saves 4B */
 	int cancel_seq;
+	/* ktime_get_ns() at io_wq_enqueue(), for the queue delay stats */
+	u64 queued_ns;
 };
 
 struct io_fixed_file {
@@ -362,6 +364,14 @@ struct io_ring_ctx {
 	struct wait_queue_head	sqo_sq_wait;
 	struct list_head	sqd_list;
 
+	/* SQPOLL fair-share budget, and per-ring stats reported in fdinfo */
+	unsigned int		sq_weight;
+	unsigned int		sq_deficit;
+	unsigned long		sq_last_active;
+	u64			sq_submitted;
+	u64			sq_backoffs;
+	u64			sq_sleeps;
+
 	unsigned int		file_alloc_start;
 	unsigned int		file_alloc_end;
 
@@ -413,10 +423,24 @@ struct io_ring_ctx {
 	unsigned int		napi_busy_poll_to;
 	bool			napi_prefer_busy_poll;
 	bool			napi_enabled;
+	bool			napi_adaptive;
+
+	/* adaptive busy poll window, and hits/misses in the current epoch */
+	unsigned int		napi_adaptive_to;
+	u8			napi_epoch_hits;
+	u8			napi_epoch_total;
+	unsigned long		napi_nr_hits;
+	unsigned long		napi_nr_misses;
 
 	DECLARE_HASHTABLE(napi_ht, 4);
 #endif
 
+	/* per-CPU, IORING_OP_LAST entries, see io_uring/opstats.c */
+	struct io_op_stats __percpu	*op_stats;
+
+	/* zero copy receive area, see io_uring/zcrx.c */
+	struct io_zcrx_ifq		*ifq;
+
 	/* protected by ->completion_lock */
 	unsigned			evfd_last_cq_tail;
 
@@ -472,6 +496,7 @@ enum {
 	REQ_F_BL_EMPTY_BIT,
 	REQ_F_BL_NO_RECYCLE_BIT,
 	REQ_F_BUFFERS_COMMIT_BIT,
+	REQ_F_BUF_MORE_BIT,
 
 	/* not a real bit, just to check we're not overflowing the space */
 	__REQ_F_LAST_BIT,
@@ -552,6 +577,8 @@ enum {
 	REQ_F_BL_NO_RECYCLE	= IO_REQ_FLAG(REQ_F_BL_NO_RECYCLE_BIT),
 	/* buffer ring head needs incrementing on put */
 	REQ_F_BUFFERS_COMMIT	= IO_REQ_FLAG(REQ_F_BUFFERS_COMMIT_BIT),
+	/* incremental buffer consumption, more space available */
+	REQ_F_BUF_MORE		= IO_REQ_FLAG(REQ_F_BUF_MORE_BIT),
 };
 
 typedef void (*io_req_tw_func_t)(struct io_kiocb *req, struct io_tw_state *ts);
@@ -655,6 +682,8 @@ struct io_kiocb {
 	struct async_poll		*apoll;
 	/* opcode allocated if it needs to store data for async defer */
 	void				*async_data;
+	/* see io_uring/opstats.h */
+	u32				stat_ts;
 	/* linked requests, IFF REQ_F_HARDLINK or REQ_F_LINK are set */
 	atomic_t			poll_refs;
 	struct io_kiocb			*link;
@@ -89,6 +89,13 @@ struct irq_desc {
 #ifdef CONFIG_GENERIC_PENDING_IRQ
 	cpumask_var_t		pending_mask;
 #endif
+#ifdef CONFIG_IRQ_BALANCE
+	unsigned int		balance_gen;	/* pass balance_count is from */
+	unsigned int		balance_count;
+	unsigned int		balance_rate;	/* irqs in the last interval */
+	int			balance_cpu;	/* pinned by the balancer or -1 */
+	unsigned int		balance_moved;	/* pass of the last move */
+#endif
 #endif
 	unsigned long		threads_oneshot;
 	atomic_t		threads_active;
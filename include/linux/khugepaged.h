@@ -4,6 +4,8 @@
 
 #include <linux/sched/coredump.h> /* MMF_VM_HUGEPAGE */
 
+struct seq_file;
+
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 extern struct attribute_group khugepaged_attr_group;
 
@@ -16,6 +18,7 @@ extern void khugepaged_enter_vma(struct vm_area_struct *vma,
 				 unsigned long vm_flags);
 extern void khugepaged_min_free_kbytes_update(void);
 extern bool current_is_khugepaged(void);
+extern void khugepaged_show_mm_stats(struct seq_file *m, struct mm_struct *mm);
 #ifdef CONFIG_SHMEM
 extern int collapse_pte_mapped_thp(struct mm_struct *mm, unsigned long addr,
 				   bool install_pmd);
@@ -63,6 +66,11 @@ static inline bool current_is_khugepaged(void)
 {
 	return false;
 }
+
+static inline void khugepaged_show_mm_stats(struct seq_file *m,
+					    struct mm_struct *mm)
+{
+}
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
 #endif /* _LINUX_KHUGEPAGED_H */
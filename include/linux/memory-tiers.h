@@ -35,8 +35,12 @@ struct memory_dev_type {
 
 struct access_coordinate;
 
+/* Upper bound of pages promoted together by one batch */
+#define NUMA_PROMOTION_BATCH_MAX	1024
+
 #ifdef CONFIG_NUMA
 extern bool numa_demotion_enabled;
+extern unsigned int numa_promotion_batch;
 extern struct memory_dev_type *default_dram_type;
 struct memory_dev_type *alloc_memory_type(int adistance);
 void put_memory_type(struct memory_dev_type *memtype);
@@ -55,6 +59,7 @@ void mt_put_memory_types(struct list_head *memory_types);
 int next_demotion_node(int node);
 void node_get_allowed_targets(pg_data_t *pgdat, nodemask_t *targets);
 bool node_is_toptier(int node);
+bool node_promotion_allowed(int node, unsigned long nr_pages);
 #else
 static inline int next_demotion_node(int node)
 {
@@ -70,11 +75,17 @@ static inline bool node_is_toptier(int node)
 {
 	return true;
 }
+
+static inline bool node_promotion_allowed(int node, unsigned long nr_pages)
+{
+	return true;
+}
 #endif
 
 #else
 
 #define numa_demotion_enabled	false
+#define numa_promotion_batch	0
 #define default_dram_type	NULL
 /*
  * CONFIG_NUMA implementation returns non NULL error.
@@ -114,6 +125,11 @@ static inline bool node_is_toptier(int node)
 	return true;
 }
 
+static inline bool node_promotion_allowed(int node, unsigned long nr_pages)
+{
+	return true;
+}
+
 static inline int register_mt_adistance_algorithm(struct notifier_block *nb)
 {
 	return 0;
@@ -911,6 +911,13 @@ struct mm_struct {
 		spinlock_t			ioctx_lock;
 		struct kioctx_table __rcu	*ioctx_table;
 #endif
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+		/*
+		 * Private futex hash, set up on the first FUTEX_PRIVATE
+		 * operation of the mm, see futex_private_hash_setup().
+		 */
+		struct futex_private_hash	*futex_phash;
+#endif
 #ifdef CONFIG_MEMCG
 		/*
 		 * "owner" points to a task that is regarded as the canonical
@@ -1233,6 +1240,9 @@ typedef __bitwise unsigned int vm_fault_t;
  *				fsync() to complete (for synchronous page faults
  *				in DAX)
  * @VM_FAULT_COMPLETED:		->fault completed, meanwhile mmap lock released
+ * @VM_FAULT_MMAP_LOCK:		->fault cannot proceed under the per-VMA lock,
+ *				retry with the mmap_lock held (only set together
+ *				with VM_FAULT_RETRY)
  * @VM_FAULT_HINDEX_MASK:	mask HINDEX value
  *
  */
@@ -1250,6 +1260,7 @@ enum vm_fault_reason {
 	VM_FAULT_DONE_COW       = (__force vm_fault_t)0x001000,
 	VM_FAULT_NEEDDSYNC      = (__force vm_fault_t)0x002000,
 	VM_FAULT_COMPLETED      = (__force vm_fault_t)0x004000,
+	VM_FAULT_MMAP_LOCK      = (__force vm_fault_t)0x008000,
 	VM_FAULT_HINDEX_MASK    = (__force vm_fault_t)0x0f0000,
 };
 
@@ -1274,7 +1285,8 @@ enum vm_fault_reason {
 	{ VM_FAULT_FALLBACK,            "FALLBACK" },	\
 	{ VM_FAULT_DONE_COW,            "DONE_COW" },	\
 	{ VM_FAULT_NEEDDSYNC,           "NEEDDSYNC" },	\
-	{ VM_FAULT_COMPLETED,           "COMPLETED" }
+	{ VM_FAULT_COMPLETED,           "COMPLETED" },	\
+	{ VM_FAULT_MMAP_LOCK,           "MMAP_LOCK" }
 
 struct vm_special_mapping {
 	const char *name;	/* The name, e.g. "[vdso]". */
@@ -215,6 +215,8 @@ enum node_stat_item {
 #ifdef CONFIG_NUMA_BALANCING
 	PGPROMOTE_SUCCESS,	/* promote successfully */
 	PGPROMOTE_CANDIDATE,	/* candidate pages to promote */
+	PGPROMOTE_BATCHED,	/* pages promoted by batches */
+	PGPROMOTE_RATELIMITED,	/* promotions refused by tier rate limit */
 #endif
 	/* PGDEMOTE_*: pages demoted */
 	PGDEMOTE_KSWAPD,
@@ -477,7 +479,7 @@ struct lru_gen_mm_state {
 	/* where the last iteration ended before */
 	struct list_head *tail;
 	/* Bloom filters flip after each iteration */
-	unsigned long *filters[NR_BLOOM_FILTERS];
+	struct lru_gen_bloom_filter __rcu *filters[NR_BLOOM_FILTERS];
 	/* the mm stats for debugging */
 	unsigned long stats[NR_HIST_GENS][NR_MM_STATS];
 };
@@ -695,6 +697,7 @@ struct per_cpu_pages {
 	int batch;		/* chunk size for buddy add/remove */
 	u8 flags;		/* protected by pcp->lock */
 	u8 alloc_factor;	/* batch scaling factor during allocate */
+	u8 refill_factor;	/* batch scaling factor from refill rate */
 #ifdef CONFIG_NUMA
 	u8 expire;		/* When 0, remote pagesets are drained */
 #endif
@@ -702,6 +705,12 @@ struct per_cpu_pages {
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[NR_PCP_LISTS];
+
+	unsigned long last_refill;	/* jiffies of the last refill */
+	unsigned long nr_refills;	/* refills from the zone */
+#ifdef CONFIG_NUMA
+	unsigned long nr_remote_frees;	/* pages freed from a remote CPU */
+#endif
 } ____cacheline_aligned_in_smp;
 
 struct per_cpu_zonestat {
@@ -176,6 +176,7 @@ struct netfs_io_subrequest {
 	struct netfs_io_request *rreq;		/* Supervising I/O request */
 	struct work_struct	work;
 	struct list_head	rreq_link;	/* Link in rreq->subrequests */
+	struct list_head	batch_link;	/* Link in a cross-inode write batch */
 	struct iov_iter		io_iter;	/* Iterator for this subrequest */
 	unsigned long long	start;		/* Where to start the I/O */
 	size_t			max_len;	/* Maximum size of the I/O */
@@ -309,6 +310,11 @@ struct netfs_request_ops {
 	void (*begin_writeback)(struct netfs_io_request *wreq);
 	void (*prepare_write)(struct netfs_io_subrequest *subreq);
 	void (*issue_write)(struct netfs_io_subrequest *subreq);
+	/* Issue a batch of upload subrequests (linked by ->batch_link), possibly
+	 * from several inodes of the same superblock.  Each must be unlinked
+	 * and eventually completed with netfs_write_subrequest_terminated().
+	 */
+	void (*issue_write_batch)(struct list_head *subreqs);
 	void (*retry_request)(struct netfs_io_request *wreq, struct netfs_io_stream *stream);
 	void (*invalidate_cache)(struct netfs_io_request *wreq);
 };
@@ -44,6 +44,12 @@ is_static struct percpu_rw_semaphore name = {				\
 
 extern bool __percpu_down_read(struct percpu_rw_semaphore *, bool);
 
+#ifdef CONFIG_LOCK_EVENT_COUNTS
+extern void percpu_rwsem_lockevent_fast(void);
+#else
+static inline void percpu_rwsem_lockevent_fast(void) { }
+#endif
+
 static inline void percpu_down_read(struct percpu_rw_semaphore *sem)
 {
 	might_sleep();
@@ -59,10 +65,12 @@ static inline void percpu_down_read(struct percpu_rw_semaphore *sem)
 	 * and that once the synchronize_rcu() is done, the writer will see
 	 * anything we did within this RCU-sched read-size critical section.
 	 */
-	if (likely(rcu_sync_is_idle(&sem->rss)))
+	if (likely(rcu_sync_is_idle(&sem->rss))) {
 		this_cpu_inc(*sem->read_count);
-	else
+		percpu_rwsem_lockevent_fast();
+	} else {
 		__percpu_down_read(sem, false); /* Unconditional memory barrier */
+	}
 	/*
 	 * The preempt_enable() prevents the compiler from
 	 * bleeding the critical section out.
@@ -78,10 +86,12 @@ static inline bool percpu_down_read_trylock(struct percpu_rw_semaphore *sem)
 	/*
 	 * Same as in percpu_down_read().
 	 */
-	if (likely(rcu_sync_is_idle(&sem->rss)))
+	if (likely(rcu_sync_is_idle(&sem->rss))) {
 		this_cpu_inc(*sem->read_count);
-	else
+		percpu_rwsem_lockevent_fast();
+	} else {
 		ret = __percpu_down_read(sem, true); /* Unconditional memory barrier */
+	}
 	preempt_enable();
 	/*
 	 * The barrier() from preempt_enable() prevents the compiler from
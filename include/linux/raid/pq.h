@@ -74,10 +74,13 @@ struct raid6_calls {
 	int  (*valid)(void);	/* Returns 1 if this routine set is usable */
 	const char *name;	/* Name of this routine set */
 	int priority;		/* Relative priority ranking if non-zero */
+	/* Optional: gen_syndrome for several stripes in one go */
+	void (*gen_syndrome_batch)(int, size_t, void ***, int);
 };
 
 /* Selected algorithm */
 extern struct raid6_calls raid6_call;
+void raid6_gen_syndrome_batch(int disks, size_t bytes, void ***ptrs, int nr);
 
 /* Various routine sets */
 extern const struct raid6_calls raid6_intx1;
@@ -101,6 +104,7 @@ extern const struct raid6_calls raid6_avx2x4;
 extern const struct raid6_calls raid6_avx512x1;
 extern const struct raid6_calls raid6_avx512x2;
 extern const struct raid6_calls raid6_avx512x4;
+extern const struct raid6_calls raid6_avx512gfnix2;
 extern const struct raid6_calls raid6_s390vx8;
 extern const struct raid6_calls raid6_vpermxor1;
 extern const struct raid6_calls raid6_vpermxor2;
@@ -121,6 +125,7 @@ extern const struct raid6_recov_calls raid6_recov_intx1;
 extern const struct raid6_recov_calls raid6_recov_ssse3;
 extern const struct raid6_recov_calls raid6_recov_avx2;
 extern const struct raid6_recov_calls raid6_recov_avx512;
+extern const struct raid6_recov_calls raid6_recov_gfni;
 extern const struct raid6_recov_calls raid6_recov_s390xc;
 extern const struct raid6_recov_calls raid6_recov_neon;
 extern const struct raid6_recov_calls raid6_recov_lsx;
@@ -79,6 +79,10 @@ struct shrink_control {
  *
  * @flags determine the shrinker abilities, like numa awareness
  */
+#define SHRINKER_HIST_BUCKETS	20
+
+struct shrinker_async;
+
 struct shrinker {
 	unsigned long (*count_objects)(struct shrinker *,
 				       struct shrink_control *sc);
@@ -112,9 +116,14 @@ struct shrinker {
 	int debugfs_id;
 	const char *name;
 	struct dentry *debugfs_entry;
+	/* per invocation, log2 buckets */
+	atomic_long_t latency_hist[SHRINKER_HIST_BUCKETS];	/* usecs */
+	atomic_long_t freed_hist[SHRINKER_HIST_BUCKETS];	/* objects */
 #endif
 	/* objs pending delete, per node */
 	atomic_long_t *nr_deferred;
+	/* work beyond the direct reclaim time budget, per node */
+	struct shrinker_async *async;
 };
 #define DEFAULT_SEEKS 2 /* A good number if you don't know better. */
 
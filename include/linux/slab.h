@@ -53,6 +53,7 @@ enum _slab_flag_bits {
 #endif
 #ifndef CONFIG_SLUB_TINY
 	_SLAB_RECLAIM_ACCOUNT,
+	_SLAB_PERCPU_SHEAVES,
 #endif
 	_SLAB_OBJECT_POISON,
 	_SLAB_CMPXCHG_DOUBLE,
@@ -205,6 +206,17 @@ enum _slab_flag_bits {
 #endif
 #define SLAB_TEMPORARY		SLAB_RECLAIM_ACCOUNT	/* Objects are short-lived */
 
+/*
+ * Cache freed objects in per-cpu arrays ("sheaves") backed by a per-node
+ * stock of full and empty arrays, so that alloc/free of hot objects rarely
+ * touch the slabs themselves. Ignored for caches with debugging enabled.
+ */
+#ifndef CONFIG_SLUB_TINY
+#define SLAB_PERCPU_SHEAVES	__SLAB_FLAG_BIT(_SLAB_PERCPU_SHEAVES)
+#else
+#define SLAB_PERCPU_SHEAVES	__SLAB_FLAG_UNUSED
+#endif
+
 /* Slab created using create_boot_cache */
 #ifdef CONFIG_SLAB_OBJ_EXT
 #define SLAB_NO_OBJ_EXT		__SLAB_FLAG_BIT(_SLAB_NO_OBJ_EXT)
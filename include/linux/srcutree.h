@@ -26,6 +26,7 @@ struct srcu_data {
 	atomic_long_t srcu_lock_count[2];	/* Locks per CPU. */
 	atomic_long_t srcu_unlock_count[2];	/* Unlocks per CPU. */
 	int srcu_nmi_safety;			/* NMI-safe srcu_struct structure? */
+	int srcu_reader_seen;			/* Counted in ->mynode summary? */
 
 	/* Update-side state. */
 	spinlock_t __private lock ____cacheline_internodealigned_in_smp;
@@ -55,6 +56,12 @@ struct srcu_node {
 	struct srcu_node *srcu_parent;		/* Next up in tree. */
 	int grplo;				/* Least CPU for node. */
 	int grphi;				/* Biggest CPU for node. */
+
+	/* Leaf reader summary, see srcu_readers_active_idx_check_leaves(). */
+	int srcu_readers_dirty;			/* Counters changed since cached? */
+	bool srcu_readers_refresh;		/* Being re-cached by this scan? */
+	unsigned long srcu_lock_cache[2];	/* Cached leaf ->srcu_lock_count[] sums. */
+	unsigned long srcu_unlock_cache[2];	/* Cached leaf ->srcu_unlock_count[] sums. */
 };
 
 /*
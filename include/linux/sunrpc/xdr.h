@@ -260,6 +260,14 @@ extern void xdr_init_decode_pages(struct xdr_stream *xdr, struct xdr_buf *buf,
 		struct page **pages, unsigned int len);
 extern void xdr_finish_decode(struct xdr_stream *xdr);
 extern __be32 *xdr_inline_decode(struct xdr_stream *xdr, size_t nbytes);
+extern ssize_t xdr_stream_decode_u32_items(struct xdr_stream *xdr, u32 *items,
+					   unsigned int count);
+extern ssize_t xdr_stream_decode_u64_items(struct xdr_stream *xdr, u64 *items,
+					   unsigned int count);
+extern ssize_t xdr_stream_decode_array_items(struct xdr_stream *xdr,
+		void *items, size_t item_size, size_t item_len,
+		unsigned int count,
+		void (*decode)(void *items, const __be32 *p, unsigned int n));
 extern unsigned int xdr_read_pages(struct xdr_stream *xdr, unsigned int len);
 extern void xdr_enter_page(struct xdr_stream *xdr, unsigned int len);
 extern int xdr_process_buf(const struct xdr_buf *buf, unsigned int offset, unsigned int len, int (*actor)(struct scatterlist *, void *), void *data);
@@ -781,6 +789,14 @@ xdr_stream_decode_uint32_array(struct xdr_stream *xdr,
 		return -EBADMSG;
 	if (U32_MAX >= SIZE_MAX / sizeof(*p) && len > SIZE_MAX / sizeof(*p))
 		return -EBADMSG;
+	if (array && len <= array_size) {
+		/* decodes straight across pages, no scratch buffer needed */
+		if (xdr_stream_decode_u32_items(xdr, array, len) < 0)
+			return -EBADMSG;
+		if (len < array_size)
+			memset(array+len, 0, (array_size-len)*sizeof(*array));
+		return len;
+	}
 	p = xdr_inline_decode(xdr, len * sizeof(*p));
 	if (unlikely(!p))
 		return -EBADMSG;
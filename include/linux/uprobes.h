@@ -75,8 +75,10 @@ struct uprobe_task {
 
 	struct uprobe			*active_uprobe;
 	unsigned long			xol_vaddr;
+	struct uprobe			*xol_uprobe;	/* kept slot's insn */
 
 	struct return_instance		*return_instances;
+	struct return_instance		*ri_pool;	/* unused instances */
 	unsigned int			depth;
 };
 
@@ -55,6 +55,12 @@ int virtqueue_add_inbuf_ctx(struct virtqueue *vq,
 			    void *ctx,
 			    gfp_t gfp);
 
+int virtqueue_add_inbufs_ctx(struct virtqueue *vq,
+			     struct scatterlist sg[], unsigned int num,
+			     void *data[],
+			     void *ctx[],
+			     gfp_t gfp);
+
 int virtqueue_add_sgs(struct virtqueue *vq,
 		      struct scatterlist *sgs[],
 		      unsigned int out_sgs,
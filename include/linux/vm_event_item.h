@@ -69,6 +69,9 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_MIGRATION_SUCCESS,
 		THP_MIGRATION_FAIL,
 		THP_MIGRATION_SPLIT,
+		PGMIGRATE_COPY_BYTES_SERIAL,
+		PGMIGRATE_COPY_BYTES_THREADS,
+		PGMIGRATE_COPY_BYTES_DMA,
 #endif
 #ifdef CONFIG_COMPACTION
 		COMPACTMIGRATE_SCANNED, COMPACTFREE_SCANNED,
@@ -144,6 +147,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		ZSWPOUT,
 		ZSWPWB,
 #endif
+#ifdef CONFIG_LRU_GEN
+		LRU_GEN_PMD_SKIP,
+		LRU_GEN_PMD_MISS,
+#endif
+		VMALLOC_HUGE_ALLOC,
+		VMALLOC_HUGE_FALLBACK,
 #ifdef CONFIG_X86
 		DIRECT_MAP_LEVEL2_SPLIT,
 		DIRECT_MAP_LEVEL3_SPLIT,
@@ -153,6 +162,10 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		VMA_LOCK_ABORT,
 		VMA_LOCK_RETRY,
 		VMA_LOCK_MISS,
+		VMA_LOCK_FALLBACK_FAULT_OPS,
+		VMA_LOCK_FALLBACK_ANON_VMA,
+		VMA_LOCK_FALLBACK_DEVICE_PRIVATE,
+		VMA_LOCK_FALLBACK_RETRY,
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -180,6 +180,87 @@ zstd_cctx *zstd_init_cctx(void *workspace, size_t workspace_size);
 size_t zstd_compress_cctx(zstd_cctx *cctx, void *dst, size_t dst_capacity,
 	const void *src, size_t src_size, const zstd_parameters *parameters);
 
+/**
+ * zstd_compress_parallel() - compress src into dst using several threads
+ * @dst:          The buffer to compress src into.
+ * @dst_capacity: The size of the destination buffer. May be any size, but
+ *                zstd_compress_bound() of each chunk summed up is guaranteed
+ *                to be large enough.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data to compress.
+ * @parameters:   The compression parameters to be used for every chunk.
+ * @chunk_size:   src is split into chunks of this size, each compressed into
+ *                its own frame. Must not be 0.
+ * @nr_threads:   Maximum number of threads to use, including the caller, or
+ *                0 for the number of online CPUs.
+ *
+ * The frames are concatenated in order, so the result can be decompressed by
+ * zstd_decompress_dctx() or the streaming API in one go. Matches are only
+ * found within a chunk, so small chunks compress worse. Allocates the
+ * workspaces itself and must be called from process context.
+ *
+ * Return:        The compressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_compress_parallel(void *dst, size_t dst_capacity,
+	const void *src, size_t src_size, const zstd_parameters *parameters,
+	size_t chunk_size, unsigned int nr_threads);
+
+/* ======   Dictionary Compression   ====== */
+
+typedef ZSTD_CDict zstd_cdict;
+
+/**
+ * zstd_cdict_workspace_bound() - memory needed to initialize a zstd_cdict
+ * @dict_size: The size of the dictionary.
+ * @cparams:   The compression parameters to be used.
+ *
+ * Return:     A lower bound on the size of the workspace that is passed to
+ *             zstd_init_cdict().
+ */
+size_t zstd_cdict_workspace_bound(size_t dict_size,
+	const zstd_compression_parameters *cparams);
+
+/**
+ * zstd_init_cdict() - digest a dictionary for compression
+ * @dict:           The dictionary, e.g. trained by zstd --train. It is
+ *                  referenced, not copied, and must outlive the returned
+ *                  dictionary.
+ * @dict_size:      The size of the dictionary.
+ * @cparams:        The compression parameters to be used.
+ * @workspace:      The workspace to emplace the dictionary into. It must
+ *                  outlive the returned dictionary.
+ * @workspace_size: The size of workspace. Use zstd_cdict_workspace_bound() to
+ *                  determine how large the workspace must be.
+ *
+ * The digested dictionary is read-only and may be shared by any number of
+ * compression contexts at the same time.
+ *
+ * Return:          A zstd compression dictionary or NULL on error.
+ */
+const zstd_cdict *zstd_init_cdict(const void *dict, size_t dict_size,
+	const zstd_compression_parameters *cparams, void *workspace,
+	size_t workspace_size);
+
+/**
+ * zstd_compress_using_cdict() - compress src into dst with a dictionary
+ * @cctx:         The context. Must have been initialized with zstd_init_cctx()
+ *                and a workspace sized for the parameters of @cdict.
+ * @dst:          The buffer to compress src into.
+ * @dst_capacity: The size of the destination buffer. May be any size, but
+ *                ZSTD_compressBound(srcSize) is guaranteed to be large enough.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data to compress.
+ * @cdict:        The dictionary, initialized with zstd_init_cdict().
+ * @fparams:      The frame parameters to be used.
+ *
+ * Return:        The compressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_compress_using_cdict(zstd_cctx *cctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_cdict *cdict, const zstd_frame_parameters *fparams);
+
 /* ======   Single-pass Decompression   ====== */
 
 typedef ZSTD_DCtx zstd_dctx;
@@ -220,6 +301,52 @@ zstd_dctx *zstd_init_dctx(void *workspace, size_t workspace_size);
 size_t zstd_decompress_dctx(zstd_dctx *dctx, void *dst, size_t dst_capacity,
 	const void *src, size_t src_size);
 
+/* ======   Dictionary Decompression   ====== */
+
+typedef ZSTD_DDict zstd_ddict;
+
+/**
+ * zstd_ddict_workspace_bound() - memory needed to initialize a zstd_ddict
+ * @dict_size: The size of the dictionary.
+ *
+ * Return:     A lower bound on the size of the workspace that is passed to
+ *             zstd_init_ddict().
+ */
+size_t zstd_ddict_workspace_bound(size_t dict_size);
+
+/**
+ * zstd_init_ddict() - digest a dictionary for decompression
+ * @dict:           The dictionary the data was compressed with. It is
+ *                  referenced, not copied, and must outlive the returned
+ *                  dictionary.
+ * @dict_size:      The size of the dictionary.
+ * @workspace:      The workspace to emplace the dictionary into. It must
+ *                  outlive the returned dictionary.
+ * @workspace_size: The size of workspace. Use zstd_ddict_workspace_bound() to
+ *                  determine how large the workspace must be.
+ *
+ * Return:          A zstd decompression dictionary or NULL on error.
+ */
+const zstd_ddict *zstd_init_ddict(const void *dict, size_t dict_size,
+	void *workspace, size_t workspace_size);
+
+/**
+ * zstd_decompress_using_ddict() - decompress src into dst with a dictionary
+ * @dctx:         The decompression context.
+ * @dst:          The buffer to decompress src into.
+ * @dst_capacity: The size of the destination buffer. Must be at least as large
+ *                as the decompressed size.
+ * @src:          The zstd compressed data to decompress.
+ * @src_size:     The exact size of the data to decompress.
+ * @ddict:        The dictionary, initialized with zstd_init_ddict().
+ *
+ * Return:        The decompressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_decompress_using_ddict(zstd_dctx *dctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_ddict *ddict);
+
 /* ======   Streaming Buffers   ====== */
 
 /**
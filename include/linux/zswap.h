@@ -6,6 +6,7 @@
 #include <linux/mm_types.h>
 
 struct lruvec;
+struct seq_file;
 
 extern atomic_t zswap_stored_pages;
 
@@ -29,10 +30,13 @@ struct zswap_lruvec_state {
 unsigned long zswap_total_pages(void);
 bool zswap_store(struct folio *folio);
 bool zswap_load(struct folio *folio);
+int zswap_nr_present(swp_entry_t swp, int nr_pages);
 void zswap_invalidate(swp_entry_t swp);
 int zswap_swapon(int type, unsigned long nr_pages);
 void zswap_swapoff(int type);
 void zswap_memcg_offline_cleanup(struct mem_cgroup *memcg);
+int zswap_memcg_pool_set(struct mem_cgroup *memcg, char *buf);
+void zswap_memcg_pool_show(struct seq_file *m, struct mem_cgroup *memcg);
 void zswap_lruvec_state_init(struct lruvec *lruvec);
 void zswap_folio_swapin(struct folio *folio);
 bool is_zswap_enabled(void);
@@ -50,6 +54,11 @@ static inline bool zswap_load(struct folio *folio)
 	return false;
 }
 
+static inline int zswap_nr_present(swp_entry_t swp, int nr_pages)
+{
+	return 0;
+}
+
 static inline void zswap_invalidate(swp_entry_t swp) {}
 static inline int zswap_swapon(int type, unsigned long nr_pages)
 {
@@ -186,6 +186,8 @@ struct slave {
 	struct delayed_work notify_work;
 	struct kobject kobj;
 	struct rtnl_link_stats64 slave_stats;
+	/* bytes per rebalance interval of the flows pinned to this slave */
+	u64    tx_flow_load;
 };
 
 static inline struct slave *to_slave(struct kobject *kobj)
@@ -199,6 +201,28 @@ struct bond_up_slave {
 	struct slave	*arr[];
 };
 
+/* Flow pinning table for balance-xor and 802.3ad, see tx_flow_table.
+ * Entries are updated locklessly from the xmit path; @slave is only
+ * compared against the current usable_slaves array, never dereferenced
+ * on its own.
+ */
+#define BOND_FLOW_TABLE_SIZE		4096
+#define BOND_FLOW_IDLE			(HZ / 10)
+#define BOND_FLOW_REBALANCE_INTERVAL	HZ
+
+struct bond_flow {
+	u32		hash;
+	u32		slave_idx;	/* hint into usable_slaves->arr */
+	struct slave	*slave;
+	unsigned long	last_used;	/* jiffies */
+	u64		bytes;		/* since the last rebalance */
+};
+
+struct bond_flow_table {
+	u64		avg_flow_load;
+	struct bond_flow flows[BOND_FLOW_TABLE_SIZE];
+};
+
 /*
  * Link pseudo-state only used internally by monitors
  */
@@ -252,6 +276,8 @@ struct bonding {
 	struct   delayed_work ad_work;
 	struct   delayed_work mcast_work;
 	struct   delayed_work slave_arr_work;
+	struct   bond_flow_table *flow_tbl;
+	struct   delayed_work flow_work;
 #ifdef CONFIG_DEBUG_FS
 	/* debugging support via debugfs */
 	struct	 dentry *debug_dir;
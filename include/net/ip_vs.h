@@ -869,6 +869,7 @@ struct ip_vs_app {
 
 struct ipvs_master_sync_state {
 	struct list_head	sync_queue;
+	spinlock_t		sync_buff_lock;	/* protects sync_buff */
 	struct ip_vs_sync_buff	*sync_buff;
 	unsigned long		sync_queue_len;
 	unsigned int		sync_queue_delay;
@@ -1026,7 +1027,7 @@ struct netns_ipvs {
 	/* ip_vs_sync */
 	spinlock_t		sync_lock;
 	struct ipvs_master_sync_state *ms;
-	spinlock_t		sync_buff_lock;
+	spinlock_t		sync_buff_lock;	/* sync_state changes */
 	struct ip_vs_sync_thread_data *master_tinfo;
 	struct ip_vs_sync_thread_data *backup_tinfo;
 	int			threads_mask;
@@ -1362,6 +1363,7 @@ const char *ip_vs_state_name(const struct ip_vs_conn *cp);
 void ip_vs_tcp_conn_listen(struct ip_vs_conn *cp);
 int ip_vs_check_template(struct ip_vs_conn *ct, struct ip_vs_dest *cdest);
 void ip_vs_random_dropentry(struct netns_ipvs *ipvs);
+void ip_vs_conn_tab_stats_show(struct seq_file *seq);
 int ip_vs_conn_init(void);
 void ip_vs_conn_cleanup(void);
 
@@ -111,6 +111,7 @@ struct kcm_psock {
 	unsigned long long saved_rx_bytes;
 	unsigned long long saved_rx_msgs;
 	struct sk_buff *ready_rx_msg;
+	bool rx_need_wake;
 
 	/* Transmit */
 	struct kcm_sock *tx_kcm;
@@ -10,6 +10,7 @@
 #include <net/dst_ops.h>
 
 struct ctl_table_header;
+struct xfrm_pol_cache;
 
 struct xfrm_policy_hash {
 	struct hlist_head	__rcu *table;
@@ -58,6 +59,11 @@ struct netns_xfrm {
 	struct xfrm_policy_hthresh policy_hthresh;
 	struct list_head	inexact_bins;
 
+	/* per-cpu policy lookup cache, valid while policy_genid is unchanged */
+	struct xfrm_pol_cache __percpu *policy_cache;
+	unsigned int		policy_genid;
+	unsigned int		policy_sec_count;
+
 
 	struct sock		*nlsk;
 	struct sock		*nlsk_stash;
@@ -156,6 +156,11 @@ struct tls_offload_context_tx {
 	u64 hint_record_sn;
 	u64 unacked_record_sn;
 
+	/* software fallback and resync telemetry, reported via sock_diag */
+	u64 fallback_pkts;
+	u64 fallback_bytes;
+	u32 resyncs;
+
 	struct scatterlist sg_tx_data[MAX_SKB_FRAGS];
 	void (*sk_destruct)(struct sock *sk);
 	struct work_struct destruct_work;
@@ -305,6 +310,8 @@ struct tls_offload_context_rx {
 	u8 resync_nh_reset:1;
 	/* CORE_NEXT_HINT-only member, but use the hole here */
 	u8 resync_nh_do_now:1;
+	/* resync requests sent to the device, reported via sock_diag */
+	u32 resyncs;
 	union {
 		/* TLS_OFFLOAD_SYNC_TYPE_DRIVER_REQ */
 		struct {
@@ -292,6 +292,9 @@ struct xfrm_state {
 	 * interpreted by xfrm_type methods. */
 	void			*data;
 	u8			dir;
+
+	/* CPU this SA is used by for output, UINT_MAX if not pinned */
+	u32			pcpu_num;
 };
 
 static inline struct net *xs_net(struct xfrm_state *x)
@@ -231,7 +231,7 @@ DECLARE_EVENT_CLASS(cgroup_rstat,
 		  __entry->cpu, __entry->contended)
 );
 
-/* Related to global: cgroup_rstat_lock */
+/* Related to per subsystem: css_rstat_lock */
 DEFINE_EVENT(cgroup_rstat, cgroup_rstat_lock_contended,
 
 	TP_PROTO(struct cgroup *cgrp, int cpu, bool contended),
@@ -253,7 +253,7 @@ DEFINE_EVENT(cgroup_rstat, cgroup_rstat_unlock,
 	TP_ARGS(cgrp, cpu, contended)
 );
 
-/* Related to per CPU: cgroup_rstat_cpu_lock */
+/* Related to per subsystem per CPU: css_rstat_cpu_lock */
 DEFINE_EVENT(cgroup_rstat, cgroup_rstat_cpu_lock_contended,
 
 	TP_PROTO(struct cgroup *cgrp, int cpu, bool contended),
@@ -296,6 +296,31 @@ DEFINE_EVENT(cgroup_rstat, cgroup_rstat_cpu_unlock_fastpath,
 	TP_ARGS(cgrp, cpu, contended)
 );
 
+TRACE_EVENT(cpuset_rebuild_sched_domains,
+
+	TP_PROTO(int ndoms, bool changed, u64 gen_ns, u64 rebuild_ns),
+
+	TP_ARGS(ndoms, changed, gen_ns, rebuild_ns),
+
+	TP_STRUCT__entry(
+		__field(	int,		ndoms			)
+		__field(	bool,		changed			)
+		__field(	u64,		gen_ns			)
+		__field(	u64,		rebuild_ns		)
+	),
+
+	TP_fast_assign(
+		__entry->ndoms = ndoms;
+		__entry->changed = changed;
+		__entry->gen_ns = gen_ns;
+		__entry->rebuild_ns = rebuild_ns;
+	),
+
+	TP_printk("ndoms=%d changed=%d generate_ns=%llu rebuild_ns=%llu",
+		  __entry->ndoms, __entry->changed,
+		  __entry->gen_ns, __entry->rebuild_ns)
+);
+
 #endif /* _TRACE_CGROUP_H */
 
 /* This part must be outside protection */
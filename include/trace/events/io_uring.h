@@ -677,6 +677,48 @@ TRACE_EVENT(io_uring_local_work_run,
 	TP_printk("ring %p, count %d, loops %u", __entry->ctx, __entry->count, __entry->loops)
 );
 
+/*
+ * io_uring_op_latency - request latency, recorded if IORING_REGISTER_OP_STATS
+ *			 is enabled for the ring
+ *
+ * @req:		pointer to a submitted request
+ * @stage:		"queue" for submission to issue, "exec" for issue to
+ *			completion
+ * @usec:		latency, in ~usec units (ns >> 10)
+ */
+TRACE_EVENT(io_uring_op_latency,
+
+	TP_PROTO(struct io_kiocb *req, const char *stage, u32 usec),
+
+	TP_ARGS(req, stage, usec),
+
+	TP_STRUCT__entry (
+		__field(  void *,		ctx		)
+		__field(  void *,		req		)
+		__field(  unsigned long long,	user_data	)
+		__field(  u8,			opcode		)
+		__field(  u32,			usec		)
+
+		__string( op_str, io_uring_get_opcode(req->opcode) )
+		__string( stage, stage )
+	),
+
+	TP_fast_assign(
+		__entry->ctx		= req->ctx;
+		__entry->req		= req;
+		__entry->user_data	= req->cqe.user_data;
+		__entry->opcode		= req->opcode;
+		__entry->usec		= usec;
+
+		__assign_str(op_str);
+		__assign_str(stage);
+	),
+
+	TP_printk("ring %p, req %p, user_data 0x%llx, opcode %s, %s %u us",
+		  __entry->ctx, __entry->req, __entry->user_data,
+		  __get_str(op_str), __get_str(stage), __entry->usec)
+);
+
 #endif /* _TRACE_IO_URING_H */
 
 /* This part must be outside protection */
@@ -442,6 +442,32 @@ TRACE_EVENT(tick_stop,
 	TP_printk("success=%d dependency=%s",  __entry->success, \
 			show_tick_dep_name(__entry->dependency))
 );
+
+/**
+ * tick_nohz_full_interrupt - called when a busy nohz_full CPU with the tick
+ *			      stopped enters an interrupt
+ * @quiet:	time since the last tick, in nanoseconds
+ *
+ * Meant for auditing isolated CPUs: the irq_handler_entry, ipi_entry,
+ * hrtimer_expire_entry etc. events that follow on the same CPU tell which
+ * source caused the interruption.
+ */
+TRACE_EVENT(tick_nohz_full_interrupt,
+
+	TP_PROTO(s64 quiet),
+
+	TP_ARGS(quiet),
+
+	TP_STRUCT__entry(
+		__field( s64,		quiet	)
+	),
+
+	TP_fast_assign(
+		__entry->quiet		= quiet;
+	),
+
+	TP_printk("quiet=%lld", __entry->quiet)
+);
 #endif
 
 #endif /*  _TRACE_TIMER_H */
@@ -65,4 +65,40 @@ struct cachefiles_read {
  */
 #define CACHEFILES_IOC_READ_COMPLETE	_IOW(0x98, 1, int)
 
+/*
+ * io_uring interface, IORING_OP_URING_CMD on the /dev/cachefiles fd with a
+ * struct cachefiles_uring_cmd in sqe->cmd.
+ *
+ * CACHEFILES_URING_CMD_FETCH copies up to @nr (0 for no limit) pending
+ * requests into the @len bytes at @buf.  Each one is a struct cachefiles_msg
+ * starting at a CACHEFILES_MSG_ALIGN boundary.  The CQE carries the number of
+ * bytes filled, 0 if nothing was pending; poll the fd to wait for requests.
+ *
+ * CACHEFILES_URING_CMD_READ_COMPLETE completes the @nr READ requests listed
+ * in the array of struct cachefiles_read_done at @buf, like
+ * CACHEFILES_IOC_READ_COMPLETE on each anon fd.  The CQE carries the number
+ * of requests completed, which stops at the first invalid entry.
+ */
+enum cachefiles_uring_cmd_op {
+	CACHEFILES_URING_CMD_FETCH,
+	CACHEFILES_URING_CMD_READ_COMPLETE,
+};
+
+#define CACHEFILES_MSG_ALIGN	8
+
+struct cachefiles_uring_cmd {
+	__u64 buf;
+	__u32 len;
+	__u32 nr;
+};
+
+/*
+ * @msg_id	the @msg_id of the READ request
+ * @error	0, or a negative error code to fail the read with
+ */
+struct cachefiles_read_done {
+	__u32 msg_id;
+	__s32 error;
+};
+
 #endif
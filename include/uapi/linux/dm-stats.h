@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Binary layout of the device-mapper statistics exported through
+ * /sys/block/dm-<minor>/dm/stats.
+ *
+ * The file is a sequence of records, one for every area of every region,
+ * ordered by region id and then by area.  Each record is a struct
+ * dm_stats_area followed by the histogram counters of the region, if it
+ * has a histogram.  record_size gives the size of the whole record, so
+ * that readers can skip fields they don't know about.
+ *
+ * The counters are the same ones that @stats_print reports.  Times are in
+ * milliseconds, or in nanoseconds for regions created with
+ * precise_timestamps.
+ */
+#ifndef _LINUX_DM_STATS_H
+#define _LINUX_DM_STATS_H
+
+#include <linux/types.h>
+
+struct dm_stats_area {
+	__u32 record_size;
+	__u32 region_id;
+	__u64 start;		/* in sectors */
+	__u64 len;		/* in sectors */
+
+	__u64 reads;
+	__u64 read_merges;
+	__u64 read_sectors;
+	__u64 read_ticks;
+	__u64 writes;
+	__u64 write_merges;
+	__u64 write_sectors;
+	__u64 write_ticks;
+	__u64 in_flight;
+	__u64 io_ticks;
+	__u64 time_in_queue;
+	__u64 read_io_ticks;
+	__u64 write_io_ticks;
+
+	__u64 histogram[];
+};
+
+#endif /* _LINUX_DM_STATS_H */
@@ -57,6 +57,7 @@ enum {
 	ETHTOOL_MSG_PLCA_GET_STATUS,
 	ETHTOOL_MSG_MM_GET,
 	ETHTOOL_MSG_MM_SET,
+	ETHTOOL_MSG_QSTATS_GET,
 
 	/* add new constants above here */
 	__ETHTOOL_MSG_USER_CNT,
@@ -109,6 +110,7 @@ enum {
 	ETHTOOL_MSG_PLCA_NTF,
 	ETHTOOL_MSG_MM_GET_REPLY,
 	ETHTOOL_MSG_MM_NTF,
+	ETHTOOL_MSG_QSTATS_GET_REPLY,
 
 	/* add new constants above here */
 	__ETHTOOL_MSG_KERNEL_CNT,
@@ -996,6 +998,63 @@ enum {
 	ETHTOOL_A_MM_MAX = (__ETHTOOL_A_MM_CNT - 1)
 };
 
+/* QSTATS */
+
+enum {
+	ETHTOOL_A_QSTATS_UNSPEC,
+	ETHTOOL_A_QSTATS_HEADER,		/* nest - _A_HEADER_* */
+	ETHTOOL_A_QSTATS_RX_QUEUES,		/* u32 */
+	ETHTOOL_A_QSTATS_TX_QUEUES,		/* u32 */
+	ETHTOOL_A_QSTATS_RX,			/* binary - u64[_QSTATS_RX_CNT] */
+	ETHTOOL_A_QSTATS_TX,			/* binary - u64[_QSTATS_TX_CNT] */
+
+	/* add new constants above here */
+	__ETHTOOL_A_QSTATS_CNT,
+	ETHTOOL_A_QSTATS_MAX = (__ETHTOOL_A_QSTATS_CNT - 1)
+};
+
+/* Layout of the packed ETHTOOL_A_QSTATS_RX and ETHTOOL_A_QSTATS_TX
+ * attributes, one attribute per queue in queue index order. Counters the
+ * device does not collect are set to ~0ULL.
+ */
+enum {
+	ETHTOOL_QSTATS_RX_BYTES,
+	ETHTOOL_QSTATS_RX_PACKETS,
+	ETHTOOL_QSTATS_RX_ALLOC_FAIL,
+	ETHTOOL_QSTATS_RX_HW_DROPS,
+	ETHTOOL_QSTATS_RX_HW_DROP_OVERRUNS,
+	ETHTOOL_QSTATS_RX_CSUM_UNNECESSARY,
+	ETHTOOL_QSTATS_RX_CSUM_NONE,
+	ETHTOOL_QSTATS_RX_CSUM_BAD,
+	ETHTOOL_QSTATS_RX_HW_GRO_PACKETS,
+	ETHTOOL_QSTATS_RX_HW_GRO_BYTES,
+	ETHTOOL_QSTATS_RX_HW_GRO_WIRE_PACKETS,
+	ETHTOOL_QSTATS_RX_HW_GRO_WIRE_BYTES,
+	ETHTOOL_QSTATS_RX_HW_DROP_RATELIMITS,
+
+	/* add new constants above here */
+	__ETHTOOL_QSTATS_RX_CNT
+};
+
+enum {
+	ETHTOOL_QSTATS_TX_BYTES,
+	ETHTOOL_QSTATS_TX_PACKETS,
+	ETHTOOL_QSTATS_TX_HW_DROPS,
+	ETHTOOL_QSTATS_TX_HW_DROP_ERRORS,
+	ETHTOOL_QSTATS_TX_CSUM_NONE,
+	ETHTOOL_QSTATS_TX_NEEDS_CSUM,
+	ETHTOOL_QSTATS_TX_HW_GSO_PACKETS,
+	ETHTOOL_QSTATS_TX_HW_GSO_BYTES,
+	ETHTOOL_QSTATS_TX_HW_GSO_WIRE_PACKETS,
+	ETHTOOL_QSTATS_TX_HW_GSO_WIRE_BYTES,
+	ETHTOOL_QSTATS_TX_HW_DROP_RATELIMITS,
+	ETHTOOL_QSTATS_TX_STOP,
+	ETHTOOL_QSTATS_TX_WAKE,
+
+	/* add new constants above here */
+	__ETHTOOL_QSTATS_TX_CNT
+};
+
 /* generic netlink info */
 #define ETHTOOL_GENL_NAME "ethtool"
 #define ETHTOOL_GENL_VERSION 1
@@ -257,6 +257,9 @@ enum io_uring_op {
 	IORING_OP_FUTEX_WAITV,
 	IORING_OP_FIXED_FD_INSTALL,
 	IORING_OP_FTRUNCATE,
+	IORING_OP_RECV_ZC,
+	IORING_OP_FUTEX_WAKEV,
+	IORING_OP_SENDFILE,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -389,6 +392,18 @@ enum io_uring_op {
 enum io_uring_msg_ring_flags {
 	IORING_MSG_DATA,	/* pass sqe->len as 'res' and off as user_data */
 	IORING_MSG_SEND_FD,	/* send a registered fd to another ring */
+	IORING_MSG_DATA_VEC,	/* post sqe->len CQEs described by the
+				 * io_uring_msg_data array at sqe->off */
+};
+
+/*
+ * One message of an IORING_MSG_DATA_VEC batch. flags is only passed through
+ * to cqe->flags if IORING_MSG_RING_FLAGS_PASS is set.
+ */
+struct io_uring_msg_data {
+	__u64	user_data;
+	__s32	res;
+	__u32	flags;
 };
 
 /*
@@ -438,11 +453,18 @@ struct io_uring_cqe {
  * IORING_CQE_F_SOCK_NONEMPTY	If set, more data to read after socket recv
  * IORING_CQE_F_NOTIF	Set for notification CQEs. Can be used to distinct
  * 			them from sends.
+ * IORING_CQE_F_BUF_MORE	If set, the buffer ID set in the completion will get
+ *			more completions. In other words, the buffer is being
+ *			partially consumed, and will be used by the kernel for
+ *			more completions. This is only set for buffers used via
+ *			the incremental buffer consumption, as provided by
+ *			a ring buffer setup with IOU_PBUF_RING_INC.
  */
 #define IORING_CQE_F_BUFFER		(1U << 0)
 #define IORING_CQE_F_MORE		(1U << 1)
 #define IORING_CQE_F_SOCK_NONEMPTY	(1U << 2)
 #define IORING_CQE_F_NOTIF		(1U << 3)
+#define IORING_CQE_F_BUF_MORE		(1U << 4)
 
 #define IORING_CQE_BUFFER_SHIFT		16
 
@@ -517,7 +539,8 @@ struct io_uring_params {
 	__u32 sq_thread_idle;
 	__u32 features;
 	__u32 wq_fd;
-	__u32 resv[3];
+	__u32 sq_thread_weight;
+	__u32 resv[2];
 	struct io_sqring_offsets sq_off;
 	struct io_cqring_offsets cq_off;
 };
@@ -540,6 +563,7 @@ struct io_uring_params {
 #define IORING_FEAT_LINKED_FILE		(1U << 12)
 #define IORING_FEAT_REG_REG_RING	(1U << 13)
 #define IORING_FEAT_RECVSEND_BUNDLE	(1U << 14)
+#define IORING_FEAT_SQPOLL_WEIGHT	(1U << 15)
 
 /*
  * io_uring_register(2) opcodes and arguments
@@ -593,6 +617,15 @@ enum io_uring_register_op {
 	IORING_REGISTER_NAPI			= 27,
 	IORING_UNREGISTER_NAPI			= 28,
 
+	/* register a zero copy receive area and its refill queue */
+	IORING_REGISTER_ZCRX_IFQ		= 29,
+
+	/* copy registered buffers from source ring to current ring */
+	IORING_REGISTER_CLONE_BUFFERS		= 30,
+
+	/* enable per-opcode latency stats, shown in fdinfo */
+	IORING_REGISTER_OP_STATS		= 31,
+
 	/* this goes last */
 	IORING_REGISTER_LAST,
 
@@ -705,9 +738,17 @@ struct io_uring_buf_ring {
  *			mmap(2) with the offset set as:
  *			IORING_OFF_PBUF_RING | (bgid << IORING_OFF_PBUF_SHIFT)
  *			to get a virtual mapping for the ring.
+ * IOU_PBUF_RING_INC:	If set, buffers consumed from this buffer ring can be
+ *			consumed incrementally. Normally one (or more) buffers
+ *			are fully consumed. With incremental consumptions, it's
+ *			feasible to register big ranges of buffers, and each
+ *			use of it will consume only as much as it needs. This
+ *			requires that both the kernel and application keep
+ *			track of where the current read/recv index is at.
  */
 enum io_uring_register_pbuf_ring_flags {
 	IOU_PBUF_RING_MMAP	= 1,
+	IOU_PBUF_RING_INC	= 2,
 };
 
 /* argument for IORING_(UN)REGISTER_PBUF_RING */
@@ -726,11 +767,30 @@ struct io_uring_buf_status {
 	__u32	resv[8];
 };
 
+/* io_uring_napi->flags */
+enum {
+	/* shrink or grow the busy poll window with the poll hit rate */
+	IORING_NAPI_ADAPTIVE	= (1U << 0),
+};
+
+/* src_fd is a registered ring index, not a normal file descriptor */
+enum {
+	IORING_REGISTER_SRC_REGISTERED	= (1U << 0),
+};
+
+/* argument for IORING_REGISTER_CLONE_BUFFERS */
+struct io_uring_clone_buffers {
+	__u32	src_fd;
+	__u32	flags;
+	__u32	pad[6];
+};
+
 /* argument for IORING_(UN)REGISTER_NAPI */
 struct io_uring_napi {
 	__u32	busy_poll_to;
 	__u8	prefer_busy_poll;
-	__u8	pad[3];
+	__u8	flags;
+	__u8	pad[2];
 	__u64	resv;
 };
 
@@ -790,6 +850,53 @@ struct io_uring_recvmsg_out {
 	__u32 flags;
 };
 
+/* Zero copy receive refill queue entry, returns a buffer to the kernel */
+struct io_uring_zcrx_rqe {
+	__u64	off;
+	__u32	len;
+	__u32	__pad;
+};
+
+/*
+ * IORING_OP_RECV_ZC completions need IORING_SETUP_CQE32, the second half
+ * of the CQE carries the offset of the payload in the receive area.
+ */
+struct io_uring_zcrx_cqe {
+	__u64	off;
+	__u64	__pad;
+};
+
+struct io_uring_zcrx_offsets {
+	__u32	head;
+	__u32	tail;
+	__u32	rqes;
+	__u32	__resv2;
+	__u64	__resv[2];
+};
+
+/* Receive area, page aligned user memory payload is placed into */
+struct io_uring_zcrx_area_reg {
+	__u64	addr;
+	__u64	len;
+	__u32	flags;
+	__u32	__resv1;
+	__u64	__resv2[2];
+};
+
+/*
+ * Argument for IORING_REGISTER_ZCRX_IFQ. The refill queue lives in page
+ * aligned user memory at rq_addr, laid out according to the offsets the
+ * kernel writes back.
+ */
+struct io_uring_zcrx_ifq_reg {
+	__u32	rq_entries;
+	__u32	flags;
+	__u64	rq_addr;
+	__u64	area_ptr;	/* pointer to struct io_uring_zcrx_area_reg */
+	struct io_uring_zcrx_offsets offsets;
+	__u64	__resv[4];
+};
+
 /*
  * Argument for IORING_OP_URING_CMD when file is a socket
  */
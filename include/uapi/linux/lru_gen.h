@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_LRU_GEN_H
+#define _UAPI_LINUX_LRU_GEN_H
+
+#include <linux/types.h>
+
+/*
+ * Binary layout of the memory.lru_gen_hist cgroup file: one
+ * struct lru_gen_hist_header followed by header.nr_nodes records of
+ * struct lru_gen_hist_node, one per node with memory. All counts are in
+ * pages. Readers should check the version and record size, and use
+ * nr_gens/nr_tiers rather than the array sizes to know how many entries
+ * are valid.
+ */
+#define LRU_GEN_HIST_VERSION	1
+
+#define LRU_GEN_HIST_MAX_GENS	4
+#define LRU_GEN_HIST_MAX_TIERS	4
+
+enum {
+	LRU_GEN_HIST_ANON,
+	LRU_GEN_HIST_FILE,
+	LRU_GEN_HIST_NR_TYPES
+};
+
+struct lru_gen_hist_header {
+	__u32 version;
+	__u32 record_size;	/* sizeof(struct lru_gen_hist_node) */
+	__u32 nr_nodes;
+	__u32 nr_gens;		/* valid entries of lru_gen_hist_node.gens */
+	__u32 nr_tiers;		/* valid entries of lru_gen_hist_node.tiers */
+	__u32 __reserved;
+};
+
+struct lru_gen_hist_gen {
+	__u64 seq;
+	__u64 age_ms;		/* time since the generation was created */
+	__u64 nr_pages[LRU_GEN_HIST_NR_TYPES];
+};
+
+struct lru_gen_hist_tier {
+	/* moving averages over past evictions */
+	__u64 avg_refaulted[LRU_GEN_HIST_NR_TYPES];
+	__u64 avg_total[LRU_GEN_HIST_NR_TYPES];
+	/* running counts for the oldest generation */
+	__u64 refaulted[LRU_GEN_HIST_NR_TYPES];
+	__u64 evicted[LRU_GEN_HIST_NR_TYPES];
+	__u64 protected[LRU_GEN_HIST_NR_TYPES];
+};
+
+struct lru_gen_hist_node {
+	__u32 nid;
+	__u32 __reserved;
+	__u64 max_seq;
+	__u64 min_seq[LRU_GEN_HIST_NR_TYPES];
+	/* youngest first, generations below min_seq of a type have 0 pages */
+	struct lru_gen_hist_gen gens[LRU_GEN_HIST_MAX_GENS];
+	struct lru_gen_hist_tier tiers[LRU_GEN_HIST_MAX_TIERS];
+};
+
+#endif /* _UAPI_LINUX_LRU_GEN_H */
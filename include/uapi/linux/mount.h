@@ -124,6 +124,7 @@ enum fsconfig_command {
 #define MOUNT_ATTR_NODIRATIME	0x00000080 /* Do not update directory access times */
 #define MOUNT_ATTR_IDMAP	0x00100000 /* Idmap mount to @userns_fd in struct mount_attr. */
 #define MOUNT_ATTR_NOSYMFOLLOW	0x00200000 /* Do not follow symlinks */
+#define MOUNT_ATTR_WALKCACHE	0x00400000 /* Cache deep path walks */
 
 /*
  * mount_setattr()
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_PIDSTATS_H
+#define _UAPI_LINUX_PIDSTATS_H
+
+#include <linux/types.h>
+
+/*
+ * /proc/pidstats returns one record per visible thread group:
+ *
+ *	struct pidstats_record, followed by one __u64 for every bit set
+ *	in ->mask, lowest bit first.
+ *
+ * Writing a __u64 field mask to the file before reading selects the
+ * fields; by default all of them are returned.  Unknown bits are rejected.
+ * Records are 8 byte aligned, ->size covers the header and the values.
+ */
+struct pidstats_record {
+	__u32	size;
+	__u32	pid;
+	__u64	mask;
+	__u64	values[];
+};
+
+#define PIDSTATS_PPID		(1ULL << 0)
+#define PIDSTATS_STATE		(1ULL << 1)	/* state letter, as in stat */
+#define PIDSTATS_UID		(1ULL << 2)	/* real uid */
+#define PIDSTATS_GID		(1ULL << 3)	/* real gid */
+#define PIDSTATS_NUM_THREADS	(1ULL << 4)
+#define PIDSTATS_PRIORITY	(1ULL << 5)	/* as in stat, signed */
+#define PIDSTATS_NICE		(1ULL << 6)	/* signed */
+#define PIDSTATS_UTIME		(1ULL << 7)	/* nanoseconds */
+#define PIDSTATS_STIME		(1ULL << 8)	/* nanoseconds */
+#define PIDSTATS_START_TIME	(1ULL << 9)	/* nanoseconds since boot */
+#define PIDSTATS_MIN_FLT	(1ULL << 10)
+#define PIDSTATS_MAJ_FLT	(1ULL << 11)
+#define PIDSTATS_VSIZE		(1ULL << 12)	/* bytes */
+#define PIDSTATS_RSS		(1ULL << 13)	/* bytes */
+#define PIDSTATS_NVCSW		(1ULL << 14)	/* of the group leader */
+#define PIDSTATS_NIVCSW		(1ULL << 15)	/* of the group leader */
+#define PIDSTATS_PROCESSOR	(1ULL << 16)	/* last CPU of the leader */
+
+#define PIDSTATS_ALL		((1ULL << 17) - 1)
+
+#endif /* _UAPI_LINUX_PIDSTATS_H */
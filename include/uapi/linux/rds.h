@@ -137,7 +137,10 @@ typedef __u8	rds_tos_t;
 #define RDS6_INFO_TCP_SOCKETS		10016
 #define RDS6_INFO_IB_CONNECTIONS	10017
 
-#define RDS_INFO_LAST			10017
+/* Per path statistics of TCP connections, both IPv4 and IPv6 */
+#define RDS_INFO_TCP_PATHS		10018
+
+#define RDS_INFO_LAST			10018
 
 struct rds_info_counter {
 	__u8	name[32];
@@ -239,6 +242,19 @@ struct rds6_info_tcp_socket {
 	__u32		last_seen_una;
 } __attribute__((packed));
 
+struct rds_info_tcp_path {
+	struct in6_addr	local_addr;
+	__be16		local_port;
+	struct in6_addr	peer_addr;
+	__be16		peer_port;
+	__u8		tos;
+	__u8		path_index;
+	__u64		tx_msgs;
+	__u64		tx_bytes;
+	__u64		rx_msgs;
+	__u64		rx_bytes;
+} __attribute__((packed));
+
 #define RDS_IB_GID_LEN	16
 struct rds_info_rdma_connection {
 	__be32		src_addr;
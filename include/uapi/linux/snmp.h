@@ -339,6 +339,8 @@ enum
 	LINUX_MIB_XFRMACQUIREERROR,		/* XfrmAcquireError */
 	LINUX_MIB_XFRMOUTSTATEDIRERROR,		/* XfrmOutStateDirError */
 	LINUX_MIB_XFRMINSTATEDIRERROR,		/* XfrmInStateDirError */
+	LINUX_MIB_XFRMPOLCACHEHIT,		/* XfrmPolCacheHit */
+	LINUX_MIB_XFRMPOLCACHEMISS,		/* XfrmPolCacheMiss */
 	__LINUX_MIB_XFRMMAX
 };
 
@@ -358,6 +360,10 @@ enum
 	LINUX_MIB_TLSRXDEVICERESYNC,		/* TlsRxDeviceResync */
 	LINUX_MIB_TLSDECRYPTRETRY,		/* TlsDecryptRetry */
 	LINUX_MIB_TLSRXNOPADVIOL,		/* TlsRxNoPadViolation */
+	LINUX_MIB_TLSRXASYNC,			/* TlsRxAsync */
+	LINUX_MIB_TLSRXASYNCBUSY,		/* TlsRxAsyncBusy */
+	LINUX_MIB_TLSTXDEVICERESYNC,		/* TlsTxDeviceResync */
+	LINUX_MIB_TLSTXDEVICEFALLBACK,		/* TlsTxDeviceFallback */
 	__LINUX_MIB_TLSMAX
 };
 
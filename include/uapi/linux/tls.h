@@ -194,6 +194,10 @@ enum {
 	TLS_INFO_RXCONF,
 	TLS_INFO_ZC_RO_TX,
 	TLS_INFO_RX_NO_PAD,
+	TLS_INFO_TX_FALLBACK_PKTS,	/* uint */
+	TLS_INFO_TX_FALLBACK_BYTES,	/* uint */
+	TLS_INFO_TX_RESYNCS,		/* u32 */
+	TLS_INFO_RX_RESYNCS,		/* u32 */
 	__TLS_INFO_MAX,
 };
 #define TLS_INFO_MAX (__TLS_INFO_MAX - 1)
@@ -13,4 +13,10 @@ struct sockaddr_un {
 
 #define SIOCUNIXFILE (SIOCPROTOPRIVATE + 0) /* open a socket file with O_PATH */
 
+/* 'cmsg_level' and 'cmsg_type' of MSG_ZEROCOPY completion notifications
+ * read from the error queue of a SOCK_STREAM socket.
+ */
+#define SOL_UNIX	288
+#define UNIX_RECVERR	1
+
 #endif /* _LINUX_UN_H */
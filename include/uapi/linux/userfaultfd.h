@@ -42,10 +42,12 @@
 			   UFFD_FEATURE_WP_UNPOPULATED |	\
 			   UFFD_FEATURE_POISON |		\
 			   UFFD_FEATURE_WP_ASYNC |		\
-			   UFFD_FEATURE_MOVE)
+			   UFFD_FEATURE_MOVE |			\
+			   UFFD_FEATURE_COPY_VEC)
 #define UFFD_API_IOCTLS				\
 	((__u64)1 << _UFFDIO_REGISTER |		\
 	 (__u64)1 << _UFFDIO_UNREGISTER |	\
+	 (__u64)1 << _UFFDIO_COPY_VEC |		\
 	 (__u64)1 << _UFFDIO_API)
 #define UFFD_API_RANGE_IOCTLS			\
 	((__u64)1 << _UFFDIO_WAKE |		\
@@ -79,6 +81,7 @@
 #define _UFFDIO_WRITEPROTECT		(0x06)
 #define _UFFDIO_CONTINUE		(0x07)
 #define _UFFDIO_POISON			(0x08)
+#define _UFFDIO_COPY_VEC		(0x09)
 #define _UFFDIO_API			(0x3F)
 
 /* userfaultfd ioctl ids */
@@ -103,6 +106,8 @@
 				      struct uffdio_continue)
 #define UFFDIO_POISON		_IOWR(UFFDIO, _UFFDIO_POISON, \
 				      struct uffdio_poison)
+#define UFFDIO_COPY_VEC		_IOWR(UFFDIO, _UFFDIO_COPY_VEC, \
+				      struct uffdio_copy_vec)
 
 /* read() structure */
 struct uffd_msg {
@@ -248,6 +253,7 @@ struct uffdio_api {
 #define UFFD_FEATURE_POISON			(1<<14)
 #define UFFD_FEATURE_WP_ASYNC			(1<<15)
 #define UFFD_FEATURE_MOVE			(1<<16)
+#define UFFD_FEATURE_COPY_VEC			(1<<17)
 	__u64 features;
 
 	__u64 ioctls;
@@ -374,6 +380,37 @@ struct uffdio_move {
 	__s64 move;
 };
 
+/*
+ * UFFDIO_COPY_VEC resolves many faults with a single ioctl: "vec" points
+ * to an array of "nr" struct uffdio_copy, each processed as by
+ * UFFDIO_COPY (or UFFDIO_CONTINUE with UFFDIO_COPY_VEC_MODE_CONTINUE,
+ * in which case "src" is ignored), with its result written to its "copy"
+ * field.  Processing stops at the first entry that fails or is only
+ * partially copied.
+ *
+ * With UFFDIO_COPY_VEC_MODE_ASYNC the ioctl returns as soon as the
+ * vector is queued, and the eventfd "eventfd" is signaled once all
+ * entries have been processed and their results written back.  The
+ * vector, the source buffers and the uffdio_copy_vec itself must stay
+ * valid until then.
+ */
+struct uffdio_copy_vec {
+	__u64 vec;
+	__u64 nr;
+#define UFFDIO_COPY_VEC_MODE_CONTINUE		((__u64)1<<0)
+#define UFFDIO_COPY_VEC_MODE_ASYNC		((__u64)1<<1)
+	__u64 mode;
+	__s32 eventfd;
+	__u32 pad;
+	/*
+	 * "copied" is the number of entries completely processed, it is
+	 * written by the ioctl and must be at the end: the copy_from_user
+	 * will not read the last 8 bytes.
+	 */
+	__s64 copied;
+};
+#define UFFDIO_COPY_VEC_MAX			1024
+
 /*
  * Flags for the userfaultfd(2) system call itself.
  */
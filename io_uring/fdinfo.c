@@ -14,6 +14,8 @@
 #include "fdinfo.h"
 #include "cancel.h"
 #include "rsrc.h"
+#include "tctx.h"
+#include "opstats.h"
 
 #ifdef CONFIG_PROC_FS
 static __cold int io_uring_show_cred(struct seq_file *m, unsigned int id,
@@ -165,6 +167,23 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	seq_printf(m, "SqThreadCpu:\t%d\n", sq_cpu);
 	seq_printf(m, "SqTotalTime:\t%llu\n", sq_total_time);
 	seq_printf(m, "SqWorkTime:\t%llu\n", sq_work_time);
+	if (ctx->flags & IORING_SETUP_SQPOLL) {
+		seq_printf(m, "SqWeight:\t%u\n", ctx->sq_weight);
+		seq_printf(m, "SqSubmitted:\t%llu\n", ctx->sq_submitted);
+		seq_printf(m, "SqBackoffs:\t%llu\n", ctx->sq_backoffs);
+		seq_printf(m, "SqSleeps:\t%llu\n", ctx->sq_sleeps);
+		seq_printf(m, "SqIdleTime:\t%u\n",
+			   jiffies_to_msecs(jiffies - ctx->sq_last_active));
+	}
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	if (READ_ONCE(ctx->napi_enabled)) {
+		seq_printf(m, "NapiBusyPollTo:\t%u\n", ctx->napi_busy_poll_to);
+		seq_printf(m, "NapiAdaptive:\t%d\n", ctx->napi_adaptive);
+		seq_printf(m, "NapiAdaptiveTo:\t%u\n", ctx->napi_adaptive_to);
+		seq_printf(m, "NapiHits:\t%lu\n", ctx->napi_nr_hits);
+		seq_printf(m, "NapiMisses:\t%lu\n", ctx->napi_nr_misses);
+	}
+#endif
 	seq_printf(m, "UserFiles:\t%u\n", ctx->nr_user_files);
 	for (i = 0; has_lock && i < ctx->nr_user_files; i++) {
 		struct file *f = io_file_from_index(&ctx->file_table, i);
@@ -189,6 +208,19 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 		xa_for_each(&ctx->personalities, index, cred)
 			io_uring_show_cred(m, index, cred);
 	}
+	if (has_lock && !list_empty(&ctx->tctx_list)) {
+		struct io_tctx_node *node;
+
+		seq_puts(m, "IoWq:\n");
+		list_for_each_entry(node, &ctx->tctx_list, ctx_node) {
+			struct io_uring_task *tctx = node->task->io_uring;
+
+			if (!tctx || !tctx->io_wq)
+				continue;
+			seq_printf(m, " task=%d\n", task_pid_nr(node->task));
+			io_wq_show_fdinfo(m, tctx->io_wq);
+		}
+	}
 
 	seq_puts(m, "PollList:\n");
 	for (i = 0; i < (1U << ctx->cancel_table.hash_bits); i++) {
@@ -212,6 +244,8 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	if (has_lock)
 		mutex_unlock(&ctx->uring_lock);
 
+	io_op_stats_show_fdinfo(ctx, m);
+
 	seq_puts(m, "CqOverflowList:\n");
 	spin_lock(&ctx->completion_lock);
 	list_for_each_entry(ocqe, &ctx->cq_overflow_list, list) {
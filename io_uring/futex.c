@@ -363,6 +363,75 @@ int io_futex_wait(struct io_kiocb *req, unsigned int issue_flags)
 	return IOU_OK;
 }
 
+/*
+ * Wake a vector of futexes. Each futex_waitv entry gives the futex, its
+ * FUTEX2_* flags and, in val, the max number of waiters to wake on it. The
+ * mask in sqe->addr3 applies to all of them.
+ */
+int io_futex_wakev_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	struct futex_vector *futexv;
+	struct futex_waitv aux;
+	unsigned int i;
+
+	if (unlikely(sqe->fd || sqe->buf_index || sqe->file_index ||
+		     sqe->addr2 || sqe->futex_flags))
+		return -EINVAL;
+
+	iof->uaddr = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	iof->futex_mask = READ_ONCE(sqe->addr3);
+	iof->futex_nr = READ_ONCE(sqe->len);
+	if (!iof->futex_nr || iof->futex_nr > FUTEX_WAITV_MAX)
+		return -EINVAL;
+	if (!iof->futex_mask || iof->futex_mask > U32_MAX)
+		return -EINVAL;
+
+	futexv = kcalloc(iof->futex_nr, sizeof(*futexv), GFP_KERNEL);
+	if (!futexv)
+		return -ENOMEM;
+
+	for (i = 0; i < iof->futex_nr; i++) {
+		unsigned int flags;
+
+		if (copy_from_user(&aux, &iof->uwaitv[i], sizeof(aux)))
+			goto fault;
+		if ((aux.flags & ~FUTEX2_VALID_MASK) || aux.__reserved ||
+		    aux.val > INT_MAX)
+			goto inval;
+		flags = futex2_to_flags(aux.flags);
+		if (!futex_flags_valid(flags))
+			goto inval;
+
+		futexv[i].w.flags = flags;
+		futexv[i].w.val = aux.val;
+		futexv[i].w.uaddr = aux.uaddr;
+	}
+
+	req->flags |= REQ_F_ASYNC_DATA;
+	req->async_data = futexv;
+	return 0;
+fault:
+	kfree(futexv);
+	return -EFAULT;
+inval:
+	kfree(futexv);
+	return -EINVAL;
+}
+
+int io_futex_wakev(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	int ret;
+
+	ret = futex_wake_multiple(req->async_data, iof->futex_nr,
+				  iof->futex_mask);
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
+
 int io_futex_wake(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
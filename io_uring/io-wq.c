@@ -16,6 +16,7 @@
 #include <linux/task_work.h>
 #include <linux/audit.h>
 #include <linux/mmu_context.h>
+#include <linux/seq_file.h>
 #include <uapi/linux/io_uring.h>
 
 #include "io-wq.h"
@@ -23,6 +24,8 @@
 #include "io_uring.h"
 
 #define WORKER_IDLE_TIMEOUT	(5 * HZ)
+/* how far past a remote item a worker looks for work local to its node */
+#define IO_WQ_NODE_SCAN		8
 
 enum {
 	IO_WORKER_F_UP		= 0,	/* up and active */
@@ -50,6 +53,7 @@ struct io_worker {
 	struct list_head all_list;
 	struct task_struct *task;
 	struct io_wq *wq;
+	int node;
 
 	struct io_wq_work *cur_work;
 	raw_spinlock_t lock;
@@ -83,6 +87,18 @@ struct io_wq_acct {
 	unsigned long flags;
 };
 
+/*
+ * Work accounted to the node it asked for, or to the node of the worker
+ * that ran it if it had no preference.
+ */
+struct io_wq_node_stats {
+	atomic_long_t nr_work;
+	/* ran by a worker on another node */
+	atomic_long_t nr_remote;
+	atomic64_t delay_ns;
+	atomic64_t max_delay_ns;
+};
+
 enum {
 	IO_WQ_ACCT_BOUND,
 	IO_WQ_ACCT_UNBOUND,
@@ -120,6 +136,9 @@ struct io_wq {
 	struct io_wq_work *hash_tail[IO_WQ_NR_HASH_BUCKETS];
 
 	cpumask_var_t cpu_mask;
+
+	/* nr_node_ids entries */
+	struct io_wq_node_stats *node_stats;
 };
 
 static enum cpuhp_state io_wq_online;
@@ -132,7 +151,7 @@ struct io_cb_cancel_data {
 	bool cancel_all;
 };
 
-static bool create_io_worker(struct io_wq *wq, int index);
+static bool create_io_worker(struct io_wq *wq, int index, int node);
 static void io_wq_dec_running(struct io_worker *worker);
 static bool io_acct_cancel_pending_work(struct io_wq *wq,
 					struct io_wq_acct *acct,
@@ -267,7 +286,7 @@ static inline bool io_acct_run_queue(struct io_wq_acct *acct)
  * caller must create one.
  */
 static bool io_wq_activate_free_worker(struct io_wq *wq,
-					struct io_wq_acct *acct)
+					struct io_wq_acct *acct, int node)
 	__must_hold(RCU)
 {
 	struct hlist_nulls_node *n;
@@ -281,7 +300,8 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
 	hlist_nulls_for_each_entry_rcu(worker, n, &wq->free_list, nulls_node) {
 		if (!io_worker_get(worker))
 			continue;
-		if (io_wq_get_acct(worker) != acct) {
+		if (io_wq_get_acct(worker) != acct ||
+		    (node != NUMA_NO_NODE && worker->node != node)) {
 			io_worker_release(worker);
 			continue;
 		}
@@ -302,7 +322,8 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
  * We need a worker. If we find a free one, we're good. If not, and we're
  * below the max number of workers, create one.
  */
-static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
+static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct,
+				int node)
 {
 	/*
 	 * Most likely an attempt to queue unbounded work on an io_wq that
@@ -320,7 +341,7 @@ static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
 	raw_spin_unlock(&wq->lock);
 	atomic_inc(&acct->nr_running);
 	atomic_inc(&wq->worker_refs);
-	return create_io_worker(wq, acct->index);
+	return create_io_worker(wq, acct->index, node);
 }
 
 static void io_wq_inc_running(struct io_worker *worker)
@@ -349,7 +370,7 @@ static void create_worker_cb(struct callback_head *cb)
 	}
 	raw_spin_unlock(&wq->lock);
 	if (do_create) {
-		create_io_worker(wq, worker->create_index);
+		create_io_worker(wq, worker->create_index, worker->node);
 	} else {
 		atomic_dec(&acct->nr_running);
 		io_worker_ref_put(wq);
@@ -476,8 +497,9 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 	__must_hold(acct->lock)
 {
 	struct io_wq_work_node *node, *prev;
+	struct io_wq_work_node *remote = NULL, *remote_prev = NULL;
 	struct io_wq_work *work, *tail;
-	unsigned int stall_hash = -1U;
+	unsigned int stall_hash = -1U, scanned = 0;
 	struct io_wq *wq = worker->wq;
 
 	wq_list_for_each(node, prev, &acct->work_list) {
@@ -485,10 +507,25 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 
 		work = container_of(node, struct io_wq_work, list);
 
-		/* not hashed, can run anytime */
+		/*
+		 * Not hashed, can run anytime. Prefer work local to our node,
+		 * but don't look too far past the first remote item.
+		 */
 		if (!io_wq_is_hashed(work)) {
-			wq_list_del(&acct->work_list, node, prev);
-			return work;
+			int work_node = io_wq_work_node(work);
+
+			if (work_node == NUMA_NO_NODE ||
+			    work_node == worker->node) {
+				wq_list_del(&acct->work_list, node, prev);
+				return work;
+			}
+			if (!remote) {
+				remote = node;
+				remote_prev = prev;
+			}
+			if (++scanned >= IO_WQ_NODE_SCAN)
+				break;
+			continue;
 		}
 
 		hash = io_get_work_hash(work);
@@ -507,6 +544,11 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 		node = &tail->list;
 	}
 
+	if (remote) {
+		wq_list_del(&acct->work_list, remote, remote_prev);
+		return container_of(remote, struct io_wq_work, list);
+	}
+
 	if (stall_hash != -1U) {
 		bool unstalled;
 
@@ -528,6 +570,34 @@ static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
 	return NULL;
 }
 
+static void io_wq_account_work(struct io_worker *worker,
+			       struct io_wq_work *work)
+{
+	int node = io_wq_work_node(work);
+	struct io_wq_node_stats *stats;
+	s64 delay, max;
+
+	if (!worker->wq->node_stats)
+		return;
+	if (node == NUMA_NO_NODE)
+		node = worker->node;
+	if (node == NUMA_NO_NODE)
+		node = numa_node_id();
+
+	stats = &worker->wq->node_stats[node];
+	delay = max_t(s64, ktime_get_ns() - work->queued_ns, 0);
+	atomic_long_inc(&stats->nr_work);
+	if (node != worker->node)
+		atomic_long_inc(&stats->nr_remote);
+	atomic64_add(delay, &stats->delay_ns);
+
+	max = atomic64_read(&stats->max_delay_ns);
+	while (delay > max) {
+		if (atomic64_try_cmpxchg(&stats->max_delay_ns, &max, delay))
+			break;
+	}
+}
+
 static void io_assign_current_work(struct io_worker *worker,
 				   struct io_wq_work *work)
 {
@@ -580,6 +650,7 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 		if (!work)
 			break;
 
+		io_wq_account_work(worker, work);
 		__io_worker_busy(wq, worker);
 
 		io_assign_current_work(worker, work);
@@ -727,9 +798,23 @@ void io_wq_worker_sleeping(struct task_struct *tsk)
 static void io_init_new_worker(struct io_wq *wq, struct io_worker *worker,
 			       struct task_struct *tsk)
 {
+	cpumask_var_t mask;
+
 	tsk->worker_private = worker;
 	worker->task = tsk;
-	set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+
+	/* keep a node's worker on that node, within the io-wq affinity */
+	if (worker->node != NUMA_NO_NODE &&
+	    alloc_cpumask_var(&mask, GFP_KERNEL)) {
+		if (cpumask_and(mask, wq->cpu_mask,
+				cpumask_of_node(worker->node)))
+			set_cpus_allowed_ptr(tsk, mask);
+		else
+			set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+		free_cpumask_var(mask);
+	} else {
+		set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+	}
 
 	raw_spin_lock(&wq->lock);
 	hlist_nulls_add_head_rcu(&worker->nulls_node, &wq->free_list);
@@ -773,7 +858,7 @@ static void create_worker_cont(struct callback_head *cb)
 	worker = container_of(cb, struct io_worker, create_work);
 	clear_bit_unlock(0, &worker->create_state);
 	wq = worker->wq;
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, worker->node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 		io_worker_release(worker);
@@ -815,7 +900,7 @@ static void io_workqueue_create(struct work_struct *work)
 		kfree(worker);
 }
 
-static bool create_io_worker(struct io_wq *wq, int index)
+static bool create_io_worker(struct io_wq *wq, int index, int node)
 {
 	struct io_wq_acct *acct = &wq->acct[index];
 	struct io_worker *worker;
@@ -836,13 +921,14 @@ static bool create_io_worker(struct io_wq *wq, int index)
 
 	refcount_set(&worker->ref, 1);
 	worker->wq = wq;
+	worker->node = node;
 	raw_spin_lock_init(&worker->lock);
 	init_completion(&worker->ref_done);
 
 	if (index == IO_WQ_ACCT_BOUND)
 		set_bit(IO_WORKER_F_BOUND, &worker->flags);
 
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 	} else if (!io_should_retry_thread(PTR_ERR(tsk))) {
@@ -927,12 +1013,13 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 {
 	struct io_wq_acct *acct = io_work_get_acct(wq, work);
 	unsigned long work_flags = work->flags;
+	int node = io_wq_work_node(work);
 	struct io_cb_cancel_data match = {
 		.fn		= io_wq_work_match_item,
 		.data		= work,
 		.cancel_all	= false,
 	};
-	bool do_create;
+	bool do_create, need_worker;
 
 	/*
 	 * If io-wq is exiting for this task, or if the request has explicitly
@@ -944,20 +1031,32 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 		return;
 	}
 
+	work->queued_ns = ktime_get_ns();
 	raw_spin_lock(&acct->lock);
 	io_wq_insert_work(wq, work);
 	clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
 	raw_spin_unlock(&acct->lock);
 
+	need_worker = (work_flags & IO_WQ_WORK_CONCURRENT) ||
+			!atomic_read(&acct->nr_running);
+
 	rcu_read_lock();
-	do_create = !io_wq_activate_free_worker(wq, acct);
+	do_create = !io_wq_activate_free_worker(wq, acct, node);
+	/*
+	 * No idle worker on the node the work wants. Grow that node's pool
+	 * if we'd create a worker anyway and there's room, otherwise borrow
+	 * an idle worker from any node.
+	 */
+	if (do_create && node != NUMA_NO_NODE &&
+	    !(need_worker &&
+	      READ_ONCE(acct->nr_workers) < READ_ONCE(acct->max_workers)))
+		do_create = !io_wq_activate_free_worker(wq, acct, NUMA_NO_NODE);
 	rcu_read_unlock();
 
-	if (do_create && ((work_flags & IO_WQ_WORK_CONCURRENT) ||
-	    !atomic_read(&acct->nr_running))) {
+	if (do_create && need_worker) {
 		bool did_create;
 
-		did_create = io_wq_create_worker(wq, acct);
+		did_create = io_wq_create_worker(wq, acct, node);
 		if (likely(did_create))
 			return;
 
@@ -1163,6 +1262,9 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 	if (!alloc_cpumask_var(&wq->cpu_mask, GFP_KERNEL))
 		goto err;
 	cpumask_copy(wq->cpu_mask, cpu_possible_mask);
+	/* stats are best effort, io-wq works fine without them */
+	wq->node_stats = kcalloc(nr_node_ids, sizeof(*wq->node_stats),
+				 GFP_KERNEL);
 	wq->acct[IO_WQ_ACCT_BOUND].max_workers = bounded;
 	wq->acct[IO_WQ_ACCT_UNBOUND].max_workers =
 				task_rlimit(current, RLIMIT_NPROC);
@@ -1192,6 +1294,7 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 err:
 	io_wq_put_hash(data->hash);
 	free_cpumask_var(wq->cpu_mask);
+	kfree(wq->node_stats);
 	kfree(wq);
 	return ERR_PTR(ret);
 }
@@ -1261,6 +1364,7 @@ static void io_wq_destroy(struct io_wq *wq)
 	io_wq_cancel_pending_work(wq, &match);
 	free_cpumask_var(wq->cpu_mask);
 	io_wq_put_hash(wq->hash);
+	kfree(wq->node_stats);
 	kfree(wq);
 }
 
@@ -1370,6 +1474,28 @@ int io_wq_max_workers(struct io_wq *wq, int *new_count)
 	return 0;
 }
 
+#ifdef CONFIG_PROC_FS
+void io_wq_show_fdinfo(struct seq_file *m, struct io_wq *wq)
+{
+	int node;
+
+	if (!wq->node_stats)
+		return;
+
+	for_each_node(node) {
+		struct io_wq_node_stats *stats = &wq->node_stats[node];
+		unsigned long nr = atomic_long_read(&stats->nr_work);
+
+		if (!nr)
+			continue;
+		seq_printf(m, "  node%d: work=%lu remote=%lu avg_delay_ns=%llu max_delay_ns=%lld\n",
+			   node, nr, atomic_long_read(&stats->nr_remote),
+			   div64_u64(atomic64_read(&stats->delay_ns), nr),
+			   atomic64_read(&stats->max_delay_ns));
+	}
+}
+#endif
+
 static __init int io_wq_init(void)
 {
 	int ret;
@@ -5,6 +5,7 @@
 #include <linux/io_uring_types.h>
 
 struct io_wq;
+struct seq_file;
 
 enum {
 	IO_WQ_WORK_CANCEL	= 1,
@@ -12,6 +13,8 @@ enum {
 	IO_WQ_WORK_UNBOUND	= 4,
 	IO_WQ_WORK_CONCURRENT	= 16,
 
+	IO_WQ_NODE_SHIFT	= 8,	/* bits 8..23 hold the preferred node + 1 */
+	IO_WQ_NODE_MASK		= 0xffff,
 	IO_WQ_HASH_SHIFT	= 24,	/* upper 8 bits are used for hash key */
 };
 
@@ -49,6 +52,7 @@ void io_wq_put_and_exit(struct io_wq *wq);
 
 void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work);
 void io_wq_hash_work(struct io_wq_work *work, void *val);
+void io_wq_show_fdinfo(struct seq_file *m, struct io_wq *wq);
 
 int io_wq_cpu_affinity(struct io_uring_task *tctx, cpumask_var_t mask);
 int io_wq_max_workers(struct io_wq *wq, int *new_count);
@@ -59,6 +63,21 @@ static inline bool io_wq_is_hashed(struct io_wq_work *work)
 	return work->flags & IO_WQ_WORK_HASHED;
 }
 
+/*
+ * Ask for @work to be run by a worker local to @node, if the io-wq has or
+ * may create one there.
+ */
+static inline void io_wq_set_node(struct io_wq_work *work, int node)
+{
+	if (node != NUMA_NO_NODE)
+		work->flags |= (node + 1) << IO_WQ_NODE_SHIFT;
+}
+
+static inline int io_wq_work_node(struct io_wq_work *work)
+{
+	return ((work->flags >> IO_WQ_NODE_SHIFT) & IO_WQ_NODE_MASK) - 1;
+}
+
 typedef bool (work_cancel_fn)(struct io_wq_work *, void *);
 
 enum io_wq_cancel io_wq_cancel_cb(struct io_wq *wq, work_cancel_fn *cancel,
@@ -94,6 +94,7 @@
 #include "waitid.h"
 #include "futex.h"
 #include "napi.h"
+#include "zcrx.h"
 #include "uring_cmd.h"
 #include "memmap.h"
 
@@ -481,6 +482,13 @@ static void io_prep_async_work(struct io_kiocb *req)
 		if (def->unbound_nonreg_file)
 			req->work.flags |= IO_WQ_WORK_UNBOUND;
 	}
+
+	/*
+	 * Page cache for buffered IO and the user memory being copied are
+	 * most likely local to the submitter, keep the punt on that node.
+	 */
+	if (nr_online_nodes > 1)
+		io_wq_set_node(&req->work, numa_node_id());
 }
 
 static void io_prep_async_link(struct io_kiocb *req)
@@ -522,6 +530,7 @@ static void io_queue_iowq(struct io_kiocb *req)
 		req->work.flags |= IO_WQ_WORK_CANCEL;
 
 	trace_io_uring_queue_async_work(req, io_wq_is_hashed(&req->work));
+	io_op_stats_punt(req);
 	io_wq_enqueue(tctx->io_wq, &req->work);
 	if (link)
 		io_queue_linked_timeout(link);
@@ -851,7 +860,7 @@ bool io_cqe_cache_refill(struct io_ring_ctx *ctx, bool overflow)
 }
 
 static bool io_fill_cqe_aux(struct io_ring_ctx *ctx, u64 user_data, s32 res,
-			      u32 cflags)
+			      u32 cflags, u64 extra1, u64 extra2)
 {
 	struct io_uring_cqe *cqe;
 
@@ -870,8 +879,8 @@ static bool io_fill_cqe_aux(struct io_ring_ctx *ctx, u64 user_data, s32 res,
 		WRITE_ONCE(cqe->flags, cflags);
 
 		if (ctx->flags & IORING_SETUP_CQE32) {
-			WRITE_ONCE(cqe->big_cqe[0], 0);
-			WRITE_ONCE(cqe->big_cqe[1], 0);
+			WRITE_ONCE(cqe->big_cqe[0], extra1);
+			WRITE_ONCE(cqe->big_cqe[1], extra2);
 		}
 		return true;
 	}
@@ -883,7 +892,7 @@ bool io_post_aux_cqe(struct io_ring_ctx *ctx, u64 user_data, s32 res, u32 cflags
 	bool filled;
 
 	io_cq_lock(ctx);
-	filled = io_fill_cqe_aux(ctx, user_data, res, cflags);
+	filled = io_fill_cqe_aux(ctx, user_data, res, cflags, 0, 0);
 	if (!filled)
 		filled = io_cqring_event_overflow(ctx, user_data, res, cflags, 0, 0);
 
@@ -891,11 +900,47 @@ bool io_post_aux_cqe(struct io_ring_ctx *ctx, u64 user_data, s32 res, u32 cflags
 	return filled;
 }
 
+/*
+ * Post a batch of aux CQEs under a single completion lock, with one wakeup
+ * for the lot. Returns the number posted, which is only short of @nr if we
+ * failed to allocate an overflow entry.
+ */
+unsigned int io_post_aux_cqes(struct io_ring_ctx *ctx,
+			      const struct io_uring_msg_data *msgs,
+			      unsigned int nr, bool pass_flags)
+{
+	unsigned int i;
+
+	io_cq_lock(ctx);
+	for (i = 0; i < nr; i++) {
+		u32 cflags = pass_flags ? msgs[i].flags : 0;
+
+		if (io_fill_cqe_aux(ctx, msgs[i].user_data, msgs[i].res,
+				    cflags, 0, 0))
+			continue;
+		if (!io_cqring_event_overflow(ctx, msgs[i].user_data,
+					      msgs[i].res, cflags, 0, 0))
+			break;
+	}
+	io_cq_unlock_post(ctx);
+	return i;
+}
+
 /*
  * A helper for multishot requests posting additional CQEs.
  * Should only be used from a task_work including IO_URING_F_MULTISHOT.
  */
 bool io_req_post_cqe(struct io_kiocb *req, s32 res, u32 cflags)
+{
+	return io_req_post_cqe32(req, res, cflags, 0, 0);
+}
+
+/*
+ * As io_req_post_cqe(), also filling the second half of the CQE on rings
+ * set up with IORING_SETUP_CQE32.
+ */
+bool io_req_post_cqe32(struct io_kiocb *req, s32 res, u32 cflags,
+		       u64 extra1, u64 extra2)
 {
 	struct io_ring_ctx *ctx = req->ctx;
 	bool posted;
@@ -904,7 +949,8 @@ bool io_req_post_cqe(struct io_kiocb *req, s32 res, u32 cflags)
 	lockdep_assert_held(&ctx->uring_lock);
 
 	__io_cq_lock(ctx);
-	posted = io_fill_cqe_aux(ctx, req->cqe.user_data, res, cflags);
+	posted = io_fill_cqe_aux(ctx, req->cqe.user_data, res, cflags,
+				 extra1, extra2);
 	ctx->submit_state.cq_flush = true;
 	__io_cq_unlock_post(ctx);
 	return posted;
@@ -953,7 +999,7 @@ void io_req_defer_failed(struct io_kiocb *req, s32 res)
 	lockdep_assert_held(&req->ctx->uring_lock);
 
 	req_set_fail(req);
-	io_req_set_res(req, res, io_put_kbuf(req, IO_URING_F_UNLOCKED));
+	io_req_set_res(req, res, io_put_kbuf(req, res, IO_URING_F_UNLOCKED));
 	if (def->fail)
 		def->fail(req);
 	io_req_complete_defer(req);
@@ -1748,6 +1794,7 @@ static int io_issue_sqe(struct io_kiocb *req, unsigned int issue_flags)
 	if (!def->audit_skip)
 		audit_uring_entry(req->opcode);
 
+	io_op_stats_issue(req);
 	ret = def->issue(req, issue_flags);
 
 	if (!def->audit_skip)
@@ -2059,6 +2106,7 @@ static int io_init_req(struct io_ring_ctx *ctx, struct io_kiocb *req,
 	req->rsrc_node = NULL;
 	req->task = current;
 	req->cancel_seq_set = false;
+	io_op_stats_submit(req);
 
 	if (unlikely(opcode >= IORING_OP_LAST)) {
 		req->opcode = 0;
@@ -2651,6 +2699,7 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	io_alloc_cache_free(&ctx->uring_cache, kfree);
 	io_futex_cache_free(ctx);
 	io_destroy_buffers(ctx);
+	io_unregister_zcrx_ifqs(ctx);
 	mutex_unlock(&ctx->uring_lock);
 	if (ctx->sq_creds)
 		put_cred(ctx->sq_creds);
@@ -2677,6 +2726,7 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	if (ctx->hash_map)
 		io_wq_put_hash(ctx->hash_map);
 	io_napi_free(ctx);
+	io_op_stats_free(ctx);
 	kfree(ctx->cancel_table.hbs);
 	kfree(ctx->cancel_table_locked.hbs);
 	xa_destroy(&ctx->io_bl_xa);
@@ -3570,7 +3620,7 @@ static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
 			IORING_FEAT_EXT_ARG | IORING_FEAT_NATIVE_WORKERS |
 			IORING_FEAT_RSRC_TAGS | IORING_FEAT_CQE_SKIP |
 			IORING_FEAT_LINKED_FILE | IORING_FEAT_REG_REG_RING |
-			IORING_FEAT_RECVSEND_BUNDLE;
+			IORING_FEAT_RECVSEND_BUNDLE | IORING_FEAT_SQPOLL_WEIGHT;
 
 	if (copy_to_user(params, p, sizeof(*p))) {
 		ret = -EFAULT;
@@ -18,9 +18,17 @@
 #define IORING_MSG_RING_MASK		(IORING_MSG_RING_CQE_SKIP | \
 					IORING_MSG_RING_FLAGS_PASS)
 
+/* Max number of messages in a single IORING_MSG_DATA_VEC */
+#define IORING_MSG_RING_MAX_VEC		256
+
 struct io_msg {
 	struct file			*file;
-	struct file			*src_file;
+	union {
+		/* IORING_MSG_SEND_FD */
+		struct file			*src_file;
+		/* IORING_MSG_DATA_VEC */
+		struct io_uring_msg_data	*vec;
+	};
 	struct callback_head		tw;
 	u64 user_data;
 	u32 len;
@@ -59,6 +67,12 @@ void io_msg_ring_cleanup(struct io_kiocb *req)
 {
 	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
 
+	if (msg->cmd == IORING_MSG_DATA_VEC) {
+		kfree(msg->vec);
+		msg->vec = NULL;
+		return;
+	}
+
 	if (WARN_ON_ONCE(!msg->src_file))
 		return;
 
@@ -155,6 +169,59 @@ static int io_msg_ring_data(struct io_kiocb *req, unsigned int issue_flags)
 	return ret;
 }
 
+static void io_msg_tw_vec_complete(struct callback_head *head)
+{
+	struct io_msg *msg = container_of(head, struct io_msg, tw);
+	struct io_kiocb *req = cmd_to_io_kiocb(msg);
+	struct io_ring_ctx *target_ctx = req->file->private_data;
+	bool pass = msg->flags & IORING_MSG_RING_FLAGS_PASS;
+	int ret = -EOWNERDEAD;
+
+	if (!(current->flags & PF_EXITING)) {
+		/* see io_msg_tw_complete() */
+		if (target_ctx->flags & IORING_SETUP_IOPOLL)
+			mutex_lock(&target_ctx->uring_lock);
+		ret = io_post_aux_cqes(target_ctx, msg->vec, msg->len, pass);
+		if (target_ctx->flags & IORING_SETUP_IOPOLL)
+			mutex_unlock(&target_ctx->uring_lock);
+		if (!ret)
+			ret = -EOVERFLOW;
+	}
+
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_queue_tw_complete(req, ret);
+}
+
+/*
+ * Deliver a batch of messages with one completion lock round trip and one
+ * wakeup of the target. Completes with the number of CQEs posted, which is
+ * only short of the batch size if the target overflowed and we could not
+ * allocate overflow entries. It's up to the sender to resend the remainder.
+ */
+static int io_msg_ring_data_vec(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_ring_ctx *target_ctx = req->file->private_data;
+	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
+	bool pass = msg->flags & IORING_MSG_RING_FLAGS_PASS;
+	int ret;
+
+	if (target_ctx->flags & IORING_SETUP_R_DISABLED)
+		return -EBADFD;
+
+	if (io_msg_need_remote(target_ctx))
+		return io_msg_exec_remote(req, io_msg_tw_vec_complete);
+
+	if (target_ctx->flags & IORING_SETUP_IOPOLL) {
+		if (unlikely(io_double_lock_ctx(target_ctx, issue_flags)))
+			return -EAGAIN;
+	}
+	ret = io_post_aux_cqes(target_ctx, msg->vec, msg->len, pass);
+	if (target_ctx->flags & IORING_SETUP_IOPOLL)
+		io_double_unlock_ctx(target_ctx);
+	return ret ?: -EOVERFLOW;
+}
+
 static struct file *io_msg_grab_file(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
@@ -261,6 +328,27 @@ int io_msg_ring_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	if (msg->flags & ~IORING_MSG_RING_MASK)
 		return -EINVAL;
 
+	/*
+	 * The batch must be copied now, it may be delivered from the
+	 * target ring's task where our memory isn't reachable.
+	 */
+	if (msg->cmd == IORING_MSG_DATA_VEC) {
+		if (msg->src_fd || msg->dst_fd ||
+		    (msg->flags & ~IORING_MSG_RING_FLAGS_PASS))
+			return -EINVAL;
+		if (!msg->len || msg->len > IORING_MSG_RING_MAX_VEC)
+			return -EINVAL;
+		msg->vec = memdup_array_user(u64_to_user_ptr(msg->user_data),
+					     msg->len, sizeof(*msg->vec));
+		if (IS_ERR(msg->vec)) {
+			int ret = PTR_ERR(msg->vec);
+
+			msg->vec = NULL;
+			return ret;
+		}
+		req->flags |= REQ_F_NEED_CLEANUP;
+	}
+
 	return 0;
 }
 
@@ -280,6 +368,9 @@ int io_msg_ring(struct io_kiocb *req, unsigned int issue_flags)
 	case IORING_MSG_SEND_FD:
 		ret = io_msg_send_fd(req, issue_flags);
 		break;
+	case IORING_MSG_DATA_VEC:
+		ret = io_msg_ring_data_vec(req, issue_flags);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
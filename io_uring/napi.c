@@ -8,6 +8,11 @@
 /* Timeout for cleanout of stale entries. */
 #define NAPI_TIMEOUT		(60 * SEC_CONVERSION)
 
+/* busy poll loops per adaptive window update */
+#define NAPI_ADAPT_EPOCH	16
+/* the adaptive window never shrinks below busy_poll_to >> NAPI_ADAPT_SHIFT */
+#define NAPI_ADAPT_SHIFT	4
+
 struct io_napi_entry {
 	unsigned int		napi_id;
 	struct list_head	list;
@@ -102,6 +107,50 @@ static inline void io_napi_remove_stale(struct io_ring_ctx *ctx, bool is_stale)
 		__io_napi_remove_stale(ctx);
 }
 
+static unsigned int io_napi_poll_to(struct io_ring_ctx *ctx)
+{
+	if (READ_ONCE(ctx->napi_adaptive))
+		return READ_ONCE(ctx->napi_adaptive_to);
+	return READ_ONCE(ctx->napi_busy_poll_to);
+}
+
+/*
+ * Account a busy poll loop as a hit if it found events to complete, or a
+ * miss if it ran until the poll window expired. With adaptive polling, at
+ * the end of each epoch widen the window when most loops hit, and narrow
+ * it when most missed so we stop burning CPU on an idle queue. The updates
+ * are racy if multiple tasks wait on the ring, which is fine for a
+ * heuristic.
+ */
+static void io_napi_adapt(struct io_ring_ctx *ctx, bool hit)
+{
+	unsigned int to, min_to, max_to;
+
+	if (hit)
+		ctx->napi_nr_hits++;
+	else
+		ctx->napi_nr_misses++;
+
+	if (!READ_ONCE(ctx->napi_adaptive))
+		return;
+	ctx->napi_epoch_hits += hit;
+	if (++ctx->napi_epoch_total < NAPI_ADAPT_EPOCH)
+		return;
+
+	max_to = READ_ONCE(ctx->napi_busy_poll_to);
+	min_to = min(max(max_to >> NAPI_ADAPT_SHIFT, 1U), max_to);
+	to = READ_ONCE(ctx->napi_adaptive_to);
+
+	if (ctx->napi_epoch_hits * 4 >= NAPI_ADAPT_EPOCH * 3)
+		to = max_to / 2 < to ? max_to : to * 2;
+	else if (ctx->napi_epoch_hits * 4 < NAPI_ADAPT_EPOCH)
+		to = to / 2;
+	WRITE_ONCE(ctx->napi_adaptive_to, clamp(to, min_to, max_to));
+
+	ctx->napi_epoch_hits = 0;
+	ctx->napi_epoch_total = 0;
+}
+
 static inline bool io_napi_busy_loop_timeout(unsigned long start_time,
 					     unsigned long bp_usec)
 {
@@ -171,6 +220,8 @@ static void io_napi_blocking_busy_loop(struct io_ring_ctx *ctx,
 	rcu_read_unlock();
 
 	io_napi_remove_stale(ctx, is_stale);
+	if (!signal_pending(current))
+		io_napi_adapt(ctx, io_should_wake(iowq) || io_has_work(ctx));
 }
 
 /*
@@ -218,19 +269,26 @@ int io_register_napi(struct io_ring_ctx *ctx, void __user *arg)
 {
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ctx->napi_busy_poll_to,
-		.prefer_busy_poll = ctx->napi_prefer_busy_poll
+		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
+		.flags		  = ctx->napi_adaptive ? IORING_NAPI_ADAPTIVE : 0,
 	};
 	struct io_uring_napi napi;
 
 	if (copy_from_user(&napi, arg, sizeof(napi)))
 		return -EFAULT;
-	if (napi.pad[0] || napi.pad[1] || napi.pad[2] || napi.resv)
+	if (napi.pad[0] || napi.pad[1] || napi.resv)
+		return -EINVAL;
+	if (napi.flags & ~IORING_NAPI_ADAPTIVE)
 		return -EINVAL;
 
 	if (copy_to_user(arg, &curr, sizeof(curr)))
 		return -EFAULT;
 
 	WRITE_ONCE(ctx->napi_busy_poll_to, napi.busy_poll_to);
+	WRITE_ONCE(ctx->napi_adaptive_to, napi.busy_poll_to);
+	ctx->napi_epoch_hits = 0;
+	ctx->napi_epoch_total = 0;
+	WRITE_ONCE(ctx->napi_adaptive, !!(napi.flags & IORING_NAPI_ADAPTIVE));
 	WRITE_ONCE(ctx->napi_prefer_busy_poll, !!napi.prefer_busy_poll);
 	WRITE_ONCE(ctx->napi_enabled, true);
 	return 0;
@@ -248,13 +306,15 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
 {
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ctx->napi_busy_poll_to,
-		.prefer_busy_poll = ctx->napi_prefer_busy_poll
+		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
+		.flags		  = ctx->napi_adaptive ? IORING_NAPI_ADAPTIVE : 0,
 	};
 
 	if (arg && copy_to_user(arg, &curr, sizeof(curr)))
 		return -EFAULT;
 
 	WRITE_ONCE(ctx->napi_busy_poll_to, 0);
+	WRITE_ONCE(ctx->napi_adaptive, false);
 	WRITE_ONCE(ctx->napi_prefer_busy_poll, false);
 	WRITE_ONCE(ctx->napi_enabled, false);
 	return 0;
@@ -273,7 +333,7 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
 void __io_napi_adjust_timeout(struct io_ring_ctx *ctx, struct io_wait_queue *iowq,
 			      struct timespec64 *ts)
 {
-	unsigned int poll_to = READ_ONCE(ctx->napi_busy_poll_to);
+	unsigned int poll_to = io_napi_poll_to(ctx);
 
 	if (ts) {
 		struct timespec64 poll_to_ts;
@@ -311,12 +371,17 @@ void __io_napi_busy_loop(struct io_ring_ctx *ctx, struct io_wait_queue *iowq)
  * io_napi_sqpoll_busy_poll() - busy poll loop for sqpoll
  * @ctx: pointer to io-uring context structure
  *
- * Splice of the napi list and execute the napi busy poll loop.
+ * Splice of the napi list and execute the napi busy poll loop. Returns 1 if
+ * polling generated work for the SQPOLL thread, so that it keeps spinning for
+ * as long as the network is busy but may still go idle once it isn't. Socket
+ * wakeups queue task_work to the SQPOLL task, so RX is picked up without the
+ * application having to enter the kernel.
  */
 int io_napi_sqpoll_busy_poll(struct io_ring_ctx *ctx)
 {
 	LIST_HEAD(napi_list);
 	bool is_stale = false;
+	bool hit;
 
 	if (!READ_ONCE(ctx->napi_busy_poll_to))
 		return 0;
@@ -328,7 +393,11 @@ int io_napi_sqpoll_busy_poll(struct io_ring_ctx *ctx)
 	rcu_read_unlock();
 
 	io_napi_remove_stale(ctx, is_stale);
-	return 1;
+
+	hit = task_work_pending(current) || io_has_work(ctx) ||
+	      !llist_empty(&current->io_uring->task_list);
+	io_napi_adapt(ctx, hit);
+	return hit;
 }
 
 #endif
@@ -118,6 +118,7 @@ struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx)
 	notif->task = current;
 	io_get_task_refs(1);
 	notif->rsrc_node = NULL;
+	notif->stat_ts = 0;
 
 	nd = io_notif_to_data(notif);
 	nd->zc_report = false;
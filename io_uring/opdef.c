@@ -484,6 +484,21 @@ const struct io_issue_def io_issue_defs[] = {
 		.prep			= io_eopnotsupp_prep,
 #endif
 	},
+	[IORING_OP_FUTEX_WAKEV] = {
+#if defined(CONFIG_FUTEX)
+		.prep			= io_futex_wakev_prep,
+		.issue			= io_futex_wakev,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
+	[IORING_OP_SENDFILE] = {
+		.needs_file		= 1,
+		.unbound_nonreg_file	= 1,
+		.audit_skip		= 1,
+		.prep			= io_sendfile_prep,
+		.issue			= io_sendfile,
+	},
 	[IORING_OP_FIXED_FD_INSTALL] = {
 		.needs_file		= 1,
 		.prep			= io_install_fixed_fd_prep,
@@ -495,6 +510,18 @@ const struct io_issue_def io_issue_defs[] = {
 		.prep			= io_ftruncate_prep,
 		.issue			= io_ftruncate,
 	},
+	[IORING_OP_RECV_ZC] = {
+		.needs_file		= 1,
+		.unbound_nonreg_file	= 1,
+		.pollin			= 1,
+		.ioprio			= 1,
+#if defined(CONFIG_NET)
+		.prep			= io_recvzc_prep,
+		.issue			= io_recvzc,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
 };
 
 const struct io_cold_def io_cold_defs[] = {
@@ -716,6 +743,15 @@ const struct io_cold_def io_cold_defs[] = {
 	[IORING_OP_FTRUNCATE] = {
 		.name			= "FTRUNCATE",
 	},
+	[IORING_OP_RECV_ZC] = {
+		.name			= "RECV_ZC",
+	},
+	[IORING_OP_FUTEX_WAKEV] = {
+		.name			= "FUTEX_WAKEV",
+	},
+	[IORING_OP_SENDFILE] = {
+		.name			= "SENDFILE",
+	},
 };
 
 const char *io_uring_get_opcode(u8 opcode)
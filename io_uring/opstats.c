@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Optional per-opcode latency histograms. Enabled per ring with
+ * IORING_REGISTER_OP_STATS, kept in per-CPU buckets so that recording is just
+ * a this_cpu_inc(), and summed up when read through fdinfo.
+ */
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/io_uring.h>
+
+#include <uapi/linux/io_uring.h>
+
+#include <trace/events/io_uring.h>
+
+#include "io_uring.h"
+#include "opdef.h"
+#include "opstats.h"
+
+static inline struct io_op_stats __percpu *io_op_stats(struct io_kiocb *req)
+{
+	return &req->ctx->op_stats[req->opcode];
+}
+
+static inline unsigned int io_op_stats_bucket(u32 delta)
+{
+	return min_t(unsigned int, fls(delta), IO_OP_STATS_BUCKETS - 1);
+}
+
+void __io_op_stats_issue(struct io_kiocb *req)
+{
+	u32 now = io_op_stats_now();
+
+	/* first issue, account the time the request spent queued */
+	if (req->stat_ts & 1) {
+		u32 delta = now - req->stat_ts;
+
+		this_cpu_inc(io_op_stats(req)->queue[io_op_stats_bucket(delta)]);
+		trace_io_uring_op_latency(req, "queue", delta);
+	}
+	req->stat_ts = (now & ~1U) ?: 2;
+}
+
+void __io_op_stats_complete(struct io_kiocb *req)
+{
+	u32 delta;
+
+	/* failed before it was ever issued */
+	if (req->stat_ts & 1)
+		return;
+
+	delta = io_op_stats_now() - req->stat_ts;
+	this_cpu_inc(io_op_stats(req)->exec[io_op_stats_bucket(delta)]);
+	trace_io_uring_op_latency(req, "exec", delta);
+}
+
+void __io_op_stats_punt(struct io_kiocb *req)
+{
+	this_cpu_inc(io_op_stats(req)->punts);
+}
+
+/*
+ * Stats can only be turned on. Requests check ctx->op_stats without any
+ * locking, clearing and freeing it under them isn't worth the trouble for a
+ * debugging aid, it's released with the ring.
+ */
+int io_register_op_stats(struct io_ring_ctx *ctx, void __user *arg,
+			 unsigned int nr_args)
+{
+	struct io_op_stats __percpu *stats;
+
+	if (arg || nr_args)
+		return -EINVAL;
+	if (ctx->op_stats)
+		return -EBUSY;
+
+	stats = __alloc_percpu(sizeof(struct io_op_stats) * IORING_OP_LAST,
+			       __alignof__(struct io_op_stats));
+	if (!stats)
+		return -ENOMEM;
+	smp_store_release(&ctx->op_stats, stats);
+	return 0;
+}
+
+void io_op_stats_free(struct io_ring_ctx *ctx)
+{
+	free_percpu(ctx->op_stats);
+	ctx->op_stats = NULL;
+}
+
+#ifdef CONFIG_PROC_FS
+static void io_op_stats_show_hist(struct seq_file *m, const char *name,
+				  const u64 *hist)
+{
+	int i;
+
+	seq_printf(m, " %s=", name);
+	for (i = 0; i < IO_OP_STATS_BUCKETS; i++)
+		seq_printf(m, "%s%llu", i ? "," : "", hist[i]);
+}
+
+void io_op_stats_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
+{
+	struct io_op_stats __percpu *stats = READ_ONCE(ctx->op_stats);
+	struct io_op_stats sum;
+	int op, cpu, i;
+
+	if (!stats)
+		return;
+
+	seq_puts(m, "OpStats:\n");
+	for (op = 0; op < IORING_OP_LAST; op++) {
+		u64 total = 0;
+
+		memset(&sum, 0, sizeof(sum));
+		for_each_possible_cpu(cpu) {
+			struct io_op_stats *s = per_cpu_ptr(&stats[op], cpu);
+
+			sum.punts += s->punts;
+			for (i = 0; i < IO_OP_STATS_BUCKETS; i++) {
+				sum.queue[i] += s->queue[i];
+				sum.exec[i] += s->exec[i];
+				total += s->queue[i] + s->exec[i];
+			}
+		}
+		if (!total && !sum.punts)
+			continue;
+
+		seq_printf(m, "  %s: punts=%llu", io_uring_get_opcode(op),
+			   sum.punts);
+		io_op_stats_show_hist(m, "queue_us", sum.queue);
+		io_op_stats_show_hist(m, "exec_us", sum.exec);
+		seq_putc(m, '\n');
+	}
+}
+#endif
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0
+#ifndef IOU_OPSTATS_H
+#define IOU_OPSTATS_H
+
+#include <linux/timekeeping.h>
+#include <linux/io_uring_types.h>
+
+/* log2 usec buckets, the last one collects everything from ~16ms up */
+#define IO_OP_STATS_BUCKETS	16
+
+struct io_op_stats {
+	u64	punts;
+	/* submission to (last) issue */
+	u64	queue[IO_OP_STATS_BUCKETS];
+	/* last issue to completion */
+	u64	exec[IO_OP_STATS_BUCKETS];
+};
+
+int io_register_op_stats(struct io_ring_ctx *ctx, void __user *arg,
+			 unsigned int nr_args);
+void io_op_stats_free(struct io_ring_ctx *ctx);
+void io_op_stats_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m);
+
+void __io_op_stats_issue(struct io_kiocb *req);
+void __io_op_stats_complete(struct io_kiocb *req);
+void __io_op_stats_punt(struct io_kiocb *req);
+
+/*
+ * req->stat_ts holds a ~usec timestamp (ns >> 10) with the low bit used as
+ * a marker: odd means submitted but not yet issued, even and non-zero means
+ * issued. Zero means stats aren't tracked for this request.
+ */
+static inline u32 io_op_stats_now(void)
+{
+	return (u32)(ktime_get_ns() >> 10);
+}
+
+static inline void io_op_stats_submit(struct io_kiocb *req)
+{
+	if (likely(!READ_ONCE(req->ctx->op_stats)))
+		req->stat_ts = 0;
+	else
+		req->stat_ts = io_op_stats_now() | 1;
+}
+
+static inline void io_op_stats_issue(struct io_kiocb *req)
+{
+	if (unlikely(req->stat_ts))
+		__io_op_stats_issue(req);
+}
+
+static inline void io_op_stats_complete(struct io_kiocb *req)
+{
+	if (unlikely(req->stat_ts))
+		__io_op_stats_complete(req);
+}
+
+static inline void io_op_stats_punt(struct io_kiocb *req)
+{
+	if (unlikely(req->stat_ts))
+		__io_op_stats_punt(req);
+}
+
+#endif
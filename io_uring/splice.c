@@ -8,6 +8,10 @@
 #include <linux/namei.h>
 #include <linux/io_uring.h>
 #include <linux/splice.h>
+#include <linux/pagemap.h>
+#include <linux/fsnotify.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/sched/xacct.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -76,6 +80,124 @@ int io_tee(struct io_kiocb *req, unsigned int issue_flags)
 	return IOU_OK;
 }
 
+/*
+ * Like sendfile(2): sqe->fd is the destination, splice_fd_in the source file
+ * and sqe->off the source offset, or -1 to use and update its file position.
+ */
+int io_sendfile_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_splice *sp = io_kiocb_to_cmd(req, struct io_splice);
+
+	if (READ_ONCE(sqe->splice_off_in))
+		return -EINVAL;
+	sp->off_in = READ_ONCE(sqe->off);
+	sp->off_out = 0;
+	return __io_splice_prep(req, sqe);
+}
+
+/*
+ * The splice loop reads at most a pipe's worth at a time, which also caps the
+ * readahead request size at that. Tell readahead about the whole range up
+ * front instead, so the filesystem's ->readahead() (iomap_readahead() for
+ * most) sees large sequential requests.
+ */
+static void io_sendfile_readahead(struct file *in, loff_t pos, size_t len)
+{
+	struct address_space *mapping = in->f_mapping;
+	pgoff_t index = pos >> PAGE_SHIFT;
+	unsigned long nr;
+
+	if (!S_ISREG(file_inode(in)->i_mode) || (in->f_mode & FMODE_RANDOM))
+		return;
+	if (!mapping->a_ops->readahead)
+		return;
+
+	/* fits in one pipe, the splice read does the same readahead itself */
+	nr = ((pos + len - 1) >> PAGE_SHIFT) - index + 1;
+	if (nr <= PIPE_DEF_BUFFERS)
+		return;
+	page_cache_sync_readahead(mapping, &in->f_ra, in, index, nr);
+}
+
+/*
+ * Stream a file range to another file, usually a socket, straight from the
+ * page cache. This uses the per-task internal pipe of do_splice_direct(),
+ * so the application neither allocates pipes nor links two SPLICE requests.
+ */
+int io_sendfile(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_splice *sp = io_kiocb_to_cmd(req, struct io_splice);
+	struct file *out = sp->file_out;
+	loff_t pos, out_pos, max;
+	size_t len = sp->len;
+	struct file *in;
+	ssize_t ret;
+
+	WARN_ON_ONCE(issue_flags & IO_URING_F_NONBLOCK);
+
+	if (sp->flags & SPLICE_F_FD_IN_FIXED)
+		in = io_file_get_fixed(req, sp->splice_fd_in, issue_flags);
+	else
+		in = io_file_get_normal(req, sp->splice_fd_in);
+	if (!in) {
+		ret = -EBADF;
+		goto done;
+	}
+
+	ret = -EBADF;
+	if (!(in->f_mode & FMODE_READ) || !(out->f_mode & FMODE_WRITE))
+		goto out_put;
+	ret = -ESPIPE;
+	if (sp->off_in == -1) {
+		pos = in->f_pos;
+	} else {
+		pos = sp->off_in;
+		if (!(in->f_mode & FMODE_PREAD))
+			goto out_put;
+	}
+	ret = rw_verify_area(READ, in, &pos, len);
+	if (ret < 0)
+		goto out_put;
+	len = min_t(size_t, len, MAX_RW_COUNT);
+
+	max = min(file_inode(in)->i_sb->s_maxbytes,
+		  file_inode(out)->i_sb->s_maxbytes);
+	if (unlikely(pos + len > max)) {
+		ret = -EOVERFLOW;
+		if (pos >= max)
+			goto out_put;
+		len = max - pos;
+	}
+
+	out_pos = out->f_pos;
+	ret = rw_verify_area(WRITE, out, &out_pos, len);
+	if (ret < 0)
+		goto out_put;
+
+	ret = 0;
+	if (len) {
+		io_sendfile_readahead(in, pos, len);
+		ret = do_splice_direct(in, &pos, out, &out_pos, len, 0);
+	}
+	if (ret > 0) {
+		add_rchar(current, ret);
+		add_wchar(current, ret);
+		fsnotify_access(in);
+		fsnotify_modify(out);
+		out->f_pos = out_pos;
+		if (sp->off_in == -1)
+			in->f_pos = pos;
+	}
+out_put:
+	if (!(sp->flags & SPLICE_F_FD_IN_FIXED))
+		fput(in);
+done:
+	if (ret != sp->len)
+		req_set_fail(req);
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
+
 int io_splice_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_splice *sp = io_kiocb_to_cmd(req, struct io_splice);
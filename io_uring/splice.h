@@ -5,3 +5,6 @@ int io_tee(struct io_kiocb *req, unsigned int issue_flags);
 
 int io_splice_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_splice(struct io_kiocb *req, unsigned int issue_flags);
+
+int io_sendfile_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
+int io_sendfile(struct io_kiocb *req, unsigned int issue_flags);
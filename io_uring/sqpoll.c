@@ -19,6 +19,7 @@
 #include "sqpoll.h"
 
 #define IORING_SQPOLL_CAP_ENTRIES_VALUE 8
+#define IORING_SQPOLL_MAX_WEIGHT	64
 #define IORING_TW_CAP_ENTRIES_VALUE	8
 
 enum {
@@ -166,6 +167,31 @@ static inline bool io_sqd_events_pending(struct io_sq_data *sqd)
 	return READ_ONCE(sqd->state);
 }
 
+/*
+ * Deficit round-robin across the rings sharing an SQPOLL thread. Every pass
+ * credits a ring with a quantum proportional to its weight, and it may submit
+ * up to its accumulated credit. Unused credit is carried over for a ring that
+ * still has entries pending, but bounded to two quanta so that a ring that
+ * was throttled can't burst past its share once it catches up.
+ */
+static unsigned int io_sq_budget(struct io_ring_ctx *ctx,
+				 unsigned int to_submit)
+{
+	unsigned int quantum = ctx->sq_weight * IORING_SQPOLL_CAP_ENTRIES_VALUE;
+
+	if (!to_submit) {
+		ctx->sq_deficit = 0;
+		return 0;
+	}
+
+	ctx->sq_deficit = min(ctx->sq_deficit + quantum, 2 * quantum);
+	if (to_submit > ctx->sq_deficit) {
+		ctx->sq_backoffs++;
+		to_submit = ctx->sq_deficit;
+	}
+	return to_submit;
+}
+
 static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 {
 	unsigned int to_submit;
@@ -173,8 +199,8 @@ static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 
 	to_submit = io_sqring_entries(ctx);
 	/* if we're handling multiple rings, cap submit size for fairness */
-	if (cap_entries && to_submit > IORING_SQPOLL_CAP_ENTRIES_VALUE)
-		to_submit = IORING_SQPOLL_CAP_ENTRIES_VALUE;
+	if (cap_entries)
+		to_submit = io_sq_budget(ctx, to_submit);
 
 	if (!wq_list_empty(&ctx->iopoll_list) || to_submit) {
 		const struct cred *creds = NULL;
@@ -195,6 +221,14 @@ static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 			ret = io_submit_sqes(ctx, to_submit);
 		mutex_unlock(&ctx->uring_lock);
 
+		if (ret > 0) {
+			if (cap_entries)
+				ctx->sq_deficit -= min_t(unsigned int, ret,
+							 ctx->sq_deficit);
+			ctx->sq_submitted += ret;
+			ctx->sq_last_active = jiffies;
+		}
+
 		if (io_napi(ctx))
 			ret += io_napi_sqpoll_busy_poll(ctx);
 
@@ -362,6 +396,8 @@ static int io_sq_thread(void *data)
 			}
 
 			if (needs_sched) {
+				list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+					ctx->sq_sleeps++;
 				mutex_unlock(&sqd->lock);
 				schedule();
 				mutex_lock(&sqd->lock);
@@ -431,6 +467,9 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 		struct io_sq_data *sqd;
 		bool attached;
 
+		if (p->sq_thread_weight > IORING_SQPOLL_MAX_WEIGHT)
+			return -EINVAL;
+
 		ret = security_uring_sqpoll();
 		if (ret)
 			return ret;
@@ -446,6 +485,8 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 		ctx->sq_thread_idle = msecs_to_jiffies(p->sq_thread_idle);
 		if (!ctx->sq_thread_idle)
 			ctx->sq_thread_idle = HZ;
+		ctx->sq_weight = p->sq_thread_weight ?: 1;
+		ctx->sq_last_active = jiffies;
 
 		io_sq_thread_park(sqd);
 		list_add(&ctx->sqd_list, &sqd->ctx_list);
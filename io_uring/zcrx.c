@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/mm.h>
+#include <linux/highmem.h>
+#include <linux/io_uring.h>
+#include <linux/nospec.h>
+#include <linux/skbuff.h>
+#include <linux/vmalloc.h>
+
+#include <net/rps.h>
+#include <net/sock.h>
+#include <net/tcp.h>
+
+#include <uapi/linux/io_uring.h>
+
+#include "io_uring.h"
+#include "memmap.h"
+#include "rsrc.h"
+#include "zcrx.h"
+
+#define IO_RQ_MAX_ENTRIES		32768
+
+/* bounds the time a multishot request holds the socket lock */
+#define IO_SKBS_PER_CALL_LIMIT		20
+
+struct io_zcrx_args {
+	struct io_kiocb		*req;
+	struct io_zcrx_ifq	*ifq;
+	unsigned int		nr_skbs;
+};
+
+static int io_allocate_rbuf_ring(struct io_zcrx_ifq *ifq,
+				 struct io_uring_zcrx_ifq_reg *reg)
+{
+	size_t off, size;
+	void *ptr;
+
+	off = ALIGN(sizeof(struct io_uring), L1_CACHE_BYTES);
+	size = off + sizeof(struct io_uring_zcrx_rqe) * reg->rq_entries;
+
+	ptr = __io_uaddr_map(&ifq->rq_pages, &ifq->nr_rq_pages,
+			     reg->rq_addr, size);
+	if (IS_ERR(ptr))
+		return PTR_ERR(ptr);
+
+	ifq->rq_ring = ptr;
+	ifq->rqes = ptr + off;
+	ifq->rq_entries = reg->rq_entries;
+
+	reg->offsets.head = offsetof(struct io_uring, head);
+	reg->offsets.tail = offsetof(struct io_uring, tail);
+	reg->offsets.rqes = off;
+	return 0;
+}
+
+static void io_free_rbuf_ring(struct io_zcrx_ifq *ifq)
+{
+	if (!ifq->rq_ring)
+		return;
+	io_pages_free(&ifq->rq_pages, ifq->nr_rq_pages);
+	ifq->nr_rq_pages = 0;
+	vunmap(ifq->rq_ring);
+	ifq->rq_ring = NULL;
+}
+
+static void io_zcrx_free_area(struct io_zcrx_area *area)
+{
+	struct io_ring_ctx *ctx = area->ifq->ctx;
+
+	if (area->pages) {
+		if (ctx->user)
+			__io_unaccount_mem(ctx->user, area->nr_pages);
+		io_pages_free(&area->pages, area->nr_pages);
+	}
+	bitmap_free(area->user_owned);
+	kvfree(area->freelist);
+	kfree(area);
+}
+
+static int io_zcrx_create_area(struct io_zcrx_ifq *ifq,
+			       struct io_uring_zcrx_area_reg *reg)
+{
+	struct io_ring_ctx *ctx = ifq->ctx;
+	struct io_zcrx_area *area;
+	int i, ret, nr_pages;
+
+	if (reg->flags || reg->__resv1 ||
+	    memchr_inv(reg->__resv2, 0, sizeof(reg->__resv2)))
+		return -EINVAL;
+	if (!reg->addr || !reg->len ||
+	    !PAGE_ALIGNED(reg->addr) || !PAGE_ALIGNED(reg->len))
+		return -EINVAL;
+	if (reg->len >> PAGE_SHIFT > INT_MAX)
+		return -EINVAL;
+
+	area = kzalloc(sizeof(*area), GFP_KERNEL);
+	if (!area)
+		return -ENOMEM;
+	area->ifq = ifq;
+
+	area->pages = io_pin_pages(reg->addr, reg->len, &nr_pages);
+	if (IS_ERR(area->pages)) {
+		ret = PTR_ERR(area->pages);
+		area->pages = NULL;
+		goto err;
+	}
+	area->nr_pages = nr_pages;
+
+	if (ctx->user) {
+		ret = __io_account_mem(ctx->user, nr_pages);
+		if (ret) {
+			io_pages_free(&area->pages, nr_pages);
+			goto err;
+		}
+	}
+
+	ret = -ENOMEM;
+	area->freelist = kvmalloc_array(nr_pages, sizeof(area->freelist[0]),
+					GFP_KERNEL);
+	area->user_owned = bitmap_zalloc(nr_pages, GFP_KERNEL);
+	if (!area->freelist || !area->user_owned)
+		goto err;
+
+	/* hand out low offsets first */
+	for (i = 0; i < nr_pages; i++)
+		area->freelist[i] = nr_pages - i - 1;
+	area->free_count = nr_pages;
+
+	ifq->area = area;
+	return 0;
+err:
+	io_zcrx_free_area(area);
+	return ret;
+}
+
+static void io_zcrx_ifq_free(struct io_zcrx_ifq *ifq)
+{
+	if (ifq->area)
+		io_zcrx_free_area(ifq->area);
+	io_free_rbuf_ring(ifq);
+	kfree(ifq);
+}
+
+int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
+			  struct io_uring_zcrx_ifq_reg __user *arg)
+{
+	struct io_uring_zcrx_area_reg area;
+	struct io_uring_zcrx_ifq_reg reg;
+	struct io_zcrx_ifq *ifq;
+	int ret;
+
+	/* completions carry the payload offset in the second half */
+	if (!(ctx->flags & IORING_SETUP_CQE32))
+		return -EINVAL;
+	if (ctx->ifq)
+		return -EBUSY;
+	if (copy_from_user(&reg, arg, sizeof(reg)))
+		return -EFAULT;
+	if (copy_from_user(&area, u64_to_user_ptr(reg.area_ptr), sizeof(area)))
+		return -EFAULT;
+	if (reg.flags || memchr_inv(reg.__resv, 0, sizeof(reg.__resv)) ||
+	    memchr_inv(&reg.offsets, 0, sizeof(reg.offsets)))
+		return -EINVAL;
+	if (!reg.rq_entries || reg.rq_entries > IO_RQ_MAX_ENTRIES)
+		return -EINVAL;
+	reg.rq_entries = roundup_pow_of_two(reg.rq_entries);
+
+	ifq = kzalloc(sizeof(*ifq), GFP_KERNEL);
+	if (!ifq)
+		return -ENOMEM;
+	ifq->ctx = ctx;
+	spin_lock_init(&ifq->lock);
+
+	ret = io_allocate_rbuf_ring(ifq, &reg);
+	if (ret)
+		goto err;
+
+	ret = io_zcrx_create_area(ifq, &area);
+	if (ret)
+		goto err;
+
+	if (copy_to_user(arg, &reg, sizeof(reg))) {
+		ret = -EFAULT;
+		goto err;
+	}
+	ctx->ifq = ifq;
+	return 0;
+err:
+	io_zcrx_ifq_free(ifq);
+	return ret;
+}
+
+void io_unregister_zcrx_ifqs(struct io_ring_ctx *ctx)
+{
+	struct io_zcrx_ifq *ifq = ctx->ifq;
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	if (!ifq)
+		return;
+	ctx->ifq = NULL;
+	io_zcrx_ifq_free(ifq);
+}
+
+/*
+ * Take back the buffers userspace has returned in the refill queue. Only
+ * pages currently owned by userspace are accepted, so a bogus or repeated
+ * entry can't put a page on the freelist twice.
+ */
+static void io_zcrx_ring_refill(struct io_zcrx_ifq *ifq)
+{
+	struct io_zcrx_area *area = ifq->area;
+	unsigned int mask = ifq->rq_entries - 1;
+	unsigned int entries;
+
+	lockdep_assert_held(&ifq->lock);
+
+	/* pairs with the release store of the tail by userspace */
+	entries = smp_load_acquire(&ifq->rq_ring->tail) - ifq->cached_rq_head;
+	entries = min(entries, ifq->rq_entries);
+
+	for (; entries; entries--) {
+		struct io_uring_zcrx_rqe *rqe;
+		u64 idx;
+
+		rqe = &ifq->rqes[ifq->cached_rq_head++ & mask];
+		idx = READ_ONCE(rqe->off) >> PAGE_SHIFT;
+		if (unlikely(idx >= area->nr_pages))
+			continue;
+		idx = array_index_nospec(idx, area->nr_pages);
+		if (unlikely(!__test_and_clear_bit(idx, area->user_owned)))
+			continue;
+		area->freelist[area->free_count++] = idx;
+	}
+
+	smp_store_release(&ifq->rq_ring->head, ifq->cached_rq_head);
+}
+
+static int io_zcrx_get_page(struct io_zcrx_ifq *ifq)
+{
+	struct io_zcrx_area *area = ifq->area;
+	int idx = -1;
+
+	spin_lock(&ifq->lock);
+	if (!area->free_count)
+		io_zcrx_ring_refill(ifq);
+	if (area->free_count) {
+		idx = area->freelist[--area->free_count];
+		__set_bit(idx, area->user_owned);
+	}
+	spin_unlock(&ifq->lock);
+	return idx;
+}
+
+static void io_zcrx_put_page(struct io_zcrx_ifq *ifq, int idx)
+{
+	struct io_zcrx_area *area = ifq->area;
+
+	spin_lock(&ifq->lock);
+	__clear_bit(idx, area->user_owned);
+	area->freelist[area->free_count++] = idx;
+	spin_unlock(&ifq->lock);
+}
+
+/*
+ * Place up to a page worth of payload into a free page of the area and
+ * post a CQE pointing at it.
+ */
+static ssize_t io_zcrx_copy_chunk(struct io_kiocb *req,
+				  struct io_zcrx_ifq *ifq,
+				  const struct sk_buff *skb,
+				  unsigned int offset, size_t len)
+{
+	size_t n = min_t(size_t, len, PAGE_SIZE);
+	void *vaddr;
+	int idx, ret;
+
+	idx = io_zcrx_get_page(ifq);
+	if (idx < 0)
+		return -ENOBUFS;
+
+	vaddr = kmap_local_page(ifq->area->pages[idx]);
+	ret = skb_copy_bits(skb, offset, vaddr, n);
+	kunmap_local(vaddr);
+
+	if (unlikely(ret)) {
+		io_zcrx_put_page(ifq, idx);
+		return ret;
+	}
+	if (!io_req_post_cqe32(req, n, IORING_CQE_F_MORE,
+			       (u64)idx << PAGE_SHIFT, 0)) {
+		io_zcrx_put_page(ifq, idx);
+		return -ENOSPC;
+	}
+	return n;
+}
+
+static int io_zcrx_recv_skb(read_descriptor_t *desc, struct sk_buff *skb,
+			    unsigned int offset, size_t len)
+{
+	struct io_zcrx_args *args = desc->arg.data;
+	size_t copied = 0;
+	ssize_t ret = 0;
+
+	len = min_t(size_t, len, desc->count);
+	args->nr_skbs++;
+
+	while (len) {
+		ret = io_zcrx_copy_chunk(args->req, args->ifq, skb, offset, len);
+		if (ret <= 0)
+			break;
+		offset += ret;
+		len -= ret;
+		copied += ret;
+	}
+
+	if (!copied)
+		return ret;
+	desc->count -= copied;
+	return copied;
+}
+
+static int io_zcrx_tcp_recvmsg(struct io_kiocb *req, struct io_zcrx_ifq *ifq,
+			       struct sock *sk, unsigned int flags,
+			       unsigned int issue_flags, unsigned int *outlen)
+{
+	unsigned int len = *outlen;
+	struct io_zcrx_args args = {
+		.req = req,
+		.ifq = ifq,
+	};
+	read_descriptor_t rd_desc = {
+		.count = len ? len : UINT_MAX,
+		.arg.data = &args,
+	};
+	int ret;
+
+	lock_sock(sk);
+	ret = tcp_read_sock(sk, &rd_desc, io_zcrx_recv_skb);
+	if (len && ret > 0)
+		*outlen = len - ret;
+	if (ret <= 0) {
+		if (ret < 0 || sock_flag(sk, SOCK_DONE))
+			goto out;
+		if (sk->sk_err)
+			ret = sock_error(sk);
+		else if (sk->sk_shutdown & RCV_SHUTDOWN)
+			goto out;
+		else if (sk->sk_state == TCP_CLOSE)
+			ret = -ENOTCONN;
+		else
+			ret = -EAGAIN;
+	} else if (unlikely(args.nr_skbs > IO_SKBS_PER_CALL_LIMIT) &&
+		   (issue_flags & IO_URING_F_MULTISHOT)) {
+		ret = IOU_REQUEUE;
+	} else if (sock_flag(sk, SOCK_DONE)) {
+		/* keep going until the read returns 0 */
+		if (issue_flags & IO_URING_F_MULTISHOT)
+			ret = IOU_REQUEUE;
+		else
+			ret = -EAGAIN;
+	}
+out:
+	release_sock(sk);
+	return ret;
+}
+
+int io_zcrx_recv(struct io_kiocb *req, struct io_zcrx_ifq *ifq,
+		 struct socket *sock, unsigned int flags,
+		 unsigned int issue_flags, unsigned int *len)
+{
+	struct sock *sk = sock->sk;
+	const struct proto *prot = READ_ONCE(sk->sk_prot);
+
+	if (prot->recvmsg != tcp_recvmsg)
+		return -EPROTONOSUPPORT;
+
+	sock_rps_record_flow(sk);
+	return io_zcrx_tcp_recvmsg(req, ifq, sk, flags, issue_flags, len);
+}
@@ -45,6 +45,7 @@
 #include <linux/cgroup.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
+#include <trace/events/cgroup.h>
 
 DEFINE_STATIC_KEY_FALSE(cpusets_pre_enable_key);
 DEFINE_STATIC_KEY_FALSE(cpusets_enabled_key);
@@ -1183,6 +1184,95 @@ partition_and_rebuild_sched_domains(int ndoms_new, cpumask_var_t doms_new[],
 	mutex_unlock(&sched_domains_mutex);
 }
 
+/*
+ * A copy of the sched domains last handed to the scheduler. Partition
+ * changes which leave the set of domains as it was, e.g. moving a CPU
+ * between two member cpusets of the same partition, then don't go through
+ * partition_sched_domains() and a rebuild of the deadline accounting of
+ * every root domain. applied_ndoms < 0 means the set is unknown.
+ *
+ * While sd_rebuild_deferred is set (see cpuset.cpus.batch), write paths
+ * only record that a rebuild is needed in sd_rebuild_pending and the
+ * rebuild is done once when the batch is committed.
+ *
+ * All protected by cpuset_mutex.
+ */
+static cpumask_var_t *applied_doms;
+static struct sched_domain_attr *applied_attr;
+static int applied_ndoms = -1;
+static bool sd_rebuild_deferred;
+static bool sd_rebuild_pending;
+
+/* Same as dattrs_equal() of the scheduler */
+static bool cpuset_dattrs_equal(struct sched_domain_attr *cur, int idx_cur,
+				struct sched_domain_attr *new, int idx_new)
+{
+	struct sched_domain_attr tmp;
+
+	if (!new && !cur)
+		return true;
+
+	tmp = SD_ATTR_INIT;
+
+	return !memcmp(cur ? (cur + idx_cur) : &tmp,
+		       new ? (new + idx_new) : &tmp,
+		       sizeof(struct sched_domain_attr));
+}
+
+static bool sched_domains_applied(int ndoms, cpumask_var_t doms[],
+				  struct sched_domain_attr *attr)
+{
+	int i, j;
+
+	if (!doms || ndoms != applied_ndoms)
+		return false;
+
+	/* generate_sched_domains() doesn't keep the order of the domains */
+	for (i = 0; i < ndoms; i++) {
+		for (j = 0; j < applied_ndoms; j++) {
+			if (cpumask_equal(doms[i], applied_doms[j]) &&
+			    cpuset_dattrs_equal(applied_attr, j, attr, i))
+				break;
+		}
+		if (j == applied_ndoms)
+			return false;
+	}
+	return true;
+}
+
+static void record_applied_sched_domains(int ndoms, cpumask_var_t doms[],
+					 struct sched_domain_attr *attr)
+{
+	int i;
+
+	if (applied_doms)
+		free_sched_domains(applied_doms, applied_ndoms);
+	kfree(applied_attr);
+	applied_doms = NULL;
+	applied_attr = NULL;
+	applied_ndoms = -1;
+
+	/* the scheduler picks the housekeeping CPUs for a NULL @doms */
+	if (!doms)
+		return;
+
+	applied_doms = alloc_sched_domains(ndoms);
+	if (!applied_doms)
+		return;
+	for (i = 0; i < ndoms; i++)
+		cpumask_copy(applied_doms[i], doms[i]);
+
+	if (attr) {
+		applied_attr = kmemdup(attr, ndoms * sizeof(*attr), GFP_KERNEL);
+		if (!applied_attr) {
+			free_sched_domains(applied_doms, ndoms);
+			applied_doms = NULL;
+			return;
+		}
+	}
+	applied_ndoms = ndoms;
+}
+
 /*
  * Rebuild scheduler domains.
  *
@@ -1192,19 +1282,30 @@ partition_and_rebuild_sched_domains(int ndoms_new, cpumask_var_t doms_new[],
  * 'cpus' is removed, then call this routine to rebuild the
  * scheduler's dynamic sched domains.
  *
+ * Unless @force is set, the rebuild is postponed while a batch is open and
+ * skipped if the resulting domains are the ones the scheduler already has.
+ *
  * Call with cpuset_mutex held.  Takes cpus_read_lock().
  */
-static void rebuild_sched_domains_locked(void)
+static void __rebuild_sched_domains_locked(bool force)
 {
 	struct cgroup_subsys_state *pos_css;
 	struct sched_domain_attr *attr;
 	cpumask_var_t *doms;
 	struct cpuset *cs;
+	u64 start, gen_ns;
+	bool changed;
 	int ndoms;
 
 	lockdep_assert_cpus_held();
 	lockdep_assert_held(&cpuset_mutex);
 
+	if (!force && sd_rebuild_deferred) {
+		sd_rebuild_pending = true;
+		return;
+	}
+	sd_rebuild_pending = false;
+
 	/*
 	 * If we have raced with CPU hotplug, return early to avoid
 	 * passing doms with offlined cpu to partition_sched_domains().
@@ -1240,21 +1341,96 @@ static void rebuild_sched_domains_locked(void)
 	}
 
 	/* Generate domain masks and attrs */
+	start = ktime_get_ns();
 	ndoms = generate_sched_domains(&doms, &attr);
+	gen_ns = ktime_get_ns() - start;
 
-	/* Have scheduler rebuild the domains */
-	partition_and_rebuild_sched_domains(ndoms, doms, attr);
+	changed = force || !sched_domains_applied(ndoms, doms, attr);
+	if (changed) {
+		record_applied_sched_domains(ndoms, doms, attr);
+		/* Have scheduler rebuild the domains */
+		partition_and_rebuild_sched_domains(ndoms, doms, attr);
+	} else {
+		free_sched_domains(doms, ndoms);
+		kfree(attr);
+	}
+
+	trace_cpuset_rebuild_sched_domains(ndoms, changed, gen_ns,
+					   ktime_get_ns() - start - gen_ns);
+}
+
+static void rebuild_sched_domains_locked(void)
+{
+	__rebuild_sched_domains_locked(false);
+}
+
+static void sd_batch_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(sd_batch_work, sd_batch_fn);
+
+/*
+ * Writing 1 to cpuset.cpus.batch opens a batch, writing 0 commits it with a
+ * single sched domain rebuild. A batch left open is committed after
+ * SD_BATCH_TIMEOUT, so that a crashed manager can't keep the domains stale.
+ */
+#define SD_BATCH_TIMEOUT	HZ
+
+static void sd_batch_commit(void)
+{
+	lockdep_assert_held(&cpuset_mutex);
+
+	sd_rebuild_deferred = false;
+	if (sd_rebuild_pending)
+		rebuild_sched_domains_locked();
+}
+
+static void sd_batch_set(bool open)
+{
+	if (open) {
+		sd_rebuild_deferred = true;
+		mod_delayed_work(system_unbound_wq, &sd_batch_work,
+				 SD_BATCH_TIMEOUT);
+	} else {
+		cancel_delayed_work(&sd_batch_work);
+		sd_batch_commit();
+	}
+}
+
+static void sd_batch_fn(struct work_struct *work)
+{
+	cpus_read_lock();
+	mutex_lock(&cpuset_mutex);
+	if (sd_rebuild_deferred) {
+		pr_warn_once("cpuset: committing sched domain batch left open\n");
+		sd_batch_commit();
+	}
+	mutex_unlock(&cpuset_mutex);
+	cpus_read_unlock();
 }
 #else /* !CONFIG_SMP */
+static void __rebuild_sched_domains_locked(bool force)
+{
+}
+
 static void rebuild_sched_domains_locked(void)
 {
 }
+
+static bool sd_rebuild_deferred;
+
+static void sd_batch_set(bool open)
+{
+	sd_rebuild_deferred = open;
+}
 #endif /* CONFIG_SMP */
 
+/*
+ * Used by CPU hotplug and the scheduler, which may have changed the sched
+ * domains behind our back: always rebuild.
+ */
 static void rebuild_sched_domains_cpuslocked(void)
 {
 	mutex_lock(&cpuset_mutex);
-	rebuild_sched_domains_locked();
+	__rebuild_sched_domains_locked(true);
 	mutex_unlock(&cpuset_mutex);
 }
 
@@ -3492,6 +3668,7 @@ typedef enum {
 	FILE_MEMORY_PRESSURE,
 	FILE_SPREAD_PAGE,
 	FILE_SPREAD_SLAB,
+	FILE_SCHED_DOMAIN_BATCH,
 } cpuset_filetype_t;
 
 static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
@@ -3533,6 +3710,12 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_SPREAD_SLAB:
 		retval = update_flag(CS_SPREAD_SLAB, cs, val);
 		break;
+	case FILE_SCHED_DOMAIN_BATCH:
+		if (val > 1)
+			retval = -EINVAL;
+		else
+			sd_batch_set(val);
+		break;
 	default:
 		retval = -EINVAL;
 		break;
@@ -3711,6 +3894,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_spread_page(cs);
 	case FILE_SPREAD_SLAB:
 		return is_spread_slab(cs);
+	case FILE_SCHED_DOMAIN_BATCH:
+		return sd_rebuild_deferred;
 	default:
 		BUG();
 	}
@@ -3978,6 +4163,14 @@ static struct cftype dfl_files[] = {
 		.flags = CFTYPE_ONLY_ON_ROOT,
 	},
 
+	{
+		.name = "cpus.batch",
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_SCHED_DOMAIN_BATCH,
+		.flags = CFTYPE_ONLY_ON_ROOT,
+	},
+
 	{ }	/* terminate */
 };
 
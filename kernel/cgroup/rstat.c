@@ -1,16 +1,36 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "cgroup-internal.h"
 
+#include <linux/sched/clock.h>
 #include <linux/sched/cputime.h>
 
 #include <linux/bpf.h>
 #include <linux/btf.h>
 #include <linux/btf_ids.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/cgroup.h>
 
-static DEFINE_SPINLOCK(cgroup_rstat_lock);
-static DEFINE_PER_CPU(raw_spinlock_t, cgroup_rstat_cpu_lock);
+/*
+ * There is an updated tree, with its own locks, for each subsystem with
+ * ->css_rstat_flush() and one for cgroup::self, the last index.
+ */
+#define CSS_RSTAT_NR_TREES	(CGROUP_SUBSYS_COUNT + 1)
+
+static spinlock_t css_rstat_lock[CSS_RSTAT_NR_TREES];
+static DEFINE_PER_CPU(raw_spinlock_t, css_rstat_cpu_lock[CSS_RSTAT_NR_TREES]);
+
+/* flush statistics of each tree, protected by its css_rstat_lock */
+struct css_rstat_flush_stat {
+	u64	flushes;
+	u64	contended;
+	u64	wait_ns;	/* for css_rstat_lock when contended */
+	u64	flush_ns;
+	u64	max_flush_ns;
+};
+
+static struct css_rstat_flush_stat css_rstat_flush_stat[CSS_RSTAT_NR_TREES];
 
 static void cgroup_base_stat_flush(struct cgroup *cgrp, int cpu);
 
@@ -19,8 +39,19 @@ static struct cgroup_rstat_cpu *cgroup_rstat_cpu(struct cgroup *cgrp, int cpu)
 	return per_cpu_ptr(cgrp->rstat_cpu, cpu);
 }
 
+static struct css_rstat_cpu *css_rstat_cpu(struct cgroup_subsys_state *css,
+					   int cpu)
+{
+	return per_cpu_ptr(css->rstat_cpu, cpu);
+}
+
+static inline int css_rstat_tree(struct cgroup_subsys_state *css)
+{
+	return css->ss ? css->ss->id : CGROUP_SUBSYS_COUNT;
+}
+
 /*
- * Helper functions for rstat per CPU lock (cgroup_rstat_cpu_lock).
+ * Helper functions for rstat per CPU lock (css_rstat_cpu_lock).
  *
  * This makes it easier to diagnose locking issues and contention in
  * production environments. The parameter @fast_path determine the
@@ -35,7 +66,7 @@ unsigned long _cgroup_rstat_cpu_lock(raw_spinlock_t *cpu_lock, int cpu,
 	bool contended;
 
 	/*
-	 * The _irqsave() is needed because cgroup_rstat_lock is
+	 * The _irqsave() is needed because css_rstat_lock is
 	 * spinlock_t which is a sleeping lock on PREEMPT_RT. Acquiring
 	 * this lock with the _irq() suffix only disables interrupts on
 	 * a non-PREEMPT_RT kernel. The raw_spinlock_t below disables
@@ -74,17 +105,19 @@ void _cgroup_rstat_cpu_unlock(raw_spinlock_t *cpu_lock, int cpu,
 }
 
 /**
- * cgroup_rstat_updated - keep track of updated rstat_cpu
- * @cgrp: target cgroup
+ * css_rstat_updated - keep track of updated rstat_cpu
+ * @css: target css
  * @cpu: cpu on which rstat_cpu was updated
  *
- * @cgrp's rstat_cpu on @cpu was updated.  Put it on the parent's matching
- * rstat_cpu->updated_children list.  See the comment on top of
- * cgroup_rstat_cpu definition for details.
+ * @css's rstat_cpu on @cpu was updated.  Put it on the parent's matching
+ * rstat_cpu->updated_children list of its subsystem's updated tree.  See
+ * the comment on top of css_rstat_cpu definition for details.
  */
-__bpf_kfunc void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
+void css_rstat_updated(struct cgroup_subsys_state *css, int cpu)
 {
-	raw_spinlock_t *cpu_lock = per_cpu_ptr(&cgroup_rstat_cpu_lock, cpu);
+	int tree = css_rstat_tree(css);
+	raw_spinlock_t *cpu_lock = per_cpu_ptr(&css_rstat_cpu_lock[tree], cpu);
+	struct cgroup *cgrp = css->cgroup;
 	unsigned long flags;
 
 	/*
@@ -92,22 +125,22 @@ __bpf_kfunc void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
 	 * temporary inaccuracies, which is fine.
 	 *
 	 * Because @parent's updated_children is terminated with @parent
-	 * instead of NULL, we can tell whether @cgrp is on the list by
+	 * instead of NULL, we can tell whether @css is on the list by
 	 * testing the next pointer for NULL.
 	 */
-	if (data_race(cgroup_rstat_cpu(cgrp, cpu)->updated_next))
+	if (data_race(css_rstat_cpu(css, cpu)->updated_next))
 		return;
 
 	flags = _cgroup_rstat_cpu_lock(cpu_lock, cpu, cgrp, true);
 
-	/* put @cgrp and all ancestors on the corresponding updated lists */
+	/* put @css and all ancestors on the corresponding updated lists */
 	while (true) {
-		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
-		struct cgroup *parent = cgroup_parent(cgrp);
-		struct cgroup_rstat_cpu *prstatc;
+		struct css_rstat_cpu *rstatc = css_rstat_cpu(css, cpu);
+		struct cgroup_subsys_state *parent = css->parent;
+		struct css_rstat_cpu *prstatc;
 
 		/*
-		 * Both additions and removals are bottom-up.  If a cgroup
+		 * Both additions and removals are bottom-up.  If a css
 		 * is already in the tree, all ancestors are.
 		 */
 		if (rstatc->updated_next)
@@ -115,39 +148,50 @@ __bpf_kfunc void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
 
 		/* Root has no parent to link it to, but mark it busy */
 		if (!parent) {
-			rstatc->updated_next = cgrp;
+			rstatc->updated_next = css;
 			break;
 		}
 
-		prstatc = cgroup_rstat_cpu(parent, cpu);
+		prstatc = css_rstat_cpu(parent, cpu);
 		rstatc->updated_next = prstatc->updated_children;
-		prstatc->updated_children = cgrp;
+		prstatc->updated_children = css;
 
-		cgrp = parent;
+		css = parent;
 	}
 
 	_cgroup_rstat_cpu_unlock(cpu_lock, cpu, cgrp, flags, true);
 }
 
 /**
- * cgroup_rstat_push_children - push children cgroups into the given list
+ * cgroup_rstat_updated - keep track of updated basic and bpf stats
+ * @cgrp: target cgroup
+ * @cpu: cpu on which rstat_cpu was updated
+ */
+__bpf_kfunc void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
+{
+	css_rstat_updated(&cgrp->self, cpu);
+}
+
+/**
+ * css_rstat_push_children - push children csses into the given list
  * @head: current head of the list (= subtree root)
  * @child: first child of the root
  * @cpu: target cpu
- * Return: A new singly linked list of cgroups to be flush
+ * Return: A new singly linked list of csses to be flush
  *
- * Iteratively traverse down the cgroup_rstat_cpu updated tree level by
+ * Iteratively traverse down the css_rstat_cpu updated tree level by
  * level and push all the parents first before their next level children
  * into a singly linked list built from the tail backward like "pushing"
- * cgroups into a stack. The root is pushed by the caller.
+ * csses into a stack. The root is pushed by the caller.
  */
-static struct cgroup *cgroup_rstat_push_children(struct cgroup *head,
-						 struct cgroup *child, int cpu)
+static struct cgroup_subsys_state *
+css_rstat_push_children(struct cgroup_subsys_state *head,
+			struct cgroup_subsys_state *child, int cpu)
 {
-	struct cgroup *chead = child;	/* Head of child cgroup level */
-	struct cgroup *ghead = NULL;	/* Head of grandchild cgroup level */
-	struct cgroup *parent, *grandchild;
-	struct cgroup_rstat_cpu *crstatc;
+	struct cgroup_subsys_state *chead = child;	/* Head of child css level */
+	struct cgroup_subsys_state *ghead = NULL;	/* Head of grandchild css level */
+	struct cgroup_subsys_state *parent, *grandchild;
+	struct css_rstat_cpu *crstatc;
 
 	child->rstat_flush_next = NULL;
 
@@ -155,13 +199,13 @@ static struct cgroup *cgroup_rstat_push_children(struct cgroup *head,
 	while (chead) {
 		child = chead;
 		chead = child->rstat_flush_next;
-		parent = cgroup_parent(child);
+		parent = child->parent;
 
-		/* updated_next is parent cgroup terminated */
+		/* updated_next is parent css terminated */
 		while (child != parent) {
 			child->rstat_flush_next = head;
 			head = child;
-			crstatc = cgroup_rstat_cpu(child, cpu);
+			crstatc = css_rstat_cpu(child, cpu);
 			grandchild = crstatc->updated_children;
 			if (grandchild != child) {
 				/* Push the grand child to the next level */
@@ -183,31 +227,33 @@ static struct cgroup *cgroup_rstat_push_children(struct cgroup *head,
 }
 
 /**
- * cgroup_rstat_updated_list - return a list of updated cgroups to be flushed
- * @root: root of the cgroup subtree to traverse
+ * css_rstat_updated_list - return a list of updated csses to be flushed
+ * @root: root of the css subtree to traverse
  * @cpu: target cpu
- * Return: A singly linked list of cgroups to be flushed
+ * Return: A singly linked list of csses to be flushed
  *
  * Walks the updated rstat_cpu tree on @cpu from @root.  During traversal,
- * each returned cgroup is unlinked from the updated tree.
+ * each returned css is unlinked from the updated tree.
  *
  * The only ordering guarantee is that, for a parent and a child pair
  * covered by a given traversal, the child is before its parent in
  * the list.
  *
  * Note that updated_children is self terminated and points to a list of
- * child cgroups if not empty. Whereas updated_next is like a sibling link
- * within the children list and terminated by the parent cgroup. An exception
- * here is the cgroup root whose updated_next can be self terminated.
+ * child csses if not empty. Whereas updated_next is like a sibling link
+ * within the children list and terminated by the parent css. An exception
+ * here is the root css whose updated_next can be self terminated.
  */
-static struct cgroup *cgroup_rstat_updated_list(struct cgroup *root, int cpu)
+static struct cgroup_subsys_state *
+css_rstat_updated_list(struct cgroup_subsys_state *root, int cpu)
 {
-	raw_spinlock_t *cpu_lock = per_cpu_ptr(&cgroup_rstat_cpu_lock, cpu);
-	struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(root, cpu);
-	struct cgroup *head = NULL, *parent, *child;
+	raw_spinlock_t *cpu_lock =
+		per_cpu_ptr(&css_rstat_cpu_lock[css_rstat_tree(root)], cpu);
+	struct css_rstat_cpu *rstatc = css_rstat_cpu(root, cpu);
+	struct cgroup_subsys_state *head = NULL, *parent, *child;
 	unsigned long flags;
 
-	flags = _cgroup_rstat_cpu_lock(cpu_lock, cpu, root, false);
+	flags = _cgroup_rstat_cpu_lock(cpu_lock, cpu, root->cgroup, false);
 
 	/* Return NULL if this subtree is not on-list */
 	if (!rstatc->updated_next)
@@ -217,17 +263,17 @@ static struct cgroup *cgroup_rstat_updated_list(struct cgroup *root, int cpu)
 	 * Unlink @root from its parent. As the updated_children list is
 	 * singly linked, we have to walk it to find the removal point.
 	 */
-	parent = cgroup_parent(root);
+	parent = root->parent;
 	if (parent) {
-		struct cgroup_rstat_cpu *prstatc;
-		struct cgroup **nextp;
+		struct css_rstat_cpu *prstatc;
+		struct cgroup_subsys_state **nextp;
 
-		prstatc = cgroup_rstat_cpu(parent, cpu);
+		prstatc = css_rstat_cpu(parent, cpu);
 		nextp = &prstatc->updated_children;
 		while (*nextp != root) {
-			struct cgroup_rstat_cpu *nrstatc;
+			struct css_rstat_cpu *nrstatc;
 
-			nrstatc = cgroup_rstat_cpu(*nextp, cpu);
+			nrstatc = css_rstat_cpu(*nextp, cpu);
 			WARN_ON_ONCE(*nextp == parent);
 			nextp = &nrstatc->updated_next;
 		}
@@ -242,9 +288,9 @@ static struct cgroup *cgroup_rstat_updated_list(struct cgroup *root, int cpu)
 	child = rstatc->updated_children;
 	rstatc->updated_children = root;
 	if (child != root)
-		head = cgroup_rstat_push_children(head, child, cpu);
+		head = css_rstat_push_children(head, child, cpu);
 unlock_ret:
-	_cgroup_rstat_cpu_unlock(cpu_lock, cpu, root, flags, false);
+	_cgroup_rstat_cpu_unlock(cpu_lock, cpu, root->cgroup, flags, false);
 	return head;
 }
 
@@ -271,7 +317,7 @@ __weak noinline void bpf_rstat_flush(struct cgroup *cgrp,
 __bpf_hook_end();
 
 /*
- * Helper functions for locking cgroup_rstat_lock.
+ * Helper functions for locking css_rstat_lock.
  *
  * This makes it easier to diagnose locking issues and contention in
  * production environments.  The parameter @cpu_in_loop indicate lock
@@ -279,97 +325,128 @@ __bpf_hook_end();
  * value -1 is used when obtaining the main lock else this is the CPU
  * number processed last.
  */
-static inline void __cgroup_rstat_lock(struct cgroup *cgrp, int cpu_in_loop)
-	__acquires(&cgroup_rstat_lock)
+static inline void __css_rstat_lock(struct cgroup_subsys_state *css,
+				    int cpu_in_loop)
+	__acquires(&css_rstat_lock[css_rstat_tree(css)])
 {
+	int tree = css_rstat_tree(css);
+	struct cgroup *cgrp = css->cgroup;
 	bool contended;
+	u64 start;
 
-	contended = !spin_trylock_irq(&cgroup_rstat_lock);
+	contended = !spin_trylock_irq(&css_rstat_lock[tree]);
 	if (contended) {
 		trace_cgroup_rstat_lock_contended(cgrp, cpu_in_loop, contended);
-		spin_lock_irq(&cgroup_rstat_lock);
+		start = local_clock();
+		spin_lock_irq(&css_rstat_lock[tree]);
+		css_rstat_flush_stat[tree].contended++;
+		css_rstat_flush_stat[tree].wait_ns += local_clock() - start;
 	}
 	trace_cgroup_rstat_locked(cgrp, cpu_in_loop, contended);
 }
 
-static inline void __cgroup_rstat_unlock(struct cgroup *cgrp, int cpu_in_loop)
-	__releases(&cgroup_rstat_lock)
+static inline void __css_rstat_unlock(struct cgroup_subsys_state *css,
+				      int cpu_in_loop)
+	__releases(&css_rstat_lock[css_rstat_tree(css)])
 {
-	trace_cgroup_rstat_unlock(cgrp, cpu_in_loop, false);
-	spin_unlock_irq(&cgroup_rstat_lock);
+	trace_cgroup_rstat_unlock(css->cgroup, cpu_in_loop, false);
+	spin_unlock_irq(&css_rstat_lock[css_rstat_tree(css)]);
 }
 
-/* see cgroup_rstat_flush() */
-static void cgroup_rstat_flush_locked(struct cgroup *cgrp)
-	__releases(&cgroup_rstat_lock) __acquires(&cgroup_rstat_lock)
+/* see css_rstat_flush() */
+static void css_rstat_flush_locked(struct cgroup_subsys_state *css)
+	__releases(&css_rstat_lock[css_rstat_tree(css)])
+	__acquires(&css_rstat_lock[css_rstat_tree(css)])
 {
+	int tree = css_rstat_tree(css);
+	struct css_rstat_flush_stat *fs = &css_rstat_flush_stat[tree];
+	u64 start = local_clock(), delta;
 	int cpu;
 
-	lockdep_assert_held(&cgroup_rstat_lock);
+	lockdep_assert_held(&css_rstat_lock[tree]);
 
 	for_each_possible_cpu(cpu) {
-		struct cgroup *pos = cgroup_rstat_updated_list(cgrp, cpu);
+		struct cgroup_subsys_state *pos = css_rstat_updated_list(css, cpu);
 
 		for (; pos; pos = pos->rstat_flush_next) {
-			struct cgroup_subsys_state *css;
-
-			cgroup_base_stat_flush(pos, cpu);
-			bpf_rstat_flush(pos, cgroup_parent(pos), cpu);
+			if (pos->ss) {
+				pos->ss->css_rstat_flush(pos, cpu);
+			} else {
+				struct cgroup *cgrp = pos->cgroup;
 
-			rcu_read_lock();
-			list_for_each_entry_rcu(css, &pos->rstat_css_list,
-						rstat_css_node)
-				css->ss->css_rstat_flush(css, cpu);
-			rcu_read_unlock();
+				cgroup_base_stat_flush(cgrp, cpu);
+				bpf_rstat_flush(cgrp, cgroup_parent(cgrp), cpu);
+			}
 		}
 
 		/* play nice and yield if necessary */
-		if (need_resched() || spin_needbreak(&cgroup_rstat_lock)) {
-			__cgroup_rstat_unlock(cgrp, cpu);
+		if (need_resched() || spin_needbreak(&css_rstat_lock[tree])) {
+			__css_rstat_unlock(css, cpu);
 			if (!cond_resched())
 				cpu_relax();
-			__cgroup_rstat_lock(cgrp, cpu);
+			__css_rstat_lock(css, cpu);
 		}
 	}
+
+	delta = local_clock() - start;
+	fs->flushes++;
+	fs->flush_ns += delta;
+	if (delta > fs->max_flush_ns)
+		fs->max_flush_ns = delta;
 }
 
 /**
- * cgroup_rstat_flush - flush stats in @cgrp's subtree
- * @cgrp: target cgroup
+ * css_rstat_flush - flush stats in @css's subtree
+ * @css: target css
  *
- * Collect all per-cpu stats in @cgrp's subtree into the global counters
- * and propagate them upwards.  After this function returns, all cgroups in
- * the subtree have up-to-date ->stat.
+ * Collect all per-cpu stats in @css's subtree into the global counters
+ * and propagate them upwards.  After this function returns, all csses in
+ * the subtree have up-to-date stats.  Only the updated tree of @css's
+ * subsystem is walked, or the one of the basic resource statistics for
+ * cgroup::self, and only its lock is taken.
  *
- * This also gets all cgroups in the subtree including @cgrp off the
+ * This also gets all csses in the subtree including @css off the
  * ->updated_children lists.
  *
  * This function may block.
  */
-__bpf_kfunc void cgroup_rstat_flush(struct cgroup *cgrp)
+void css_rstat_flush(struct cgroup_subsys_state *css)
 {
 	might_sleep();
 
-	__cgroup_rstat_lock(cgrp, -1);
-	cgroup_rstat_flush_locked(cgrp);
-	__cgroup_rstat_unlock(cgrp, -1);
+	__css_rstat_lock(css, -1);
+	css_rstat_flush_locked(css);
+	__css_rstat_unlock(css, -1);
+}
+
+/**
+ * cgroup_rstat_flush - flush basic and bpf stats in @cgrp's subtree
+ * @cgrp: target cgroup
+ *
+ * See css_rstat_flush(), the subsystems flush their own stats.
+ *
+ * This function may block.
+ */
+__bpf_kfunc void cgroup_rstat_flush(struct cgroup *cgrp)
+{
+	css_rstat_flush(&cgrp->self);
 }
 
 /**
  * cgroup_rstat_flush_hold - flush stats in @cgrp's subtree and hold
  * @cgrp: target cgroup
  *
- * Flush stats in @cgrp's subtree and prevent further flushes.  Must be
- * paired with cgroup_rstat_flush_release().
+ * Flush basic stats in @cgrp's subtree and prevent further flushes.  Must
+ * be paired with cgroup_rstat_flush_release().
  *
  * This function may block.
  */
 void cgroup_rstat_flush_hold(struct cgroup *cgrp)
-	__acquires(&cgroup_rstat_lock)
+	__acquires(&css_rstat_lock[CGROUP_SUBSYS_COUNT])
 {
 	might_sleep();
-	__cgroup_rstat_lock(cgrp, -1);
-	cgroup_rstat_flush_locked(cgrp);
+	__css_rstat_lock(&cgrp->self, -1);
+	css_rstat_flush_locked(&cgrp->self);
 }
 
 /**
@@ -377,58 +454,95 @@ void cgroup_rstat_flush_hold(struct cgroup *cgrp)
  * @cgrp: cgroup used by tracepoint
  */
 void cgroup_rstat_flush_release(struct cgroup *cgrp)
-	__releases(&cgroup_rstat_lock)
+	__releases(&css_rstat_lock[CGROUP_SUBSYS_COUNT])
 {
-	__cgroup_rstat_unlock(cgrp, -1);
+	__css_rstat_unlock(&cgrp->self, -1);
 }
 
-int cgroup_rstat_init(struct cgroup *cgrp)
+int css_rstat_init(struct cgroup_subsys_state *css)
 {
 	int cpu;
 
-	/* the root cgrp has rstat_cpu preallocated */
-	if (!cgrp->rstat_cpu) {
-		cgrp->rstat_cpu = alloc_percpu(struct cgroup_rstat_cpu);
-		if (!cgrp->rstat_cpu)
-			return -ENOMEM;
-	}
+	css->rstat_cpu = alloc_percpu(struct css_rstat_cpu);
+	if (!css->rstat_cpu)
+		return -ENOMEM;
 
 	/* ->updated_children list is self terminated */
-	for_each_possible_cpu(cpu) {
-		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
-
-		rstatc->updated_children = cgrp;
-		u64_stats_init(&rstatc->bsync);
-	}
+	for_each_possible_cpu(cpu)
+		css_rstat_cpu(css, cpu)->updated_children = css;
 
 	return 0;
 }
 
-void cgroup_rstat_exit(struct cgroup *cgrp)
+void css_rstat_exit(struct cgroup_subsys_state *css)
 {
 	int cpu;
 
-	cgroup_rstat_flush(cgrp);
+	if (!css->rstat_cpu)
+		return;
+
+	css_rstat_flush(css);
 
 	/* sanity check */
 	for_each_possible_cpu(cpu) {
-		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
+		struct css_rstat_cpu *rstatc = css_rstat_cpu(css, cpu);
 
-		if (WARN_ON_ONCE(rstatc->updated_children != cgrp) ||
+		if (WARN_ON_ONCE(rstatc->updated_children != css) ||
 		    WARN_ON_ONCE(rstatc->updated_next))
 			return;
 	}
 
+	free_percpu(css->rstat_cpu);
+	css->rstat_cpu = NULL;
+}
+
+int cgroup_rstat_init(struct cgroup *cgrp)
+{
+	bool prealloc = cgrp->rstat_cpu;
+	int cpu, ret;
+
+	/* the root cgrp has rstat_cpu preallocated */
+	if (!prealloc) {
+		cgrp->rstat_cpu = alloc_percpu(struct cgroup_rstat_cpu);
+		if (!cgrp->rstat_cpu)
+			return -ENOMEM;
+	}
+
+	ret = css_rstat_init(&cgrp->self);
+	if (ret) {
+		if (!prealloc) {
+			free_percpu(cgrp->rstat_cpu);
+			cgrp->rstat_cpu = NULL;
+		}
+		return ret;
+	}
+
+	for_each_possible_cpu(cpu)
+		u64_stats_init(&cgroup_rstat_cpu(cgrp, cpu)->bsync);
+
+	return 0;
+}
+
+void cgroup_rstat_exit(struct cgroup *cgrp)
+{
+	css_rstat_exit(&cgrp->self);
+	/* failed the sanity check, leave it alone */
+	if (cgrp->self.rstat_cpu)
+		return;
+
 	free_percpu(cgrp->rstat_cpu);
 	cgrp->rstat_cpu = NULL;
 }
 
 void __init cgroup_rstat_boot(void)
 {
-	int cpu;
+	int cpu, i;
 
-	for_each_possible_cpu(cpu)
-		raw_spin_lock_init(per_cpu_ptr(&cgroup_rstat_cpu_lock, cpu));
+	for (i = 0; i < CSS_RSTAT_NR_TREES; i++) {
+		spin_lock_init(&css_rstat_lock[i]);
+		for_each_possible_cpu(cpu)
+			raw_spin_lock_init(per_cpu_ptr(&css_rstat_cpu_lock[i], cpu));
+	}
 }
 
 /*
@@ -639,6 +753,43 @@ void cgroup_base_stat_cputime_show(struct seq_file *seq)
 #endif
 }
 
+static void css_rstat_flush_stat_show_one(struct seq_file *m,
+					  const char *name, int tree)
+{
+	struct css_rstat_flush_stat fs;
+
+	spin_lock_irq(&css_rstat_lock[tree]);
+	fs = css_rstat_flush_stat[tree];
+	spin_unlock_irq(&css_rstat_lock[tree]);
+
+	seq_printf(m, "%-8s %12llu %12llu %12llu %12llu %12llu\n", name,
+		   fs.flushes, fs.contended, fs.wait_ns / NSEC_PER_USEC,
+		   fs.flush_ns / NSEC_PER_USEC, fs.max_flush_ns / NSEC_PER_USEC);
+}
+
+static int css_rstat_flush_stat_show(struct seq_file *m, void *v)
+{
+	struct cgroup_subsys *ss;
+	int ssid;
+
+	seq_printf(m, "%-8s %12s %12s %12s %12s %12s\n", "tree", "flushes",
+		   "contended", "wait_us", "flush_us", "max_flush_us");
+	css_rstat_flush_stat_show_one(m, "base", CGROUP_SUBSYS_COUNT);
+	for_each_subsys(ss, ssid)
+		if (ss->css_rstat_flush)
+			css_rstat_flush_stat_show_one(m, ss->name, ssid);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(css_rstat_flush_stat);
+
+static int __init css_rstat_debugfs_init(void)
+{
+	debugfs_create_file("cgroup_rstat", 0444, NULL, NULL,
+			    &css_rstat_flush_stat_fops);
+	return 0;
+}
+late_initcall(css_rstat_debugfs_init);
+
 /* Add bpf kfuncs for cgroup_rstat_updated() and cgroup_rstat_flush() */
 BTF_KFUNCS_START(bpf_rstat_kfunc_ids)
 BTF_ID_FLAGS(func, cgroup_rstat_updated)
@@ -5993,6 +5993,26 @@ static long _perf_ioctl(struct perf_event *event, unsigned int cmd, unsigned lon
 		return 0;
 	}
 
+	case PERF_EVENT_IOC_WAKEUP_LATENCY: {
+		struct perf_buffer *rb;
+		u64 value;
+
+		if (copy_from_user(&value, (u64 __user *)arg, sizeof(value)))
+			return -EFAULT;
+		if (value > NSEC_PER_SEC)
+			return -EINVAL;
+
+		rcu_read_lock();
+		rb = rcu_dereference(event->rb);
+		if (!rb || !rb->nr_pages) {
+			rcu_read_unlock();
+			return -EINVAL;
+		}
+		WRITE_ONCE(rb->wakeup_latency, value);
+		rcu_read_unlock();
+		return 0;
+	}
+
 	case PERF_EVENT_IOC_QUERY_BPF:
 		return perf_event_query_prog_array(event, (void __user *)arg);
 
@@ -6296,6 +6316,68 @@ static void ring_buffer_wakeup(struct perf_event *event)
 	rcu_read_unlock();
 }
 
+/*
+ * Deliver the wakeups that perf_rb_wakeup_defer() held back, at most
+ * ->wakeup_latency after the previous one.
+ */
+enum hrtimer_restart perf_rb_wakeup_timer(struct hrtimer *timer)
+{
+	struct perf_buffer *rb = container_of(timer, struct perf_buffer, wakeup_timer);
+	struct perf_event *event;
+
+	atomic_set(&rb->wakeup_deferred, 0);
+	/* Pairs with the barrier in perf_output_wakeup(). */
+	smp_mb__after_atomic();
+	WRITE_ONCE(rb->wakeup_stamp, ktime_get_ns());
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(event, &rb->event_list, rb_entry) {
+		wake_up_all(&event->waitq);
+		if (event->pending_kill) {
+			kill_fasync(perf_event_fasync(event), SIGIO, event->pending_kill);
+			event->pending_kill = 0;
+		}
+	}
+	rcu_read_unlock();
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * With a wakeup latency set on @event's buffer, wake the readers at most
+ * once per latency period: a wakeup within a period of the previous one
+ * is held back until the end of that period.  Returns true if the wakeup
+ * was deferred.
+ */
+static bool perf_rb_wakeup_defer(struct perf_event *event)
+{
+	struct perf_buffer *rb;
+	bool deferred = false;
+	u64 latency, now;
+
+	if (event->parent)
+		event = event->parent;
+
+	rcu_read_lock();
+	rb = rcu_dereference(event->rb);
+	latency = rb ? READ_ONCE(rb->wakeup_latency) : 0;
+	if (latency) {
+		now = ktime_get_ns();
+		if (now - READ_ONCE(rb->wakeup_stamp) >= latency) {
+			WRITE_ONCE(rb->wakeup_stamp, now);
+		} else {
+			deferred = true;
+			if (!atomic_xchg(&rb->wakeup_deferred, 1))
+				hrtimer_start(&rb->wakeup_timer,
+					      ns_to_ktime(READ_ONCE(rb->wakeup_stamp) + latency),
+					      HRTIMER_MODE_ABS);
+		}
+	}
+	rcu_read_unlock();
+
+	return deferred;
+}
+
 struct perf_buffer *ring_buffer_get(struct perf_event *event)
 {
 	struct perf_buffer *rb;
@@ -6817,7 +6899,8 @@ static void perf_pending_irq(struct irq_work *entry)
 	 */
 	if (event->pending_wakeup) {
 		event->pending_wakeup = 0;
-		perf_event_wakeup(event);
+		if (!perf_rb_wakeup_defer(event))
+			perf_event_wakeup(event);
 	}
 
 	__perf_pending_irq(event);
@@ -3,6 +3,7 @@
 #define _KERNEL_EVENTS_INTERNAL_H
 
 #include <linux/hardirq.h>
+#include <linux/hrtimer.h>
 #include <linux/uaccess.h>
 #include <linux/refcount.h>
 
@@ -35,6 +36,12 @@ struct perf_buffer {
 	spinlock_t			event_lock;
 	struct list_head		event_list;
 
+	/* wakeup coalescing, see perf_rb_wakeup_defer() */
+	u64				wakeup_latency;	/* ns, 0: off        */
+	u64				wakeup_stamp;	/* last wakeup, ns   */
+	atomic_t			wakeup_deferred;
+	struct hrtimer			wakeup_timer;
+
 	atomic_t			mmap_count;
 	unsigned long			mmap_locked;
 	struct user_struct		*mmap_user;
@@ -59,12 +66,14 @@ struct perf_buffer {
 };
 
 extern void rb_free(struct perf_buffer *rb);
+extern enum hrtimer_restart perf_rb_wakeup_timer(struct hrtimer *timer);
 
 static inline void rb_free_rcu(struct rcu_head *rcu_head)
 {
 	struct perf_buffer *rb;
 
 	rb = container_of(rcu_head, struct perf_buffer, rcu_head);
+	hrtimer_cancel(&rb->wakeup_timer);
 	rb_free(rb);
 }
 
@@ -19,13 +19,25 @@
 
 static void perf_output_wakeup(struct perf_output_handle *handle)
 {
-	atomic_set(&handle->rb->poll, EPOLLIN);
+	struct perf_buffer *rb = handle->rb;
+
+	atomic_set(&rb->poll, EPOLLIN);
 
 	handle->event->pending_wakeup = 1;
 
 	if (*perf_event_fasync(handle->event) && !handle->event->pending_kill)
 		handle->event->pending_kill = POLL_IN;
 
+	/*
+	 * A coalesced wakeup is already scheduled and will deliver this one.
+	 * Pairs with the barrier in perf_rb_wakeup_timer().
+	 */
+	if (READ_ONCE(rb->wakeup_latency)) {
+		smp_mb();
+		if (atomic_read(&rb->wakeup_deferred))
+			return;
+	}
+
 	irq_work_queue(&handle->event->pending_irq);
 }
 
@@ -331,6 +343,9 @@ ring_buffer_init(struct perf_buffer *rb, long watermark, int flags)
 	INIT_LIST_HEAD(&rb->event_list);
 	spin_lock_init(&rb->event_lock);
 
+	hrtimer_init(&rb->wakeup_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	rb->wakeup_timer.function = perf_rb_wakeup_timer;
+
 	/*
 	 * perf_output_begin() only checks rb->paused, therefore
 	 * rb->paused must be true if we have no pages for output.
@@ -808,6 +823,42 @@ static void *perf_mmap_alloc_page(int cpu)
 	return page_address(page);
 }
 
+/*
+ * Allocate the data pages in physically contiguous chunks of up to a PMD,
+ * split into order-0 pages so that they are mapped and freed as before.
+ * The kernel writes the buffer through the linear map, where a chunk can
+ * be covered by a single huge TLB entry rather than one entry per page.
+ *
+ * Returns the number of pages allocated.
+ */
+static int perf_mmap_alloc_data_pages(struct perf_buffer *rb, int nr_pages,
+				      int cpu)
+{
+	int node = (cpu == -1) ? cpu : cpu_to_node(cpu);
+	int order = PMD_ORDER;
+	struct page *page;
+	int i = 0, j;
+
+	while (i < nr_pages) {
+		order = min(order, ilog2(nr_pages - i));
+		page = alloc_pages_node(node, GFP_KERNEL | __GFP_ZERO |
+					(order ? __GFP_NORETRY | __GFP_NOWARN : 0),
+					order);
+		if (!page) {
+			if (!order)
+				break;
+			order--;
+			continue;
+		}
+		if (order)
+			split_page(page, order);
+		for (j = 0; j < 1 << order; j++)
+			rb->data_pages[i++] = page_address(page + j);
+	}
+
+	return i;
+}
+
 static void perf_mmap_free_page(void *addr)
 {
 	struct page *page = virt_to_page(addr);
@@ -837,11 +888,9 @@ struct perf_buffer *rb_alloc(int nr_pages, long watermark, int cpu, int flags)
 	if (!rb->user_page)
 		goto fail_user_page;
 
-	for (i = 0; i < nr_pages; i++) {
-		rb->data_pages[i] = perf_mmap_alloc_page(cpu);
-		if (!rb->data_pages[i])
-			goto fail_data_pages;
-	}
+	i = perf_mmap_alloc_data_pages(rb, nr_pages, cpu);
+	if (i < nr_pages)
+		goto fail_data_pages;
 
 	rb->nr_pages = nr_pages;
 
@@ -40,6 +40,7 @@ static struct rb_root uprobes_tree = RB_ROOT;
 #define no_uprobe_events()	RB_EMPTY_ROOT(&uprobes_tree)
 
 static DEFINE_RWLOCK(uprobes_treelock);	/* serialize rbtree access */
+static seqcount_rwlock_t uprobes_seqcount = SEQCNT_RWLOCK_ZERO(uprobes_seqcount, &uprobes_treelock);
 
 #define UPROBES_HASH_SZ	13
 /* serialize uprobe->pending_list */
@@ -54,6 +55,7 @@ DEFINE_STATIC_PERCPU_RWSEM(dup_mmap_sem);
 struct uprobe {
 	struct rb_node		rb_node;	/* node in the rb tree */
 	refcount_t		ref;
+	struct rcu_head		rcu;		/* lockless find_uprobe() */
 	struct rw_semaphore	register_rwsem;
 	struct rw_semaphore	consumer_rwsem;
 	struct list_head	pending_list;
@@ -91,12 +93,14 @@ static LIST_HEAD(delayed_uprobe_list);
  * mangled by set_swbp().
  *
  * On a breakpoint hit, thread contests for a slot.  It frees the
- * slot after singlestep. Currently a fixed number of slots are
+ * slot after singlestep, unless it can keep it for its next hit, see
+ * xol_release_insn_slot(). Currently a fixed number of slots are
  * allocated.
  */
 struct xol_area {
 	wait_queue_head_t 		wq;		/* if all slots are busy */
 	atomic_t 			slot_count;	/* number of in-use slots */
+	atomic_t			slot_kept;	/* ... kept by idle threads */
 	unsigned long 			*bitmap;	/* 0 = free slot */
 
 	struct vm_special_mapping	xol_mapping;
@@ -604,7 +608,8 @@ static void put_uprobe(struct uprobe *uprobe)
 		mutex_lock(&delayed_uprobe_lock);
 		delayed_uprobe_remove(uprobe, NULL);
 		mutex_unlock(&delayed_uprobe_lock);
-		kfree(uprobe);
+		/* find_uprobe() may still be looking at it */
+		kfree_rcu(uprobe, rcu);
 	}
 }
 
@@ -647,31 +652,35 @@ static inline int __uprobe_cmp(struct rb_node *a, const struct rb_node *b)
 	return uprobe_cmp(u->inode, u->offset, __node_2_uprobe(b));
 }
 
-static struct uprobe *__find_uprobe(struct inode *inode, loff_t offset)
-{
-	struct __uprobe_key key = {
-		.inode = inode,
-		.offset = offset,
-	};
-	struct rb_node *node = rb_find(&key, &uprobes_tree, __uprobe_cmp_key);
-
-	if (node)
-		return get_uprobe(__node_2_uprobe(node));
-
-	return NULL;
-}
-
 /*
  * Find a uprobe corresponding to a given inode:offset
- * Acquires uprobes_treelock
+ *
+ * Lockless: the tree is walked under RCU and uprobes_seqcount, a walk which
+ * raced with a rotation may miss a node and is retried. A uprobe found with
+ * a zero refcount has already been erased by delete_uprobe().
  */
 static struct uprobe *find_uprobe(struct inode *inode, loff_t offset)
 {
-	struct uprobe *uprobe;
+	struct __uprobe_key key = {
+		.inode = inode,
+		.offset = offset,
+	};
+	struct uprobe *uprobe = NULL;
+	struct rb_node *node;
+	unsigned int seq;
 
-	read_lock(&uprobes_treelock);
-	uprobe = __find_uprobe(inode, offset);
-	read_unlock(&uprobes_treelock);
+	rcu_read_lock();
+	do {
+		seq = read_seqcount_begin(&uprobes_seqcount);
+		node = rb_find_rcu(&key, &uprobes_tree, __uprobe_cmp_key);
+		if (node) {
+			uprobe = __node_2_uprobe(node);
+			if (!refcount_inc_not_zero(&uprobe->ref))
+				uprobe = NULL;
+			break;
+		}
+	} while (read_seqcount_retry(&uprobes_seqcount, seq));
+	rcu_read_unlock();
 
 	return uprobe;
 }
@@ -680,12 +689,13 @@ static struct uprobe *__insert_uprobe(struct uprobe *uprobe)
 {
 	struct rb_node *node;
 
-	node = rb_find_add(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
+	/* get access + creation ref, before find_uprobe() can see it */
+	refcount_set(&uprobe->ref, 2);
+
+	node = rb_find_add_rcu(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
 	if (node)
 		return get_uprobe(__node_2_uprobe(node));
 
-	/* get access + creation ref */
-	refcount_set(&uprobe->ref, 2);
 	return NULL;
 }
 
@@ -702,7 +712,9 @@ static struct uprobe *insert_uprobe(struct uprobe *uprobe)
 	struct uprobe *u;
 
 	write_lock(&uprobes_treelock);
+	write_seqcount_begin(&uprobes_seqcount);
 	u = __insert_uprobe(uprobe);
+	write_seqcount_end(&uprobes_seqcount);
 	write_unlock(&uprobes_treelock);
 
 	return u;
@@ -936,7 +948,9 @@ static void delete_uprobe(struct uprobe *uprobe)
 		return;
 
 	write_lock(&uprobes_treelock);
+	write_seqcount_begin(&uprobes_seqcount);
 	rb_erase(&uprobe->rb_node, &uprobes_tree);
+	write_seqcount_end(&uprobes_seqcount);
 	write_unlock(&uprobes_treelock);
 	RB_CLEAR_NODE(&uprobe->rb_node); /* for uprobe_is_active() */
 	put_uprobe(uprobe);
@@ -1502,6 +1516,7 @@ static struct xol_area *__create_xol_area(unsigned long vaddr)
 	/* Reserve the 1st slot for get_trampoline_vaddr() */
 	set_bit(0, area->bitmap);
 	atomic_set(&area->slot_count, 1);
+	atomic_set(&area->slot_kept, 0);
 	arch_uprobe_copy_ixol(area->pages[0], 0, &insn, UPROBE_SWBP_INSN_SIZE);
 
 	if (!xol_add_vma(mm, area))
@@ -1605,6 +1620,8 @@ static unsigned long xol_take_insn_slot(struct xol_area *area)
  */
 static unsigned long xol_get_insn_slot(struct uprobe *uprobe)
 {
+	struct uprobe_task *utask = current->utask;
+	struct uprobe *kept = utask->xol_uprobe;
 	struct xol_area *area;
 	unsigned long xol_vaddr;
 
@@ -1612,7 +1629,18 @@ static unsigned long xol_get_insn_slot(struct uprobe *uprobe)
 	if (!area)
 		return 0;
 
-	xol_vaddr = xol_take_insn_slot(area);
+	/* the slot kept from the last hit, it may still hold our insn */
+	xol_vaddr = utask->xol_vaddr;
+	if (kept) {
+		utask->xol_uprobe = NULL;
+		atomic_dec(&area->slot_kept);
+		put_uprobe(kept);
+		if (kept == uprobe)
+			return xol_vaddr;
+	}
+
+	if (!xol_vaddr)
+		xol_vaddr = xol_take_insn_slot(area);
 	if (unlikely(!xol_vaddr))
 		return 0;
 
@@ -1651,6 +1679,8 @@ static void xol_free_insn_slot(struct task_struct *tsk)
 		if (slot_nr >= UINSNS_PER_PAGE)
 			return;
 
+		if (tsk->utask->xol_uprobe)
+			atomic_dec(&area->slot_kept);
 		clear_bit(slot_nr, area->bitmap);
 		atomic_dec(&area->slot_count);
 		smp_mb__after_atomic(); /* pairs with prepare_to_wait() */
@@ -1661,6 +1691,24 @@ static void xol_free_insn_slot(struct task_struct *tsk)
 	}
 }
 
+/*
+ * After a singlestep, keep the slot and the copy of @uprobe's insn in it
+ * for the next hit of this thread. Only half of the slots can be kept, so
+ * that threads without one never wait for the idle ones.
+ */
+static void xol_release_insn_slot(struct uprobe_task *utask,
+				  struct uprobe *uprobe)
+{
+	struct xol_area *area = current->mm->uprobes_state.xol_area;
+
+	if (area && atomic_add_unless(&area->slot_kept, 1, UINSNS_PER_PAGE / 2)) {
+		utask->xol_uprobe = get_uprobe(uprobe);
+		return;
+	}
+
+	xol_free_insn_slot(current);
+}
+
 void __weak arch_uprobe_copy_ixol(struct page *page, unsigned long vaddr,
 				  void *src, unsigned long len)
 {
@@ -1697,11 +1745,35 @@ unsigned long uprobe_get_trap_addr(struct pt_regs *regs)
 	return instruction_pointer(regs);
 }
 
-static struct return_instance *free_ret_instance(struct return_instance *ri)
+static struct return_instance *alloc_ret_instance(struct uprobe_task *utask)
+{
+	struct return_instance *ri = utask->ri_pool;
+
+	if (likely(ri)) {
+		utask->ri_pool = ri->next;
+		return ri;
+	}
+
+	return kmalloc(sizeof(struct return_instance), GFP_KERNEL);
+}
+
+/*
+ * The instances are recycled through utask->ri_pool, which is bounded by
+ * the deepest nesting this thread has seen, see MAX_URETPROBE_DEPTH.
+ */
+static void __free_ret_instance(struct uprobe_task *utask,
+				struct return_instance *ri)
+{
+	ri->next = utask->ri_pool;
+	utask->ri_pool = ri;
+}
+
+static struct return_instance *free_ret_instance(struct uprobe_task *utask,
+						 struct return_instance *ri)
 {
 	struct return_instance *next = ri->next;
 	put_uprobe(ri->uprobe);
-	kfree(ri);
+	__free_ret_instance(utask, ri);
 	return next;
 }
 
@@ -1722,9 +1794,16 @@ void uprobe_free_utask(struct task_struct *t)
 
 	ri = utask->return_instances;
 	while (ri)
-		ri = free_ret_instance(ri);
+		ri = free_ret_instance(utask, ri);
+
+	while ((ri = utask->ri_pool)) {
+		utask->ri_pool = ri->next;
+		kfree(ri);
+	}
 
 	xol_free_insn_slot(t);
+	if (utask->xol_uprobe)
+		put_uprobe(utask->xol_uprobe);
 	kfree(utask);
 	t->utask = NULL;
 }
@@ -1847,7 +1926,7 @@ static void cleanup_return_instances(struct uprobe_task *utask, bool chained,
 	enum rp_check ctx = chained ? RP_CHECK_CHAIN_CALL : RP_CHECK_CALL;
 
 	while (ri && !arch_uretprobe_is_alive(ri, ctx, regs)) {
-		ri = free_ret_instance(ri);
+		ri = free_ret_instance(utask, ri);
 		utask->depth--;
 	}
 	utask->return_instances = ri;
@@ -1874,7 +1953,7 @@ static void prepare_uretprobe(struct uprobe *uprobe, struct pt_regs *regs)
 		return;
 	}
 
-	ri = kmalloc(sizeof(struct return_instance), GFP_KERNEL);
+	ri = alloc_ret_instance(utask);
 	if (!ri)
 		return;
 
@@ -1916,7 +1995,7 @@ static void prepare_uretprobe(struct uprobe *uprobe, struct pt_regs *regs)
 
 	return;
  fail:
-	kfree(ri);
+	__free_ret_instance(utask, ri);
 }
 
 /* Prepare to single-step probed instruction out of line. */
@@ -2151,7 +2230,7 @@ static void handle_trampoline(struct pt_regs *regs)
 		do {
 			if (valid)
 				handle_uretprobe_chain(ri, regs);
-			ri = free_ret_instance(ri);
+			ri = free_ret_instance(utask, ri);
 			utask->depth--;
 		} while (ri != next);
 	} while (!valid);
@@ -2266,10 +2345,10 @@ static void handle_singlestep(struct uprobe_task *utask, struct pt_regs *regs)
 	else
 		WARN_ON_ONCE(1);
 
+	xol_release_insn_slot(utask, uprobe);
 	put_uprobe(uprobe);
 	utask->active_uprobe = NULL;
 	utask->state = UTASK_RUNNING;
-	xol_free_insn_slot(current);
 
 	spin_lock_irq(&current->sighand->siglock);
 	recalc_sigpending(); /* see uprobe_deny_signal() */
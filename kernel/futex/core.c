@@ -35,25 +35,43 @@
 #include <linux/jhash.h>
 #include <linux/pagemap.h>
 #include <linux/plist.h>
-#include <linux/memblock.h>
 #include <linux/fault-inject.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
 
 #include "futex.h"
 #include "../locking/rtmutex_common.h"
 
 /*
- * The base of the bucket array and its size are always used together
- * (after initialization only in futex_hash()), so ensure that they
- * reside in the same cacheline.
+ * The global hash is made of one bucket array per possible node, all of
+ * the same size. The bases of the bucket arrays and their size are always
+ * used together (after initialization only in futex_hash()), so keep the
+ * size next to them.
  */
 static struct {
-	struct futex_hash_bucket *queues;
 	unsigned long            hashsize;
+	unsigned int             hashshift;
+	struct futex_hash_bucket *queues[MAX_NUMNODES];
 } __futex_data __read_mostly __aligned(2*sizeof(long));
-#define futex_queues   (__futex_data.queues)
-#define futex_hashsize (__futex_data.hashsize)
+#define futex_queues    (__futex_data.queues)
+#define futex_hashsize  (__futex_data.hashsize)
+#define futex_hashshift (__futex_data.hashshift)
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/*
+ * Per mm hash for PROCESS_PRIVATE futexes. mm->futex_phash is NULL until
+ * the first private futex operation of the mm decides, once and for all,
+ * whether the mm uses its own table or FUTEX_PHASH_GLOBAL, i.e. the global
+ * one. It must never change afterwards: a waiter and its waker have to
+ * agree on the bucket.
+ */
+struct futex_private_hash {
+	unsigned long			mask;
+	struct futex_hash_bucket	queues[];
+};
+
+#define FUTEX_PHASH_GLOBAL	((struct futex_private_hash *)ERR_PTR(-ENOMEM))
+#endif
 
 /*
  * Fault injections for futexes.
@@ -106,19 +124,136 @@ late_initcall(fail_futex_debugfs);
 
 #endif /* CONFIG_FAIL_FUTEX */
 
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+}
+
+void futex_hash_free(struct mm_struct *mm)
+{
+	struct futex_private_hash *fph = mm->futex_phash;
+
+	/* No task uses the mm anymore, so there can't be any waiters left */
+	if (!IS_ERR_OR_NULL(fph))
+		kvfree(fph);
+	mm->futex_phash = NULL;
+}
+
+/*
+ * Set up the private hash on the first PROCESS_PRIVATE operation of @mm.
+ * The number of tasks contending on the buckets at any time is bounded by
+ * the number of CPUs, so size it by that rather than by the thread count,
+ * which can't be known here and would require rehashing queued waiters
+ * later on. If the allocation fails the mm sticks to the global hash.
+ */
+static void futex_private_hash_setup(struct mm_struct *mm)
+{
+	struct futex_private_hash *fph;
+	unsigned long i, slots;
+
+	slots = roundup_pow_of_two(4 * num_online_cpus());
+	slots = clamp(slots, 16UL, futex_hashsize);
+
+	fph = kvmalloc_node(struct_size(fph, queues, slots),
+			    GFP_KERNEL_ACCOUNT | __GFP_NOWARN, numa_node_id());
+	if (!fph) {
+		cmpxchg(&mm->futex_phash, NULL, FUTEX_PHASH_GLOBAL);
+		return;
+	}
+
+	fph->mask = slots - 1;
+	for (i = 0; i < slots; i++)
+		futex_hash_bucket_init(&fph->queues[i]);
+
+	/* Publish the initialized buckets, pairs with READ_ONCE() in futex_hash() */
+	if (cmpxchg_release(&mm->futex_phash, NULL, fph))
+		kvfree(fph);
+}
+
+static inline bool futex_key_is_private(union futex_key *key)
+{
+	return !(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED));
+}
+#endif
+
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket in the global or private hash
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket in the global hash, or in the private hash of
+ * the mm for PROCESS_PRIVATE keys when CONFIG_FUTEX_PRIVATE_HASH is set.
+ *
+ * The node of the global hash is the one stored next to a FUTEX2_NUMA
+ * futex, otherwise keys are spread over the nodes by the hash bits above
+ * the bucket index.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
+	unsigned int node = key->both.node;
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	if (futex_key_is_private(key)) {
+		struct futex_private_hash *fph;
+
+		fph = READ_ONCE(key->private.mm->futex_phash);
+		if (!IS_ERR_OR_NULL(fph))
+			return &fph->queues[hash & fph->mask];
+	}
+#endif
+	if (node == FUTEX_NO_NODE) {
+		node = (hash >> futex_hashshift) % nr_node_ids;
+		if (!node_possible(node))
+			node = find_next_bit_wrap(node_possible_map.bits,
+						  nr_node_ids, node);
+	}
+
+	return &futex_queues[node][hash & (futex_hashsize - 1)];
+}
+
+/*
+ * Read the node of a FUTEX2_NUMA futex from the u32 following its value,
+ * claiming it for the local node if it is still FUTEX_NO_NODE. Once set
+ * the node must not be changed by user space while the futex is in use,
+ * otherwise waiters and wakers end up in different buckets.
+ */
+static int futex_get_node(u32 __user *naddr, unsigned int *node)
+{
+	u32 val, cur, local;
+	int ret;
 
-	return &futex_queues[hash & (futex_hashsize - 1)];
+	if (get_user(val, naddr))
+		return -EFAULT;
+
+	while (val == FUTEX_NO_NODE) {
+		local = numa_node_id();
+		ret = futex_cmpxchg_value_locked(&cur, naddr, val, local);
+		if (!ret) {
+			/* cur is the previous value, someone else may have won */
+			val = cur == val ? local : cur;
+			break;
+		}
+		if (ret != -EFAULT)
+			return ret;
+		if (fault_in_user_writeable(naddr))
+			return -EFAULT;
+	}
+
+	if (val >= MAX_NUMNODES || !node_possible(val))
+		return -EINVAL;
+
+	*node = val;
+	return 0;
 }
 
 
@@ -227,24 +362,34 @@ int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
 	struct folio *folio;
 	struct address_space *mapping;
 	int err, ro = 0;
+	size_t size;
 	bool fshared;
 
 	fshared = flags & FLAGS_SHARED;
 
 	/*
-	 * The futex address must be "naturally" aligned.
+	 * The futex address must be "naturally" aligned, a NUMA futex
+	 * including its node.
 	 */
+	size = (flags & FLAGS_NUMA) ? 2 * sizeof(u32) : sizeof(u32);
 	key->both.offset = address % PAGE_SIZE;
-	if (unlikely((address % sizeof(u32)) != 0))
+	if (unlikely((address % size) != 0))
 		return -EINVAL;
 	address -= key->both.offset;
 
-	if (unlikely(!access_ok(uaddr, sizeof(u32))))
+	if (unlikely(!access_ok(uaddr, size)))
 		return -EFAULT;
 
 	if (unlikely(should_fail_futex(fshared)))
 		return -EFAULT;
 
+	key->both.node = FUTEX_NO_NODE;
+	if (flags & FLAGS_NUMA) {
+		err = futex_get_node(uaddr + 1, &key->both.node);
+		if (err)
+			return err;
+	}
+
 	/*
 	 * PROCESS_PRIVATE futexes are fast.
 	 * As the mm cannot disappear under us and the 'key' only needs
@@ -264,6 +409,10 @@ int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
 		else
 			key->private.mm = NULL;
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+		if (unlikely(!READ_ONCE(mm->futex_phash)))
+			futex_private_hash_setup(mm);
+#endif
 		key->private.address = address;
 		return 0;
 	}
@@ -1147,26 +1296,32 @@ void futex_exit_release(struct task_struct *tsk)
 
 static int __init futex_init(void)
 {
-	unsigned int futex_shift;
-	unsigned long i;
+	unsigned long i, hashsize;
+	int n;
 
 #ifdef CONFIG_BASE_SMALL
-	futex_hashsize = 16;
+	hashsize = 16;
 #else
-	futex_hashsize = roundup_pow_of_two(256 * num_possible_cpus());
+	hashsize = 256 * num_possible_cpus() / num_possible_nodes();
+	hashsize = roundup_pow_of_two(max(hashsize, 16UL));
 #endif
+	futex_hashsize = hashsize;
+	futex_hashshift = ilog2(hashsize);
+
+	for_each_node(n) {
+		struct futex_hash_bucket *queues;
 
-	futex_queues = alloc_large_system_hash("futex", sizeof(*futex_queues),
-					       futex_hashsize, 0, 0,
-					       &futex_shift, NULL,
-					       futex_hashsize, futex_hashsize);
-	futex_hashsize = 1UL << futex_shift;
+		queues = kvmalloc_node(array_size(hashsize, sizeof(*queues)),
+				       GFP_KERNEL, n);
+		if (!queues)
+			panic("Failed to allocate futex hash table for node %d\n", n);
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
+		for (i = 0; i < hashsize; i++)
+			futex_hash_bucket_init(&queues[i]);
+		futex_queues[n] = queues;
 	}
+	pr_info("futex hash table entries: %lu per node, %d nodes\n",
+		hashsize, num_possible_nodes());
 
 	return 0;
 }
@@ -90,7 +90,8 @@ long do_futex(u32 __user *uaddr, int op, u32 val, ktime_t *timeout,
 	if (flags & FLAGS_CLOCKRT) {
 		if (cmd != FUTEX_WAIT_BITSET &&
 		    cmd != FUTEX_WAIT_REQUEUE_PI &&
-		    cmd != FUTEX_LOCK_PI2)
+		    cmd != FUTEX_LOCK_PI2 &&
+		    cmd != FUTEX_LOCK)
 			return -ENOSYS;
 	}
 
@@ -126,6 +127,8 @@ long do_futex(u32 __user *uaddr, int op, u32 val, ktime_t *timeout,
 					     uaddr2);
 	case FUTEX_CMP_REQUEUE_PI:
 		return futex_requeue(uaddr, flags, uaddr2, flags, val, val2, &val3, 1);
+	case FUTEX_LOCK:
+		return futex_lock(uaddr, flags, timeout);
 	}
 	return -ENOSYS;
 }
@@ -138,6 +141,7 @@ static __always_inline bool futex_cmd_has_timeout(u32 cmd)
 	case FUTEX_LOCK_PI2:
 	case FUTEX_WAIT_BITSET:
 	case FUTEX_WAIT_REQUEUE_PI:
+	case FUTEX_LOCK:
 		return true;
 	}
 	return false;
@@ -3,6 +3,7 @@
 #include <linux/plist.h>
 #include <linux/sched/task.h>
 #include <linux/sched/signal.h>
+#include <linux/sched/clock.h>
 #include <linux/freezer.h>
 
 #include "futex.h"
@@ -200,6 +201,88 @@ int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 	return ret;
 }
 
+/**
+ * futex_wake_multiple - Wake waiters on a vector of futexes
+ * @vs:		The futex list to wake, w.val is the max number to wake on each
+ * @count:	The number of futexes in the list
+ * @bitset:	Bitset the waiters must match, applied to every futex
+ *
+ * Like calling futex_wake() for each entry, but each hash bucket is locked
+ * once for all the futexes hashing to it and the woken tasks are collected on
+ * a single wake_q, so waking a batch costs one pass over the buckets and one
+ * round of wakeups.
+ *
+ * Return: the total number of waiters woken, or an error if a key lookup
+ * failed or a PI futex was found. As with futex_wake(), waiters found before
+ * a PI futex are still woken in the latter case.
+ */
+int futex_wake_multiple(struct futex_vector *vs, unsigned int count, u32 bitset)
+{
+	DECLARE_BITMAP(done, FUTEX_WAITV_MAX);
+	struct futex_hash_bucket *hb;
+	struct futex_q *this, *next;
+	DEFINE_WAKE_Q(wake_q);
+	unsigned int i, j;
+	int ret = 0, woken = 0;
+
+	if (!bitset || count > FUTEX_WAITV_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		u32 __user *uaddr = (u32 __user *)(unsigned long)vs[i].w.uaddr;
+
+		vs[i].q.key = FUTEX_KEY_INIT;
+		ret = get_futex_key(uaddr, vs[i].w.flags, &vs[i].q.key,
+				    FUTEX_READ);
+		if (unlikely(ret))
+			return ret;
+		/* remember the bucket, so each is only hashed once */
+		vs[i].q.lock_ptr = &futex_hash(&vs[i].q.key)->lock;
+	}
+
+	bitmap_zero(done, count);
+	for (i = 0; i < count && !ret; i++) {
+		if (test_bit(i, done))
+			continue;
+
+		hb = container_of(vs[i].q.lock_ptr, struct futex_hash_bucket, lock);
+		if (!futex_hb_waiters_pending(hb))
+			continue;
+
+		spin_lock(&hb->lock);
+		for (j = i; j < count; j++) {
+			int nr = 0;
+
+			if (test_bit(j, done) || vs[j].q.lock_ptr != &hb->lock)
+				continue;
+			__set_bit(j, done);
+
+			plist_for_each_entry_safe(this, next, &hb->chain, list) {
+				if (nr >= vs[j].w.val)
+					break;
+				if (!futex_match(&this->key, &vs[j].q.key))
+					continue;
+				if (this->pi_state || this->rt_waiter) {
+					ret = -EINVAL;
+					break;
+				}
+				if (!(this->bitset & bitset))
+					continue;
+
+				this->wake(&wake_q, this);
+				nr++;
+			}
+			woken += nr;
+			if (ret)
+				break;
+		}
+		spin_unlock(&hb->lock);
+	}
+
+	wake_up_q(&wake_q);
+	return ret ?: woken;
+}
+
 static int futex_atomic_op_inuser(unsigned int encoded_op, u32 __user *uaddr)
 {
 	unsigned int op =	  (encoded_op & 0x70000000) >> 28;
@@ -732,3 +815,126 @@ static long futex_wait_restart(struct restart_block *restart)
 				restart->futex.val, tp, restart->futex.bitset);
 }
 
+
+/*
+ * FUTEX_LOCK: non-PI futex lock with adaptive spinning.
+ *
+ * The futex word holds the TID of the owner and FUTEX_WAITERS like a PI
+ * futex, but there is no kernel side owner tracking. User space takes the
+ * lock with cmpxchg(0 -> TID) and only calls FUTEX_LOCK on contention.
+ * Unlocking is done in user space as well: cmpxchg(TID -> 0), and if that
+ * fails because FUTEX_WAITERS is set, store 0 and FUTEX_WAKE one waiter.
+ *
+ * While the owner is running on a CPU it is likely to release the lock
+ * soon, so spin on the futex word instead of paying for a sleep and a
+ * wakeup, the same as mutex_spin_on_owner() does for kernel mutexes. The
+ * spinners only read the word, so unlike osq_lock() they don't need to be
+ * queued, but the time spent spinning is bounded as user space critical
+ * sections can be long.
+ */
+#define FUTEX_LOCK_SPIN_NS	(50 * NSEC_PER_USEC)
+
+/* Returns true when the futex word changed and the lock should be retried */
+static bool futex_spin_on_owner(u32 __user *uaddr, u32 uval)
+{
+	u64 end = local_clock() + FUTEX_LOCK_SPIN_NS;
+	struct task_struct *owner;
+	bool changed = false;
+	u32 cur;
+
+	rcu_read_lock();
+	owner = find_task_by_vpid(uval & FUTEX_TID_MASK);
+	while (owner) {
+		if (futex_get_value_locked(&cur, uaddr))
+			break;
+		if (cur != uval) {
+			changed = true;
+			break;
+		}
+		if (!owner_on_cpu(owner) || need_resched() ||
+		    local_clock() > end)
+			break;
+		cpu_relax();
+	}
+	rcu_read_unlock();
+
+	return changed;
+}
+
+static int futex_lock_cmpxchg(u32 __user *uaddr, u32 *curval, u32 uval,
+			      u32 nval)
+{
+	int ret;
+
+	for (;;) {
+		ret = futex_cmpxchg_value_locked(curval, uaddr, uval, nval);
+		if (ret != -EFAULT)
+			return ret;
+
+		ret = fault_in_user_writeable(uaddr);
+		if (ret)
+			return ret;
+	}
+}
+
+int futex_lock(u32 __user *uaddr, unsigned int flags, ktime_t *time)
+{
+	struct hrtimer_sleeper timeout, *to;
+	u32 uval, nval, curval, tid = task_pid_vnr(current);
+	bool waited = false;
+	int ret;
+
+	to = futex_setup_timer(time, &timeout, flags, 0);
+
+	for (;;) {
+		if (get_user(uval, uaddr)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		if (!(uval & FUTEX_TID_MASK)) {
+			/*
+			 * Keep FUTEX_OWNER_DIED for user space to see, and
+			 * FUTEX_WAITERS if we slept: the unlocker only woke
+			 * one waiter, others may still be queued.
+			 */
+			nval = (uval & ~FUTEX_TID_MASK) | tid;
+			if (waited)
+				nval |= FUTEX_WAITERS;
+			ret = futex_lock_cmpxchg(uaddr, &curval, uval, nval);
+			if (ret == -EAGAIN || (!ret && curval != uval))
+				continue;
+			break;
+		}
+
+		if ((uval & FUTEX_TID_MASK) == tid) {
+			ret = -EDEADLK;
+			break;
+		}
+
+		if (futex_spin_on_owner(uaddr, uval))
+			continue;
+
+		if (!(uval & FUTEX_WAITERS)) {
+			nval = uval | FUTEX_WAITERS;
+			ret = futex_lock_cmpxchg(uaddr, &curval, uval, nval);
+			if (ret == -EAGAIN || (!ret && curval != uval))
+				continue;
+			if (ret)
+				break;
+			uval = nval;
+		}
+
+		/* -EWOULDBLOCK: the word changed before we got queued */
+		ret = __futex_wait(uaddr, flags, uval, to, FUTEX_BITSET_MATCH_ANY);
+		if (ret && ret != -EWOULDBLOCK)
+			break;
+		waited = true;
+	}
+
+	if (to) {
+		hrtimer_cancel(&to->timer);
+		destroy_hrtimer_on_stack(&to->timer);
+	}
+	return ret;
+}
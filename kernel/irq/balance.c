@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * In kernel interrupt rebalancing.
+ *
+ * Managed interrupts are spread once when the device is set up and the
+ * vector matrix only balances the number of vectors per CPU, not the
+ * interrupt load. With irq_balance.interval_ms set, the interrupt rate of
+ * every balanceable, unmanaged interrupt is sampled each interval and the
+ * busiest interrupt CPU of a node hands one of its interrupts over to the
+ * least busy CPU of the same node, when its load is above the node average
+ * by more than irq_balance.threshold_pct and the move makes things better.
+ *
+ * Only interrupts which are not pinned to a single CPU are considered, an
+ * interrupt moved by the balancer is pinned to its new CPU and stays under
+ * the balancer's control until user space changes its affinity. At most
+ * irq_balance.max_moves interrupts are moved per interval and an interrupt
+ * is not moved again for IRQ_BALANCE_COOLDOWN intervals.
+ */
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/topology.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "irq_balance."
+
+#define IRQ_BALANCE_COOLDOWN	10	/* intervals */
+
+static unsigned int irq_balance_interval_ms;
+static unsigned int irq_balance_threshold_pct = 25;
+static unsigned int irq_balance_min_rate = 1000;	/* per second */
+static unsigned int irq_balance_max_moves = 4;
+module_param_named(threshold_pct, irq_balance_threshold_pct, uint, 0644);
+module_param_named(min_rate, irq_balance_min_rate, uint, 0644);
+module_param_named(max_moves, irq_balance_max_moves, uint, 0644);
+
+static DEFINE_MUTEX(irq_balance_mutex);
+static unsigned long *irq_balance_load;	/* per CPU, irqs in the last interval */
+static cpumask_var_t irq_balance_cpus;
+static unsigned int irq_balance_gen;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_fn);
+
+static bool irq_balance_owned(struct irq_desc *desc)
+{
+	const struct cpumask *aff = irq_data_get_affinity_mask(&desc->irq_data);
+
+	return desc->balance_cpu >= 0 &&
+	       cpumask_equal(aff, cpumask_of(desc->balance_cpu));
+}
+
+/* Called with desc->lock held, the CPU @desc is handled on or -1 */
+static int irq_balance_desc_cpu(struct irq_desc *desc)
+{
+	struct irq_data *data = &desc->irq_data;
+	const struct cpumask *aff = irq_data_get_affinity_mask(data);
+	unsigned int cpu;
+
+	if (!desc->action || !irqd_can_balance(data) ||
+	    irqd_affinity_is_managed(data) || irqd_is_setaffinity_pending(data) ||
+	    !irqd_is_started(data))
+		return -1;
+
+	/* pinned by user space */
+	if (!irq_balance_owned(desc) && cpumask_weight(aff) < 2) {
+		desc->balance_cpu = -1;
+		return -1;
+	}
+
+	cpu = cpumask_first(irq_data_get_effective_affinity_mask(data));
+	return cpu < nr_cpu_ids && cpu_online(cpu) ? cpu : -1;
+}
+
+static void irq_balance_sample(void)
+{
+	struct irq_desc *desc;
+	unsigned int irq, count;
+	int cpu;
+
+	memset(irq_balance_load, 0, nr_cpu_ids * sizeof(*irq_balance_load));
+	irq_balance_gen++;
+
+	for_each_active_irq(irq) {
+		desc = irq_to_desc(irq);
+		if (!desc)
+			continue;
+
+		raw_spin_lock_irq(&desc->lock);
+		count = kstat_irqs_desc(desc, cpu_possible_mask);
+		/* no rate until it has been sampled twice in a row */
+		if (desc->balance_gen == irq_balance_gen - 1)
+			desc->balance_rate = count - desc->balance_count;
+		else
+			desc->balance_rate = 0;
+		desc->balance_count = count;
+		desc->balance_gen = irq_balance_gen;
+
+		cpu = irq_balance_desc_cpu(desc);
+		if (cpu >= 0)
+			irq_balance_load[cpu] += desc->balance_rate;
+		raw_spin_unlock_irq(&desc->lock);
+	}
+}
+
+/*
+ * Move the busiest interrupt of @from which fits in the load difference to
+ * @to, so that @to doesn't end up busier than @from was.
+ */
+static bool irq_balance_move(unsigned int from, unsigned int to)
+{
+	unsigned long diff = irq_balance_load[from] - irq_balance_load[to];
+	struct irq_desc *desc, *best = NULL;
+	unsigned int irq, rate = 0;
+	bool moved = false;
+
+	for_each_active_irq(irq) {
+		desc = irq_to_desc(irq);
+		if (!desc)
+			continue;
+
+		raw_spin_lock_irq(&desc->lock);
+		if (irq_balance_desc_cpu(desc) == from &&
+		    desc->balance_rate > rate && desc->balance_rate < diff &&
+		    (desc->balance_cpu < 0 ||
+		     irq_balance_gen - desc->balance_moved >= IRQ_BALANCE_COOLDOWN) &&
+		    (irq_balance_owned(desc) ||
+		     cpumask_test_cpu(to, irq_data_get_affinity_mask(&desc->irq_data)))) {
+			best = desc;
+			rate = desc->balance_rate;
+		}
+		raw_spin_unlock_irq(&desc->lock);
+	}
+
+	if (!best)
+		return false;
+
+	/* the descriptors can't go away, we hold the sparse irq lock */
+	raw_spin_lock_irq(&best->lock);
+	if (irq_balance_desc_cpu(best) == from &&
+	    !irq_set_affinity_locked(&best->irq_data, cpumask_of(to), false)) {
+		best->balance_cpu = to;
+		best->balance_moved = irq_balance_gen;
+		irq_balance_load[from] -= rate;
+		irq_balance_load[to] += rate;
+		moved = true;
+	}
+	raw_spin_unlock_irq(&best->lock);
+
+	return moved;
+}
+
+static unsigned int irq_balance_node(int node, unsigned int moves,
+				     unsigned long min)
+{
+	unsigned long sum, avg;
+	unsigned int cpu, nr, hot, cold;
+
+	while (moves < READ_ONCE(irq_balance_max_moves)) {
+		cpumask_and(irq_balance_cpus, cpumask_of_node(node), cpu_online_mask);
+		cpumask_and(irq_balance_cpus, irq_balance_cpus, irq_default_affinity);
+		if (cpumask_weight(irq_balance_cpus) < 2)
+			break;
+
+		sum = nr = 0;
+		hot = cold = cpumask_first(irq_balance_cpus);
+		for_each_cpu(cpu, irq_balance_cpus) {
+			sum += irq_balance_load[cpu];
+			nr++;
+			if (irq_balance_load[cpu] > irq_balance_load[hot])
+				hot = cpu;
+			if (irq_balance_load[cpu] < irq_balance_load[cold])
+				cold = cpu;
+		}
+
+		avg = sum / nr;
+		if (irq_balance_load[hot] < min ||
+		    irq_balance_load[hot] * 100 <=
+		    avg * (100 + READ_ONCE(irq_balance_threshold_pct)))
+			break;
+
+		if (!irq_balance_move(hot, cold))
+			break;
+		moves++;
+	}
+
+	return moves;
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	unsigned int interval = READ_ONCE(irq_balance_interval_ms);
+	unsigned int moves = 0;
+	unsigned long min;
+	int node;
+
+	if (!interval)
+		return;
+
+	min = (unsigned long)READ_ONCE(irq_balance_min_rate) * interval / MSEC_PER_SEC;
+
+	mutex_lock(&irq_balance_mutex);
+	cpus_read_lock();
+	irq_lock_sparse();
+
+	irq_balance_sample();
+	for_each_online_node(node)
+		moves = irq_balance_node(node, moves, min);
+
+	irq_unlock_sparse();
+	cpus_read_unlock();
+	mutex_unlock(&irq_balance_mutex);
+
+	queue_delayed_work(system_unbound_wq, &irq_balance_work,
+			   msecs_to_jiffies(interval));
+}
+
+static int irq_balance_set_interval(const char *val, const struct kernel_param *kp)
+{
+	unsigned int interval;
+	int ret;
+
+	ret = kstrtouint(val, 0, &interval);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(irq_balance_interval_ms, interval);
+	/* before irq_balance_init() the work item is queued from there */
+	if (interval && irq_balance_load)
+		mod_delayed_work(system_unbound_wq, &irq_balance_work, 0);
+	return 0;
+}
+
+static const struct kernel_param_ops irq_balance_interval_ops = {
+	.set = irq_balance_set_interval,
+	.get = param_get_uint,
+};
+module_param_cb(interval_ms, &irq_balance_interval_ops, &irq_balance_interval_ms, 0644);
+
+static int __init irq_balance_init(void)
+{
+	if (!zalloc_cpumask_var(&irq_balance_cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	irq_balance_load = kcalloc(nr_cpu_ids, sizeof(*irq_balance_load), GFP_KERNEL);
+	if (!irq_balance_load) {
+		free_cpumask_var(irq_balance_cpus);
+		return -ENOMEM;
+	}
+
+	if (irq_balance_interval_ms)
+		queue_delayed_work(system_unbound_wq, &irq_balance_work,
+				   msecs_to_jiffies(irq_balance_interval_ms));
+	return 0;
+}
+late_initcall(irq_balance_init);
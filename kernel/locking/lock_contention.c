@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Always-available lock contention histograms.
+ *
+ * Writing 1 to /proc/lock_contention attaches in-kernel probes to the
+ * contention_begin/contention_end tracepoints, which are static keys when
+ * nothing is attached, and starts recording the wait time of every
+ * contended spinlock, rwlock, mutex, rwsem and rtmutex acquisition into a
+ * per-CPU table of log2 histograms keyed by the call site of the lock
+ * operation. Writing 0 detaches the probes again, reading the file gives
+ * the histograms summed over all CPUs.
+ *
+ * Unlike lock_stat this needs neither lockdep nor a rebuild, and unlike a
+ * tracing consumer the cost is only paid on contention: one stack walk to
+ * find the call site and a few per-CPU increments.
+ */
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/kstrtox.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/debug.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/stacktrace.h>
+#include <linux/tracepoint.h>
+#include <trace/events/lock.h>
+
+#define LCH_NR_BUCKETS		24	/* log2(usecs), up to ~8s */
+#define LCH_SITE_BITS		8
+#define LCH_NR_SITES		(1 << LCH_SITE_BITS)
+#define LCH_SITE_PROBES		8
+#define LCH_TASK_BITS		10
+#define LCH_NR_TASKS		(1 << LCH_TASK_BITS)
+#define LCH_STACK_DEPTH		12
+
+struct lch_site {
+	unsigned long	ip;
+	unsigned int	flags;
+	u64		count;
+	u64		total_ns;
+	u64		max_ns;
+	u64		buckets[LCH_NR_BUCKETS];
+};
+
+struct lch_cpu {
+	struct lch_site	sites[LCH_NR_SITES];
+	u64		dropped;	/* site table full, or task slot busy */
+};
+
+/*
+ * Waiters in flight. Sleeping locks may end on another CPU than they
+ * began, so these are global and hashed by task. Only the outermost
+ * contention of a task is measured; a lock contended while a task already
+ * waits for another one (e.g. a mutex wait_lock) is not.
+ */
+struct lch_task {
+	struct task_struct	*task;
+	void			*lock;
+	unsigned long		ip;
+	unsigned int		flags;
+	u64			start;
+};
+
+static struct lch_task lch_tasks[LCH_NR_TASKS];
+static struct lch_cpu __percpu *lch_cpus;
+static DEFINE_MUTEX(lch_mutex);
+static bool lch_enabled;
+static DEFINE_PER_CPU(u64, lch_task_busy);
+
+/* The first caller outside of the locking and scheduler code */
+static unsigned long lch_call_site(void)
+{
+	unsigned long entries[LCH_STACK_DEPTH];
+	bool in_lock = false;
+	unsigned int i, nr;
+
+	nr = stack_trace_save(entries, ARRAY_SIZE(entries), 0);
+	for (i = 0; i < nr; i++) {
+		if (in_lock_functions(entries[i]) ||
+		    in_sched_functions(entries[i]))
+			in_lock = true;
+		else if (in_lock)
+			return entries[i];
+	}
+	return 0;
+}
+
+static void lch_contention_begin(void *data, void *lock, unsigned int flags)
+{
+	struct lch_task *t = &lch_tasks[hash_ptr(current, LCH_TASK_BITS)];
+	struct task_struct *owner = READ_ONCE(t->task);
+
+	/* mutexes begin again after optimistic spinning, keep the start */
+	if (owner == current)
+		return;
+
+	if (owner || cmpxchg(&t->task, NULL, current)) {
+		this_cpu_inc(lch_task_busy);
+		return;
+	}
+
+	t->lock = lock;
+	t->flags = flags;
+	t->ip = lch_call_site();
+	t->start = local_clock();
+}
+
+static void lch_record(struct lch_task *t, u64 delta)
+{
+	struct lch_cpu *c = this_cpu_ptr(lch_cpus);
+	unsigned int i, h = hash_long(t->ip, LCH_SITE_BITS);
+	struct lch_site *site;
+	unsigned int bucket;
+
+	for (i = 0; i < LCH_SITE_PROBES; i++) {
+		site = &c->sites[(h + i) & (LCH_NR_SITES - 1)];
+		if (site->ip == t->ip)
+			break;
+		if (!site->ip && !cmpxchg_local(&site->ip, 0, t->ip))
+			break;
+	}
+	if (i == LCH_SITE_PROBES) {
+		c->dropped++;
+		return;
+	}
+
+	bucket = min_t(unsigned int, ilog2((delta >> 10) | 1),
+		       LCH_NR_BUCKETS - 1);
+	site->flags |= t->flags;
+	site->count++;
+	site->total_ns += delta;
+	if (delta > site->max_ns)
+		site->max_ns = delta;
+	site->buckets[bucket]++;
+}
+
+static void lch_contention_end(void *data, void *lock, int ret)
+{
+	struct lch_task *t = &lch_tasks[hash_ptr(current, LCH_TASK_BITS)];
+
+	/* not ours, or the end of a nested contention */
+	if (READ_ONCE(t->task) != current || t->lock != lock)
+		return;
+
+	if (t->ip)
+		lch_record(t, local_clock() - t->start);
+
+	smp_store_release(&t->task, NULL);
+}
+
+static int lch_enable(void)
+{
+	int cpu, ret;
+
+	if (!lch_cpus) {
+		lch_cpus = alloc_percpu(struct lch_cpu);
+		if (!lch_cpus)
+			return -ENOMEM;
+	}
+
+	for_each_possible_cpu(cpu) {
+		memset(per_cpu_ptr(lch_cpus, cpu), 0, sizeof(struct lch_cpu));
+		per_cpu(lch_task_busy, cpu) = 0;
+	}
+	memset(lch_tasks, 0, sizeof(lch_tasks));
+
+	/* end first, so that no task slot is claimed without its release */
+	ret = register_trace_contention_end(lch_contention_end, NULL);
+	if (ret)
+		return ret;
+	ret = register_trace_contention_begin(lch_contention_begin, NULL);
+	if (ret) {
+		unregister_trace_contention_end(lch_contention_end, NULL);
+		tracepoint_synchronize_unregister();
+	}
+	return ret;
+}
+
+static void lch_disable(void)
+{
+	unregister_trace_contention_begin(lch_contention_begin, NULL);
+	unregister_trace_contention_end(lch_contention_end, NULL);
+	tracepoint_synchronize_unregister();
+}
+
+static int lch_show(struct seq_file *m, void *v)
+{
+	struct lch_site *sum, *s, *d;
+	u64 dropped = 0;
+	int cpu, i, j, k, n = 0;
+
+	mutex_lock(&lch_mutex);
+	seq_printf(m, "enabled: %d\n", lch_enabled);
+	if (!lch_cpus)
+		goto out;
+
+	sum = kvcalloc(LCH_NR_SITES, sizeof(*sum), GFP_KERNEL);
+	if (!sum) {
+		mutex_unlock(&lch_mutex);
+		return -ENOMEM;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct lch_cpu *c = per_cpu_ptr(lch_cpus, cpu);
+
+		dropped += data_race(c->dropped) +
+			   data_race(per_cpu(lch_task_busy, cpu));
+		for (i = 0; i < LCH_NR_SITES; i++) {
+			s = &c->sites[i];
+			if (!data_race(s->ip))
+				continue;
+			for (j = 0; j < n; j++)
+				if (sum[j].ip == s->ip)
+					break;
+			if (j == n) {
+				if (n == LCH_NR_SITES) {
+					dropped += data_race(s->count);
+					continue;
+				}
+				sum[n++].ip = s->ip;
+			}
+			d = &sum[j];
+			d->flags |= data_race(s->flags);
+			d->count += data_race(s->count);
+			d->total_ns += data_race(s->total_ns);
+			d->max_ns = max(d->max_ns, data_race(s->max_ns));
+			for (k = 0; k < LCH_NR_BUCKETS; k++)
+				d->buckets[k] += data_race(s->buckets[k]);
+		}
+	}
+
+	seq_printf(m, "dropped: %llu\n", dropped);
+	seq_puts(m, "# flags count total_us max_us [log2(us) buckets] site\n");
+	for (j = 0; j < n; j++) {
+		d = &sum[j];
+		seq_printf(m, "%#04x %llu %llu %llu [", d->flags, d->count,
+			   d->total_ns / NSEC_PER_USEC,
+			   d->max_ns / NSEC_PER_USEC);
+		for (k = 0; k < LCH_NR_BUCKETS; k++)
+			seq_printf(m, k ? " %llu" : "%llu", d->buckets[k]);
+		seq_printf(m, "] %pS\n", (void *)d->ip);
+	}
+	kvfree(sum);
+out:
+	mutex_unlock(&lch_mutex);
+	return 0;
+}
+
+static int lch_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lch_show, NULL);
+}
+
+static ssize_t lch_write(struct file *file, const char __user *buf,
+			 size_t count, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&lch_mutex);
+	if (enable && !lch_enabled) {
+		ret = lch_enable();
+		lch_enabled = !ret;
+	} else if (!enable && lch_enabled) {
+		lch_disable();
+		lch_enabled = false;
+	}
+	mutex_unlock(&lch_mutex);
+
+	return ret ? ret : count;
+}
+
+static const struct proc_ops lch_proc_ops = {
+	.proc_open	= lch_open,
+	.proc_read	= seq_read,
+	.proc_write	= lch_write,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
+static int __init lock_contention_init(void)
+{
+	proc_create("lock_contention", 0600, NULL, &lch_proc_ops);
+	return 0;
+}
+device_initcall(lock_contention_init);
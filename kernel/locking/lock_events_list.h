@@ -47,6 +47,8 @@ LOCK_EVENT(lock_use_node2)	/* # of locking ops that use 2nd percpu node */
 LOCK_EVENT(lock_use_node3)	/* # of locking ops that use 3rd percpu node */
 LOCK_EVENT(lock_use_node4)	/* # of locking ops that use 4th percpu node */
 LOCK_EVENT(lock_no_node)	/* # of locking ops w/o using percpu node    */
+LOCK_EVENT(lock_cna_reorder)	/* # of CNA queue reorders for node locality */
+LOCK_EVENT(lock_cna_flush)	/* # of CNA secondary queue fairness flushes */
 #endif /* CONFIG_QUEUED_SPINLOCKS */
 
 /*
@@ -67,3 +69,15 @@ LOCK_EVENT(rwsem_rlock_handoff)	/* # of read lock handoffs		*/
 LOCK_EVENT(rwsem_wlock)		/* # of write locks acquired		*/
 LOCK_EVENT(rwsem_wlock_fail)	/* # of failed write lock acquisitions	*/
 LOCK_EVENT(rwsem_wlock_handoff)	/* # of write lock handoffs		*/
+
+/*
+ * Locking events for percpu-rwsem
+ *
+ * pcpu_rwsem_rlock_fast / (pcpu_rwsem_rlock_fast + pcpu_rwsem_rlock_slow)
+ * is the reader fast path hit rate.
+ */
+LOCK_EVENT(pcpu_rwsem_rlock_fast)	/* # of per-CPU fast path read locks	*/
+LOCK_EVENT(pcpu_rwsem_rlock_slow)	/* # of read locks via the slow path	*/
+LOCK_EVENT(pcpu_rwsem_rlock_spin)	/* # of read locks after spinning	*/
+LOCK_EVENT(pcpu_rwsem_rlock_sleep)	/* # of reader sleeps			*/
+LOCK_EVENT(pcpu_rwsem_wlock)		/* # of write locks			*/
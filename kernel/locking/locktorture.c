@@ -114,10 +114,12 @@ static struct task_struct **reader_tasks;
 static bool lock_is_write_held;
 static atomic_t lock_is_read_held;
 static unsigned long last_lock_release;
+static int last_lock_node = NUMA_NO_NODE;
 
 struct lock_stress_stats {
 	long n_lock_fail;
 	long n_lock_acquired;
+	long n_lock_local;	/* acquired on the node of the previous writer */
 };
 
 struct call_rcu_chain {
@@ -848,6 +850,7 @@ static int lock_torture_writer(void *arg)
 	DEFINE_TORTURE_RANDOM(rand);
 	bool skip_main_lock;
 	int tid = lwsp - cxt.lwsa;
+	int node;
 
 	VERBOSE_TOROUT_STRING("lock_torture_writer task started");
 	if (!rt_task(current))
@@ -889,6 +892,10 @@ static int lock_torture_writer(void *arg)
 					  __func__, j1 - j);
 			}
 			lwsp->n_lock_acquired++;
+			node = cpu_to_node(raw_smp_processor_id());
+			if (node == last_lock_node)
+				lwsp->n_lock_local++;
+			last_lock_node = node;
 
 			cxt.cur_ops->write_delay(&rand);
 
@@ -950,7 +957,7 @@ static void __torture_print_stats(char *page,
 	bool fail = false;
 	int i, n_stress;
 	long max = 0, min = statp ? data_race(statp[0].n_lock_acquired) : 0;
-	long long sum = 0;
+	long long sum = 0, local = 0;
 
 	n_stress = write ? cxt.nrealwriters_stress : cxt.nrealreaders_stress;
 	for (i = 0; i < n_stress; i++) {
@@ -958,6 +965,7 @@ static void __torture_print_stats(char *page,
 			fail = true;
 		cur = data_race(statp[i].n_lock_acquired);
 		sum += cur;
+		local += data_race(statp[i].n_lock_local);
 		if (max < cur)
 			max = cur;
 		if (min > cur)
@@ -969,6 +977,10 @@ static void __torture_print_stats(char *page,
 			sum, max, min,
 			!onoff_interval && max / 2 > min ? "???" : "",
 			fail, fail ? "!!!" : "");
+	/* How often the lock stayed on the same node, see the CNA qspinlock */
+	if (write && nr_node_ids > 1)
+		page += sprintf(page, "Writes:  Node-local handoffs: %lld (%lld%%)\n",
+				local, sum ? div64_s64(local * 100, sum) : 0);
 	if (fail)
 		atomic_inc(&cxt.n_lock_torture_errors);
 }
@@ -1243,6 +1255,7 @@ static int __init lock_torture_init(void)
 		for (i = 0; i < cxt.nrealwriters_stress; i++) {
 			cxt.lwsa[i].n_lock_fail = 0;
 			cxt.lwsa[i].n_lock_acquired = 0;
+			cxt.lwsa[i].n_lock_local = 0;
 		}
 	}
 
@@ -8,9 +8,19 @@
 #include <linux/sched.h>
 #include <linux/sched/task.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/clock.h>
 #include <linux/errno.h>
 #include <trace/events/lock.h>
 
+#include "lock_events.h"
+
+/*
+ * How long a reader spins for the writer to go away before it sleeps.
+ * Writers that hold the lock for long are the common case, so keep it
+ * short, it only has to cover a writer that is about to release.
+ */
+#define PERCPU_RWSEM_SPIN_NS	(10 * NSEC_PER_USEC)
+
 int __percpu_init_rwsem(struct percpu_rw_semaphore *sem,
 			const char *name, struct lock_class_key *key)
 {
@@ -164,14 +174,48 @@ static void percpu_rwsem_wait(struct percpu_rw_semaphore *sem, bool reader)
 	__set_current_state(TASK_RUNNING);
 }
 
+/*
+ * Optimistically spin, with preemption disabled, while a writer holds the
+ * lock. Don't jump ahead of queued waiters so that they stay FIFO.
+ */
+static bool percpu_rwsem_read_spin(struct percpu_rw_semaphore *sem)
+{
+	u64 end = local_clock() + PERCPU_RWSEM_SPIN_NS;
+
+	while (atomic_read(&sem->block)) {
+		if (waitqueue_active(&sem->waiters) || need_resched() ||
+		    local_clock() > end)
+			return false;
+		cpu_relax();
+	}
+
+	return __percpu_down_read_trylock(sem);
+}
+
+#ifdef CONFIG_LOCK_EVENT_COUNTS
+void percpu_rwsem_lockevent_fast(void)
+{
+	lockevent_inc(pcpu_rwsem_rlock_fast);
+}
+EXPORT_SYMBOL_GPL(percpu_rwsem_lockevent_fast);
+#endif
+
 bool __sched __percpu_down_read(struct percpu_rw_semaphore *sem, bool try)
 {
+	lockevent_inc(pcpu_rwsem_rlock_slow);
+
 	if (__percpu_down_read_trylock(sem))
 		return true;
 
 	if (try)
 		return false;
 
+	if (percpu_rwsem_read_spin(sem)) {
+		lockevent_inc(pcpu_rwsem_rlock_spin);
+		return true;
+	}
+
+	lockevent_inc(pcpu_rwsem_rlock_sleep);
 	trace_contention_begin(sem, LCB_F_PERCPU | LCB_F_READ);
 	preempt_enable();
 	percpu_rwsem_wait(sem, /* .reader = */ true);
@@ -227,6 +271,7 @@ void __sched percpu_down_write(struct percpu_rw_semaphore *sem)
 
 	might_sleep();
 	rwsem_acquire(&sem->dep_map, 0, 0, _RET_IP_);
+	lockevent_inc(pcpu_rwsem_wlock);
 
 	/* Notify readers to take the slow path. */
 	rcu_sync_enter(&sem->rss);
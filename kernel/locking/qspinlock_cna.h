@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+#include <linux/sched/clock.h>
+
+/*
+ * Implement a NUMA-aware version of MCS (aka CNA, or compact NUMA-aware
+ * lock).
+ *
+ * In CNA, spinning threads are organized in two queues, a primary queue
+ * for threads running on the same NUMA node as the current lock holder,
+ * and a secondary queue for threads running on other nodes. Schematically,
+ * it looks like this:
+ *
+ *    cna_node
+ *   +----------+     +--------+         +--------+
+ *   |mcs:next  | --> |mcs:next| --> ... |mcs:next| --> NULL  [Primary queue]
+ *   |mcs:locked| -.  +--------+         +--------+
+ *   +----------+  |
+ *                 `----------------------.
+ *                                        v
+ *                 +--------+         +--------+
+ *                 |mcs:next| --> ... |mcs:next|            [Secondary queue]
+ *                 +--------+         +--------+
+ *                     ^                    |
+ *                     `--------------------'
+ *                       sec_tail of the head
+ *
+ * N.B. locked := 1 if secondary queue is absent. Otherwise, it contains
+ * the encoded pointer to the head of the secondary queue, which is passed
+ * along with the MCS lock from one queue head to the next.
+ *
+ * When the queue head starts waiting for the lock owner, it scans the
+ * primary queue for a waiter on its own node and moves the waiters it
+ * skips to the tail of the secondary queue. Those are only the waiters
+ * with a successor, so the lock tail is never touched. If the primary
+ * queue becomes empty while the secondary one is not, the latter becomes
+ * the primary queue through a cmpxchg of the lock tail.
+ *
+ * For long-term fairness, the secondary queue is spliced back in front of
+ * the primary queue once its head has been waiting there for longer than
+ * numa_spinlock_threshold_ns.
+ *
+ * The CNA slowpath is selected at boot with "numa_spinlock=on" and shares
+ * the per CPU qnodes with the native one, the extra state lives in the
+ * room reserved for pvqspinlocks.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u16			reserved;
+	u32			encoded_tail;	/* self */
+	u32			sec_tail;	/* secondary queue tail, head only */
+	u32			sec_start;	/* see cna_clock(), head only */
+};
+
+static bool numa_spinlock __initdata;
+static u64 numa_spinlock_threshold_ns __read_mostly = NSEC_PER_MSEC;
+
+/* A ~1us resolution clock, its wraparound is handled by the users */
+static __always_inline u32 cna_clock(void)
+{
+	return (u32)(local_clock() >> 10);
+}
+
+static __always_inline struct cna_node *cna_decode(u32 encoded)
+{
+	return (struct cna_node *)decode_tail(encoded);
+}
+
+static __always_inline struct cna_node *cna_secondary(struct cna_node *cn)
+{
+	u32 locked = (u32)READ_ONCE(cn->mcs.locked);
+
+	return locked > _Q_LOCKED_VAL ? cna_decode(locked) : NULL;
+}
+
+static void __init cna_init_nodes(void)
+{
+	unsigned int cpu;
+	int i;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	for_each_possible_cpu(cpu) {
+		struct cna_node *cn = (struct cna_node *)per_cpu_ptr(&qnodes[0], cpu);
+
+		for (i = 0; i < MAX_NODES; i++, cn = (void *)cn + sizeof(struct qnode)) {
+			cn->numa_node = cpu_to_node(cpu);
+			cn->encoded_tail = encode_tail(cpu, i);
+		}
+	}
+}
+
+/*
+ * Append the primary queue segment [@first, @last] to the secondary queue
+ * of @cn, creating it if needed.
+ */
+static __always_inline void cna_splice_tail(struct cna_node *cn,
+					    struct cna_node *first,
+					    struct cna_node *last)
+{
+	struct cna_node *head = cna_secondary(cn);
+
+	last->mcs.next = NULL;
+
+	if (!head) {
+		first->sec_tail = last->encoded_tail;
+		first->sec_start = cna_clock();
+		cn->mcs.locked = first->encoded_tail;
+		return;
+	}
+
+	cna_decode(head->sec_tail)->mcs.next = &first->mcs;
+	head->sec_tail = last->encoded_tail;
+}
+
+/*
+ * Called by the queue head before it waits for the lock owner, reorder
+ * the queue so that @node->next is the first waiter on our node.
+ */
+static __always_inline u32 cna_wait_head_or_lock(struct qspinlock *lock,
+						 struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct cna_node *head = cna_secondary(cn);
+	struct cna_node *first, *last, *cur;
+	struct mcs_spinlock *next;
+
+	next = READ_ONCE(node->next);
+	if (!next)
+		return 0;
+
+	if (head && (u32)(cna_clock() - head->sec_start) >
+		    (u32)(numa_spinlock_threshold_ns >> 10)) {
+		/* put everybody from the secondary queue back in front */
+		cna_decode(head->sec_tail)->mcs.next = next;
+		node->next = &head->mcs;
+		node->locked = _Q_LOCKED_VAL;
+		lockevent_inc(lock_cna_flush);
+		return 0;
+	}
+
+	first = cur = (struct cna_node *)next;
+	last = NULL;
+	while (cur->numa_node != cn->numa_node) {
+		next = READ_ONCE(cur->mcs.next);
+		if (!next)
+			break;	/* don't move the tail */
+		last = cur;
+		cur = (struct cna_node *)next;
+	}
+
+	if (last && cur->numa_node == cn->numa_node) {
+		cna_splice_tail(cn, first, last);
+		node->next = &cur->mcs;
+		lockevent_inc(lock_cna_reorder);
+	}
+
+	return 0;
+}
+
+/*
+ * The primary queue is empty: make the secondary queue, if any, the
+ * primary one and hand the MCS lock to its head.
+ */
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock,
+					       u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct cna_node *head = cna_secondary((struct cna_node *)node);
+	u32 new;
+
+	if (!head)
+		return atomic_try_cmpxchg_relaxed(&lock->val, &val, _Q_LOCKED_VAL);
+
+	new = head->sec_tail | _Q_LOCKED_VAL;
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val, new))
+		return false;
+
+	arch_mcs_spin_unlock_contended(&head->mcs.locked);
+	return true;
+}
+
+/* Pass the MCS lock along with the secondary queue */
+static __always_inline void cna_mcs_pass_lock(struct mcs_spinlock *node,
+					      struct mcs_spinlock *next)
+{
+	int val = READ_ONCE(node->locked);
+
+	if ((u32)val <= _Q_LOCKED_VAL)
+		val = _Q_LOCKED_VAL;
+
+	smp_store_release(&next->locked, val);
+}
+
+/*
+ * Switch to the CNA slowpath if requested and running natively on a NUMA
+ * machine. Must be called on the boot CPU before any other CPU can take a
+ * spinlock, as the native and CNA slowpaths can't be mixed on a lock.
+ */
+void __init cna_configure_spin_lock_slowpath(void)
+{
+	if (!numa_spinlock || nr_node_ids < 2 ||
+	    pv_ops.lock.queued_spin_lock_slowpath != native_queued_spin_lock_slowpath)
+		return;
+
+	cna_init_nodes();
+	pv_ops.lock.queued_spin_lock_slowpath = __cna_queued_spin_lock_slowpath;
+
+	pr_info("Enabling CNA spinlock, threshold %llu ns\n",
+		numa_spinlock_threshold_ns);
+}
+
+static int __init numa_spinlock_setup(char *str)
+{
+	return kstrtobool(str, &numa_spinlock) ? 0 : 1;
+}
+__setup("numa_spinlock=", numa_spinlock_setup);
+
+static int __init numa_spinlock_threshold_setup(char *str)
+{
+	u64 ns;
+
+	if (kstrtoull(str, 0, &ns) || !ns)
+		return 0;
+
+	numa_spinlock_threshold_ns = ns;
+	return 1;
+}
+__setup("numa_spinlock_threshold_ns=", numa_spinlock_threshold_setup);
@@ -210,6 +210,41 @@ static struct ref_scale_ops srcu_ops = {
 	.name		= "srcu"
 };
 
+// Definitions for SRCU grace-period scan testing.  Each "read section"
+// is an expedited grace period, which is dominated by the scan of the
+// per-CPU counters on large systems.  Use a small loops value, and
+// srcutree.convert_to_big=1 to get the summarized leaf scans.
+DEFINE_STATIC_SRCU(srcu_gp_refctl_scale);
+
+static void srcu_gp_ref_scale_read_section(const int nloops)
+{
+	int i;
+	int idx;
+
+	for (i = nloops; i >= 0; i--) {
+		idx = srcu_read_lock(&srcu_gp_refctl_scale);
+		srcu_read_unlock(&srcu_gp_refctl_scale, idx);
+		synchronize_srcu_expedited(&srcu_gp_refctl_scale);
+	}
+}
+
+static void srcu_gp_ref_scale_delay_section(const int nloops, const int udl, const int ndl)
+{
+	int i;
+
+	for (i = nloops; i >= 0; i--) {
+		synchronize_srcu_expedited(&srcu_gp_refctl_scale);
+		un_delay(udl, ndl);
+	}
+}
+
+static struct ref_scale_ops srcu_gp_ops = {
+	.init		= rcu_sync_scale_init,
+	.readsection	= srcu_gp_ref_scale_read_section,
+	.delaysection	= srcu_gp_ref_scale_delay_section,
+	.name		= "srcu-gp"
+};
+
 #ifdef CONFIG_TASKS_RCU
 
 // Definitions for RCU Tasks ref scale testing: Empty read markers.
@@ -1078,7 +1113,7 @@ ref_scale_init(void)
 	long i;
 	int firsterr = 0;
 	static struct ref_scale_ops *scale_ops[] = {
-		&rcu_ops, &srcu_ops, RCU_TRACE_OPS RCU_TASKS_OPS &refcnt_ops, &rwlock_ops,
+		&rcu_ops, &srcu_ops, &srcu_gp_ops, RCU_TRACE_OPS RCU_TASKS_OPS &refcnt_ops, &rwlock_ops,
 		&rwsem_ops, &lock_ops, &lock_irq_ops, &acqrel_ops, &clock_ops, &jiffies_ops,
 		&typesafe_ref_ops, &typesafe_lock_ops, &typesafe_seqlock_ops,
 	};
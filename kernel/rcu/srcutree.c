@@ -193,6 +193,7 @@ static bool init_srcu_struct_nodes(struct srcu_struct *ssp, gfp_t gfp_flags)
 			snp->srcu_data_have_cbs[i] = 0;
 		}
 		snp->srcu_gp_seq_needed_exp = SRCU_SNP_INIT_SEQ;
+		snp->srcu_readers_dirty = 1; /* Nothing cached yet. */
 		snp->grplo = -1;
 		snp->grphi = -1;
 		if (snp == &ssp->srcu_sup->node[0]) {
@@ -455,6 +456,130 @@ static unsigned long srcu_readers_unlock_idx(struct srcu_struct *ssp, int idx)
 	return sum;
 }
 
+/*
+ * Scan the leaves of the srcu_node tree, valid only once ->srcu_size_state
+ * has reached SRCU_SIZE_BIG.
+ */
+#define srcu_for_each_leaf_node(ssp, snp) \
+	for ((snp) = (ssp)->srcu_sup->level[rcu_num_lvls - 1]; \
+	     (snp) < &(ssp)->srcu_sup->node[rcu_num_nodes]; (snp)++)
+
+/*
+ * Record that the counters of @sdp changed since its leaf srcu_node last
+ * cached their sums.  Called by readers which found ->srcu_reader_seen
+ * clear after updating their counter, and after smp_mb() B for locks.
+ */
+static void srcu_reader_mark(struct srcu_data *sdp)
+{
+	struct srcu_node *snp;
+
+	WRITE_ONCE(sdp->srcu_reader_seen, 1);
+	smp_rmb(); /* Cleared ->srcu_reader_seen implies initialized ->mynode. */
+	snp = READ_ONCE(sdp->mynode);
+	if (snp)
+		WRITE_ONCE(snp->srcu_readers_dirty, 1);
+	smp_mb(); /* Order the above before the critical section, pairs with A. */
+}
+
+/*
+ * Sum the lock (@lock true) or unlock counters of the CPUs of leaf @snp
+ * for both ranks.
+ */
+static void srcu_readers_leaf_sum(struct srcu_struct *ssp, struct srcu_node *snp,
+				  bool lock, unsigned long *sum)
+{
+	int cpu;
+
+	sum[0] = sum[1] = 0;
+	for (cpu = snp->grplo; cpu <= snp->grphi; cpu++) {
+		struct srcu_data *sdp;
+
+		if (!cpu_possible(cpu))
+			continue;
+		sdp = per_cpu_ptr(ssp->sda, cpu);
+		if (lock) {
+			sum[0] += atomic_long_read(&sdp->srcu_lock_count[0]);
+			sum[1] += atomic_long_read(&sdp->srcu_lock_count[1]);
+		} else {
+			sum[0] += atomic_long_read(&sdp->srcu_unlock_count[0]);
+			sum[1] += atomic_long_read(&sdp->srcu_unlock_count[1]);
+		}
+	}
+}
+
+/*
+ * srcu_readers_active_idx_check() for SRCU_SIZE_BIG domains, where each
+ * leaf srcu_node caches the counter sums of its CPUs.  A leaf whose CPUs
+ * ran no reader since it last cached them is skipped instead of rescanned,
+ * so that idle parts of large machines cost one read per leaf.
+ *
+ * A leaf is re-cached by clearing its ->srcu_readers_dirty and its CPUs'
+ * ->srcu_reader_seen, then reading the counters after a full barrier.
+ * A reader whose counter update that read misses finds its CPU's
+ * ->srcu_reader_seen clear and marks the leaf dirty again: for locks,
+ * smp_mb() B and the barrier here make this a store-buffering pattern,
+ * and srcu_reader_mark() orders the mark before the critical section
+ * against A, just like the counters themselves.  Unlocks have no barrier
+ * before the check, so a cached unlock sum may be too low.  That can only
+ * make the readers appear to still be present, in which case every leaf
+ * whose cache was used is marked dirty for the next attempt to rescan.
+ *
+ * Called with ->srcu_gp_mutex held, which serializes the caches.
+ */
+static bool srcu_readers_active_idx_check_leaves(struct srcu_struct *ssp, int idx)
+{
+	unsigned long locks = 0, unlocks = 0;
+	unsigned long sum[2];
+	struct srcu_node *snp;
+	bool cached = false;
+	int cpu;
+
+	srcu_for_each_leaf_node(ssp, snp) {
+		snp->srcu_readers_refresh = false;
+		if (snp->grplo < 0)
+			continue;
+		if (READ_ONCE(snp->srcu_readers_dirty)) {
+			WRITE_ONCE(snp->srcu_readers_dirty, 0);
+			for (cpu = snp->grplo; cpu <= snp->grphi; cpu++)
+				if (cpu_possible(cpu))
+					WRITE_ONCE(per_cpu_ptr(ssp->sda, cpu)->srcu_reader_seen, 0);
+			smp_mb(); /* Clear the marks before reading the counters. */
+			srcu_readers_leaf_sum(ssp, snp, false, snp->srcu_unlock_cache);
+			snp->srcu_readers_refresh = true;
+		} else {
+			cached = true;
+		}
+		unlocks += snp->srcu_unlock_cache[idx];
+	}
+
+	smp_mb(); /* A */  /* See srcu_readers_active_idx_check(). */
+
+	srcu_for_each_leaf_node(ssp, snp) {
+		if (snp->grplo < 0)
+			continue;
+		if (snp->srcu_readers_refresh) {
+			srcu_readers_leaf_sum(ssp, snp, true, snp->srcu_lock_cache);
+			locks += snp->srcu_lock_cache[idx];
+		} else if (READ_ONCE(snp->srcu_readers_dirty)) {
+			/* New readers since the unlock pass, leave it dirty. */
+			srcu_readers_leaf_sum(ssp, snp, true, sum);
+			locks += sum[idx];
+		} else {
+			locks += snp->srcu_lock_cache[idx];
+		}
+	}
+
+	if (locks == unlocks)
+		return true;
+
+	if (cached) {
+		srcu_for_each_leaf_node(ssp, snp)
+			if (!snp->srcu_readers_refresh)
+				WRITE_ONCE(snp->srcu_readers_dirty, 1);
+	}
+	return false;
+}
+
 /*
  * Return true if the number of pre-existing readers is determined to
  * be zero.
@@ -463,6 +588,9 @@ static bool srcu_readers_active_idx_check(struct srcu_struct *ssp, int idx)
 {
 	unsigned long unlocks;
 
+	if (smp_load_acquire(&ssp->srcu_sup->srcu_size_state) == SRCU_SIZE_BIG)
+		return srcu_readers_active_idx_check_leaves(ssp, idx);
+
 	unlocks = srcu_readers_unlock_idx(ssp, idx);
 
 	/*
@@ -714,8 +842,12 @@ int __srcu_read_lock(struct srcu_struct *ssp)
 	int idx;
 
 	idx = READ_ONCE(ssp->srcu_idx) & 0x1;
+	preempt_disable_notrace(); /* Mark the CPU whose counter was updated. */
 	this_cpu_inc(ssp->sda->srcu_lock_count[idx].counter);
 	smp_mb(); /* B */  /* Avoid leaking the critical section. */
+	if (unlikely(!__this_cpu_read(ssp->sda->srcu_reader_seen)))
+		srcu_reader_mark(this_cpu_ptr(ssp->sda));
+	preempt_enable_notrace();
 	return idx;
 }
 EXPORT_SYMBOL_GPL(__srcu_read_lock);
@@ -727,8 +859,13 @@ EXPORT_SYMBOL_GPL(__srcu_read_lock);
  */
 void __srcu_read_unlock(struct srcu_struct *ssp, int idx)
 {
+	struct srcu_data *sdp = raw_cpu_ptr(ssp->sda);
+
 	smp_mb(); /* C */  /* Avoid leaking the critical section. */
 	this_cpu_inc(ssp->sda->srcu_unlock_count[idx].counter);
+	/* Migration or a stale mark only delays the grace period. */
+	if (unlikely(!READ_ONCE(sdp->srcu_reader_seen)))
+		srcu_reader_mark(sdp);
 }
 EXPORT_SYMBOL_GPL(__srcu_read_unlock);
 
@@ -747,6 +884,8 @@ int __srcu_read_lock_nmisafe(struct srcu_struct *ssp)
 	idx = READ_ONCE(ssp->srcu_idx) & 0x1;
 	atomic_long_inc(&sdp->srcu_lock_count[idx]);
 	smp_mb__after_atomic(); /* B */  /* Avoid leaking the critical section. */
+	if (unlikely(!READ_ONCE(sdp->srcu_reader_seen)))
+		srcu_reader_mark(sdp);
 	return idx;
 }
 EXPORT_SYMBOL_GPL(__srcu_read_lock_nmisafe);
@@ -762,6 +901,8 @@ void __srcu_read_unlock_nmisafe(struct srcu_struct *ssp, int idx)
 
 	smp_mb__before_atomic(); /* C */  /* Avoid leaking the critical section. */
 	atomic_long_inc(&sdp->srcu_unlock_count[idx]);
+	if (unlikely(!READ_ONCE(sdp->srcu_reader_seen)))
+		srcu_reader_mark(sdp);
 }
 EXPORT_SYMBOL_GPL(__srcu_read_unlock_nmisafe);
 
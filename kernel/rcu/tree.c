@@ -64,6 +64,8 @@
 #include <linux/mm.h>
 #include <linux/kasan.h>
 #include <linux/context_tracking.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "../time/tick-internal.h"
 
 #include "tree.h"
@@ -2451,6 +2453,44 @@ static bool rcu_do_batch_check_time(long count, long tlimit,
 	       local_clock() >= tlimit;
 }
 
+#ifdef CONFIG_RCU_BATCH_HIST
+/* Account a batch of callback invocations started at @start. */
+static void rcu_batch_hist_record(struct rcu_data *rdp, u64 start)
+{
+	u64 us = (local_clock() - start) / NSEC_PER_USEC;
+	int b = min_t(int, ilog2(us | 1), RCU_BATCH_HIST_BUCKETS - 1);
+
+	WRITE_ONCE(rdp->batch_hist[b], rdp->batch_hist[b] + 1);
+}
+
+static int rcu_batch_hist_show(struct seq_file *m, void *v)
+{
+	int cpu, i;
+
+	seq_puts(m, "# cpu node count[log2(us)]\n");
+	for_each_possible_cpu(cpu) {
+		struct rcu_data *rdp = per_cpu_ptr(&rcu_data, cpu);
+
+		seq_printf(m, "%d %d", cpu, cpu_to_node(cpu));
+		for (i = 0; i < RCU_BATCH_HIST_BUCKETS; i++)
+			seq_printf(m, " %lu", READ_ONCE(rdp->batch_hist[i]));
+		seq_putc(m, '\n');
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rcu_batch_hist);
+
+static int __init rcu_batch_hist_init(void)
+{
+	debugfs_create_file("rcu_batch_hist", 0444, NULL, NULL,
+			    &rcu_batch_hist_fops);
+	return 0;
+}
+late_initcall(rcu_batch_hist_init);
+#else /* #ifdef CONFIG_RCU_BATCH_HIST */
+static void rcu_batch_hist_record(struct rcu_data *rdp, u64 start) { }
+#endif /* #else #ifdef CONFIG_RCU_BATCH_HIST */
+
 /*
  * Invoke any RCU callbacks that have made it to the end of their grace
  * period.  Throttle as specified by rdp->blimit.
@@ -2468,6 +2508,7 @@ static void rcu_do_batch(struct rcu_data *rdp)
 	struct rcu_cblist rcl = RCU_CBLIST_INITIALIZER(rcl);
 	struct rcu_head *rhp;
 	long tlimit = 0;
+	u64 __maybe_unused start = 0;
 
 	/* If no callbacks are ready, just return. */
 	if (!rcu_segcblist_ready_cbs(&rdp->cblist)) {
@@ -2496,6 +2537,14 @@ static void rcu_do_batch(struct rcu_data *rdp)
 	pending = rcu_segcblist_get_seglen(&rdp->cblist, RCU_DONE_TAIL);
 	div = READ_ONCE(rcu_divisor);
 	div = div < 0 ? 7 : div > sizeof(long) * 8 - 2 ? sizeof(long) * 8 - 2 : div;
+	/*
+	 * If this CPU's backlog is large enough to hammer quiescent states,
+	 * the memory is better freed sooner: invoke a larger share of the
+	 * ready callbacks per batch, the time limit below still bounds the
+	 * softirq run.
+	 */
+	if (qovld_calc > 0 && rcu_segcblist_n_cbs(&rdp->cblist) >= qovld_calc)
+		div >>= 1;
 	bl = max(rdp->blimit, pending >> div);
 	if ((in_serving_softirq() || rdp->rcu_cpu_kthread_status == RCU_KTHREAD_RUNNING) &&
 	    (IS_ENABLED(CONFIG_RCU_DOUBLE_CHECK_CB_TIME) || unlikely(bl > 100))) {
@@ -2518,6 +2567,8 @@ static void rcu_do_batch(struct rcu_data *rdp)
 
 	/* Invoke callbacks. */
 	tick_dep_set_task(current, TICK_DEP_BIT_RCU);
+	if (IS_ENABLED(CONFIG_RCU_BATCH_HIST))
+		start = local_clock();
 	rhp = rcu_cblist_dequeue(&rcl);
 
 	for (; rhp; rhp = rcu_cblist_dequeue(&rcl)) {
@@ -2568,6 +2619,7 @@ static void rcu_do_batch(struct rcu_data *rdp)
 
 	rcu_nocb_lock_irqsave(rdp, flags);
 	rdp->n_cbs_invoked += count;
+	rcu_batch_hist_record(rdp, start);
 	trace_rcu_batch_end(rcu_state.name, count, !!rcl.head, need_resched(),
 			    is_idle_task(current), rcu_is_callbacks_kthread(rdp));
 
@@ -3187,12 +3239,14 @@ EXPORT_SYMBOL_GPL(call_rcu);
  * @list: List node. All blocks are linked between each other
  * @gp_snap: Snapshot of RCU state for objects placed to this bulk
  * @nr_records: Number of active pointers in the array
+ * @nr_bytes: Size of the slab objects in the array
  * @records: Array of the kvfree_rcu() pointers
  */
 struct kvfree_rcu_bulk_data {
 	struct list_head list;
 	struct rcu_gp_oldstate gp_snap;
 	unsigned long nr_records;
+	unsigned long nr_bytes;
 	void *records[];
 };
 
@@ -3242,6 +3296,8 @@ struct kfree_rcu_cpu_work {
  * @work_in_progress: Indicates that page_cache_work is running
  * @hrtimer: A hrtimer for scheduling a page_cache_work
  * @nr_bkv_objs: number of allocated objects at @bkvcache.
+ * @pending_bytes: Size of the slab objects queued here and not yet freed,
+ *	including those of in-flight @krw_arr batches.
  *
  * This is a per-CPU structure.  The reason that it is not included in
  * the rcu_data structure is to permit this code to be extracted from
@@ -3271,8 +3327,28 @@ struct kfree_rcu_cpu {
 
 	struct llist_head bkvcache;
 	int nr_bkv_objs;
+	atomic_long_t pending_bytes;
 };
 
+/*
+ * Set by the shrinker to an expedited grace period it started. Until that
+ * grace period completes, kfree_rcu_monitor() only frees what is ready and
+ * re-checks every jiffy instead of handing the objects to a new batch
+ * waiting for a normal grace period.
+ */
+static unsigned long kfree_rcu_shrink_gp = RCU_GET_STATE_COMPLETED;
+
+static bool kfree_rcu_shrink_gp_pending(void)
+{
+	return !poll_state_synchronize_rcu(READ_ONCE(kfree_rcu_shrink_gp));
+}
+
+/* Objects that were not allocated from slab, i.e. vmalloc(), are not counted. */
+static size_t kvfree_rcu_bytes(void *ptr)
+{
+	return is_vmalloc_addr(ptr) ? 0 : ksize(ptr);
+}
+
 static DEFINE_PER_CPU(struct kfree_rcu_cpu, krc) = {
 	.lock = __RAW_SPIN_LOCK_UNLOCKED(krc.lock),
 };
@@ -3379,6 +3455,7 @@ kvfree_rcu_bulk(struct kfree_rcu_cpu *krcp,
 		}
 		rcu_lock_release(&rcu_callback_map);
 	}
+	atomic_long_sub(bnode->nr_bytes, &krcp->pending_bytes);
 
 	raw_spin_lock_irqsave(&krcp->lock, flags);
 	if (put_cached_bnode(krcp, bnode))
@@ -3392,7 +3469,7 @@ kvfree_rcu_bulk(struct kfree_rcu_cpu *krcp,
 }
 
 static void
-kvfree_rcu_list(struct rcu_head *head)
+kvfree_rcu_list(struct kfree_rcu_cpu *krcp, struct rcu_head *head)
 {
 	struct rcu_head *next;
 
@@ -3405,8 +3482,10 @@ kvfree_rcu_list(struct rcu_head *head)
 		rcu_lock_acquire(&rcu_callback_map);
 		trace_rcu_invoke_kvfree_callback(rcu_state.name, head, offset);
 
-		if (!WARN_ON_ONCE(!__is_kvfree_rcu_offset(offset)))
+		if (!WARN_ON_ONCE(!__is_kvfree_rcu_offset(offset))) {
+			atomic_long_sub(kvfree_rcu_bytes(ptr), &krcp->pending_bytes);
 			kvfree(ptr);
+		}
 
 		rcu_lock_release(&rcu_callback_map);
 		cond_resched_tasks_rcu_qs();
@@ -3458,7 +3537,7 @@ static void kfree_rcu_work(struct work_struct *work)
 	 * This list is named "Channel 3".
 	 */
 	if (head && !WARN_ON_ONCE(!poll_state_synchronize_rcu_full(&head_gp_snap)))
-		kvfree_rcu_list(head);
+		kvfree_rcu_list(krcp, head);
 }
 
 static bool
@@ -3501,7 +3580,8 @@ schedule_delayed_monitor_work(struct kfree_rcu_cpu *krcp)
 {
 	long delay, delay_left;
 
-	delay = krc_count(krcp) >= KVFREE_BULK_MAX_ENTR ? 1:KFREE_DRAIN_JIFFIES;
+	delay = krc_count(krcp) >= KVFREE_BULK_MAX_ENTR ||
+		kfree_rcu_shrink_gp_pending() ? 1 : KFREE_DRAIN_JIFFIES;
 	if (delayed_work_pending(&krcp->monitor_work)) {
 		delay_left = krcp->monitor_work.timer.expires - jiffies;
 		if (delay < delay_left)
@@ -3546,7 +3626,7 @@ kvfree_rcu_drain_ready(struct kfree_rcu_cpu *krcp)
 	}
 
 	if (head_ready)
-		kvfree_rcu_list(head_ready);
+		kvfree_rcu_list(krcp, head_ready);
 }
 
 /*
@@ -3562,6 +3642,10 @@ static void kfree_rcu_monitor(struct work_struct *work)
 	// Drain ready for reclaim.
 	kvfree_rcu_drain_ready(krcp);
 
+	// The shrinker asked for an expedited GP, wait for it instead.
+	if (kfree_rcu_shrink_gp_pending())
+		goto out;
+
 	raw_spin_lock_irqsave(&krcp->lock, flags);
 
 	// Attempt to start a new batch.
@@ -3606,6 +3690,7 @@ static void kfree_rcu_monitor(struct work_struct *work)
 
 	raw_spin_unlock_irqrestore(&krcp->lock, flags);
 
+out:
 	// If there is nothing to detach, it means that our job is
 	// successfully done here. In case of having at least one
 	// of the channels that is still busy we should rearm the
@@ -3729,10 +3814,17 @@ add_ptr_to_bulk_krc_lock(struct kfree_rcu_cpu **krcp,
 
 		// Initialize the new block and attach it.
 		bnode->nr_records = 0;
+		bnode->nr_bytes = 0;
 		list_add(&bnode->list, &(*krcp)->bulk_head[idx]);
 	}
 
 	// Finally insert and update the GP for this page.
+	if (!idx) {
+		size_t bytes = ksize(ptr);
+
+		bnode->nr_bytes += bytes;
+		atomic_long_add(bytes, &(*krcp)->pending_bytes);
+	}
 	bnode->records[bnode->nr_records++] = ptr;
 	get_state_synchronize_rcu_full(&bnode->gp_snap);
 	atomic_inc(&(*krcp)->bulk_count[idx]);
@@ -3791,6 +3883,7 @@ void kvfree_call_rcu(struct rcu_head *head, void *ptr)
 		head->next = krcp->head;
 		WRITE_ONCE(krcp->head, head);
 		atomic_inc(&krcp->head_count);
+		atomic_long_add(kvfree_rcu_bytes(ptr), &krcp->pending_bytes);
 
 		// Take a snapshot for this krcp.
 		krcp->head_gp_snap = get_state_synchronize_rcu();
@@ -3848,6 +3941,13 @@ kfree_rcu_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 {
 	int cpu, freed = 0;
 
+	// Memory is tight, so don't leave the objects queued for a normal
+	// grace period. This does not wait, the monitors pick up the objects
+	// as soon as the expedited grace period has completed.
+	if (!kfree_rcu_shrink_gp_pending())
+		WRITE_ONCE(kfree_rcu_shrink_gp,
+			   start_poll_synchronize_rcu_expedited());
+
 	for_each_possible_cpu(cpu) {
 		int count;
 		struct kfree_rcu_cpu *krcp = per_cpu_ptr(&krc, cpu);
@@ -3866,6 +3966,32 @@ kfree_rcu_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 	return freed == 0 ? SHRINK_STOP : freed;
 }
 
+static int param_set_kfree_rcu_pending_bytes(const char *val,
+					     const struct kernel_param *kp)
+{
+	return -EPERM;
+}
+
+static int param_get_kfree_rcu_pending_bytes(char *buffer,
+					     const struct kernel_param *kp)
+{
+	long bytes = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		bytes += atomic_long_read(&per_cpu_ptr(&krc, cpu)->pending_bytes);
+
+	return sprintf(buffer, "%ld\n", max(bytes, 0L));
+}
+
+static const struct kernel_param_ops kfree_rcu_pending_bytes_ops = {
+	.set = param_set_kfree_rcu_pending_bytes,
+	.get = param_get_kfree_rcu_pending_bytes,
+};
+
+// Bytes of slab objects handed to kfree_rcu() and not yet freed.
+module_param_cb(kfree_rcu_pending_bytes, &kfree_rcu_pending_bytes_ops, NULL, 0444);
+
 void __init kfree_rcu_scheduler_running(void)
 {
 	int cpu;
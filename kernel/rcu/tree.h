@@ -175,6 +175,8 @@ struct rcu_snap_record {
 };
 
 /* Per-CPU data for read-copy update. */
+#define RCU_BATCH_HIST_BUCKETS	16
+
 struct rcu_data {
 	/* 1) quiescent-state and grace-period handling : */
 	unsigned long	gp_seq;		/* Track rsp->gp_seq counter. */
@@ -282,6 +284,10 @@ struct rcu_data {
 					    /* the first RCU stall timeout */
 
 	long lazy_len;			/* Length of buffered lazy callbacks. */
+#ifdef CONFIG_RCU_BATCH_HIST
+	unsigned long batch_hist[RCU_BATCH_HIST_BUCKETS];
+					/* rcu_do_batch() durations, log2(us). */
+#endif
 	int cpu;
 };
 
@@ -335,12 +335,91 @@ static bool exp_funnel_lock(unsigned long s)
  * Select the CPUs within the specified rcu_node that the upcoming
  * expedited grace period needs to wait for.
  */
+/*
+ * If non-zero, nohz_full CPUs running in the kernel are not sent an IPI
+ * right away. They are instead given this many milliseconds to report
+ * a quiescent state on their own through their next extended quiescent
+ * state, typically on their return to user mode, and only those which
+ * didn't get one in time are sent the IPI. Capped at one second.
+ */
+static int rcu_exp_nohz_poll_ms;
+module_param(rcu_exp_nohz_poll_ms, int, 0644);
+
+static atomic_long_t rcu_exp_nohz_ipis_avoided;
+
+static int param_set_exp_nohz_ipis_avoided(const char *val,
+					   const struct kernel_param *kp)
+{
+	return -EPERM;
+}
+
+static int param_get_exp_nohz_ipis_avoided(char *buffer,
+					   const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%ld\n",
+		       atomic_long_read(&rcu_exp_nohz_ipis_avoided));
+}
+
+static const struct kernel_param_ops exp_nohz_ipis_avoided_ops = {
+	.set = param_set_exp_nohz_ipis_avoided,
+	.get = param_get_exp_nohz_ipis_avoided,
+};
+module_param_cb(rcu_exp_nohz_ipis_avoided, &exp_nohz_ipis_avoided_ops, NULL, 0444);
+
+/*
+ * Select the nohz_full CPUs of @mask_ipi which are to be polled rather
+ * than sent an IPI.
+ */
+static unsigned long sync_rcu_exp_nohz_poll_mask(struct rcu_node *rnp,
+						 unsigned long mask_ipi)
+{
+	unsigned long mask_poll = 0;
+	int cpu;
+
+	if (!IS_ENABLED(CONFIG_NO_HZ_FULL) || READ_ONCE(rcu_exp_nohz_poll_ms) <= 0)
+		return 0;
+
+	for_each_leaf_node_cpu_mask(rnp, cpu, mask_ipi) {
+		if (tick_nohz_full_cpu(cpu))
+			mask_poll |= per_cpu_ptr(&rcu_data, cpu)->grpmask;
+	}
+	return mask_poll;
+}
+
+/*
+ * Wait for the CPUs of @mask_poll to pass through an extended quiescent
+ * state, returning those that did.
+ */
+static unsigned long sync_rcu_exp_nohz_poll(struct rcu_node *rnp,
+					    unsigned long mask_poll)
+{
+	int ms = min_t(int, READ_ONCE(rcu_exp_nohz_poll_ms), MSEC_PER_SEC);
+	unsigned long deadline = jiffies + msecs_to_jiffies(ms);
+	unsigned long mask_qs = 0;
+	int cpu;
+
+	for (;;) {
+		for_each_leaf_node_cpu_mask(rnp, cpu, mask_poll & ~mask_qs) {
+			struct rcu_data *rdp = per_cpu_ptr(&rcu_data, cpu);
+
+			if (rcu_dynticks_in_eqs_since(rdp, rdp->exp_dynticks_snap))
+				mask_qs |= rdp->grpmask;
+		}
+		if (mask_qs == mask_poll || time_after(jiffies, deadline))
+			break;
+		schedule_timeout_idle(1);
+	}
+	atomic_long_add(hweight_long(mask_qs), &rcu_exp_nohz_ipis_avoided);
+	return mask_qs;
+}
+
 static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 {
 	int cpu;
 	unsigned long flags;
 	unsigned long mask_ofl_test;
 	unsigned long mask_ofl_ipi;
+	unsigned long mask_poll;
 	int ret;
 	struct rcu_node *rnp = container_of(rewp, struct rcu_node, rew);
 
@@ -365,6 +444,8 @@ static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 		}
 	}
 	mask_ofl_ipi = rnp->expmask & ~mask_ofl_test;
+	mask_poll = sync_rcu_exp_nohz_poll_mask(rnp, mask_ofl_ipi);
+	mask_ofl_ipi &= ~mask_poll;
 
 	/*
 	 * Need to wait for any blocked tasks as well.	Note that
@@ -376,6 +457,7 @@ static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 	raw_spin_unlock_irqrestore_rcu_node(rnp, flags);
 
 	/* IPI the remaining CPUs for expedited quiescent state. */
+ipi:
 	for_each_leaf_node_cpu_mask(rnp, cpu, mask_ofl_ipi) {
 		struct rcu_data *rdp = per_cpu_ptr(&rcu_data, cpu);
 		unsigned long mask = rdp->grpmask;
@@ -411,6 +493,15 @@ static void __sync_rcu_exp_select_node_cpus(struct rcu_exp_work *rewp)
 			mask_ofl_test |= mask;
 		raw_spin_unlock_irqrestore_rcu_node(rnp, flags);
 	}
+
+	/* Then give the nohz_full CPUs a chance, IPI those that didn't make it. */
+	if (mask_poll) {
+		mask_ofl_ipi = mask_poll;
+		mask_ofl_test |= sync_rcu_exp_nohz_poll(rnp, mask_poll);
+		mask_ofl_ipi &= ~mask_ofl_test;
+		mask_poll = 0;
+		goto ipi;
+	}
 	/* Report quiescent states for those that went offline. */
 	if (mask_ofl_test)
 		rcu_report_exp_cpu_mult(rnp, mask_ofl_test, false);
@@ -1513,12 +1513,14 @@ static void rcu_spawn_cpu_nocb_kthread(int cpu)
 	rdp_gp = rdp->nocb_gp_rdp;
 	mutex_lock(&rdp_gp->nocb_gp_kthread_mutex);
 	if (!rdp_gp->nocb_gp_kthread) {
-		t = kthread_run(rcu_nocb_gp_kthread, rdp_gp,
-				"rcuog/%d", rdp_gp->cpu);
+		t = kthread_create_on_node(rcu_nocb_gp_kthread, rdp_gp,
+					   cpu_to_node(rdp_gp->cpu),
+					   "rcuog/%d", rdp_gp->cpu);
 		if (WARN_ONCE(IS_ERR(t), "%s: Could not start rcuo GP kthread, OOM is now expected behavior\n", __func__)) {
 			mutex_unlock(&rdp_gp->nocb_gp_kthread_mutex);
 			goto end;
 		}
+		wake_up_process(t);
 		WRITE_ONCE(rdp_gp->nocb_gp_kthread, t);
 		if (kthread_prio)
 			sched_setscheduler_nocheck(t, SCHED_FIFO, &sp);
@@ -1578,7 +1580,13 @@ static void __init rcu_organize_nocb_kthreads(void)
 	 */
 	for_each_possible_cpu(cpu) {
 		rdp = per_cpu_ptr(&rcu_data, cpu);
-		if (rdp->cpu >= nl) {
+		/*
+		 * Don't let a group span NUMA nodes, so that the rcuog
+		 * kthread batching the grace-period waits of a group only
+		 * touches the rcu_data structures of its own node.
+		 */
+		if (rdp->cpu >= nl ||
+		    cpu_to_node(cpu) != cpu_to_node(rdp_gp->cpu)) {
 			/* New GP kthread, set up for CBs & next GP. */
 			gotnocbs = true;
 			nl = DIV_ROUND_UP(rdp->cpu + 1, ls) * ls;
@@ -676,6 +676,9 @@ static void __hrtimer_reprogram(struct hrtimer_cpu_base *cpu_base,
 	if (!hrtimer_hres_active(cpu_base) || cpu_base->hang_detected)
 		return;
 
+#ifdef CONFIG_HIGH_RES_TIMERS
+	cpu_base->nr_reprograms++;
+#endif
 	tick_program_event(expires_next, 1);
 }
 
@@ -852,6 +855,25 @@ static void hrtimer_reprogram(struct hrtimer *timer, bool reprogram)
 	if (expires >= cpu_base->expires_next)
 		return;
 
+	/*
+	 * If the already programmed event is within the slack of this
+	 * timer, the interrupt for it expires this timer as well because
+	 * expiry is checked against the soft expiry time. Don't reprogram
+	 * the clock event device just to fire a bit earlier.
+	 *
+	 * Only for hard timers: soft timers are expired from the softirq
+	 * which is raised based on softirq_expires_next.
+	 */
+	if (!timer->is_soft && hrtimer_hres_active(cpu_base) &&
+	    cpu_base->expires_next != KTIME_MAX &&
+	    ktime_sub(hrtimer_get_softexpires(timer), base->offset) <=
+	    cpu_base->expires_next) {
+#ifdef CONFIG_HIGH_RES_TIMERS
+		cpu_base->nr_coalesced++;
+#endif
+		return;
+	}
+
 	/*
 	 * If the hrtimer interrupt is running, then it will reevaluate the
 	 * clock bases and reprogram the clock event device.
@@ -177,6 +177,14 @@ static inline void timers_update_nohz(void) { }
 
 DECLARE_PER_CPU(struct hrtimer_cpu_base, hrtimer_bases);
 
+struct timer_wheel_stats {
+	unsigned long	nr_expired;
+	u64		run_time;
+	u64		max_run_time;
+};
+
+extern void timer_get_wheel_stats(unsigned int cpu, struct timer_wheel_stats *stats);
+
 extern u64 get_next_timer_interrupt(unsigned long basej, u64 basem);
 u64 timer_base_try_to_set_idle(unsigned long basej, u64 basem, bool *idle);
 void timer_clear_idle(void);
@@ -1546,8 +1546,12 @@ static inline void tick_nohz_irq_enter(void)
 	 * rare case (typically stop machine). So we must make sure we have a
 	 * last resort.
 	 */
-	if (tick_sched_flag_test(ts, TS_FLAG_STOPPED))
+	if (tick_sched_flag_test(ts, TS_FLAG_STOPPED)) {
+		if (tick_nohz_full_cpu(smp_processor_id()) &&
+		    !tick_sched_flag_test(ts, TS_FLAG_INIDLE))
+			trace_tick_nohz_full_interrupt(ktime_to_ns(ktime_sub(now, ts->last_tick)));
 		tick_nohz_update_jiffies(now);
+	}
 }
 
 #else
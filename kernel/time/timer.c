@@ -22,6 +22,7 @@
 #include <linux/export.h>
 #include <linux/interrupt.h>
 #include <linux/percpu.h>
+#include <linux/prefetch.h>
 #include <linux/init.h>
 #include <linux/mm.h>
 #include <linux/swap.h>
@@ -41,6 +42,7 @@
 #include <linux/sched/sysctl.h>
 #include <linux/sched/nohz.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/clock.h>
 #include <linux/slab.h>
 #include <linux/compat.h>
 #include <linux/random.h>
@@ -261,6 +263,10 @@ struct timer_base {
 	bool			next_expiry_recalc;
 	bool			is_idle;
 	bool			timers_pending;
+	/* Expiry statistics for /proc/timer_list, protected by @lock */
+	unsigned long		nr_expired;
+	u64			run_time;
+	u64			max_run_time;
 	DECLARE_BITMAP(pending_map, WHEEL_SIZE);
 	struct hlist_head	vectors[WHEEL_SIZE];
 } ____cacheline_aligned;
@@ -1822,7 +1828,14 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 
 		timer = hlist_entry(head->first, struct timer_list, entry);
 
+		/*
+		 * A busy bucket can hold thousands of timers, start pulling
+		 * in the next one while this one runs.
+		 */
+		prefetch(timer->entry.next);
+
 		base->running_timer = timer;
+		base->nr_expired++;
 		detach_timer(timer, true);
 
 		fn = timer->function;
@@ -2420,16 +2433,46 @@ static inline void __run_timers(struct timer_base *base)
 
 static void __run_timer_base(struct timer_base *base)
 {
+	u64 start, delta;
+
 	if (time_before(jiffies, base->next_expiry))
 		return;
 
 	timer_base_lock_expiry(base);
 	raw_spin_lock_irq(&base->lock);
+	start = local_clock();
 	__run_timers(base);
+	delta = local_clock() - start;
+	base->run_time += delta;
+	if (delta > base->max_run_time)
+		base->max_run_time = delta;
 	raw_spin_unlock_irq(&base->lock);
 	timer_base_unlock_expiry(base);
 }
 
+/**
+ * timer_get_wheel_stats - Sum up the expiry statistics of a CPU's timer bases
+ * @cpu:	The CPU to report on
+ * @stats:	Filled with the number of timers expired, and the total and
+ *		longest time spent expiring timers in one run
+ */
+void timer_get_wheel_stats(unsigned int cpu, struct timer_wheel_stats *stats)
+{
+	unsigned long flags;
+	int i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < NR_BASES; i++) {
+		struct timer_base *base = per_cpu_ptr(&timer_bases[i], cpu);
+
+		raw_spin_lock_irqsave(&base->lock, flags);
+		stats->nr_expired += base->nr_expired;
+		stats->run_time += base->run_time;
+		stats->max_run_time = max(stats->max_run_time, base->max_run_time);
+		raw_spin_unlock_irqrestore(&base->lock, flags);
+	}
+}
+
 static void run_timer_base(int index)
 {
 	struct timer_base *base = this_cpu_ptr(&timer_bases[index]);
@@ -136,10 +136,24 @@ static void print_cpu(struct seq_file *m, int cpu, u64 now)
 	P(nr_retries);
 	P(nr_hangs);
 	P(max_hang_time);
+	P(nr_reprograms);
+	P(nr_coalesced);
 #endif
 #undef P
 #undef P_ns
 
+	{
+		struct timer_wheel_stats ws;
+
+		timer_get_wheel_stats(cpu, &ws);
+		SEQ_printf(m, "  .%-15s: %Lu\n", "wheel_expired",
+			   (unsigned long long)ws.nr_expired);
+		SEQ_printf(m, "  .%-15s: %Lu nsecs\n", "wheel_run_time",
+			   (unsigned long long)ws.run_time);
+		SEQ_printf(m, "  .%-15s: %Lu nsecs\n", "wheel_max_run",
+			   (unsigned long long)ws.max_run_time);
+	}
+
 #ifdef CONFIG_TICK_ONESHOT
 # define P(x) \
 	SEQ_printf(m, "  .%-15s: %Lu\n", #x, \
@@ -260,7 +274,7 @@ static void timer_list_show_tickdevices_header(struct seq_file *m)
 
 static inline void timer_list_header(struct seq_file *m, u64 now)
 {
-	SEQ_printf(m, "Timer List Version: v0.10\n");
+	SEQ_printf(m, "Timer List Version: v0.11\n");
 	SEQ_printf(m, "HRTIMER_MAX_CLOCK_BASES: %d\n", HRTIMER_MAX_CLOCK_BASES);
 	SEQ_printf(m, "now at %Ld nsecs\n", (unsigned long long)now);
 	SEQ_printf(m, "\n");
@@ -26,6 +26,21 @@ EXPORT_SYMBOL(raid6_empty_zero_page);
 struct raid6_calls raid6_call;
 EXPORT_SYMBOL_GPL(raid6_call);
 
+/*
+ * Compute the syndromes of @nr stripes, letting the implementation keep the
+ * vector unit enabled across all of them where it supports that.
+ */
+void raid6_gen_syndrome_batch(int disks, size_t bytes, void ***ptrs, int nr)
+{
+	if (raid6_call.gen_syndrome_batch) {
+		raid6_call.gen_syndrome_batch(disks, bytes, ptrs, nr);
+		return;
+	}
+	while (nr--)
+		raid6_call.gen_syndrome(disks, bytes, *ptrs++);
+}
+EXPORT_SYMBOL_GPL(raid6_gen_syndrome_batch);
+
 const struct raid6_calls * const raid6_algos[] = {
 #if defined(__i386__) && !defined(__arch_um__)
 #ifdef CONFIG_AS_AVX512
@@ -42,6 +57,9 @@ const struct raid6_calls * const raid6_algos[] = {
 	&raid6_mmxx1,
 #endif
 #if defined(__x86_64__) && !defined(__arch_um__)
+#ifdef CONFIG_AS_GFNI
+	&raid6_avx512gfnix2,
+#endif
 #ifdef CONFIG_AS_AVX512
 	&raid6_avx512x4,
 	&raid6_avx512x2,
@@ -96,6 +114,9 @@ EXPORT_SYMBOL_GPL(raid6_datap_recov);
 
 const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #ifdef CONFIG_X86
+#ifdef CONFIG_AS_GFNI
+	&raid6_recov_gfni,
+#endif
 #ifdef CONFIG_AS_AVX512
 	&raid6_recov_avx512,
 #endif
@@ -131,15 +152,51 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #define RAID6_TEST_DISKS	8
 #define RAID6_TEST_DISKS_ORDER	3
 
-static inline const struct raid6_recov_calls *raid6_choose_recov(void)
+/*
+ * With the benchmark enabled, time the two data disk recovery of every
+ * valid algorithm, ties go to the higher priority. This uses the already
+ * selected gen_syndrome(), as the recovery routines do.
+ */
+static inline const struct raid6_recov_calls *raid6_choose_recov(
+	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
 {
+	unsigned long perf, bestperf = 0, j0, j1;
 	const struct raid6_recov_calls *const *algo;
 	const struct raid6_recov_calls *best;
 
-	for (best = NULL, algo = raid6_recov_algos; *algo; algo++)
-		if (!best || (*algo)->priority > best->priority)
-			if (!(*algo)->valid || (*algo)->valid())
+	for (best = NULL, algo = raid6_recov_algos; *algo; algo++) {
+		if ((*algo)->valid && !(*algo)->valid())
+			continue;
+
+		if (!IS_ENABLED(CONFIG_RAID6_PQ_BENCHMARK) ||
+		    !raid6_call.gen_syndrome) {
+			if (!best || (*algo)->priority > best->priority)
 				best = *algo;
+			continue;
+		}
+
+		perf = 0;
+
+		preempt_disable();
+		j0 = jiffies;
+		while ((j1 = jiffies) == j0)
+			cpu_relax();
+		while (time_before(jiffies,
+				   j1 + (1 << RAID6_TIME_JIFFIES_LG2))) {
+			(*algo)->data2(disks, PAGE_SIZE, 0, 1, *dptrs);
+			perf++;
+		}
+		preempt_enable();
+
+		if (!best || perf > bestperf ||
+		    (perf == bestperf && (*algo)->priority > best->priority)) {
+			bestperf = perf;
+			best = *algo;
+		}
+		pr_info("raid6: %-8s recov() %5ld MB/s\n", (*algo)->name,
+			(perf * HZ * 2) >>
+			(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2));
+	}
 
 	if (best) {
 		raid6_2data_recov = best->data2;
@@ -273,7 +330,7 @@ int __init raid6_select_algo(void)
 	gen_best = raid6_choose_gen(&dptrs, disks);
 
 	/* select raid recover functions */
-	rec_best = raid6_choose_recov();
+	rec_best = raid6_choose_recov(&dptrs, disks);
 
 	free_pages((unsigned long)disk_ptr, RAID6_TEST_DISKS_ORDER);
 
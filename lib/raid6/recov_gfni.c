@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * RAID-6 recovery with AVX512 + GFNI
+ *
+ * The multiplications by the P and Q constants are done with GF2P8AFFINEQB
+ * and the bit matrices of these constants, instead of the nibble table
+ * lookups of recov_avx512.c.
+ */
+
+#ifdef CONFIG_AS_GFNI
+
+#include <linux/raid/pq.h>
+#include "x86.h"
+
+static int raid6_has_avx512gfni(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX512F) &&
+		boot_cpu_has(X86_FEATURE_AVX512BW) &&
+		boot_cpu_has(X86_FEATURE_GFNI);
+}
+
+static void raid6_2data_recov_gfni(int disks, size_t bytes, int faila,
+				   int failb, void **ptrs)
+{
+	u8 *p, *q, *dp, *dq;
+	u64 pbmul, qmul;	/* P multiplier for B data, Q multiplier */
+
+	p = (u8 *)ptrs[disks-2];
+	q = (u8 *)ptrs[disks-1];
+
+	/*
+	 * Compute syndrome with zero for the missing data pages
+	 * Use the dead data pages as temporary storage for
+	 * delta p and delta q
+	 */
+
+	dp = (u8 *)ptrs[faila];
+	ptrs[faila] = (void *)raid6_empty_zero_page;
+	ptrs[disks-2] = dp;
+	dq = (u8 *)ptrs[failb];
+	ptrs[failb] = (void *)raid6_empty_zero_page;
+	ptrs[disks-1] = dq;
+
+	raid6_call.gen_syndrome(disks, bytes, ptrs);
+
+	/* Restore pointer table */
+	ptrs[faila]   = dp;
+	ptrs[failb]   = dq;
+	ptrs[disks-2] = p;
+	ptrs[disks-1] = q;
+
+	/* Now, pick the proper matrices */
+	pbmul = raid6_gfni_matrix(raid6_gfexi[failb-faila]);
+	qmul  = raid6_gfni_matrix(raid6_gfinv[raid6_gfexp[faila] ^
+						raid6_gfexp[failb]]);
+
+	kernel_fpu_begin();
+
+	asm volatile("vpbroadcastq %0, %%zmm6\n\t"
+		     "vpbroadcastq %1, %%zmm7"
+		     :
+		     : "m" (pbmul), "m" (qmul));
+
+	while (bytes) {
+		asm volatile("vmovdqa64 %0, %%zmm0\n\t"
+			     "vmovdqa64 %1, %%zmm1\n\t"
+			     "vpxorq %2, %%zmm0, %%zmm0\n\t"
+			     "vpxorq %3, %%zmm1, %%zmm1\n\t"
+			     /* 0 = px, 1 = qx = qmul[q ^ dq] */
+			     "vgf2p8affineqb $0, %%zmm7, %%zmm1, %%zmm1\n\t"
+			     /* 2 = db = pbmul[px] ^ qx */
+			     "vgf2p8affineqb $0, %%zmm6, %%zmm0, %%zmm2\n\t"
+			     "vpxorq %%zmm1, %%zmm2, %%zmm2\n\t"
+			     /* 0 = da = db ^ px */
+			     "vpxorq %%zmm2, %%zmm0, %%zmm0\n\t"
+			     "vmovdqa64 %%zmm2, %3\n\t"
+			     "vmovdqa64 %%zmm0, %2"
+			     :
+			     : "m" (p[0]), "m" (q[0]), "m" (dp[0]),
+			       "m" (dq[0]));
+
+		bytes -= 64;
+		p += 64;
+		q += 64;
+		dp += 64;
+		dq += 64;
+	}
+
+	kernel_fpu_end();
+}
+
+static void raid6_datap_recov_gfni(int disks, size_t bytes, int faila,
+				   void **ptrs)
+{
+	u8 *p, *q, *dq;
+	u64 qmul;		/* Q multiplier */
+
+	p = (u8 *)ptrs[disks-2];
+	q = (u8 *)ptrs[disks-1];
+
+	/*
+	 * Compute syndrome with zero for the missing data page
+	 * Use the dead data page as temporary storage for delta q
+	 */
+
+	dq = (u8 *)ptrs[faila];
+	ptrs[faila] = (void *)raid6_empty_zero_page;
+	ptrs[disks-1] = dq;
+
+	raid6_call.gen_syndrome(disks, bytes, ptrs);
+
+	/* Restore pointer table */
+	ptrs[faila]   = dq;
+	ptrs[disks-1] = q;
+
+	/* Now, pick the proper matrix */
+	qmul = raid6_gfni_matrix(raid6_gfinv[raid6_gfexp[faila]]);
+
+	kernel_fpu_begin();
+
+	asm volatile("vpbroadcastq %0, %%zmm7" : : "m" (qmul));
+
+	while (bytes) {
+		asm volatile("vmovdqa64 %0, %%zmm1\n\t"
+			     "vpxorq %1, %%zmm1, %%zmm1\n\t"
+			     /* 1 = dq = qmul[q ^ dq] */
+			     "vgf2p8affineqb $0, %%zmm7, %%zmm1, %%zmm1\n\t"
+			     "vpxorq %2, %%zmm1, %%zmm0\n\t"
+			     "vmovdqa64 %%zmm1, %1\n\t"
+			     "vmovdqa64 %%zmm0, %2"
+			     :
+			     : "m" (q[0]), "m" (dq[0]), "m" (p[0]));
+
+		bytes -= 64;
+		p += 64;
+		q += 64;
+		dq += 64;
+	}
+
+	kernel_fpu_end();
+}
+
+const struct raid6_recov_calls raid6_recov_gfni = {
+	.data2 = raid6_2data_recov_gfni,
+	.datap = raid6_datap_recov_gfni,
+	.valid = raid6_has_avx512gfni,
+	.name = "avx512gfni",
+	.priority = 4,
+};
+
+#endif /* CONFIG_AS_GFNI */
@@ -71,5 +71,23 @@ static inline int boot_cpu_has(int flag)
 
 #endif /* ndef __KERNEL__ */
 
+/*
+ * The GF2P8AFFINEQB bit matrix multiplying each byte by @c in the RAID-6
+ * field: byte 7 - i of the matrix selects the input bits which make up bit
+ * i of the product.
+ */
+static inline u64 raid6_gfni_matrix(u8 c)
+{
+	u64 matrix = 0;
+	int i, j;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < 8; j++)
+			if (raid6_gfmul[c][1 << j] & (1 << i))
+				matrix |= 1ULL << (8 * (7 - i) + j);
+
+	return matrix;
+}
+
 #endif
 #endif
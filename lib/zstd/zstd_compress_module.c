@@ -9,9 +9,14 @@
  * You may select, at your option, one of the above-listed licenses.
  */
 
+#include <linux/completion.h>
+#include <linux/cpumask.h>
 #include <linux/kernel.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
 #include <linux/zstd.h>
 
 #include "common/zstd_deps.h"
@@ -101,6 +106,158 @@ size_t zstd_compress_cctx(zstd_cctx *cctx, void *dst, size_t dst_capacity,
 }
 EXPORT_SYMBOL(zstd_compress_cctx);
 
+struct zstd_parallel {
+	const void *src;
+	size_t src_size;
+	size_t chunk_size;
+	const zstd_parameters *parameters;
+	size_t workspace_size;
+	unsigned int nr_chunks;
+	atomic_t next_chunk;
+	atomic_t nr_workers;
+	struct completion done;
+	void **bufs;		/* compressed chunks */
+	size_t *sizes;		/* their sizes or errors */
+};
+
+struct zstd_parallel_work {
+	struct work_struct work;
+	struct zstd_parallel *zp;
+};
+
+/* Compress chunks until there are none left, the result is per chunk */
+static void zstd_parallel_compress(struct zstd_parallel *zp)
+{
+	size_t bound = ZSTD_compressBound(zp->chunk_size);
+	void *workspace = kvmalloc(zp->workspace_size, GFP_KERNEL);
+	zstd_cctx *cctx = zstd_init_cctx(workspace, zp->workspace_size);
+	unsigned int i;
+	size_t len;
+
+	while ((i = atomic_inc_return(&zp->next_chunk) - 1) < zp->nr_chunks) {
+		len = min(zp->chunk_size, zp->src_size - i * zp->chunk_size);
+		zp->bufs[i] = kvmalloc(bound, GFP_KERNEL);
+		if (!cctx || !zp->bufs[i]) {
+			zp->sizes[i] = ERROR(memory_allocation);
+			continue;
+		}
+		zp->sizes[i] = zstd_compress_cctx(cctx, zp->bufs[i], bound,
+			zp->src + i * zp->chunk_size, len, zp->parameters);
+	}
+
+	kvfree(workspace);
+	if (atomic_dec_and_test(&zp->nr_workers))
+		complete(&zp->done);
+}
+
+static void zstd_parallel_work_fn(struct work_struct *work)
+{
+	struct zstd_parallel_work *w =
+		container_of(work, struct zstd_parallel_work, work);
+
+	zstd_parallel_compress(w->zp);
+}
+
+size_t zstd_compress_parallel(void *dst, size_t dst_capacity,
+	const void *src, size_t src_size, const zstd_parameters *parameters,
+	size_t chunk_size, unsigned int nr_threads)
+{
+	struct zstd_parallel zp = {
+		.src = src,
+		.src_size = src_size,
+		.chunk_size = chunk_size,
+		.parameters = parameters,
+		.workspace_size = zstd_cctx_workspace_bound(&parameters->cParams),
+	};
+	struct zstd_parallel_work *works = NULL;
+	size_t ret = 0, pos = 0;
+	unsigned int i;
+
+	if (!chunk_size)
+		return ERROR(parameter_outOfBound);
+
+	zp.nr_chunks = max_t(size_t, DIV_ROUND_UP(src_size, chunk_size), 1);
+	if (!nr_threads)
+		nr_threads = num_online_cpus();
+	nr_threads = min(nr_threads, zp.nr_chunks);
+
+	zp.bufs = kvcalloc(zp.nr_chunks, sizeof(*zp.bufs), GFP_KERNEL);
+	zp.sizes = kvcalloc(zp.nr_chunks, sizeof(*zp.sizes), GFP_KERNEL);
+	if (nr_threads > 1)
+		works = kcalloc(nr_threads - 1, sizeof(*works), GFP_KERNEL);
+	if (!zp.bufs || !zp.sizes || (nr_threads > 1 && !works)) {
+		ret = ERROR(memory_allocation);
+		goto out;
+	}
+
+	atomic_set(&zp.next_chunk, 0);
+	atomic_set(&zp.nr_workers, nr_threads);
+	init_completion(&zp.done);
+
+	/* the caller is a worker too, so this makes progress on a busy wq */
+	for (i = 0; i < nr_threads - 1; i++) {
+		works[i].zp = &zp;
+		INIT_WORK(&works[i].work, zstd_parallel_work_fn);
+		queue_work(system_unbound_wq, &works[i].work);
+	}
+	zstd_parallel_compress(&zp);
+	wait_for_completion(&zp.done);
+
+	for (i = 0; i < zp.nr_chunks; i++) {
+		if (ZSTD_isError(zp.sizes[i])) {
+			ret = zp.sizes[i];
+			break;
+		}
+		if (zp.sizes[i] > dst_capacity - pos) {
+			ret = ERROR(dstSize_tooSmall);
+			break;
+		}
+		memcpy(dst + pos, zp.bufs[i], zp.sizes[i]);
+		pos += zp.sizes[i];
+	}
+	if (!ret)
+		ret = pos;
+
+out:
+	if (zp.bufs) {
+		for (i = 0; i < zp.nr_chunks; i++)
+			kvfree(zp.bufs[i]);
+	}
+	kfree(works);
+	kvfree(zp.sizes);
+	kvfree(zp.bufs);
+	return ret;
+}
+EXPORT_SYMBOL(zstd_compress_parallel);
+
+size_t zstd_cdict_workspace_bound(size_t dict_size,
+	const zstd_compression_parameters *cparams)
+{
+	return ZSTD_estimateCDictSize_advanced(dict_size, *cparams,
+		ZSTD_dlm_byRef);
+}
+EXPORT_SYMBOL(zstd_cdict_workspace_bound);
+
+const zstd_cdict *zstd_init_cdict(const void *dict, size_t dict_size,
+	const zstd_compression_parameters *cparams, void *workspace,
+	size_t workspace_size)
+{
+	if (workspace == NULL)
+		return NULL;
+	return ZSTD_initStaticCDict(workspace, workspace_size, dict, dict_size,
+		ZSTD_dlm_byRef, ZSTD_dct_auto, *cparams);
+}
+EXPORT_SYMBOL(zstd_init_cdict);
+
+size_t zstd_compress_using_cdict(zstd_cctx *cctx, void *dst,
+	size_t dst_capacity, const void *src, size_t src_size,
+	const zstd_cdict *cdict, const zstd_frame_parameters *fparams)
+{
+	return ZSTD_compress_usingCDict_advanced(cctx, dst, dst_capacity,
+		src, src_size, cdict, *fparams);
+}
+EXPORT_SYMBOL(zstd_compress_using_cdict);
+
 size_t zstd_cstream_workspace_bound(const zstd_compression_parameters *cparams)
 {
 	return ZSTD_estimateCStreamSize_usingCParams(*cparams);
@@ -456,6 +456,39 @@ static ssize_t strict_limit_show(struct device *dev,
 }
 static DEVICE_ATTR_RW(strict_limit);
 
+static ssize_t ra_history_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int ra_history;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &ra_history);
+	if (ret < 0)
+		return ret;
+	if (ra_history > 1)
+		return -EINVAL;
+
+	spin_lock_bh(&bdi_lock);
+	if (ra_history)
+		bdi->capabilities |= BDI_CAP_RA_HISTORY;
+	else
+		bdi->capabilities &= ~BDI_CAP_RA_HISTORY;
+	spin_unlock_bh(&bdi_lock);
+
+	return count;
+}
+
+static ssize_t ra_history_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%d\n",
+			!!(bdi->capabilities & BDI_CAP_RA_HISTORY));
+}
+static DEVICE_ATTR_RW(ra_history);
+
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
@@ -466,6 +499,7 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_max_bytes.attr,
 	&dev_attr_stable_pages_required.attr,
 	&dev_attr_strict_limit.attr,
+	&dev_attr_ra_history.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(bdi_dev);
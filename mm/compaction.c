@@ -1953,6 +1953,13 @@ static int sysctl_compact_unevictable_allowed __read_mostly = CONFIG_COMPACT_UNE
 static unsigned int __read_mostly sysctl_compaction_proactiveness = 20;
 static int sysctl_extfrag_threshold = 500;
 static int __read_mostly sysctl_compact_memory;
+/*
+ * Number of workers proactive compaction splits each zone between, and the
+ * cap of their combined migration bandwidth in MB/s (0 means no cap).
+ */
+static unsigned int __read_mostly sysctl_compaction_proactive_workers = 1;
+static unsigned int __read_mostly sysctl_compaction_proactive_rate_limit;
+static int compaction_proactive_workers_max = 64;
 
 static inline void
 update_fast_start_pfn(struct compact_control *cc, unsigned long pfn)
@@ -2533,12 +2540,39 @@ compaction_suit_allocation_order(struct zone *zone, unsigned int order,
 	return COMPACT_CONTINUE;
 }
 
+/*
+ * Publish the progress of a parallel proactive compaction worker, and
+ * throttle it if it went over its share of the migration bandwidth.
+ */
+static void compact_range_progress(struct compact_control *cc,
+				   unsigned int nr_migrated)
+{
+	struct compact_range *range = cc->range;
+	unsigned long now = jiffies;
+
+	WRITE_ONCE(range->migrate_pfn, cc->migrate_pfn);
+	WRITE_ONCE(range->free_pfn, cc->free_pfn);
+	WRITE_ONCE(range->nr_migrated, range->nr_migrated + nr_migrated);
+
+	if (!range->rate_limit)
+		return;
+	if (time_after(now, range->rl_start + HZ)) {
+		range->rl_start = now;
+		range->rl_nr = 0;
+	}
+	range->rl_nr += nr_migrated;
+	if (range->rl_nr >= range->rate_limit)
+		schedule_timeout_interruptible(range->rl_start + HZ - now);
+}
+
 static enum compact_result
 compact_zone(struct compact_control *cc, struct capture_control *capc)
 {
 	enum compact_result ret;
-	unsigned long start_pfn = cc->zone->zone_start_pfn;
-	unsigned long end_pfn = zone_end_pfn(cc->zone);
+	unsigned long start_pfn = cc->range ? cc->range->start_pfn :
+					      cc->zone->zone_start_pfn;
+	unsigned long end_pfn = cc->range ? cc->range->end_pfn :
+					    zone_end_pfn(cc->zone);
 	unsigned long last_migrated_pfn;
 	const bool sync = cc->mode != MIGRATE_ASYNC;
 	bool update_cached;
@@ -2674,6 +2708,9 @@ compact_zone(struct compact_control *cc, struct capture_control *capc)
 
 		trace_mm_compaction_migratepages(nr_migratepages, nr_succeeded);
 
+		if (cc->range)
+			compact_range_progress(cc, nr_succeeded);
+
 		/* All pages were either migrated or will be released */
 		cc->nr_migratepages = 0;
 		if (err) {
@@ -2898,6 +2935,108 @@ enum compact_result try_to_compact_pages(gfp_t gfp_mask, unsigned int order,
 	return rc;
 }
 
+/* Smallest part of a zone worth a worker of its own, in pageblocks */
+#define COMPACT_RANGE_MIN_BLOCKS	64
+
+struct compact_ranges {
+	int nr;
+	struct compact_range range[];
+};
+
+/* Ranges of the last parallel proactive compaction of each node */
+static struct compact_ranges *node_compact_ranges[MAX_NUMNODES];
+static DEFINE_MUTEX(compact_ranges_lock);
+
+static void compact_range_work_fn(struct work_struct *work)
+{
+	struct compact_range *range = container_of(work, struct compact_range,
+						   work);
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+		.no_set_skip_hint = true,
+		.whole_zone = true,
+		.gfp_mask = GFP_KERNEL,
+		.proactive_compaction = true,
+		.zone = range->zone,
+		.range = range,
+	};
+
+	compact_zone(&cc, NULL);
+
+	count_compact_events(KCOMPACTD_MIGRATE_SCANNED, cc.total_migrate_scanned);
+	count_compact_events(KCOMPACTD_FREE_SCANNED, cc.total_free_scanned);
+	WRITE_ONCE(range->done, true);
+}
+
+/*
+ * Split the zone into pageblock aligned PFN ranges and compact those in
+ * parallel, each with its own migration and free scanners.  Returns false
+ * if the zone should rather be compacted as a whole.
+ */
+static bool proactive_compact_zone_parallel(struct zone *zone)
+{
+	unsigned long nr = READ_ONCE(sysctl_compaction_proactive_workers);
+	unsigned long rate_limit = READ_ONCE(sysctl_compaction_proactive_rate_limit);
+	unsigned long start_pfn = zone->zone_start_pfn;
+	unsigned long end_pfn = zone_end_pfn(zone);
+	struct compact_ranges *ranges, *old;
+	int nid = zone_to_nid(zone);
+	unsigned long span, pfn;
+	int i;
+
+	nr = min(nr, (end_pfn - start_pfn) /
+		     (pageblock_nr_pages * COMPACT_RANGE_MIN_BLOCKS));
+	if (nr <= 1)
+		return false;
+
+	ranges = kzalloc(struct_size(ranges, range, nr), GFP_KERNEL);
+	if (!ranges)
+		return false;
+
+	ranges->nr = nr;
+	span = DIV_ROUND_UP(end_pfn - start_pfn, nr);
+	/* Share the bandwidth cap evenly between the workers */
+	if (rate_limit)
+		rate_limit = max(1UL, (rate_limit << (20 - PAGE_SHIFT)) / nr);
+
+	for (i = 0, pfn = start_pfn; i < nr; i++) {
+		struct compact_range *range = &ranges->range[i];
+
+		range->zone = zone;
+		range->start_pfn = pfn;
+		if (i == nr - 1)
+			range->end_pfn = end_pfn;
+		else
+			range->end_pfn = min(end_pfn,
+				ALIGN(start_pfn + span * (i + 1),
+				      pageblock_nr_pages));
+		range->migrate_pfn = range->start_pfn;
+		range->free_pfn = range->end_pfn;
+		range->rate_limit = rate_limit;
+		INIT_WORK(&range->work, compact_range_work_fn);
+		pfn = range->end_pfn;
+	}
+
+	mutex_lock(&compact_ranges_lock);
+	old = node_compact_ranges[nid];
+	node_compact_ranges[nid] = ranges;
+	mutex_unlock(&compact_ranges_lock);
+	kfree(old);
+
+	for (i = 0; i < nr; i++) {
+		if (ranges->range[i].start_pfn < ranges->range[i].end_pfn)
+			queue_work(system_unbound_wq, &ranges->range[i].work);
+		else
+			ranges->range[i].done = true;
+	}
+	for (i = 0; i < nr; i++)
+		flush_work(&ranges->range[i].work);
+
+	return true;
+}
+
 /*
  * compact_node() - compact all zones within a node
  * @pgdat: The node page data
@@ -2907,7 +3046,8 @@ enum compact_result try_to_compact_pages(gfp_t gfp_mask, unsigned int order,
  * reaches within proactive compaction thresholds (as determined by the
  * proactiveness tunable), it is possible that the function returns before
  * reaching score targets due to various back-off conditions, such as,
- * contention on per-node or per-zone locks.
+ * contention on per-node or per-zone locks.  Proactive compaction of large
+ * zones is split between sysctl_compaction_proactive_workers workers.
  */
 static int compact_node(pg_data_t *pgdat, bool proactive)
 {
@@ -2932,6 +3072,9 @@ static int compact_node(pg_data_t *pgdat, bool proactive)
 
 		cc.zone = zone;
 
+		if (proactive && proactive_compact_zone_parallel(zone))
+			continue;
+
 		compact_zone(&cc, NULL);
 
 		if (proactive) {
@@ -3028,13 +3171,48 @@ static ssize_t compact_store(struct device *dev,
 }
 static DEVICE_ATTR_WO(compact);
 
+static ssize_t compact_progress_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct compact_ranges *ranges;
+	int i, len = 0;
+
+	mutex_lock(&compact_ranges_lock);
+	ranges = node_compact_ranges[dev->id];
+	for (i = 0; ranges && i < ranges->nr; i++) {
+		struct compact_range *range = &ranges->range[i];
+
+		len += sysfs_emit_at(buf, len,
+			"%s %lu-%lu migrate_pfn %lu free_pfn %lu migrated %lu %s\n",
+			range->zone->name, range->start_pfn, range->end_pfn,
+			READ_ONCE(range->migrate_pfn),
+			READ_ONCE(range->free_pfn),
+			READ_ONCE(range->nr_migrated),
+			READ_ONCE(range->done) ? "done" : "running");
+	}
+	mutex_unlock(&compact_ranges_lock);
+
+	return len;
+}
+static DEVICE_ATTR_RO(compact_progress);
+
 int compaction_register_node(struct node *node)
 {
-	return device_create_file(&node->dev, &dev_attr_compact);
+	int ret;
+
+	ret = device_create_file(&node->dev, &dev_attr_compact);
+	if (ret)
+		return ret;
+
+	ret = device_create_file(&node->dev, &dev_attr_compact_progress);
+	if (ret)
+		device_remove_file(&node->dev, &dev_attr_compact);
+	return ret;
 }
 
 void compaction_unregister_node(struct node *node)
 {
+	device_remove_file(&node->dev, &dev_attr_compact_progress);
 	device_remove_file(&node->dev, &dev_attr_compact);
 }
 #endif /* CONFIG_SYSFS && CONFIG_NUMA */
@@ -3339,6 +3517,22 @@ static struct ctl_table vm_compaction[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_ONE_HUNDRED,
 	},
+	{
+		.procname	= "compaction_proactive_workers",
+		.data		= &sysctl_compaction_proactive_workers,
+		.maxlen		= sizeof(sysctl_compaction_proactive_workers),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &compaction_proactive_workers_max,
+	},
+	{
+		.procname	= "compaction_proactive_rate_limit_MBps",
+		.data		= &sysctl_compaction_proactive_rate_limit,
+		.maxlen		= sizeof(sysctl_compaction_proactive_rate_limit),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	},
 	{
 		.procname	= "extfrag_threshold",
 		.data		= &sysctl_extfrag_threshold,
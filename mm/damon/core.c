@@ -515,10 +515,8 @@ static void damon_destroy_targets(struct damon_ctx *ctx)
 {
 	struct damon_target *t, *next_t;
 
-	if (ctx->ops.cleanup) {
+	if (ctx->ops.cleanup)
 		ctx->ops.cleanup(ctx);
-		return;
-	}
 
 	damon_for_each_target_safe(t, next_t, ctx)
 		damon_destroy_target(t);
@@ -10,7 +10,9 @@
 #include <linux/mmu_notifier.h>
 #include <linux/page_idle.h>
 #include <linux/pagemap.h>
+#include <linux/perf_event.h>
 #include <linux/rmap.h>
+#include <linux/sort.h>
 #include <linux/swap.h>
 
 #include "../internal.h"
@@ -363,6 +365,228 @@ static int damon_pa_scheme_score(struct damon_ctx *context,
 	return DAMOS_MAX_SCORE;
 }
 
+#ifdef CONFIG_DAMON_PADDR_PMU
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_pa_pmu."
+
+/*
+ * Perf event used for taking the access samples.  It should be an event that
+ * reports data addresses, e.g., Intel PEBS memory loads, AMD IBS op or Arm SPE
+ * events.  The last level cache read misses event by default.
+ */
+static unsigned int event_type __read_mostly = PERF_TYPE_HW_CACHE;
+module_param(event_type, uint, 0600);
+
+static unsigned long long event_config __read_mostly =
+	PERF_COUNT_HW_CACHE_LL |
+	(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+module_param(event_config, ullong, 0600);
+
+static unsigned int precise_ip __read_mostly = 2;
+module_param(precise_ip, uint, 0600);
+
+/* Take one sample per this number of events */
+static unsigned long long sample_period __read_mostly = 10007;
+module_param(sample_period, ullong, 0600);
+
+#define DAMON_PA_PMU_NR_SAMPLES	512
+
+/* Written by the overflow handler of the CPU, drained by kdamond */
+struct damon_pa_pmu_buf {
+	unsigned int head;
+	unsigned int tail;
+	unsigned long addrs[DAMON_PA_PMU_NR_SAMPLES];
+};
+
+static DEFINE_MUTEX(damon_pa_pmu_lock);
+/* The context using the events.  Only one context at a time can use those */
+static struct damon_ctx *damon_pa_pmu_ctx;
+static struct damon_pa_pmu_buf __percpu *damon_pa_pmu_bufs;
+static DEFINE_PER_CPU(struct perf_event *, damon_pa_pmu_events);
+static unsigned long *damon_pa_pmu_samples;
+
+static void damon_pa_pmu_overflow(struct perf_event *event,
+		struct perf_sample_data *data, struct pt_regs *regs)
+{
+	struct damon_pa_pmu_buf *buf = this_cpu_ptr(damon_pa_pmu_bufs);
+	unsigned int head = buf->head;
+
+	perf_prepare_sample(data, event, regs);
+	if (!(data->sample_flags & PERF_SAMPLE_PHYS_ADDR) || !data->phys_addr)
+		return;
+
+	/* Drop the sample if kdamond didn't catch up yet */
+	if (head - smp_load_acquire(&buf->tail) >= DAMON_PA_PMU_NR_SAMPLES)
+		return;
+
+	buf->addrs[head % DAMON_PA_PMU_NR_SAMPLES] = data->phys_addr;
+	smp_store_release(&buf->head, head + 1);
+}
+
+static void damon_pa_pmu_release(void)
+{
+	struct perf_event *event;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		event = per_cpu(damon_pa_pmu_events, cpu);
+		if (!event)
+			continue;
+		perf_event_release_kernel(event);
+		per_cpu(damon_pa_pmu_events, cpu) = NULL;
+	}
+	free_percpu(damon_pa_pmu_bufs);
+	damon_pa_pmu_bufs = NULL;
+	kvfree(damon_pa_pmu_samples);
+	damon_pa_pmu_samples = NULL;
+}
+
+static int damon_pa_pmu_create(void)
+{
+	struct perf_event_attr attr = {
+		.type = event_type,
+		.size = sizeof(attr),
+		.config = event_config,
+		.sample_period = sample_period,
+		.sample_type = PERF_SAMPLE_ADDR | PERF_SAMPLE_PHYS_ADDR,
+		.precise_ip = min(precise_ip, 3U),
+	};
+	struct perf_event *event;
+	int cpu, nr_events = 0;
+
+	damon_pa_pmu_bufs = alloc_percpu(struct damon_pa_pmu_buf);
+	damon_pa_pmu_samples = kvmalloc_array(num_possible_cpus(),
+			sizeof(unsigned long) * DAMON_PA_PMU_NR_SAMPLES,
+			GFP_KERNEL);
+	if (!damon_pa_pmu_bufs || !damon_pa_pmu_samples)
+		goto fail;
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		event = perf_event_create_kernel_counter(&attr, cpu, NULL,
+				damon_pa_pmu_overflow, NULL);
+		if (IS_ERR(event))
+			continue;
+		per_cpu(damon_pa_pmu_events, cpu) = event;
+		nr_events++;
+	}
+	cpus_read_unlock();
+
+	if (nr_events)
+		return 0;
+fail:
+	damon_pa_pmu_release();
+	return -ENODEV;
+}
+
+static void damon_pa_pmu_init(struct damon_ctx *ctx)
+{
+	mutex_lock(&damon_pa_pmu_lock);
+	if (damon_pa_pmu_ctx)
+		pr_warn("PMU sampling is already used by another context\n");
+	else if (damon_pa_pmu_create())
+		pr_warn("cannot create PMU sampling events\n");
+	else
+		damon_pa_pmu_ctx = ctx;
+	mutex_unlock(&damon_pa_pmu_lock);
+}
+
+static void damon_pa_pmu_cleanup(struct damon_ctx *ctx)
+{
+	mutex_lock(&damon_pa_pmu_lock);
+	if (damon_pa_pmu_ctx == ctx) {
+		damon_pa_pmu_release();
+		damon_pa_pmu_ctx = NULL;
+	}
+	mutex_unlock(&damon_pa_pmu_lock);
+}
+
+static int damon_pa_pmu_cmp(const void *a, const void *b)
+{
+	unsigned long l = *(const unsigned long *)a;
+	unsigned long r = *(const unsigned long *)b;
+
+	return l < r ? -1 : l > r;
+}
+
+/* Move the samples taken since the last call into damon_pa_pmu_samples */
+static unsigned int damon_pa_pmu_drain(void)
+{
+	struct damon_pa_pmu_buf *buf;
+	unsigned int head, tail, nr = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		buf = per_cpu_ptr(damon_pa_pmu_bufs, cpu);
+		head = smp_load_acquire(&buf->head);
+		for (tail = buf->tail; tail != head; tail++)
+			damon_pa_pmu_samples[nr++] =
+				buf->addrs[tail % DAMON_PA_PMU_NR_SAMPLES];
+		smp_store_release(&buf->tail, tail);
+	}
+	sort(damon_pa_pmu_samples, nr, sizeof(*damon_pa_pmu_samples),
+			damon_pa_pmu_cmp, NULL);
+	return nr;
+}
+
+/*
+ * A region is regarded as accessed in the last sampling interval if any of
+ * the hardware samples taken during the interval falls in it.  Unlike
+ * damon_pa_check_accesses(), no page table is touched.
+ */
+static unsigned int damon_pa_pmu_check_accesses(struct damon_ctx *ctx)
+{
+	struct damon_target *t;
+	struct damon_region *r;
+	unsigned int max_nr_accesses = 0;
+	unsigned int i, nr = 0;
+	bool accessed;
+
+	if (READ_ONCE(damon_pa_pmu_ctx) == ctx)
+		nr = damon_pa_pmu_drain();
+
+	damon_for_each_target(t, ctx) {
+		i = 0;
+		damon_for_each_region(r, t) {
+			while (i < nr && damon_pa_pmu_samples[i] < r->ar.start)
+				i++;
+			accessed = i < nr && damon_pa_pmu_samples[i] < r->ar.end;
+			damon_update_region_access_rate(r, accessed, &ctx->attrs);
+			max_nr_accesses = max(r->nr_accesses, max_nr_accesses);
+		}
+	}
+
+	return max_nr_accesses;
+}
+
+static int __init damon_pa_pmu_register(void)
+{
+	struct damon_operations ops = {
+		.id = DAMON_OPS_PADDR_PMU,
+		.init = damon_pa_pmu_init,
+		.update = NULL,
+		.prepare_access_checks = NULL,
+		.check_accesses = damon_pa_pmu_check_accesses,
+		.reset_aggregated = NULL,
+		.target_valid = NULL,
+		.cleanup = damon_pa_pmu_cleanup,
+		.apply_scheme = damon_pa_apply_scheme,
+		.get_scheme_score = damon_pa_scheme_score,
+	};
+
+	return damon_register_ops(&ops);
+}
+#else
+static inline int damon_pa_pmu_register(void)
+{
+	return 0;
+}
+#endif	/* CONFIG_DAMON_PADDR_PMU */
+
 static int __init damon_pa_initcall(void)
 {
 	struct damon_operations ops = {
@@ -377,8 +601,12 @@ static int __init damon_pa_initcall(void)
 		.apply_scheme = damon_pa_apply_scheme,
 		.get_scheme_score = damon_pa_scheme_score,
 	};
+	int err;
 
-	return damon_register_ops(&ops);
+	err = damon_register_ops(&ops);
+	if (err)
+		return err;
+	return damon_pa_pmu_register();
 };
 
 subsys_initcall(damon_pa_initcall);
@@ -17,6 +17,11 @@
  * least 'size' bytes.  Free blocks are tracked in an unsorted singly-linked
  * list of free blocks across all pages.  Used blocks aren't tracked, but we
  * keep a count of how many are currently allocated from each page.
+ *
+ * To keep pool->lock off the fast path, each CPU also holds a small magazine
+ * of free blocks.  Allocations and frees are served from it with interrupts
+ * disabled, and only move blocks to and from the shared list in batches.
+ * Blocks in a magazine are still counted in nr_active.
  */
 
 #include <linux/device.h>
@@ -26,6 +31,7 @@
 #include <linux/list.h>
 #include <linux/export.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
 #include <linux/poison.h>
 #include <linux/sched.h>
 #include <linux/sched/mm.h>
@@ -40,11 +46,20 @@
 #define DMAPOOL_DEBUG 1
 #endif
 
+/* bytes of blocks a CPU may keep to itself, and an upper bound in blocks */
+#define DMAPOOL_CPU_BYTES	(2 * PAGE_SIZE)
+#define DMAPOOL_CPU_MAX		32
+
 struct dma_block {
 	struct dma_block *next_block;
 	dma_addr_t dma;
 };
 
+struct dma_pool_cpu {		/* per-CPU magazine of free blocks */
+	struct dma_block *next_block;
+	unsigned int count;
+};
+
 struct dma_pool {		/* the pool */
 	struct list_head page_list;
 	spinlock_t lock;
@@ -52,6 +67,9 @@ struct dma_pool {		/* the pool */
 	size_t nr_blocks;
 	size_t nr_active;
 	size_t nr_pages;
+	struct dma_pool_cpu __percpu *cpu_cache;
+	unsigned int cpu_limit;
+	unsigned int cpu_batch;
 	struct device *dev;
 	unsigned int size;
 	unsigned int allocation;
@@ -69,6 +87,18 @@ struct dma_page {		/* cacheable header for 'allocation' bytes */
 static DEFINE_MUTEX(pools_lock);
 static DEFINE_MUTEX(pools_reg_lock);
 
+static size_t pool_cpu_cached(struct dma_pool *pool)
+{
+	size_t cached = 0;
+	int cpu;
+
+	if (!pool->cpu_cache)
+		return 0;
+	for_each_possible_cpu(cpu)
+		cached += READ_ONCE(per_cpu_ptr(pool->cpu_cache, cpu)->count);
+	return cached;
+}
+
 static ssize_t pools_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
 	struct dma_pool *pool;
@@ -80,7 +110,8 @@ static ssize_t pools_show(struct device *dev, struct device_attribute *attr, cha
 	list_for_each_entry(pool, &dev->dma_pools, pools) {
 		/* per-pool info, no real statistics yet */
 		size += sysfs_emit_at(buf, size, "%-16s %4zu %4zu %4u %2zu\n",
-				      pool->name, pool->nr_active,
+				      pool->name,
+				      pool->nr_active - pool_cpu_cached(pool),
 				      pool->nr_blocks, pool->size,
 				      pool->nr_pages);
 	}
@@ -197,6 +228,108 @@ static void pool_block_push(struct dma_pool *pool, struct dma_block *block,
 	pool->next_block = block;
 }
 
+/*
+ * Take a block from this CPU's magazine, or return NULL if the pool has none
+ * or it is empty.
+ */
+static struct dma_block *pool_cpu_pop(struct dma_pool *pool)
+{
+	struct dma_block *block;
+	struct dma_pool_cpu *c;
+	unsigned long flags;
+
+	if (!pool->cpu_cache)
+		return NULL;
+
+	local_irq_save(flags);
+	c = this_cpu_ptr(pool->cpu_cache);
+	block = c->next_block;
+	if (block) {
+		c->next_block = block->next_block;
+		c->count--;
+	}
+	local_irq_restore(flags);
+	return block;
+}
+
+/*
+ * Move up to a batch of blocks from the shared list to this CPU's magazine.
+ * Called with pool->lock held and interrupts disabled.
+ */
+static void pool_cpu_refill(struct dma_pool *pool)
+{
+	struct dma_block *block;
+	struct dma_pool_cpu *c;
+
+	if (!pool->cpu_cache)
+		return;
+
+	c = this_cpu_ptr(pool->cpu_cache);
+	while (c->count < pool->cpu_batch) {
+		block = pool_block_pop(pool);
+		if (!block)
+			break;
+		block->next_block = c->next_block;
+		c->next_block = block;
+		c->count++;
+	}
+}
+
+/*
+ * Put a block in this CPU's magazine.  A full magazine first hands its oldest
+ * batch back to the shared list.
+ */
+static void pool_cpu_push(struct dma_pool *pool, struct dma_block *block,
+			  dma_addr_t dma)
+{
+	struct dma_block *first = NULL, *last;
+	struct dma_pool_cpu *c;
+	unsigned long flags;
+	unsigned int i;
+
+	local_irq_save(flags);
+	c = this_cpu_ptr(pool->cpu_cache);
+	if (c->count >= pool->cpu_limit) {
+		first = last = c->next_block;
+		for (i = 1; i < pool->cpu_batch; i++)
+			last = last->next_block;
+		c->next_block = last->next_block;
+		c->count -= pool->cpu_batch;
+	}
+
+	block->dma = dma;
+	block->next_block = c->next_block;
+	c->next_block = block;
+	c->count++;
+
+	if (first) {
+		spin_lock(&pool->lock);
+		last->next_block = pool->next_block;
+		pool->next_block = first;
+		pool->nr_active -= pool->cpu_batch;
+		spin_unlock(&pool->lock);
+	}
+	local_irq_restore(flags);
+}
+
+/* Give every magazine back to the shared list, the pool must be idle */
+static void pool_cpu_drain(struct dma_pool *pool)
+{
+	struct dma_block *block;
+	struct dma_pool_cpu *c;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		c = per_cpu_ptr(pool->cpu_cache, cpu);
+		while ((block = c->next_block)) {
+			c->next_block = block->next_block;
+			pool_block_push(pool, block, block->dma);
+			pool->nr_active--;
+		}
+		c->count = 0;
+	}
+}
+
 
 /**
  * dma_pool_create - Creates a pool of consistent memory blocks, for dma.
@@ -266,6 +399,17 @@ struct dma_pool *dma_pool_create(const char *name, struct device *dev,
 	retval->allocation = allocation;
 	INIT_LIST_HEAD(&retval->pools);
 
+	/*
+	 * The debug checks need every free block on the shared list, and big
+	 * blocks would pin too much memory per CPU, so those pools go without
+	 * magazines.  So does a pool whose magazines can't be allocated.
+	 */
+	retval->cpu_limit = min_t(size_t, DMAPOOL_CPU_BYTES / size,
+				  DMAPOOL_CPU_MAX);
+	retval->cpu_batch = retval->cpu_limit / 2;
+	if (!IS_ENABLED(DMAPOOL_DEBUG) && retval->cpu_batch)
+		retval->cpu_cache = alloc_percpu(struct dma_pool_cpu);
+
 	/*
 	 * pools_lock ensures that the ->dma_pools list does not get corrupted.
 	 * pools_reg_lock ensures that there is not a race between
@@ -288,6 +432,7 @@ struct dma_pool *dma_pool_create(const char *name, struct device *dev,
 			list_del(&retval->pools);
 			mutex_unlock(&pools_lock);
 			mutex_unlock(&pools_reg_lock);
+			free_percpu(retval->cpu_cache);
 			kfree(retval);
 			return NULL;
 		}
@@ -374,6 +519,11 @@ void dma_pool_destroy(struct dma_pool *pool)
 		device_remove_file(pool->dev, &dev_attr_pools);
 	mutex_unlock(&pools_reg_lock);
 
+	if (pool->cpu_cache) {
+		pool_cpu_drain(pool);
+		free_percpu(pool->cpu_cache);
+	}
+
 	if (pool->nr_active) {
 		dev_err(pool->dev, "%s %s busy\n", __func__, pool->name);
 		busy = true;
@@ -410,6 +560,10 @@ void *dma_pool_alloc(struct dma_pool *pool, gfp_t mem_flags,
 
 	might_alloc(mem_flags);
 
+	block = pool_cpu_pop(pool);
+	if (block)
+		goto out;
+
 	spin_lock_irqsave(&pool->lock, flags);
 	block = pool_block_pop(pool);
 	if (!block) {
@@ -427,8 +581,10 @@ void *dma_pool_alloc(struct dma_pool *pool, gfp_t mem_flags,
 		pool_initialise_page(pool, page);
 		block = pool_block_pop(pool);
 	}
+	pool_cpu_refill(pool);
 	spin_unlock_irqrestore(&pool->lock, flags);
 
+out:
 	*handle = block->dma;
 	pool_check_block(pool, block, mem_flags);
 	if (want_init_on_alloc(mem_flags))
@@ -452,6 +608,13 @@ void dma_pool_free(struct dma_pool *pool, void *vaddr, dma_addr_t dma)
 	struct dma_block *block = vaddr;
 	unsigned long flags;
 
+	/* without DMAPOOL_DEBUG this only scrubs the block, no lock needed */
+	if (pool->cpu_cache) {
+		pool_block_err(pool, vaddr, dma);
+		pool_cpu_push(pool, block, dma);
+		return;
+	}
+
 	spin_lock_irqsave(&pool->lock, flags);
 	if (!pool_block_err(pool, vaddr, dma)) {
 		pool_block_push(pool, block, dma);
@@ -1,12 +1,17 @@
+#include <linux/completion.h>
+#include <linux/cpumask.h>
 #include <linux/device.h>
 #include <linux/dma-map-ops.h>
 #include <linux/dma-mapping.h>
 #include <linux/dmapool.h>
 #include <linux/kernel.h>
+#include <linux/kthread.h>
 #include <linux/ktime.h>
 #include <linux/module.h>
 
 #define NR_TESTS (100)
+#define NR_SCALE_LOOPS (8192)
+#define SCALE_BATCH (16)
 
 struct dma_pool_pair {
 	dma_addr_t dma;
@@ -28,6 +33,11 @@ static const struct dmapool_parms pool_parms[] = {
 	{ .size = 68, .align = 32, .boundary = 4096 },
 };
 
+struct dmapool_thread {
+	struct completion done;
+	int ret;
+};
+
 static struct dma_pool *pool;
 static struct device test_dev;
 static u64 dma_mask;
@@ -98,6 +108,82 @@ static int dmapool_test_block(const struct dmapool_parms *parms)
 	return ret;
 }
 
+static int dmapool_scale_fn(void *data)
+{
+	struct dma_pool_pair p[SCALE_BATCH];
+	struct dmapool_thread *t = data;
+	int i;
+
+	for (i = 0; i < NR_SCALE_LOOPS; i++) {
+		t->ret = dmapool_test_alloc(p, SCALE_BATCH);
+		if (t->ret)
+			break;
+		if (need_resched())
+			cond_resched();
+	}
+
+	complete(&t->done);
+	return 0;
+}
+
+/*
+ * Allocate and free from one shared pool on 1, 2, 4, ... online CPUs at once,
+ * to see how alloc/free scales with the number of CPUs hitting the pool.
+ */
+static int dmapool_test_scale(const struct dmapool_parms *parms)
+{
+	unsigned int n, i, nr_cpus = num_online_cpus();
+	ktime_t start_time, end_time;
+	struct dmapool_thread *t;
+	struct task_struct *task;
+	int ret = 0;
+
+	t = kcalloc(nr_cpus, sizeof(*t), GFP_KERNEL);
+	if (!t)
+		return -ENOMEM;
+
+	pool = dma_pool_create("test pool", &test_dev, parms->size,
+			       parms->align, parms->boundary);
+	if (!pool) {
+		ret = -ENOMEM;
+		goto free_threads;
+	}
+
+	for (n = 1; n <= nr_cpus && !ret; n *= 2) {
+		for (i = 0; i < n; i++)
+			init_completion(&t[i].done);
+
+		start_time = ktime_get();
+		for (i = 0; i < n; i++) {
+			task = kthread_create(dmapool_scale_fn, &t[i],
+					      "dmapool_test/%u", i);
+			if (IS_ERR(task)) {
+				t[i].ret = PTR_ERR(task);
+				complete(&t[i].done);
+				continue;
+			}
+			kthread_bind(task, cpumask_nth(i, cpu_online_mask));
+			wake_up_process(task);
+		}
+		for (i = 0; i < n; i++) {
+			wait_for_completion(&t[i].done);
+			if (t[i].ret)
+				ret = t[i].ret;
+		}
+		end_time = ktime_get();
+
+		printk("dmapool scale: size:%-4zu align:%-4zu cpus:%-4u ops:%-8u time:%llu\n",
+			parms->size, parms->align, n,
+			n * NR_SCALE_LOOPS * SCALE_BATCH,
+			ktime_us_delta(end_time, start_time));
+	}
+
+	dma_pool_destroy(pool);
+free_threads:
+	kfree(t);
+	return ret;
+}
+
 static void dmapool_test_release(struct device *dev)
 {
 }
@@ -131,6 +217,9 @@ static int dmapool_checks(void)
 			break;
 	}
 
+	for (i = 0; !ret && i < ARRAY_SIZE(pool_parms); i++)
+		ret = dmapool_test_scale(&pool_parms[i]);
+
 del_device:
 	device_del(&test_dev);
 put_device:
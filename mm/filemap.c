@@ -2325,6 +2325,9 @@ static void filemap_get_read_batch(struct address_space *mapping,
 			break;
 		if (folio_test_readahead(folio))
 			break;
+		/* Don't walk the tree past a large folio covering the range */
+		if (folio_next_index(folio) > max)
+			break;
 		xas_advance(&xas, folio_next_index(folio) - 1);
 		continue;
 put_folio:
@@ -2685,9 +2688,13 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 			}
 		}
 put_folios:
-		for (i = 0; i < folio_batch_count(&fbatch); i++)
-			folio_put(fbatch.folios[i]);
-		folio_batch_init(&fbatch);
+		/*
+		 * Drop the whole batch at once: folios_put() only takes
+		 * the lruvec lock and uncharges once for any folios whose
+		 * last reference goes away here, e.g. after a racing
+		 * truncate.
+		 */
+		folios_put(&fbatch);
 	} while (iov_iter_count(iter) && iocb->ki_pos < isize && !error);
 
 	file_accessed(filp);
@@ -2808,22 +2815,31 @@ generic_file_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 EXPORT_SYMBOL(generic_file_read_iter);
 
 /*
- * Splice subpages from a folio into a pipe.
+ * Splice a folio, or its subpages for highmem, into a pipe.
  */
 size_t splice_folio_into_pipe(struct pipe_inode_info *pipe,
 			      struct folio *folio, loff_t fpos, size_t size)
 {
 	struct page *page;
 	size_t spliced = 0, offset = offset_in_folio(folio, fpos);
+	size_t chunk = PAGE_SIZE;
 
 	page = folio_page(folio, offset / PAGE_SIZE);
 	size = min(size, folio_size(folio) - offset);
 	offset %= PAGE_SIZE;
 
+	/*
+	 * Lowmem folios go into a single buffer, so that large folios cost one
+	 * slot and one reference. Highmem ones are split into pages as pipe
+	 * buffer users may kmap() beyond the first page.
+	 */
+	if (!folio_test_highmem(folio))
+		chunk = offset + size;
+
 	while (spliced < size &&
 	       !pipe_full(pipe->head, pipe->tail, pipe->max_usage)) {
 		struct pipe_buffer *buf = pipe_head_buf(pipe);
-		size_t part = min_t(size_t, PAGE_SIZE - offset, size - spliced);
+		size_t part = min_t(size_t, chunk - offset, size - spliced);
 
 		*buf = (struct pipe_buffer) {
 			.ops	= &page_cache_pipe_buf_ops,
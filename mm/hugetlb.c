@@ -36,6 +36,8 @@
 #include <linux/memory.h>
 #include <linux/mm_inline.h>
 #include <linux/padata.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
 
 #include <asm/page.h>
 #include <asm/pgalloc.h>
@@ -1315,31 +1317,72 @@ static void enqueue_hugetlb_folio(struct hstate *h, struct folio *folio)
 	lockdep_assert_held(&hugetlb_lock);
 	VM_BUG_ON_FOLIO(folio_ref_count(folio), folio);
 
-	list_move(&folio->lru, &h->hugepage_freelists[nid]);
+	/*
+	 * Pre-zeroed folios are kept at the tail of the free lists, so that
+	 * allocations that do not need zeroed memory consume them last.
+	 */
+	if (folio_test_hugetlb_zeroed(folio))
+		list_move_tail(&folio->lru, &h->hugepage_freelists[nid]);
+	else
+		list_move(&folio->lru, &h->hugepage_freelists[nid]);
 	h->free_huge_pages++;
 	h->free_huge_pages_node[nid]++;
 	folio_set_hugetlb_freed(folio);
 }
 
+static void __dequeue_hugetlb_folio(struct hstate *h, struct folio *folio)
+{
+	int nid = folio_nid(folio);
+
+	lockdep_assert_held(&hugetlb_lock);
+	list_move(&folio->lru, &h->hugepage_activelist);
+	folio_ref_unfreeze(folio, 1);
+	folio_clear_hugetlb_freed(folio);
+	h->free_huge_pages--;
+	h->free_huge_pages_node[nid]--;
+}
+
+static bool dequeue_hugetlb_folio_suitable(struct folio *folio, bool pin)
+{
+	if (pin && !folio_is_longterm_pinnable(folio))
+		return false;
+
+	return !folio_test_hwpoison(folio);
+}
+
+/*
+ * @zeroed is only a preference: callers asking for it will get a pre-zeroed
+ * folio if one is available on @nid, any other folio otherwise.  The zeroed
+ * state of the returned folio is only kept for those callers, so that
+ * hugetlb_zero_folio() can skip clearing it.
+ */
 static struct folio *dequeue_hugetlb_folio_node_exact(struct hstate *h,
-								int nid)
+							int nid, bool zeroed)
 {
 	struct folio *folio;
 	bool pin = !!(current->flags & PF_MEMALLOC_PIN);
 
 	lockdep_assert_held(&hugetlb_lock);
-	list_for_each_entry(folio, &h->hugepage_freelists[nid], lru) {
-		if (pin && !folio_is_longterm_pinnable(folio))
-			continue;
+	if (zeroed) {
+		list_for_each_entry_reverse(folio, &h->hugepage_freelists[nid],
+					    lru) {
+			if (!folio_test_hugetlb_zeroed(folio))
+				break;
+			if (!dequeue_hugetlb_folio_suitable(folio, pin))
+				continue;
+
+			__dequeue_hugetlb_folio(h, folio);
+			return folio;
+		}
+	}
 
-		if (folio_test_hwpoison(folio))
+	list_for_each_entry(folio, &h->hugepage_freelists[nid], lru) {
+		if (!dequeue_hugetlb_folio_suitable(folio, pin))
 			continue;
 
-		list_move(&folio->lru, &h->hugepage_activelist);
-		folio_ref_unfreeze(folio, 1);
-		folio_clear_hugetlb_freed(folio);
-		h->free_huge_pages--;
-		h->free_huge_pages_node[nid]--;
+		__dequeue_hugetlb_folio(h, folio);
+		if (!zeroed)
+			folio_clear_hugetlb_zeroed(folio);
 		return folio;
 	}
 
@@ -1372,7 +1415,8 @@ static struct folio *dequeue_hugetlb_folio_nodemask(struct hstate *h, gfp_t gfp_
 			continue;
 		node = zone_to_nid(zone);
 
-		folio = dequeue_hugetlb_folio_node_exact(h, node);
+		folio = dequeue_hugetlb_folio_node_exact(h, node,
+							 !!(gfp_mask & __GFP_ZERO));
 		if (folio)
 			return folio;
 	}
@@ -1413,8 +1457,9 @@ static struct folio *dequeue_hugetlb_folio_vma(struct hstate *h,
 	gfp_mask = htlb_alloc_mask(h);
 	nid = huge_node(vma, address, gfp_mask, &mpol, &nodemask);
 
+	/* Pages for vma are cleared before use, prefer pre-zeroed ones */
 	if (mpol_is_preferred_many(mpol)) {
-		folio = dequeue_hugetlb_folio_nodemask(h, gfp_mask,
+		folio = dequeue_hugetlb_folio_nodemask(h, gfp_mask | __GFP_ZERO,
 							nid, nodemask);
 
 		/* Fallback to all nodes if page==NULL */
@@ -1422,7 +1467,7 @@ static struct folio *dequeue_hugetlb_folio_vma(struct hstate *h,
 	}
 
 	if (!folio)
-		folio = dequeue_hugetlb_folio_nodemask(h, gfp_mask,
+		folio = dequeue_hugetlb_folio_nodemask(h, gfp_mask | __GFP_ZERO,
 							nid, nodemask);
 
 	if (folio && !avoid_reserve && vma_has_reserves(vma, chg)) {
@@ -1963,6 +2008,142 @@ struct hstate *size_to_hstate(unsigned long size)
 	return NULL;
 }
 
+/*
+ * Pre-zeroing of free huge pages.
+ *
+ * When enabled for an hstate, a low priority kernel thread clears free
+ * huge pages in the background, so that hugetlb faults can skip the
+ * clearing that otherwise dominates their latency.  Only pages in excess
+ * of the reserves are taken off the free lists while being cleared, so a
+ * reservation can always be satisfied, whether or not the page it gets
+ * has been cleared.
+ */
+static struct task_struct *hugetlb_zerod_thread;
+static DEFINE_MUTEX(hugetlb_zerod_mutex);
+static DECLARE_WAIT_QUEUE_HEAD(hugetlb_zerod_wait);
+static bool hugetlb_zerod_kick;
+
+static void hugetlb_zerod_wakeup(void)
+{
+	if (!READ_ONCE(hugetlb_zerod_kick)) {
+		WRITE_ONCE(hugetlb_zerod_kick, true);
+		wake_up_interruptible(&hugetlb_zerod_wait);
+	}
+}
+
+/*
+ * Clear one free folio of hstate @h that has not been pre-zeroed yet.
+ * Returns false if there is no such folio.
+ */
+static bool hugetlb_zero_one(struct hstate *h)
+{
+	struct folio *folio = NULL, *iter;
+	int nid;
+
+	spin_lock_irq(&hugetlb_lock);
+	if (!available_huge_pages(h))
+		goto out_unlock;
+
+	for_each_node_state(nid, N_MEMORY) {
+		/* Pre-zeroed folios are at the tail, stop at the first one */
+		list_for_each_entry(iter, &h->hugepage_freelists[nid], lru) {
+			if (folio_test_hugetlb_zeroed(iter))
+				break;
+			if (folio_test_hwpoison(iter))
+				continue;
+			folio = iter;
+			break;
+		}
+		if (folio)
+			break;
+	}
+	if (!folio)
+		goto out_unlock;
+
+	__dequeue_hugetlb_folio(h, folio);
+	spin_unlock_irq(&hugetlb_lock);
+
+	clear_huge_page(&folio->page, 0, pages_per_huge_page(h));
+
+	spin_lock_irq(&hugetlb_lock);
+	/* Nobody else may have found the folio while it was off the lists */
+	if (folio_ref_freeze(folio, 1)) {
+		folio_set_hugetlb_zeroed(folio);
+		enqueue_hugetlb_folio(h, folio);
+		spin_unlock_irq(&hugetlb_lock);
+	} else {
+		spin_unlock_irq(&hugetlb_lock);
+		folio_put(folio);
+	}
+	return true;
+
+out_unlock:
+	spin_unlock_irq(&hugetlb_lock);
+	return false;
+}
+
+static int hugetlb_zerod(void *unused)
+{
+	struct hstate *h;
+
+	set_freezable();
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		bool progress = false;
+
+		WRITE_ONCE(hugetlb_zerod_kick, false);
+		for_each_hstate(h) {
+			if (READ_ONCE(h->prezero) && hugetlb_zero_one(h))
+				progress = true;
+			cond_resched();
+		}
+
+		if (!progress)
+			wait_event_freezable(hugetlb_zerod_wait,
+					     READ_ONCE(hugetlb_zerod_kick) ||
+					     kthread_should_stop());
+	}
+
+	return 0;
+}
+
+static int hugetlb_zerod_start(void)
+{
+	struct task_struct *thread;
+	int err = 0;
+
+	mutex_lock(&hugetlb_zerod_mutex);
+	if (!hugetlb_zerod_thread) {
+		thread = kthread_run(hugetlb_zerod, NULL, "hugetlb_zerod");
+		if (IS_ERR(thread))
+			err = PTR_ERR(thread);
+		else
+			hugetlb_zerod_thread = thread;
+	}
+	mutex_unlock(&hugetlb_zerod_mutex);
+
+	return err;
+}
+
+/**
+ * hugetlb_zero_folio - clear a newly allocated hugetlb folio
+ * @folio: the folio to clear
+ * @addr_hint: the user address the folio is being faulted in at
+ *
+ * Skips the clearing if the folio was pre-zeroed while on the free lists.
+ */
+void hugetlb_zero_folio(struct folio *folio, unsigned long addr_hint)
+{
+	if (folio_test_hugetlb_zeroed(folio)) {
+		folio_clear_hugetlb_zeroed(folio);
+		return;
+	}
+
+	clear_huge_page(&folio->page, addr_hint,
+			pages_per_huge_page(folio_hstate(folio)));
+}
+
 void free_huge_folio(struct folio *folio)
 {
 	/*
@@ -1984,6 +2165,7 @@ void free_huge_folio(struct folio *folio)
 	folio->mapping = NULL;
 	restore_reserve = folio_test_hugetlb_restore_reserve(folio);
 	folio_clear_hugetlb_restore_reserve(folio);
+	folio_clear_hugetlb_zeroed(folio);
 
 	/*
 	 * If HPageRestoreReserve was set on page, page allocation consumed a
@@ -2027,6 +2209,8 @@ void free_huge_folio(struct folio *folio)
 		arch_clear_hugetlb_flags(folio);
 		enqueue_hugetlb_folio(h, folio);
 		spin_unlock_irqrestore(&hugetlb_lock, flags);
+		if (READ_ONCE(h->prezero))
+			hugetlb_zerod_wakeup();
 	}
 }
 
@@ -2345,6 +2529,102 @@ static struct folio *alloc_pool_huge_folio(struct hstate *h,
 	return NULL;
 }
 
+/*
+ * Fresh folios are handed to the pool in batches of this size, so that the
+ * vmemmap they free and the time hugetlb_lock is held stay bounded while
+ * still sharing TLB flushes between many folios.
+ */
+#define HUGETLB_ALLOC_BATCH		1024
+/* Pool increases of at least this many pages are split between nodes */
+#define HUGETLB_PARALLEL_ALLOC_MIN	(2 * HUGETLB_ALLOC_BATCH)
+
+struct hugetlb_alloc_work {
+	struct work_struct work;
+	struct hstate *h;
+	struct task_struct *task;
+	int nid;
+	unsigned long nr_to_alloc;
+};
+
+static void hugetlb_alloc_work_fn(struct work_struct *work)
+{
+	struct hugetlb_alloc_work *aw = container_of(work,
+					struct hugetlb_alloc_work, work);
+	struct hstate *h = aw->h;
+	gfp_t gfp_mask = htlb_alloc_mask(h) | __GFP_THISNODE;
+	nodemask_t node_alloc_noretry;
+	unsigned long i, nr = 0;
+	LIST_HEAD(folio_list);
+
+	nodes_clear(node_alloc_noretry);
+	for (i = 0; i < aw->nr_to_alloc; i++) {
+		struct folio *folio;
+
+		folio = only_alloc_fresh_hugetlb_folio(h, gfp_mask, aw->nid,
+					NULL, &node_alloc_noretry);
+		if (!folio)
+			break;
+
+		list_add(&folio->lru, &folio_list);
+		if (++nr == HUGETLB_ALLOC_BATCH) {
+			prep_and_add_allocated_folios(h, &folio_list);
+			nr = 0;
+		}
+
+		/* The task resizing the pool is waiting for us */
+		if (signal_pending(aw->task))
+			break;
+		cond_resched();
+	}
+
+	if (nr)
+		prep_and_add_allocated_folios(h, &folio_list);
+}
+
+/*
+ * Grow the pool of @h by up to @delta pages, with one worker allocating
+ * and optimizing the vmemmap of an even share of the pages on each node of
+ * @nodes_allowed.  Whatever they fail to allocate is left to the caller.
+ */
+static void hugetlb_alloc_pool_parallel(struct hstate *h, unsigned long delta,
+					nodemask_t *nodes_allowed)
+{
+	struct hugetlb_alloc_work *works;
+	int nr = 0, i = 0, nid;
+
+	if (hstate_is_gigantic(h) || delta < HUGETLB_PARALLEL_ALLOC_MIN)
+		return;
+
+	for_each_node_mask(nid, *nodes_allowed)
+		if (node_state(nid, N_MEMORY))
+			nr++;
+	if (nr <= 1)
+		return;
+
+	works = kcalloc(nr, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return;
+
+	for_each_node_mask(nid, *nodes_allowed) {
+		struct hugetlb_alloc_work *aw = &works[i];
+
+		if (!node_state(nid, N_MEMORY))
+			continue;
+
+		aw->h = h;
+		aw->task = current;
+		aw->nid = nid;
+		aw->nr_to_alloc = delta / nr + (i < delta % nr);
+		INIT_WORK(&aw->work, hugetlb_alloc_work_fn);
+		queue_work_node(nid, system_unbound_wq, &aw->work);
+		i++;
+	}
+
+	for (i = 0; i < nr; i++)
+		flush_work(&works[i].work);
+	kfree(works);
+}
+
 /*
  * Remove huge page from pool from next node to free.  Attempt to keep
  * persistent huge pages more or less balanced over allowed nodes.
@@ -3464,6 +3744,7 @@ static void __init hugetlb_hstate_alloc_pages_onenode(struct hstate *h, int nid)
 {
 	unsigned long i;
 	char buf[32];
+	LIST_HEAD(folio_list);
 
 	for (i = 0; i < h->max_huge_pages_node[nid]; ++i) {
 		if (hstate_is_gigantic(h)) {
@@ -3473,14 +3754,17 @@ static void __init hugetlb_hstate_alloc_pages_onenode(struct hstate *h, int nid)
 			struct folio *folio;
 			gfp_t gfp_mask = htlb_alloc_mask(h) | __GFP_THISNODE;
 
-			folio = alloc_fresh_hugetlb_folio(h, gfp_mask, nid,
+			folio = only_alloc_fresh_hugetlb_folio(h, gfp_mask, nid,
 					&node_states[N_MEMORY], NULL);
 			if (!folio)
 				break;
-			free_huge_folio(folio); /* free it into the hugepage allocator */
+			list_add(&folio->lru, &folio_list);
 		}
 		cond_resched();
 	}
+	/* Optimize the vmemmap of all of them under the same TLB flushes */
+	if (!list_empty(&folio_list))
+		prep_and_add_allocated_folios(h, &folio_list);
 	if (i == h->max_huge_pages_node[nid])
 		return;
 
@@ -3838,6 +4122,19 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 			break;
 	}
 
+	/*
+	 * Large increases are first split between the allowed nodes, the
+	 * loop below makes up for anything the per-node workers could not
+	 * allocate.
+	 */
+	if (count > persistent_huge_pages(h)) {
+		unsigned long delta = count - persistent_huge_pages(h);
+
+		spin_unlock_irq(&hugetlb_lock);
+		hugetlb_alloc_pool_parallel(h, delta, nodes_allowed);
+		spin_lock_irq(&hugetlb_lock);
+	}
+
 	allocated = 0;
 	while (count > (persistent_huge_pages(h) + allocated)) {
 		/*
@@ -3860,7 +4157,10 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 		}
 
 		list_add(&folio->lru, &page_list);
-		allocated++;
+		if (++allocated == HUGETLB_ALLOC_BATCH) {
+			prep_and_add_allocated_folios(h, &page_list);
+			allocated = 0;
+		}
 
 		/* Bail for signals. Probably ctrl-c from user */
 		if (signal_pending(current)) {
@@ -4325,12 +4625,71 @@ static ssize_t demote_size_store(struct kobject *kobj,
 }
 HSTATE_ATTR(demote_size);
 
+static ssize_t prezero_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+
+	return sysfs_emit(buf, "%d\n", READ_ONCE(h->prezero));
+}
+
+static ssize_t prezero_store(struct kobject *kobj,
+			     struct kobj_attribute *attr,
+			     const char *buf, size_t count)
+{
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+	bool enable;
+	int err;
+
+	err = kstrtobool(buf, &enable);
+	if (err)
+		return -EINVAL;
+
+	if (enable) {
+		err = hugetlb_zerod_start();
+		if (err)
+			return err;
+	}
+
+	WRITE_ONCE(h->prezero, enable);
+	if (enable)
+		hugetlb_zerod_wakeup();
+
+	return count;
+}
+HSTATE_ATTR(prezero);
+
+static ssize_t free_zeroed_hugepages_show(struct kobject *kobj,
+					  struct kobj_attribute *attr, char *buf)
+{
+	struct hstate *h = kobj_to_hstate(kobj, NULL);
+	unsigned long nr = 0;
+	struct folio *folio;
+	int nid;
+
+	spin_lock_irq(&hugetlb_lock);
+	for_each_node_state(nid, N_MEMORY) {
+		list_for_each_entry_reverse(folio, &h->hugepage_freelists[nid],
+					    lru) {
+			if (!folio_test_hugetlb_zeroed(folio))
+				break;
+			nr++;
+		}
+	}
+	spin_unlock_irq(&hugetlb_lock);
+
+	return sysfs_emit(buf, "%lu\n", nr);
+}
+HSTATE_ATTR_RO(free_zeroed_hugepages);
+
 static struct attribute *hstate_attrs[] = {
 	&nr_hugepages_attr.attr,
 	&nr_overcommit_hugepages_attr.attr,
 	&free_hugepages_attr.attr,
 	&resv_hugepages_attr.attr,
 	&surplus_hugepages_attr.attr,
+	&prezero_attr.attr,
+	&free_zeroed_hugepages_attr.attr,
 #ifdef CONFIG_NUMA
 	&nr_hugepages_mempolicy_attr.attr,
 #endif
@@ -6298,8 +6657,7 @@ static vm_fault_t hugetlb_no_page(struct address_space *mapping,
 				ret = 0;
 			goto out;
 		}
-		clear_huge_page(&folio->page, vmf->real_address,
-				pages_per_huge_page(h));
+		hugetlb_zero_folio(folio, vmf->real_address);
 		__folio_mark_uptodate(folio);
 		new_folio = true;
 
@@ -710,6 +710,25 @@ struct compact_control {
 					 * ensure forward progress.
 					 */
 	bool alloc_contig;		/* alloc_contig_range allocation */
+	struct compact_range *range;	/* PFN range of a parallel worker */
+};
+
+/*
+ * A part of a zone compacted by one of the parallel proactive compaction
+ * workers.  The progress fields are updated by the worker as it goes.
+ */
+struct compact_range {
+	struct work_struct work;
+	struct zone *zone;
+	unsigned long start_pfn;
+	unsigned long end_pfn;
+	unsigned long rate_limit;	/* pages per second, 0 if unlimited */
+	unsigned long rl_start;		/* current rate limit window */
+	unsigned long rl_nr;		/* pages migrated in the window */
+	unsigned long migrate_pfn;
+	unsigned long free_pfn;
+	unsigned long nr_migrated;
+	bool done;
 };
 
 /*
@@ -1052,6 +1071,9 @@ extern unsigned long  __must_check vm_mmap_pgoff(struct file *, unsigned long,
 
 extern void set_pageblock_order(void);
 unsigned long reclaim_pages(struct list_head *folio_list);
+#if defined(CONFIG_LRU_GEN) && defined(CONFIG_MEMCG)
+int lru_gen_memcg_hist_show(struct seq_file *m, struct mem_cgroup *memcg);
+#endif
 unsigned int reclaim_clean_pages_from_list(struct zone *zone,
 					    struct list_head *folio_list);
 /* The ALLOC_WMARK bits are used as an index to zone->watermark */
@@ -1481,12 +1503,27 @@ static inline void shrinker_debugfs_name_free(struct shrinker *shrinker)
 	shrinker->name = NULL;
 }
 
+static inline void shrinker_debugfs_account(struct shrinker *shrinker,
+					    u64 ns, unsigned long freed)
+{
+	int lat = min_t(int, fls64(div_u64(ns, NSEC_PER_USEC)),
+			SHRINKER_HIST_BUCKETS - 1);
+
+	atomic_long_inc(&shrinker->latency_hist[lat]);
+	atomic_long_inc(&shrinker->freed_hist[min_t(int, fls_long(freed),
+						    SHRINKER_HIST_BUCKETS - 1)]);
+}
+
 extern int shrinker_debugfs_add(struct shrinker *shrinker);
 extern struct dentry *shrinker_debugfs_detach(struct shrinker *shrinker,
 					      int *debugfs_id);
 extern void shrinker_debugfs_remove(struct dentry *debugfs_entry,
 				    int debugfs_id);
 #else /* CONFIG_SHRINKER_DEBUG */
+static inline void shrinker_debugfs_account(struct shrinker *shrinker,
+					    u64 ns, unsigned long freed)
+{
+}
 static inline int shrinker_debugfs_add(struct shrinker *shrinker)
 {
 	return 0;
@@ -14,6 +14,8 @@
 #include <linux/freezer.h>
 #include <linux/mman.h>
 #include <linux/hashtable.h>
+#include <linux/list_sort.h>
+#include <linux/seq_file.h>
 #include <linux/userfaultfd_k.h>
 #include <linux/page_idle.h>
 #include <linux/page_table_check.h>
@@ -88,6 +90,8 @@ static DECLARE_WAIT_QUEUE_HEAD(khugepaged_wait);
 static unsigned int khugepaged_max_ptes_none __read_mostly;
 static unsigned int khugepaged_max_ptes_swap __read_mostly;
 static unsigned int khugepaged_max_ptes_shared __read_mostly;
+/* visit the mms with the most young ptes first in each full scan */
+static bool khugepaged_scan_hot_first __read_mostly;
 
 #define MM_SLOTS_HASH_BITS 10
 static DEFINE_READ_MOSTLY_HASHTABLE(mm_slots_hash, MM_SLOTS_HASH_BITS);
@@ -102,14 +106,23 @@ struct collapse_control {
 
 	/* nodemask for allocation fallback */
 	nodemask_t alloc_nmask;
+
+	/* Num young ptes seen by the current scan */
+	unsigned int nr_young;
 };
 
 /**
  * struct khugepaged_mm_slot - khugepaged information per mm that is being scanned
  * @slot: hash lookup from mm to mm_slot
+ * @heat: decaying count of young ptes khugepaged found in this mm
+ * @nr_collapsed: number of hugepages khugepaged collapsed in this mm
+ * @collapse_ns: total time spent in those successful collapses
  */
 struct khugepaged_mm_slot {
 	struct mm_slot slot;
+	unsigned long heat;
+	unsigned long nr_collapsed;
+	u64 collapse_ns;
 };
 
 /**
@@ -327,11 +340,43 @@ static ssize_t max_ptes_shared_store(struct kobject *kobj,
 static struct kobj_attribute khugepaged_max_ptes_shared_attr =
 	__ATTR_RW(max_ptes_shared);
 
+/*
+ * scan_hot_first makes khugepaged reorder its mm list after every full
+ * scan, so that the mms in which it found the most young ptes recently
+ * are visited, and collapsed, first. Every mm is still scanned once per
+ * full scan.
+ */
+static ssize_t scan_hot_first_show(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   char *buf)
+{
+	return sysfs_emit(buf, "%d\n", khugepaged_scan_hot_first);
+}
+
+static ssize_t scan_hot_first_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	int err;
+	bool enable;
+
+	err = kstrtobool(buf, &enable);
+	if (err)
+		return -EINVAL;
+
+	WRITE_ONCE(khugepaged_scan_hot_first, enable);
+
+	return count;
+}
+static struct kobj_attribute scan_hot_first_attr =
+	__ATTR_RW(scan_hot_first);
+
 static struct attribute *khugepaged_attr[] = {
 	&khugepaged_defrag_attr.attr,
 	&khugepaged_max_ptes_none_attr.attr,
 	&khugepaged_max_ptes_swap_attr.attr,
 	&khugepaged_max_ptes_shared_attr.attr,
+	&scan_hot_first_attr.attr,
 	&pages_to_scan_attr.attr,
 	&pages_collapsed_attr.attr,
 	&full_scans_attr.attr,
@@ -1398,6 +1443,7 @@ static int hpage_collapse_scan_pmd(struct mm_struct *mm,
 	}
 out_unmap:
 	pte_unmap_unlock(pte, ptl);
+	cc->nr_young += referenced;
 	if (result == SCAN_SUCCEED) {
 		result = collapse_huge_page(mm, address, referenced,
 					    unmapped, cc);
@@ -2312,6 +2358,60 @@ static int hpage_collapse_scan_file(struct mm_struct *mm, unsigned long addr,
 }
 #endif
 
+static int khugepaged_heat_cmp(void *priv, const struct list_head *a,
+			       const struct list_head *b)
+{
+	struct khugepaged_mm_slot *sa, *sb;
+
+	sa = mm_slot_entry(list_entry(a, struct mm_slot, mm_node),
+			   struct khugepaged_mm_slot, slot);
+	sb = mm_slot_entry(list_entry(b, struct mm_slot, mm_node),
+			   struct khugepaged_mm_slot, slot);
+
+	return sa->heat < sb->heat;
+}
+
+/*
+ * At the end of a full scan, order the mm list hottest first for the next
+ * one, and age the heat so that it follows the recent access pattern.
+ */
+static void khugepaged_sort_mm_slots(void)
+{
+	struct mm_slot *slot;
+
+	lockdep_assert_held(&khugepaged_mm_lock);
+
+	if (!READ_ONCE(khugepaged_scan_hot_first))
+		return;
+
+	list_sort(NULL, &khugepaged_scan.mm_head, khugepaged_heat_cmp);
+	list_for_each_entry(slot, &khugepaged_scan.mm_head, mm_node)
+		mm_slot_entry(slot, struct khugepaged_mm_slot, slot)->heat /= 2;
+}
+
+void khugepaged_show_mm_stats(struct seq_file *m, struct mm_struct *mm)
+{
+	struct khugepaged_mm_slot *mm_slot;
+	unsigned long nr_collapsed = 0;
+	struct mm_slot *slot;
+	u64 collapse_ns = 0;
+
+	if (test_bit(MMF_VM_HUGEPAGE, &mm->flags)) {
+		spin_lock(&khugepaged_mm_lock);
+		slot = mm_slot_lookup(mm_slots_hash, mm);
+		mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
+		if (mm_slot) {
+			nr_collapsed = mm_slot->nr_collapsed;
+			collapse_ns = mm_slot->collapse_ns;
+		}
+		spin_unlock(&khugepaged_mm_lock);
+	}
+
+	seq_printf(m, "THP_collapsed:\t%lu\n", nr_collapsed);
+	seq_printf(m, "THP_collapse_avg_us:\t%llu\n", nr_collapsed ?
+		   div64_u64(collapse_ns, nr_collapsed * NSEC_PER_USEC) : 0);
+}
+
 static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 					    struct collapse_control *cc)
 	__releases(&khugepaged_mm_lock)
@@ -2323,10 +2423,13 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
 	int progress = 0;
+	u64 start, collapse_ns = 0;
+	unsigned long nr_collapsed = 0;
 
 	VM_BUG_ON(!pages);
 	lockdep_assert_held(&khugepaged_mm_lock);
 	*result = SCAN_FAIL;
+	cc->nr_young = 0;
 
 	if (khugepaged_scan.mm_slot) {
 		mm_slot = khugepaged_scan.mm_slot;
@@ -2386,6 +2489,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 			VM_BUG_ON(khugepaged_scan.address < hstart ||
 				  khugepaged_scan.address + HPAGE_PMD_SIZE >
 				  hend);
+			start = ktime_get_ns();
 			if (IS_ENABLED(CONFIG_SHMEM) && vma->vm_file) {
 				struct file *file = get_file(vma->vm_file);
 				pgoff_t pgoff = linear_page_index(vma,
@@ -2411,8 +2515,11 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 					khugepaged_scan.address, &mmap_locked, cc);
 			}
 
-			if (*result == SCAN_SUCCEED)
+			if (*result == SCAN_SUCCEED) {
 				++khugepaged_pages_collapsed;
+				nr_collapsed++;
+				collapse_ns += ktime_get_ns() - start;
+			}
 
 			/* move to next address */
 			khugepaged_scan.address += HPAGE_PMD_SIZE;
@@ -2436,6 +2543,9 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 
 	spin_lock(&khugepaged_mm_lock);
 	VM_BUG_ON(khugepaged_scan.mm_slot != mm_slot);
+	mm_slot->heat += cc->nr_young;
+	mm_slot->nr_collapsed += nr_collapsed;
+	mm_slot->collapse_ns += collapse_ns;
 	/*
 	 * Release the current mm_slot if this mm is about to die, or
 	 * if we scanned all vmas of this mm.
@@ -2455,6 +2565,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 		} else {
 			khugepaged_scan.mm_slot = NULL;
 			khugepaged_full_scans++;
+			khugepaged_sort_mm_slots();
 		}
 
 		collect_mm_slot(mm_slot);
@@ -287,6 +287,7 @@ static unsigned int ksm_thread_sleep_millisecs = 20;
 
 /* Checksum of an empty (zeroed) page */
 static unsigned int zero_checksum __read_mostly;
+static unsigned int zero_sampled_checksum __read_mostly;
 
 /* Whether to merge empty (zeroed) pages with actual zero pages */
 static bool ksm_use_zero_pages __read_mostly;
@@ -295,6 +296,12 @@ static bool ksm_use_zero_pages __read_mostly;
 /* Default to true at least temporarily, for testing */
 static bool ksm_smart_scan = true;
 
+/* Upper bound of scans a long-unmergeable page is skipped for */
+static unsigned int ksm_smart_scan_max_skip __read_mostly = 8;
+
+/* Hash only a sample of each page to detect volatile pages */
+static bool ksm_sampled_checksum __read_mostly;
+
 /* The number of zero pages which is placed by KSM */
 atomic_long_t ksm_zero_pages = ATOMIC_LONG_INIT(0);
 
@@ -1275,6 +1282,27 @@ static u32 calc_checksum(struct page *page)
 	return checksum;
 }
 
+#define KSM_CHECKSUM_SAMPLES		8
+#define KSM_CHECKSUM_SAMPLE_BYTES	64
+
+/*
+ * Hash a few cache lines spread over the page instead of all of it. This is
+ * only used to tell whether a page changed since the previous scan, merging
+ * always compares the full contents.
+ */
+static u32 calc_sampled_checksum(struct page *page)
+{
+	u32 checksum = 0;
+	void *addr = kmap_local_page(page);
+	int i;
+
+	for (i = 0; i < KSM_CHECKSUM_SAMPLES; i++)
+		checksum = xxhash(addr + i * (PAGE_SIZE / KSM_CHECKSUM_SAMPLES),
+				  KSM_CHECKSUM_SAMPLE_BYTES, checksum);
+	kunmap_local(addr);
+	return checksum;
+}
+
 static int write_protect_page(struct vm_area_struct *vma, struct folio *folio,
 			      pte_t *orig_pte)
 {
@@ -2369,7 +2397,10 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	 * don't want to insert it in the unstable tree, and we don't want
 	 * to waste our time searching for something identical to it there.
 	 */
-	checksum = calc_checksum(page);
+	if (ksm_sampled_checksum)
+		checksum = calc_sampled_checksum(page);
+	else
+		checksum = calc_checksum(page);
 	if (rmap_item->oldchecksum != checksum) {
 		rmap_item->oldchecksum = checksum;
 		return;
@@ -2379,7 +2410,9 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	 * Same checksum as an empty page. We attempt to merge it with the
 	 * appropriate zero page if the user enabled this via sysfs.
 	 */
-	if (ksm_use_zero_pages && (checksum == zero_checksum)) {
+	if (ksm_use_zero_pages &&
+	    checksum == (ksm_sampled_checksum ? zero_sampled_checksum :
+						zero_checksum)) {
 		struct vm_area_struct *vma;
 
 		mmap_read_lock(mm);
@@ -2512,15 +2545,22 @@ static unsigned int skip_age(rmap_age_t age)
 		return 2;
 	if (age <= 8)
 		return 4;
+	if (ksm_smart_scan_max_skip <= 8)
+		return ksm_smart_scan_max_skip;
 
-	return 8;
+	/* Keep doubling the skips every four unsuccessful scans */
+	return min(8U << min((age - 9) / 4, 5), ksm_smart_scan_max_skip);
 }
 
 /*
  * Determines if a page should be skipped for the current scan.
  *
- * @page: page to check
+ * @page: page to check, or NULL if the page has not been looked up yet
  * @rmap_item: associated rmap_item of page
+ *
+ * Without a page only the rmap_item state is consulted, and the rmap_item is
+ * left untouched unless the page is skipped: that lets the caller avoid the
+ * page table walk for pages that would be skipped anyway.
  */
 static bool should_skip_rmap_item(struct page *page,
 				  struct ksm_rmap_item *rmap_item)
@@ -2535,10 +2575,12 @@ static bool should_skip_rmap_item(struct page *page,
 	 * will essentially ignore them, but we still have to process them
 	 * properly.
 	 */
-	if (PageKsm(page))
+	if (page ? PageKsm(page) : rmap_item->address & STABLE_FLAG)
 		return false;
 
 	age = rmap_item->age;
+	if (!page && (age < 3 || !rmap_item->remaining_skips))
+		return false;
 	if (age != U8_MAX)
 		rmap_item->age++;
 
@@ -2654,6 +2696,15 @@ static struct ksm_rmap_item *scan_get_next_rmap_item(struct page **page)
 		while (ksm_scan.address < vma->vm_end) {
 			if (ksm_test_exit(mm))
 				break;
+			rmap_item = *ksm_scan.rmap_list;
+			if (rmap_item &&
+			    (rmap_item->address & PAGE_MASK) == ksm_scan.address &&
+			    should_skip_rmap_item(NULL, rmap_item)) {
+				ksm_scan.rmap_list = &rmap_item->rmap_list;
+				ksm_scan.address += PAGE_SIZE;
+				cond_resched();
+				continue;
+			}
 			*page = follow_page(vma, ksm_scan.address, FOLL_GET);
 			if (IS_ERR_OR_NULL(*page)) {
 				ksm_scan.address += PAGE_SIZE;
@@ -3747,6 +3798,53 @@ static ssize_t smart_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(smart_scan);
 
+static ssize_t smart_scan_max_skip_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", ksm_smart_scan_max_skip);
+}
+
+static ssize_t smart_scan_max_skip_store(struct kobject *kobj,
+					 struct kobj_attribute *attr,
+					 const char *buf, size_t count)
+{
+	unsigned int value;
+	int err;
+
+	err = kstrtouint(buf, 10, &value);
+	if (err)
+		return -EINVAL;
+	/* remaining_skips is a rmap_age_t */
+	if (value < 1 || value > U8_MAX)
+		return -EINVAL;
+
+	ksm_smart_scan_max_skip = value;
+	return count;
+}
+KSM_ATTR(smart_scan_max_skip);
+
+static ssize_t sampled_checksum_show(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", ksm_sampled_checksum);
+}
+
+static ssize_t sampled_checksum_store(struct kobject *kobj,
+				      struct kobj_attribute *attr,
+				      const char *buf, size_t count)
+{
+	int err;
+	bool value;
+
+	err = kstrtobool(buf, &value);
+	if (err)
+		return -EINVAL;
+
+	ksm_sampled_checksum = value;
+	return count;
+}
+KSM_ATTR(sampled_checksum);
+
 static ssize_t advisor_mode_show(struct kobject *kobj,
 				 struct kobj_attribute *attr, char *buf)
 {
@@ -3893,6 +3991,8 @@ static struct attribute *ksm_attrs[] = {
 	&use_zero_pages_attr.attr,
 	&general_profit_attr.attr,
 	&smart_scan_attr.attr,
+	&smart_scan_max_skip_attr.attr,
+	&sampled_checksum_attr.attr,
 	&advisor_mode_attr.attr,
 	&advisor_max_cpu_attr.attr,
 	&advisor_min_pages_to_scan_attr.attr,
@@ -3914,6 +4014,7 @@ static int __init ksm_init(void)
 
 	/* The correct value depends on page size and endianness */
 	zero_checksum = calc_checksum(ZERO_PAGE(0));
+	zero_sampled_checksum = calc_sampled_checksum(ZERO_PAGE(0));
 	/* Default to false for backwards compatibility */
 	ksm_use_zero_pages = false;
 
@@ -40,8 +40,33 @@
 struct madvise_walk_private {
 	struct mmu_gather *tlb;
 	bool pageout;
+	/* Folios isolated for MADV_PAGEOUT, not reclaimed yet */
+	struct list_head folio_list;
+	unsigned long nr_pages;
 };
 
+/*
+ * Reclaiming the isolated folios ends with a TLB flush of the unmapped
+ * ranges, so MADV_PAGEOUT collects folios across page tables and reclaims
+ * them in batches of this many pages rather than once per page table.
+ */
+#define PAGEOUT_BATCH_PAGES	(SWAP_CLUSTER_MAX * 128)
+
+static void madvise_pageout_batch(struct madvise_walk_private *private,
+				  struct list_head *folio_list)
+{
+	struct folio *folio;
+
+	list_for_each_entry(folio, folio_list, lru)
+		private->nr_pages += folio_nr_pages(folio);
+	list_splice_tail_init(folio_list, &private->folio_list);
+
+	if (private->nr_pages < PAGEOUT_BATCH_PAGES)
+		return;
+	reclaim_pages(&private->folio_list);
+	private->nr_pages = 0;
+}
+
 /*
  * Any behaviour which results in changes to the vma->vm_flags needs to
  * take mmap_lock for writing. Others, which simply traverse vmas, need
@@ -423,7 +448,7 @@ static int madvise_cold_or_pageout_pte_range(pmd_t *pmd,
 huge_unlock:
 		spin_unlock(ptl);
 		if (pageout)
-			reclaim_pages(&folio_list);
+			madvise_pageout_batch(private, &folio_list);
 		return 0;
 	}
 
@@ -547,7 +572,7 @@ static int madvise_cold_or_pageout_pte_range(pmd_t *pmd,
 		pte_unmap_unlock(start_pte, ptl);
 	}
 	if (pageout)
-		reclaim_pages(&folio_list);
+		madvise_pageout_batch(private, &folio_list);
 	cond_resched();
 
 	return 0;
@@ -603,10 +628,12 @@ static void madvise_pageout_page_range(struct mmu_gather *tlb,
 	struct madvise_walk_private walk_private = {
 		.pageout = true,
 		.tlb = tlb,
+		.folio_list = LIST_HEAD_INIT(walk_private.folio_list),
 	};
 
 	tlb_start_vma(tlb, vma);
 	walk_page_range(vma->vm_mm, addr, end, &cold_walk_ops, &walk_private);
+	reclaim_pages(&walk_private.folio_list);
 	tlb_end_vma(tlb, vma);
 }
 
@@ -852,7 +852,7 @@ static inline void memcg_rstat_updated(struct mem_cgroup *memcg, int val)
 	if (!val)
 		return;
 
-	cgroup_rstat_updated(memcg->css.cgroup, cpu);
+	css_rstat_updated(&memcg->css, cpu);
 	statc = this_cpu_ptr(memcg->vmstats_percpu);
 	for (; statc; statc = statc->parent) {
 		stats_updates = READ_ONCE(statc->stats_updates) + abs(val);
@@ -876,7 +876,7 @@ static void do_flush_stats(struct mem_cgroup *memcg)
 	if (mem_cgroup_is_root(memcg))
 		WRITE_ONCE(flush_last_time, jiffies_64);
 
-	cgroup_rstat_flush(memcg->css.cgroup);
+	css_rstat_flush(&memcg->css);
 }
 
 /*
@@ -907,6 +907,50 @@ void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 		mem_cgroup_flush_stats(memcg);
 }
 
+/*
+ * With a non-zero stats_read_staleness, memory.stat and memory.numa_stat
+ * readers never flush synchronously unless the periodic flush is older than
+ * that many jiffies. They get the last flushed values, with the bound of the
+ * error shown alongside, and leave the flushing to the worker.
+ */
+static unsigned long stats_read_staleness;
+
+static void mem_cgroup_flush_stats_for_read(struct mem_cgroup *memcg)
+{
+	unsigned long staleness = READ_ONCE(stats_read_staleness);
+
+	if (!staleness) {
+		mem_cgroup_flush_stats(memcg);
+		return;
+	}
+
+	if (!memcg_vmstats_needs_flush(memcg->vmstats))
+		return;
+
+	if (time_after64(jiffies_64, READ_ONCE(flush_last_time) + staleness))
+		do_flush_stats(memcg);
+
+	/* Let the worker catch up, off the reader's and reclaim's path */
+	mod_delayed_work(system_unbound_wq, &stats_flush_dwork, 0);
+}
+
+static void memcg_stat_format_staleness(struct mem_cgroup *memcg,
+					struct seq_buf *s)
+{
+	u64 age = jiffies_64 - READ_ONCE(flush_last_time);
+	u64 pending;
+
+	if (!READ_ONCE(stats_read_staleness))
+		return;
+
+	/* Updates not yet flushed, plus what per-cpu batching may hide */
+	pending = atomic64_read(&memcg->vmstats->stats_updates) +
+		  MEMCG_CHARGE_BATCH * num_online_cpus();
+
+	seq_buf_printf(s, "stats_age_ms %u\n", jiffies_to_msecs(age));
+	seq_buf_printf(s, "stats_max_error %llu\n", pending);
+}
+
 static void flush_memcg_stats_dwork(struct work_struct *w)
 {
 	/*
@@ -1811,8 +1855,6 @@ static void memcg_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
 	 *
 	 * Current memory state:
 	 */
-	mem_cgroup_flush_stats(memcg);
-
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		u64 size;
 
@@ -1919,6 +1961,7 @@ void mem_cgroup_print_oom_meminfo(struct mem_cgroup *memcg)
 	pr_cont_cgroup_path(memcg->css.cgroup);
 	pr_cont(":");
 	seq_buf_init(&s, buf, sizeof(buf));
+	mem_cgroup_flush_stats(memcg);
 	memory_stat_format(memcg, &s);
 	seq_buf_do_printk(&s, KERN_INFO);
 }
@@ -2413,6 +2456,8 @@ struct memcg_stock_pcp {
 	local_lock_t stock_lock;
 	struct mem_cgroup *cached; /* this never be root cgroup */
 	unsigned int nr_pages;
+	unsigned int batch;	/* adaptive charge batch for cached */
+	unsigned long last_refill;	/* jiffies of the last batch charge */
 
 #ifdef CONFIG_MEMCG_KMEM
 	struct obj_cgroup *cached_objcg;
@@ -2508,6 +2553,7 @@ static void drain_stock(struct memcg_stock_pcp *stock)
 
 	css_put(&old->css);
 	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->batch, 0);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -2550,7 +2596,7 @@ static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	stock_pages = READ_ONCE(stock->nr_pages) + nr_pages;
 	WRITE_ONCE(stock->nr_pages, stock_pages);
 
-	if (stock_pages > MEMCG_CHARGE_BATCH)
+	if (stock_pages > max(READ_ONCE(stock->batch), MEMCG_CHARGE_BATCH))
 		drain_stock(stock);
 }
 
@@ -2563,6 +2609,56 @@ static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
 }
 
+/*
+ * A cpu's charge batch doubles each time its stock of the same memcg runs
+ * dry again within MEMCG_STOCK_FAST_REFILL jiffies of the last batch charge,
+ * and falls back to MEMCG_CHARGE_BATCH once charging slows down. This cuts
+ * the atomic updates of the hierarchical page counters for cgroups charging
+ * at high rates.
+ *
+ * What all cpus together may hold in their stocks is kept to a small part
+ * of the memcg's limit, so that the batching doesn't loosen it much.
+ */
+#define MEMCG_CHARGE_BATCH_MAX	1024U
+#define MEMCG_STOCK_FAST_REFILL	1
+#define MEMCG_STOCK_LIMIT_SHIFT	6
+
+static unsigned int memcg_charge_batch_cap(struct mem_cgroup *memcg)
+{
+	unsigned long limit = min(READ_ONCE(memcg->memory.max),
+				  READ_ONCE(memcg->memory.high));
+	unsigned long cap;
+
+	cap = (limit >> MEMCG_STOCK_LIMIT_SHIFT) / num_online_cpus();
+
+	return clamp_t(unsigned long, cap, MEMCG_CHARGE_BATCH,
+		       MEMCG_CHARGE_BATCH_MAX);
+}
+
+static unsigned int memcg_stock_next_batch(struct mem_cgroup *memcg)
+{
+	struct memcg_stock_pcp *stock;
+	unsigned long flags;
+	unsigned int batch;
+
+	local_lock_irqsave(&memcg_stock.stock_lock, flags);
+
+	stock = this_cpu_ptr(&memcg_stock);
+	batch = READ_ONCE(stock->batch);
+	if (READ_ONCE(stock->cached) != memcg || !batch ||
+	    time_after(jiffies, stock->last_refill + MEMCG_STOCK_FAST_REFILL))
+		batch = MEMCG_CHARGE_BATCH;
+	else
+		batch = min(batch * 2, memcg_charge_batch_cap(memcg));
+
+	WRITE_ONCE(stock->batch, batch);
+	stock->last_refill = jiffies;
+
+	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
+
+	return batch;
+}
+
 /*
  * Drains all per-CPU charge caches for given root_memcg resp. subtree
  * of the hierarchy under it.
@@ -2890,7 +2986,7 @@ void mem_cgroup_handle_over_high(gfp_t gfp_mask)
 static int try_charge_memcg(struct mem_cgroup *memcg, gfp_t gfp_mask,
 			unsigned int nr_pages)
 {
-	unsigned int batch = max(MEMCG_CHARGE_BATCH, nr_pages);
+	unsigned int batch = 0;
 	int nr_retries = MAX_RECLAIM_RETRIES;
 	struct mem_cgroup *mem_over_limit;
 	struct page_counter *counter;
@@ -2905,6 +3001,9 @@ static int try_charge_memcg(struct mem_cgroup *memcg, gfp_t gfp_mask,
 	if (consume_stock(memcg, nr_pages))
 		return 0;
 
+	if (!batch)
+		batch = max(memcg_stock_next_batch(memcg), nr_pages);
+
 	if (!do_memsw_account() ||
 	    page_counter_try_charge(&memcg->memsw, batch, &counter)) {
 		if (page_counter_try_charge(&memcg->memory, batch, &counter))
@@ -7104,7 +7203,9 @@ static int memory_stat_show(struct seq_file *m, void *v)
 	if (!buf)
 		return -ENOMEM;
 	seq_buf_init(&s, buf, PAGE_SIZE);
+	mem_cgroup_flush_stats_for_read(memcg);
 	memory_stat_format(memcg, &s);
+	memcg_stat_format_staleness(memcg, &s);
 	seq_puts(m, buf);
 	kfree(buf);
 	return 0;
@@ -7123,7 +7224,7 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 	int i;
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
 
-	mem_cgroup_flush_stats(memcg);
+	mem_cgroup_flush_stats_for_read(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		int nid;
@@ -7148,6 +7249,33 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 }
 #endif
 
+#ifdef CONFIG_LRU_GEN
+static int memory_lru_gen_hist_show(struct seq_file *m, void *v)
+{
+	return lru_gen_memcg_hist_show(m, mem_cgroup_from_seq(m));
+}
+#endif
+
+static int memory_stat_staleness_show(struct seq_file *m, void *v)
+{
+	seq_printf(m, "%u\n", jiffies_to_msecs(READ_ONCE(stats_read_staleness)));
+	return 0;
+}
+
+static ssize_t memory_stat_staleness_write(struct kernfs_open_file *of,
+					   char *buf, size_t nbytes, loff_t off)
+{
+	unsigned int msecs;
+	int ret;
+
+	ret = kstrtouint(strstrip(buf), 0, &msecs);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(stats_read_staleness, msecs_to_jiffies(msecs));
+	return nbytes;
+}
+
 static int memory_oom_group_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
@@ -7278,6 +7406,18 @@ static struct cftype memory_files[] = {
 		.name = "numa_stat",
 		.seq_show = memory_numa_stat_show,
 	},
+#endif
+	{
+		.name = "stat_staleness_ms",
+		.flags = CFTYPE_ONLY_ON_ROOT,
+		.seq_show = memory_stat_staleness_show,
+		.write = memory_stat_staleness_write,
+	},
+#ifdef CONFIG_LRU_GEN
+	{
+		.name = "lru_gen_hist",
+		.seq_show = memory_lru_gen_hist_show,
+	},
 #endif
 	{
 		.name = "oom.group",
@@ -7584,15 +7724,14 @@ int mem_cgroup_swapin_charge_folio(struct folio *folio, struct mm_struct *mm,
 }
 
 /*
- * mem_cgroup_swapin_uncharge_swap - uncharge swap slot
- * @entry: swap entry for which the page is charged
- *
- * Call this function after successfully adding the charged page to swapcache.
+ * mem_cgroup_swapin_uncharge_swap - uncharge swap slots
+ * @entry: first swap entry for which the folio is charged
+ * @nr_pages: number of pages which will be uncharged
  *
- * Note: This function assumes the page for which swap slot is being uncharged
- * is order 0 page.
+ * Call this function after successfully adding the charged folio to
+ * swapcache, or after reading it in directly for a synchronous swap device.
  */
-void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry)
+void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry, unsigned int nr_pages)
 {
 	/*
 	 * Cgroup1's unified memory+swap counter has been charged with the
@@ -7612,7 +7751,7 @@ void mem_cgroup_swapin_uncharge_swap(swp_entry_t entry)
 		 * let's not wait for it.  The page already received a
 		 * memory+swap charge, drop the swap entry duplicate.
 		 */
-		mem_cgroup_uncharge_swap(entry, 1);
+		mem_cgroup_uncharge_swap(entry, nr_pages);
 	}
 }
 
@@ -8494,6 +8633,25 @@ static ssize_t zswap_writeback_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int zswap_pool_show(struct seq_file *m, void *v)
+{
+	zswap_memcg_pool_show(m, mem_cgroup_from_seq(m));
+	return 0;
+}
+
+static ssize_t zswap_pool_write(struct kernfs_open_file *of,
+				char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	int err;
+
+	err = zswap_memcg_pool_set(memcg, buf);
+	if (err)
+		return err;
+
+	return nbytes;
+}
+
 static struct cftype zswap_files[] = {
 	{
 		.name = "zswap.current",
@@ -8511,6 +8669,12 @@ static struct cftype zswap_files[] = {
 		.seq_show = zswap_writeback_show,
 		.write = zswap_writeback_write,
 	},
+	{
+		.name = "zswap.pool",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = zswap_pool_show,
+		.write = zswap_pool_write,
+	},
 	{ }	/* terminate */
 };
 #endif /* CONFIG_MEMCG_KMEM && CONFIG_ZSWAP */
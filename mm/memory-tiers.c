@@ -23,6 +23,12 @@ struct memory_tier {
 	struct device dev;
 	/* All the nodes that are part of all the lower memory tiers. */
 	nodemask_t lower_tier_mask;
+	/* Cap of promotions out of this tier in MB/s, 0 means unlimited */
+	unsigned int promote_rate_limit;
+	/* Start of the current promotion rate limit window in jiffies */
+	unsigned long promote_rl_start;
+	/* Pages promoted out of this tier in the current window */
+	unsigned long promote_rl_nr;
 };
 
 struct demotion_nodes {
@@ -160,8 +166,33 @@ static ssize_t nodelist_show(struct device *dev,
 }
 static DEVICE_ATTR_RO(nodelist);
 
+static ssize_t promote_rate_limit_MBps_show(struct device *dev,
+					    struct device_attribute *attr,
+					    char *buf)
+{
+	return sysfs_emit(buf, "%u\n",
+			  READ_ONCE(to_memory_tier(dev)->promote_rate_limit));
+}
+
+static ssize_t promote_rate_limit_MBps_store(struct device *dev,
+					     struct device_attribute *attr,
+					     const char *buf, size_t count)
+{
+	unsigned int limit;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &limit);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(to_memory_tier(dev)->promote_rate_limit, limit);
+	return count;
+}
+static DEVICE_ATTR_RW(promote_rate_limit_MBps);
+
 static struct attribute *memtier_dev_attrs[] = {
 	&dev_attr_nodelist.attr,
+	&dev_attr_promote_rate_limit_MBps.attr,
 	NULL
 };
 
@@ -279,6 +310,45 @@ bool node_is_toptier(int node)
 	return toptier;
 }
 
+/**
+ * node_promotion_allowed - charge a promotion against the tier rate limit
+ * @node: the node the folio is promoted from
+ * @nr_pages: number of pages to promote
+ *
+ * Return: false if promoting @nr_pages from @node would exceed the
+ * promotion rate limit of the memory tier of @node in the current one
+ * second window, true otherwise.
+ */
+bool node_promotion_allowed(int node, unsigned long nr_pages)
+{
+	struct memory_tier *memtier;
+	unsigned long limit, now = jiffies;
+	bool allowed = true;
+
+	rcu_read_lock();
+	memtier = rcu_dereference(NODE_DATA(node)->memtier);
+	if (!memtier)
+		goto out;
+	limit = READ_ONCE(memtier->promote_rate_limit);
+	if (!limit)
+		goto out;
+	limit <<= 20 - PAGE_SHIFT;
+
+	/* Racy, but only approximate rate limiting is needed */
+	if (time_after(now, READ_ONCE(memtier->promote_rl_start) + HZ)) {
+		WRITE_ONCE(memtier->promote_rl_start, now);
+		WRITE_ONCE(memtier->promote_rl_nr, 0);
+	}
+	if (READ_ONCE(memtier->promote_rl_nr) + nr_pages > limit)
+		allowed = false;
+	else
+		WRITE_ONCE(memtier->promote_rl_nr,
+			   memtier->promote_rl_nr + nr_pages);
+out:
+	rcu_read_unlock();
+	return allowed;
+}
+
 void node_get_allowed_targets(pg_data_t *pgdat, nodemask_t *targets)
 {
 	struct memory_tier *memtier;
@@ -927,6 +997,7 @@ static int __init memory_tier_init(void)
 subsys_initcall(memory_tier_init);
 
 bool numa_demotion_enabled = false;
+unsigned int numa_promotion_batch;
 
 #ifdef CONFIG_MIGRATION
 #ifdef CONFIG_SYSFS
@@ -953,8 +1024,35 @@ static ssize_t demotion_enabled_store(struct kobject *kobj,
 static struct kobj_attribute numa_demotion_enabled_attr =
 	__ATTR_RW(demotion_enabled);
 
+static ssize_t promotion_batch_show(struct kobject *kobj,
+				    struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(numa_promotion_batch));
+}
+
+static ssize_t promotion_batch_store(struct kobject *kobj,
+				     struct kobj_attribute *attr,
+				     const char *buf, size_t count)
+{
+	unsigned int batch;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 0, &batch);
+	if (ret)
+		return ret;
+	if (batch > NUMA_PROMOTION_BATCH_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(numa_promotion_batch, batch);
+	return count;
+}
+
+static struct kobj_attribute numa_promotion_batch_attr =
+	__ATTR_RW(promotion_batch);
+
 static struct attribute *numa_attrs[] = {
 	&numa_demotion_enabled_attr.attr,
+	&numa_promotion_batch_attr.attr,
 	NULL,
 };
 
@@ -78,6 +78,7 @@
 #include <linux/ptrace.h>
 #include <linux/vmalloc.h>
 #include <linux/sched/sysctl.h>
+#include <linux/zswap.h>
 
 #include <trace/events/kmem.h>
 
@@ -887,6 +888,53 @@ copy_nonpresent_pte(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 	return 0;
 }
 
+/*
+ * Copy a batch of contiguous swap entries, as detected by swap_pte_batch(),
+ * duplicating them under a single swap cluster lock.  Returns the number of
+ * entries copied, or 0 if the caller should use copy_nonpresent_pte().
+ */
+static int copy_swap_ptes(struct mm_struct *dst_mm, struct mm_struct *src_mm,
+		pte_t *dst_pte, pte_t *src_pte, pte_t orig_pte,
+		struct vm_area_struct *dst_vma, unsigned long addr,
+		int max_nr, int *rss)
+{
+	swp_entry_t entry = pte_to_swp_entry(orig_pte);
+	pte_t pte;
+	int i, nr;
+
+	if (max_nr == 1 || non_swap_entry(entry))
+		return 0;
+	nr = swap_pte_batch(src_pte, max_nr, orig_pte);
+	if (nr == 1)
+		return 0;
+	nr = swap_duplicate_nr(entry, nr);
+	if (nr < 0)
+		return 0;
+
+	/* make sure dst_mm is on swapoff's mmlist. */
+	if (unlikely(list_empty(&dst_mm->mmlist))) {
+		spin_lock(&mmlist_lock);
+		if (list_empty(&dst_mm->mmlist))
+			list_add(&dst_mm->mmlist, &src_mm->mmlist);
+		spin_unlock(&mmlist_lock);
+	}
+
+	for (i = 0; i < nr; i++, addr += PAGE_SIZE) {
+		pte = orig_pte;
+		/* Mark the swap entry as shared. */
+		if (pte_swp_exclusive(orig_pte)) {
+			pte = pte_swp_clear_exclusive(orig_pte);
+			set_pte_at(src_mm, addr, src_pte + i, pte);
+		}
+		if (!userfaultfd_wp(dst_vma))
+			pte = pte_swp_clear_uffd_wp(pte);
+		set_pte_at(dst_mm, addr, dst_pte + i, pte);
+		orig_pte = pte_next_swp_offset(orig_pte);
+	}
+	rss[MM_SWAPENTS] += nr;
+	return nr;
+}
+
 /*
  * Copy a present and normal page.
  *
@@ -1126,6 +1174,14 @@ copy_pte_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma,
 			continue;
 		}
 		if (unlikely(!pte_present(ptent))) {
+			max_nr = (end - addr) / PAGE_SIZE;
+			nr = copy_swap_ptes(dst_mm, src_mm, dst_pte, src_pte,
+					    ptent, dst_vma, addr, max_nr, rss);
+			if (nr) {
+				progress += 8 * nr;
+				continue;
+			}
+			nr = 1;
 			ret = copy_nonpresent_pte(dst_mm, src_mm,
 						  dst_pte, src_pte,
 						  dst_vma, src_vma,
@@ -3205,7 +3261,8 @@ static inline vm_fault_t vmf_can_call_fault(const struct vm_fault *vmf)
 	if (vma->vm_ops->map_pages || !(vmf->flags & FAULT_FLAG_VMA_LOCK))
 		return 0;
 	vma_end_read(vma);
-	return VM_FAULT_RETRY;
+	count_vm_vma_lock_event(VMA_LOCK_FALLBACK_FAULT_OPS);
+	return VM_FAULT_RETRY | VM_FAULT_MMAP_LOCK;
 }
 
 /**
@@ -3233,7 +3290,8 @@ vm_fault_t vmf_anon_prepare(struct vm_fault *vmf)
 	if (vmf->flags & FAULT_FLAG_VMA_LOCK) {
 		if (!mmap_read_trylock(vma->vm_mm)) {
 			vma_end_read(vma);
-			return VM_FAULT_RETRY;
+			count_vm_vma_lock_event(VMA_LOCK_FALLBACK_ANON_VMA);
+			return VM_FAULT_RETRY | VM_FAULT_MMAP_LOCK;
 		}
 	}
 	if (__anon_vma_prepare(vma))
@@ -3936,6 +3994,145 @@ static vm_fault_t handle_pte_marker(struct vm_fault *vmf)
 	return VM_FAULT_SIGBUS;
 }
 
+static struct folio *__alloc_swap_folio(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct folio *folio;
+	swp_entry_t entry;
+
+	folio = vma_alloc_folio(GFP_HIGHUSER_MOVABLE, 0, vma, vmf->address,
+				false);
+	if (!folio)
+		return NULL;
+
+	entry = pte_to_swp_entry(vmf->orig_pte);
+	if (mem_cgroup_swapin_charge_folio(folio, vma->vm_mm,
+					   GFP_KERNEL, entry)) {
+		folio_put(folio);
+		return NULL;
+	}
+
+	return folio;
+}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Check whether the nr_pages ptes at ptep, which cover the naturally aligned
+ * range around the faulting address, map contiguous swap entries that were
+ * swapped out together and can be read back into a single large folio.
+ */
+static bool can_swapin_thp(struct vm_fault *vmf, pte_t *ptep, int nr_pages)
+{
+	swp_entry_t entry, fault_entry = pte_to_swp_entry(vmf->orig_pte);
+	unsigned long addr = ALIGN_DOWN(vmf->address, nr_pages * PAGE_SIZE);
+	pgoff_t idx = (vmf->address - addr) >> PAGE_SHIFT;
+	pte_t pte = ptep_get(ptep);
+
+	if (!is_swap_pte(pte))
+		return false;
+	entry = pte_to_swp_entry(pte);
+	if (non_swap_entry(entry) ||
+	    swp_type(entry) != swp_type(fault_entry) ||
+	    swp_offset(entry) + idx != swp_offset(fault_entry) ||
+	    !IS_ALIGNED(swp_offset(entry), nr_pages))
+		return false;
+	if (swap_pte_batch(ptep, nr_pages, pte) != nr_pages)
+		return false;
+
+	/*
+	 * Entries with a swapcache folio must be faulted through the
+	 * swapcache, and zswap can only fill the folio if it holds every
+	 * subpage or none of them.
+	 */
+	if (non_swapcache_batch(entry, nr_pages) != nr_pages)
+		return false;
+	idx = zswap_nr_present(entry, nr_pages);
+	if (idx && idx != nr_pages)
+		return false;
+
+	return true;
+}
+
+static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	unsigned long orders;
+	struct folio *folio;
+	unsigned long addr;
+	swp_entry_t entry;
+	spinlock_t *ptl;
+	pte_t *pte;
+	gfp_t gfp;
+	int order;
+
+	/*
+	 * If uffd is active for the vma we need per-page fault fidelity to
+	 * maintain the uffd semantics.
+	 */
+	if (unlikely(userfaultfd_armed(vma)))
+		goto fallback;
+
+	/*
+	 * Get a list of all the (large) orders below PMD_ORDER that are enabled
+	 * for this vma. Then filter out the orders that can't be allocated over
+	 * the faulting address and still be fully contained in the vma.
+	 */
+	orders = thp_vma_allowable_orders(vma, vma->vm_flags,
+			TVA_IN_PF | TVA_ENFORCE_SYSFS, BIT(PMD_ORDER) - 1);
+	orders = thp_vma_suitable_orders(vma, vmf->address, orders);
+
+	if (!orders)
+		goto fallback;
+
+	pte = pte_offset_map_lock(vmf->vma->vm_mm, vmf->pmd,
+				  vmf->address & PMD_MASK, &ptl);
+	if (unlikely(!pte))
+		goto fallback;
+
+	/*
+	 * Find the highest order where the aligned range is a batch of
+	 * contiguous swap entries that can be read back as one folio.
+	 */
+	order = highest_order(orders);
+	while (orders) {
+		addr = ALIGN_DOWN(vmf->address, PAGE_SIZE << order);
+		if (can_swapin_thp(vmf, pte + pte_index(addr), 1 << order))
+			break;
+		order = next_order(&orders, order);
+	}
+
+	pte_unmap_unlock(pte, ptl);
+
+	if (!orders)
+		goto fallback;
+
+	/* Try allocating the highest of the remaining orders. */
+	entry = pte_to_swp_entry(vmf->orig_pte);
+	gfp = vma_thp_gfp_mask(vma);
+	while (orders) {
+		addr = ALIGN_DOWN(vmf->address, PAGE_SIZE << order);
+		folio = vma_alloc_folio(gfp, order, vma, addr, true);
+		if (folio) {
+			if (!mem_cgroup_swapin_charge_folio(folio, vma->vm_mm,
+							    gfp, entry))
+				return folio;
+			count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK_CHARGE);
+			folio_put(folio);
+		}
+		count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK);
+		order = next_order(&orders, order);
+	}
+
+fallback:
+	return __alloc_swap_folio(vmf);
+}
+#else /* !CONFIG_TRANSPARENT_HUGEPAGE */
+static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+{
+	return __alloc_swap_folio(vmf);
+}
+#endif /* CONFIG_TRANSPARENT_HUGEPAGE */
+
 /*
  * We enter with non-exclusive mmap_lock (to exclude vma changes,
  * but allow concurrent faults), and pte mapped but not yet locked.
@@ -3954,9 +4151,12 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	bool need_clear_cache = false;
 	bool exclusive = false;
 	swp_entry_t entry;
-	pte_t pte;
+	pte_t pte, oldpte;
 	vm_fault_t ret = 0;
 	void *shadow = NULL;
+	int nr_pages = 1;
+	unsigned long address;
+	pte_t *ptep;
 
 	if (!pte_unmap_same(vmf))
 		goto out;
@@ -3976,7 +4176,8 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 				 * under VMA lock.
 				 */
 				vma_end_read(vma);
-				ret = VM_FAULT_RETRY;
+				count_vm_vma_lock_event(VMA_LOCK_FALLBACK_DEVICE_PRIVATE);
+				ret = VM_FAULT_RETRY | VM_FAULT_MMAP_LOCK;
 				goto out;
 			}
 
@@ -4020,35 +4221,33 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	if (!folio) {
 		if (data_race(si->flags & SWP_SYNCHRONOUS_IO) &&
 		    __swap_count(entry) == 1) {
-			/*
-			 * Prevent parallel swapin from proceeding with
-			 * the cache flag. Otherwise, another thread may
-			 * finish swapin first, free the entry, and swapout
-			 * reusing the same entry. It's undetectable as
-			 * pte_same() returns true due to entry reuse.
-			 */
-			if (swapcache_prepare(entry)) {
-				/* Relax a bit to prevent rapid repeated page faults */
-				schedule_timeout_uninterruptible(1);
-				goto out;
-			}
-			need_clear_cache = true;
-
 			/* skip swapcache */
-			folio = vma_alloc_folio(GFP_HIGHUSER_MOVABLE, 0,
-						vma, vmf->address, false);
-			page = &folio->page;
+			folio = alloc_swap_folio(vmf);
 			if (folio) {
 				__folio_set_locked(folio);
 				__folio_set_swapbacked(folio);
 
-				if (mem_cgroup_swapin_charge_folio(folio,
-							vma->vm_mm, GFP_KERNEL,
-							entry)) {
-					ret = VM_FAULT_OOM;
+				nr_pages = folio_nr_pages(folio);
+				if (folio_test_large(folio))
+					entry = swp_entry(swp_type(entry),
+						ALIGN_DOWN(swp_offset(entry),
+							   nr_pages));
+				/*
+				 * Prevent parallel swapin from proceeding with
+				 * the cache flag. Otherwise, another thread may
+				 * finish swapin first, free the entry, and
+				 * swapout reusing the same entry. It's
+				 * undetectable as pte_same() returns true due
+				 * to entry reuse.
+				 */
+				if (swapcache_prepare(entry, nr_pages)) {
+					/* Relax a bit to prevent rapid repeated page faults */
+					schedule_timeout_uninterruptible(1);
 					goto out_page;
 				}
-				mem_cgroup_swapin_uncharge_swap(entry);
+				need_clear_cache = true;
+
+				mem_cgroup_swapin_uncharge_swap(entry, nr_pages);
 
 				shadow = get_shadow_from_swap_cache(entry);
 				if (shadow)
@@ -4060,6 +4259,10 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 				folio->swap = entry;
 				swap_read_folio(folio, true, NULL);
 				folio->private = NULL;
+				page = folio_page(folio, (vmf->address -
+					ALIGN_DOWN(vmf->address,
+						   nr_pages * PAGE_SIZE)) >>
+					PAGE_SHIFT);
 			}
 		} else {
 			page = swapin_readahead(entry, GFP_HIGHUSER_MOVABLE,
@@ -4155,6 +4358,28 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 		goto out_nomap;
 	}
 
+	address = vmf->address;
+	ptep = vmf->pte;
+	/*
+	 * A large folio read in bypassing the swapcache covers the whole
+	 * aligned range: map it in one go, after making sure nobody faulted
+	 * in or zapped any of the other ptes while we released the PT lock.
+	 */
+	if (nr_pages > 1) {
+		unsigned long folio_start;
+
+		folio_start = ALIGN_DOWN(vmf->address, nr_pages * PAGE_SIZE);
+		ptep = vmf->pte - ((vmf->address - folio_start) >> PAGE_SHIFT);
+		oldpte = ptep_get(ptep);
+		if (unlikely(!is_swap_pte(oldpte) ||
+			     pte_to_swp_entry(oldpte).val != entry.val ||
+			     swap_pte_batch(ptep, nr_pages, oldpte) != nr_pages))
+			goto out_nomap;
+		address = folio_start;
+	} else {
+		oldpte = vmf->orig_pte;
+	}
+
 	/*
 	 * PG_anon_exclusive reuses PG_mappedtodisk for anon pages. A swap pte
 	 * must never point at an anonymous page in the swapcache that is
@@ -4214,13 +4439,13 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	 * We're already holding a reference on the page but haven't mapped it
 	 * yet.
 	 */
-	swap_free(entry);
+	swap_free_nr(entry, nr_pages);
 	if (should_try_to_free_swap(folio, vma, vmf->flags))
 		folio_free_swap(folio);
 
-	inc_mm_counter(vma->vm_mm, MM_ANONPAGES);
-	dec_mm_counter(vma->vm_mm, MM_SWAPENTS);
-	pte = mk_pte(page, vma->vm_page_prot);
+	add_mm_counter(vma->vm_mm, MM_ANONPAGES, nr_pages);
+	add_mm_counter(vma->vm_mm, MM_SWAPENTS, -nr_pages);
+	pte = mk_pte(nr_pages > 1 ? &folio->page : page, vma->vm_page_prot);
 
 	/*
 	 * Same logic as in do_wp_page(); however, optimize for pages that are
@@ -4236,11 +4461,33 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 		}
 		rmap_flags |= RMAP_EXCLUSIVE;
 	}
-	flush_icache_page(vma, page);
 	if (pte_swp_soft_dirty(vmf->orig_pte))
 		pte = pte_mksoft_dirty(pte);
 	if (pte_swp_uffd_wp(vmf->orig_pte))
 		pte = pte_mkuffd_wp(pte);
+
+	if (nr_pages > 1) {
+		int i;
+
+		/* A fresh large folio, so certainly exclusive. */
+		folio_ref_add(folio, nr_pages - 1);
+		flush_icache_pages(vma, &folio->page, nr_pages);
+		vmf->orig_pte = pte_advance_pfn(pte,
+				(vmf->address - address) >> PAGE_SHIFT);
+		folio_add_new_anon_rmap(folio, vma, address);
+
+		VM_BUG_ON(pte_write(pte) && !PageAnonExclusive(page));
+		set_ptes(vma->vm_mm, address, ptep, pte, nr_pages);
+		for (i = 0; i < nr_pages; i++) {
+			arch_do_swap_page(vma->vm_mm, vma,
+					  address + i * PAGE_SIZE,
+					  pte_advance_pfn(pte, i), oldpte);
+			oldpte = pte_next_swp_offset(oldpte);
+		}
+		goto mapped;
+	}
+
+	flush_icache_page(vma, page);
 	vmf->orig_pte = pte;
 
 	/* ksm created a completely new copy */
@@ -4256,7 +4503,7 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 			(pte_write(pte) && !PageAnonExclusive(page)));
 	set_pte_at(vma->vm_mm, vmf->address, vmf->pte, pte);
 	arch_do_swap_page(vma->vm_mm, vma, vmf->address, pte, vmf->orig_pte);
-
+mapped:
 	folio_unlock(folio);
 	if (folio != swapcache && swapcache) {
 		/*
@@ -4279,14 +4526,14 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	}
 
 	/* No need to invalidate - it was non-present before */
-	update_mmu_cache_range(vmf, vma, vmf->address, vmf->pte, 1);
+	update_mmu_cache_range(vmf, vma, address, ptep, nr_pages);
 unlock:
 	if (vmf->pte)
 		pte_unmap_unlock(vmf->pte, vmf->ptl);
 out:
 	/* Clear the swap cache pin for direct swapin after PTL unlock */
 	if (need_clear_cache)
-		swapcache_clear(si, entry);
+		swapcache_clear(si, entry, nr_pages);
 	if (si)
 		put_swap_device(si);
 	return ret;
@@ -4302,7 +4549,7 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 		folio_put(swapcache);
 	}
 	if (need_clear_cache)
-		swapcache_clear(si, entry);
+		swapcache_clear(si, entry, nr_pages);
 	if (si)
 		put_swap_device(si);
 	return ret;
@@ -4397,6 +4644,109 @@ static struct folio *alloc_anon_folio(struct vm_fault *vmf)
 	return folio_prealloc(vma->vm_mm, vma, vmf->address, true);
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * The faulting address got a folio of @order only, because the range of the
+ * highest allowed order around it is partially populated.  Fill the other
+ * empty parts of that range with the largest allowed orders that fit, so that
+ * sparse accesses don't keep faulting in small folios one at a time.
+ *
+ * This is best effort: it stops at the first allocation or charge failure.
+ */
+static void anon_fault_around(struct vm_fault *vmf, int order)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	unsigned long orders, around, start, end, addr;
+	struct folio *folio;
+	spinlock_t *ptl;
+	pte_t *pte, entry;
+	int max_order, nr_pages;
+	gfp_t gfp;
+
+	if (!transparent_hugepage_anon_fault_around() ||
+	    unlikely(userfaultfd_armed(vma)))
+		return;
+
+	orders = thp_vma_allowable_orders(vma, vma->vm_flags,
+			TVA_IN_PF | TVA_ENFORCE_SYSFS, BIT(PMD_ORDER) - 1);
+	orders = thp_vma_suitable_orders(vma, vmf->address, orders);
+	if (!orders)
+		return;
+	max_order = highest_order(orders);
+	if (max_order <= order)
+		return;
+
+	start = ALIGN_DOWN(vmf->address, PAGE_SIZE << max_order);
+	end = start + (PAGE_SIZE << max_order);
+	/* The whole range can't be empty, so only look at smaller orders */
+	orders &= BIT(max_order) - 1;
+	gfp = vma_thp_gfp_mask(vma);
+
+	for (addr = start; addr < end; addr += PAGE_SIZE << order) {
+		pte = pte_offset_map(vmf->pmd, addr);
+		if (!pte)
+			return;
+		around = orders;
+		order = highest_order(around);
+		while (around) {
+			if (IS_ALIGNED(addr, PAGE_SIZE << order) &&
+			    pte_range_none(pte, 1 << order))
+				break;
+			order = next_order(&around, order);
+		}
+		pte_unmap(pte);
+		if (!around) {
+			order = 0;
+			continue;
+		}
+
+		nr_pages = 1 << order;
+		folio = vma_alloc_folio(gfp, order, vma, addr, true);
+		if (!folio) {
+			count_mthp_stat(order, MTHP_STAT_ANON_FAULT_AROUND_FALLBACK);
+			return;
+		}
+		if (mem_cgroup_charge(folio, vma->vm_mm, gfp)) {
+			count_mthp_stat(order, MTHP_STAT_ANON_FAULT_AROUND_FALLBACK);
+			folio_put(folio);
+			return;
+		}
+		folio_throttle_swaprate(folio, gfp);
+		clear_huge_page(&folio->page, addr, nr_pages);
+		__folio_mark_uptodate(folio);
+
+		entry = mk_pte(&folio->page, vma->vm_page_prot);
+		if (vma->vm_flags & VM_WRITE)
+			entry = pte_mkwrite(pte_mkdirty(entry), vma);
+
+		pte = pte_offset_map_lock(vma->vm_mm, vmf->pmd, addr, &ptl);
+		if (!pte) {
+			folio_put(folio);
+			return;
+		}
+		if (!pte_range_none(pte, nr_pages) ||
+		    check_stable_address_space(vma->vm_mm)) {
+			pte_unmap_unlock(pte, ptl);
+			folio_put(folio);
+			continue;
+		}
+
+		folio_ref_add(folio, nr_pages - 1);
+		add_mm_counter(vma->vm_mm, MM_ANONPAGES, nr_pages);
+		count_mthp_stat(order, MTHP_STAT_ANON_FAULT_AROUND);
+		folio_add_new_anon_rmap(folio, vma, addr);
+		folio_add_lru_vma(folio, vma);
+		set_ptes(vma->vm_mm, addr, pte, entry, nr_pages);
+		update_mmu_cache_range(vmf, vma, addr, pte, nr_pages);
+		pte_unmap_unlock(pte, ptl);
+	}
+}
+#else
+static inline void anon_fault_around(struct vm_fault *vmf, int order)
+{
+}
+#endif
+
 /*
  * We enter with non-exclusive mmap_lock (to exclude vma changes,
  * but allow concurrent faults), and pte mapped but not yet locked.
@@ -4409,6 +4759,7 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 	struct folio *folio;
 	vm_fault_t ret = 0;
 	int nr_pages = 1;
+	int around_order = -1;
 	pte_t entry;
 	int i;
 
@@ -4503,6 +4854,7 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 #endif
 	folio_add_new_anon_rmap(folio, vma, addr);
 	folio_add_lru_vma(folio, vma);
+	around_order = folio_order(folio);
 setpte:
 	if (vmf_orig_pte_uffd_wp(vmf))
 		entry = pte_mkuffd_wp(entry);
@@ -4513,6 +4865,8 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 unlock:
 	if (vmf->pte)
 		pte_unmap_unlock(vmf->pte, vmf->ptl);
+	if (around_order >= 0)
+		anon_fault_around(vmf, around_order);
 	return ret;
 release:
 	folio_put(folio);
@@ -50,6 +50,9 @@
 #include <linux/random.h>
 #include <linux/sched/sysctl.h>
 #include <linux/memory-tiers.h>
+#include <linux/workqueue.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 
 #include <asm/tlbflush.h>
 
@@ -650,6 +653,7 @@ EXPORT_SYMBOL(folio_migrate_flags);
 void folio_migrate_copy(struct folio *newfolio, struct folio *folio)
 {
 	folio_copy(newfolio, folio);
+	count_vm_events(PGMIGRATE_COPY_BYTES_SERIAL, folio_size(folio));
 	folio_migrate_flags(newfolio, folio);
 }
 EXPORT_SYMBOL(folio_migrate_copy);
@@ -1037,7 +1041,9 @@ static int move_to_new_folio(struct folio *dst, struct folio *src,
 enum {
 	PAGE_WAS_MAPPED = BIT(0),
 	PAGE_WAS_MLOCKED = BIT(1),
-	PAGE_OLD_STATES = PAGE_WAS_MAPPED | PAGE_WAS_MLOCKED,
+	/* Contents already copied to dst by migrate_folios_precopy() */
+	PAGE_WAS_COPIED = BIT(2),
+	PAGE_OLD_STATES = PAGE_WAS_MAPPED | PAGE_WAS_MLOCKED | PAGE_WAS_COPIED,
 };
 
 static void __migrate_folio_record(struct folio *dst,
@@ -1284,7 +1290,9 @@ static int migrate_folio_move(free_folio_t put_new_folio, unsigned long private,
 	prev = dst->lru.prev;
 	list_del(&dst->lru);
 
-	rc = move_to_new_folio(dst, src, mode);
+	/* Only the flags are left to transfer for precopied folios */
+	rc = move_to_new_folio(dst, src, (old_page_state & PAGE_WAS_COPIED) ?
+			       MIGRATE_SYNC_NO_COPY : mode);
 	if (rc)
 		goto out;
 
@@ -1336,7 +1344,12 @@ static int migrate_folio_move(free_folio_t put_new_folio, unsigned long private,
 	 */
 	if (rc == -EAGAIN) {
 		list_add(&dst->lru, prev);
-		__migrate_folio_record(dst, old_page_state, anon_vma);
+		/*
+		 * Whoever held the extra reference may have modified src, so
+		 * copy it again on retry.
+		 */
+		__migrate_folio_record(dst, old_page_state & ~PAGE_WAS_COPIED,
+				       anon_vma);
 		return rc;
 	}
 
@@ -1618,6 +1631,328 @@ static int migrate_hugetlbs(struct list_head *from, new_folio_t get_new_folio,
  * deadlock (e.g., for loop device).  So, if mode != MIGRATE_ASYNC, the
  * length of the from list must be <= 1.
  */
+/*
+ * Parallel copy stage of migrate_pages_batch().
+ *
+ * Once a batch of folios is unmapped, their contents can be copied to the
+ * destination folios before the one by one move stage, either by a DMA
+ * engine providing memcpy offload or by several CPUs.  Copy bandwidth of a
+ * single CPU is often what limits migrations between memory tiers.
+ *
+ * Only anonymous folios outside the swap cache are precopied: they are
+ * migrated by migrate_folio() and nobody can modify them once unmapped,
+ * unless they hold a reference, which makes the move stage fail and
+ * retry with a fresh copy.  Everything else, and whatever the parallel
+ * stage failed to copy, is copied by the move stage as before.
+ */
+static unsigned int sysctl_migrate_copy_threads __read_mostly = 1;
+static unsigned int sysctl_migrate_copy_dma __read_mostly;
+static const unsigned int migrate_copy_threads_max = 64;
+
+/* Batches smaller than this are not worth the setup cost */
+#define MIGRATE_COPY_MIN_PAGES		32
+/* Minimum number of pages given to each copy thread */
+#define MIGRATE_COPY_THREAD_PAGES	64
+
+struct migrate_copy_pair {
+	struct folio *src;
+	struct folio *dst;
+	bool copied;
+#ifdef CONFIG_DMA_ENGINE
+	bool mapped;
+	dma_addr_t src_addr;
+	dma_addr_t dst_addr;
+#endif
+};
+
+struct migrate_copy_work {
+	struct work_struct work;
+	struct migrate_copy_pair *pairs;
+	int start;
+	int end;
+};
+
+static bool migrate_copy_reason_allowed(enum migrate_reason reason)
+{
+	/* Compaction keeps folios on the same node and is latency bound */
+	switch (reason) {
+	case MR_DEMOTION:
+	case MR_NUMA_MISPLACED:
+	case MR_SYSCALL:
+	case MR_MEMPOLICY_MBIND:
+	case MR_MEMORY_HOTPLUG:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool migrate_folio_precopyable(struct folio *src, struct folio *dst)
+{
+	return !__folio_test_movable(src) && folio_test_anon(src) &&
+	       !folio_test_swapcache(src) && !folio_test_hugetlb(src) &&
+	       folio_nr_pages(src) == folio_nr_pages(dst);
+}
+
+#ifdef CONFIG_DMA_ENGINE
+static bool migrate_copy_dma_submit(struct dma_chan *chan, struct device *dev,
+				    struct migrate_copy_pair *pair,
+				    dma_cookie_t *cookie)
+{
+	size_t len = folio_size(pair->src);
+	struct dma_async_tx_descriptor *tx;
+
+	if (len > dma_get_max_seg_size(dev))
+		return false;
+
+	pair->src_addr = dma_map_page(dev, folio_page(pair->src, 0), 0, len,
+				      DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, pair->src_addr))
+		return false;
+	pair->dst_addr = dma_map_page(dev, folio_page(pair->dst, 0), 0, len,
+				      DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, pair->dst_addr))
+		goto unmap_src;
+
+	tx = dmaengine_prep_dma_memcpy(chan, pair->dst_addr, pair->src_addr,
+				       len, DMA_CTRL_ACK);
+	if (!tx)
+		goto unmap_dst;
+	*cookie = dmaengine_submit(tx);
+	if (dma_submit_error(*cookie))
+		goto unmap_dst;
+
+	pair->mapped = true;
+	return true;
+
+unmap_dst:
+	dma_unmap_page(dev, pair->dst_addr, len, DMA_FROM_DEVICE);
+unmap_src:
+	dma_unmap_page(dev, pair->src_addr, len, DMA_TO_DEVICE);
+	return false;
+}
+
+/* Returns the number of bytes copied */
+static unsigned long migrate_copy_dma(struct migrate_copy_pair *pairs, int nr)
+{
+	dma_cookie_t cookie, last = -EINVAL;
+	unsigned long bytes = 0;
+	enum dma_status status;
+	struct dma_chan *chan;
+	dma_cap_mask_t mask;
+	struct device *dev;
+	int i;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+	chan = dma_request_chan_by_mask(&mask);
+	if (IS_ERR(chan))
+		return 0;
+	dev = dmaengine_get_dma_device(chan);
+
+	for (i = 0; i < nr; i++)
+		if (migrate_copy_dma_submit(chan, dev, &pairs[i], &cookie))
+			last = cookie;
+
+	if (last < 0)
+		goto release;
+
+	/* Descriptors of a channel complete in order */
+	status = dma_sync_wait(chan, last);
+	if (status != DMA_COMPLETE)
+		dmaengine_terminate_sync(chan);
+
+	for (i = 0; i < nr; i++) {
+		struct migrate_copy_pair *pair = &pairs[i];
+		size_t len = folio_size(pair->src);
+
+		if (!pair->mapped)
+			continue;
+		dma_unmap_page(dev, pair->dst_addr, len, DMA_FROM_DEVICE);
+		dma_unmap_page(dev, pair->src_addr, len, DMA_TO_DEVICE);
+		pair->mapped = false;
+		if (status == DMA_COMPLETE) {
+			pair->copied = true;
+			bytes += len;
+		}
+	}
+
+release:
+	dma_release_channel(chan);
+	return bytes;
+}
+#else
+static unsigned long migrate_copy_dma(struct migrate_copy_pair *pairs, int nr)
+{
+	return 0;
+}
+#endif
+
+static void migrate_copy_range(struct migrate_copy_pair *pairs,
+			       int start, int end)
+{
+	int i;
+
+	for (i = start; i < end; i++) {
+		if (pairs[i].copied)
+			continue;
+		folio_copy(pairs[i].dst, pairs[i].src);
+		pairs[i].copied = true;
+	}
+}
+
+static void migrate_copy_work_fn(struct work_struct *work)
+{
+	struct migrate_copy_work *cw = container_of(work,
+					struct migrate_copy_work, work);
+
+	migrate_copy_range(cw->pairs, cw->start, cw->end);
+}
+
+/*
+ * Split the copies not done by DMA between @nr_threads CPUs, the calling
+ * one included.  Returns the number of bytes copied.
+ */
+static unsigned long migrate_copy_threads(struct migrate_copy_pair *pairs,
+					  int nr, unsigned int nr_threads)
+{
+	struct migrate_copy_work *works;
+	unsigned long nr_pages = 0, bytes = 0;
+	int i, start, per_thread;
+
+	for (i = 0; i < nr; i++)
+		if (!pairs[i].copied)
+			nr_pages += folio_nr_pages(pairs[i].src);
+
+	nr_threads = min_t(unsigned long, nr_threads,
+			   nr_pages / MIGRATE_COPY_THREAD_PAGES);
+	nr_threads = min_t(unsigned int, nr_threads, nr);
+	if (nr_threads <= 1)
+		return 0;
+
+	works = kcalloc(nr_threads, sizeof(*works), GFP_KERNEL | __GFP_NOWARN);
+	if (!works)
+		return 0;
+
+	for (i = 0; i < nr; i++)
+		if (!pairs[i].copied)
+			bytes += folio_size(pairs[i].src);
+
+	per_thread = DIV_ROUND_UP(nr, nr_threads);
+	for (i = 0, start = 0; i < nr_threads; i++, start += per_thread) {
+		struct migrate_copy_work *cw = &works[i];
+
+		cw->pairs = pairs;
+		cw->start = min(start, nr);
+		cw->end = min(start + per_thread, nr);
+		INIT_WORK(&cw->work, migrate_copy_work_fn);
+		if (i)
+			queue_work_node(folio_nid(pairs[cw->start].dst),
+					system_unbound_wq, &cw->work);
+	}
+
+	migrate_copy_range(pairs, works[0].start, works[0].end);
+	for (i = 1; i < nr_threads; i++)
+		flush_work(&works[i].work);
+	kfree(works);
+
+	return bytes;
+}
+
+static void migrate_folios_precopy(struct list_head *src_folios,
+				   struct list_head *dst_folios,
+				   enum migrate_reason reason)
+{
+	unsigned int nr_threads = READ_ONCE(sysctl_migrate_copy_threads);
+	bool use_dma = READ_ONCE(sysctl_migrate_copy_dma);
+	struct migrate_copy_pair *pairs;
+	struct folio *src, *dst;
+	unsigned long nr_pages = 0, bytes;
+	int nr = 0, i;
+
+	if ((nr_threads <= 1 && !use_dma) || !migrate_copy_reason_allowed(reason))
+		return;
+
+	dst = list_first_entry(dst_folios, struct folio, lru);
+	list_for_each_entry(src, src_folios, lru) {
+		if (migrate_folio_precopyable(src, dst)) {
+			nr_pages += folio_nr_pages(src);
+			nr++;
+		}
+		dst = list_next_entry(dst, lru);
+	}
+	if (nr_pages < MIGRATE_COPY_MIN_PAGES)
+		return;
+
+	pairs = kvcalloc(nr, sizeof(*pairs), GFP_KERNEL | __GFP_NOWARN);
+	if (!pairs)
+		return;
+
+	i = 0;
+	dst = list_first_entry(dst_folios, struct folio, lru);
+	list_for_each_entry(src, src_folios, lru) {
+		if (migrate_folio_precopyable(src, dst)) {
+			pairs[i].src = src;
+			pairs[i].dst = dst;
+			i++;
+		}
+		dst = list_next_entry(dst, lru);
+	}
+
+	if (use_dma) {
+		bytes = migrate_copy_dma(pairs, nr);
+		if (bytes)
+			count_vm_events(PGMIGRATE_COPY_BYTES_DMA, bytes);
+	}
+	if (nr_threads > 1) {
+		bytes = migrate_copy_threads(pairs, nr, nr_threads);
+		if (bytes)
+			count_vm_events(PGMIGRATE_COPY_BYTES_THREADS, bytes);
+	}
+
+	for (i = 0; i < nr; i++) {
+		int old_page_state = 0;
+		struct anon_vma *anon_vma = NULL;
+
+		if (!pairs[i].copied)
+			continue;
+		__migrate_folio_extract(pairs[i].dst, &old_page_state,
+					&anon_vma);
+		__migrate_folio_record(pairs[i].dst,
+				       old_page_state | PAGE_WAS_COPIED,
+				       anon_vma);
+	}
+	kvfree(pairs);
+}
+
+static struct ctl_table migrate_copy_sysctls[] = {
+	{
+		.procname	= "migrate_copy_threads",
+		.data		= &sysctl_migrate_copy_threads,
+		.maxlen		= sizeof(sysctl_migrate_copy_threads),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= (void *)&migrate_copy_threads_max,
+	},
+	{
+		.procname	= "migrate_copy_dma",
+		.data		= &sysctl_migrate_copy_dma,
+		.maxlen		= sizeof(sysctl_migrate_copy_dma),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
+};
+
+static int __init migrate_copy_sysctl_init(void)
+{
+	register_sysctl_init("vm", migrate_copy_sysctls);
+	return 0;
+}
+subsys_initcall(migrate_copy_sysctl_init);
+
 static int migrate_pages_batch(struct list_head *from,
 		new_folio_t get_new_folio, free_folio_t put_new_folio,
 		unsigned long private, enum migrate_mode mode, int reason,
@@ -1795,6 +2130,9 @@ static int migrate_pages_batch(struct list_head *from,
 	/* Flush TLBs for all unmapped folios */
 	try_to_unmap_flush();
 
+	if (!list_empty(&unmap_folios))
+		migrate_folios_precopy(&unmap_folios, &dst_folios, reason);
+
 	retry = 1;
 	for (pass = 0; pass < nr_pass && retry; pass++) {
 		retry = 0;
@@ -2586,10 +2924,107 @@ static int numamigrate_isolate_folio(pg_data_t *pgdat, struct folio *folio)
 	return 1;
 }
 
+/*
+ * Folios isolated for promotion to a node, migrated together once
+ * numa_promotion_batch pages are queued or after a short delay.
+ */
+struct promote_batch {
+	spinlock_t lock;
+	struct list_head folios;
+	unsigned long nr_pages;
+	int nid;
+	struct delayed_work work;
+};
+
+static struct promote_batch *promote_batches;
+
+#define PROMOTE_BATCH_DELAY	msecs_to_jiffies(10)
+
+static void promote_batch_migrate(struct list_head *folios, int node)
+{
+	pg_data_t *pgdat = NODE_DATA(node);
+	unsigned int nr_succeeded = 0;
+
+	migrate_pages(folios, alloc_misplaced_dst_folio, NULL, node,
+		      MIGRATE_ASYNC, MR_NUMA_MISPLACED, &nr_succeeded);
+	putback_movable_pages(folios);
+	if (nr_succeeded) {
+		count_vm_numa_events(NUMA_PAGE_MIGRATE, nr_succeeded);
+		mod_node_page_state(pgdat, PGPROMOTE_SUCCESS, nr_succeeded);
+		mod_node_page_state(pgdat, PGPROMOTE_BATCHED, nr_succeeded);
+	}
+}
+
+static void promote_batch_work_fn(struct work_struct *work)
+{
+	struct promote_batch *pb = container_of(to_delayed_work(work),
+						struct promote_batch, work);
+	LIST_HEAD(folios);
+
+	spin_lock(&pb->lock);
+	list_splice_init(&pb->folios, &folios);
+	pb->nr_pages = 0;
+	spin_unlock(&pb->lock);
+
+	if (!list_empty(&folios))
+		promote_batch_migrate(&folios, pb->nid);
+}
+
+/*
+ * Queue an isolated folio for promotion to @node.  The caller filling up the
+ * batch migrates it, the delayed work picks up whatever is left behind.
+ */
+static void promote_batch_add(struct folio *folio, int node)
+{
+	struct promote_batch *pb = &promote_batches[node];
+	LIST_HEAD(folios);
+	bool full;
+
+	spin_lock(&pb->lock);
+	list_add_tail(&folio->lru, &pb->folios);
+	pb->nr_pages += folio_nr_pages(folio);
+	full = pb->nr_pages >= READ_ONCE(numa_promotion_batch);
+	if (full) {
+		list_splice_init(&pb->folios, &folios);
+		pb->nr_pages = 0;
+	}
+	spin_unlock(&pb->lock);
+
+	if (full)
+		promote_batch_migrate(&folios, node);
+	else
+		schedule_delayed_work(&pb->work, PROMOTE_BATCH_DELAY);
+}
+
+static int __init promote_batch_init(void)
+{
+	int nid;
+
+	promote_batches = kcalloc(nr_node_ids, sizeof(*promote_batches),
+				  GFP_KERNEL);
+	if (!promote_batches)
+		return -ENOMEM;
+
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct promote_batch *pb = &promote_batches[nid];
+
+		spin_lock_init(&pb->lock);
+		INIT_LIST_HEAD(&pb->folios);
+		pb->nid = nid;
+		INIT_DELAYED_WORK(&pb->work, promote_batch_work_fn);
+	}
+	return 0;
+}
+subsys_initcall(promote_batch_init);
+
 /*
  * Attempt to migrate a misplaced folio to the specified destination
  * node. Caller is expected to have an elevated reference count on
  * the folio that will be dropped by this function before returning.
+ *
+ * Promotions from a slower memory tier are rate limited per source tier,
+ * and queued for a batched migration if numa_promotion_batch is set.  A
+ * queued folio keeps its NUMA hinting entry until the batch is migrated.
  */
 int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 			    int node)
@@ -2600,6 +3035,8 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	unsigned int nr_succeeded;
 	LIST_HEAD(migratepages);
 	int nr_pages = folio_nr_pages(folio);
+	bool promote = !node_is_toptier(folio_nid(folio)) &&
+		       node_is_toptier(node);
 
 	/*
 	 * Don't migrate file folios that are mapped in multiple processes
@@ -2619,10 +3056,20 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	if (folio_is_file_lru(folio) && folio_test_dirty(folio))
 		goto out;
 
+	if (promote && !node_promotion_allowed(folio_nid(folio), nr_pages)) {
+		mod_node_page_state(pgdat, PGPROMOTE_RATELIMITED, nr_pages);
+		goto out;
+	}
+
 	isolated = numamigrate_isolate_folio(pgdat, folio);
 	if (!isolated)
 		goto out;
 
+	if (promote && READ_ONCE(numa_promotion_batch) > 1 && promote_batches) {
+		promote_batch_add(folio, node);
+		return isolated;
+	}
+
 	list_add(&folio->lru, &migratepages);
 	nr_remaining = migrate_pages(&migratepages, alloc_misplaced_dst_folio,
 				     NULL, node, MIGRATE_ASYNC,
@@ -2638,7 +3085,7 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	}
 	if (nr_succeeded) {
 		count_vm_numa_events(NUMA_PAGE_MIGRATE, nr_succeeded);
-		if (!node_is_toptier(folio_nid(folio)) && node_is_toptier(node))
+		if (promote)
 			mod_node_page_state(pgdat, PGPROMOTE_SUCCESS,
 					    nr_succeeded);
 	}
@@ -2286,6 +2286,10 @@ int decay_pcp_high(struct zone *zone, struct per_cpu_pages *pcp)
 			todo++;
 	}
 
+	/* Forget about refill storms once the pcp went quiet */
+	if (pcp->refill_factor && time_after(jiffies, pcp->last_refill + HZ))
+		pcp->refill_factor = 0;
+
 	to_drain = pcp->count - pcp->high;
 	if (to_drain > 0) {
 		spin_lock(&pcp->lock);
@@ -2448,7 +2452,37 @@ void drain_all_pages(struct zone *zone)
 	__drain_all_pages(zone, false);
 }
 
-static int nr_pcp_free(struct per_cpu_pages *pcp, int batch, int high, bool free_high)
+/*
+ * Adaptive pcp batching: grow the refill batch of pcps that run dry in quick
+ * succession, and free pages to remote zones in as large chunks as possible.
+ * Meant for allocation storms, e.g. from NIC receive, that otherwise keep
+ * bouncing zone->lock between CPUs.
+ */
+static int percpu_pagelist_adaptive_batch __read_mostly;
+
+/* Refills at most this many jiffies apart increase pcp->refill_factor */
+#define PCP_FAST_REFILL_JIFFIES	1
+
+static void pcp_update_refill_factor(struct per_cpu_pages *pcp)
+{
+	unsigned long now = jiffies;
+
+	pcp->nr_refills++;
+
+	if (!READ_ONCE(percpu_pagelist_adaptive_batch)) {
+		pcp->refill_factor = 0;
+	} else if (time_before_eq(now, pcp->last_refill + PCP_FAST_REFILL_JIFFIES)) {
+		if (pcp->refill_factor < CONFIG_PCP_BATCH_SCALE_MAX)
+			pcp->refill_factor++;
+	} else if (pcp->refill_factor) {
+		pcp->refill_factor--;
+	}
+
+	pcp->last_refill = now;
+}
+
+static int nr_pcp_free(struct per_cpu_pages *pcp, struct zone *zone,
+		       int batch, int high, bool free_high)
 {
 	int min_nr_free, max_nr_free;
 
@@ -2464,6 +2498,14 @@ static int nr_pcp_free(struct per_cpu_pages *pcp, int batch, int high, bool free
 	min_nr_free = batch;
 	max_nr_free = high - batch;
 
+	/*
+	 * Pages on the pcp of a remote zone are rarely allocated again by
+	 * this CPU, return them in as few remote zone->lock trips as possible.
+	 */
+	if (READ_ONCE(percpu_pagelist_adaptive_batch) &&
+	    zone_to_nid(zone) != numa_node_id())
+		return max_nr_free;
+
 	/*
 	 * Increase the batch number to the number of the consecutive
 	 * freed pages to reduce zone lock contention.
@@ -2536,6 +2578,10 @@ static void free_unref_page_commit(struct zone *zone, struct per_cpu_pages *pcp,
 	 */
 	pcp->alloc_factor >>= 1;
 	__count_vm_events(PGFREE, 1 << order);
+#ifdef CONFIG_NUMA
+	if (zone_to_nid(zone) != numa_node_id())
+		pcp->nr_remote_frees += 1 << order;
+#endif
 	pindex = order_to_pindex(migratetype, order);
 	list_add(&page->pcp_list, &pcp->lists[pindex]);
 	pcp->count += 1 << order;
@@ -2560,7 +2606,7 @@ static void free_unref_page_commit(struct zone *zone, struct per_cpu_pages *pcp,
 		pcp->free_count += (1 << order);
 	high = nr_pcp_high(pcp, zone, batch, free_high);
 	if (pcp->count >= high) {
-		free_pcppages_bulk(zone, nr_pcp_free(pcp, batch, high, free_high),
+		free_pcppages_bulk(zone, nr_pcp_free(pcp, zone, batch, high, free_high),
 				   pcp, pindex);
 		if (test_bit(ZONE_BELOW_HIGH, &zone->flags) &&
 		    zone_watermark_ok(zone, 0, high_wmark_pages(zone),
@@ -2883,7 +2929,8 @@ static int nr_pcp_alloc(struct per_cpu_pages *pcp, struct zone *zone, int order)
 	if (order)
 		batch = base_batch;
 	else
-		batch = (base_batch << pcp->alloc_factor);
+		batch = base_batch << min(pcp->alloc_factor + pcp->refill_factor,
+					  CONFIG_PCP_BATCH_SCALE_MAX);
 
 	/*
 	 * If we had larger pcp->high, we could avoid to allocate from
@@ -2928,8 +2975,10 @@ struct page *__rmqueue_pcplist(struct zone *zone, unsigned int order,
 
 	do {
 		if (list_empty(list)) {
-			int batch = nr_pcp_alloc(pcp, zone, order);
-			int alloced;
+			int batch, alloced;
+
+			pcp_update_refill_factor(pcp);
+			batch = nr_pcp_alloc(pcp, zone, order);
 
 			alloced = rmqueue_bulk(zone, order,
 					batch, list,
@@ -6266,6 +6315,15 @@ static struct ctl_table page_alloc_sysctl_table[] = {
 		.proc_handler	= percpu_pagelist_high_fraction_sysctl_handler,
 		.extra1		= SYSCTL_ZERO,
 	},
+	{
+		.procname	= "percpu_pagelist_adaptive_batch",
+		.data		= &percpu_pagelist_adaptive_batch,
+		.maxlen		= sizeof(percpu_pagelist_adaptive_batch),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 	{
 		.procname	= "lowmem_reserve_ratio",
 		.data		= &sysctl_lowmem_reserve_ratio,
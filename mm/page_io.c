@@ -515,18 +515,22 @@ void swap_read_folio(struct folio *folio, bool synchronous,
 		psi_memstall_enter(&pflags);
 	}
 	delayacct_swapin_start();
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	count_mthp_stat(folio_order(folio), MTHP_STAT_SWPIN);
+#endif
 
-	if (zswap_load(folio)) {
-		folio_mark_uptodate(folio);
-		folio_unlock(folio);
-	} else if (data_race(sis->flags & SWP_FS_OPS)) {
+	/* zswap_load() unlocks the folio when it handled the read */
+	if (zswap_load(folio))
+		goto finish;
+
+	if (data_race(sis->flags & SWP_FS_OPS))
 		swap_read_folio_fs(folio, plug);
-	} else if (synchronous || (sis->flags & SWP_SYNCHRONOUS_IO)) {
+	else if (synchronous || (sis->flags & SWP_SYNCHRONOUS_IO))
 		swap_read_folio_bdev_sync(folio, sis);
-	} else {
+	else
 		swap_read_folio_bdev_async(folio, sis);
-	}
 
+finish:
 	if (workingset) {
 		delayacct_thrashing_end(&in_thrashing);
 		psi_memstall_leave(&pflags);
@@ -11,6 +11,8 @@
 #include <linux/stackdepot.h>
 #include <linux/seq_file.h>
 #include <linux/memcontrol.h>
+#include <linux/percpu.h>
+#include <linux/random.h>
 #include <linux/sched/clock.h>
 
 #include "internal.h"
@@ -52,6 +54,19 @@ static depot_stack_handle_t dummy_handle;
 static depot_stack_handle_t failure_handle;
 static depot_stack_handle_t early_handle;
 
+/*
+ * Sampling mode: with page_owner_sample=N only about 1 in N allocations of
+ * each order records its stack, the others are left without a handle and
+ * skip the free stack as well.  The stack records page_owner adds to stack
+ * depot can be bounded by page_owner_stack_budget=; past it, only stacks
+ * that fit in the depot's current pool are still recorded.
+ */
+static unsigned int page_owner_sample_interval __read_mostly;
+static unsigned long page_owner_stack_budget __read_mostly;
+static atomic_long_t page_owner_stack_bytes;
+static atomic_long_t page_owner_stacks_dropped;
+static DEFINE_PER_CPU(int [NR_PAGE_ORDERS], page_owner_sample_countdown);
+
 static void init_early_allocated_pages(void);
 
 static inline void set_current_in_page_owner(void)
@@ -81,6 +96,21 @@ static int __init early_page_owner_param(char *buf)
 }
 early_param("page_owner", early_page_owner_param);
 
+static int __init early_page_owner_sample_param(char *buf)
+{
+	return kstrtouint(buf, 0, &page_owner_sample_interval);
+}
+early_param("page_owner_sample", early_page_owner_sample_param);
+
+static int __init early_page_owner_budget_param(char *buf)
+{
+	if (!buf)
+		return -EINVAL;
+	page_owner_stack_budget = memparse(buf, &buf);
+	return 0;
+}
+early_param("page_owner_stack_budget", early_page_owner_budget_param);
+
 static __init bool need_page_owner(void)
 {
 	return page_owner_enabled;
@@ -143,20 +173,51 @@ static inline struct page_owner *get_page_owner(struct page_ext *page_ext)
 	return page_ext_data(page_ext, &page_owner_ops);
 }
 
+static inline bool page_owner_sampled(unsigned short order)
+{
+	unsigned int interval = READ_ONCE(page_owner_sample_interval);
+
+	if (interval <= 1)
+		return true;
+
+	order = min_t(unsigned short, order, MAX_PAGE_ORDER);
+	if (this_cpu_dec_return(page_owner_sample_countdown[order]) > 0)
+		return false;
+
+	/* Jitter the period so that periodic allocation patterns don't alias */
+	this_cpu_write(page_owner_sample_countdown[order],
+		       interval / 2 + get_random_u32_below(interval) + 1);
+	return true;
+}
+
+static inline bool page_owner_over_budget(void)
+{
+	unsigned long budget = READ_ONCE(page_owner_stack_budget);
+
+	return budget && atomic_long_read(&page_owner_stack_bytes) >= budget;
+}
+
 static noinline depot_stack_handle_t save_stack(gfp_t flags)
 {
 	unsigned long entries[PAGE_OWNER_STACK_DEPTH];
+	depot_flags_t depot_flags = STACK_DEPOT_FLAG_CAN_ALLOC;
 	depot_stack_handle_t handle;
 	unsigned int nr_entries;
 
 	if (current->in_page_owner)
 		return dummy_handle;
 
+	if (page_owner_over_budget())
+		depot_flags = 0;
+
 	set_current_in_page_owner();
 	nr_entries = stack_trace_save(entries, ARRAY_SIZE(entries), 2);
-	handle = stack_depot_save(entries, nr_entries, flags);
-	if (!handle)
+	handle = stack_depot_save_flags(entries, nr_entries, flags, depot_flags);
+	if (!handle) {
+		if (!depot_flags)
+			atomic_long_inc(&page_owner_stacks_dropped);
 		handle = failure_handle;
+	}
 	unset_current_in_page_owner();
 
 	return handle;
@@ -168,6 +229,9 @@ static void add_stack_record_to_list(struct stack_record *stack_record,
 	unsigned long flags;
 	struct stack *stack;
 
+	atomic_long_add(sizeof(*stack_record) + sizeof(*stack),
+			&page_owner_stack_bytes);
+
 	set_current_in_page_owner();
 	stack = kmalloc(sizeof(*stack), gfp_nested_mask(gfp_mask));
 	if (!stack) {
@@ -256,6 +320,23 @@ static inline void __update_page_owner_handle(struct page_ext *page_ext,
 	}
 }
 
+/* An allocation that was not sampled: forget whatever the pages had before */
+static inline void __clear_page_owner_handle(struct page_ext *page_ext,
+					     unsigned short order)
+{
+	int i;
+	struct page_owner *page_owner;
+
+	for (i = 0; i < (1 << order); i++) {
+		page_owner = get_page_owner(page_ext);
+		page_owner->handle = 0;
+		page_owner->order = order;
+		__clear_bit(PAGE_EXT_OWNER, &page_ext->flags);
+		__clear_bit(PAGE_EXT_OWNER_ALLOCATED, &page_ext->flags);
+		page_ext = page_ext_next(page_ext);
+	}
+}
+
 static inline void __update_page_owner_free_handle(struct page_ext *page_ext,
 						   depot_stack_handle_t handle,
 						   unsigned short order,
@@ -294,6 +375,12 @@ void __reset_page_owner(struct page *page, unsigned short order)
 	page_owner = get_page_owner(page_ext);
 	alloc_handle = page_owner->handle;
 
+	/* Not sampled at allocation, so not worth a stack at free either */
+	if (!alloc_handle && READ_ONCE(page_owner_sample_interval) > 1) {
+		page_ext_put(page_ext);
+		return;
+	}
+
 	handle = save_stack(GFP_NOWAIT | __GFP_NOWARN);
 	__update_page_owner_free_handle(page_ext, handle, order, current->pid,
 					current->tgid, free_ts_nsec);
@@ -317,6 +404,15 @@ noinline void __set_page_owner(struct page *page, unsigned short order,
 	u64 ts_nsec = local_clock();
 	depot_stack_handle_t handle;
 
+	if (!page_owner_sampled(order)) {
+		page_ext = page_ext_get(page);
+		if (unlikely(!page_ext))
+			return;
+		__clear_page_owner_handle(page_ext, order);
+		page_ext_put(page_ext);
+		return;
+	}
+
 	handle = save_stack(gfp_mask);
 
 	page_ext = page_ext_get(page);
@@ -951,6 +1047,144 @@ static int page_owner_threshold_set(void *data, u64 val)
 DEFINE_SIMPLE_ATTRIBUTE(proc_page_owner_threshold, &page_owner_threshold_get,
 			&page_owner_threshold_set, "%llu");
 
+/*
+ * Binary stream of the stacks, for tools/mm/page_owner_sort -b: a header
+ * followed by one record per stack, each with its nr_entries return
+ * addresses.  Counts are of sampled base pages, scale by sample_interval.
+ */
+#define PAGE_OWNER_STACKS_MAGIC		0x504f5354	/* "POST" */
+#define PAGE_OWNER_STACKS_VERSION	1
+
+struct page_owner_stacks_hdr {
+	u32 magic;
+	u32 version;
+	u32 sample_interval;
+	u32 max_entries;
+	u64 stack_bytes;
+	u64 stacks_dropped;
+};
+
+struct page_owner_stacks_rec {
+	u64 nr_base_pages;
+	u32 handle;
+	u32 nr_entries;
+	u64 entries[];
+};
+
+static void *stack_bin_start(struct seq_file *m, loff_t *ppos)
+{
+	if (!*ppos)
+		return SEQ_START_TOKEN;
+	return stack_start(m, ppos);
+}
+
+static void *stack_bin_next(struct seq_file *m, void *v, loff_t *ppos)
+{
+	struct stack *stack;
+
+	if (v != SEQ_START_TOKEN)
+		return stack_next(m, v, ppos);
+
+	/* Pairs with smp_store_release() in add_stack_record_to_list() */
+	stack = smp_load_acquire(&stack_list);
+	*ppos = stack ? 1 : -1UL;
+	m->private = stack;
+	return stack;
+}
+
+static int stack_bin_print(struct seq_file *m, void *v)
+{
+	struct page_owner_stacks_rec rec;
+	struct stack *stack = v;
+	struct stack_record *stack_record;
+	int i, nr_base_pages;
+	u64 entry;
+
+	if (v == SEQ_START_TOKEN) {
+		struct page_owner_stacks_hdr hdr = {
+			.magic = PAGE_OWNER_STACKS_MAGIC,
+			.version = PAGE_OWNER_STACKS_VERSION,
+			.sample_interval = max(READ_ONCE(page_owner_sample_interval), 1U),
+			.max_entries = PAGE_OWNER_STACK_DEPTH,
+			.stack_bytes = atomic_long_read(&page_owner_stack_bytes),
+			.stacks_dropped = atomic_long_read(&page_owner_stacks_dropped),
+		};
+
+		seq_write(m, &hdr, sizeof(hdr));
+		return 0;
+	}
+
+	stack_record = stack->stack_record;
+	if (!stack_record)
+		return 0;
+
+	nr_base_pages = refcount_read(&stack_record->count) - 1;
+	if (nr_base_pages < 1 || nr_base_pages < page_owner_pages_threshold)
+		return 0;
+
+	rec.nr_base_pages = nr_base_pages;
+	rec.handle = stack_record->handle.handle;
+	rec.nr_entries = stack_record->size;
+	seq_write(m, &rec, sizeof(rec));
+	for (i = 0; i < rec.nr_entries; i++) {
+		entry = stack_record->entries[i];
+		seq_write(m, &entry, sizeof(entry));
+	}
+
+	return 0;
+}
+
+static const struct seq_operations page_owner_stack_bin_op = {
+	.start	= stack_bin_start,
+	.next	= stack_bin_next,
+	.stop	= stack_stop,
+	.show	= stack_bin_print
+};
+
+static int page_owner_stack_bin_open(struct inode *inode, struct file *file)
+{
+	return seq_open_private(file, &page_owner_stack_bin_op, 0);
+}
+
+static const struct file_operations page_owner_stack_bin_operations = {
+	.open		= page_owner_stack_bin_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int page_owner_sample_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(page_owner_sample_interval);
+	return 0;
+}
+
+static int page_owner_sample_set(void *data, u64 val)
+{
+	if (val > UINT_MAX)
+		return -EINVAL;
+	WRITE_ONCE(page_owner_sample_interval, val);
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(proc_page_owner_sample, &page_owner_sample_get,
+			&page_owner_sample_set, "%llu");
+
+static int page_owner_budget_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(page_owner_stack_budget);
+	return 0;
+}
+
+static int page_owner_budget_set(void *data, u64 val)
+{
+	WRITE_ONCE(page_owner_stack_budget, val);
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(proc_page_owner_budget, &page_owner_budget_get,
+			&page_owner_budget_set, "%llu");
+
 
 static int __init pageowner_init(void)
 {
@@ -968,6 +1202,12 @@ static int __init pageowner_init(void)
 			    &page_owner_stack_operations);
 	debugfs_create_file("count_threshold", 0600, dir, NULL,
 			    &proc_page_owner_threshold);
+	debugfs_create_file("stacks_bin", 0400, dir, NULL,
+			    &page_owner_stack_bin_operations);
+	debugfs_create_file("sample_interval", 0600, dir, NULL,
+			    &proc_page_owner_sample);
+	debugfs_create_file("stack_budget", 0600, dir, NULL,
+			    &proc_page_owner_budget);
 
 	return 0;
 }
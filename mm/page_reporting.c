@@ -106,16 +106,26 @@ page_reporting_drain(struct page_reporting_dev_info *prdev,
 		     struct scatterlist *sgl, unsigned int nents, bool reported)
 {
 	struct scatterlist *sg = sgl;
+	struct zone *zone = NULL;
 
 	/*
 	 * Drain the now reported pages back into their respective
 	 * free lists/areas. We assume at least one page is populated.
+	 * The pages may come from several zones, a batch is carried
+	 * over from one zone to the next.
 	 */
 	do {
 		struct page *page = sg_page(sg);
 		int mt = get_pageblock_migratetype(page);
 		unsigned int order = get_order(sg->length);
 
+		if (page_zone(page) != zone) {
+			if (zone)
+				spin_unlock_irq(&zone->lock);
+			zone = page_zone(page);
+			spin_lock_irq(&zone->lock);
+		}
+
 		__putback_isolated_page(page, order, mt);
 
 		/* If the pages were not reported due to error skip flagging */
@@ -133,6 +143,8 @@ page_reporting_drain(struct page_reporting_dev_info *prdev,
 			__SetPageReported(page);
 	} while ((sg = sg_next(sg)));
 
+	spin_unlock_irq(&zone->lock);
+
 	/* reinitialize scatterlist now that it is empty */
 	sg_init_table(sgl, nents);
 }
@@ -230,12 +242,12 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 		/* update budget to reflect call to report function */
 		budget--;
 
-		/* reacquire zone lock and resume processing */
-		spin_lock_irq(&zone->lock);
-
 		/* flush reported pages from the sg list */
 		page_reporting_drain(prdev, sgl, PAGE_REPORTING_CAPACITY, !err);
 
+		/* reacquire zone lock and resume processing */
+		spin_lock_irq(&zone->lock);
+
 		/*
 		 * Reset next to first entry, the old next isn't valid
 		 * since we dropped the lock to report the pages
@@ -258,9 +270,10 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 
 static int
 page_reporting_process_zone(struct page_reporting_dev_info *prdev,
-			    struct scatterlist *sgl, struct zone *zone)
+			    struct scatterlist *sgl, struct zone *zone,
+			    unsigned int *offset)
 {
-	unsigned int order, mt, leftover, offset = PAGE_REPORTING_CAPACITY;
+	unsigned int order, mt;
 	unsigned long watermark;
 	int err = 0;
 
@@ -283,24 +296,12 @@ page_reporting_process_zone(struct page_reporting_dev_info *prdev,
 				continue;
 
 			err = page_reporting_cycle(prdev, zone, order, mt,
-						   sgl, &offset);
+						   sgl, offset);
 			if (err)
 				return err;
 		}
 	}
 
-	/* report the leftover pages before going idle */
-	leftover = PAGE_REPORTING_CAPACITY - offset;
-	if (leftover) {
-		sgl = &sgl[offset];
-		err = prdev->report(prdev, sgl, leftover);
-
-		/* flush any remaining pages out from the last report */
-		spin_lock_irq(&zone->lock);
-		page_reporting_drain(prdev, sgl, leftover, !err);
-		spin_unlock_irq(&zone->lock);
-	}
-
 	return err;
 }
 
@@ -309,6 +310,7 @@ static void page_reporting_process(struct work_struct *work)
 	struct delayed_work *d_work = to_delayed_work(work);
 	struct page_reporting_dev_info *prdev =
 		container_of(d_work, struct page_reporting_dev_info, work);
+	unsigned int leftover, offset = PAGE_REPORTING_CAPACITY;
 	int err = 0, state = PAGE_REPORTING_ACTIVE;
 	struct scatterlist *sgl;
 	struct zone *zone;
@@ -328,12 +330,25 @@ static void page_reporting_process(struct work_struct *work)
 
 	sg_init_table(sgl, PAGE_REPORTING_CAPACITY);
 
+	/*
+	 * A partially filled scatterlist is carried over to the next zone,
+	 * so most reports are full ones even with many small zones.
+	 */
 	for_each_zone(zone) {
-		err = page_reporting_process_zone(prdev, sgl, zone);
+		err = page_reporting_process_zone(prdev, sgl, zone, &offset);
 		if (err)
 			break;
 	}
 
+	/* report the leftover pages before going idle */
+	leftover = PAGE_REPORTING_CAPACITY - offset;
+	if (leftover) {
+		err = prdev->report(prdev, &sgl[offset], leftover);
+
+		/* flush any remaining pages out from the last report */
+		page_reporting_drain(prdev, &sgl[offset], leftover, !err);
+	}
+
 	kfree(sgl);
 err_out:
 	/*
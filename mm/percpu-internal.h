@@ -175,6 +175,10 @@ struct percpu_stats {
 	u32 nr_max_chunks;	/* max # of live chunks */
 	size_t min_alloc_size;	/* min allocation size */
 	size_t max_alloc_size;	/* max allocation size */
+	u64 nr_fast_alloc;	/* # of allocations without pcpu_alloc_mutex */
+	u64 nr_hint_alloc;	/* # of allocations from a size class hint */
+	u64 nr_lock_contended;	/* # of times pcpu_lock was busy */
+	u64 nr_mutex_contended;	/* # of times pcpu_alloc_mutex was busy */
 };
 
 extern struct percpu_stats pcpu_stats;
@@ -233,6 +237,58 @@ static inline void pcpu_stats_area_dealloc(struct pcpu_chunk *chunk)
 	chunk->nr_alloc--;
 }
 
+/*
+ * pcpu_stats_fast_alloc - count an allocation which skipped pcpu_alloc_mutex
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ */
+static inline void pcpu_stats_fast_alloc(void)
+{
+	lockdep_assert_held(&pcpu_lock);
+
+	pcpu_stats.nr_fast_alloc++;
+}
+
+/*
+ * pcpu_stats_hint_alloc - count an allocation served by a size class hint
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ */
+static inline void pcpu_stats_hint_alloc(void)
+{
+	lockdep_assert_held(&pcpu_lock);
+
+	pcpu_stats.nr_hint_alloc++;
+}
+
+/*
+ * pcpu_stats_lock_contended - count a wait for pcpu_lock
+ *
+ * CONTEXT:
+ * pcpu_lock, taken after the wait.
+ */
+static inline void pcpu_stats_lock_contended(void)
+{
+	lockdep_assert_held(&pcpu_lock);
+
+	pcpu_stats.nr_lock_contended++;
+}
+
+/*
+ * pcpu_stats_mutex_contended - count a wait for pcpu_alloc_mutex
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ */
+static inline void pcpu_stats_mutex_contended(void)
+{
+	lockdep_assert_held(&pcpu_lock);
+
+	pcpu_stats.nr_mutex_contended++;
+}
+
 /*
  * pcpu_stats_chunk_alloc - increment chunk stats
  */
@@ -275,6 +331,22 @@ static inline void pcpu_stats_area_dealloc(struct pcpu_chunk *chunk)
 {
 }
 
+static inline void pcpu_stats_fast_alloc(void)
+{
+}
+
+static inline void pcpu_stats_hint_alloc(void)
+{
+}
+
+static inline void pcpu_stats_lock_contended(void)
+{
+}
+
+static inline void pcpu_stats_mutex_contended(void)
+{
+}
+
 static inline void pcpu_stats_chunk_alloc(void)
 {
 }
@@ -188,6 +188,10 @@ static int percpu_stats_show(struct seq_file *m, void *v)
 	PU(nr_max_chunks);
 	PU(min_alloc_size);
 	PU(max_alloc_size);
+	PU(nr_fast_alloc);
+	PU(nr_hint_alloc);
+	PU(nr_lock_contended);
+	PU(nr_mutex_contended);
 	P("empty_pop_pages", pcpu_nr_empty_pop_pages);
 	seq_putc(m, '\n');
 
@@ -109,6 +109,9 @@
 #define PCPU_EMPTY_POP_PAGES_LOW	2
 #define PCPU_EMPTY_POP_PAGES_HIGH	4
 
+/* size classes with a chunk hint, up to 64 << PCPU_MIN_ALLOC_SHIFT bytes */
+#define PCPU_NR_HINT_CLASSES		7
+
 #ifdef CONFIG_SMP
 /* default addr <-> pcpu_ptr mapping, override in asm/percpu.h if necessary */
 #ifndef __addr_to_pcpu_ptr
@@ -171,6 +174,12 @@ struct pcpu_chunk *pcpu_reserved_chunk __ro_after_init;
 DEFINE_SPINLOCK(pcpu_lock);	/* all internal data structures */
 static DEFINE_MUTEX(pcpu_alloc_mutex);	/* chunk create/destroy, [de]pop, map ext */
 
+/*
+ * The chunk which served the last allocation of each small size class, tried
+ * before the slot lists are scanned.  Protected by pcpu_lock.
+ */
+static struct pcpu_chunk *pcpu_class_hint[PCPU_NR_HINT_CLASSES];
+
 struct list_head *pcpu_chunk_lists __ro_after_init; /* chunk list slots */
 
 /*
@@ -1725,6 +1734,96 @@ static void pcpu_alloc_tag_free_hook(struct pcpu_chunk *chunk, int off, size_t s
 }
 #endif
 
+/*
+ * With CONFIG_PERCPU_STATS, count the times pcpu_lock was already held when
+ * we got to it.
+ */
+#define pcpu_lock_irqsave(flags)					\
+do {									\
+	if (!IS_ENABLED(CONFIG_PERCPU_STATS) ||				\
+	    !spin_trylock_irqsave(&pcpu_lock, flags)) {			\
+		spin_lock_irqsave(&pcpu_lock, flags);			\
+		pcpu_stats_lock_contended();				\
+	}								\
+} while (0)
+
+static void pcpu_forget_class_hints(struct pcpu_chunk *chunk)
+{
+	int i;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	for (i = 0; i < PCPU_NR_HINT_CLASSES; i++)
+		if (pcpu_class_hint[i] == chunk)
+			pcpu_class_hint[i] = NULL;
+}
+
+/**
+ * pcpu_alloc_normal - allocate an area from the normal chunks
+ * @bits: size of the area in bitmap bits
+ * @bit_align: alignment of the area in bitmap bits
+ * @pop_only: only allocate from already populated memory
+ * @chunkp: the chunk the area was allocated from
+ *
+ * Small allocations first try the chunk their size class was last served
+ * from, which usually still has room, and only scan the chunk slots from
+ * the one fitting @bits upwards when that fails.
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * Allocated offset in @chunkp on success, -1 if no area was found.
+ */
+static int pcpu_alloc_normal(int bits, size_t bit_align, bool pop_only,
+			     struct pcpu_chunk **chunkp)
+{
+	int class = order_base_2(bits);
+	struct pcpu_chunk *chunk, *next;
+	int slot, off;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	if (class < PCPU_NR_HINT_CLASSES) {
+		chunk = pcpu_class_hint[class];
+		if (chunk && !chunk->isolated) {
+			off = pcpu_find_block_fit(chunk, bits, bit_align, pop_only);
+			if (off >= 0)
+				off = pcpu_alloc_area(chunk, bits, bit_align, off);
+			if (off >= 0) {
+				pcpu_stats_hint_alloc();
+				*chunkp = chunk;
+				return off;
+			}
+		}
+	}
+
+	for (slot = pcpu_size_to_slot(bits << PCPU_MIN_ALLOC_SHIFT);
+	     slot <= pcpu_free_slot; slot++) {
+		list_for_each_entry_safe(chunk, next, &pcpu_chunk_lists[slot],
+					 list) {
+			off = pcpu_find_block_fit(chunk, bits, bit_align,
+						  pop_only);
+			if (off < 0) {
+				if (slot < PCPU_SLOT_FAIL_THRESHOLD)
+					pcpu_chunk_move(chunk, 0);
+				continue;
+			}
+
+			off = pcpu_alloc_area(chunk, bits, bit_align, off);
+			if (off >= 0) {
+				pcpu_reintegrate_chunk(chunk);
+				if (class < PCPU_NR_HINT_CLASSES)
+					pcpu_class_hint[class] = chunk;
+				*chunkp = chunk;
+				return off;
+			}
+		}
+	}
+
+	return -1;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1746,11 +1845,12 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	gfp_t pcpu_gfp;
 	bool is_atomic;
 	bool do_warn;
+	bool mutex_held = false, mutex_contended = false;
 	struct obj_cgroup *objcg = NULL;
 	static int warn_limit = 10;
-	struct pcpu_chunk *chunk, *next;
+	struct pcpu_chunk *chunk;
 	const char *err;
-	int slot, off, cpu, ret;
+	int off, cpu, ret;
 	unsigned long flags;
 	void __percpu *ptr;
 	size_t bits, bit_align;
@@ -1784,21 +1884,44 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	/*
+	 * Small allocations which fit in populated memory of an existing chunk
+	 * don't need pcpu_alloc_mutex, just like atomic ones: an allocated area
+	 * keeps its chunk and pages from being freed.  Try that first, so that
+	 * they don't queue up behind chunk creation and population.
+	 */
+	if (!is_atomic && !reserved &&
+	    order_base_2(bits) < PCPU_NR_HINT_CLASSES) {
+		pcpu_lock_irqsave(flags);
+		off = pcpu_alloc_normal(bits, bit_align, true, &chunk);
+		if (off >= 0) {
+			pcpu_stats_fast_alloc();
+			goto area_found;
+		}
+		spin_unlock_irqrestore(&pcpu_lock, flags);
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
 		 * and it may wait for memory reclaim. Allow current task
 		 * to become OOM victim, in case of memory pressure.
 		 */
-		if (gfp & __GFP_NOFAIL) {
-			mutex_lock(&pcpu_alloc_mutex);
-		} else if (mutex_lock_killable(&pcpu_alloc_mutex)) {
-			pcpu_memcg_post_alloc_hook(objcg, NULL, 0, size);
-			return NULL;
+		if (!mutex_trylock(&pcpu_alloc_mutex)) {
+			mutex_contended = true;
+			if (gfp & __GFP_NOFAIL) {
+				mutex_lock(&pcpu_alloc_mutex);
+			} else if (mutex_lock_killable(&pcpu_alloc_mutex)) {
+				pcpu_memcg_post_alloc_hook(objcg, NULL, 0, size);
+				return NULL;
+			}
 		}
+		mutex_held = true;
 	}
 
-	spin_lock_irqsave(&pcpu_lock, flags);
+	pcpu_lock_irqsave(flags);
+	if (mutex_contended)
+		pcpu_stats_mutex_contended();
 
 	/* serve reserved allocations from the reserved chunk if available */
 	if (reserved && pcpu_reserved_chunk) {
@@ -1820,24 +1943,9 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 
 restart:
 	/* search through normal chunks */
-	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
-		list_for_each_entry_safe(chunk, next, &pcpu_chunk_lists[slot],
-					 list) {
-			off = pcpu_find_block_fit(chunk, bits, bit_align,
-						  is_atomic);
-			if (off < 0) {
-				if (slot < PCPU_SLOT_FAIL_THRESHOLD)
-					pcpu_chunk_move(chunk, 0);
-				continue;
-			}
-
-			off = pcpu_alloc_area(chunk, bits, bit_align, off);
-			if (off >= 0) {
-				pcpu_reintegrate_chunk(chunk);
-				goto area_found;
-			}
-		}
-	}
+	off = pcpu_alloc_normal(bits, bit_align, is_atomic, &chunk);
+	if (off >= 0)
+		goto area_found;
 
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
@@ -1867,7 +1975,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
 	/* populate if not all pages are already there */
-	if (!is_atomic) {
+	if (mutex_held) {
 		unsigned int page_end, rs, re;
 
 		rs = PFN_DOWN(off);
@@ -1969,8 +2077,10 @@ static void pcpu_balance_free(bool empty_only)
 		if (chunk == list_first_entry(free_head, struct pcpu_chunk, list))
 			continue;
 
-		if (!empty_only || chunk->nr_empty_pop_pages == 0)
+		if (!empty_only || chunk->nr_empty_pop_pages == 0) {
+			pcpu_forget_class_hints(chunk);
 			list_move(&chunk->list, &to_free);
+		}
 	}
 
 	if (list_empty(&to_free))
@@ -2273,7 +2383,7 @@ void free_percpu(void __percpu *ptr)
 	chunk = pcpu_chunk_addr_search(addr);
 	off = addr - chunk->base_addr;
 
-	spin_lock_irqsave(&pcpu_lock, flags);
+	pcpu_lock_irqsave(flags);
 	size = pcpu_free_area(chunk, off);
 
 	pcpu_alloc_tag_free_hook(chunk, off, size);
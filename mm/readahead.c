@@ -547,6 +547,66 @@ void page_cache_ra_order(struct readahead_control *ractl,
 	do_page_cache_ra(ractl, ra->size, ra->async_size);
 }
 
+/*
+ * Readahead history.
+ *
+ * On a bdi with BDI_CAP_RA_HISTORY set, the address_space remembers the
+ * window its last sequential reader ramped up to, and the stride of its
+ * last strided reader. A struct file opened later on the same inode
+ * starts at that window, or prefetches along that stride, instead of
+ * relearning the pattern from a cold file_ra_state.
+ */
+static inline bool ra_history_enabled(struct backing_dev_info *bdi)
+{
+	return bdi->capabilities & BDI_CAP_RA_HISTORY;
+}
+
+static void ra_history_save_size(struct address_space *mapping,
+				 unsigned long size)
+{
+	if (READ_ONCE(mapping->ra_hist_size) != size)
+		WRITE_ONCE(mapping->ra_hist_size, size);
+}
+
+/*
+ * Strided reads of req_size pages, each starting stride pages after the
+ * previous one. The pattern counts as established once the same stride
+ * is seen twice in a row, or as soon as a fresh file sees the stride
+ * recorded for its inode. Then read the current block, plus as many of
+ * the following ones as fit into the readahead window.
+ */
+static bool try_stride_readahead(struct readahead_control *ractl,
+				 pgoff_t index, pgoff_t prev_index,
+				 unsigned long req_size, unsigned long max)
+{
+	struct address_space *mapping = ractl->mapping;
+	struct file_ra_state *ra = ractl->ra;
+	unsigned long stride, hist, nr;
+
+	hist = READ_ONCE(mapping->ra_hist_stride);
+	if (ra->prev_pos == -1) {
+		stride = hist;
+	} else {
+		stride = index - prev_index + req_size - 1;
+		if (stride != hist) {
+			WRITE_ONCE(mapping->ra_hist_stride,
+				   stride <= UINT_MAX ? stride : 0);
+			return false;
+		}
+	}
+
+	if (stride <= req_size)
+		return false;
+
+	for (nr = 0; nr < max; nr += req_size) {
+		ractl->_index = index;
+		do_page_cache_ra(ractl, req_size, 0);
+		index += stride;
+	}
+
+	return true;
+}
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -560,6 +620,7 @@ static void ondemand_readahead(struct readahead_control *ractl,
 	pgoff_t index = readahead_index(ractl);
 	pgoff_t expected, prev_index;
 	unsigned int order = folio ? folio_order(folio) : 0;
+	bool history = ra_history_enabled(bdi);
 
 	/*
 	 * If the request exceeds the readahead window, allow the read to
@@ -635,6 +696,10 @@ static void ondemand_readahead(struct readahead_control *ractl,
 			max_pages))
 		goto readit;
 
+	if (history && try_stride_readahead(ractl, index, prev_index,
+					    req_size, max_pages))
+		return;
+
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
@@ -643,8 +708,15 @@ static void ondemand_readahead(struct readahead_control *ractl,
 	return;
 
 initial_readahead:
+	add_pages = get_init_ra_size(req_size, max_pages);
+	/* A new reader of a known sequential stream skips the ramp up */
+	if (history && !ra->size) {
+		add_pages = max_t(unsigned long, add_pages,
+				  READ_ONCE(ractl->mapping->ra_hist_size));
+		add_pages = min(add_pages, max_pages);
+	}
 	ra->start = index;
-	ra->size = get_init_ra_size(req_size, max_pages);
+	ra->size = add_pages;
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
 
 readit:
@@ -665,6 +737,9 @@ static void ondemand_readahead(struct readahead_control *ractl,
 		}
 	}
 
+	if (history)
+		ra_history_save_size(ractl->mapping, ra->size);
+
 	ractl->_index = ra->start;
 	page_cache_ra_order(ractl, ra, order);
 }
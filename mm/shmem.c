@@ -39,6 +39,7 @@
 #include <linux/hugetlb.h>
 #include <linux/fs_parser.h>
 #include <linux/swapfile.h>
+#include <linux/zswap.h>
 #include <linux/iversion.h>
 #include "swap.h"
 
@@ -119,6 +120,7 @@ struct shmem_options {
 	umode_t mode;
 	bool full_inums;
 	int huge;
+	unsigned long huge_orders;
 	int seen;
 	bool noswap;
 	unsigned short quota_types;
@@ -129,6 +131,7 @@ struct shmem_options {
 #define SHMEM_SEEN_INUMS 8
 #define SHMEM_SEEN_NOSWAP 16
 #define SHMEM_SEEN_QUOTA 32
+#define SHMEM_SEEN_HUGE_ORDERS 64
 };
 
 #ifdef CONFIG_TMPFS
@@ -573,6 +576,25 @@ bool shmem_is_huge(struct inode *inode, pgoff_t index, bool shmem_huge_force,
 	}
 }
 
+/*
+ * Folio orders below PMD size allowed by the huge_orders= mount option for
+ * a new folio of @inode.  They are tried, highest first, after the PMD
+ * size allowed by huge=, both for allocations and for swapin.
+ */
+static unsigned long shmem_mthp_orders(struct inode *inode,
+				       struct mm_struct *mm,
+				       unsigned long vm_flags)
+{
+	if (!S_ISREG(inode->i_mode))
+		return 0;
+	if (mm && ((vm_flags & VM_NOHUGEPAGE) || test_bit(MMF_DISABLE_THP, &mm->flags)))
+		return 0;
+	if (shmem_huge == SHMEM_HUGE_DENY)
+		return 0;
+
+	return READ_ONCE(SHMEM_SB(inode->i_sb)->huge_orders);
+}
+
 #if defined(CONFIG_SYSFS)
 static int shmem_parse_huge(const char *str)
 {
@@ -748,6 +770,13 @@ static long shmem_unused_huge_count(struct super_block *sb,
 
 #define shmem_huge SHMEM_HUGE_DENY
 
+static unsigned long shmem_mthp_orders(struct inode *inode,
+				       struct mm_struct *mm,
+				       unsigned long vm_flags)
+{
+	return 0;
+}
+
 static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 		struct shrink_control *sc, unsigned long nr_to_split)
 {
@@ -768,7 +797,6 @@ static int shmem_add_to_page_cache(struct folio *folio,
 	VM_BUG_ON_FOLIO(index != round_down(index, nr), folio);
 	VM_BUG_ON_FOLIO(!folio_test_locked(folio), folio);
 	VM_BUG_ON_FOLIO(!folio_test_swapbacked(folio), folio);
-	VM_BUG_ON(expected && folio_test_large(folio));
 
 	folio_ref_add(folio, nr);
 	folio->mapping = mapping;
@@ -779,11 +807,29 @@ static int shmem_add_to_page_cache(struct folio *folio,
 
 	do {
 		xas_lock_irq(&xas);
-		if (expected != xas_find_conflict(&xas)) {
-			xas_set_err(&xas, -EEXIST);
-			goto unlock;
-		}
-		if (expected && xas_find_conflict(&xas)) {
+		if (expected) {
+			swp_entry_t swap = radix_to_swp_entry(expected);
+			void *entry;
+			long i = 0;
+
+			/*
+			 * A large folio read from swap replaces the run of
+			 * consecutive swap entries starting at @expected.
+			 */
+			xas_for_each_conflict(&xas, entry) {
+				if (i >= nr || entry != swp_to_radix_entry(
+						swp_entry(swp_type(swap),
+							  swp_offset(swap) + i))) {
+					xas_set_err(&xas, -EEXIST);
+					goto unlock;
+				}
+				i++;
+			}
+			if (i != nr) {
+				xas_set_err(&xas, -EEXIST);
+				goto unlock;
+			}
+		} else if (xas_find_conflict(&xas)) {
 			xas_set_err(&xas, -EEXIST);
 			goto unlock;
 		}
@@ -1603,37 +1649,38 @@ static gfp_t limit_gfp_mask(gfp_t huge_gfp, gfp_t limit_gfp)
 	return result;
 }
 
-static struct folio *shmem_alloc_hugefolio(gfp_t gfp,
+static struct folio *shmem_alloc_folio(gfp_t gfp, int order,
 		struct shmem_inode_info *info, pgoff_t index)
 {
 	struct mempolicy *mpol;
 	pgoff_t ilx;
 	struct page *page;
 
-	mpol = shmem_get_pgoff_policy(info, index, HPAGE_PMD_ORDER, &ilx);
-	page = alloc_pages_mpol(gfp, HPAGE_PMD_ORDER, mpol, ilx, numa_node_id());
+	mpol = shmem_get_pgoff_policy(info, index, order, &ilx);
+	page = alloc_pages_mpol(gfp, order, mpol, ilx, numa_node_id());
 	mpol_cond_put(mpol);
 
 	return page_rmappable_folio(page);
 }
 
-static struct folio *shmem_alloc_folio(gfp_t gfp,
-		struct shmem_inode_info *info, pgoff_t index)
+static void shmem_count_fallback(int order, bool charge)
 {
-	struct mempolicy *mpol;
-	pgoff_t ilx;
-	struct page *page;
-
-	mpol = shmem_get_pgoff_policy(info, index, 0, &ilx);
-	page = alloc_pages_mpol(gfp, 0, mpol, ilx, numa_node_id());
-	mpol_cond_put(mpol);
+	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE))
+		return;
 
-	return (struct folio *)page;
+	if (order == PMD_ORDER) {
+		count_vm_event(THP_FILE_FALLBACK);
+		if (charge)
+			count_vm_event(THP_FILE_FALLBACK_CHARGE);
+	}
+	count_mthp_stat(order, MTHP_STAT_SHMEM_FALLBACK);
+	if (charge)
+		count_mthp_stat(order, MTHP_STAT_SHMEM_FALLBACK_CHARGE);
 }
 
 static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		struct inode *inode, pgoff_t index,
-		struct mm_struct *fault_mm, bool huge)
+		struct mm_struct *fault_mm, int order)
 {
 	struct address_space *mapping = inode->i_mapping;
 	struct shmem_inode_info *info = SHMEM_I(inode);
@@ -1642,11 +1689,11 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 	int error;
 
 	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE))
-		huge = false;
+		order = 0;
 
-	if (huge) {
-		pages = HPAGE_PMD_NR;
-		index = round_down(index, HPAGE_PMD_NR);
+	pages = 1L << order;
+	if (order) {
+		index = round_down(index, pages);
 
 		/*
 		 * Check for conflict before waiting on a huge allocation.
@@ -1657,18 +1704,16 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		 * Elsewhere -EEXIST would be the right code, but not here.
 		 */
 		if (xa_find(&mapping->i_pages, &index,
-				index + HPAGE_PMD_NR - 1, XA_PRESENT))
+				index + pages - 1, XA_PRESENT))
 			return ERR_PTR(-E2BIG);
-
-		folio = shmem_alloc_hugefolio(gfp, info, index);
-		if (!folio)
-			count_vm_event(THP_FILE_FALLBACK);
-	} else {
-		pages = 1;
-		folio = shmem_alloc_folio(gfp, info, index);
 	}
-	if (!folio)
+
+	folio = shmem_alloc_folio(gfp, order, info, index);
+	if (!folio) {
+		if (order)
+			shmem_count_fallback(order, false);
 		return ERR_PTR(-ENOMEM);
+	}
 
 	__folio_set_locked(folio);
 	__folio_set_swapbacked(folio);
@@ -1679,9 +1724,8 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		if (xa_find(&mapping->i_pages, &index,
 				index + pages - 1, XA_PRESENT)) {
 			error = -EEXIST;
-		} else if (huge) {
-			count_vm_event(THP_FILE_FALLBACK);
-			count_vm_event(THP_FILE_FALLBACK_CHARGE);
+		} else if (order) {
+			shmem_count_fallback(order, true);
 		}
 		goto unlock;
 	}
@@ -1765,7 +1809,7 @@ static int shmem_replace_folio(struct folio **foliop, gfp_t gfp,
 	 */
 	gfp &= ~GFP_CONSTRAINT_MASK;
 	VM_BUG_ON_FOLIO(folio_test_large(old), old);
-	new = shmem_alloc_folio(gfp, info, index);
+	new = shmem_alloc_folio(gfp, 0, info, index);
 	if (!new)
 		return -ENOMEM;
 
@@ -1818,14 +1862,28 @@ static void shmem_set_folio_swapin_error(struct inode *inode, pgoff_t index,
 					 struct folio *folio, swp_entry_t swap)
 {
 	struct address_space *mapping = inode->i_mapping;
+	long i, nr = folio_nr_pages(folio), nr_poisoned = 0;
 	swp_entry_t swapin_error;
 	void *old;
 
+	/* Poison every index of a large folio, starting from its first */
+	index -= swp_offset(swap) - swp_offset(folio->swap);
+	swap = folio->swap;
+
 	swapin_error = make_poisoned_swp_entry();
-	old = xa_cmpxchg_irq(&mapping->i_pages, index,
-			     swp_to_radix_entry(swap),
-			     swp_to_radix_entry(swapin_error), 0);
-	if (old != swp_to_radix_entry(swap))
+	for (i = 0; i < nr; i++) {
+		swp_entry_t entry = swp_entry(swp_type(swap),
+					      swp_offset(swap) + i);
+
+		old = xa_cmpxchg_irq(&mapping->i_pages, index + i,
+				     swp_to_radix_entry(entry),
+				     swp_to_radix_entry(swapin_error), 0);
+		if (old != swp_to_radix_entry(entry))
+			continue;
+		swap_free(entry);
+		nr_poisoned++;
+	}
+	if (!nr_poisoned)
 		return;
 
 	folio_wait_writeback(folio);
@@ -1835,9 +1893,124 @@ static void shmem_set_folio_swapin_error(struct inode *inode, pgoff_t index,
 	 * won't be 0 when inode is released and thus trigger WARN_ON(i_blocks)
 	 * in shmem_evict_inode().
 	 */
-	shmem_recalc_inode(inode, -1, -1);
-	swap_free(swap);
+	shmem_recalc_inode(inode, -nr_poisoned, -nr_poisoned);
+}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Check that the @nr indices from @index hold the consecutive swap entries
+ * starting at @swap.
+ */
+static bool shmem_swap_range_contiguous(struct address_space *mapping,
+		pgoff_t index, swp_entry_t swap, long nr)
+{
+	XA_STATE(xas, &mapping->i_pages, index);
+	void *entry;
+	long i = 0;
+
+	rcu_read_lock();
+	xas_for_each(&xas, entry, index + nr - 1) {
+		if (xas_retry(&xas, entry))
+			continue;
+		if (xas.xa_index != index + i ||
+		    entry != swp_to_radix_entry(swp_entry(swp_type(swap),
+						swp_offset(swap) + i)))
+			break;
+		i++;
+	}
+	rcu_read_unlock();
+
+	return i == nr;
+}
+
+/*
+ * Read the swap entry @swap at @index back as part of a large folio, of
+ * the highest order allowed for @inode whose aligned range holds a run of
+ * naturally aligned swap entries that can be read as one.  Returns NULL
+ * if there is none, letting the caller fall back to a small folio.
+ */
+static struct folio *shmem_swapin_large(struct inode *inode, pgoff_t index,
+		swp_entry_t swap, gfp_t gfp, struct mm_struct *fault_mm)
+{
+	struct address_space *mapping = inode->i_mapping;
+	struct shmem_inode_info *info = SHMEM_I(inode);
+	unsigned long orders;
+	struct folio *folio;
+	void *shadow = NULL;
+	int order;
+
+	orders = shmem_mthp_orders(inode, fault_mm, 0);
+	orders &= BIT(ilog2(SWAPFILE_CLUSTER) + 1) - 1;
+	if (!orders)
+		return NULL;
+
+	order = highest_order(orders);
+	while (orders) {
+		long nr = 1L << order;
+		pgoff_t aligned = round_down(index, nr);
+		swp_entry_t base = swp_entry(swp_type(swap),
+					     swp_offset(swap) - (index - aligned));
+		int nr_zswap;
+
+		if (swp_offset(swap) < index - aligned ||
+		    !IS_ALIGNED(swp_offset(base), nr) ||
+		    !shmem_swap_range_contiguous(mapping, aligned, base, nr) ||
+		    non_swapcache_batch(base, nr) != nr)
+			goto next;
+		/* zswap can only fill the folio if it holds all or none */
+		nr_zswap = zswap_nr_present(base, nr);
+		if (nr_zswap && nr_zswap != nr)
+			goto next;
+
+		folio = shmem_alloc_folio(limit_gfp_mask(vma_thp_gfp_mask(NULL),
+							 gfp),
+					  order, info, aligned);
+		if (!folio) {
+			count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK);
+			goto next;
+		}
+		/* Pin the entries, they may have been freed or cached */
+		if (swapcache_prepare(base, nr)) {
+			folio_put(folio);
+			count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK);
+			goto next;
+		}
+
+		__folio_set_locked(folio);
+		__folio_set_swapbacked(folio);
+		if (mem_cgroup_swapin_charge_folio(folio, NULL, gfp, base)) {
+			count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK_CHARGE);
+			goto fail_unlock;
+		}
+		if (add_to_swap_cache(folio, base, gfp & GFP_RECLAIM_MASK,
+				      &shadow))
+			goto fail_unlock;
+
+		mem_cgroup_swapin_uncharge_swap(base, nr);
+		if (shadow)
+			workingset_refault(folio, shadow);
+		folio_add_lru(folio);
+		swap_read_folio(folio, false, NULL);
+		return folio;
+
+fail_unlock:
+		put_swap_folio(folio, base);
+		folio_unlock(folio);
+		folio_put(folio);
+		count_mthp_stat(order, MTHP_STAT_SWPIN_FALLBACK);
+next:
+		order = next_order(&orders, order);
+	}
+
+	return NULL;
+}
+#else
+static struct folio *shmem_swapin_large(struct inode *inode, pgoff_t index,
+		swp_entry_t swap, gfp_t gfp, struct mm_struct *fault_mm)
+{
+	return NULL;
 }
+#endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
 /*
  * Swap in the folio pointed to by *foliop.
@@ -1854,7 +2027,9 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 	struct shmem_inode_info *info = SHMEM_I(inode);
 	struct swap_info_struct *si;
 	struct folio *folio = NULL;
-	swp_entry_t swap;
+	swp_entry_t swap, base;
+	pgoff_t offset;
+	long nr;
 	int error;
 
 	VM_BUG_ON(!*foliop || !xa_is_value(*foliop));
@@ -1882,7 +2057,9 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 			count_memcg_event_mm(fault_mm, PGMAJFAULT);
 		}
 		/* Here we actually start the io */
-		folio = shmem_swapin_cluster(swap, gfp, info, index);
+		folio = shmem_swapin_large(inode, index, swap, gfp, fault_mm);
+		if (!folio)
+			folio = shmem_swapin_cluster(swap, gfp, info, index);
 		if (!folio) {
 			error = -ENOMEM;
 			goto failed;
@@ -1891,8 +2068,12 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 
 	/* We have to do this with folio locked to prevent races */
 	folio_lock(folio);
+	nr = folio_nr_pages(folio);
+	offset = swp_offset(swap) - swp_offset(folio->swap);
 	if (!folio_test_swapcache(folio) ||
-	    folio->swap.val != swap.val ||
+	    swp_type(folio->swap) != swp_type(swap) ||
+	    swp_offset(folio->swap) > swp_offset(swap) || offset >= nr ||
+	    (index & (nr - 1)) != offset ||
 	    !shmem_confirm_swap(mapping, index, swap)) {
 		error = -EEXIST;
 		goto unlock;
@@ -1909,25 +2090,30 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 	 */
 	arch_swap_restore(folio_swap(swap, folio), folio);
 
-	if (shmem_should_replace_folio(folio, gfp)) {
+	/*
+	 * Large folios are only read in by shmem_swapin_large(), which
+	 * allocated them with the mapping's gfp already.
+	 */
+	if (nr == 1 && shmem_should_replace_folio(folio, gfp)) {
 		error = shmem_replace_folio(&folio, gfp, info, index);
 		if (error)
 			goto failed;
 	}
 
-	error = shmem_add_to_page_cache(folio, mapping, index,
-					swp_to_radix_entry(swap), gfp);
+	base = folio->swap;
+	error = shmem_add_to_page_cache(folio, mapping, index - offset,
+					swp_to_radix_entry(base), gfp);
 	if (error)
 		goto failed;
 
-	shmem_recalc_inode(inode, 0, -1);
+	shmem_recalc_inode(inode, 0, -nr);
 
 	if (sgp == SGP_WRITE)
 		folio_mark_accessed(folio);
 
 	delete_from_swap_cache(folio);
 	folio_mark_dirty(folio);
-	swap_free(swap);
+	swap_free_nr(base, nr);
 	put_swap_device(si);
 
 	*foliop = folio;
@@ -1965,6 +2151,7 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 	struct folio *folio;
 	int error;
 	bool alloced;
+	unsigned long orders;
 
 	if (WARN_ON_ONCE(!shmem_mapping(inode->i_mapping)))
 		return -EINVAL;
@@ -2036,23 +2223,34 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 		return 0;
 	}
 
+	orders = shmem_mthp_orders(inode, fault_mm, vma ? vma->vm_flags : 0);
 	if (shmem_is_huge(inode, index, false, fault_mm,
-			  vma ? vma->vm_flags : 0)) {
+			  vma ? vma->vm_flags : 0))
+		orders |= BIT(PMD_ORDER);
+
+	if (orders) {
 		gfp_t huge_gfp;
+		int order;
 
 		huge_gfp = vma_thp_gfp_mask(vma);
 		huge_gfp = limit_gfp_mask(huge_gfp, gfp);
-		folio = shmem_alloc_and_add_folio(huge_gfp,
-				inode, index, fault_mm, true);
-		if (!IS_ERR(folio)) {
-			count_vm_event(THP_FILE_ALLOC);
-			goto alloced;
+		order = highest_order(orders);
+		while (orders) {
+			folio = shmem_alloc_and_add_folio(huge_gfp,
+					inode, index, fault_mm, order);
+			if (!IS_ERR(folio)) {
+				if (order == PMD_ORDER)
+					count_vm_event(THP_FILE_ALLOC);
+				count_mthp_stat(order, MTHP_STAT_SHMEM_ALLOC);
+				goto alloced;
+			}
+			if (PTR_ERR(folio) == -EEXIST)
+				goto repeat;
+			order = next_order(&orders, order);
 		}
-		if (PTR_ERR(folio) == -EEXIST)
-			goto repeat;
 	}
 
-	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, false);
+	folio = shmem_alloc_and_add_folio(gfp, inode, index, fault_mm, 0);
 	if (IS_ERR(folio)) {
 		error = PTR_ERR(folio);
 		if (error == -EEXIST)
@@ -2063,7 +2261,7 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 
 alloced:
 	alloced = true;
-	if (folio_test_pmd_mappable(folio) &&
+	if (folio_test_large(folio) &&
 	    DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE) <
 					folio_next_index(folio) - 1) {
 		struct shmem_sb_info *sbinfo = SHMEM_SB(inode->i_sb);
@@ -2633,7 +2831,7 @@ int shmem_mfill_atomic_pte(pmd_t *dst_pmd,
 
 	if (!*foliop) {
 		ret = -ENOMEM;
-		folio = shmem_alloc_folio(gfp, info, pgoff);
+		folio = shmem_alloc_folio(gfp, 0, info, pgoff);
 		if (!folio)
 			goto out_unacct_blocks;
 
@@ -3876,6 +4074,7 @@ static const struct export_operations shmem_export_ops = {
 enum shmem_param {
 	Opt_gid,
 	Opt_huge,
+	Opt_huge_orders,
 	Opt_mode,
 	Opt_mpol,
 	Opt_nr_blocks,
@@ -3905,6 +4104,7 @@ static const struct constant_table shmem_param_enums_huge[] = {
 const struct fs_parameter_spec shmem_fs_parameters[] = {
 	fsparam_u32   ("gid",		Opt_gid),
 	fsparam_enum  ("huge",		Opt_huge,  shmem_param_enums_huge),
+	fsparam_string("huge_orders",	Opt_huge_orders),
 	fsparam_u32oct("mode",		Opt_mode),
 	fsparam_string("mpol",		Opt_mpol),
 	fsparam_string("nr_blocks",	Opt_nr_blocks),
@@ -3926,6 +4126,40 @@ const struct fs_parameter_spec shmem_fs_parameters[] = {
 	{}
 };
 
+/*
+ * Parse a huge_orders= list of folio sizes separated by colons, such as
+ * "16K:64K:1M".  Each size must be a power of two number of pages, at
+ * least four and below PMD size, which is controlled by huge=.  "never"
+ * clears the list.
+ */
+static int shmem_parse_huge_orders(char *str, unsigned long *orders)
+{
+	unsigned long new = 0;
+	char *p;
+
+	if (!strcmp(str, "never")) {
+		*orders = 0;
+		return 0;
+	}
+
+	while ((p = strsep(&str, ":")) != NULL) {
+		unsigned long size;
+		char *rest;
+		int order;
+
+		size = memparse(p, &rest);
+		if (*rest || size < PAGE_SIZE || !is_power_of_2(size))
+			return -EINVAL;
+		order = ilog2(size) - PAGE_SHIFT;
+		if (order < 2 || order >= PMD_ORDER)
+			return -EINVAL;
+		new |= BIT(order);
+	}
+
+	*orders = new;
+	return 0;
+}
+
 static int shmem_parse_one(struct fs_context *fc, struct fs_parameter *param)
 {
 	struct shmem_options *ctx = fc->fs_private;
@@ -4005,6 +4239,14 @@ static int shmem_parse_one(struct fs_context *fc, struct fs_parameter *param)
 			goto unsupported_parameter;
 		ctx->seen |= SHMEM_SEEN_HUGE;
 		break;
+	case Opt_huge_orders:
+		if (!(IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE) &&
+		      has_transparent_hugepage()))
+			goto unsupported_parameter;
+		if (shmem_parse_huge_orders(param->string, &ctx->huge_orders))
+			goto bad_value;
+		ctx->seen |= SHMEM_SEEN_HUGE_ORDERS;
+		break;
 	case Opt_mpol:
 		if (IS_ENABLED(CONFIG_NUMA)) {
 			mpol_put(ctx->mpol);
@@ -4211,6 +4453,8 @@ static int shmem_reconfigure(struct fs_context *fc)
 
 	if (ctx->seen & SHMEM_SEEN_HUGE)
 		sbinfo->huge = ctx->huge;
+	if (ctx->seen & SHMEM_SEEN_HUGE_ORDERS)
+		WRITE_ONCE(sbinfo->huge_orders, ctx->huge_orders);
 	if (ctx->seen & SHMEM_SEEN_INUMS)
 		sbinfo->full_inums = ctx->full_inums;
 	if (ctx->seen & SHMEM_SEEN_BLOCKS)
@@ -4284,6 +4528,17 @@ static int shmem_show_options(struct seq_file *seq, struct dentry *root)
 	/* Rightly or wrongly, show huge mount option unmasked by shmem_huge */
 	if (sbinfo->huge)
 		seq_printf(seq, ",huge=%s", shmem_format_huge(sbinfo->huge));
+	if (sbinfo->huge_orders) {
+		unsigned long orders = sbinfo->huge_orders;
+		char sep = '=';
+		int order;
+
+		seq_puts(seq, ",huge_orders");
+		for_each_set_bit(order, &orders, PMD_ORDER) {
+			seq_printf(seq, "%c%luK", sep, (PAGE_SIZE << order) >> 10);
+			sep = ':';
+		}
+	}
 #endif
 	mpol = shmem_get_sbmpol(sbinfo);
 	shmem_show_mpol(seq, mpol);
@@ -4377,6 +4632,7 @@ static int shmem_fill_super(struct super_block *sb, struct fs_context *fc)
 	sbinfo->full_inums = ctx->full_inums;
 	sbinfo->mode = ctx->mode;
 	sbinfo->huge = ctx->huge;
+	sbinfo->huge_orders = ctx->huge_orders;
 	sbinfo->mpol = ctx->mpol;
 	ctx->mpol = NULL;
 
@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0
 #include <linux/memcontrol.h>
+#include <linux/moduleparam.h>
 #include <linux/rwsem.h>
 #include <linux/shrinker.h>
 #include <linux/rculist.h>
+#include <linux/swap.h>
+#include <linux/workqueue.h>
 #include <trace/events/vmscan.h>
 
 #include "internal.h"
@@ -10,6 +13,27 @@
 LIST_HEAD(shrinker_list);
 DEFINE_MUTEX(shrinker_mutex);
 
+/*
+ * A shrinker invocation from direct reclaim stops scanning once it ran for
+ * this long and leaves the rest of its work to a worker on the node, so that
+ * one slow shrinker doesn't stall every allocating task.  0 disables it.
+ */
+static unsigned int shrinker_budget_us;
+module_param_named(budget_us, shrinker_budget_us, uint, 0644);
+
+#define SHRINKER_ASYNC_PENDING	0
+
+struct shrinker_async {
+	struct work_struct work;
+	struct shrinker *shrinker;
+	struct mem_cgroup *memcg;
+	unsigned long flags;
+	int nid;
+	int priority;
+};
+
+static struct workqueue_struct *shrinker_async_wq;
+
 #ifdef CONFIG_MEMCG
 static int shrinker_nr_max;
 
@@ -366,8 +390,12 @@ static long add_nr_deferred(long nr, struct shrinker *shrinker,
 
 #define SHRINK_BATCH 128
 
+static void shrinker_queue_async(struct shrinker *shrinker,
+				 struct shrink_control *shrinkctl, int priority);
+
 static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
-				    struct shrinker *shrinker, int priority)
+				    struct shrinker *shrinker, int priority,
+				    bool async)
 {
 	unsigned long freed = 0;
 	unsigned long long delta;
@@ -378,11 +406,16 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	long batch_size = shrinker->batch ? shrinker->batch
 					  : SHRINK_BATCH;
 	long scanned = 0, next_deferred;
+	u64 start = ktime_get_ns(), budget = 0;
+	bool over_budget = false;
 
 	freeable = shrinker->count_objects(shrinker, shrinkctl);
 	if (freeable == 0 || freeable == SHRINK_EMPTY)
 		return freeable;
 
+	if (!async && !current_is_kswapd())
+		budget = (u64)READ_ONCE(shrinker_budget_us) * NSEC_PER_USEC;
+
 	/*
 	 * copy the current shrinker scan count into a local variable
 	 * and zero it so that other concurrent shrinker invocations
@@ -442,6 +475,12 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 		scanned += shrinkctl->nr_scanned;
 
 		cond_resched();
+
+		/* what is left over is deferred below */
+		if (budget && total_scan > 0 && ktime_get_ns() - start > budget) {
+			over_budget = true;
+			break;
+		}
 	}
 
 	/*
@@ -460,9 +499,70 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	new_nr = add_nr_deferred(next_deferred, shrinker, shrinkctl);
 
 	trace_mm_shrink_slab_end(shrinker, shrinkctl->nid, freed, nr, new_nr, total_scan);
+	shrinker_debugfs_account(shrinker, ktime_get_ns() - start, freed);
+
+	if (over_budget)
+		shrinker_queue_async(shrinker, shrinkctl, priority);
 	return freed;
 }
 
+static void shrinker_async_workfn(struct work_struct *work)
+{
+	struct shrinker_async *sa = container_of(work, struct shrinker_async, work);
+	struct shrinker *shrinker = sa->shrinker;
+	struct shrink_control sc = {
+		.gfp_mask = GFP_KERNEL,
+		.nid = sa->nid,
+		.memcg = sa->memcg,
+	};
+
+	do_shrink_slab(&sc, shrinker, sa->priority, true);
+
+	mem_cgroup_put(sa->memcg);
+	clear_bit_unlock(SHRINKER_ASYNC_PENDING, &sa->flags);
+	/* may let shrinker_free() go ahead and free @sa */
+	shrinker_put(shrinker);
+}
+
+/*
+ * Run the deferred work of @shrinker for the node and memcg of @shrinkctl
+ * from a worker on that node.  If the worker is already busy with this
+ * shrinker and node, the work stays deferred for the next invocation.
+ */
+static void shrinker_queue_async(struct shrinker *shrinker,
+				 struct shrink_control *shrinkctl, int priority)
+{
+	int nid = shrinker->flags & SHRINKER_NUMA_AWARE ? shrinkctl->nid : 0;
+	struct shrinker_async *sa = &shrinker->async[nid];
+
+	if (!shrinker_async_wq ||
+	    test_and_set_bit_lock(SHRINKER_ASYNC_PENDING, &sa->flags))
+		return;
+
+	if (!shrinker_try_get(shrinker))
+		goto clear;
+	if (!mem_cgroup_tryget_online(shrinkctl->memcg)) {
+		shrinker_put(shrinker);
+		goto clear;
+	}
+
+	sa->nid = shrinkctl->nid;
+	sa->memcg = shrinkctl->memcg;
+	sa->priority = priority;
+	queue_work_node(shrinkctl->nid, shrinker_async_wq, &sa->work);
+	return;
+clear:
+	clear_bit_unlock(SHRINKER_ASYNC_PENDING, &sa->flags);
+}
+
+static int __init shrinker_async_init(void)
+{
+	shrinker_async_wq = alloc_workqueue("shrinker_async",
+					    WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	return shrinker_async_wq ? 0 : -ENOMEM;
+}
+subsys_initcall(shrinker_async_init);
+
 #ifdef CONFIG_MEMCG
 static unsigned long shrink_slab_memcg(gfp_t gfp_mask, int nid,
 			struct mem_cgroup *memcg, int priority)
@@ -545,7 +645,7 @@ static unsigned long shrink_slab_memcg(gfp_t gfp_mask, int nid,
 			    !(shrinker->flags & SHRINKER_NONSLAB))
 				continue;
 
-			ret = do_shrink_slab(&sc, shrinker, priority);
+			ret = do_shrink_slab(&sc, shrinker, priority, false);
 			if (ret == SHRINK_EMPTY) {
 				clear_bit(offset, unit->map);
 				/*
@@ -564,7 +664,7 @@ static unsigned long shrink_slab_memcg(gfp_t gfp_mask, int nid,
 				 *   set_bit()          do_shrink_slab()
 				 */
 				smp_mb__after_atomic();
-				ret = do_shrink_slab(&sc, shrinker, priority);
+				ret = do_shrink_slab(&sc, shrinker, priority, false);
 				if (ret == SHRINK_EMPTY)
 					ret = 0;
 				else
@@ -659,7 +759,7 @@ unsigned long shrink_slab(gfp_t gfp_mask, int nid, struct mem_cgroup *memcg,
 
 		rcu_read_unlock();
 
-		ret = do_shrink_slab(&sc, shrinker, priority);
+		ret = do_shrink_slab(&sc, shrinker, priority, false);
 		if (ret == SHRINK_EMPTY)
 			ret = 0;
 		freed += ret;
@@ -678,7 +778,7 @@ struct shrinker *shrinker_alloc(unsigned int flags, const char *fmt, ...)
 	struct shrinker *shrinker;
 	unsigned int size;
 	va_list ap;
-	int err;
+	int err, i;
 
 	shrinker = kzalloc(sizeof(struct shrinker), GFP_KERNEL);
 	if (!shrinker)
@@ -693,6 +793,15 @@ struct shrinker *shrinker_alloc(unsigned int flags, const char *fmt, ...)
 	shrinker->flags = flags | SHRINKER_ALLOCATED;
 	shrinker->seeks = DEFAULT_SEEKS;
 
+	size = flags & SHRINKER_NUMA_AWARE ? nr_node_ids : 1;
+	shrinker->async = kcalloc(size, sizeof(*shrinker->async), GFP_KERNEL);
+	if (!shrinker->async)
+		goto err_flags;
+	for (i = 0; i < size; i++) {
+		INIT_WORK(&shrinker->async[i].work, shrinker_async_workfn);
+		shrinker->async[i].shrinker = shrinker;
+	}
+
 	if (flags & SHRINKER_MEMCG_AWARE) {
 		err = shrinker_memcg_alloc(shrinker);
 		if (err == -ENOSYS) {
@@ -726,6 +835,7 @@ struct shrinker *shrinker_alloc(unsigned int flags, const char *fmt, ...)
 	return shrinker;
 
 err_flags:
+	kfree(shrinker->async);
 	shrinker_debugfs_name_free(shrinker);
 err_name:
 	kfree(shrinker);
@@ -761,6 +871,7 @@ static void shrinker_free_rcu_cb(struct rcu_head *head)
 	struct shrinker *shrinker = container_of(head, struct shrinker, rcu);
 
 	kfree(shrinker->nr_deferred);
+	kfree(shrinker->async);
 	kfree(shrinker);
 }
 
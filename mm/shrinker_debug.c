@@ -95,6 +95,21 @@ static int shrinker_debugfs_count_show(struct seq_file *m, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(shrinker_debugfs_count);
 
+static int shrinker_debugfs_stats_show(struct seq_file *m, void *v)
+{
+	struct shrinker *shrinker = m->private;
+	int i;
+
+	seq_puts(m, "# from latency_us freed_objects\n");
+	for (i = 0; i < SHRINKER_HIST_BUCKETS; i++)
+		seq_printf(m, "%lu %ld %ld\n", i ? 1UL << (i - 1) : 0,
+			   atomic_long_read(&shrinker->latency_hist[i]),
+			   atomic_long_read(&shrinker->freed_hist[i]));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(shrinker_debugfs_stats);
+
 static int shrinker_debugfs_scan_open(struct inode *inode, struct file *file)
 {
 	file->private_data = inode->i_private;
@@ -190,6 +205,8 @@ int shrinker_debugfs_add(struct shrinker *shrinker)
 			    &shrinker_debugfs_count_fops);
 	debugfs_create_file("scan", 0220, entry, shrinker,
 			    &shrinker_debugfs_scan_fops);
+	debugfs_create_file("stats", 0440, entry, shrinker,
+			    &shrinker_debugfs_stats_fops);
 	return 0;
 }
 
@@ -373,6 +373,14 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_PCS,		/* Allocation from percpu sheaf */
+	FREE_PCS,		/* Free to percpu sheaf */
+	SHEAF_REFILL,		/* Refill of a sheaf from slabs */
+	SHEAF_FLUSH,		/* Objects flushed from a sheaf to slabs */
+	BARN_GET,		/* Full sheaf taken from the barn */
+	BARN_PUT,		/* Full sheaf put into the barn */
+	ALLOC_BULK_PARTIAL,	/* Bulk alloc objects taken from node partials */
+	ALLOC_BULK_CPU_SLAB,	/* Bulk alloc objects taken via the cpu slab */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -419,6 +427,19 @@ void stat_add(const struct kmem_cache *s, enum stat_item si, int v)
 #endif
 }
 
+#ifndef CONFIG_SLUB_TINY
+/*
+ * Per node stock of sheaves, shared by all cpus of the node.
+ */
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
+#endif
+
 /*
  * The slab lists for all objects.
  */
@@ -431,6 +452,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn barn;
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -3103,6 +3127,474 @@ static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 	}
 }
 
+/*
+ * Per cpu sheaves for caches created with SLAB_PERCPU_SHEAVES.
+ *
+ * A sheaf is an array of free objects. Each cpu has a main sheaf that
+ * objects are allocated from and freed to under a local lock, so the fast
+ * paths need neither a cmpxchg nor access to the slab's freelist, and an
+ * optional spare sheaf that is either empty or full. When the main sheaf
+ * runs empty on allocation (or full on free), it is exchanged with the
+ * spare, or with a full (or empty) sheaf from the node's barn. Only when
+ * that fails are objects moved between a sheaf and the slabs, in bulk.
+ *
+ * Objects in sheaves have been through the free hooks already, and go
+ * through the alloc hooks again when handed out, so to the rest of the
+ * kernel they are just free objects. Allocations for a remote node and
+ * frees of objects from a remote node bypass the sheaves.
+ */
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	void *objects[];
+};
+
+struct slub_percpu_sheaves {
+	local_lock_t lock;
+	struct slab_sheaf *main;	/* never NULL when unlocked */
+	struct slab_sheaf *spare;	/* empty or full, may be NULL */
+};
+
+/* Soft limits on how many sheaves a barn keeps around */
+#define MAX_FULL_SHEAVES	10
+#define MAX_EMPTY_SHEAVES	10
+
+/* Maximum number of objects flushed from a sheaf under the local lock */
+#define PCS_BATCH_MAX		32U
+
+static int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags,
+				   size_t size, void **p);
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
+
+static inline bool cache_has_sheaves(struct kmem_cache *s)
+{
+	return s->cpu_sheaves;
+}
+
+static inline struct node_barn *get_barn(struct kmem_cache *s)
+{
+	return &get_node(s, numa_mem_id())->barn;
+}
+
+static struct slab_sheaf *alloc_empty_sheaf(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slab_sheaf *sheaf;
+
+	/* Keep the caller's reclaim constraints but nothing else */
+	gfp = (gfp & GFP_KERNEL) | __GFP_NOWARN;
+
+	sheaf = kmalloc(struct_size(sheaf, objects, s->sheaf_capacity), gfp);
+	if (sheaf)
+		sheaf->size = 0;
+
+	return sheaf;
+}
+
+static void free_empty_sheaf(struct slab_sheaf *sheaf)
+{
+	VM_WARN_ON_ONCE(sheaf->size);
+	kfree(sheaf);
+}
+
+static int refill_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf,
+			gfp_t gfp)
+{
+	int to_fill = s->sheaf_capacity - sheaf->size;
+	int filled;
+
+	if (!to_fill)
+		return 0;
+
+	filled = __kmem_cache_alloc_bulk(s, gfp, to_fill,
+					 &sheaf->objects[sheaf->size]);
+	if (!filled)
+		return -ENOMEM;
+
+	sheaf->size += filled;
+	stat(s, SHEAF_REFILL);
+
+	return 0;
+}
+
+/* Return all objects of a sheaf that is no longer visible to others */
+static void sheaf_flush(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	if (!sheaf->size)
+		return;
+
+	__kmem_cache_free_bulk(s, sheaf->size, &sheaf->objects[0]);
+	sheaf->size = 0;
+	stat(s, SHEAF_FLUSH);
+}
+
+static void barn_init(struct node_barn *barn)
+{
+	spin_lock_init(&barn->lock);
+	INIT_LIST_HEAD(&barn->sheaves_full);
+	INIT_LIST_HEAD(&barn->sheaves_empty);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+}
+
+static struct slab_sheaf *barn_get_sheaf(struct node_barn *barn, bool full)
+{
+	struct list_head *list = full ? &barn->sheaves_full : &barn->sheaves_empty;
+	unsigned int *nr = full ? &barn->nr_full : &barn->nr_empty;
+	struct slab_sheaf *sheaf;
+	unsigned long flags;
+
+	/* Don't bother taking the lock for a barn that is known to be bare */
+	if (!data_race(*nr))
+		return NULL;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	sheaf = list_first_entry_or_null(list, struct slab_sheaf, barn_list);
+	if (sheaf) {
+		list_del(&sheaf->barn_list);
+		(*nr)--;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return sheaf;
+}
+
+/*
+ * Store a sheaf in the barn. Unless @force, fail when the barn already
+ * holds as many sheaves of the kind as it should.
+ */
+static bool barn_put_sheaf(struct node_barn *barn, struct slab_sheaf *sheaf,
+			   bool force)
+{
+	bool full = sheaf->size;
+	struct list_head *list = full ? &barn->sheaves_full : &barn->sheaves_empty;
+	unsigned int *nr = full ? &barn->nr_full : &barn->nr_empty;
+	unsigned int max = full ? MAX_FULL_SHEAVES : MAX_EMPTY_SHEAVES;
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (force || *nr < max) {
+		list_add(&sheaf->barn_list, list);
+		(*nr)++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	return ret;
+}
+
+/* Give back all sheaves held by a barn, and the objects they contain */
+static void barn_shrink(struct kmem_cache *s, struct kmem_cache_node *n)
+{
+	struct node_barn *barn = &n->barn;
+	struct slab_sheaf *sheaf, *next;
+	unsigned long flags;
+	LIST_HEAD(full);
+	LIST_HEAD(empty);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &full);
+	list_splice_init(&barn->sheaves_empty, &empty);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, next, &full, barn_list) {
+		sheaf_flush(s, sheaf);
+		free_empty_sheaf(sheaf);
+	}
+
+	list_for_each_entry_safe(sheaf, next, &empty, barn_list)
+		free_empty_sheaf(sheaf);
+}
+
+/*
+ * Make the main sheaf non-empty. Called with the local lock held, returns
+ * with it held and the (possibly different) cpu's sheaves, or NULL with the
+ * lock dropped if no objects could be obtained.
+ */
+static struct slub_percpu_sheaves *
+__pcs_replace_empty_main(struct kmem_cache *s, struct slub_percpu_sheaves *pcs,
+			 gfp_t gfp, unsigned long *flags)
+{
+	struct slab_sheaf *sheaf, *old = NULL;
+	struct node_barn *barn;
+
+	if (pcs->spare && pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return pcs;
+	}
+
+	barn = get_barn(s);
+	sheaf = barn_get_sheaf(barn, true);
+	if (sheaf) {
+		stat(s, BARN_GET);
+		goto install;
+	}
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, *flags);
+
+	/*
+	 * Refilling may need to allocate new slabs, which must not happen
+	 * under the local lock, and honours the caller's gfp constraints.
+	 */
+	sheaf = barn_get_sheaf(barn, false);
+	if (!sheaf) {
+		sheaf = alloc_empty_sheaf(s, gfp);
+		if (!sheaf)
+			return NULL;
+	}
+
+	if (refill_sheaf(s, sheaf, gfp)) {
+		if (!barn_put_sheaf(barn, sheaf, false))
+			free_empty_sheaf(sheaf);
+		return NULL;
+	}
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, *flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	/* We might have been migrated, or raced with a free or another refill */
+	if (pcs->main->size) {
+		barn_put_sheaf(get_barn(s), sheaf, true);
+		return pcs;
+	}
+
+install:
+	if (!pcs->spare)
+		pcs->spare = pcs->main;
+	else if (!barn_put_sheaf(get_barn(s), pcs->main, false))
+		old = pcs->main;
+	pcs->main = sheaf;
+
+	if (old)
+		free_empty_sheaf(old);
+
+	return pcs;
+}
+
+static __fastpath_inline void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+	void *object;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(!pcs->main->size)) {
+		pcs = __pcs_replace_empty_main(s, pcs, gfp, &flags);
+		if (unlikely(!pcs))
+			return NULL;
+	}
+
+	object = pcs->main->objects[--pcs->main->size];
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, ALLOC_PCS);
+
+	return object;
+}
+
+/*
+ * Make room in the main sheaf. Called with the local lock held, returns
+ * with it held and the (possibly different) cpu's sheaves, or NULL with the
+ * lock dropped if the caller should free to the slab directly.
+ */
+static struct slub_percpu_sheaves *
+__pcs_replace_full_main(struct kmem_cache *s, struct slub_percpu_sheaves *pcs,
+			unsigned long *flags)
+{
+	void *objects[PCS_BATCH_MAX];
+	struct slab_sheaf *empty;
+	struct node_barn *barn;
+	unsigned int batch;
+
+	if (pcs->spare && !pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return pcs;
+	}
+
+	barn = get_barn(s);
+	if (data_race(barn->nr_full) < MAX_FULL_SHEAVES) {
+		empty = barn_get_sheaf(barn, false);
+		if (!empty && !pcs->spare)
+			empty = alloc_empty_sheaf(s, GFP_NOWAIT);
+		if (empty) {
+			if (!pcs->spare) {
+				pcs->spare = pcs->main;
+			} else {
+				barn_put_sheaf(barn, pcs->main, true);
+				stat(s, BARN_PUT);
+			}
+			pcs->main = empty;
+			return pcs;
+		}
+	}
+
+	/*
+	 * The barn is saturated with full sheaves, so give some of the
+	 * objects back to their slabs, keeping the rest for allocations.
+	 */
+	batch = min(pcs->main->size / 2, PCS_BATCH_MAX);
+	pcs->main->size -= batch;
+	memcpy(objects, &pcs->main->objects[pcs->main->size],
+	       batch * sizeof(void *));
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, *flags);
+
+	__kmem_cache_free_bulk(s, batch, objects);
+	stat(s, SHEAF_FLUSH);
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, *flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == s->sheaf_capacity)) {
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, *flags);
+		return NULL;
+	}
+
+	return pcs;
+}
+
+static __fastpath_inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == s->sheaf_capacity)) {
+		pcs = __pcs_replace_full_main(s, pcs, &flags);
+		if (unlikely(!pcs))
+			return false;
+	}
+
+	pcs->main->objects[pcs->main->size++] = object;
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, FREE_PCS);
+
+	return true;
+}
+
+/* Flush the sheaves of the current cpu, which might be in concurrent use */
+static void pcs_flush_all(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	void *objects[PCS_BATCH_MAX];
+	struct slab_sheaf *spare;
+	unsigned long flags;
+	unsigned int batch;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+	spare = pcs->spare;
+	pcs->spare = NULL;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (spare) {
+		sheaf_flush(s, spare);
+		free_empty_sheaf(spare);
+	}
+
+	do {
+		local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+		pcs = this_cpu_ptr(s->cpu_sheaves);
+		batch = min(pcs->main->size, PCS_BATCH_MAX);
+		pcs->main->size -= batch;
+		memcpy(objects, &pcs->main->objects[pcs->main->size],
+		       batch * sizeof(void *));
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+		if (batch) {
+			__kmem_cache_free_bulk(s, batch, objects);
+			stat(s, SHEAF_FLUSH);
+		}
+	} while (batch);
+}
+
+/* Flush the sheaves of a cpu that went offline */
+static void __pcs_flush_all_cpu(struct kmem_cache *s, unsigned int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	if (pcs->spare) {
+		sheaf_flush(s, pcs->spare);
+		free_empty_sheaf(pcs->spare);
+		pcs->spare = NULL;
+	}
+
+	sheaf_flush(s, pcs->main);
+}
+
+static bool pcs_has_objects(struct kmem_cache *s, unsigned int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	return data_race(pcs->main->size) || data_race(pcs->spare);
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	unsigned int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		/* Only possible when called on a cache that failed to open */
+		if (!pcs->main)
+			continue;
+
+		__pcs_flush_all_cpu(s, cpu);
+		free_empty_sheaf(pcs->main);
+	}
+
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s)
+{
+	unsigned int cpu;
+
+	/*
+	 * Debugging needs every free to be processed as it happens, and
+	 * kmalloc caches are too numerous and too early to be worth it.
+	 */
+	if (s->flags & (SLAB_DEBUG_FLAGS | SLAB_KMALLOC))
+		s->flags &= ~SLAB_PERCPU_SHEAVES;
+
+	if (!(s->flags & SLAB_PERCPU_SHEAVES))
+		return 0;
+
+	/* Up to a slab's worth of objects, but not too many nor too few */
+	s->sheaf_capacity = clamp(oo_objects(s->oo), 4U, PCS_BATCH_MAX);
+
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		local_lock_init(&pcs->lock);
+		pcs->main = alloc_empty_sheaf(s, GFP_KERNEL);
+		if (!pcs->main) {
+			free_percpu_sheaves(s);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
@@ -3119,6 +3611,9 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	}
 
 	put_partials_cpu(s, c);
+
+	if (cache_has_sheaves(s))
+		__pcs_flush_all_cpu(s, cpu);
 }
 
 struct slub_flush_work {
@@ -3147,12 +3642,18 @@ static void flush_cpu_slab(struct work_struct *w)
 		flush_slab(s, c);
 
 	put_partials(s);
+
+	if (cache_has_sheaves(s))
+		pcs_flush_all(s);
 }
 
 static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
+	if (cache_has_sheaves(s) && pcs_has_objects(s, cpu))
+		return true;
+
 	return c->slab || slub_percpu_partial(c);
 }
 
@@ -3212,6 +3713,19 @@ static int slub_cpu_dead(unsigned int cpu)
 }
 
 #else /* CONFIG_SLUB_TINY */
+static inline bool cache_has_sheaves(struct kmem_cache *s) { return false; }
+static inline void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	return NULL;
+}
+static inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	return false;
+}
+static inline void barn_shrink(struct kmem_cache *s,
+			       struct kmem_cache_node *n) { }
+static inline void free_percpu_sheaves(struct kmem_cache *s) { }
+static inline int init_percpu_sheaves(struct kmem_cache *s) { return 0; }
 static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
@@ -3987,7 +4501,12 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	if (cache_has_sheaves(s) &&
+	    (node == NUMA_NO_NODE || node == numa_mem_id()))
+		object = alloc_from_pcs(s, gfpflags);
+
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -4435,8 +4954,17 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 	memcg_slab_free_hook(s, slab, &object, 1);
 	alloc_tagging_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s))))
-		do_slab_free(s, slab, object, object, 1, addr);
+	if (unlikely(!slab_free_hook(s, object, slab_want_init_on_free(s))))
+		return;
+
+	if (cache_has_sheaves(s) && likely(slab_nid(slab) == numa_mem_id()) &&
+	    likely(!slab_test_pfmemalloc(slab)) &&
+	    likely(!is_kfence_address(object))) {
+		if (likely(free_to_pcs(s, object)))
+			return;
+	}
+
+	do_slab_free(s, slab, object, object, 1, addr);
 }
 
 #ifdef CONFIG_MEMCG_KMEM
@@ -4680,13 +5208,106 @@ void kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p)
 EXPORT_SYMBOL(kmem_cache_free_bulk);
 
 #ifndef CONFIG_SLUB_TINY
+/*
+ * Bulk allocations of at least this many objects first take whole
+ * freelists from the local node's partial slabs.
+ */
+#define SLUB_BULK_PARTIAL_MIN	16
+
+/*
+ * Take up to @size objects straight from the freelists of the partial slabs
+ * of @n, in a single pass under the list_lock.
+ *
+ * Each slab's freelist is detached completely with one cmpxchg, which makes
+ * the slab full so it can just be removed from the partial list, without
+ * freezing it or going through the cpu slab an object at a time. Objects of
+ * the last slab that are not needed are freed back to it afterwards.
+ */
+static unsigned int alloc_bulk_from_partial(struct kmem_cache *s,
+		struct kmem_cache_node *n, gfp_t gfp, unsigned int size,
+		void **p)
+{
+	struct slab *slab, *slab2, *leftover = NULL;
+	unsigned int allocated = 0;
+	void *freelist = NULL;
+	unsigned long flags;
+
+	if (!n || !data_race(n->nr_partial))
+		return 0;
+
+	spin_lock_irqsave(&n->list_lock, flags);
+	list_for_each_entry_safe(slab, slab2, &n->partial, slab_list) {
+		unsigned long counters;
+		struct slab new;
+
+		if (!pfmemalloc_match(slab, gfp))
+			continue;
+
+		do {
+			freelist = slab->freelist;
+			counters = slab->counters;
+
+			new.counters = counters;
+			VM_BUG_ON(new.frozen);
+
+			new.inuse = slab->objects;
+
+		} while (!slab_update_freelist(s, slab,
+			freelist, counters,
+			NULL, new.counters,
+			"alloc_bulk_from_partial"));
+
+		remove_partial(n, slab);
+
+		while (freelist && allocated < size) {
+			void *object = freelist;
+
+			freelist = get_freepointer(s, object);
+			maybe_wipe_obj_freeptr(s, object);
+			p[allocated++] = object;
+		}
+
+		if (freelist) {
+			leftover = slab;
+			break;
+		}
+
+		if (allocated == size)
+			break;
+	}
+	spin_unlock_irqrestore(&n->list_lock, flags);
+
+	if (leftover) {
+		void *tail = freelist, *next;
+		int cnt = 1;
+
+		while ((next = get_freepointer(s, tail))) {
+			tail = next;
+			cnt++;
+		}
+		__slab_free(s, leftover, freelist, tail, cnt, _RET_IP_);
+	}
+
+	stat_add(s, ALLOC_BULK_PARTIAL, allocated);
+
+	return allocated;
+}
+
 static inline
 int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 			    void **p)
 {
 	struct kmem_cache_cpu *c;
 	unsigned long irqflags;
-	int i;
+	int i = 0, from_partial;
+
+	if (size >= SLUB_BULK_PARTIAL_MIN && !kmem_cache_debug(s)) {
+		i = alloc_bulk_from_partial(s, get_node(s, numa_mem_id()),
+					    flags, size, p);
+		if (i == size)
+			return i;
+	}
+	from_partial = i;
 
 	/*
 	 * Drain objects in the per cpu slab, while disabling local
@@ -4696,7 +5317,7 @@ int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 	c = slub_get_cpu_ptr(s->cpu_slab);
 	local_lock_irqsave(&s->cpu_slab->lock, irqflags);
 
-	for (i = 0; i < size; i++) {
+	for (; i < size; i++) {
 		void *object = kfence_alloc(s, s->object_size, flags);
 
 		if (unlikely(object)) {
@@ -4742,6 +5363,8 @@ int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 	local_unlock_irqrestore(&s->cpu_slab->lock, irqflags);
 	slub_put_cpu_ptr(s->cpu_slab);
 
+	stat_add(s, ALLOC_BULK_CPU_SLAB, i - from_partial);
+
 	return i;
 
 error:
@@ -4953,6 +5576,9 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	barn_init(&n->barn);
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -5042,6 +5668,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
+	free_percpu_sheaves(s);
 #ifndef CONFIG_SLUB_TINY
 	free_percpu(s->cpu_slab);
 #endif
@@ -5296,7 +5923,7 @@ static int kmem_cache_open(struct kmem_cache *s, slab_flags_t flags)
 	if (!init_kmem_cache_nodes(s))
 		goto error;
 
-	if (alloc_kmem_cache_cpus(s))
+	if (alloc_kmem_cache_cpus(s) && !init_percpu_sheaves(s))
 		return 0;
 
 error:
@@ -5376,6 +6003,8 @@ int __kmem_cache_shutdown(struct kmem_cache *s)
 	flush_all_cpus_locked(s);
 	/* Attempt to free all objects */
 	for_each_kmem_cache_node(s, node, n) {
+		if (cache_has_sheaves(s))
+			barn_shrink(s, n);
 		free_partial(s, n);
 		if (n->nr_partial || node_nr_slabs(n))
 			return 1;
@@ -5558,6 +6187,9 @@ static int __kmem_cache_do_shrink(struct kmem_cache *s)
 	int ret = 0;
 
 	for_each_kmem_cache_node(s, node, n) {
+		if (cache_has_sheaves(s))
+			barn_shrink(s, n);
+
 		INIT_LIST_HEAD(&discard);
 		for (i = 0; i < SHRINK_PROMOTE_MAX; i++)
 			INIT_LIST_HEAD(promote + i);
@@ -6432,6 +7064,14 @@ static ssize_t slabs_cpu_partial_show(struct kmem_cache *s, char *buf)
 }
 SLAB_ATTR_RO(slabs_cpu_partial);
 
+#ifndef CONFIG_SLUB_TINY
+static ssize_t sheaf_capacity_show(struct kmem_cache *s, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", s->cpu_sheaves ? s->sheaf_capacity : 0);
+}
+SLAB_ATTR_RO(sheaf_capacity);
+#endif
+
 static ssize_t reclaim_account_show(struct kmem_cache *s, char *buf)
 {
 	return sysfs_emit(buf, "%d\n", !!(s->flags & SLAB_RECLAIM_ACCOUNT));
@@ -6684,6 +7324,14 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_PCS, alloc_cpu_sheaf);
+STAT_ATTR(FREE_PCS, free_cpu_sheaf);
+STAT_ATTR(SHEAF_REFILL, sheaf_refill);
+STAT_ATTR(SHEAF_FLUSH, sheaf_flush);
+STAT_ATTR(BARN_GET, barn_get);
+STAT_ATTR(BARN_PUT, barn_put);
+STAT_ATTR(ALLOC_BULK_PARTIAL, alloc_bulk_partial);
+STAT_ATTR(ALLOC_BULK_CPU_SLAB, alloc_bulk_cpu_slab);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -6727,6 +7375,9 @@ static struct attribute *slab_attrs[] = {
 	&destroy_by_rcu_attr.attr,
 	&shrink_attr.attr,
 	&slabs_cpu_partial_attr.attr,
+#ifndef CONFIG_SLUB_TINY
+	&sheaf_capacity_attr.attr,
+#endif
 #ifdef CONFIG_SLUB_DEBUG
 	&total_objects_attr.attr,
 	&objects_attr.attr,
@@ -6771,6 +7422,14 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_cpu_sheaf_attr.attr,
+	&free_cpu_sheaf_attr.attr,
+	&sheaf_refill_attr.attr,
+	&sheaf_flush_attr.attr,
+	&barn_get_attr.attr,
+	&barn_put_attr.attr,
+	&alloc_bulk_partial_attr.attr,
+	&alloc_bulk_cpu_slab_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -530,11 +530,20 @@ static void alloc_cluster(struct swap_info_struct *si, unsigned long idx)
 	cluster_set_count_flag(ci + idx, 0, 0);
 }
 
+static inline void count_swap_cluster_stat(int order, int item)
+{
+#ifdef CONFIG_THP_SWAP
+	count_mthp_stat(order, item);
+#endif
+}
+
 static void free_cluster(struct swap_info_struct *si, unsigned long idx)
 {
 	struct swap_cluster_info *ci = si->cluster_info + idx;
 
 	VM_BUG_ON(cluster_count(ci) != 0);
+	list_del_init(&ci->nonfull);
+	ci->order = 0;
 	/*
 	 * If the swap is discardable, prepare discard the cluster
 	 * instead of free it immediately. The cluster will be freed
@@ -583,22 +592,27 @@ static void inc_cluster_info_page(struct swap_info_struct *p,
 /*
  * The cluster corresponding to page_nr decreases one usage. If the usage
  * counter becomes 0, which means no page in the cluster is in using, we can
- * optionally discard the cluster and add it to free cluster list.
+ * optionally discard the cluster and add it to free cluster list. Otherwise
+ * the cluster now has room again and is queued on the nonfull list of the
+ * order it was allocated for, so that order can reuse it without a scan.
  */
 static void dec_cluster_info_page(struct swap_info_struct *p,
 	struct swap_cluster_info *cluster_info, unsigned long page_nr)
 {
 	unsigned long idx = page_nr / SWAPFILE_CLUSTER;
+	struct swap_cluster_info *ci;
 
 	if (!cluster_info)
 		return;
 
-	VM_BUG_ON(cluster_count(&cluster_info[idx]) == 0);
-	cluster_set_count(&cluster_info[idx],
-		cluster_count(&cluster_info[idx]) - 1);
+	ci = &cluster_info[idx];
+	VM_BUG_ON(cluster_count(ci) == 0);
+	cluster_set_count(ci, cluster_count(ci) - 1);
 
-	if (cluster_count(&cluster_info[idx]) == 0)
+	if (cluster_count(ci) == 0)
 		free_cluster(p, idx);
+	else if (list_empty(&ci->nonfull))
+		list_add_tail(&ci->nonfull, &p->nonfull_clusters[ci->order]);
 }
 
 /*
@@ -641,7 +655,8 @@ static inline bool swap_range_empty(char *swap_map, unsigned int start,
 /*
  * Try to get swap entries with specified order from current cpu's swap entry
  * pool (a cluster). This might involve allocating a new cluster for current CPU
- * too.
+ * too. A partially used cluster of the same order is preferred over a free
+ * one, so that free clusters are kept for the orders that really need them.
  */
 static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 	unsigned long *offset, unsigned long *scan_base, int order)
@@ -649,13 +664,21 @@ static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 	unsigned int nr_pages = 1 << order;
 	struct percpu_cluster *cluster;
 	struct swap_cluster_info *ci;
+	struct swap_cluster_info *nonfull;
 	unsigned int tmp, max;
 
 new_cluster:
+	nonfull = NULL;
 	cluster = this_cpu_ptr(si->percpu_cluster);
 	tmp = cluster->next[order];
 	if (tmp == SWAP_NEXT_INVALID) {
-		if (!cluster_list_empty(&si->free_clusters)) {
+		ci = list_first_entry_or_null(&si->nonfull_clusters[order],
+					      struct swap_cluster_info, nonfull);
+		if (ci) {
+			list_del_init(&ci->nonfull);
+			tmp = (ci - si->cluster_info) * SWAPFILE_CLUSTER;
+			nonfull = ci;
+		} else if (!cluster_list_empty(&si->free_clusters)) {
 			tmp = cluster_next(&si->free_clusters.head) *
 					SWAPFILE_CLUSTER;
 		} else if (!cluster_list_empty(&si->discard_clusters)) {
@@ -688,9 +711,20 @@ static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 		unlock_cluster(ci);
 	}
 	if (tmp >= max) {
+		/*
+		 * The nonfull cluster has free slots, but none aligned run
+		 * of nr_pages. It is requeued once more entries get freed.
+		 */
+		if (nonfull && cluster_count(nonfull) < SWAPFILE_CLUSTER)
+			count_swap_cluster_stat(order, MTHP_STAT_SWPOUT_FRAG);
 		cluster->next[order] = SWAP_NEXT_INVALID;
 		goto new_cluster;
 	}
+	if (nonfull)
+		count_swap_cluster_stat(order, MTHP_STAT_SWPOUT_NONFULL);
+	ci = si->cluster_info + tmp / SWAPFILE_CLUSTER;
+	if (cluster_is_free(ci))
+		ci->order = order;
 	*offset = tmp;
 	*scan_base = tmp;
 	tmp += nr_pages;
@@ -1356,6 +1390,35 @@ void swap_free(swp_entry_t entry)
 		__swap_entry_free(p, entry);
 }
 
+/*
+ * Caller has made sure that the swap device corresponding to entry
+ * is still around or has not been recycled. The nr_pages entries must
+ * not cross a swap cluster boundary.
+ */
+void swap_free_nr(swp_entry_t entry, int nr_pages)
+{
+	DECLARE_BITMAP(to_free, SWAPFILE_CLUSTER) = { 0 };
+	unsigned long offset = swp_offset(entry);
+	struct swap_cluster_info *ci;
+	struct swap_info_struct *p;
+	int i;
+
+	p = _swap_info_get(entry);
+	if (!p)
+		return;
+
+	VM_WARN_ON(nr_pages > SWAPFILE_CLUSTER - offset % SWAPFILE_CLUSTER);
+	ci = lock_cluster_or_swap_info(p, offset);
+	for (i = 0; i < nr_pages; i++) {
+		if (!__swap_entry_free_locked(p, offset + i, 1))
+			__bitmap_set(to_free, i, 1);
+	}
+	unlock_cluster_or_swap_info(p, ci);
+
+	for_each_set_bit(i, to_free, SWAPFILE_CLUSTER)
+		free_swap_slot(swp_entry(p->type, offset + i));
+}
+
 /*
  * Called after dropping swapcache to decrease refcnt to swap entries.
  */
@@ -2967,6 +3030,8 @@ static int setup_swap_map_and_extents(struct swap_info_struct *p,
 
 	cluster_list_init(&p->free_clusters);
 	cluster_list_init(&p->discard_clusters);
+	for (i = 0; i < SWAP_NR_ORDERS; i++)
+		INIT_LIST_HEAD(&p->nonfull_clusters[i]);
 
 	for (i = 0; i < swap_header->info.nr_badpages; i++) {
 		unsigned int page_nr = swap_header->info.badpages[i];
@@ -3156,8 +3221,10 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 			goto bad_swap_unlock_inode;
 		}
 
-		for (ci = 0; ci < nr_cluster; ci++)
+		for (ci = 0; ci < nr_cluster; ci++) {
 			spin_lock_init(&((cluster_info + ci)->lock));
+			INIT_LIST_HEAD(&((cluster_info + ci)->nonfull));
+		}
 
 		p->percpu_cluster = alloc_percpu(struct percpu_cluster);
 		if (!p->percpu_cluster) {
@@ -3314,7 +3381,9 @@ void si_swapinfo(struct sysinfo *val)
 }
 
 /*
- * Verify that a swap entry is valid and increment its swap map count.
+ * Verify that nr swap entries are valid and increment their swap map counts.
+ * The entries must all sit in the same cluster, and either all of them are
+ * updated or none is.
  *
  * Returns error code in following case.
  * - success -> 0
@@ -3324,60 +3393,77 @@ void si_swapinfo(struct sysinfo *val)
  * - swap-cache reference is requested but the entry is not used. -> ENOENT
  * - swap-mapped reference requested but needs continued swap count. -> ENOMEM
  */
-static int __swap_duplicate(swp_entry_t entry, unsigned char usage)
+static int __swap_duplicate(swp_entry_t entry, unsigned char usage, int nr)
 {
 	struct swap_info_struct *p;
 	struct swap_cluster_info *ci;
 	unsigned long offset;
 	unsigned char count;
 	unsigned char has_cache;
-	int err;
+	int err, i;
 
 	p = swp_swap_info(entry);
 
 	offset = swp_offset(entry);
+	VM_WARN_ON(nr > SWAPFILE_CLUSTER - offset % SWAPFILE_CLUSTER);
 	ci = lock_cluster_or_swap_info(p, offset);
 
-	count = p->swap_map[offset];
-
-	/*
-	 * swapin_readahead() doesn't check if a swap entry is valid, so the
-	 * swap entry could be SWAP_MAP_BAD. Check here with lock held.
-	 */
-	if (unlikely(swap_count(count) == SWAP_MAP_BAD)) {
-		err = -ENOENT;
-		goto unlock_out;
-	}
-
-	has_cache = count & SWAP_HAS_CACHE;
-	count &= ~SWAP_HAS_CACHE;
 	err = 0;
+	for (i = 0; i < nr; i++) {
+		count = p->swap_map[offset + i];
 
-	if (usage == SWAP_HAS_CACHE) {
-
-		/* set SWAP_HAS_CACHE if there is no cache and entry is used */
-		if (!has_cache && count)
-			has_cache = SWAP_HAS_CACHE;
-		else if (has_cache)		/* someone else added cache */
-			err = -EEXIST;
-		else				/* no users remaining */
+		/*
+		 * swapin_readahead() doesn't check if a swap entry is valid, so the
+		 * swap entry could be SWAP_MAP_BAD. Check here with lock held.
+		 */
+		if (unlikely(swap_count(count) == SWAP_MAP_BAD)) {
 			err = -ENOENT;
+			goto unlock_out;
+		}
 
-	} else if (count || has_cache) {
+		has_cache = count & SWAP_HAS_CACHE;
+		count &= ~SWAP_HAS_CACHE;
+
+		if (usage == SWAP_HAS_CACHE) {
+			if (has_cache)		/* someone else added cache */
+				err = -EEXIST;
+			else if (!count)	/* no users remaining */
+				err = -ENOENT;
+		} else if (!count && !has_cache) {
+			err = -ENOENT;		/* unused swap entry */
+		} else if ((count & ~COUNT_CONTINUED) > SWAP_MAP_MAX) {
+			err = -EINVAL;
+		} else if (nr > 1 && (count & ~COUNT_CONTINUED) == SWAP_MAP_MAX) {
+			/* Leave continuations to the single entry path */
+			err = -ENOMEM;
+		}
 
-		if ((count & ~COUNT_CONTINUED) < SWAP_MAP_MAX)
+		if (err)
+			goto unlock_out;
+	}
+
+	for (i = 0; i < nr; i++) {
+		count = p->swap_map[offset + i];
+		has_cache = count & SWAP_HAS_CACHE;
+		count &= ~SWAP_HAS_CACHE;
+
+		if (usage == SWAP_HAS_CACHE)
+			has_cache = SWAP_HAS_CACHE;
+		else if ((count & ~COUNT_CONTINUED) < SWAP_MAP_MAX)
 			count += usage;
-		else if ((count & ~COUNT_CONTINUED) > SWAP_MAP_MAX)
-			err = -EINVAL;
-		else if (swap_count_continued(p, offset, count))
+		else if (swap_count_continued(p, offset + i, count))
 			count = COUNT_CONTINUED;
-		else
+		else {
+			/*
+			 * Don't need to rollback changes, because for
+			 * nr > 1 any continuation was refused above.
+			 */
 			err = -ENOMEM;
-	} else
-		err = -ENOENT;			/* unused swap entry */
+			goto unlock_out;
+		}
 
-	if (!err)
-		WRITE_ONCE(p->swap_map[offset], count | has_cache);
+		WRITE_ONCE(p->swap_map[offset + i], count | has_cache);
+	}
 
 unlock_out:
 	unlock_cluster_or_swap_info(p, ci);
@@ -3390,7 +3476,7 @@ static int __swap_duplicate(swp_entry_t entry, unsigned char usage)
  */
 void swap_shmem_alloc(swp_entry_t entry)
 {
-	__swap_duplicate(entry, SWAP_MAP_SHMEM);
+	__swap_duplicate(entry, SWAP_MAP_SHMEM, 1);
 }
 
 /*
@@ -3404,35 +3490,58 @@ int swap_duplicate(swp_entry_t entry)
 {
 	int err = 0;
 
-	while (!err && __swap_duplicate(entry, 1) == -ENOMEM)
+	while (!err && __swap_duplicate(entry, 1, 1) == -ENOMEM)
 		err = add_swap_count_continuation(entry, GFP_ATOMIC);
 	return err;
 }
 
 /*
- * @entry: swap entry for which we allocate swap cache.
+ * Increase reference count of up to @nr contiguous swap entries by 1, under
+ * a single cluster lock, stopping at the end of the cluster of @entry.
  *
- * Called when allocating swap cache for existing swap entry,
+ * Returns the number of entries handled, as for swap_duplicate() other
+ * failures count as handled.  Returns -ENOMEM without changing anything if
+ * one of the entries would need a swap_count_continuation: the caller should
+ * fall back to swap_duplicate() then.
+ */
+int swap_duplicate_nr(swp_entry_t entry, int nr)
+{
+	unsigned long offset = swp_offset(entry);
+
+	nr = min_t(int, nr, SWAPFILE_CLUSTER - offset % SWAPFILE_CLUSTER);
+	if (__swap_duplicate(entry, 1, nr) == -ENOMEM)
+		return -ENOMEM;
+	return nr;
+}
+
+/*
+ * @entry: first swap entry from which we allocate swap cache.
+ * @nr: number of contiguous entries, all within one swap cluster.
+ *
+ * Called when allocating swap cache for existing swap entries,
  * This can return error codes. Returns 0 at success.
  * -EEXIST means there is a swap cache.
  * Note: return code is different from swap_duplicate().
  */
-int swapcache_prepare(swp_entry_t entry)
+int swapcache_prepare(swp_entry_t entry, int nr)
 {
-	return __swap_duplicate(entry, SWAP_HAS_CACHE);
+	return __swap_duplicate(entry, SWAP_HAS_CACHE, nr);
 }
 
-void swapcache_clear(struct swap_info_struct *si, swp_entry_t entry)
+void swapcache_clear(struct swap_info_struct *si, swp_entry_t entry, int nr)
 {
 	struct swap_cluster_info *ci;
 	unsigned long offset = swp_offset(entry);
 	unsigned char usage;
+	int i;
 
-	ci = lock_cluster_or_swap_info(si, offset);
-	usage = __swap_entry_free_locked(si, offset, SWAP_HAS_CACHE);
-	unlock_cluster_or_swap_info(si, ci);
-	if (!usage)
-		free_swap_slot(entry);
+	for (i = 0; i < nr; i++) {
+		ci = lock_cluster_or_swap_info(si, offset + i);
+		usage = __swap_entry_free_locked(si, offset + i, SWAP_HAS_CACHE);
+		unlock_cluster_or_swap_info(si, ci);
+		if (!usage)
+			free_swap_slot(swp_entry(swp_type(entry), offset + i));
+	}
 }
 
 struct swap_info_struct *swp_swap_info(swp_entry_t entry)
@@ -43,6 +43,8 @@
 #include <asm/tlbflush.h>
 #include <asm/shmparam.h>
 #include <linux/page_owner.h>
+#include <linux/debugfs.h>
+#include <linux/sysctl.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/vmalloc.h>
@@ -72,8 +74,45 @@ static int __init set_nohugevmalloc(char *str)
 	return 0;
 }
 early_param("nohugevmalloc", set_nohugevmalloc);
+
+/*
+ * VM_ALLOW_HUGE_VMAP allocations for NUMA_NO_NODE normally only get PMD
+ * mappings once every online node's share reaches PMD_SIZE. Allocations of
+ * at least this size use PMD mappings as soon as they cover one PMD, trading
+ * the rounding up to a PMD multiple for TLB reach. Zero disables this.
+ */
+static unsigned long vmalloc_huge_min_kbytes __read_mostly;
+
+static struct ctl_table vmalloc_sysctls[] = {
+	{
+		.procname	= "vmalloc_huge_min_kbytes",
+		.data		= &vmalloc_huge_min_kbytes,
+		.maxlen		= sizeof(vmalloc_huge_min_kbytes),
+		.mode		= 0644,
+		.proc_handler	= proc_doulongvec_minmax,
+	},
+};
+
+static int __init vmalloc_sysctl_init(void)
+{
+	register_sysctl_init("vm", vmalloc_sysctls);
+	return 0;
+}
+late_initcall(vmalloc_sysctl_init);
+
+static bool vmalloc_huge_eager(unsigned long size)
+{
+	unsigned long min_kbytes = READ_ONCE(vmalloc_huge_min_kbytes);
+
+	return min_kbytes && (size >> 10) >= min_kbytes;
+}
 #else /* CONFIG_HAVE_ARCH_HUGE_VMALLOC */
 static const bool vmap_allow_huge = false;
+
+static inline bool vmalloc_huge_eager(unsigned long size)
+{
+	return false;
+}
 #endif	/* CONFIG_HAVE_ARCH_HUGE_VMALLOC */
 
 bool is_vmalloc_addr(const void *x)
@@ -889,6 +928,7 @@ static struct vmap_node {
 	struct list_head purge_list;
 	struct work_struct purge_work;
 	unsigned long nr_purged;
+	u64 purge_ns;
 } single;
 
 /*
@@ -2186,11 +2226,36 @@ decay_va_pool_node(struct vmap_node *vn, bool full_decay)
 	reclaim_list_global(&decay_list);
 }
 
+#define VMAP_PURGE_HIST_SLOTS	20
+
+/*
+ * Latencies of lazy purges that had areas to free, in power of two
+ * microsecond slots: slot 0 counts events below 1us, slot N those in
+ * [2^(N-1), 2^N) us and the last slot everything longer than that.
+ * Updated under vmap_purge_lock.
+ */
+static struct vmap_purge_stats {
+	unsigned long purge[VMAP_PURGE_HIST_SLOTS];	/* whole purge */
+	unsigned long flush[VMAP_PURGE_HIST_SLOTS];	/* TLB flush */
+	unsigned long node[VMAP_PURGE_HIST_SLOTS];	/* per-node work */
+	unsigned long nr_purges;
+	unsigned long nr_offloaded;
+	u64 max_ns;
+} vmap_purge_stats;
+
+static void vmap_purge_hist_add(unsigned long *hist, u64 ns)
+{
+	unsigned int slot = fls64(div_u64(ns, NSEC_PER_USEC));
+
+	hist[min(slot, VMAP_PURGE_HIST_SLOTS - 1)]++;
+}
+
 static void purge_vmap_node(struct work_struct *work)
 {
 	struct vmap_node *vn = container_of(work,
 		struct vmap_node, purge_work);
 	struct vmap_area *va, *n_va;
+	u64 start_ns = ktime_get_ns();
 	LIST_HEAD(local_list);
 
 	vn->nr_purged = 0;
@@ -2219,6 +2284,7 @@ static void purge_vmap_node(struct work_struct *work)
 	}
 
 	reclaim_list_global(&local_list);
+	vn->purge_ns = ktime_get_ns() - start_ns;
 }
 
 /*
@@ -2230,11 +2296,14 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 	unsigned long nr_purged_areas = 0;
 	unsigned int nr_purge_helpers;
 	unsigned int nr_purge_nodes;
+	u64 start_ns, flush_ns;
 	struct vmap_node *vn;
 	int i;
 
 	lockdep_assert_held(&vmap_purge_lock);
 
+	start_ns = ktime_get_ns();
+
 	/*
 	 * Use cpumask to mark which node has to be processed.
 	 */
@@ -2266,7 +2335,10 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 
 	nr_purge_nodes = cpumask_weight(&purge_nodes);
 	if (nr_purge_nodes > 0) {
+		flush_ns = ktime_get_ns();
 		flush_tlb_kernel_range(start, end);
+		vmap_purge_hist_add(vmap_purge_stats.flush,
+				    ktime_get_ns() - flush_ns);
 
 		/* One extra worker is per a lazy_max_pages() full set minus one. */
 		nr_purge_helpers = atomic_long_read(&vmap_lazy_nr) / lazy_max_pages();
@@ -2283,11 +2355,14 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 				else
 					schedule_work(&vn->purge_work);
 
+				vmap_purge_stats.nr_offloaded++;
 				nr_purge_helpers--;
 			} else {
 				vn->purge_work.func = NULL;
 				purge_vmap_node(&vn->purge_work);
 				nr_purged_areas += vn->nr_purged;
+				vmap_purge_hist_add(vmap_purge_stats.node,
+						    vn->purge_ns);
 			}
 		}
 
@@ -2297,8 +2372,15 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 			if (vn->purge_work.func) {
 				flush_work(&vn->purge_work);
 				nr_purged_areas += vn->nr_purged;
+				vmap_purge_hist_add(vmap_purge_stats.node,
+						    vn->purge_ns);
 			}
 		}
+
+		start_ns = ktime_get_ns() - start_ns;
+		vmap_purge_hist_add(vmap_purge_stats.purge, start_ns);
+		vmap_purge_stats.max_ns = max(vmap_purge_stats.max_ns, start_ns);
+		vmap_purge_stats.nr_purges++;
 	}
 
 	trace_purge_vmap_area_lazy(start, end, nr_purged_areas);
@@ -3777,7 +3859,7 @@ void *__vmalloc_node_range_noprof(unsigned long size, unsigned long align,
 		 */
 
 		size_per_node = size;
-		if (node == NUMA_NO_NODE)
+		if (node == NUMA_NO_NODE && !vmalloc_huge_eager(size))
 			size_per_node /= num_online_nodes();
 		if (arch_vmap_pmd_supported(prot) && size_per_node >= PMD_SIZE)
 			shift = PMD_SHIFT;
@@ -3833,6 +3915,9 @@ void *__vmalloc_node_range_noprof(unsigned long size, unsigned long align,
 	if (!ret)
 		goto fail;
 
+	if (shift > PAGE_SHIFT)
+		count_vm_event(VMALLOC_HUGE_ALLOC);
+
 	/*
 	 * Mark the pages as accessible, now that they are mapped.
 	 * The condition for setting KASAN_VMALLOC_INIT should complement the
@@ -3863,6 +3948,7 @@ void *__vmalloc_node_range_noprof(unsigned long size, unsigned long align,
 
 fail:
 	if (shift > PAGE_SHIFT) {
+		count_vm_event(VMALLOC_HUGE_FALLBACK);
 		shift = PAGE_SHIFT;
 		align = real_align;
 		size = real_size;
@@ -4959,6 +5045,48 @@ module_init(proc_vmalloc_init);
 
 #endif
 
+#ifdef CONFIG_DEBUG_FS
+static int vmap_purge_stats_show(struct seq_file *m, void *v)
+{
+	struct vmap_purge_stats *st = &vmap_purge_stats;
+	int i;
+
+	mutex_lock(&vmap_purge_lock);
+	seq_printf(m, "purges %lu\n", st->nr_purges);
+	seq_printf(m, "offloaded_nodes %lu\n", st->nr_offloaded);
+	seq_printf(m, "max_usecs %llu\n", div_u64(st->max_ns, NSEC_PER_USEC));
+	seq_printf(m, "%-12s %12s %12s %12s\n",
+		   "usecs", "purge", "tlb_flush", "node");
+
+	for (i = 0; i < VMAP_PURGE_HIST_SLOTS; i++) {
+		char range[24];
+
+		if (!i)
+			snprintf(range, sizeof(range), "<1");
+		else if (i == VMAP_PURGE_HIST_SLOTS - 1)
+			snprintf(range, sizeof(range), ">=%lu", 1UL << (i - 1));
+		else
+			snprintf(range, sizeof(range), "%lu-%lu",
+				 1UL << (i - 1), 1UL << i);
+
+		seq_printf(m, "%-12s %12lu %12lu %12lu\n", range,
+			   st->purge[i], st->flush[i], st->node[i]);
+	}
+	mutex_unlock(&vmap_purge_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vmap_purge_stats);
+
+static int __init vmap_purge_debugfs_init(void)
+{
+	debugfs_create_file("vmap_purge_stats", 0400, NULL, NULL,
+			    &vmap_purge_stats_fops);
+	return 0;
+}
+late_initcall(vmap_purge_debugfs_init);
+#endif
+
 static void __init vmap_init_free_space(void)
 {
 	unsigned long vmap_start = 1;
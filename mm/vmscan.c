@@ -63,6 +63,7 @@
 #include <linux/swapops.h>
 #include <linux/balloon_compaction.h>
 #include <linux/sched/sysctl.h>
+#include <linux/lru_gen.h>
 
 #include "internal.h"
 #include "swap.h"
@@ -2655,10 +2656,11 @@ static bool __maybe_unused seq_is_valid(struct lruvec *lruvec)
  ******************************************************************************/
 
 /*
- * Bloom filters with m=1<<15, k=2 and the false positive rates of ~1/5 when
- * n=10,000 and ~1/2 when n=20,000, where, conventionally, m is the number of
- * bits in a bitmap, k is the number of hash functions and n is the number of
- * inserted items.
+ * Bloom filters with k=2 and m, the number of bits in a bitmap, sized to
+ * about BLOOM_FILTER_BITS_PER_ITEM times n, the number of items inserted
+ * into the other filter during the previous iteration, which gives false
+ * positive rates of ~1/20. The first filter of an lruvec has m=1<<15, which
+ * gives ~1/5 when n=10,000 and ~1/2 when n=20,000.
  *
  * Page table walkers use one of the two filters to reduce their search space.
  * To get rid of non-leaf entries that no longer have enough leaf entries, the
@@ -2668,80 +2670,143 @@ static bool __maybe_unused seq_is_valid(struct lruvec *lruvec)
  * walk_pmd_range(); the eviction also report them when walking the rmap
  * in lru_gen_look_around().
  *
+ * Sizing by n keeps false positives, and thus the PMDs walked in vain,
+ * bounded on large machines with many processes, while small memcgs get
+ * small filters. Filters only shrink when n dropped by more than half, to
+ * avoid reallocating them back and forth, and replaced filters are freed
+ * after an RCU grace period since walkers may still be using them.
+ *
  * For future optimizations:
  * 1. It's not necessary to keep both filters all the time. The spare one can be
  *    freed after the RCU grace period and reallocated if needed again.
- * 2. And when reallocating, it's worth scaling its size according to the number
- *    of inserted entries in the other filter, to reduce the memory overhead on
- *    small systems and false positives on large systems.
- * 3. Jenkins' hash function is an alternative to Knuth's.
+ * 2. Jenkins' hash function is an alternative to Knuth's.
  */
-#define BLOOM_FILTER_SHIFT	15
+#define BLOOM_FILTER_SHIFT		15
+#define BLOOM_FILTER_MIN_SHIFT		12
+#define BLOOM_FILTER_MAX_SHIFT		19
+#define BLOOM_FILTER_BITS_PER_ITEM	8
+
+struct lru_gen_bloom_filter {
+	struct rcu_head rcu;
+	unsigned int shift;
+	/* racy count of items that set new bits */
+	unsigned long nr_items;
+	unsigned long bitmap[];
+};
 
 static inline int filter_gen_from_seq(unsigned long seq)
 {
 	return seq % NR_BLOOM_FILTERS;
 }
 
-static void get_item_key(void *item, int *key)
+static void get_item_key(void *item, unsigned int shift, int *key)
 {
-	u32 hash = hash_ptr(item, BLOOM_FILTER_SHIFT * 2);
+	u64 hash = (u64)(unsigned long)item * GOLDEN_RATIO_64;
 
-	BUILD_BUG_ON(BLOOM_FILTER_SHIFT * 2 > BITS_PER_TYPE(u32));
+	BUILD_BUG_ON(BLOOM_FILTER_MAX_SHIFT * 2 > BITS_PER_TYPE(u64));
 
-	key[0] = hash & (BIT(BLOOM_FILTER_SHIFT) - 1);
-	key[1] = hash >> BLOOM_FILTER_SHIFT;
+	key[0] = hash >> (64 - shift);
+	key[1] = (hash >> (64 - shift * 2)) & (BIT(shift) - 1);
 }
 
 static bool test_bloom_filter(struct lru_gen_mm_state *mm_state, unsigned long seq,
 			      void *item)
 {
 	int key[2];
-	unsigned long *filter;
+	bool ret = true;
+	struct lru_gen_bloom_filter *filter;
 	int gen = filter_gen_from_seq(seq);
 
-	filter = READ_ONCE(mm_state->filters[gen]);
-	if (!filter)
-		return true;
+	rcu_read_lock();
 
-	get_item_key(item, key);
+	filter = rcu_dereference(mm_state->filters[gen]);
+	if (filter) {
+		get_item_key(item, filter->shift, key);
+		ret = test_bit(key[0], filter->bitmap) &&
+		      test_bit(key[1], filter->bitmap);
+	}
 
-	return test_bit(key[0], filter) && test_bit(key[1], filter);
+	rcu_read_unlock();
+
+	return ret;
 }
 
 static void update_bloom_filter(struct lru_gen_mm_state *mm_state, unsigned long seq,
 				void *item)
 {
+	int i;
 	int key[2];
-	unsigned long *filter;
+	bool added = false;
+	struct lru_gen_bloom_filter *filter;
 	int gen = filter_gen_from_seq(seq);
 
-	filter = READ_ONCE(mm_state->filters[gen]);
+	rcu_read_lock();
+
+	filter = rcu_dereference(mm_state->filters[gen]);
 	if (!filter)
-		return;
+		goto unlock;
 
-	get_item_key(item, key);
+	get_item_key(item, filter->shift, key);
 
-	if (!test_bit(key[0], filter))
-		set_bit(key[0], filter);
-	if (!test_bit(key[1], filter))
-		set_bit(key[1], filter);
+	for (i = 0; i < ARRAY_SIZE(key); i++) {
+		if (!test_bit(key[i], filter->bitmap)) {
+			set_bit(key[i], filter->bitmap);
+			added = true;
+		}
+	}
+
+	if (added)
+		WRITE_ONCE(filter->nr_items, READ_ONCE(filter->nr_items) + 1);
+unlock:
+	rcu_read_unlock();
+}
+
+static unsigned int bloom_filter_shift(unsigned long nr_items)
+{
+	unsigned int shift = order_base_2(nr_items * BLOOM_FILTER_BITS_PER_ITEM);
+
+	return clamp(shift, BLOOM_FILTER_MIN_SHIFT, BLOOM_FILTER_MAX_SHIFT);
 }
 
 static void reset_bloom_filter(struct lru_gen_mm_state *mm_state, unsigned long seq)
 {
-	unsigned long *filter;
+	unsigned int shift = BLOOM_FILTER_SHIFT;
+	struct lru_gen_bloom_filter *filter, *prev;
 	int gen = filter_gen_from_seq(seq);
 
-	filter = mm_state->filters[gen];
-	if (filter) {
-		bitmap_clear(filter, 0, BIT(BLOOM_FILTER_SHIFT));
+	rcu_read_lock();
+	prev = rcu_dereference(mm_state->filters[filter_gen_from_seq(seq - 1)]);
+	if (prev)
+		shift = bloom_filter_shift(READ_ONCE(prev->nr_items));
+	rcu_read_unlock();
+
+	/* only the first walker of an iteration resets the filter */
+	filter = rcu_dereference_protected(mm_state->filters[gen], true);
+	if (filter && shift < filter->shift && shift + 1 >= filter->shift)
+		shift = filter->shift;
+
+	if (filter && filter->shift == shift)
+		goto clear;
+
+	prev = filter;
+	filter = kzalloc(struct_size(filter, bitmap, BITS_TO_LONGS(BIT(shift))),
+			 __GFP_HIGH | __GFP_NOMEMALLOC | __GFP_NOWARN);
+	if (!filter) {
+		/* keep using the old size rather than none */
+		filter = prev;
+		if (filter)
+			goto clear;
 		return;
 	}
 
-	filter = bitmap_zalloc(BIT(BLOOM_FILTER_SHIFT),
-			       __GFP_HIGH | __GFP_NOMEMALLOC | __GFP_NOWARN);
-	WRITE_ONCE(mm_state->filters[gen], filter);
+	filter->shift = shift;
+	rcu_assign_pointer(mm_state->filters[gen], filter);
+	if (prev)
+		kfree_rcu(prev, rcu);
+	return;
+clear:
+	bitmap_clear(filter->bitmap, 0, BIT(filter->shift));
+	WRITE_ONCE(filter->nr_items, 0);
 }
 
 /******************************************************************************
@@ -2915,6 +2980,11 @@ static void reset_mm_stats(struct lru_gen_mm_walk *walk, bool last)
 
 	hist = lru_hist_from_seq(walk->seq);
 
+	count_vm_events(LRU_GEN_PMD_SKIP, walk->mm_stats[MM_NONLEAF_TOTAL] -
+					   walk->mm_stats[MM_NONLEAF_FOUND]);
+	count_vm_events(LRU_GEN_PMD_MISS, walk->mm_stats[MM_NONLEAF_FOUND] -
+					   walk->mm_stats[MM_NONLEAF_ADDED]);
+
 	for (i = 0; i < NR_MM_STATS; i++) {
 		WRITE_ONCE(mm_state->stats[hist][i],
 			   mm_state->stats[hist][i] + walk->mm_stats[i]);
@@ -5542,6 +5612,104 @@ static const struct file_operations lru_gen_ro_fops = {
 	.release = seq_release,
 };
 
+/******************************************************************************
+ *                          cgroup histogram interface
+ ******************************************************************************/
+
+#ifdef CONFIG_MEMCG
+static void lru_gen_fill_hist(struct lruvec *lruvec, struct lru_gen_hist_node *rec)
+{
+	int i, type, tier, zone;
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+	DEFINE_MAX_SEQ(lruvec);
+	DEFINE_MIN_SEQ(lruvec);
+
+	rec->nid = lruvec_pgdat(lruvec)->node_id;
+	rec->max_seq = max_seq;
+
+	for (type = 0; type < ANON_AND_FILE; type++)
+		rec->min_seq[type] = min_seq[type];
+
+	for (i = 0; i < MAX_NR_GENS && i <= max_seq; i++) {
+		unsigned long seq = max_seq - i;
+		int gen = lru_gen_from_seq(seq);
+		unsigned long birth = READ_ONCE(lrugen->timestamps[gen]);
+		struct lru_gen_hist_gen *hg = &rec->gens[i];
+
+		hg->seq = seq;
+		hg->age_ms = jiffies_to_msecs(jiffies - birth);
+
+		for (type = 0; type < ANON_AND_FILE; type++) {
+			if (seq < min_seq[type])
+				continue;
+
+			for (zone = 0; zone < MAX_NR_ZONES; zone++)
+				hg->nr_pages[type] +=
+					max(READ_ONCE(lrugen->nr_pages[gen][type][zone]), 0L);
+		}
+	}
+
+	for (tier = 0; tier < MAX_NR_TIERS; tier++) {
+		struct lru_gen_hist_tier *ht = &rec->tiers[tier];
+
+		for (type = 0; type < ANON_AND_FILE; type++) {
+			int hist = lru_hist_from_seq(min_seq[type]);
+
+			ht->avg_refaulted[type] = READ_ONCE(lrugen->avg_refaulted[type][tier]);
+			ht->avg_total[type] = READ_ONCE(lrugen->avg_total[type][tier]);
+			ht->refaulted[type] = atomic_long_read(&lrugen->refaulted[hist][type][tier]);
+			ht->evicted[type] = atomic_long_read(&lrugen->evicted[hist][type][tier]);
+			if (tier)
+				ht->protected[type] =
+					READ_ONCE(lrugen->protected[hist][type][tier - 1]);
+		}
+	}
+}
+
+/*
+ * Emit the generation and tier counters of all lruvecs of @memcg in the
+ * binary format of <uapi/linux/lru_gen.h>. Everything is read from the
+ * live, eventually consistent counters, without walking any lists, so
+ * this is cheap enough to be polled.
+ */
+int lru_gen_memcg_hist_show(struct seq_file *m, struct mem_cgroup *memcg)
+{
+	struct lru_gen_hist_header hdr = {
+		.version = LRU_GEN_HIST_VERSION,
+		.record_size = sizeof(struct lru_gen_hist_node),
+		.nr_gens = MAX_NR_GENS,
+		.nr_tiers = MAX_NR_TIERS,
+	};
+	nodemask_t nodes = node_states[N_MEMORY];
+	struct lru_gen_hist_node *rec;
+	int nid;
+
+	BUILD_BUG_ON(MAX_NR_GENS > LRU_GEN_HIST_MAX_GENS);
+	BUILD_BUG_ON(MAX_NR_TIERS > LRU_GEN_HIST_MAX_TIERS);
+	BUILD_BUG_ON(ANON_AND_FILE != LRU_GEN_HIST_NR_TYPES);
+
+	if (!lru_gen_enabled())
+		return -EOPNOTSUPP;
+
+	rec = kmalloc(sizeof(*rec), GFP_KERNEL);
+	if (!rec)
+		return -ENOMEM;
+
+	hdr.nr_nodes = nodes_weight(nodes);
+	seq_write(m, &hdr, sizeof(hdr));
+
+	for_each_node_mask(nid, nodes) {
+		memset(rec, 0, sizeof(*rec));
+		lru_gen_fill_hist(mem_cgroup_lruvec(memcg, NODE_DATA(nid)), rec);
+		seq_write(m, rec, sizeof(*rec));
+	}
+
+	kfree(rec);
+
+	return 0;
+}
+#endif /* CONFIG_MEMCG */
+
 /******************************************************************************
  *                          initialization
  ******************************************************************************/
@@ -5612,8 +5780,8 @@ void lru_gen_exit_memcg(struct mem_cgroup *memcg)
 			continue;
 
 		for (i = 0; i < NR_BLOOM_FILTERS; i++) {
-			bitmap_free(mm_state->filters[i]);
-			mm_state->filters[i] = NULL;
+			kfree(rcu_dereference_protected(mm_state->filters[i], true));
+			RCU_INIT_POINTER(mm_state->filters[i], NULL);
 		}
 	}
 }
@@ -195,6 +195,70 @@ void fold_vm_numa_events(void)
 
 #ifdef CONFIG_SMP
 
+#ifdef CONFIG_HAVE_CMPXCHG_LOCAL
+/*
+ * When the kernel is booted with nohz_full= or isolcpus=, vmstat_shepherd
+ * folds the differentials of isolated CPUs from a housekeeping CPU instead
+ * of queueing vmstat_work on them.  The remote fold takes the differential
+ * with xchg(), so every update of a differential has to be SMP-atomic as
+ * well while this is enabled: this_cpu_cmpxchg() and the plain RMW of the
+ * __mod_*() variants are only atomic against the local CPU.
+ */
+static DEFINE_STATIC_KEY_FALSE(vmstat_remote_fold);
+
+static inline bool vmstat_fold_remote(void)
+{
+	return static_branch_unlikely(&vmstat_remote_fold);
+}
+
+/*
+ * Add @delta to the differential at @p of the current CPU, SMP-atomically.
+ * Returns the amount that overflowed the threshold @t and must be added to
+ * the zone or node counter.  @overstep_mode as for mod_zone_state().
+ */
+static long vmstat_diff_add_atomic(s8 *p, long delta, long t,
+				   int overstep_mode)
+{
+	long n, z;
+	s8 o;
+
+	o = READ_ONCE(*p);
+	do {
+		z = 0;
+		n = delta + (long)o;
+
+		if (abs(n) > t) {
+			int os = overstep_mode * (t >> 1);
+
+			z = n + os;
+			n = -os;
+		}
+	} while (!try_cmpxchg(p, &o, n));
+
+	return z;
+}
+#else
+static inline bool vmstat_fold_remote(void)
+{
+	return false;
+}
+
+static inline long vmstat_diff_add_atomic(s8 *p, long delta, long t,
+					  int overstep_mode)
+{
+	BUILD_BUG();
+	return 0;
+}
+#endif
+
+/* Take the differential at @p of the current cpu, see vmstat_fold_remote() */
+static inline s8 vmstat_diff_take(s8 __percpu *p)
+{
+	if (vmstat_fold_remote())
+		return xchg(this_cpu_ptr(p), 0);
+	return this_cpu_xchg(*p, 0);
+}
+
 int calculate_pressure_threshold(struct zone *zone)
 {
 	int threshold;
@@ -356,10 +420,18 @@ void __mod_zone_page_state(struct zone *zone, enum zone_stat_item item,
 	 */
 	preempt_disable_nested();
 
-	x = delta + __this_cpu_read(*p);
-
 	t = __this_cpu_read(pcp->stat_threshold);
 
+	if (vmstat_fold_remote()) {
+		x = vmstat_diff_add_atomic(this_cpu_ptr(p), delta, t, 0);
+		if (x)
+			zone_page_state_add(x, zone, item);
+		preempt_enable_nested();
+		return;
+	}
+
+	x = delta + __this_cpu_read(*p);
+
 	if (unlikely(abs(x) > t)) {
 		zone_page_state_add(x, zone, item);
 		x = 0;
@@ -392,10 +464,18 @@ void __mod_node_page_state(struct pglist_data *pgdat, enum node_stat_item item,
 	/* See __mod_node_page_state */
 	preempt_disable_nested();
 
-	x = delta + __this_cpu_read(*p);
-
 	t = __this_cpu_read(pcp->stat_threshold);
 
+	if (vmstat_fold_remote()) {
+		x = vmstat_diff_add_atomic(this_cpu_ptr(p), delta, t, 0);
+		if (x)
+			node_page_state_add(x, pgdat, item);
+		preempt_enable_nested();
+		return;
+	}
+
+	x = delta + __this_cpu_read(*p);
+
 	if (unlikely(abs(x) > t)) {
 		node_page_state_add(x, pgdat, item);
 		x = 0;
@@ -438,6 +518,16 @@ void __inc_zone_state(struct zone *zone, enum zone_stat_item item)
 	/* See __mod_node_page_state */
 	preempt_disable_nested();
 
+	if (vmstat_fold_remote()) {
+		long z = vmstat_diff_add_atomic(this_cpu_ptr(p), 1,
+					__this_cpu_read(pcp->stat_threshold),
+					1);
+		if (z)
+			zone_page_state_add(z, zone, item);
+		preempt_enable_nested();
+		return;
+	}
+
 	v = __this_cpu_inc_return(*p);
 	t = __this_cpu_read(pcp->stat_threshold);
 	if (unlikely(v > t)) {
@@ -461,6 +551,16 @@ void __inc_node_state(struct pglist_data *pgdat, enum node_stat_item item)
 	/* See __mod_node_page_state */
 	preempt_disable_nested();
 
+	if (vmstat_fold_remote()) {
+		long z = vmstat_diff_add_atomic(this_cpu_ptr(p), 1,
+					__this_cpu_read(pcp->stat_threshold),
+					1);
+		if (z)
+			node_page_state_add(z, pgdat, item);
+		preempt_enable_nested();
+		return;
+	}
+
 	v = __this_cpu_inc_return(*p);
 	t = __this_cpu_read(pcp->stat_threshold);
 	if (unlikely(v > t)) {
@@ -494,6 +594,16 @@ void __dec_zone_state(struct zone *zone, enum zone_stat_item item)
 	/* See __mod_node_page_state */
 	preempt_disable_nested();
 
+	if (vmstat_fold_remote()) {
+		long z = vmstat_diff_add_atomic(this_cpu_ptr(p), -1,
+					__this_cpu_read(pcp->stat_threshold),
+					-1);
+		if (z)
+			zone_page_state_add(z, zone, item);
+		preempt_enable_nested();
+		return;
+	}
+
 	v = __this_cpu_dec_return(*p);
 	t = __this_cpu_read(pcp->stat_threshold);
 	if (unlikely(v < - t)) {
@@ -517,6 +627,16 @@ void __dec_node_state(struct pglist_data *pgdat, enum node_stat_item item)
 	/* See __mod_node_page_state */
 	preempt_disable_nested();
 
+	if (vmstat_fold_remote()) {
+		long z = vmstat_diff_add_atomic(this_cpu_ptr(p), -1,
+					__this_cpu_read(pcp->stat_threshold),
+					-1);
+		if (z)
+			node_page_state_add(z, pgdat, item);
+		preempt_enable_nested();
+		return;
+	}
+
 	v = __this_cpu_dec_return(*p);
 	t = __this_cpu_read(pcp->stat_threshold);
 	if (unlikely(v < - t)) {
@@ -562,6 +682,17 @@ static inline void mod_zone_state(struct zone *zone,
 	long n, t, z;
 	s8 o;
 
+	if (vmstat_fold_remote()) {
+		preempt_disable();
+		z = vmstat_diff_add_atomic(this_cpu_ptr(p), delta,
+					   this_cpu_read(pcp->stat_threshold),
+					   overstep_mode);
+		preempt_enable();
+		if (z)
+			zone_page_state_add(z, zone, item);
+		return;
+	}
+
 	o = this_cpu_read(*p);
 	do {
 		z = 0;  /* overflow to zone counters */
@@ -631,6 +762,17 @@ static inline void mod_node_state(struct pglist_data *pgdat,
 		delta >>= PAGE_SHIFT;
 	}
 
+	if (vmstat_fold_remote()) {
+		preempt_disable();
+		z = vmstat_diff_add_atomic(this_cpu_ptr(p), delta,
+					   this_cpu_read(pcp->stat_threshold),
+					   overstep_mode);
+		preempt_enable();
+		if (z)
+			node_page_state_add(z, pgdat, item);
+		return;
+	}
+
 	o = this_cpu_read(*p);
 	do {
 		z = 0;  /* overflow to node counters */
@@ -821,7 +963,7 @@ static int refresh_cpu_vm_stats(bool do_pagesets)
 		for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++) {
 			int v;
 
-			v = this_cpu_xchg(pzstats->vm_stat_diff[i], 0);
+			v = vmstat_diff_take(&pzstats->vm_stat_diff[i]);
 			if (v) {
 
 				atomic_long_add(v, &zone->vm_stat[i]);
@@ -876,7 +1018,7 @@ static int refresh_cpu_vm_stats(bool do_pagesets)
 		for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++) {
 			int v;
 
-			v = this_cpu_xchg(p->vm_node_stat_diff[i], 0);
+			v = vmstat_diff_take(&p->vm_node_stat_diff[i]);
 			if (v) {
 				atomic_long_add(v, &pgdat->vm_stat[i]);
 				global_node_diff[i] += v;
@@ -948,6 +1090,65 @@ void cpu_vm_stats_fold(int cpu)
 	fold_diff(global_zone_diff, global_node_diff);
 }
 
+#ifdef CONFIG_HAVE_CMPXCHG_LOCAL
+/*
+ * Fold the differentials of a remote, isolated cpu into the zone, node
+ * and global counters.  Counterpart of refresh_cpu_vm_stats() for cpus
+ * that must not run vmstat_work; the pagesets are left alone.
+ */
+static int fold_remote_cpu_vm_stats(int cpu)
+{
+	struct pglist_data *pgdat;
+	struct zone *zone;
+	int i;
+	int global_zone_diff[NR_VM_ZONE_STAT_ITEMS] = { 0, };
+	int global_node_diff[NR_VM_NODE_STAT_ITEMS] = { 0, };
+
+	for_each_populated_zone(zone) {
+		struct per_cpu_zonestat *pzstats;
+
+		pzstats = per_cpu_ptr(zone->per_cpu_zonestats, cpu);
+
+		for (i = 0; i < NR_VM_ZONE_STAT_ITEMS; i++) {
+			int v;
+
+			if (!READ_ONCE(pzstats->vm_stat_diff[i]))
+				continue;
+			v = xchg(&pzstats->vm_stat_diff[i], 0);
+			if (v) {
+				atomic_long_add(v, &zone->vm_stat[i]);
+				global_zone_diff[i] += v;
+			}
+		}
+	}
+
+	for_each_online_pgdat(pgdat) {
+		struct per_cpu_nodestat *p;
+
+		p = per_cpu_ptr(pgdat->per_cpu_nodestats, cpu);
+
+		for (i = 0; i < NR_VM_NODE_STAT_ITEMS; i++) {
+			int v;
+
+			if (!READ_ONCE(p->vm_node_stat_diff[i]))
+				continue;
+			v = xchg(&p->vm_node_stat_diff[i], 0);
+			if (v) {
+				atomic_long_add(v, &pgdat->vm_stat[i]);
+				global_node_diff[i] += v;
+			}
+		}
+	}
+
+	return fold_diff(global_zone_diff, global_node_diff);
+}
+#else
+static inline int fold_remote_cpu_vm_stats(int cpu)
+{
+	return 0;
+}
+#endif
+
 /*
  * this is only called if !populated_zone(zone), which implies no other users of
  * pset->vm_stat_diff[] exist.
@@ -1251,6 +1452,8 @@ const char * const vmstat_text[] = {
 #ifdef CONFIG_NUMA_BALANCING
 	"pgpromote_success",
 	"pgpromote_candidate",
+	"pgpromote_batched",
+	"pgpromote_ratelimited",
 #endif
 	"pgdemote_kswapd",
 	"pgdemote_direct",
@@ -1323,6 +1526,9 @@ const char * const vmstat_text[] = {
 	"thp_migration_success",
 	"thp_migration_fail",
 	"thp_migration_split",
+	"pgmigrate_copy_bytes_serial",
+	"pgmigrate_copy_bytes_threads",
+	"pgmigrate_copy_bytes_dma",
 #endif
 #ifdef CONFIG_COMPACTION
 	"compact_migrate_scanned",
@@ -1406,6 +1612,12 @@ const char * const vmstat_text[] = {
 	"zswpout",
 	"zswpwb",
 #endif
+#ifdef CONFIG_LRU_GEN
+	"lru_gen_pmd_skip",
+	"lru_gen_pmd_miss",
+#endif
+	"vmalloc_huge_alloc",
+	"vmalloc_huge_fallback",
 #ifdef CONFIG_X86
 	"direct_map_level2_splits",
 	"direct_map_level3_splits",
@@ -1415,6 +1627,10 @@ const char * const vmstat_text[] = {
 	"vma_lock_abort",
 	"vma_lock_retry",
 	"vma_lock_miss",
+	"vma_lock_fallback_fault_ops",
+	"vma_lock_fallback_anon_vma",
+	"vma_lock_fallback_device_private",
+	"vma_lock_fallback_retry",
 #endif
 #endif /* CONFIG_VM_EVENT_COUNTERS || CONFIG_MEMCG */
 };
@@ -1746,11 +1962,19 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 			   "\n    cpu: %i"
 			   "\n              count: %i"
 			   "\n              high:  %i"
-			   "\n              batch: %i",
+			   "\n              batch: %i"
+			   "\n              refill_factor: %u"
+			   "\n              refills: %lu",
 			   i,
 			   pcp->count,
 			   pcp->high,
-			   pcp->batch);
+			   pcp->batch,
+			   pcp->refill_factor,
+			   pcp->nr_refills);
+#ifdef CONFIG_NUMA
+		seq_printf(m, "\n              remote_frees: %lu",
+			   pcp->nr_remote_frees);
+#endif
 #ifdef CONFIG_SMP
 		pzstats = per_cpu_ptr(zone->per_cpu_zonestats, i);
 		seq_printf(m, "\n  vm stats threshold: %d",
@@ -1948,7 +2172,8 @@ int vmstat_refresh(struct ctl_table *table, int write,
 
 static void vmstat_update(struct work_struct *w)
 {
-	if (refresh_cpu_vm_stats(true)) {
+	if (refresh_cpu_vm_stats(true) &&
+	    !(vmstat_fold_remote() && cpu_is_isolated(smp_processor_id()))) {
 		/*
 		 * Counters were updated so we expect more updates
 		 * to occur in the future. Keep on running the
@@ -2043,9 +2268,14 @@ static void vmstat_shepherd(struct work_struct *w)
 		 * been isolated from the kernel interference without critical
 		 * infrastructure ever noticing. Skip regular flushing from vmstat_shepherd
 		 * for all isolated CPUs to avoid interference with the isolated workload.
+		 * Where the differentials can be folded remotely, do that from here
+		 * instead so that the drift of isolated CPUs stays bounded.
 		 */
-		if (cpu_is_isolated(cpu))
+		if (cpu_is_isolated(cpu)) {
+			if (vmstat_fold_remote() && need_update(cpu))
+				fold_remote_cpu_vm_stats(cpu);
 			continue;
+		}
 
 		if (!delayed_work_pending(dw) && need_update(cpu))
 			queue_delayed_work_on(cpu, mm_percpu_wq, dw, 0);
@@ -2062,6 +2292,12 @@ static void __init start_shepherd_timer(void)
 {
 	int cpu;
 
+#ifdef CONFIG_HAVE_CMPXCHG_LOCAL
+	if (housekeeping_enabled(HK_TYPE_TICK) ||
+	    housekeeping_enabled(HK_TYPE_DOMAIN))
+		static_branch_enable(&vmstat_remote_fold);
+#endif
+
 	for_each_possible_cpu(cpu)
 		INIT_DEFERRABLE_WORK(per_cpu_ptr(&vmstat_work, cpu),
 			vmstat_update);
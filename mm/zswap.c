@@ -35,6 +35,8 @@
 #include <linux/pagemap.h>
 #include <linux/workqueue.h>
 #include <linux/list_lru.h>
+#include <linux/mm_inline.h>
+#include <linux/sched/stat.h>
 
 #include "swap.h"
 #include "internal.h"
@@ -58,6 +60,8 @@ static atomic_t zswap_same_filled_pages = ATOMIC_INIT(0);
 static u64 zswap_pool_limit_hit;
 /* Pages written back when pool limit was reached */
 static u64 zswap_written_back_pages;
+/* Pages written back by the background writer because they aged out */
+static u64 zswap_aged_written_back_pages;
 /* Store failed due to a reclaim failure after pool limit was reached */
 static u64 zswap_reject_reclaim_fail;
 /* Store failed due to compression algorithm failure */
@@ -131,6 +135,24 @@ static bool zswap_shrinker_enabled = IS_ENABLED(
 		CONFIG_ZSWAP_SHRINKER_DEFAULT_ON);
 module_param_named(shrinker_enabled, zswap_shrinker_enabled, bool, 0644);
 
+/*
+ * Proactively write back entries that were stored this many MGLRU
+ * generations ago, while the system is otherwise idle. 0 disables it.
+ */
+static unsigned int zswap_writeback_age;
+static int zswap_writeback_age_param_set(const char *,
+					 const struct kernel_param *);
+static const struct kernel_param_ops zswap_writeback_age_param_ops = {
+	.set =		zswap_writeback_age_param_set,
+	.get =		param_get_uint,
+};
+module_param_cb(writeback_age, &zswap_writeback_age_param_ops,
+		&zswap_writeback_age, 0644);
+
+/* How often the aged writeback runs, and how much it does per lruvec */
+#define ZSWAP_AGE_WRITEBACK_INTERVAL	(10 * HZ)
+#define ZSWAP_AGE_WRITEBACK_BATCH	64
+
 bool is_zswap_enabled(void)
 {
 	return zswap_enabled;
@@ -140,11 +162,27 @@ bool is_zswap_enabled(void)
 * data structures
 **********************************/
 
+/*
+ * Maximum number of subpages of a large folio that are stored together.
+ * Asynchronous (hardware) compressors get one request per subpage in
+ * flight, so that they can work on the whole batch in parallel.
+ */
+#define ZSWAP_MAX_BATCH_SIZE 8
+
+/*
+ * reqs, waits, buffers and the scatterlists are indexed by the position of
+ * a page within a compression batch. Synchronous compressors only ever
+ * process one page at a time and thus only have nr_reqs == 1 of them.
+ * Slot 0 is also used for decompression.
+ */
 struct crypto_acomp_ctx {
 	struct crypto_acomp *acomp;
-	struct acomp_req *req;
-	struct crypto_wait wait;
-	u8 *buffer;
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE];
+	struct crypto_wait waits[ZSWAP_MAX_BATCH_SIZE];
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist inputs[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist outputs[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int nr_reqs;
 	struct mutex mutex;
 	bool is_sleepable;
 };
@@ -173,6 +211,7 @@ static DEFINE_SPINLOCK(zswap_shrink_lock);
 static struct mem_cgroup *zswap_next_shrink;
 static struct work_struct zswap_shrink_work;
 static struct shrinker *zswap_shrinker;
+static struct delayed_work zswap_age_work;
 
 /*
  * struct zswap_entry
@@ -187,12 +226,15 @@ static struct shrinker *zswap_shrinker;
  * pool - the zswap_pool the entry's data is in
  * handle - zpool allocation handle that stores the compressed page data
  * value - value of the same-value filled pages which have same content
+ * lru_seq - lower bits of the MGLRU max_seq of the entry's lruvec when the
+ *           entry was added to the LRU, used to tell its age.
  * objcg - the obj_cgroup that the compressed memory is charged to
  * lru - handle to the pool's lru used to evict pages.
  */
 struct zswap_entry {
 	swp_entry_t swpentry;
 	unsigned int length;
+	unsigned int lru_seq;
 	struct zswap_pool *pool;
 	union {
 		unsigned long handle;
@@ -477,6 +519,141 @@ static struct zswap_pool *zswap_pool_find_get(char *type, char *compressor)
 	return NULL;
 }
 
+#ifdef CONFIG_MEMCG_KMEM
+/* serializes updates of memcg->zswap_pool */
+static DEFINE_MUTEX(zswap_memcg_pool_lock);
+
+/*
+ * Returns a reference to the pool that new entries charged to @objcg are
+ * stored in: the pool bound to the closest memcg in its hierarchy through
+ * memory.zswap.pool, or the current global pool if there is none.
+ */
+static struct zswap_pool *zswap_pool_objcg_get(struct obj_cgroup *objcg)
+{
+	struct mem_cgroup *memcg;
+	struct zswap_pool *pool;
+
+	if (!objcg)
+		return zswap_pool_current_get();
+
+	rcu_read_lock();
+	for (memcg = obj_cgroup_memcg(objcg); memcg;
+	     memcg = parent_mem_cgroup(memcg)) {
+		pool = rcu_dereference(memcg->zswap_pool);
+		if (pool && zswap_pool_get(pool)) {
+			rcu_read_unlock();
+			return pool;
+		}
+	}
+	rcu_read_unlock();
+
+	return zswap_pool_current_get();
+}
+
+static void zswap_memcg_pool_replace(struct mem_cgroup *memcg,
+				     struct zswap_pool *pool)
+{
+	struct zswap_pool *old;
+
+	mutex_lock(&zswap_memcg_pool_lock);
+	old = rcu_replace_pointer(memcg->zswap_pool, pool,
+				  lockdep_is_held(&zswap_memcg_pool_lock));
+	mutex_unlock(&zswap_memcg_pool_lock);
+
+	/* drop the memcg's ref, the pool goes away with its last entry */
+	if (old)
+		zswap_pool_put(old);
+}
+
+/*
+ * Bind @memcg to a pool using the compressor and zpool type given in @buf,
+ * as "<compressor> [<zpool>]". Without a zpool type, the global zpool
+ * parameter is used. Writing "default" makes the memcg fall back to its
+ * parent's pool again.
+ */
+int zswap_memcg_pool_set(struct mem_cgroup *memcg, char *buf)
+{
+	char *compressor, *type, *s = strstrip(buf);
+	char zpool_type[32];
+	struct zswap_pool *pool;
+	int ret = 0;
+
+	if (!strcmp(s, "default")) {
+		zswap_memcg_pool_replace(memcg, NULL);
+		return 0;
+	}
+
+	compressor = strsep(&s, " \t");
+	type = s ? skip_spaces(s) : NULL;
+	if (!type || !*type) {
+		kernel_param_lock(THIS_MODULE);
+		strscpy(zpool_type, zswap_zpool_type, sizeof(zpool_type));
+		kernel_param_unlock(THIS_MODULE);
+		type = zpool_type;
+	}
+
+	mutex_lock(&zswap_init_lock);
+	if (zswap_init_state != ZSWAP_INIT_SUCCEED)
+		ret = -ENODEV;
+	mutex_unlock(&zswap_init_lock);
+	if (ret)
+		return ret;
+
+	if (!crypto_has_acomp(compressor, 0, 0)) {
+		pr_err("compressor %s not available\n", compressor);
+		return -ENOENT;
+	}
+	if (!zpool_has_pool(type)) {
+		pr_err("zpool %s not available\n", type);
+		return -ENOENT;
+	}
+
+	spin_lock_bh(&zswap_pools_lock);
+	pool = zswap_pool_find_get(type, compressor);
+	spin_unlock_bh(&zswap_pools_lock);
+
+	if (!pool) {
+		pool = zswap_pool_create(type, compressor);
+		if (!pool)
+			return -EINVAL;
+
+		/*
+		 * The pool never becomes the current pool by being bound to
+		 * a memcg: take the memcg's ref and drop the initial one, so
+		 * that it is destroyed like any other decommissioned pool
+		 * once the memcg and all its entries let go of it.
+		 */
+		WARN_ON(!zswap_pool_get(pool));
+		spin_lock_bh(&zswap_pools_lock);
+		list_add_tail_rcu(&pool->list, &zswap_pools);
+		spin_unlock_bh(&zswap_pools_lock);
+		percpu_ref_kill(&pool->ref);
+	}
+
+	zswap_memcg_pool_replace(memcg, pool);
+	return 0;
+}
+
+void zswap_memcg_pool_show(struct seq_file *m, struct mem_cgroup *memcg)
+{
+	struct zswap_pool *pool;
+
+	rcu_read_lock();
+	pool = rcu_dereference(memcg->zswap_pool);
+	if (pool)
+		seq_printf(m, "%s %s\n", pool->tfm_name,
+			   zpool_get_type(pool->zpools[0]));
+	else
+		seq_puts(m, "default\n");
+	rcu_read_unlock();
+}
+#else
+static struct zswap_pool *zswap_pool_objcg_get(struct obj_cgroup *objcg)
+{
+	return zswap_pool_current_get();
+}
+#endif
+
 static unsigned long zswap_max_pages(void)
 {
 	return totalram_pages() * zswap_max_pool_percent / 100;
@@ -708,6 +885,15 @@ static inline int entry_to_nid(struct zswap_entry *entry)
 	return page_to_nid(virt_to_page(entry));
 }
 
+static unsigned int zswap_lruvec_seq(struct lruvec *lruvec)
+{
+#ifdef CONFIG_LRU_GEN
+	return READ_ONCE(lruvec->lrugen.max_seq);
+#else
+	return 0;
+#endif
+}
+
 static void zswap_lru_add(struct list_lru *list_lru, struct zswap_entry *entry)
 {
 	atomic_long_t *nr_zswap_protected;
@@ -736,6 +922,7 @@ static void zswap_lru_add(struct list_lru *list_lru, struct zswap_entry *entry)
 	/* Update the protection area */
 	lru_size = list_lru_count_one(list_lru, nid, memcg);
 	lruvec = mem_cgroup_lruvec(memcg, NODE_DATA(nid));
+	entry->lru_seq = zswap_lruvec_seq(lruvec);
 	nr_zswap_protected = &lruvec->zswap_lruvec_state.nr_zswap_protected;
 	old = atomic_long_inc_return(nr_zswap_protected);
 	/*
@@ -782,6 +969,11 @@ void zswap_memcg_offline_cleanup(struct mem_cgroup *memcg)
 	if (zswap_next_shrink == memcg)
 		zswap_next_shrink = mem_cgroup_iter(NULL, zswap_next_shrink, NULL);
 	spin_unlock(&zswap_shrink_lock);
+
+#ifdef CONFIG_MEMCG_KMEM
+	/* objcgs are reparented, new stores no longer see this memcg */
+	zswap_memcg_pool_replace(memcg, NULL);
+#endif
 }
 
 /*********************************
@@ -832,54 +1024,76 @@ static void zswap_entry_free(struct zswap_entry *entry)
 /*********************************
 * compressed storage functions
 **********************************/
+static void zswap_cpu_comp_free(struct crypto_acomp_ctx *acomp_ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZSWAP_MAX_BATCH_SIZE; i++) {
+		if (!IS_ERR_OR_NULL(acomp_ctx->reqs[i]))
+			acomp_request_free(acomp_ctx->reqs[i]);
+		acomp_ctx->reqs[i] = NULL;
+		kfree(acomp_ctx->buffers[i]);
+		acomp_ctx->buffers[i] = NULL;
+	}
+	if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
+		crypto_free_acomp(acomp_ctx->acomp);
+	acomp_ctx->acomp = NULL;
+	acomp_ctx->nr_reqs = 0;
+}
+
 static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
 	struct crypto_acomp *acomp;
 	struct acomp_req *req;
+	unsigned int i;
 	int ret;
 
 	mutex_init(&acomp_ctx->mutex);
 
-	acomp_ctx->buffer = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL, cpu_to_node(cpu));
-	if (!acomp_ctx->buffer)
-		return -ENOMEM;
-
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
 				pool->tfm_name, PTR_ERR(acomp));
-		ret = PTR_ERR(acomp);
-		goto acomp_fail;
+		return PTR_ERR(acomp);
 	}
 	acomp_ctx->acomp = acomp;
 	acomp_ctx->is_sleepable = acomp_is_async(acomp);
+	acomp_ctx->nr_reqs = acomp_ctx->is_sleepable ? ZSWAP_MAX_BATCH_SIZE : 1;
+
+	for (i = 0; i < acomp_ctx->nr_reqs; i++) {
+		acomp_ctx->buffers[i] = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL,
+						     cpu_to_node(cpu));
+		if (!acomp_ctx->buffers[i]) {
+			ret = -ENOMEM;
+			goto fail;
+		}
 
-	req = acomp_request_alloc(acomp_ctx->acomp);
-	if (!req) {
-		pr_err("could not alloc crypto acomp_request %s\n",
-		       pool->tfm_name);
-		ret = -ENOMEM;
-		goto req_fail;
-	}
-	acomp_ctx->req = req;
+		req = acomp_request_alloc(acomp_ctx->acomp);
+		if (!req) {
+			pr_err("could not alloc crypto acomp_request %s\n",
+			       pool->tfm_name);
+			ret = -ENOMEM;
+			goto fail;
+		}
+		acomp_ctx->reqs[i] = req;
 
-	crypto_init_wait(&acomp_ctx->wait);
-	/*
-	 * if the backend of acomp is async zip, crypto_req_done() will wakeup
-	 * crypto_wait_req(); if the backend of acomp is scomp, the callback
-	 * won't be called, crypto_wait_req() will return without blocking.
-	 */
-	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
-				   crypto_req_done, &acomp_ctx->wait);
+		crypto_init_wait(&acomp_ctx->waits[i]);
+		/*
+		 * if the backend of acomp is async zip, crypto_req_done() will
+		 * wakeup crypto_wait_req(); if the backend of acomp is scomp,
+		 * the callback won't be called, crypto_wait_req() will return
+		 * without blocking.
+		 */
+		acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   crypto_req_done, &acomp_ctx->waits[i]);
+	}
 
 	return 0;
 
-req_fail:
-	crypto_free_acomp(acomp_ctx->acomp);
-acomp_fail:
-	kfree(acomp_ctx->buffer);
+fail:
+	zswap_cpu_comp_free(acomp_ctx);
 	return ret;
 }
 
@@ -888,76 +1102,106 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
 
-	if (!IS_ERR_OR_NULL(acomp_ctx)) {
-		if (!IS_ERR_OR_NULL(acomp_ctx->req))
-			acomp_request_free(acomp_ctx->req);
-		if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
-			crypto_free_acomp(acomp_ctx->acomp);
-		kfree(acomp_ctx->buffer);
-	}
+	if (!IS_ERR_OR_NULL(acomp_ctx))
+		zswap_cpu_comp_free(acomp_ctx);
 
 	return 0;
 }
 
-static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
+/*
+ * Compress the pages backing the @nr entries in @entries, which all belong
+ * to @folio and to the same pool, and store the results in the zpool.
+ *
+ * The pages are processed in batches of up to acomp_ctx->nr_reqs. All
+ * requests of a batch are submitted before waiting for the first one to
+ * complete, which lets asynchronous compressors work on them in parallel,
+ * then zpool storage for the whole batch is allocated in a single pass.
+ *
+ * On failure, entries that already got zpool storage have a non-zero
+ * length and must be released by the caller.
+ */
+static bool zswap_compress(struct folio *folio, struct zswap_entry **entries,
+			   unsigned int nr)
 {
+	pgoff_t folio_offset = swp_offset(folio->swap);
 	struct crypto_acomp_ctx *acomp_ctx;
-	struct scatterlist input, output;
+	int errors[ZSWAP_MAX_BATCH_SIZE];
 	int comp_ret = 0, alloc_ret = 0;
-	unsigned int dlen = PAGE_SIZE;
+	struct zswap_entry *entry;
+	unsigned int i, j, batch;
+	unsigned int dlen;
 	unsigned long handle;
 	struct zpool *zpool;
 	char *buf;
 	gfp_t gfp;
-	u8 *dst;
 
-	acomp_ctx = raw_cpu_ptr(entry->pool->acomp_ctx);
+	acomp_ctx = raw_cpu_ptr(entries[0]->pool->acomp_ctx);
 
 	mutex_lock(&acomp_ctx->mutex);
 
-	dst = acomp_ctx->buffer;
-	sg_init_table(&input, 1);
-	sg_set_page(&input, &folio->page, PAGE_SIZE, 0);
-
-	/*
-	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
-	 * and hardware-accelerators may won't check the dst buffer size, so
-	 * giving the dst buffer with enough length to avoid buffer overflow.
-	 */
-	sg_init_one(&output, dst, PAGE_SIZE * 2);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, dlen);
+	for (i = 0; i < nr; i += batch) {
+		batch = min(nr - i, acomp_ctx->nr_reqs);
+
+		for (j = 0; j < batch; j++) {
+			struct scatterlist *input = &acomp_ctx->inputs[j];
+			struct scatterlist *output = &acomp_ctx->outputs[j];
+			struct page *page;
+
+			entry = entries[i + j];
+			page = folio_page(folio, swp_offset(entry->swpentry) -
+					  folio_offset);
+
+			sg_init_table(input, 1);
+			sg_set_page(input, page, PAGE_SIZE, 0);
+
+			/*
+			 * We need PAGE_SIZE * 2 here since there maybe
+			 * over-compression case, and hardware-accelerators may
+			 * won't check the dst buffer size, so giving the dst
+			 * buffer with enough length to avoid buffer overflow.
+			 */
+			sg_init_one(output, acomp_ctx->buffers[j], PAGE_SIZE * 2);
+			acomp_request_set_params(acomp_ctx->reqs[j], input, output,
+						 PAGE_SIZE, PAGE_SIZE);
+
+			/*
+			 * Synchronous compressors complete the request right
+			 * here; asynchronous ones queue it and we only wait
+			 * for completion once the whole batch is in flight.
+			 * Different CPUs have different acomp instances, so
+			 * multiple threads can still compress in parallel.
+			 */
+			errors[j] = crypto_acomp_compress(acomp_ctx->reqs[j]);
+		}
 
-	/*
-	 * it maybe looks a little bit silly that we send an asynchronous request,
-	 * then wait for its completion synchronously. This makes the process look
-	 * synchronous in fact.
-	 * Theoretically, acomp supports users send multiple acomp requests in one
-	 * acomp instance, then get those requests done simultaneously. but in this
-	 * case, zswap actually does store and load page by page, there is no
-	 * existing method to send the second page before the first page is done
-	 * in one thread doing zwap.
-	 * but in different threads running on different cpu, we have different
-	 * acomp instance, so multiple threads can do (de)compression in parallel.
-	 */
-	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
-	if (comp_ret)
-		goto unlock;
-
-	zpool = zswap_find_zpool(entry);
-	gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
-	if (zpool_malloc_support_movable(zpool))
-		gfp |= __GFP_HIGHMEM | __GFP_MOVABLE;
-	alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
-	if (alloc_ret)
-		goto unlock;
-
-	buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
-	memcpy(buf, dst, dlen);
-	zpool_unmap_handle(zpool, handle);
-
-	entry->handle = handle;
-	entry->length = dlen;
+		for (j = 0; j < batch; j++) {
+			errors[j] = crypto_wait_req(errors[j], &acomp_ctx->waits[j]);
+			if (errors[j] && !comp_ret)
+				comp_ret = errors[j];
+		}
+		if (comp_ret)
+			goto unlock;
+
+		for (j = 0; j < batch; j++) {
+			entry = entries[i + j];
+			dlen = acomp_ctx->reqs[j]->dlen;
+
+			zpool = zswap_find_zpool(entry);
+			gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
+			if (zpool_malloc_support_movable(zpool))
+				gfp |= __GFP_HIGHMEM | __GFP_MOVABLE;
+			alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
+			if (alloc_ret)
+				goto unlock;
+
+			buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
+			memcpy(buf, acomp_ctx->buffers[j], dlen);
+			zpool_unmap_handle(zpool, handle);
+
+			entry->handle = handle;
+			entry->length = dlen;
+		}
+	}
 
 unlock:
 	if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
@@ -993,20 +1237,20 @@ static void zswap_decompress(struct zswap_entry *entry, struct page *page)
 	 */
 	if ((acomp_ctx->is_sleepable && !zpool_can_sleep_mapped(zpool)) ||
 	    !virt_addr_valid(src)) {
-		memcpy(acomp_ctx->buffer, src, entry->length);
-		src = acomp_ctx->buffer;
+		memcpy(acomp_ctx->buffers[0], src, entry->length);
+		src = acomp_ctx->buffers[0];
 		zpool_unmap_handle(zpool, entry->handle);
 	}
 
 	sg_init_one(&input, src, entry->length);
 	sg_init_table(&output, 1);
 	sg_set_page(&output, page, PAGE_SIZE, 0);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, PAGE_SIZE);
-	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait));
-	BUG_ON(acomp_ctx->req->dlen != PAGE_SIZE);
+	acomp_request_set_params(acomp_ctx->reqs[0], &input, &output, entry->length, PAGE_SIZE);
+	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->reqs[0]), &acomp_ctx->waits[0]));
+	BUG_ON(acomp_ctx->reqs[0]->dlen != PAGE_SIZE);
 	mutex_unlock(&acomp_ctx->mutex);
 
-	if (src != acomp_ctx->buffer)
+	if (src != acomp_ctx->buffers[0])
 		zpool_unmap_handle(zpool, entry->handle);
 }
 
@@ -1370,17 +1614,105 @@ static void shrink_worker(struct work_struct *w)
 	} while (zswap_total_pages() > thr);
 }
 
+/*
+ * The zswap LRU is in store order, except for the rare entries rotated on
+ * writeback failure. Stop at the first entry that is younger than the
+ * writeback age: everything behind it is even younger.
+ */
+static enum lru_status zswap_age_cb(struct list_head *item, struct list_lru_one *l,
+				    spinlock_t *lock, void *arg)
+{
+	struct zswap_entry *entry = container_of(item, struct zswap_entry, lru);
+	unsigned int max_seq = *(unsigned int *)arg;
+	enum lru_status ret;
+
+	if (max_seq - entry->lru_seq < READ_ONCE(zswap_writeback_age))
+		return LRU_STOP;
+
+	ret = shrink_memcg_cb(item, l, lock, NULL);
+	if (ret == LRU_REMOVED_RETRY)
+		zswap_aged_written_back_pages++;
+	return ret;
+}
+
+static void zswap_age_writeback_memcg(struct mem_cgroup *memcg)
+{
+	int nid;
+
+	if (!mem_cgroup_zswap_writeback_enabled(memcg))
+		return;
+
+	/* see shrink_memcg() */
+	if (memcg && !mem_cgroup_online(memcg))
+		return;
+
+	for_each_node_state(nid, N_NORMAL_MEMORY) {
+		struct lruvec *lruvec = mem_cgroup_lruvec(memcg, NODE_DATA(nid));
+		unsigned long nr_to_walk = ZSWAP_AGE_WRITEBACK_BATCH;
+		unsigned int max_seq = zswap_lruvec_seq(lruvec);
+
+		list_lru_walk_one(&zswap_list_lru, nid, memcg, &zswap_age_cb,
+				  &max_seq, &nr_to_walk);
+	}
+}
+
+/*
+ * Background writer moving entries that aged out to the swap device, so
+ * that the pool has room for hot data by the time memory pressure hits and
+ * the shrinker would have to write back synchronously. Generations only
+ * advance under MGLRU aging, so this does nothing without MGLRU.
+ *
+ * Each round writes back a bounded number of entries per lruvec and is
+ * skipped altogether when there are more runnable tasks than CPUs.
+ */
+static void zswap_age_writeback_worker(struct work_struct *w)
+{
+	struct mem_cgroup *memcg;
+
+	if (!READ_ONCE(zswap_writeback_age) || !lru_gen_enabled())
+		return;
+
+	if (nr_running() < num_online_cpus()) {
+		memcg = mem_cgroup_iter(NULL, NULL, NULL);
+		do {
+			zswap_age_writeback_memcg(memcg);
+			cond_resched();
+		} while ((memcg = mem_cgroup_iter(NULL, memcg, NULL)));
+	}
+
+	queue_delayed_work(shrink_wq, &zswap_age_work,
+			   ZSWAP_AGE_WRITEBACK_INTERVAL);
+}
+
+static int zswap_writeback_age_param_set(const char *val,
+					 const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (ret)
+		return ret;
+
+	/* pre-init setting, the worker is started by zswap_setup() */
+	mutex_lock(&zswap_init_lock);
+	if (zswap_init_state == ZSWAP_INIT_SUCCEED && zswap_writeback_age)
+		mod_delayed_work(shrink_wq, &zswap_age_work, 0);
+	mutex_unlock(&zswap_init_lock);
+
+	return 0;
+}
+
 /*********************************
 * same-filled functions
 **********************************/
-static bool zswap_is_folio_same_filled(struct folio *folio, unsigned long *value)
+static bool zswap_is_page_same_filled(struct folio *folio, long index,
+				      unsigned long *value)
 {
 	unsigned long *page;
 	unsigned long val;
 	unsigned int pos, last_pos = PAGE_SIZE / sizeof(*page) - 1;
 	bool ret = false;
 
-	page = kmap_local_folio(folio, 0);
+	page = kmap_local_folio(folio, index * PAGE_SIZE);
 	val = page[0];
 
 	if (val != page[last_pos])
@@ -1406,25 +1738,165 @@ static void zswap_fill_page(void *ptr, unsigned long value)
 	memset_l(page, value, PAGE_SIZE / sizeof(unsigned long));
 }
 
+/*
+ * Publish @nr entries for consecutive swap offsets starting at @offset in
+ * one locked pass over @tree. Replaced entries are returned in @old, to be
+ * freed by the caller outside of the lock. Returns the number of entries
+ * that were stored, which is less than @nr only if the xarray ran out of
+ * memory; *@err is set in that case.
+ */
+static unsigned int zswap_tree_store_batch(struct xarray *tree, pgoff_t offset,
+					   struct zswap_entry **entries,
+					   struct zswap_entry **old,
+					   unsigned int nr, int *err)
+{
+	XA_STATE(xas, tree, offset);
+	unsigned int i = 0;
+
+	do {
+		xas_lock(&xas);
+		for (; i < nr; i++) {
+			xas_set(&xas, offset + i);
+			old[i] = xas_store(&xas, entries[i]);
+			if (xas_error(&xas))
+				break;
+		}
+		xas_unlock(&xas);
+	} while (xas_nomem(&xas, GFP_KERNEL));
+
+	*err = xas_error(&xas);
+	return i;
+}
+
+/*
+ * Store @nr subpages of @folio starting at subpage @index. Same-filled
+ * subpages are recorded by value, the others are compressed together as
+ * one batch, and all resulting entries are inserted into the tree at
+ * once. @pool and @objcg references are taken for each stored entry.
+ */
+static bool zswap_store_batch(struct folio *folio, long index, unsigned int nr,
+			      struct zswap_pool *pool, struct obj_cgroup *objcg)
+{
+	struct zswap_entry *entries[ZSWAP_MAX_BATCH_SIZE];
+	struct zswap_entry *comp[ZSWAP_MAX_BATCH_SIZE];
+	struct zswap_entry *old[ZSWAP_MAX_BATCH_SIZE];
+	swp_entry_t swp = folio->swap;
+	pgoff_t offset = swp_offset(swp) + index;
+	struct xarray *tree = swap_zswap_tree(swp);
+	unsigned int i, nr_alloc, nr_comp = 0, nr_stored;
+	struct zswap_entry *entry;
+	unsigned long value;
+	int err;
+
+	for (nr_alloc = 0; nr_alloc < nr; nr_alloc++) {
+		entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
+		if (!entry) {
+			zswap_reject_kmemcache_fail++;
+			goto free_entries;
+		}
+		entries[nr_alloc] = entry;
+
+		entry->swpentry = swp_entry(swp_type(swp), offset + nr_alloc);
+		entry->objcg = objcg;
+		entry->length = 0;
+		if (zswap_is_page_same_filled(folio, index + nr_alloc, &value)) {
+			entry->pool = NULL;
+			entry->value = value;
+		} else {
+			entry->pool = pool;
+			comp[nr_comp++] = entry;
+		}
+	}
+
+	if (nr_comp) {
+		if (!pool)
+			goto free_entries;
+		if (!zswap_compress(folio, comp, nr_comp))
+			goto free_entries;
+	}
+
+	nr_stored = zswap_tree_store_batch(tree, offset, entries, old, nr, &err);
+
+	/*
+	 * We finish initializing the entries while they're already in xarray.
+	 * This is safe because:
+	 *
+	 * 1. Concurrent stores and invalidations are excluded by folio lock.
+	 *
+	 * 2. Writeback is excluded by the entries not being on the LRU yet.
+	 *    The publishing order matters to prevent writeback from seeing
+	 *    an incoherent entry.
+	 */
+	for (i = 0; i < nr_stored; i++) {
+		entry = entries[i];
+
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old[i])
+			zswap_entry_free(old[i]);
+
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+		}
+
+		if (entry->length) {
+			percpu_ref_get(&pool->ref);
+			INIT_LIST_HEAD(&entry->lru);
+			zswap_lru_add(&zswap_list_lru, entry);
+		} else {
+			atomic_inc(&zswap_same_filled_pages);
+		}
+		atomic_inc(&zswap_stored_pages);
+	}
+
+	if (objcg)
+		count_objcg_events(objcg, ZSWPOUT, nr_stored);
+	count_vm_events(ZSWPOUT, nr_stored);
+
+	if (nr_stored == nr)
+		return true;
+
+	WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+	zswap_reject_alloc_fail++;
+
+	/* The stored entries are erased by the caller along with the rest */
+	memmove(entries, entries + nr_stored,
+		(nr - nr_stored) * sizeof(*entries));
+	nr_alloc = nr - nr_stored;
+free_entries:
+	for (i = 0; i < nr_alloc; i++) {
+		entry = entries[i];
+		if (entry->length)
+			zpool_free(zswap_find_zpool(entry), entry->handle);
+		zswap_entry_cache_free(entry);
+	}
+	return false;
+}
+
 /*********************************
 * main API
 **********************************/
 bool zswap_store(struct folio *folio)
 {
+	long nr_pages = folio_nr_pages(folio);
 	swp_entry_t swp = folio->swap;
 	pgoff_t offset = swp_offset(swp);
 	struct xarray *tree = swap_zswap_tree(swp);
-	struct zswap_entry *entry, *old;
 	struct obj_cgroup *objcg = NULL;
 	struct mem_cgroup *memcg = NULL;
-	unsigned long value;
+	struct zswap_pool *pool;
+	struct zswap_entry *entry;
+	long index;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
-
-	/* Large folios aren't supported */
-	if (folio_test_large(folio))
-		return false;
+	/* Large folios are naturally aligned in swap and never span trees */
+	VM_WARN_ON_ONCE(swap_zswap_tree(swp_entry(swp_type(swp),
+				offset + nr_pages - 1)) != tree);
 
 	if (!zswap_enabled)
 		goto check_old;
@@ -1443,24 +1915,11 @@ bool zswap_store(struct folio *folio)
 	if (zswap_check_limits())
 		goto reject;
 
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
-	if (!entry) {
-		zswap_reject_kmemcache_fail++;
-		goto reject;
-	}
-
-	if (zswap_is_folio_same_filled(folio, &value)) {
-		entry->length = 0;
-		entry->value = value;
-		atomic_inc(&zswap_same_filled_pages);
-		goto store_entry;
-	}
-
-	/* if entry is successfully added, it keeps the reference */
-	entry->pool = zswap_pool_current_get();
-	if (!entry->pool)
-		goto freepage;
+	/*
+	 * Every compressed entry takes its own pool reference. If there is
+	 * no pool, only same-filled subpages can be stored.
+	 */
+	pool = zswap_pool_objcg_get(objcg);
 
 	if (objcg) {
 		memcg = get_mem_cgroup_from_objcg(objcg);
@@ -1471,66 +1930,22 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	if (!zswap_compress(folio, entry))
-		goto put_pool;
-
-store_entry:
-	entry->swpentry = swp;
-	entry->objcg = objcg;
-
-	old = xa_store(tree, offset, entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
-
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
-		goto store_failed;
-	}
+	for (index = 0; index < nr_pages; index += ZSWAP_MAX_BATCH_SIZE) {
+		unsigned int nr = min_t(long, nr_pages - index,
+					ZSWAP_MAX_BATCH_SIZE);
 
-	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
-	 */
-	if (old)
-		zswap_entry_free(old);
-
-	if (objcg) {
-		obj_cgroup_charge_zswap(objcg, entry->length);
-		count_objcg_event(objcg, ZSWPOUT);
-	}
-
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
+		if (!zswap_store_batch(folio, index, nr, pool, objcg))
+			goto put_pool;
 	}
 
-	/* update stats */
-	atomic_inc(&zswap_stored_pages);
-	count_vm_event(ZSWPOUT);
-
+	if (pool)
+		zswap_pool_put(pool);
+	obj_cgroup_put(objcg);
 	return true;
 
-store_failed:
-	if (!entry->length)
-		atomic_dec(&zswap_same_filled_pages);
-	else {
-		zpool_free(zswap_find_zpool(entry), entry->handle);
 put_pool:
-		zswap_pool_put(entry->pool);
-	}
-freepage:
-	zswap_entry_cache_free(entry);
+	if (pool)
+		zswap_pool_put(pool);
 reject:
 	obj_cgroup_put(objcg);
 	if (zswap_pool_reached_full)
@@ -1538,64 +1953,122 @@ bool zswap_store(struct folio *folio)
 check_old:
 	/*
 	 * If the zswap store fails or zswap is disabled, we must invalidate the
-	 * possibly stale entry which was previously stored at this offset.
+	 * possibly stale entries which were previously stored at the offsets
+	 * of the folio, including those just stored for its first subpages.
 	 * Otherwise, writeback could overwrite the new data in the swapfile.
 	 */
-	entry = xa_erase(tree, offset);
-	if (entry)
-		zswap_entry_free(entry);
+	for (index = 0; index < nr_pages; index++) {
+		entry = xa_erase(tree, offset + index);
+		if (entry)
+			zswap_entry_free(entry);
+	}
 	return false;
 }
 
+/*
+ * Returns how many of the @nr_pages swap entries starting at @swp are held
+ * in zswap. Without SWAP_HAS_CACHE pinned on the range this is only a hint.
+ */
+int zswap_nr_present(swp_entry_t swp, int nr_pages)
+{
+	struct xarray *tree = swap_zswap_tree(swp);
+	pgoff_t offset = swp_offset(swp);
+	int i, nr = 0;
+
+	for (i = 0; i < nr_pages; i++) {
+		if (xa_load(tree, offset + i))
+			nr++;
+	}
+
+	return nr;
+}
+
+/**
+ * zswap_load() - load a folio from zswap
+ * @folio: folio to load
+ *
+ * Return: false if the folio is not in zswap and has to be read from the
+ * swap device; the folio is still locked in that case. true if zswap
+ * handled the read, the folio is then unlocked, and is uptodate unless
+ * it was a large folio only partially held in zswap.
+ */
 bool zswap_load(struct folio *folio)
 {
 	swp_entry_t swp = folio->swap;
 	pgoff_t offset = swp_offset(swp);
-	struct page *page = &folio->page;
 	bool swapcache = folio_test_swapcache(folio);
 	struct xarray *tree = swap_zswap_tree(swp);
+	long i, nr_pages = folio_nr_pages(folio);
 	struct zswap_entry *entry;
+	struct page *page;
 	u8 *dst;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 
 	/*
-	 * When reading into the swapcache, invalidate our entry. The
-	 * swapcache can be the authoritative owner of the page and
-	 * its mappings, and the pressure that results from having two
-	 * in-memory copies outweighs any benefits of caching the
-	 * compression work.
-	 *
-	 * (Most swapins go through the swapcache. The notable
-	 * exception is the singleton fault on SWP_SYNCHRONOUS_IO
-	 * files, which reads into a private page and may free it if
-	 * the fault fails. We remain the primary owner of the entry.)
+	 * Large folios are only swapped in when the swapin path found every
+	 * subpage in zswap or none of them, and it holds SWAP_HAS_CACHE on
+	 * the whole range, so entries can't be written back meanwhile. A
+	 * range that is only partially in zswap can't be completed from the
+	 * device either: fail the read rather than return mixed contents.
 	 */
-	if (swapcache)
-		entry = xa_erase(tree, offset);
-	else
-		entry = xa_load(tree, offset);
+	if (folio_test_large(folio)) {
+		int nr = zswap_nr_present(swp, nr_pages);
+
+		if (!nr)
+			return false;
+		if (WARN_ON_ONCE(nr != nr_pages)) {
+			folio_unlock(folio);
+			return true;
+		}
+	}
 
-	if (!entry)
-		return false;
+	for (i = 0; i < nr_pages; i++) {
+		page = folio_page(folio, i);
 
-	if (entry->length)
-		zswap_decompress(entry, page);
-	else {
-		dst = kmap_local_page(page);
-		zswap_fill_page(dst, entry->value);
-		kunmap_local(dst);
-	}
+		/*
+		 * When reading into the swapcache, invalidate our entry. The
+		 * swapcache can be the authoritative owner of the page and
+		 * its mappings, and the pressure that results from having two
+		 * in-memory copies outweighs any benefits of caching the
+		 * compression work.
+		 *
+		 * (Most swapins go through the swapcache. The notable
+		 * exception is the fault on SWP_SYNCHRONOUS_IO files, which
+		 * reads into a private folio and may free it if the fault
+		 * fails. We remain the primary owner of the entry.)
+		 */
+		if (swapcache)
+			entry = xa_erase(tree, offset + i);
+		else
+			entry = xa_load(tree, offset + i);
 
-	count_vm_event(ZSWPIN);
-	if (entry->objcg)
-		count_objcg_event(entry->objcg, ZSWPIN);
+		if (!entry) {
+			VM_WARN_ON_ONCE(i);
+			return false;
+		}
 
-	if (swapcache) {
-		zswap_entry_free(entry);
-		folio_mark_dirty(folio);
+		if (entry->length)
+			zswap_decompress(entry, page);
+		else {
+			dst = kmap_local_page(page);
+			zswap_fill_page(dst, entry->value);
+			kunmap_local(dst);
+		}
+
+		count_vm_event(ZSWPIN);
+		if (entry->objcg)
+			count_objcg_event(entry->objcg, ZSWPIN);
+
+		if (swapcache)
+			zswap_entry_free(entry);
 	}
 
+	if (swapcache)
+		folio_mark_dirty(folio);
+
+	folio_mark_uptodate(folio);
+	folio_unlock(folio);
 	return true;
 }
 
@@ -1683,6 +2156,8 @@ static int zswap_debugfs_init(void)
 			   zswap_debugfs_root, &zswap_reject_compress_poor);
 	debugfs_create_u64("written_back_pages", 0444,
 			   zswap_debugfs_root, &zswap_written_back_pages);
+	debugfs_create_u64("aged_written_back_pages", 0444,
+			   zswap_debugfs_root, &zswap_aged_written_back_pages);
 	debugfs_create_file("pool_total_size", 0444,
 			    zswap_debugfs_root, NULL, &total_size_fops);
 	debugfs_create_atomic_t("stored_pages", 0444,
@@ -1733,6 +2208,7 @@ static int zswap_setup(void)
 	shrinker_register(zswap_shrinker);
 
 	INIT_WORK(&zswap_shrink_work, shrink_worker);
+	INIT_DELAYED_WORK(&zswap_age_work, zswap_age_writeback_worker);
 
 	pool = __zswap_pool_create_fallback();
 	if (pool) {
@@ -1748,6 +2224,9 @@ static int zswap_setup(void)
 	if (zswap_debugfs_init())
 		pr_warn("debugfs initialization failed\n");
 	zswap_init_state = ZSWAP_INIT_SUCCEED;
+	if (zswap_writeback_age)
+		queue_delayed_work(shrink_wq, &zswap_age_work,
+				   ZSWAP_AGE_WRITEBACK_INTERVAL);
 	return 0;
 
 lru_fail:
@@ -33,6 +33,9 @@ static const struct rhashtable_params br_fdb_rht_params = {
 
 static struct kmem_cache *br_fdb_cache __read_mostly;
 
+/* max entries walked by br_fdb_cleanup() per hash_lock hold */
+#define BR_FDB_CLEANUP_BATCH	64
+
 int __init br_fdb_init(void)
 {
 	br_fdb_cache = KMEM_CACHE(net_bridge_fdb_entry, SLAB_HWCACHE_ALIGN);
@@ -545,6 +548,7 @@ void br_fdb_cleanup(struct work_struct *work)
 	unsigned long delay = hold_time(br);
 	unsigned long work_delay = delay;
 	unsigned long now = jiffies;
+	unsigned int batch = 0;
 
 	/* this part is tricky, in order to avoid blocking learning and
 	 * consequently forwarding, we rely on rcu to delete objects with
@@ -554,6 +558,14 @@ void br_fdb_cleanup(struct work_struct *work)
 	hlist_for_each_entry_rcu(f, &br->fdb_list, fdb_node) {
 		unsigned long this_timer = f->updated + delay;
 
+		/* expired entries are deleted in batches under one lock hold,
+		 * drop it now and then so learning can proceed
+		 */
+		if (batch && ++batch > BR_FDB_CLEANUP_BATCH) {
+			spin_unlock_bh(&br->hash_lock);
+			batch = 0;
+		}
+
 		if (test_bit(BR_FDB_STATIC, &f->flags) ||
 		    test_bit(BR_FDB_ADDED_BY_EXT_LEARN, &f->flags)) {
 			if (test_bit(BR_FDB_NOTIFY, &f->flags)) {
@@ -570,12 +582,16 @@ void br_fdb_cleanup(struct work_struct *work)
 		if (time_after(this_timer, now)) {
 			work_delay = min(work_delay, this_timer - now);
 		} else {
-			spin_lock_bh(&br->hash_lock);
+			if (!batch) {
+				spin_lock_bh(&br->hash_lock);
+				batch = 1;
+			}
 			if (!hlist_unhashed(&f->fdb_node))
 				fdb_delete(br, f, true);
-			spin_unlock_bh(&br->hash_lock);
 		}
 	}
+	if (batch)
+		spin_unlock_bh(&br->hash_lock);
 	rcu_read_unlock();
 
 	/* Cleanup minimum 10 milliseconds apart */
@@ -907,10 +923,8 @@ void br_fdb_update(struct net_bridge *br, struct net_bridge_port *source,
 			unsigned long now = jiffies;
 			bool fdb_modified = false;
 
-			if (now != fdb->updated) {
-				fdb->updated = now;
+			if (br_fdb_ts_refresh(&fdb->updated, now))
 				fdb_modified = __fdb_mark_active(fdb);
-			}
 
 			/* fastpath: update of existing entry */
 			if (unlikely(source != READ_ONCE(fdb->dst) &&
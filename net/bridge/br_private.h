@@ -299,6 +299,20 @@ struct net_bridge_fdb_entry {
 	struct rcu_head			rcu;
 };
 
+/* The fdb timestamps are reported to user space in clock_t units, so
+ * refreshing them more often than that only dirties a cacheline shared
+ * by all CPUs forwarding to or learning from the entry.
+ */
+#define BR_FDB_TS_GRANULARITY	(HZ / USER_HZ)
+
+static inline bool br_fdb_ts_refresh(unsigned long *ts, unsigned long now)
+{
+	if (time_before(now, *ts + BR_FDB_TS_GRANULARITY))
+		return false;
+	*ts = now;
+	return true;
+}
+
 struct net_bridge_fdb_flush_desc {
 	unsigned long			flags;
 	unsigned long			flags_mask;
@@ -346,8 +346,8 @@ static int osdc_show(struct seq_file *s, void *pp)
 	struct rb_node *n;
 
 	down_read(&osdc->lock);
-	seq_printf(s, "REQUESTS %d homeless %d\n",
-		   atomic_read(&osdc->num_requests),
+	seq_printf(s, "REQUESTS %lld homeless %d\n",
+		   percpu_counter_sum(&osdc->num_requests),
 		   atomic_read(&osdc->num_homeless));
 	for (n = rb_first(&osdc->osds); n; n = rb_next(n)) {
 		struct ceph_osd *osd = rb_entry(n, struct ceph_osd, o_node);
@@ -388,11 +388,24 @@ static int client_options_show(struct seq_file *s, void *p)
 	return 0;
 }
 
+static int messenger_show(struct seq_file *s, void *p)
+{
+	struct ceph_client *client = s->private;
+	struct ceph_messenger *msgr = &client->msgr;
+
+	seq_printf(s, "rx_data_bytes %lld\n",
+		   atomic64_read(&msgr->rx_data_bytes));
+	seq_printf(s, "rx_data_batches %lld\n",
+		   atomic64_read(&msgr->rx_data_batches));
+	return 0;
+}
+
 DEFINE_SHOW_ATTRIBUTE(monmap);
 DEFINE_SHOW_ATTRIBUTE(osdmap);
 DEFINE_SHOW_ATTRIBUTE(monc);
 DEFINE_SHOW_ATTRIBUTE(osdc);
 DEFINE_SHOW_ATTRIBUTE(client_options);
+DEFINE_SHOW_ATTRIBUTE(messenger);
 
 void __init ceph_debugfs_init(void)
 {
@@ -444,11 +457,18 @@ void ceph_debugfs_client_init(struct ceph_client *client)
 					client->debugfs_dir,
 					client,
 					&client_options_fops);
+
+	client->debugfs_msgr = debugfs_create_file("messenger",
+					0400,
+					client->debugfs_dir,
+					client,
+					&messenger_fops);
 }
 
 void ceph_debugfs_client_cleanup(struct ceph_client *client)
 {
 	dout("ceph_debugfs_client_cleanup %p\n", client);
+	debugfs_remove(client->debugfs_msgr);
 	debugfs_remove(client->debugfs_options);
 	debugfs_remove(client->debugfs_osdmap);
 	debugfs_remove(client->debugfs_monmap);
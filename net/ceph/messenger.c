@@ -1670,6 +1670,8 @@ void ceph_messenger_init(struct ceph_messenger *msgr,
 			 struct ceph_entity_addr *myaddr)
 {
 	spin_lock_init(&msgr->global_seq_lock);
+	atomic64_set(&msgr->rx_data_bytes, 0);
+	atomic64_set(&msgr->rx_data_batches, 0);
 
 	if (myaddr) {
 		memcpy(&msgr->inst.addr.in_addr, &myaddr->in_addr,
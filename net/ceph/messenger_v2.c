@@ -1857,6 +1857,33 @@ static int prepare_read_control_remainder(struct ceph_connection *con)
 	return 0;
 }
 
+/*
+ * Point in_iter at as many pieces of the destination as fit into
+ * in_data_bvecs, so that a single recvmsg() can fill several pages of
+ * the caller's bio or page vector.  The cursor is advanced past the
+ * whole batch right away, the crc is computed once it has arrived.
+ */
+static void set_in_data_bvecs(struct ceph_connection *con)
+{
+	struct ceph_msg_data_cursor *cursor = &con->v2.in_cursor;
+	size_t len = 0;
+	int i;
+
+	WARN_ON(iov_iter_count(&con->v2.in_iter));
+
+	for (i = 0; i < ARRAY_SIZE(con->v2.in_data_bvecs) &&
+		    cursor->total_resid; i++) {
+		get_bvec_at(cursor, &con->v2.in_data_bvecs[i]);
+		len += con->v2.in_data_bvecs[i].bv_len;
+		ceph_msg_data_advance(cursor, con->v2.in_data_bvecs[i].bv_len);
+	}
+	con->v2.in_data_bvec_cnt = i;
+	iov_iter_bvec(&con->v2.in_iter, ITER_DEST, con->v2.in_data_bvecs, i,
+		      len);
+	atomic64_add(len, &con->msgr->rx_data_bytes);
+	atomic64_inc(&con->msgr->rx_data_batches);
+}
+
 static int prepare_read_data(struct ceph_connection *con)
 {
 	struct bio_vec bv;
@@ -1865,19 +1892,23 @@ static int prepare_read_data(struct ceph_connection *con)
 	ceph_msg_data_cursor_init(&con->v2.in_cursor, con->in_msg,
 				  data_len(con->in_msg));
 
-	get_bvec_at(&con->v2.in_cursor, &bv);
-	if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
-		if (unlikely(!con->bounce_page)) {
-			con->bounce_page = alloc_page(GFP_NOIO);
-			if (!con->bounce_page) {
-				pr_err("failed to allocate bounce page\n");
-				return -ENOMEM;
-			}
-		}
+	if (!ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
+		set_in_data_bvecs(con);
+		con->v2.in_state = IN_S_PREPARE_READ_DATA_CONT;
+		return 0;
+	}
 
-		bv.bv_page = con->bounce_page;
-		bv.bv_offset = 0;
+	if (unlikely(!con->bounce_page)) {
+		con->bounce_page = alloc_page(GFP_NOIO);
+		if (!con->bounce_page) {
+			pr_err("failed to allocate bounce page\n");
+			return -ENOMEM;
+		}
 	}
+
+	get_bvec_at(&con->v2.in_cursor, &bv);
+	bv.bv_page = con->bounce_page;
+	bv.bv_offset = 0;
 	set_in_bvec(con, &bv);
 	con->v2.in_state = IN_S_PREPARE_READ_DATA_CONT;
 	return 0;
@@ -1886,6 +1917,7 @@ static int prepare_read_data(struct ceph_connection *con)
 static void prepare_read_data_cont(struct ceph_connection *con)
 {
 	struct bio_vec bv;
+	int i;
 
 	if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
 		con->in_data_crc = crc32c(con->in_data_crc,
@@ -1896,23 +1928,30 @@ static void prepare_read_data_cont(struct ceph_connection *con)
 		memcpy_to_page(bv.bv_page, bv.bv_offset,
 			       page_address(con->bounce_page),
 			       con->v2.in_bvec.bv_len);
-	} else {
-		con->in_data_crc = ceph_crc32c_page(con->in_data_crc,
-						    con->v2.in_bvec.bv_page,
-						    con->v2.in_bvec.bv_offset,
-						    con->v2.in_bvec.bv_len);
-	}
 
-	ceph_msg_data_advance(&con->v2.in_cursor, con->v2.in_bvec.bv_len);
-	if (con->v2.in_cursor.total_resid) {
-		get_bvec_at(&con->v2.in_cursor, &bv);
-		if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
+		ceph_msg_data_advance(&con->v2.in_cursor,
+				      con->v2.in_bvec.bv_len);
+		if (con->v2.in_cursor.total_resid) {
+			get_bvec_at(&con->v2.in_cursor, &bv);
 			bv.bv_page = con->bounce_page;
 			bv.bv_offset = 0;
+			set_in_bvec(con, &bv);
+			WARN_ON(con->v2.in_state != IN_S_PREPARE_READ_DATA_CONT);
+			return;
+		}
+	} else {
+		for (i = 0; i < con->v2.in_data_bvec_cnt; i++)
+			con->in_data_crc = ceph_crc32c_page(con->in_data_crc,
+					con->v2.in_data_bvecs[i].bv_page,
+					con->v2.in_data_bvecs[i].bv_offset,
+					con->v2.in_data_bvecs[i].bv_len);
+		con->v2.in_data_bvec_cnt = 0;
+
+		if (con->v2.in_cursor.total_resid) {
+			set_in_data_bvecs(con);
+			WARN_ON(con->v2.in_state != IN_S_PREPARE_READ_DATA_CONT);
+			return;
 		}
-		set_in_bvec(con, &bv);
-		WARN_ON(con->v2.in_state != IN_S_PREPARE_READ_DATA_CONT);
-		return;
 	}
 
 	/*
@@ -3684,6 +3723,19 @@ static void revoke_at_prepare_read_data_cont(struct ceph_connection *con)
 	WARN_ON(!data_len(con->in_msg));
 	WARN_ON(!iov_iter_is_bvec(&con->v2.in_iter));
 	resid = iov_iter_count(&con->v2.in_iter);
+	if (!ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
+		/* the cursor is already past the whole batch */
+		remaining = con->v2.in_cursor.total_resid +
+			    CEPH_EPILOGUE_PLAIN_LEN;
+		dout("%s con %p resid %d remaining %d\n", __func__, con,
+		     resid, remaining);
+		con->v2.in_data_bvec_cnt = 0;
+		con->v2.in_iter.count -= resid;
+		set_in_skip(con, resid + remaining);
+		con->v2.in_state = IN_S_FINISH_SKIP;
+		return;
+	}
+
 	WARN_ON(!resid || resid > con->v2.in_bvec.bv_len);
 	recved = con->v2.in_bvec.bv_len - resid;
 	dout("%s con %p recved %d resid %d\n", __func__, con, recved, resid);
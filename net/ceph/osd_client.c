@@ -2494,7 +2494,7 @@ static void account_request(struct ceph_osd_request *req)
 	WARN_ON(!(req->r_flags & (CEPH_OSD_FLAG_READ | CEPH_OSD_FLAG_WRITE)));
 
 	req->r_flags |= CEPH_OSD_FLAG_ONDISK;
-	atomic_inc(&req->r_osdc->num_requests);
+	percpu_counter_inc(&req->r_osdc->num_requests);
 
 	req->r_start_stamp = jiffies;
 	req->r_start_latency = ktime_get();
@@ -2520,7 +2520,7 @@ static void finish_request(struct ceph_osd_request *req)
 		ceph_init_sparse_read(&req->r_osd->o_sparse_read);
 		unlink_request(req->r_osd, req);
 	}
-	atomic_dec(&osdc->num_requests);
+	percpu_counter_dec(&osdc->num_requests);
 
 	/*
 	 * If an OSD has failed or returned and a request has been sent
@@ -5264,10 +5264,14 @@ int ceph_osdc_init(struct ceph_osd_client *osdc, struct ceph_client *client)
 	INIT_DELAYED_WORK(&osdc->timeout_work, handle_timeout);
 	INIT_DELAYED_WORK(&osdc->osds_timeout_work, handle_osds_timeout);
 
+	err = percpu_counter_init(&osdc->num_requests, 0, GFP_KERNEL);
+	if (err)
+		goto out;
+
 	err = -ENOMEM;
 	osdc->osdmap = ceph_osdmap_alloc();
 	if (!osdc->osdmap)
-		goto out;
+		goto out_counter;
 
 	osdc->req_mempool = mempool_create_slab_pool(10,
 						     ceph_osd_request_cache);
@@ -5310,6 +5314,8 @@ int ceph_osdc_init(struct ceph_osd_client *osdc, struct ceph_client *client)
 	mempool_destroy(osdc->req_mempool);
 out_map:
 	ceph_osdmap_destroy(osdc->osdmap);
+out_counter:
+	percpu_counter_destroy(&osdc->num_requests);
 out:
 	return err;
 }
@@ -5335,13 +5341,14 @@ void ceph_osdc_stop(struct ceph_osd_client *osdc)
 	WARN_ON(!RB_EMPTY_ROOT(&osdc->linger_requests));
 	WARN_ON(!RB_EMPTY_ROOT(&osdc->map_checks));
 	WARN_ON(!RB_EMPTY_ROOT(&osdc->linger_map_checks));
-	WARN_ON(atomic_read(&osdc->num_requests));
+	WARN_ON(percpu_counter_sum(&osdc->num_requests));
 	WARN_ON(atomic_read(&osdc->num_homeless));
 
 	ceph_osdmap_destroy(osdc->osdmap);
 	mempool_destroy(osdc->req_mempool);
 	ceph_msgpool_destroy(&osdc->msgpool_op);
 	ceph_msgpool_destroy(&osdc->msgpool_op_reply);
+	percpu_counter_destroy(&osdc->num_requests);
 }
 
 int osd_req_op_copy_from_init(struct ceph_osd_request *req,
@@ -3,6 +3,7 @@
 #include <linux/ceph/ceph_debug.h>
 
 #include <linux/module.h>
+#include <linux/seqlock.h>
 #include <linux/slab.h>
 
 #include <linux/ceph/libceph.h>
@@ -778,9 +779,61 @@ u64 ceph_pg_pool_flags(struct ceph_osdmap *map, u64 id)
 }
 EXPORT_SYMBOL(ceph_pg_pool_flags);
 
+/*
+ * Cache of CRUSH + upmap + temp results for a pool.  Mapping a PG is
+ * done under osdc->lock held for read by any number of submitters, so
+ * each slot is protected by a seqcount for readers and ->lock for the
+ * (rare) writers.  The osdmap epoch is part of the key: incremental
+ * maps are applied in place, and every change to anything the mapping
+ * depends on comes with a new epoch.
+ */
+#define CEPH_PG_ACTING_CACHE_OSDS	8
+#define CEPH_PG_ACTING_CACHE_MAX_SLOTS	4096
+
+struct ceph_pg_acting_cache_slot {
+	seqcount_t seq;
+	u32 epoch;  /* 0 = empty */
+	u32 seed;
+	int up_primary;
+	int acting_primary;
+	u8 up_size;
+	u8 acting_size;
+	int up[CEPH_PG_ACTING_CACHE_OSDS];
+	int acting[CEPH_PG_ACTING_CACHE_OSDS];
+};
+
+struct ceph_pg_acting_cache {
+	spinlock_t lock;
+	u32 mask;
+	struct ceph_pg_acting_cache_slot slots[];
+};
+
+static void pg_acting_cache_resize(struct ceph_pg_pool_info *pi)
+{
+	struct ceph_pg_acting_cache *cache = pi->acting_cache;
+	u32 nr_slots, i;
+
+	nr_slots = min_t(u32, roundup_pow_of_two(max(pi->pg_num, 1U)),
+			 CEPH_PG_ACTING_CACHE_MAX_SLOTS);
+	if (cache && cache->mask + 1 == nr_slots)
+		return;
+
+	kvfree(cache);
+	/* the cache is optional, map without it if this fails */
+	cache = kvzalloc(struct_size(cache, slots, nr_slots), GFP_NOFS);
+	if (cache) {
+		spin_lock_init(&cache->lock);
+		cache->mask = nr_slots - 1;
+		for (i = 0; i < nr_slots; i++)
+			seqcount_init(&cache->slots[i].seq);
+	}
+	pi->acting_cache = cache;
+}
+
 static void __remove_pg_pool(struct rb_root *root, struct ceph_pg_pool_info *pi)
 {
 	erase_pg_pool(root, pi);
+	kvfree(pi->acting_cache);
 	kfree(pi->name);
 	kfree(pi);
 }
@@ -1367,6 +1420,8 @@ static int __decode_pools(void **p, void *end, struct ceph_osdmap *map,
 		ret = decode_pool(p, end, pi);
 		if (ret)
 			return ret;
+
+		pg_acting_cache_resize(pi);
 	}
 
 	return 0;
@@ -2806,6 +2861,79 @@ static void get_temp_osds(struct ceph_osdmap *osdmap,
 		temp->primary = pg->primary_temp.osd;
 }
 
+/*
+ * The result only depends on the folded PG if the placement seed does,
+ * which is the case when pgp_num == pg_num (i.e. outside of a PG
+ * merge/split in progress).
+ */
+static struct ceph_pg_acting_cache_slot *
+pg_acting_cache_slot(struct ceph_pg_pool_info *pi, const struct ceph_pg *pgid)
+{
+	struct ceph_pg_acting_cache *cache = pi->acting_cache;
+
+	if (!cache || pi->pgp_num != pi->pg_num)
+		return NULL;
+	return &cache->slots[pgid->seed & cache->mask];
+}
+
+static bool pg_acting_cache_lookup(struct ceph_osdmap *osdmap,
+				   struct ceph_pg_pool_info *pi,
+				   const struct ceph_pg *pgid,
+				   struct ceph_osds *up,
+				   struct ceph_osds *acting)
+{
+	struct ceph_pg_acting_cache_slot *slot = pg_acting_cache_slot(pi, pgid);
+	unsigned int seq;
+	bool hit;
+
+	if (!slot)
+		return false;
+
+	do {
+		seq = read_seqcount_begin(&slot->seq);
+		hit = slot->epoch == osdmap->epoch && slot->seed == pgid->seed;
+		if (!hit)
+			continue;
+
+		up->size = slot->up_size;
+		up->primary = slot->up_primary;
+		memcpy(up->osds, slot->up, slot->up_size * sizeof(up->osds[0]));
+		acting->size = slot->acting_size;
+		acting->primary = slot->acting_primary;
+		memcpy(acting->osds, slot->acting,
+		       slot->acting_size * sizeof(acting->osds[0]));
+	} while (read_seqcount_retry(&slot->seq, seq));
+
+	return hit;
+}
+
+static void pg_acting_cache_store(struct ceph_osdmap *osdmap,
+				  struct ceph_pg_pool_info *pi,
+				  const struct ceph_pg *pgid,
+				  const struct ceph_osds *up,
+				  const struct ceph_osds *acting)
+{
+	struct ceph_pg_acting_cache_slot *slot = pg_acting_cache_slot(pi, pgid);
+
+	if (!slot || up->size > CEPH_PG_ACTING_CACHE_OSDS ||
+	    acting->size > CEPH_PG_ACTING_CACHE_OSDS)
+		return;
+
+	spin_lock(&pi->acting_cache->lock);
+	write_seqcount_begin(&slot->seq);
+	slot->epoch = osdmap->epoch;
+	slot->seed = pgid->seed;
+	slot->up_size = up->size;
+	slot->up_primary = up->primary;
+	memcpy(slot->up, up->osds, up->size * sizeof(up->osds[0]));
+	slot->acting_size = acting->size;
+	slot->acting_primary = acting->primary;
+	memcpy(slot->acting, acting->osds,
+	       acting->size * sizeof(acting->osds[0]));
+	write_seqcount_end(&slot->seq);
+	spin_unlock(&pi->acting_cache->lock);
+}
+
 /*
  * Map a PG to its acting set as well as its up set.
  *
@@ -2825,6 +2953,9 @@ void ceph_pg_to_up_acting_osds(struct ceph_osdmap *osdmap,
 	WARN_ON(pi->id != raw_pgid->pool);
 	raw_pg_to_pg(pi, raw_pgid, &pgid);
 
+	if (pg_acting_cache_lookup(osdmap, pi, &pgid, up, acting))
+		return;
+
 	pg_to_raw_osds(osdmap, pi, raw_pgid, up, &pps);
 	apply_upmap(osdmap, &pgid, up);
 	raw_to_up_osds(osdmap, pi, up);
@@ -2837,6 +2968,8 @@ void ceph_pg_to_up_acting_osds(struct ceph_osdmap *osdmap,
 			acting->primary = up->primary;
 	}
 	WARN_ON(!osds_valid(up) || !osds_valid(acting));
+
+	pg_acting_cache_store(osdmap, pi, &pgid, up, acting);
 }
 
 bool ceph_pg_to_primary_shard(struct ceph_osdmap *osdmap,
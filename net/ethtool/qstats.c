@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <net/netdev_queues.h>
+
+#include "netlink.h"
+#include "common.h"
+
+struct qstats_req_info {
+	struct ethnl_req_info		base;
+};
+
+struct qstats_reply_data {
+	struct ethnl_reply_data		base;
+	unsigned int			n_rx;
+	unsigned int			n_tx;
+	struct netdev_queue_stats_rx	*rx;
+	struct netdev_queue_stats_tx	*tx;
+};
+
+#define QSTATS_REPDATA(__reply_base) \
+	container_of(__reply_base, struct qstats_reply_data, base)
+
+const struct nla_policy ethnl_qstats_get_policy[] = {
+	[ETHTOOL_A_QSTATS_HEADER] = NLA_POLICY_NESTED(ethnl_header_policy),
+};
+
+static int qstats_prepare_data(const struct ethnl_req_info *req_base,
+			       struct ethnl_reply_data *reply_base,
+			       const struct genl_info *info)
+{
+	struct qstats_reply_data *data = QSTATS_REPDATA(reply_base);
+	struct net_device *dev = reply_base->dev;
+	const struct netdev_stat_ops *ops = dev->stat_ops;
+	unsigned int i;
+	int ret;
+
+	/* the packed attributes are the queue stats structs as u64 arrays */
+	BUILD_BUG_ON(sizeof(struct netdev_queue_stats_rx) !=
+		     __ETHTOOL_QSTATS_RX_CNT * sizeof(u64));
+	BUILD_BUG_ON(sizeof(struct netdev_queue_stats_tx) !=
+		     __ETHTOOL_QSTATS_TX_CNT * sizeof(u64));
+
+	if (!ops)
+		return -EOPNOTSUPP;
+
+	ret = ethnl_ops_begin(dev);
+	if (ret < 0)
+		return ret;
+
+	if (ops->get_queue_stats_rx) {
+		data->n_rx = dev->real_num_rx_queues;
+		data->rx = kvmalloc_array(data->n_rx, sizeof(*data->rx),
+					  GFP_KERNEL);
+		if (!data->rx) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		/* see ETHTOOL_STAT_NOT_SET, drivers only fill what they have */
+		memset(data->rx, 0xff, data->n_rx * sizeof(*data->rx));
+		for (i = 0; i < data->n_rx; i++)
+			ops->get_queue_stats_rx(dev, i, &data->rx[i]);
+	}
+	if (ops->get_queue_stats_tx) {
+		data->n_tx = dev->real_num_tx_queues;
+		data->tx = kvmalloc_array(data->n_tx, sizeof(*data->tx),
+					  GFP_KERNEL);
+		if (!data->tx) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		memset(data->tx, 0xff, data->n_tx * sizeof(*data->tx));
+		for (i = 0; i < data->n_tx; i++)
+			ops->get_queue_stats_tx(dev, i, &data->tx[i]);
+	}
+out:
+	ethnl_ops_complete(dev);
+	return ret;
+}
+
+static int qstats_reply_size(const struct ethnl_req_info *req_base,
+			     const struct ethnl_reply_data *reply_base)
+{
+	const struct qstats_reply_data *data = QSTATS_REPDATA(reply_base);
+	int len = 0;
+
+	if (data->rx)
+		len += nla_total_size(sizeof(u32)) + /* _QSTATS_RX_QUEUES */
+		       data->n_rx * nla_total_size(sizeof(*data->rx));
+	if (data->tx)
+		len += nla_total_size(sizeof(u32)) + /* _QSTATS_TX_QUEUES */
+		       data->n_tx * nla_total_size(sizeof(*data->tx));
+
+	return len;
+}
+
+static int qstats_fill_reply(struct sk_buff *skb,
+			     const struct ethnl_req_info *req_base,
+			     const struct ethnl_reply_data *reply_base)
+{
+	const struct qstats_reply_data *data = QSTATS_REPDATA(reply_base);
+	unsigned int i;
+
+	if (data->rx) {
+		if (nla_put_u32(skb, ETHTOOL_A_QSTATS_RX_QUEUES, data->n_rx))
+			return -EMSGSIZE;
+		for (i = 0; i < data->n_rx; i++)
+			if (nla_put(skb, ETHTOOL_A_QSTATS_RX,
+				    sizeof(data->rx[i]), &data->rx[i]))
+				return -EMSGSIZE;
+	}
+	if (data->tx) {
+		if (nla_put_u32(skb, ETHTOOL_A_QSTATS_TX_QUEUES, data->n_tx))
+			return -EMSGSIZE;
+		for (i = 0; i < data->n_tx; i++)
+			if (nla_put(skb, ETHTOOL_A_QSTATS_TX,
+				    sizeof(data->tx[i]), &data->tx[i]))
+				return -EMSGSIZE;
+	}
+
+	return 0;
+}
+
+static void qstats_cleanup_data(struct ethnl_reply_data *reply_base)
+{
+	struct qstats_reply_data *data = QSTATS_REPDATA(reply_base);
+
+	kvfree(data->rx);
+	kvfree(data->tx);
+}
+
+const struct ethnl_request_ops ethnl_qstats_request_ops = {
+	.request_cmd		= ETHTOOL_MSG_QSTATS_GET,
+	.reply_cmd		= ETHTOOL_MSG_QSTATS_GET_REPLY,
+	.hdr_attr		= ETHTOOL_A_QSTATS_HEADER,
+	.req_info_size		= sizeof(struct qstats_req_info),
+	.reply_data_size	= sizeof(struct qstats_reply_data),
+
+	.prepare_data		= qstats_prepare_data,
+	.reply_size		= qstats_reply_size,
+	.fill_reply		= qstats_fill_reply,
+	.cleanup_data		= qstats_cleanup_data,
+};
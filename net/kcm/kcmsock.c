@@ -188,7 +188,8 @@ static void kcm_rfree(struct sk_buff *skb)
 	}
 }
 
-static int kcm_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
+static int __kcm_queue_rcv_skb(struct sock *sk, struct sk_buff *skb,
+			       bool wake)
 {
 	struct sk_buff_head *list = &sk->sk_receive_queue;
 
@@ -208,12 +209,17 @@ static int kcm_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
 
 	skb_queue_tail(list, skb);
 
-	if (!sock_flag(sk, SOCK_DEAD))
+	if (wake && !sock_flag(sk, SOCK_DEAD))
 		sk->sk_data_ready(sk);
 
 	return 0;
 }
 
+static int kcm_queue_rcv_skb(struct sock *sk, struct sk_buff *skb)
+{
+	return __kcm_queue_rcv_skb(sk, skb, true);
+}
+
 /* Requeue received messages for a kcm socket to other kcm sockets. This is
  * called with a kcm socket is receive disabled.
  * RX mux lock held.
@@ -312,6 +318,15 @@ static void unreserve_rx_kcm(struct kcm_psock *psock,
 	if (!kcm)
 		return;
 
+	/* Wake up the reader once for all messages queued to it during this
+	 * strparser batch, see kcm_rcv_strparser().
+	 */
+	if (psock->rx_need_wake) {
+		psock->rx_need_wake = false;
+		if (!sock_flag(&kcm->sk, SOCK_DEAD))
+			kcm->sk.sk_data_ready(&kcm->sk);
+	}
+
 	spin_lock_bh(&mux->rx_lock);
 
 	psock->rx_kcm = NULL;
@@ -376,11 +391,16 @@ static void kcm_rcv_strparser(struct strparser *strp, struct sk_buff *skb)
 		return;
 	}
 
-	if (kcm_queue_rcv_skb(&kcm->sk, skb)) {
+	/* The reserved KCM stays ours until the end of the read_sock batch,
+	 * so defer its wakeup to unreserve_rx_kcm() rather than waking the
+	 * reader for every small message.
+	 */
+	if (__kcm_queue_rcv_skb(&kcm->sk, skb, false)) {
 		/* Should mean socket buffer full */
 		unreserve_rx_kcm(psock, false);
 		goto try_queue;
 	}
+	psock->rx_need_wake = true;
 }
 
 static int kcm_parse_func_strparser(struct strparser *strp, struct sk_buff *skb)
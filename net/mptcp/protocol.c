@@ -1403,8 +1403,12 @@ bool mptcp_subflow_active(struct mptcp_subflow_context *subflow)
 /* implement the mptcp packet scheduler;
  * returns the subflow that will transmit the next DSS
  * additionally updates the rtx timeout
+ *
+ * With @lowlat the half srtt of each subflow is added to its linger time,
+ * picking the subflow where the next byte is expected to arrive first.
  */
-struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+static struct sock *__mptcp_subflow_get_send(struct mptcp_sock *msk,
+					     bool lowlat)
 {
 	struct subflow_send_info send_info[SSK_MODE_MAX];
 	struct mptcp_subflow_context *subflow;
@@ -1439,6 +1443,9 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 		}
 
 		linger_time = div_u64((u64)READ_ONCE(ssk->sk_wmem_queued) << 32, pace);
+		if (lowlat)
+			linger_time += div_u64((u64)(READ_ONCE(tcp_sk(ssk)->srtt_us) >> 4) << 32,
+					       USEC_PER_SEC);
 		if (linger_time < send_info[subflow->backup].linger_time) {
 			send_info[subflow->backup].ssk = ssk;
 			send_info[subflow->backup].linger_time = linger_time;
@@ -1478,6 +1485,16 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 	return ssk;
 }
 
+struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+{
+	return __mptcp_subflow_get_send(msk, false);
+}
+
+struct sock *mptcp_subflow_get_send_lowlat(struct mptcp_sock *msk)
+{
+	return __mptcp_subflow_get_send(msk, true);
+}
+
 static void mptcp_push_release(struct sock *ssk, struct mptcp_sendmsg_info *info)
 {
 	tcp_push(ssk, 0, info->mss_now, tcp_sk(ssk)->nonagle, info->size_goal);
@@ -36,6 +36,60 @@ static struct mptcp_sched_ops mptcp_sched_default = {
 	.owner		= THIS_MODULE,
 };
 
+/* Like the default scheduler, but also accounts for the path delay */
+static int mptcp_sched_lowlat_get_subflow(struct mptcp_sock *msk,
+					  struct mptcp_sched_data *data)
+{
+	struct sock *ssk;
+
+	ssk = data->reinject ? mptcp_subflow_get_retrans(msk) :
+			       mptcp_subflow_get_send_lowlat(msk);
+	if (!ssk)
+		return -EINVAL;
+
+	mptcp_subflow_set_scheduled(mptcp_subflow_ctx(ssk), true);
+	return 0;
+}
+
+static struct mptcp_sched_ops mptcp_sched_lowlat = {
+	.get_subflow	= mptcp_sched_lowlat_get_subflow,
+	.name		= "lowlat",
+	.owner		= THIS_MODULE,
+};
+
+/* New data goes to the lowest latency subflow, reinjections are sent on
+ * every active subflow, so that the tail of a transfer does not depend
+ * on the subflow that lost it.
+ */
+static int mptcp_sched_redundant_get_subflow(struct mptcp_sock *msk,
+					     struct mptcp_sched_data *data)
+{
+	bool scheduled = false;
+	int i;
+
+	if (!data->reinject)
+		return mptcp_sched_lowlat_get_subflow(msk, data);
+
+	for (i = 0; i < data->subflows; i++) {
+		struct mptcp_subflow_context *subflow = data->contexts[i];
+
+		if (!mptcp_subflow_active(subflow) ||
+		    !sk_stream_memory_free(mptcp_subflow_tcp_sock(subflow)))
+			continue;
+
+		mptcp_subflow_set_scheduled(subflow, true);
+		scheduled = true;
+	}
+
+	return scheduled ? 0 : mptcp_sched_lowlat_get_subflow(msk, data);
+}
+
+static struct mptcp_sched_ops mptcp_sched_redundant = {
+	.get_subflow	= mptcp_sched_redundant_get_subflow,
+	.name		= "redundant",
+	.owner		= THIS_MODULE,
+};
+
 /* Must be called with rcu read lock held */
 struct mptcp_sched_ops *mptcp_sched_find(const char *name)
 {
@@ -103,6 +157,8 @@ void mptcp_unregister_scheduler(struct mptcp_sched_ops *sched)
 void mptcp_sched_init(void)
 {
 	mptcp_register_scheduler(&mptcp_sched_default);
+	mptcp_register_scheduler(&mptcp_sched_lowlat);
+	mptcp_register_scheduler(&mptcp_sched_redundant);
 }
 
 int mptcp_init_sched(struct mptcp_sock *msk,
@@ -143,6 +199,22 @@ void mptcp_subflow_set_scheduled(struct mptcp_subflow_context *subflow,
 	WRITE_ONCE(subflow->scheduled, scheduled);
 }
 
+static void mptcp_sched_data_set_contexts(const struct mptcp_sock *msk,
+					  struct mptcp_sched_data *data)
+{
+	struct mptcp_subflow_context *subflow;
+	int i = 0;
+
+	mptcp_for_each_subflow(msk, subflow) {
+		if (i == MPTCP_SUBFLOWS_MAX) {
+			pr_warn_once("too many subflows");
+			break;
+		}
+		data->contexts[i++] = subflow;
+	}
+	data->subflows = i;
+}
+
 int mptcp_sched_get_send(struct mptcp_sock *msk)
 {
 	struct mptcp_subflow_context *subflow;
@@ -169,6 +241,7 @@ int mptcp_sched_get_send(struct mptcp_sock *msk)
 	data.reinject = false;
 	if (msk->sched == &mptcp_sched_default || !msk->sched)
 		return mptcp_sched_default_get_subflow(msk, &data);
+	mptcp_sched_data_set_contexts(msk, &data);
 	return msk->sched->get_subflow(msk, &data);
 }
 
@@ -191,5 +264,6 @@ int mptcp_sched_get_retrans(struct mptcp_sock *msk)
 	data.reinject = true;
 	if (msk->sched == &mptcp_sched_default || !msk->sched)
 		return mptcp_sched_default_get_subflow(msk, &data);
+	mptcp_sched_data_set_contexts(msk, &data);
 	return msk->sched->get_subflow(msk, &data);
 }
@@ -7,6 +7,7 @@
 #include <linux/rcupdate.h>
 #include <linux/rcupdate_wait.h>
 #include <linux/jhash.h>
+#include <linux/prefetch.h>
 #include <linux/types.h>
 #include <linux/netfilter/nfnetlink.h>
 #include <linux/netfilter/ipset/ip_set.h>
@@ -1168,6 +1169,8 @@ mtype_test_cidrs(struct ip_set *set, struct mtype_elem *d,
 	struct mtype_elem orig = *d;
 	int ret, i, j = 0, k;
 #else
+	u8 cidr, next_cidr = U8_MAX;
+	u32 next_key = 0;
 	int ret, i, j = 0;
 #endif
 	u32 key, multi = 0;
@@ -1181,16 +1184,28 @@ mtype_test_cidrs(struct ip_set *set, struct mtype_elem *d,
 		     k++) {
 			mtype_data_netmask(d, NCIDR_GET(h->nets[k].cidr[1]),
 					   true);
+		key = HKEY(d, h->initval, t->htable_bits);
 #else
-		mtype_data_netmask(d, NCIDR_GET(h->nets[j].cidr[0]));
+		cidr = NCIDR_GET(h->nets[j].cidr[0]);
+		mtype_data_netmask(d, cidr);
+		key = cidr == next_cidr ? next_key :
+					  HKEY(d, h->initval, t->htable_bits);
+		/* Large sets miss the cache on every bucket: start loading the
+		 * bucket of the next prefix while this one is compared.
+		 */
+		if (j + 1 < NLEN && h->nets[j + 1].cidr[0]) {
+			struct mtype_elem next = *d;
+
+			next_cidr = NCIDR_GET(h->nets[j + 1].cidr[0]);
+			mtype_data_netmask(&next, next_cidr);
+			next_key = HKEY(&next, h->initval, t->htable_bits);
+			prefetch(&hbucket(t, next_key));
+		}
 #endif
-		key = HKEY(d, h->initval, t->htable_bits);
 		n = rcu_dereference_bh(hbucket(t, key));
 		if (!n)
 			continue;
-		for (i = 0; i < n->pos; i++) {
-			if (!test_bit(i, n->used))
-				continue;
+		for_each_set_bit(i, n->used, n->pos) {
 			data = ahash_data(n, i, set->dsize);
 			if (!mtype_data_equal(data, d, &multi))
 				continue;
@@ -1244,9 +1259,7 @@ mtype_test(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 		ret = 0;
 		goto out;
 	}
-	for (i = 0; i < n->pos; i++) {
-		if (!test_bit(i, n->used))
-			continue;
+	for_each_set_bit(i, n->used, n->pos) {
 		data = ahash_data(n, i, set->dsize);
 		if (!mtype_data_equal(data, d, &multi))
 			continue;
@@ -32,6 +32,7 @@
 #include <linux/jhash.h>
 #include <linux/random.h>
 #include <linux/rcupdate_wait.h>
+#include <linux/seqlock.h>
 
 #include <net/net_namespace.h>
 #include <net/ip_vs.h>
@@ -41,21 +42,45 @@
 #define CONFIG_IP_VS_TAB_BITS	12
 #endif
 
+static int ip_vs_conn_tab_set_bits(const char *val,
+				   const struct kernel_param *kp);
+
+static const struct kernel_param_ops ip_vs_conn_tab_bits_ops = {
+	.set = ip_vs_conn_tab_set_bits,
+	.get = param_get_int,
+};
+
 /*
- * Connection hash size. Default is what was selected at compile time.
+ * Connection hash size. Default is what was selected at compile time,
+ * writing the parameter at runtime resizes the table.
 */
 static int ip_vs_conn_tab_bits = CONFIG_IP_VS_TAB_BITS;
-module_param_named(conn_tab_bits, ip_vs_conn_tab_bits, int, 0444);
+module_param_cb(conn_tab_bits, &ip_vs_conn_tab_bits_ops,
+		&ip_vs_conn_tab_bits, 0644);
 MODULE_PARM_DESC(conn_tab_bits, "Set connections' hash size");
 
-/* size and mask values */
+/* current size and limits for resizing */
 int ip_vs_conn_tab_size __read_mostly;
-static int ip_vs_conn_tab_mask __read_mostly;
+static int ip_vs_conn_tab_min_bits __read_mostly;
+static int ip_vs_conn_tab_max_bits __read_mostly;
 
 /*
  *  Connection hash table: for input and output packets lookups of IPVS
+ *
+ *  While the table is resized, new_tbl points to the table its entries
+ *  are being moved to.  New entries are only added to the last table
+ *  and lookups walk all of them.
  */
-static struct hlist_head *ip_vs_conn_tab __read_mostly;
+struct ip_vs_conn_htable {
+	struct ip_vs_conn_htable __rcu	*new_tbl;
+	unsigned int			mask;
+	struct hlist_head		buckets[];
+};
+
+static struct ip_vs_conn_htable __rcu *ip_vs_conn_tab __read_mostly;
+
+/* Serializes resizing against the table walkers, which drop RCU on the way */
+static DEFINE_MUTEX(ip_vs_conn_tab_mutex);
 
 /*  SLAB cache for IPVS connections */
 static struct kmem_cache *ip_vs_conn_cachep __read_mostly;
@@ -67,7 +92,9 @@ static atomic_t ip_vs_conn_no_cport_cnt = ATOMIC_INIT(0);
 static unsigned int ip_vs_conn_rnd __read_mostly;
 
 /*
- *  Fine locking granularity for big connection hash table
+ *  Fine locking granularity for big connection hash table.  The lock
+ *  is selected by the low bits of the hash, the table is never smaller
+ *  than the lock array, so one lock covers a bucket in any table size.
  */
 #define CT_LOCKARRAY_BITS  5
 #define CT_LOCKARRAY_SIZE  (1<<CT_LOCKARRAY_BITS)
@@ -82,7 +109,9 @@ static unsigned int ip_vs_conn_rnd __read_mostly;
 
 struct ip_vs_aligned_lock
 {
-	spinlock_t	l;
+	spinlock_t		l;
+	/* bumped while the resizer moves the buckets this lock covers */
+	seqcount_spinlock_t	seq;
 } __attribute__((__aligned__(SMP_CACHE_BYTES)));
 
 /* lock array for conn table */
@@ -99,6 +128,46 @@ static inline void ct_write_unlock_bh(unsigned int key)
 	spin_unlock_bh(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].l);
 }
 
+static inline unsigned int ct_read_seqbegin(unsigned int key)
+{
+	return read_seqcount_begin(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].seq);
+}
+
+static inline bool ct_read_seqretry(unsigned int key, unsigned int seq)
+{
+	return read_seqcount_retry(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].seq,
+				   seq);
+}
+
+static inline struct hlist_head *
+ip_vs_conn_bucket(struct ip_vs_conn_htable *t, unsigned int hash)
+{
+	return &t->buckets[hash & t->mask];
+}
+
+/* Walk the tables a lookup for 'hash' has to search, under RCU */
+#define ip_vs_conn_for_each_table(t)					\
+	for (t = rcu_dereference(ip_vs_conn_tab); t;			\
+	     t = rcu_dereference(t->new_tbl))
+
+/* Table new entries are added to, called under the lock for the entry */
+static struct ip_vs_conn_htable *ip_vs_conn_tab_last(void)
+{
+	struct ip_vs_conn_htable *t, *next;
+
+	t = rcu_dereference_bh(ip_vs_conn_tab);
+	while ((next = rcu_dereference_bh(t->new_tbl)))
+		t = next;
+	return t;
+}
+
+/* The single table seen by walkers holding ip_vs_conn_tab_mutex */
+static inline struct ip_vs_conn_htable *ip_vs_conn_tab_locked(void)
+{
+	return rcu_dereference_protected(ip_vs_conn_tab,
+					 lockdep_is_held(&ip_vs_conn_tab_mutex));
+}
+
 static void ip_vs_conn_expire(struct timer_list *t);
 
 /*
@@ -112,11 +181,11 @@ static unsigned int ip_vs_conn_hashkey(struct netns_ipvs *ipvs, int af, unsigned
 	if (af == AF_INET6)
 		return (jhash_3words(jhash(addr, 16, ip_vs_conn_rnd),
 				    (__force u32)port, proto, ip_vs_conn_rnd) ^
-			((size_t)ipvs>>8)) & ip_vs_conn_tab_mask;
+			((size_t)ipvs>>8));
 #endif
 	return (jhash_3words((__force u32)addr->ip, (__force u32)port, proto,
 			    ip_vs_conn_rnd) ^
-		((size_t)ipvs>>8)) & ip_vs_conn_tab_mask;
+		((size_t)ipvs>>8));
 }
 
 static unsigned int ip_vs_conn_hashkey_param(const struct ip_vs_conn_param *p,
@@ -126,8 +195,7 @@ static unsigned int ip_vs_conn_hashkey_param(const struct ip_vs_conn_param *p,
 	__be16 port;
 
 	if (p->pe_data && p->pe->hashkey_raw)
-		return p->pe->hashkey_raw(p, ip_vs_conn_rnd, inverse) &
-			ip_vs_conn_tab_mask;
+		return p->pe->hashkey_raw(p, ip_vs_conn_rnd, inverse);
 
 	if (likely(!inverse)) {
 		addr = p->caddr;
@@ -177,7 +245,8 @@ static inline int ip_vs_conn_hash(struct ip_vs_conn *cp)
 	if (!(cp->flags & IP_VS_CONN_F_HASHED)) {
 		cp->flags |= IP_VS_CONN_F_HASHED;
 		refcount_inc(&cp->refcnt);
-		hlist_add_head_rcu(&cp->c_list, &ip_vs_conn_tab[hash]);
+		hlist_add_head_rcu(&cp->c_list,
+				   ip_vs_conn_bucket(ip_vs_conn_tab_last(), hash));
 		ret = 1;
 	} else {
 		pr_err("%s(): request for already hashed, called from %pS\n",
@@ -262,28 +331,35 @@ static inline bool ip_vs_conn_unlink(struct ip_vs_conn *cp)
 static inline struct ip_vs_conn *
 __ip_vs_conn_in_get(const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
+	struct ip_vs_conn_htable *t;
+	unsigned int hash, seq;
 	struct ip_vs_conn *cp;
 
 	hash = ip_vs_conn_hashkey_param(p, false);
 
 	rcu_read_lock();
 
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
-		if (p->cport == cp->cport && p->vport == cp->vport &&
-		    cp->af == p->af &&
-		    ip_vs_addr_equal(p->af, p->caddr, &cp->caddr) &&
-		    ip_vs_addr_equal(p->af, p->vaddr, &cp->vaddr) &&
-		    ((!p->cport) ^ (!(cp->flags & IP_VS_CONN_F_NO_CPORT))) &&
-		    p->protocol == cp->protocol &&
-		    cp->ipvs == p->ipvs) {
-			if (!__ip_vs_conn_get(cp))
-				continue;
-			/* HIT */
-			rcu_read_unlock();
-			return cp;
+retry:
+	seq = ct_read_seqbegin(hash);
+	ip_vs_conn_for_each_table(t) {
+		hlist_for_each_entry_rcu(cp, ip_vs_conn_bucket(t, hash), c_list) {
+			if (p->cport == cp->cport && p->vport == cp->vport &&
+			    cp->af == p->af &&
+			    ip_vs_addr_equal(p->af, p->caddr, &cp->caddr) &&
+			    ip_vs_addr_equal(p->af, p->vaddr, &cp->vaddr) &&
+			    ((!p->cport) ^ (!(cp->flags & IP_VS_CONN_F_NO_CPORT))) &&
+			    p->protocol == cp->protocol &&
+			    cp->ipvs == p->ipvs) {
+				if (!__ip_vs_conn_get(cp))
+					continue;
+				/* HIT */
+				rcu_read_unlock();
+				return cp;
+			}
 		}
 	}
+	if (ct_read_seqretry(hash, seq))
+		goto retry;
 
 	rcu_read_unlock();
 
@@ -348,38 +424,45 @@ EXPORT_SYMBOL_GPL(ip_vs_conn_in_get_proto);
 /* Get reference to connection template */
 struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
+	struct ip_vs_conn_htable *t;
+	unsigned int hash, seq;
 	struct ip_vs_conn *cp;
 
 	hash = ip_vs_conn_hashkey_param(p, false);
 
 	rcu_read_lock();
 
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
-		if (unlikely(p->pe_data && p->pe->ct_match)) {
-			if (cp->ipvs != p->ipvs)
+retry:
+	seq = ct_read_seqbegin(hash);
+	ip_vs_conn_for_each_table(t) {
+		hlist_for_each_entry_rcu(cp, ip_vs_conn_bucket(t, hash), c_list) {
+			if (unlikely(p->pe_data && p->pe->ct_match)) {
+				if (cp->ipvs != p->ipvs)
+					continue;
+				if (p->pe == cp->pe && p->pe->ct_match(p, cp)) {
+					if (__ip_vs_conn_get(cp))
+						goto out;
+				}
 				continue;
-			if (p->pe == cp->pe && p->pe->ct_match(p, cp)) {
+			}
+
+			if (cp->af == p->af &&
+			    ip_vs_addr_equal(p->af, p->caddr, &cp->caddr) &&
+			    /* protocol should only be IPPROTO_IP if
+			     * p->vaddr is a fwmark */
+			    ip_vs_addr_equal(p->protocol == IPPROTO_IP ? AF_UNSPEC :
+					     p->af, p->vaddr, &cp->vaddr) &&
+			    p->vport == cp->vport && p->cport == cp->cport &&
+			    cp->flags & IP_VS_CONN_F_TEMPLATE &&
+			    p->protocol == cp->protocol &&
+			    cp->ipvs == p->ipvs) {
 				if (__ip_vs_conn_get(cp))
 					goto out;
 			}
-			continue;
-		}
-
-		if (cp->af == p->af &&
-		    ip_vs_addr_equal(p->af, p->caddr, &cp->caddr) &&
-		    /* protocol should only be IPPROTO_IP if
-		     * p->vaddr is a fwmark */
-		    ip_vs_addr_equal(p->protocol == IPPROTO_IP ? AF_UNSPEC :
-				     p->af, p->vaddr, &cp->vaddr) &&
-		    p->vport == cp->vport && p->cport == cp->cport &&
-		    cp->flags & IP_VS_CONN_F_TEMPLATE &&
-		    p->protocol == cp->protocol &&
-		    cp->ipvs == p->ipvs) {
-			if (__ip_vs_conn_get(cp))
-				goto out;
 		}
 	}
+	if (ct_read_seqretry(hash, seq))
+		goto retry;
 	cp = NULL;
 
   out:
@@ -400,9 +483,10 @@ struct ip_vs_conn *ip_vs_ct_in_get(const struct ip_vs_conn_param *p)
  *	p->vaddr, p->vport: pkt dest address (foreign host) */
 struct ip_vs_conn *ip_vs_conn_out_get(const struct ip_vs_conn_param *p)
 {
-	unsigned int hash;
 	struct ip_vs_conn *cp, *ret=NULL;
 	const union nf_inet_addr *saddr;
+	struct ip_vs_conn_htable *t;
+	unsigned int hash, seq;
 	__be16 sport;
 
 	/*
@@ -412,31 +496,38 @@ struct ip_vs_conn *ip_vs_conn_out_get(const struct ip_vs_conn_param *p)
 
 	rcu_read_lock();
 
-	hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
-		if (p->vport != cp->cport)
-			continue;
+retry:
+	seq = ct_read_seqbegin(hash);
+	ip_vs_conn_for_each_table(t) {
+		hlist_for_each_entry_rcu(cp, ip_vs_conn_bucket(t, hash), c_list) {
+			if (p->vport != cp->cport)
+				continue;
 
-		if (IP_VS_FWD_METHOD(cp) != IP_VS_CONN_F_MASQ) {
-			sport = cp->vport;
-			saddr = &cp->vaddr;
-		} else {
-			sport = cp->dport;
-			saddr = &cp->daddr;
-		}
+			if (IP_VS_FWD_METHOD(cp) != IP_VS_CONN_F_MASQ) {
+				sport = cp->vport;
+				saddr = &cp->vaddr;
+			} else {
+				sport = cp->dport;
+				saddr = &cp->daddr;
+			}
 
-		if (p->cport == sport && cp->af == p->af &&
-		    ip_vs_addr_equal(p->af, p->vaddr, &cp->caddr) &&
-		    ip_vs_addr_equal(p->af, p->caddr, saddr) &&
-		    p->protocol == cp->protocol &&
-		    cp->ipvs == p->ipvs) {
-			if (!__ip_vs_conn_get(cp))
-				continue;
-			/* HIT */
-			ret = cp;
-			break;
+			if (p->cport == sport && cp->af == p->af &&
+			    ip_vs_addr_equal(p->af, p->vaddr, &cp->caddr) &&
+			    ip_vs_addr_equal(p->af, p->caddr, saddr) &&
+			    p->protocol == cp->protocol &&
+			    cp->ipvs == p->ipvs) {
+				if (!__ip_vs_conn_get(cp))
+					continue;
+				/* HIT */
+				ret = cp;
+				goto out;
+			}
 		}
 	}
+	if (ct_read_seqretry(hash, seq))
+		goto retry;
 
+out:
 	rcu_read_unlock();
 
 	IP_VS_DBG_BUF(9, "lookup/out %s %s:%d->%s:%d %s\n",
@@ -1046,22 +1137,24 @@ ip_vs_conn_new(const struct ip_vs_conn_param *p, int dest_af,
 #ifdef CONFIG_PROC_FS
 struct ip_vs_iter_state {
 	struct seq_net_private	p;
-	struct hlist_head	*l;
+	struct ip_vs_conn_htable *t;
+	unsigned int		idx;
 };
 
 static void *ip_vs_conn_array(struct seq_file *seq, loff_t pos)
 {
-	int idx;
+	unsigned int idx;
 	struct ip_vs_conn *cp;
 	struct ip_vs_iter_state *iter = seq->private;
+	struct ip_vs_conn_htable *t = iter->t;
 
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+	for (idx = 0; idx <= t->mask; idx++) {
+		hlist_for_each_entry_rcu(cp, &t->buckets[idx], c_list) {
 			/* __ip_vs_conn_get() is not needed by
 			 * ip_vs_conn_seq_show and ip_vs_conn_sync_seq_show
 			 */
 			if (pos-- == 0) {
-				iter->l = &ip_vs_conn_tab[idx];
+				iter->idx = idx;
 				return cp;
 			}
 		}
@@ -1076,7 +1169,8 @@ static void *ip_vs_conn_seq_start(struct seq_file *seq, loff_t *pos)
 {
 	struct ip_vs_iter_state *iter = seq->private;
 
-	iter->l = NULL;
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	iter->t = ip_vs_conn_tab_locked();
 	rcu_read_lock();
 	return *pos ? ip_vs_conn_array(seq, *pos - 1) :SEQ_START_TOKEN;
 }
@@ -1085,9 +1179,9 @@ static void *ip_vs_conn_seq_next(struct seq_file *seq, void *v, loff_t *pos)
 {
 	struct ip_vs_conn *cp = v;
 	struct ip_vs_iter_state *iter = seq->private;
+	struct ip_vs_conn_htable *t = iter->t;
 	struct hlist_node *e;
-	struct hlist_head *l = iter->l;
-	int idx;
+	unsigned int idx;
 
 	++*pos;
 	if (v == SEQ_START_TOKEN)
@@ -1098,15 +1192,15 @@ static void *ip_vs_conn_seq_next(struct seq_file *seq, void *v, loff_t *pos)
 	if (e)
 		return hlist_entry(e, struct ip_vs_conn, c_list);
 
-	idx = l - ip_vs_conn_tab;
-	while (++idx < ip_vs_conn_tab_size) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
-			iter->l = &ip_vs_conn_tab[idx];
+	idx = iter->idx;
+	while (++idx <= t->mask) {
+		hlist_for_each_entry_rcu(cp, &t->buckets[idx], c_list) {
+			iter->idx = idx;
 			return cp;
 		}
 		cond_resched_rcu();
 	}
-	iter->l = NULL;
+	iter->idx = idx;
 	return NULL;
 }
 
@@ -1114,6 +1208,7 @@ static void ip_vs_conn_seq_stop(struct seq_file *seq, void *v)
 	__releases(RCU)
 {
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 }
 
 static int ip_vs_conn_seq_show(struct seq_file *seq, void *v)
@@ -1300,17 +1395,20 @@ static inline bool ip_vs_conn_ops_mode(struct ip_vs_conn *cp)
 /* Called from keventd and must protect itself from softirqs */
 void ip_vs_random_dropentry(struct netns_ipvs *ipvs)
 {
-	int idx;
+	struct ip_vs_conn_htable *t;
 	struct ip_vs_conn *cp;
+	unsigned int idx;
 
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_locked();
 	rcu_read_lock();
 	/*
 	 * Randomly scan 1/32 of the whole table every second
 	 */
-	for (idx = 0; idx < (ip_vs_conn_tab_size>>5); idx++) {
-		unsigned int hash = get_random_u32() & ip_vs_conn_tab_mask;
+	for (idx = 0; idx < ((t->mask + 1) >> 5); idx++) {
+		unsigned int hash = get_random_u32();
 
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[hash], c_list) {
+		hlist_for_each_entry_rcu(cp, ip_vs_conn_bucket(t, hash), c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 			if (atomic_read(&cp->n_control))
@@ -1362,6 +1460,7 @@ void ip_vs_random_dropentry(struct netns_ipvs *ipvs)
 		cond_resched_rcu();
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 }
 
 
@@ -1370,14 +1469,17 @@ void ip_vs_random_dropentry(struct netns_ipvs *ipvs)
  */
 static void ip_vs_conn_flush(struct netns_ipvs *ipvs)
 {
-	int idx;
+	struct ip_vs_conn_htable *t;
 	struct ip_vs_conn *cp, *cp_c;
+	unsigned int idx;
 
 flush_again:
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_locked();
 	rcu_read_lock();
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
+	for (idx = 0; idx <= t->mask; idx++) {
 
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+		hlist_for_each_entry_rcu(cp, &t->buckets[idx], c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 			if (atomic_read(&cp->n_control))
@@ -1393,6 +1495,7 @@ static void ip_vs_conn_flush(struct netns_ipvs *ipvs)
 		cond_resched_rcu();
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
 
 	/* the counter may be not NULL, because maybe some conn entries
 	   are run by slow timer handler or unhashed but still referred */
@@ -1405,13 +1508,16 @@ static void ip_vs_conn_flush(struct netns_ipvs *ipvs)
 #ifdef CONFIG_SYSCTL
 void ip_vs_expire_nodest_conn_flush(struct netns_ipvs *ipvs)
 {
-	int idx;
+	struct ip_vs_conn_htable *t;
 	struct ip_vs_conn *cp, *cp_c;
 	struct ip_vs_dest *dest;
+	unsigned int idx;
 
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_locked();
 	rcu_read_lock();
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++) {
-		hlist_for_each_entry_rcu(cp, &ip_vs_conn_tab[idx], c_list) {
+	for (idx = 0; idx <= t->mask; idx++) {
+		hlist_for_each_entry_rcu(cp, &t->buckets[idx], c_list) {
 			if (cp->ipvs != ipvs)
 				continue;
 
@@ -1437,9 +1543,135 @@ void ip_vs_expire_nodest_conn_flush(struct netns_ipvs *ipvs)
 			break;
 	}
 	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+}
+#endif
+
+#ifdef CONFIG_PROC_FS
+/* Chain length summary for /proc/net/ip_vs_stats */
+void ip_vs_conn_tab_stats_show(struct seq_file *seq)
+{
+	unsigned int idx, len, used = 0, max_len = 0, entries = 0;
+	struct ip_vs_conn_htable *t;
+	struct ip_vs_conn *cp;
+	unsigned int size;
+
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_locked();
+	size = t->mask + 1;
+	rcu_read_lock();
+	for (idx = 0; idx <= t->mask; idx++) {
+		len = 0;
+		hlist_for_each_entry_rcu(cp, &t->buckets[idx], c_list)
+			len++;
+		if (len)
+			used++;
+		max_len = max(max_len, len);
+		entries += len;
+		cond_resched_rcu();
+	}
+	rcu_read_unlock();
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+
+	seq_puts(seq, "
+ Buckets     Used  Entries MaxChain
+");
+	seq_printf(seq, "%8X %8X %8X %8X\n", size, used, entries, max_len);
 }
 #endif
 
+static struct ip_vs_conn_htable *ip_vs_conn_htable_alloc(int bits)
+{
+	struct ip_vs_conn_htable *t;
+	unsigned int idx;
+
+	t = kvmalloc(struct_size(t, buckets, 1U << bits), GFP_KERNEL);
+	if (!t)
+		return NULL;
+
+	RCU_INIT_POINTER(t->new_tbl, NULL);
+	t->mask = (1U << bits) - 1;
+	for (idx = 0; idx <= t->mask; idx++)
+		INIT_HLIST_HEAD(&t->buckets[idx]);
+	return t;
+}
+
+/* Move all connections to a table of 2^bits buckets.  Packets keep being
+ * served meanwhile: new connections go to the new table, lookups search
+ * both tables and retry if the bucket they walked was being moved.
+ */
+static int ip_vs_conn_tab_resize(int bits)
+{
+	struct ip_vs_conn_htable *old, *new;
+	struct ip_vs_aligned_lock *lock;
+	struct hlist_node *next;
+	struct ip_vs_conn *cp;
+	unsigned int idx;
+
+	lockdep_assert_held(&ip_vs_conn_tab_mutex);
+
+	old = ip_vs_conn_tab_locked();
+	if (old->mask + 1 == 1U << bits)
+		return 0;
+
+	new = ip_vs_conn_htable_alloc(bits);
+	if (!new)
+		return -ENOMEM;
+
+	/* From now on ip_vs_conn_hash() adds to the new table */
+	rcu_assign_pointer(old->new_tbl, new);
+
+	for (idx = 0; idx <= old->mask; idx++) {
+		lock = &__ip_vs_conntbl_lock_array[idx & CT_LOCKARRAY_MASK];
+
+		ct_write_lock_bh(idx);
+		write_seqcount_begin(&lock->seq);
+		hlist_for_each_entry_safe(cp, next, &old->buckets[idx], c_list) {
+			hlist_del_rcu(&cp->c_list);
+			hlist_add_head_rcu(&cp->c_list,
+					   ip_vs_conn_bucket(new,
+						ip_vs_conn_hashkey_conn(cp)));
+		}
+		write_seqcount_end(&lock->seq);
+		ct_write_unlock_bh(idx);
+		cond_resched();
+	}
+
+	rcu_assign_pointer(ip_vs_conn_tab, new);
+	WRITE_ONCE(ip_vs_conn_tab_size, new->mask + 1);
+	synchronize_rcu();
+	kvfree(old);
+
+	pr_info("Connection hash table resized (size=%d)\n",
+		ip_vs_conn_tab_size);
+	return 0;
+}
+
+static int ip_vs_conn_tab_set_bits(const char *val,
+				   const struct kernel_param *kp)
+{
+	int bits, ret;
+
+	ret = kstrtoint(val, 0, &bits);
+	if (ret)
+		return ret;
+
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	/* Not set up yet: ip_vs_conn_init() picks the value up */
+	if (!rcu_access_pointer(ip_vs_conn_tab)) {
+		ip_vs_conn_tab_bits = bits;
+		goto out;
+	}
+
+	bits = clamp(bits, ip_vs_conn_tab_min_bits, ip_vs_conn_tab_max_bits);
+	ret = ip_vs_conn_tab_resize(bits);
+	if (!ret)
+		ip_vs_conn_tab_bits = bits;
+out:
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+	return ret;
+}
+
 /*
  * per netns init and exit
  */
@@ -1481,6 +1713,7 @@ void __net_exit ip_vs_conn_net_cleanup(struct netns_ipvs *ipvs)
 
 int __init ip_vs_conn_init(void)
 {
+	struct ip_vs_conn_htable *t;
 	size_t tab_array_size;
 	int max_avail;
 #if BITS_PER_LONG > 32
@@ -1496,24 +1729,30 @@ int __init ip_vs_conn_init(void)
 	max_avail -= 1;		/* IPVS up to 1/2 of mem */
 	max_avail -= order_base_2(sizeof(struct ip_vs_conn));
 	max = clamp(max, min, max_avail);
+
+	BUILD_BUG_ON((1 << 8) < CT_LOCKARRAY_SIZE);
+
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	ip_vs_conn_tab_min_bits = min;
+	ip_vs_conn_tab_max_bits = max;
 	ip_vs_conn_tab_bits = clamp_val(ip_vs_conn_tab_bits, min, max);
 	ip_vs_conn_tab_size = 1 << ip_vs_conn_tab_bits;
-	ip_vs_conn_tab_mask = ip_vs_conn_tab_size - 1;
 
 	/*
 	 * Allocate the connection hash table and initialize its list heads
 	 */
-	tab_array_size = array_size(ip_vs_conn_tab_size,
-				    sizeof(*ip_vs_conn_tab));
-	ip_vs_conn_tab = kvmalloc_array(ip_vs_conn_tab_size,
-					sizeof(*ip_vs_conn_tab), GFP_KERNEL);
-	if (!ip_vs_conn_tab)
+	tab_array_size = struct_size(t, buckets, ip_vs_conn_tab_size);
+	t = ip_vs_conn_htable_alloc(ip_vs_conn_tab_bits);
+	if (!t) {
+		mutex_unlock(&ip_vs_conn_tab_mutex);
 		return -ENOMEM;
+	}
 
 	/* Allocate ip_vs_conn slab cache */
 	ip_vs_conn_cachep = KMEM_CACHE(ip_vs_conn, SLAB_HWCACHE_ALIGN);
 	if (!ip_vs_conn_cachep) {
-		kvfree(ip_vs_conn_tab);
+		mutex_unlock(&ip_vs_conn_tab_mutex);
+		kvfree(t);
 		return -ENOMEM;
 	}
 
@@ -1522,24 +1761,33 @@ int __init ip_vs_conn_init(void)
 	IP_VS_DBG(0, "Each connection entry needs %zd bytes at least\n",
 		  sizeof(struct ip_vs_conn));
 
-	for (idx = 0; idx < ip_vs_conn_tab_size; idx++)
-		INIT_HLIST_HEAD(&ip_vs_conn_tab[idx]);
-
 	for (idx = 0; idx < CT_LOCKARRAY_SIZE; idx++)  {
 		spin_lock_init(&__ip_vs_conntbl_lock_array[idx].l);
+		seqcount_spinlock_init(&__ip_vs_conntbl_lock_array[idx].seq,
+				       &__ip_vs_conntbl_lock_array[idx].l);
 	}
 
 	/* calculate the random value for connection hash */
 	get_random_bytes(&ip_vs_conn_rnd, sizeof(ip_vs_conn_rnd));
 
+	rcu_assign_pointer(ip_vs_conn_tab, t);
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+
 	return 0;
 }
 
 void ip_vs_conn_cleanup(void)
 {
+	struct ip_vs_conn_htable *t;
+
 	/* Wait all ip_vs_conn_rcu_free() callbacks to complete */
 	rcu_barrier();
 	/* Release the empty cache */
 	kmem_cache_destroy(ip_vs_conn_cachep);
-	kvfree(ip_vs_conn_tab);
+
+	mutex_lock(&ip_vs_conn_tab_mutex);
+	t = ip_vs_conn_tab_locked();
+	RCU_INIT_POINTER(ip_vs_conn_tab, NULL);
+	mutex_unlock(&ip_vs_conn_tab_mutex);
+	kvfree(t);
 }
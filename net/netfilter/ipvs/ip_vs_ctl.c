@@ -2507,6 +2507,10 @@ static int ip_vs_stats_show(struct seq_file *seq, void *v)
 		   (unsigned long long)show.inbps,
 		   (unsigned long long)show.outbps);
 
+	/* the table is shared by all netns, only show it to the initial one */
+	if (net_eq(net, &init_net))
+		ip_vs_conn_tab_stats_show(seq);
+
 	return 0;
 }
 
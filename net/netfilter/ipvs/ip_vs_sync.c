@@ -392,14 +392,14 @@ get_curr_sync_buff(struct netns_ipvs *ipvs, struct ipvs_master_sync_state *ms,
 {
 	struct ip_vs_sync_buff *sb;
 
-	spin_lock_bh(&ipvs->sync_buff_lock);
+	spin_lock_bh(&ms->sync_buff_lock);
 	sb = ms->sync_buff;
 	if (sb && time_after_eq(jiffies - sb->firstuse, time)) {
 		ms->sync_buff = NULL;
 		__set_current_state(TASK_RUNNING);
 	} else
 		sb = NULL;
-	spin_unlock_bh(&ipvs->sync_buff_lock);
+	spin_unlock_bh(&ms->sync_buff_lock);
 	return sb;
 }
 
@@ -409,6 +409,32 @@ select_master_thread_id(struct netns_ipvs *ipvs, struct ip_vs_conn *cp)
 	return ((long) cp >> (1 + ilog2(sizeof(*cp)))) & ipvs->threads_mask;
 }
 
+/*
+ * Lock the sync buffer of the master thread serving @cp.  Connections
+ * handled by different threads are encoded in parallel, the master state
+ * is kept alive by the BH disabled section, see stop_sync_thread().
+ */
+static struct ipvs_master_sync_state *
+ip_vs_sync_buff_lock(struct netns_ipvs *ipvs, struct ip_vs_conn *cp)
+{
+	struct ipvs_master_sync_state *ms;
+
+	local_bh_disable();
+	/* pairs with smp_wmb() in start_sync_thread() */
+	if (!(smp_load_acquire(&ipvs->sync_state) & IP_VS_STATE_MASTER)) {
+		local_bh_enable();
+		return NULL;
+	}
+	ms = &ipvs->ms[select_master_thread_id(ipvs, cp)];
+	spin_lock(&ms->sync_buff_lock);
+	return ms;
+}
+
+static void ip_vs_sync_buff_unlock(struct ipvs_master_sync_state *ms)
+{
+	spin_unlock_bh(&ms->sync_buff_lock);
+}
+
 /*
  * Create a new sync buffer for Version 0 proto.
  */
@@ -544,7 +570,6 @@ static void ip_vs_sync_conn_v0(struct netns_ipvs *ipvs, struct ip_vs_conn *cp,
 	struct ip_vs_sync_conn_v0 *s;
 	struct ip_vs_sync_buff *buff;
 	struct ipvs_master_sync_state *ms;
-	int id;
 	unsigned int len;
 
 	if (unlikely(cp->af != AF_INET))
@@ -556,14 +581,10 @@ static void ip_vs_sync_conn_v0(struct netns_ipvs *ipvs, struct ip_vs_conn *cp,
 	if (!ip_vs_sync_conn_needed(ipvs, cp, pkts))
 		return;
 
-	spin_lock_bh(&ipvs->sync_buff_lock);
-	if (!(ipvs->sync_state & IP_VS_STATE_MASTER)) {
-		spin_unlock_bh(&ipvs->sync_buff_lock);
+	ms = ip_vs_sync_buff_lock(ipvs, cp);
+	if (!ms)
 		return;
-	}
 
-	id = select_master_thread_id(ipvs, cp);
-	ms = &ipvs->ms[id];
 	buff = ms->sync_buff;
 	len = (cp->flags & IP_VS_CONN_F_SEQ_MASK) ? FULL_CONN_SIZE :
 		SIMPLE_CONN_SIZE;
@@ -579,7 +600,7 @@ static void ip_vs_sync_conn_v0(struct netns_ipvs *ipvs, struct ip_vs_conn *cp,
 	if (!buff) {
 		buff = ip_vs_sync_buff_create_v0(ipvs, len);
 		if (!buff) {
-			spin_unlock_bh(&ipvs->sync_buff_lock);
+			ip_vs_sync_buff_unlock(ms);
 			pr_err("ip_vs_sync_buff_create failed.\n");
 			return;
 		}
@@ -609,7 +630,7 @@ static void ip_vs_sync_conn_v0(struct netns_ipvs *ipvs, struct ip_vs_conn *cp,
 	m->nr_conns++;
 	m->size = htons(ntohs(m->size) + len);
 	buff->head += len;
-	spin_unlock_bh(&ipvs->sync_buff_lock);
+	ip_vs_sync_buff_unlock(ms);
 
 	/* synchronize its controller if it has */
 	cp = cp->control;
@@ -633,7 +654,6 @@ void ip_vs_sync_conn(struct netns_ipvs *ipvs, struct ip_vs_conn *cp, int pkts)
 	union ip_vs_sync_conn *s;
 	struct ip_vs_sync_buff *buff;
 	struct ipvs_master_sync_state *ms;
-	int id;
 	__u8 *p;
 	unsigned int len, pe_name_len, pad;
 
@@ -659,14 +679,9 @@ void ip_vs_sync_conn(struct netns_ipvs *ipvs, struct ip_vs_conn *cp, int pkts)
 		pe_name_len = strnlen(cp->pe->name, IP_VS_PENAME_MAXLEN);
 	}
 
-	spin_lock_bh(&ipvs->sync_buff_lock);
-	if (!(ipvs->sync_state & IP_VS_STATE_MASTER)) {
-		spin_unlock_bh(&ipvs->sync_buff_lock);
+	ms = ip_vs_sync_buff_lock(ipvs, cp);
+	if (!ms)
 		return;
-	}
-
-	id = select_master_thread_id(ipvs, cp);
-	ms = &ipvs->ms[id];
 
 #ifdef CONFIG_IP_VS_IPV6
 	if (cp->af == AF_INET6)
@@ -701,7 +716,7 @@ void ip_vs_sync_conn(struct netns_ipvs *ipvs, struct ip_vs_conn *cp, int pkts)
 	if (!buff) {
 		buff = ip_vs_sync_buff_create(ipvs, len);
 		if (!buff) {
-			spin_unlock_bh(&ipvs->sync_buff_lock);
+			ip_vs_sync_buff_unlock(ms);
 			pr_err("ip_vs_sync_buff_create failed.\n");
 			return;
 		}
@@ -768,7 +783,7 @@ void ip_vs_sync_conn(struct netns_ipvs *ipvs, struct ip_vs_conn *cp, int pkts)
 		}
 	}
 
-	spin_unlock_bh(&ipvs->sync_buff_lock);
+	ip_vs_sync_buff_unlock(ms);
 
 control:
 	/* synchronize its controller if it has */
@@ -1729,6 +1744,7 @@ static int sync_thread_backup(void *data)
 			}
 
 			ip_vs_process_message(ipvs, tinfo->buf, len);
+			cond_resched();
 		}
 	}
 
@@ -1834,6 +1850,7 @@ int start_sync_thread(struct netns_ipvs *ipvs, struct ipvs_sync_daemon_cfg *c,
 		ms = ipvs->ms;
 		for (id = 0; id < count; id++, ms++) {
 			INIT_LIST_HEAD(&ms->sync_queue);
+			spin_lock_init(&ms->sync_buff_lock);
 			ms->sync_queue_len = 0;
 			ms->sync_queue_delay = 0;
 			INIT_DELAYED_WORK(&ms->master_wakeup_work,
@@ -1879,6 +1896,8 @@ int start_sync_thread(struct netns_ipvs *ipvs, struct ipvs_sync_daemon_cfg *c,
 		ipvs->master_tinfo = ti;
 	else
 		ipvs->backup_tinfo = ti;
+	/* publish ipvs->ms before the state, see ip_vs_sync_buff_lock() */
+	smp_wmb();
 	spin_lock_bh(&ipvs->sync_buff_lock);
 	ipvs->sync_state |= state;
 	spin_unlock_bh(&ipvs->sync_buff_lock);
@@ -1957,6 +1976,9 @@ int stop_sync_thread(struct netns_ipvs *ipvs, int state)
 		spin_unlock(&ipvs->sync_lock);
 		spin_unlock_bh(&ipvs->sync_buff_lock);
 
+		/* Wait for ip_vs_sync_buff_lock() users that saw the old state */
+		synchronize_rcu();
+
 		retc = 0;
 		for (id = ipvs->threads_mask; id >= 0; id--) {
 			struct ipvs_master_sync_state *ms = &ipvs->ms[id];
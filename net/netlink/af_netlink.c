@@ -1718,6 +1718,11 @@ static int netlink_setsockopt(struct socket *sock, int level, int optname,
 	case NETLINK_GET_STRICT_CHK:
 		nr = NETLINK_F_STRICT_CHK;
 		break;
+	case NETLINK_DUMP_BUF_SIZE:
+		if (val > NETLINK_DUMP_BUF_MAX)
+			return -EINVAL;
+		WRITE_ONCE(nlk->dump_buf_size, val);
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -1785,6 +1790,15 @@ static int netlink_getsockopt(struct socket *sock, int level, int optname,
 	case NETLINK_GET_STRICT_CHK:
 		flag = NETLINK_F_STRICT_CHK;
 		break;
+	case NETLINK_DUMP_BUF_SIZE:
+		if (len < sizeof(int))
+			return -EINVAL;
+		len = sizeof(int);
+		val = READ_ONCE(nlk->dump_buf_size);
+		if (put_user(len, optlen) ||
+		    copy_to_user(optval, &val, len))
+			return -EFAULT;
+		return 0;
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -2270,6 +2284,7 @@ static int netlink_dump(struct sock *sk, bool lock_taken)
 	size_t max_recvmsg_len;
 	struct module *module;
 	int err = -ENOBUFS;
+	u32 dump_buf_size;
 	int alloc_min_size;
 	int alloc_size;
 
@@ -2291,8 +2306,17 @@ static int netlink_dump(struct sock *sk, bool lock_taken)
 	cb = &nlk->cb;
 	alloc_min_size = max_t(int, cb->min_dump_alloc, NLMSG_GOODSIZE);
 
+	/* Sockets which opted in with NETLINK_DUMP_BUF_SIZE get one large,
+	 * possibly vmalloc'ed, skb per round instead, so big table dumps
+	 * need far fewer skb allocations and recvmsg() calls.
+	 */
+	dump_buf_size = min_t(u32, READ_ONCE(nlk->dump_buf_size),
+			      READ_ONCE(sk->sk_rcvbuf));
 	max_recvmsg_len = READ_ONCE(nlk->max_recvmsg_len);
-	if (alloc_min_size < max_recvmsg_len) {
+	if (alloc_min_size < dump_buf_size) {
+		alloc_size = dump_buf_size;
+		skb = netlink_alloc_large_skb(alloc_size, 0);
+	} else if (alloc_min_size < max_recvmsg_len) {
 		alloc_size = max_recvmsg_len;
 		skb = alloc_skb(alloc_size,
 				(GFP_KERNEL & ~__GFP_DIRECT_RECLAIM) |
@@ -19,6 +19,9 @@ enum {
 	NETLINK_F_STRICT_CHK,
 };
 
+/* upper bound for NETLINK_DUMP_BUF_SIZE, dump skbs are vmalloc backed */
+#define NETLINK_DUMP_BUF_MAX	(4 << 20)
+
 #define NLGRPSZ(x)	(ALIGN(x, sizeof(unsigned long) * 8) / 8)
 #define NLGRPLONGS(x)	(NLGRPSZ(x)/sizeof(unsigned long))
 
@@ -34,6 +37,7 @@ struct netlink_sock {
 	unsigned long		*groups;
 	unsigned long		state;
 	size_t			max_recvmsg_len;
+	u32			dump_buf_size;
 	wait_queue_head_t	wait;
 	bool			bound;
 	bool			cb_running;
@@ -345,6 +345,7 @@ static void flow_mask_remove(struct flow_table *tbl, struct sw_flow_mask *mask)
 
 static void __mask_cache_destroy(struct mask_cache *mc)
 {
+	free_percpu(mc->flow_cache);
 	free_percpu(mc->mask_cache);
 	kfree(mc);
 }
@@ -358,6 +359,7 @@ static void mask_cache_rcu_cb(struct rcu_head *rcu)
 
 static struct mask_cache *tbl_mask_cache_alloc(u32 size)
 {
+	struct flow_cache_entry __percpu *flow_cache = NULL;
 	struct mask_cache_entry __percpu *cache = NULL;
 	struct mask_cache *new;
 
@@ -381,9 +383,21 @@ static struct mask_cache *tbl_mask_cache_alloc(u32 size)
 			kfree(new);
 			return NULL;
 		}
+
+		new->flow_cache_size = min_t(u32, size, PCPU_MIN_UNIT_SIZE /
+					     sizeof(struct flow_cache_entry));
+		flow_cache = __alloc_percpu(array_size(sizeof(struct flow_cache_entry),
+						       new->flow_cache_size),
+					    __alignof__(struct flow_cache_entry));
+		if (!flow_cache) {
+			free_percpu(cache);
+			kfree(new);
+			return NULL;
+		}
 	}
 
 	new->mask_cache = cache;
+	new->flow_cache = flow_cache;
 	return new;
 }
 int ovs_flow_tbl_masks_cache_resize(struct flow_table *table, u32 size)
@@ -463,6 +477,10 @@ static void table_instance_flow_free(struct flow_table *table,
 {
 	hlist_del_rcu(&flow->flow_table.node[ti->node_ver]);
 	table->count--;
+	/* Invalidate all flow cache entries, pairs with the acquire in
+	 * ovs_flow_tbl_lookup_stats().
+	 */
+	smp_store_release(&table->flow_gen, table->flow_gen + 1);
 
 	if (ovs_identifier_is_ufid(&flow->id)) {
 		hlist_del_rcu(&flow->ufid_table.node[ufid_ti->node_ver]);
@@ -695,6 +713,24 @@ static bool ovs_flow_cmp_unmasked_key(const struct sw_flow *flow,
 	return cmp_key(flow->id.unmasked_key, key, key_start, key_end);
 }
 
+/* Compare @unmasked against @flow without building the masked key first. */
+static bool flow_cmp_unmasked_key_masked(const struct sw_flow *flow,
+					 const struct sw_flow_key *unmasked)
+{
+	const struct sw_flow_mask *mask = flow->mask;
+	int start = mask->range.start;
+	const long *m = (const long *)((const u8 *)&mask->key + start);
+	const long *k = (const long *)((const u8 *)unmasked + start);
+	const long *f = (const long *)((const u8 *)&flow->key + start);
+	int i;
+
+	for (i = start; i < mask->range.end; i += sizeof(long))
+		if ((*k++ & *m++) ^ *f++)
+			return false;
+
+	return true;
+}
+
 static struct sw_flow *masked_flow_lookup(struct table_instance *ti,
 					  const struct sw_flow_key *unmasked,
 					  const struct sw_flow_mask *mask,
@@ -779,23 +815,32 @@ static struct sw_flow *flow_lookup(struct flow_table *tbl,
  * cache entry in mask cache.
  * This is per cpu cache and is divided in MC_HASH_SEGS segments.
  * In case of a hash collision the entry is hashed in next segment.
+ *
+ * In front of it sits a direct mapped per cpu flow cache remembering the
+ * flow itself for a 'skb_hash'.  A hit there costs a single masked key
+ * compare instead of masking, hashing and walking a bucket for each mask
+ * probed.  Entries are invalidated wholesale whenever a flow is removed
+ * from the table, so a cached flow is never used after it was freed.
  * */
 struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 					  const struct sw_flow_key *key,
 					  u32 skb_hash,
 					  u32 *n_mask_hit,
-					  u32 *n_cache_hit)
+					  u32 *n_cache_hit,
+					  u32 *n_flow_cache_hit)
 {
 	struct mask_cache *mc = rcu_dereference(tbl->mask_cache);
 	struct mask_array *ma = rcu_dereference(tbl->mask_array);
 	struct table_instance *ti = rcu_dereference(tbl->ti);
 	struct mask_cache_entry *entries, *ce;
+	struct flow_cache_entry *fe;
 	struct sw_flow *flow;
-	u32 hash;
+	u32 hash, flow_gen;
 	int seg;
 
 	*n_mask_hit = 0;
 	*n_cache_hit = 0;
+	*n_flow_cache_hit = 0;
 	if (unlikely(!skb_hash || mc->cache_size == 0)) {
 		u32 mask_index = 0;
 		u32 cache = 0;
@@ -810,6 +855,19 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 	if (key->recirc_id)
 		skb_hash = jhash_1word(skb_hash, key->recirc_id);
 
+	/* Read the generation before walking the table, so that a flow found
+	 * below is still in the table as of 'flow_gen'.
+	 */
+	flow_gen = smp_load_acquire(&tbl->flow_gen);
+	fe = this_cpu_ptr(mc->flow_cache) +
+	     (skb_hash & (mc->flow_cache_size - 1));
+	if (fe->flow && fe->skb_hash == skb_hash &&
+	    fe->flow_gen == flow_gen &&
+	    flow_cmp_unmasked_key_masked(fe->flow, key)) {
+		(*n_flow_cache_hit)++;
+		return fe->flow;
+	}
+
 	ce = NULL;
 	hash = skb_hash;
 	entries = this_cpu_ptr(mc->mask_cache);
@@ -825,7 +883,7 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 					   n_cache_hit, &e->mask_index);
 			if (!flow)
 				e->skb_hash = 0;
-			return flow;
+			goto out;
 		}
 
 		if (!ce || e->skb_hash < ce->skb_hash)
@@ -841,6 +899,12 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *tbl,
 		ce->skb_hash = skb_hash;
 
 	*n_cache_hit = 0;
+out:
+	if (flow) {
+		fe->flow = flow;
+		fe->skb_hash = skb_hash;
+		fe->flow_gen = flow_gen;
+	}
 	return flow;
 }
 
@@ -27,10 +27,21 @@ struct mask_cache_entry {
 	u32 mask_index;
 };
 
+/* Exact-match (microflow) cache entry, valid while @flow_gen matches
+ * flow_table->flow_gen.
+ */
+struct flow_cache_entry {
+	struct sw_flow *flow;
+	u32 skb_hash;
+	u32 flow_gen;
+};
+
 struct mask_cache {
 	struct rcu_head rcu;
 	u32 cache_size;  /* Must be ^2 value. */
+	u32 flow_cache_size;  /* Must be ^2 value. */
 	struct mask_cache_entry __percpu *mask_cache;
+	struct flow_cache_entry __percpu *flow_cache;
 };
 
 struct mask_count {
@@ -67,6 +78,7 @@ struct flow_table {
 	unsigned long last_rehash;
 	unsigned int count;
 	unsigned int ufid_count;
+	u32 flow_gen;	/* Bumped on flow removal, see flow_cache_entry. */
 };
 
 extern struct kmem_cache *flow_stats_cache;
@@ -94,7 +106,8 @@ struct sw_flow *ovs_flow_tbl_lookup_stats(struct flow_table *,
 					  const struct sw_flow_key *,
 					  u32 skb_hash,
 					  u32 *n_mask_hit,
-					  u32 *n_cache_hit);
+					  u32 *n_cache_hit,
+					  u32 *n_flow_cache_hit);
 struct sw_flow *ovs_flow_tbl_lookup(struct flow_table *,
 				    const struct sw_flow_key *);
 struct sw_flow *ovs_flow_tbl_lookup_exact(struct flow_table *tbl,
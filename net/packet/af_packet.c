@@ -1408,13 +1408,21 @@ static unsigned int fanout_demux_rollover(struct packet_fanout *f,
 		po_skip = po;
 	}
 
-	i = j = min_t(int, po->rollover->sock, num - 1);
+	/* Probing from the flow hash keeps a rolled over flow on the same
+	 * socket for as long as that one has room, instead of following
+	 * whichever socket the last rollover from @po ended up at.
+	 */
+	if (fanout_has_flag(f, PACKET_FANOUT_FLAG_ROLLOVER_HASH))
+		i = j = reciprocal_scale(skb_get_hash(skb), num);
+	else
+		i = j = min_t(int, po->rollover->sock, num - 1);
 	do {
 		po_next = pkt_sk(rcu_dereference(f->arr[i]));
 		if (po_next != po_skip &&
 		    !packet_sock_flag(po_next, PACKET_SOCK_PRESSURE) &&
 		    packet_rcv_has_room(po_next, skb) == ROOM_NORMAL) {
-			if (i != j)
+			if (i != j &&
+			    !fanout_has_flag(f, PACKET_FANOUT_FLAG_ROLLOVER_HASH))
 				po->rollover->sock = i;
 			atomic_long_inc(&po->rollover->num);
 			if (room == ROOM_LOW)
@@ -1708,6 +1716,11 @@ static int fanout_add(struct sock *sk, struct fanout_args *args)
 		return -EINVAL;
 	}
 
+	if ((type_flags & PACKET_FANOUT_FLAG_ROLLOVER_HASH) &&
+	    type != PACKET_FANOUT_ROLLOVER &&
+	    !(type_flags & PACKET_FANOUT_FLAG_ROLLOVER))
+		return -EINVAL;
+
 	mutex_lock(&fanout_mutex);
 
 	err = -EALREADY;
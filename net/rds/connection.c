@@ -170,7 +170,7 @@ static struct rds_connection *__rds_conn_create(struct net *net,
 	struct rds_transport *loop_trans;
 	unsigned long flags;
 	int ret, i;
-	int npaths = (trans->t_mp_capable ? RDS_MPATH_WORKERS : 1);
+	int npaths = (trans->t_mp_capable ? rds_mpath_workers : 1);
 
 	rcu_read_lock();
 	conn = rds_conn_lookup(net, head, laddr, faddr, trans, tos, dev_if);
@@ -483,7 +483,7 @@ void rds_conn_destroy(struct rds_connection *conn)
 	unsigned long flags;
 	int i;
 	struct rds_conn_path *cp;
-	int npaths = (conn->c_trans->t_mp_capable ? RDS_MPATH_WORKERS : 1);
+	int npaths = (conn->c_trans->t_mp_capable ? rds_mpath_workers : 1);
 
 	rdsdebug("freeing conn %p for %pI4 -> "
 		 "%pI4\n", conn, &conn->c_laddr,
@@ -562,7 +562,7 @@ static void rds_conn_message_info_cmn(struct socket *sock, unsigned int len,
 				continue;
 
 			npaths = (conn->c_trans->t_mp_capable ?
-				 RDS_MPATH_WORKERS : 1);
+				 rds_mpath_workers : 1);
 
 			for (j = 0; j < npaths; j++) {
 				cp = &conn->c_path[j];
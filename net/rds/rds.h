@@ -91,10 +91,18 @@ enum {
 #define RDS_RECV_REFILL		3
 #define	RDS_DESTROY_PENDING	4
 
-/* Max number of multipaths per RDS connection. Must be a power of 2 */
-#define	RDS_MPATH_WORKERS	8
-#define	RDS_MPATH_HASH(rs, n) (jhash_1word((rs)->rs_bound_port, \
-			       (rs)->rs_hash_initval) & ((n) - 1))
+/* Default and max number of multipaths per RDS connection, see
+ * rds_mpath_workers.  Both must be a power of 2.
+ */
+#define	RDS_MPATH_DEF_WORKERS	8
+#define	RDS_MPATH_MAX_WORKERS	64
+/* Messages from one socket to one destination port always use the same
+ * path, which preserves their ordering while spreading the traffic of a
+ * socket talking to several peers over all paths.
+ */
+#define	RDS_MPATH_HASH(rs, dport, n) (jhash_2words((rs)->rs_bound_port, \
+				      (__force u32)(dport), \
+				      (rs)->rs_hash_initval) & ((n) - 1))
 
 #define IS_CANONICAL(laddr, faddr) (htonl(laddr) < htonl(faddr))
 
@@ -993,6 +1001,8 @@ extern unsigned int  rds_sysctl_trace_level;
 int rds_threads_init(void);
 void rds_threads_exit(void);
 extern struct workqueue_struct *rds_wq;
+extern struct workqueue_struct *rds_data_wq;
+extern unsigned int rds_mpath_workers;
 void rds_queue_reconnect(struct rds_conn_path *cp);
 void rds_connect_worker(struct work_struct *);
 void rds_shutdown_worker(struct work_struct *);
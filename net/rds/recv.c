@@ -141,7 +141,7 @@ static void rds_conn_peer_gen_update(struct rds_connection *conn,
 	if (peer_gen_num != 0) {
 		if (conn->c_peer_gen_num != 0 &&
 		    peer_gen_num != conn->c_peer_gen_num) {
-			for (i = 0; i < RDS_MPATH_WORKERS; i++) {
+			for (i = 0; i < rds_mpath_workers; i++) {
 				struct rds_conn_path *cp;
 
 				cp = &conn->c_path[i];
@@ -215,7 +215,7 @@ static void rds_recv_hs_exthdrs(struct rds_header *hdr,
 		/* Process extension header here */
 		switch (type) {
 		case RDS_EXTHDR_NPATHS:
-			conn->c_npaths = min_t(int, RDS_MPATH_WORKERS,
+			conn->c_npaths = min_t(int, rds_mpath_workers,
 					       be16_to_cpu(buffer.rds_npaths));
 			break;
 		case RDS_EXTHDR_GEN_NUM:
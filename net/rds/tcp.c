@@ -312,6 +312,54 @@ static void rds6_tcp_tc_info(struct socket *sock, unsigned int len,
 }
 #endif
 
+/* Handle RDS_INFO_TCP_PATHS socket option.  IPv4 connection addresses
+ * are returned as IPv4 mapped addresses.
+ */
+static void rds_tcp_path_info(struct socket *sock, unsigned int len,
+			      struct rds_info_iterator *iter,
+			      struct rds_info_lengths *lens)
+{
+	struct rds_info_tcp_path pinfo;
+	struct rds_tcp_connection *tc;
+	unsigned long flags;
+	unsigned int count;
+
+	spin_lock_irqsave(&rds_tcp_tc_list_lock, flags);
+
+#if IS_ENABLED(CONFIG_IPV6)
+	count = rds6_tcp_tc_count;
+#else
+	count = rds_tcp_tc_count;
+#endif
+	if (len / sizeof(pinfo) < count)
+		goto out;
+
+	list_for_each_entry(tc, &rds_tcp_tc_list, t_list_item) {
+		struct inet_sock *inet = inet_sk(tc->t_sock->sk);
+		struct rds_conn_path *cp = tc->t_cpath;
+
+		pinfo.local_addr = cp->cp_conn->c_laddr;
+		pinfo.local_port = inet->inet_sport;
+		pinfo.peer_addr = cp->cp_conn->c_faddr;
+		pinfo.peer_port = inet->inet_dport;
+		pinfo.tos = cp->cp_conn->c_tos;
+		pinfo.path_index = cp->cp_index;
+
+		pinfo.tx_msgs = READ_ONCE(tc->t_tx_msgs);
+		pinfo.tx_bytes = READ_ONCE(tc->t_tx_bytes);
+		pinfo.rx_msgs = READ_ONCE(tc->t_rx_msgs);
+		pinfo.rx_bytes = READ_ONCE(tc->t_rx_bytes);
+
+		rds_info_copy(iter, &pinfo, sizeof(pinfo));
+	}
+
+out:
+	lens->nr = count;
+	lens->each = sizeof(pinfo);
+
+	spin_unlock_irqrestore(&rds_tcp_tc_list_lock, flags);
+}
+
 int rds_tcp_laddr_check(struct net *net, const struct in6_addr *addr,
 			__u32 scope_id)
 {
@@ -368,7 +416,7 @@ static int rds_tcp_conn_alloc(struct rds_connection *conn, gfp_t gfp)
 	int i, j;
 	int ret = 0;
 
-	for (i = 0; i < RDS_MPATH_WORKERS; i++) {
+	for (i = 0; i < rds_mpath_workers; i++) {
 		tc = kmem_cache_alloc(rds_tcp_conn_slab, gfp);
 		if (!tc) {
 			ret = -ENOMEM;
@@ -379,6 +427,10 @@ static int rds_tcp_conn_alloc(struct rds_connection *conn, gfp_t gfp)
 		tc->t_tinc = NULL;
 		tc->t_tinc_hdr_rem = sizeof(struct rds_header);
 		tc->t_tinc_data_rem = 0;
+		tc->t_tx_msgs = 0;
+		tc->t_tx_bytes = 0;
+		tc->t_rx_msgs = 0;
+		tc->t_rx_bytes = 0;
 
 		conn->c_path[i].cp_transport_data = tc;
 		tc->t_cpath = &conn->c_path[i];
@@ -388,7 +440,7 @@ static int rds_tcp_conn_alloc(struct rds_connection *conn, gfp_t gfp)
 			 conn->c_path[i].cp_transport_data);
 	}
 	spin_lock_irq(&rds_tcp_conn_lock);
-	for (i = 0; i < RDS_MPATH_WORKERS; i++) {
+	for (i = 0; i < rds_mpath_workers; i++) {
 		tc = conn->c_path[i].cp_transport_data;
 		tc->t_tcp_node_detached = false;
 		list_add_tail(&tc->t_tcp_node, &rds_tcp_conn_list);
@@ -707,6 +759,7 @@ static void rds_tcp_exit(void)
 #if IS_ENABLED(CONFIG_IPV6)
 	rds_info_deregister_func(RDS6_INFO_TCP_SOCKETS, rds6_tcp_tc_info);
 #endif
+	rds_info_deregister_func(RDS_INFO_TCP_PATHS, rds_tcp_path_info);
 	unregister_pernet_device(&rds_tcp_net_ops);
 	rds_tcp_destroy_conns();
 	rds_trans_unregister(&rds_tcp_transport);
@@ -741,6 +794,7 @@ static int __init rds_tcp_init(void)
 #if IS_ENABLED(CONFIG_IPV6)
 	rds_info_register_func(RDS6_INFO_TCP_SOCKETS, rds6_tcp_tc_info);
 #endif
+	rds_info_register_func(RDS_INFO_TCP_PATHS, rds_tcp_path_info);
 
 	goto out;
 out_recv:
@@ -38,6 +38,12 @@ struct rds_tcp_connection {
 	u32			t_last_sent_nxt;
 	u32			t_last_expected_una;
 	u32			t_last_seen_una;
+
+	/* per path statistics, only updated by the send/recv workers */
+	u64			t_tx_msgs;
+	u64			t_tx_bytes;
+	u64			t_rx_msgs;
+	u64			t_rx_bytes;
 };
 
 struct rds_tcp_statistics {
@@ -245,6 +245,7 @@ static int rds_tcp_data_recv(read_descriptor_t *desc, struct sk_buff *skb,
 						  &tinc->ti_inc,
 						  arg->gfp);
 
+			WRITE_ONCE(tc->t_rx_msgs, tc->t_rx_msgs + 1);
 			tc->t_tinc_hdr_rem = sizeof(struct rds_header);
 			tc->t_tinc_data_rem = 0;
 			tc->t_tinc = NULL;
@@ -253,6 +254,7 @@ static int rds_tcp_data_recv(read_descriptor_t *desc, struct sk_buff *skb,
 		}
 	}
 out:
+	WRITE_ONCE(tc->t_rx_bytes, tc->t_rx_bytes + len - left);
 	rdsdebug("returning len %zu left %zu skb len %d rx queue depth %d\n",
 		 len, left, skb->len,
 		 skb_queue_len(&tc->t_sock->sk->sk_receive_queue));
@@ -327,7 +329,7 @@ void rds_tcp_data_ready(struct sock *sk)
 	if (rds_tcp_read_sock(cp, GFP_ATOMIC) == -ENOMEM) {
 		rcu_read_lock();
 		if (!rds_destroy_pending(cp->cp_conn))
-			queue_delayed_work(rds_wq, &cp->cp_recv_w, 0);
+			queue_delayed_work(rds_data_wq, &cp->cp_recv_w, 0);
 		rcu_read_unlock();
 	}
 out:
@@ -89,6 +89,7 @@ int rds_tcp_xmit(struct rds_connection *conn, struct rds_message *rm,
 		smp_mb__before_atomic();
 		set_bit(RDS_MSG_HAS_ACK_SEQ, &rm->m_flags);
 		tc->t_last_expected_una = rm->m_ack_seq + 1;
+		WRITE_ONCE(tc->t_tx_msgs, tc->t_tx_msgs + 1);
 
 		if (test_bit(RDS_MSG_RETRANSMITTED, &rm->m_flags))
 			rm->m_inc.i_hdr.h_flags |= RDS_FLAG_RETRANSMITTED;
@@ -157,6 +158,8 @@ int rds_tcp_xmit(struct rds_connection *conn, struct rds_message *rm,
 			}
 		}
 	}
+	if (done > 0)
+		WRITE_ONCE(tc->t_tx_bytes, tc->t_tx_bytes + done);
 	if (done == 0)
 		done = ret;
 	return done;
@@ -201,7 +204,7 @@ void rds_tcp_write_space(struct sock *sk)
 	rcu_read_lock();
 	if ((refcount_read(&sk->sk_wmem_alloc) << 1) <= sk->sk_sndbuf &&
 	    !rds_destroy_pending(cp->cp_conn))
-		queue_delayed_work(rds_wq, &cp->cp_send_w, 0);
+		queue_delayed_work(rds_data_wq, &cp->cp_send_w, 0);
 	rcu_read_unlock();
 
 out:
@@ -33,6 +33,8 @@
 #include <linux/kernel.h>
 #include <linux/random.h>
 #include <linux/export.h>
+#include <linux/log2.h>
+#include <linux/moduleparam.h>
 
 #include "rds.h"
 
@@ -67,9 +69,22 @@
  *
  *	For receive callbacks, we rely on the underlying transport
  *	(TCP, IB/RDMA) to provide the necessary synchronisation.
+ *
+ * Connection management runs on the single threaded rds_wq, while the
+ * send and receive workers of the individual paths run on rds_data_wq so
+ * that the paths of a multipath connection are serviced in parallel.
  */
 struct workqueue_struct *rds_wq;
 EXPORT_SYMBOL_GPL(rds_wq);
+struct workqueue_struct *rds_data_wq;
+EXPORT_SYMBOL_GPL(rds_data_wq);
+
+/* Number of paths per connection offered by multipath capable transports */
+unsigned int rds_mpath_workers = RDS_MPATH_DEF_WORKERS;
+EXPORT_SYMBOL_GPL(rds_mpath_workers);
+module_param(rds_mpath_workers, uint, 0444);
+MODULE_PARM_DESC(rds_mpath_workers,
+		 " Number of paths per multipath capable connection (power of 2)");
 
 void rds_connect_path_complete(struct rds_conn_path *cp, int curr)
 {
@@ -89,8 +104,8 @@ void rds_connect_path_complete(struct rds_conn_path *cp, int curr)
 	set_bit(0, &cp->cp_conn->c_map_queued);
 	rcu_read_lock();
 	if (!rds_destroy_pending(cp->cp_conn)) {
-		queue_delayed_work(rds_wq, &cp->cp_send_w, 0);
-		queue_delayed_work(rds_wq, &cp->cp_recv_w, 0);
+		queue_delayed_work(rds_data_wq, &cp->cp_send_w, 0);
+		queue_delayed_work(rds_data_wq, &cp->cp_recv_w, 0);
 	}
 	rcu_read_unlock();
 	cp->cp_conn->c_proposed_version = RDS_PROTOCOL_VERSION;
@@ -203,11 +218,11 @@ void rds_send_worker(struct work_struct *work)
 		switch (ret) {
 		case -EAGAIN:
 			rds_stats_inc(s_send_immediate_retry);
-			queue_delayed_work(rds_wq, &cp->cp_send_w, 0);
+			queue_delayed_work(rds_data_wq, &cp->cp_send_w, 0);
 			break;
 		case -ENOMEM:
 			rds_stats_inc(s_send_delayed_retry);
-			queue_delayed_work(rds_wq, &cp->cp_send_w, 2);
+			queue_delayed_work(rds_data_wq, &cp->cp_send_w, 2);
 			break;
 		default:
 			break;
@@ -228,11 +243,11 @@ void rds_recv_worker(struct work_struct *work)
 		switch (ret) {
 		case -EAGAIN:
 			rds_stats_inc(s_recv_immediate_retry);
-			queue_delayed_work(rds_wq, &cp->cp_recv_w, 0);
+			queue_delayed_work(rds_data_wq, &cp->cp_recv_w, 0);
 			break;
 		case -ENOMEM:
 			rds_stats_inc(s_recv_delayed_retry);
-			queue_delayed_work(rds_wq, &cp->cp_recv_w, 2);
+			queue_delayed_work(rds_data_wq, &cp->cp_recv_w, 2);
 			break;
 		default:
 			break;
@@ -251,15 +266,29 @@ void rds_shutdown_worker(struct work_struct *work)
 
 void rds_threads_exit(void)
 {
+	destroy_workqueue(rds_data_wq);
 	destroy_workqueue(rds_wq);
 }
 
 int rds_threads_init(void)
 {
+	if (!rds_mpath_workers || !is_power_of_2(rds_mpath_workers) ||
+	    rds_mpath_workers > RDS_MPATH_MAX_WORKERS) {
+		pr_warn("RDS: invalid rds_mpath_workers %u, using %u\n",
+			rds_mpath_workers, RDS_MPATH_DEF_WORKERS);
+		rds_mpath_workers = RDS_MPATH_DEF_WORKERS;
+	}
+
 	rds_wq = create_singlethread_workqueue("krdsd");
 	if (!rds_wq)
 		return -ENOMEM;
 
+	rds_data_wq = alloc_workqueue("krdsd_data", WQ_MEM_RECLAIM, 0);
+	if (!rds_data_wq) {
+		destroy_workqueue(rds_wq);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -94,7 +94,7 @@ static int smc_lo_register_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb,
 			goto again;
 		}
 	}
-	hash_add(ldev->dmb_ht, &dmb_node->list, dmb_node->token);
+	hash_add_rcu(ldev->dmb_ht, &dmb_node->list, dmb_node->token);
 	write_unlock_bh(&ldev->dmb_ht_lock);
 	atomic_inc(&ldev->dmb_cnt);
 
@@ -113,17 +113,26 @@ static int smc_lo_register_dmb(struct smcd_dev *smcd, struct smcd_dmb *dmb,
 	return rc;
 }
 
+static void smc_lo_free_dmb_rcu(struct rcu_head *rcu)
+{
+	struct smc_lo_dmb_node *dmb_node =
+		container_of(rcu, struct smc_lo_dmb_node, rcu);
+
+	kvfree(dmb_node->cpu_addr);
+	kfree(dmb_node);
+}
+
 static void __smc_lo_unregister_dmb(struct smc_lo_dev *ldev,
 				    struct smc_lo_dmb_node *dmb_node)
 {
 	/* remove dmb from hash table */
 	write_lock_bh(&ldev->dmb_ht_lock);
-	hash_del(&dmb_node->list);
+	hash_del_rcu(&dmb_node->list);
 	write_unlock_bh(&ldev->dmb_ht_lock);
 
 	clear_bit(dmb_node->sba_idx, ldev->sba_idx_mask);
-	kvfree(dmb_node->cpu_addr);
-	kfree(dmb_node);
+	/* smc_lo_move_data() may still be copying into it */
+	call_rcu(&dmb_node->rcu, smc_lo_free_dmb_rcu);
 
 	if (atomic_dec_and_test(&ldev->dmb_cnt))
 		wake_up(&ldev->ldev_release);
@@ -230,19 +239,23 @@ static int smc_lo_move_data(struct smcd_dev *smcd, u64 dmb_tok,
 		 */
 		return 0;
 
-	read_lock_bh(&ldev->dmb_ht_lock);
-	hash_for_each_possible(ldev->dmb_ht, tmp_node, list, dmb_tok) {
+	/* Every CDC message of every connection comes through here, so
+	 * look the peer DMB up under RCU instead of bouncing the cacheline
+	 * of the global dmb_ht_lock between CPUs.
+	 */
+	rcu_read_lock();
+	hash_for_each_possible_rcu(ldev->dmb_ht, tmp_node, list, dmb_tok) {
 		if (tmp_node->token == dmb_tok) {
 			rmb_node = tmp_node;
 			break;
 		}
 	}
 	if (!rmb_node) {
-		read_unlock_bh(&ldev->dmb_ht_lock);
+		rcu_read_unlock();
 		return -EINVAL;
 	}
 	memcpy((char *)rmb_node->cpu_addr + offset, data, size);
-	read_unlock_bh(&ldev->dmb_ht_lock);
+	rcu_read_unlock();
 
 	conn = smcd->conn[rmb_node->sba_idx];
 	if (!conn || conn->killed)
@@ -424,4 +437,5 @@ int smc_loopback_init(void)
 void smc_loopback_exit(void)
 {
 	smc_lo_dev_remove();
+	rcu_barrier(); /* wait for smc_lo_free_dmb_rcu() */
 }
@@ -31,6 +31,7 @@ struct smc_lo_dmb_node {
 	void *cpu_addr;
 	dma_addr_t dma_addr;
 	refcount_t refcnt;
+	struct rcu_head rcu;
 };
 
 struct smc_lo_dev {
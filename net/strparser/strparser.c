@@ -291,8 +291,12 @@ static int __strp_recv(read_descriptor_t *desc, struct sk_buff *orig_skb,
 
 		eaten += (cand_len - extra);
 
-		/* Hurray, we have a new message! */
-		cancel_delayed_work(&strp->msg_timer_work);
+		/* Hurray, we have a new message! The timer is only armed
+		 * for messages spanning several skbs, don't pay for the
+		 * cancel on every small one.
+		 */
+		if (delayed_work_pending(&strp->msg_timer_work))
+			cancel_delayed_work(&strp->msg_timer_work);
 		strp->skb_head = NULL;
 		strp->need_bytes = 0;
 		STRP_STATS_INCR(strp->stats.msgs);
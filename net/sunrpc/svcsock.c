@@ -298,6 +298,17 @@ static inline void svc_flush_bvec(const struct bio_vec *bvec, size_t size,
  * pages in @rqstp's rq_pages array until the last page of the message
  * has been received into a partial page.
  */
+/*
+ * Bytes that arrive after this check raise ->sk_data_ready(), which
+ * sets XPT_DATA again, so a stale answer only costs a wakeup.
+ */
+static bool svc_tcp_data_pending(struct svc_sock *svsk)
+{
+	const struct tcp_sock *tp = tcp_sk(svsk->sk_sk);
+
+	return READ_ONCE(tp->rcv_nxt) != READ_ONCE(tp->copied_seq);
+}
+
 static ssize_t svc_tcp_read_msg(struct svc_rqst *rqstp, size_t buflen,
 				size_t seek)
 {
@@ -325,10 +336,13 @@ static ssize_t svc_tcp_read_msg(struct svc_rqst *rqstp, size_t buflen,
 	if (len > 0)
 		svc_flush_bvec(bvec, len, seek);
 
-	/* If we read a full record, then assume there may be more
-	 * data to read (stream based sockets only!)
+	/* If we read a full record, there may be more data to read
+	 * (stream based sockets only!). Only requeue the transport when
+	 * the socket actually has bytes queued, so a client with one
+	 * call in flight does not wake a second thread per RPC just to
+	 * find an empty socket.
 	 */
-	if (len == buflen)
+	if (len == buflen && svc_tcp_data_pending(svsk))
 		set_bit(XPT_DATA, &svsk->sk_xprt.xpt_flags);
 
 	return len;
@@ -1346,6 +1346,36 @@ static void xdr_stream_unmap_current_page(struct xdr_stream *xdr)
 	}
 }
 
+/*
+ * Number of bytes from the start of the current page that can be decoded
+ * in place.  Consecutive pages of the same large folio sit next to each
+ * other in the direct map, so the window runs to the end of the folio (or
+ * of @pgend) instead of stopping at every page boundary.  page_ptr is left
+ * on the last page of the window for xdr_set_next_page().
+ */
+static unsigned int xdr_page_window(struct xdr_stream *xdr, unsigned int pgend)
+{
+	struct page **pages = xdr->page_ptr;
+	unsigned int n = 1, max, idx;
+	struct folio *folio;
+
+	if (pgend <= PAGE_SIZE || PageHighMem(*pages))
+		return PAGE_SIZE;
+
+	folio = page_folio(*pages);
+	if (!folio_test_large(folio))
+		return PAGE_SIZE;
+
+	idx = folio_page_idx(folio, *pages);
+	max = min_t(unsigned int, DIV_ROUND_UP(pgend, PAGE_SIZE),
+		    folio_nr_pages(folio) - idx);
+	while (n < max && pages[n] == folio_page(folio, idx + n))
+		n++;
+
+	xdr->page_ptr += n - 1;
+	return n << PAGE_SHIFT;
+}
+
 static unsigned int xdr_set_page_base(struct xdr_stream *xdr,
 				      unsigned int base, unsigned int len)
 {
@@ -1380,8 +1410,7 @@ static unsigned int xdr_set_page_base(struct xdr_stream *xdr,
 	xdr->p = (__be32*)(kaddr + pgoff);
 
 	pgend = pgoff + len;
-	if (pgend > PAGE_SIZE)
-		pgend = PAGE_SIZE;
+	pgend = min(pgend, xdr_page_window(xdr, pgend));
 	xdr->end = (__be32*)(kaddr + pgend);
 	xdr->iov = NULL;
 	return len;
@@ -1538,6 +1567,127 @@ __be32 * xdr_inline_decode(struct xdr_stream *xdr, size_t nbytes)
 }
 EXPORT_SYMBOL_GPL(xdr_inline_decode);
 
+typedef void (*xdr_decode_run_t)(void *items, const __be32 *p, unsigned int n);
+
+/*
+ * Decode @count items of @item_words XDR words each, in runs of as many
+ * items as the current buffer holds, so only an item that straddles two
+ * buffers goes through the scratch buffer.
+ */
+static __always_inline ssize_t
+xdr_stream_decode_items(struct xdr_stream *xdr, void *items, size_t item_size,
+			unsigned int item_words, unsigned int count,
+			xdr_decode_run_t decode)
+{
+	unsigned int left = count, n;
+	__be32 *p;
+
+	while (left) {
+		n = min_t(unsigned int, xdr->end - xdr->p, xdr->nwords);
+		n = min(n / item_words, left);
+		if (n) {
+			p = __xdr_inline_decode(xdr, (size_t)n * item_words << 2);
+		} else {
+			n = 1;
+			p = xdr_inline_decode(xdr, item_words << 2);
+		}
+		if (unlikely(!p))
+			return -EBADMSG;
+		decode(items, p, n);
+		items += n * item_size;
+		left -= n;
+	}
+	return count;
+}
+
+static void xdr_decode_u32_run(void *items, const __be32 *p, unsigned int n)
+{
+	u32 *v = items;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		v[i] = be32_to_cpup(p + i);
+}
+
+static void xdr_decode_u64_run(void *items, const __be32 *p, unsigned int n)
+{
+	u64 *v = items;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		v[i] = get_unaligned_be64(p + 2 * i);
+}
+
+/**
+ * xdr_stream_decode_u32_items - Decode a fixed number of 32-bit integers
+ * @xdr: pointer to xdr_stream
+ * @items: location to store the integers
+ * @count: number of integers to decode
+ *
+ * Unlike xdr_stream_decode_uint32_array() there is no length prefix, and
+ * the array may span any number of pages.
+ *
+ * Return values:
+ *   On success, returns @count
+ *   %-EBADMSG on XDR buffer overflow
+ */
+ssize_t xdr_stream_decode_u32_items(struct xdr_stream *xdr, u32 *items,
+				    unsigned int count)
+{
+	return xdr_stream_decode_items(xdr, items, sizeof(*items), 1, count,
+				       xdr_decode_u32_run);
+}
+EXPORT_SYMBOL_GPL(xdr_stream_decode_u32_items);
+
+/**
+ * xdr_stream_decode_u64_items - Decode a fixed number of 64-bit integers
+ * @xdr: pointer to xdr_stream
+ * @items: location to store the integers
+ * @count: number of integers to decode
+ *
+ * Return values:
+ *   On success, returns @count
+ *   %-EBADMSG on XDR buffer overflow
+ */
+ssize_t xdr_stream_decode_u64_items(struct xdr_stream *xdr, u64 *items,
+				    unsigned int count)
+{
+	return xdr_stream_decode_items(xdr, items, sizeof(*items), 2, count,
+				       xdr_decode_u64_run);
+}
+EXPORT_SYMBOL_GPL(xdr_stream_decode_u64_items);
+
+/**
+ * xdr_stream_decode_array_items - Decode an array of fixed-size XDR items
+ * @xdr: pointer to xdr_stream
+ * @items: location to store the decoded items
+ * @item_size: size of one decoded item in @items
+ * @item_len: size of one item on the wire, in bytes
+ * @count: number of items to decode
+ * @decode: decodes @n consecutive wire items at @p into @items
+ *
+ * For items that are not plain integers, such as file handles of known
+ * length or (cookie, verifier) pairs.  @decode is called with as many items
+ * as are contiguous in the receive buffer.
+ *
+ * Return values:
+ *   On success, returns @count
+ *   %-EBADMSG on XDR buffer overflow
+ */
+ssize_t xdr_stream_decode_array_items(struct xdr_stream *xdr, void *items,
+				      size_t item_size, size_t item_len,
+				      unsigned int count,
+				      void (*decode)(void *items,
+						     const __be32 *p,
+						     unsigned int n))
+{
+	if (unlikely(!item_len))
+		return -EINVAL;
+	return xdr_stream_decode_items(xdr, items, item_size,
+				       XDR_QUADLEN(item_len), count, decode);
+}
+EXPORT_SYMBOL_GPL(xdr_stream_decode_array_items);
+
 static void xdr_realign_pages(struct xdr_stream *xdr)
 {
 	struct xdr_buf *buf = xdr->buf;
@@ -26,6 +26,7 @@ typedef struct rpc_xprt *(*xprt_switch_find_xprt_t)(struct rpc_xprt_switch *xps,
 
 static const struct rpc_xprt_iter_ops rpc_xprt_iter_singular;
 static const struct rpc_xprt_iter_ops rpc_xprt_iter_roundrobin;
+static const struct rpc_xprt_iter_ops rpc_xprt_iter_leastqueue;
 static const struct rpc_xprt_iter_ops rpc_xprt_iter_listall;
 static const struct rpc_xprt_iter_ops rpc_xprt_iter_listoffline;
 
@@ -204,14 +205,39 @@ void xprt_switch_put(struct rpc_xprt_switch *xps)
  * rpc_xprt_switch_set_roundrobin - Set a round-robin policy on rpc_xprt_switch
  * @xps: pointer to struct rpc_xprt_switch
  *
- * Sets a round-robin default policy for iterators acting on xps.
+ * Sets a round-robin default policy for iterators acting on xps, unless
+ * the least-queue policy was already chosen for it.
  */
 void rpc_xprt_switch_set_roundrobin(struct rpc_xprt_switch *xps)
 {
-	if (READ_ONCE(xps->xps_iter_ops) != &rpc_xprt_iter_roundrobin)
+	if (READ_ONCE(xps->xps_iter_ops) == &rpc_xprt_iter_singular)
 		WRITE_ONCE(xps->xps_iter_ops, &rpc_xprt_iter_roundrobin);
 }
 
+/**
+ * rpc_xprt_switch_set_leastqueue - Set a least-queue policy on rpc_xprt_switch
+ * @xps: pointer to struct rpc_xprt_switch
+ * @enable: use the least-queue policy if true, round-robin otherwise
+ *
+ * The least-queue policy sends each new task to the active transport
+ * with the fewest tasks queued on it, so that a few large requests on
+ * one connection do not hold up small ones.
+ */
+void rpc_xprt_switch_set_leastqueue(struct rpc_xprt_switch *xps, bool enable)
+{
+	WRITE_ONCE(xps->xps_iter_ops, enable ? &rpc_xprt_iter_leastqueue :
+					       &rpc_xprt_iter_roundrobin);
+}
+
+/**
+ * rpc_xprt_switch_is_leastqueue - Check for the least-queue policy
+ * @xps: pointer to struct rpc_xprt_switch
+ */
+bool rpc_xprt_switch_is_leastqueue(const struct rpc_xprt_switch *xps)
+{
+	return READ_ONCE(xps->xps_iter_ops) == &rpc_xprt_iter_leastqueue;
+}
+
 static
 const struct rpc_xprt_iter_ops *xprt_iter_ops(const struct rpc_xprt_iter *xpi)
 {
@@ -459,6 +485,42 @@ struct rpc_xprt *xprt_iter_next_entry_roundrobin(struct rpc_xprt_iter *xpi)
 			xprt_switch_find_next_entry_roundrobin);
 }
 
+static
+struct rpc_xprt *xprt_switch_find_next_entry_leastqueue(struct rpc_xprt_switch *xps,
+		const struct rpc_xprt *cur)
+{
+	struct rpc_xprt *pos, *best = NULL;
+	bool past_cur = cur == NULL;
+	bool best_past_cur = false;
+	long queuelen, best_queuelen = LONG_MAX;
+
+	list_for_each_entry_rcu(pos, &xps->xps_xprt_list, xprt_switch) {
+		if (xprt_is_active(pos)) {
+			queuelen = atomic_long_read(&pos->queuelen);
+			/* On a tie prefer the first transport after @cur,
+			 * so that idle transports are used in turn.
+			 */
+			if (queuelen < best_queuelen ||
+			    (queuelen == best_queuelen && past_cur &&
+			     !best_past_cur)) {
+				best = pos;
+				best_queuelen = queuelen;
+				best_past_cur = past_cur;
+			}
+		}
+		if (pos == cur)
+			past_cur = true;
+	}
+	return best;
+}
+
+static
+struct rpc_xprt *xprt_iter_next_entry_leastqueue(struct rpc_xprt_iter *xpi)
+{
+	return xprt_iter_next_entry_multiple(xpi,
+			xprt_switch_find_next_entry_leastqueue);
+}
+
 static
 struct rpc_xprt *xprt_switch_find_next_entry_all(struct rpc_xprt_switch *xps,
 		const struct rpc_xprt *cur)
@@ -652,6 +714,14 @@ const struct rpc_xprt_iter_ops rpc_xprt_iter_roundrobin = {
 	.xpi_next = xprt_iter_next_entry_roundrobin,
 };
 
+/* Policy for picking the least loaded entry in the rpc_xprt_switch */
+static
+const struct rpc_xprt_iter_ops rpc_xprt_iter_leastqueue = {
+	.xpi_rewind = xprt_iter_default_rewind,
+	.xpi_xprt = xprt_iter_current_entry,
+	.xpi_next = xprt_iter_next_entry_leastqueue,
+};
+
 /* Policy for once-through iteration of entries in the rpc_xprt_switch */
 static
 const struct rpc_xprt_iter_ops rpc_xprt_iter_listall = {
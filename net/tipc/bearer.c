@@ -69,6 +69,8 @@ static struct tipc_bearer *bearer_get(struct net *net, int bearer_id)
 static void bearer_disable(struct net *net, struct tipc_bearer *b);
 static int tipc_l2_rcv_msg(struct sk_buff *skb, struct net_device *dev,
 			   struct packet_type *pt, struct net_device *orig_dev);
+static void tipc_l2_rcv_list(struct list_head *head, struct packet_type *pt,
+			     struct net_device *orig_dev);
 
 /**
  * tipc_media_find - locates specified media object by name
@@ -455,6 +457,7 @@ int tipc_enable_l2_media(struct net *net, struct tipc_bearer *b,
 	b->pt.dev = dev;
 	b->pt.type = htons(ETH_P_TIPC);
 	b->pt.func = tipc_l2_rcv_msg;
+	b->pt.list_func = tipc_l2_rcv_list;
 	dev_add_pack(&b->pt);
 	memset(&b->bcast_addr, 0, sizeof(b->bcast_addr));
 	memcpy(b->bcast_addr.value, dev->broadcast, hwaddr_len);
@@ -670,6 +673,43 @@ static int tipc_l2_rcv_msg(struct sk_buff *skb, struct net_device *dev,
 	return NET_RX_DROP;
 }
 
+/**
+ * tipc_l2_rcv_list - handle a list of incoming TIPC messages from an interface
+ * @head: the received packets
+ * @pt: the packet_type structure which was used to register this handler
+ * @orig_dev: the original receive net device in case the device is a bond
+ *
+ * Runs of packets for the same bearer are handed to tipc_rcv_list() in one go.
+ */
+static void tipc_l2_rcv_list(struct list_head *head, struct packet_type *pt,
+			     struct net_device *orig_dev)
+{
+	struct tipc_bearer *b, *prev = NULL;
+	struct sk_buff *skb, *next;
+	struct sk_buff_head list;
+
+	__skb_queue_head_init(&list);
+	rcu_read_lock();
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+		b = rcu_dereference(skb->dev->tipc_ptr) ?:
+			rcu_dereference(orig_dev->tipc_ptr);
+		if (unlikely(!b || !test_bit(0, &b->up) ||
+			     skb->pkt_type > PACKET_MULTICAST)) {
+			kfree_skb(skb);
+			continue;
+		}
+		if (prev && b != prev)
+			tipc_rcv_list(dev_net(prev->pt.dev), &list, prev);
+		prev = b;
+		TIPC_SKB_CB(skb)->flags = 0;
+		__skb_queue_tail(&list, skb);
+	}
+	if (prev)
+		tipc_rcv_list(dev_net(prev->pt.dev), &list, prev);
+	rcu_read_unlock();
+}
+
 /**
  * tipc_l2_device_event - handle device events from network device
  * @nb: the context of the notification
@@ -186,6 +186,8 @@ struct tipc_bearer_names {
  */
 
 void tipc_rcv(struct net *net, struct sk_buff *skb, struct tipc_bearer *b);
+void tipc_rcv_list(struct net *net, struct sk_buff_head *list,
+		   struct tipc_bearer *b);
 
 /*
  * Routines made available to TIPC by supported media types
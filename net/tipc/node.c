@@ -2080,6 +2080,34 @@ static bool tipc_node_check_state(struct tipc_node *n, struct sk_buff *skb,
  * Invoked with no locks held. Bearer pointer must point to a valid bearer
  * structure (i.e. cannot be NULL), but bearer can be inactive.
  */
+/* Common tail of packet reception, run without any node or link lock held */
+static void tipc_node_rcv_done(struct net *net, struct tipc_node *n,
+			       int bearer_id, int rc,
+			       struct sk_buff_head *xmitq)
+{
+	struct tipc_link_entry *le = &n->links[bearer_id];
+
+	if (unlikely(rc & TIPC_LINK_UP_EVT))
+		tipc_node_link_up(n, bearer_id, xmitq);
+
+	if (unlikely(rc & TIPC_LINK_DOWN_EVT))
+		tipc_node_link_down(n, bearer_id, false);
+
+	if (unlikely(!skb_queue_empty(&n->bc_entry.namedq)))
+		tipc_named_rcv(net, &n->bc_entry.namedq,
+			       &n->bc_entry.named_rcv_nxt,
+			       &n->bc_entry.named_open);
+
+	if (unlikely(!skb_queue_empty(&n->bc_entry.inputq1)))
+		tipc_node_mcast_rcv(n);
+
+	if (!skb_queue_empty(&le->inputq))
+		tipc_sk_rcv(net, &le->inputq);
+
+	if (!skb_queue_empty(xmitq))
+		tipc_bearer_xmit(net, bearer_id, xmitq, &le->maddr, n);
+}
+
 void tipc_rcv(struct net *net, struct sk_buff *skb, struct tipc_bearer *b)
 {
 	struct sk_buff_head xmitq;
@@ -2176,30 +2204,124 @@ void tipc_rcv(struct net *net, struct sk_buff *skb, struct tipc_bearer *b)
 		tipc_node_write_unlock(n);
 	}
 
-	if (unlikely(rc & TIPC_LINK_UP_EVT))
-		tipc_node_link_up(n, bearer_id, &xmitq);
+	tipc_node_rcv_done(net, n, bearer_id, rc, &xmitq);
 
-	if (unlikely(rc & TIPC_LINK_DOWN_EVT))
-		tipc_node_link_down(n, bearer_id, false);
+out_node_put:
+	tipc_node_put(n);
+discard:
+	kfree_skb(skb);
+}
 
-	if (unlikely(!skb_queue_empty(&n->bc_entry.namedq)))
-		tipc_named_rcv(net, &n->bc_entry.namedq,
-			       &n->bc_entry.named_rcv_nxt,
-			       &n->bc_entry.named_open);
+/* tipc_rcv_batchable - validate a packet for tipc_rcv_list()
+ *
+ * Returns true if @skb is a unicast data packet for this node which can be
+ * received without going through tipc_rcv(). Invalid packets are freed and
+ * *skb is set to NULL.
+ */
+static bool tipc_rcv_batchable(struct sk_buff **skb, u32 self)
+{
+	struct tipc_msg *hdr;
+	int usr;
 
-	if (unlikely(!skb_queue_empty(&n->bc_entry.inputq1)))
-		tipc_node_mcast_rcv(n);
+#ifdef CONFIG_TIPC_CRYPTO
+	if (!TIPC_SKB_CB(*skb)->decrypted && tipc_ehdr_validate(*skb))
+		return false;
+#endif
+	if (unlikely(!tipc_msg_validate(skb))) {
+		kfree_skb(*skb);
+		*skb = NULL;
+		return false;
+	}
+	hdr = buf_msg(*skb);
+	usr = msg_user(hdr);
+	if (unlikely(msg_non_seq(hdr) || usr == LINK_PROTOCOL ||
+		     usr == TUNNEL_PROTOCOL))
+		return false;
+	return msg_short(hdr) || msg_destnode(hdr) == self;
+}
 
-	if (!skb_queue_empty(&le->inputq))
-		tipc_sk_rcv(net, &le->inputq);
+/**
+ * tipc_rcv_list - receive a list of packets from a bearer
+ * @net: the applicable net namespace
+ * @list: the packets, all received on @b
+ * @b: pointer to bearer message arrived on
+ *
+ * Consecutive data packets from the same peer are passed to the link under
+ * a single acquisition of the node and link locks, and the resulting socket
+ * delivery and acknowledges are done once per run instead of once per
+ * packet. Anything else takes the regular tipc_rcv() path.
+ */
+void tipc_rcv_list(struct net *net, struct sk_buff_head *list,
+		   struct tipc_bearer *b)
+{
+	int bearer_id = b->identity;
+	u32 self = tipc_own_addr(net);
+	struct sk_buff_head xmitq;
+	struct tipc_link_entry *le;
+	struct tipc_link *bcl;
+	struct sk_buff *skb;
+	struct tipc_node *n;
+	u32 addr;
+	int rc;
 
-	if (!skb_queue_empty(&xmitq))
-		tipc_bearer_xmit(net, bearer_id, &xmitq, &le->maddr, n);
+	while ((skb = __skb_dequeue(list))) {
+		if (!tipc_rcv_batchable(&skb, self)) {
+			if (skb)
+				tipc_rcv(net, skb, b);
+			continue;
+		}
 
-out_node_put:
-	tipc_node_put(n);
-discard:
-	kfree_skb(skb);
+		addr = msg_prevnode(buf_msg(skb));
+		n = tipc_node_find(net, addr);
+		if (unlikely(!n)) {
+			kfree_skb(skb);
+			continue;
+		}
+		bcl = n->bc_entry.link;
+		le = &n->links[bearer_id];
+
+		tipc_node_read_lock(n);
+		if (unlikely(n->state != SELF_UP_PEER_UP ||
+			     tipc_link_acked(bcl) != msg_bcast_ack(buf_msg(skb)))) {
+			tipc_node_read_unlock(n);
+			tipc_node_put(n);
+			tipc_rcv(net, skb, b);
+			continue;
+		}
+		spin_lock_bh(&le->lock);
+		if (unlikely(!le->link)) {
+			spin_unlock_bh(&le->lock);
+			tipc_node_read_unlock(n);
+			tipc_node_put(n);
+			tipc_rcv(net, skb, b);
+			continue;
+		}
+
+		__skb_queue_head_init(&xmitq);
+		rc = 0;
+		while (skb) {
+			rc |= tipc_link_rcv(le->link, skb, &xmitq);
+			if (rc & (TIPC_LINK_UP_EVT | TIPC_LINK_DOWN_EVT))
+				break;
+
+			/* Keep going while the next packet is for this link */
+			skb = __skb_dequeue(list);
+			if (!skb)
+				break;
+			if (!tipc_rcv_batchable(&skb, self) ||
+			    msg_prevnode(buf_msg(skb)) != addr ||
+			    tipc_link_acked(bcl) != msg_bcast_ack(buf_msg(skb))) {
+				if (skb)
+					__skb_queue_head(list, skb);
+				break;
+			}
+		}
+		spin_unlock_bh(&le->lock);
+		tipc_node_read_unlock(n);
+
+		tipc_node_rcv_done(net, n, bearer_id, rc, &xmitq);
+		tipc_node_put(n);
+	}
 }
 
 void tipc_node_apply_property(struct net *net, struct tipc_bearer *b,
@@ -253,6 +253,9 @@ static void tls_device_resync_tx(struct sock *sk, struct tls_context *tls_ctx,
 	if (err)
 		return;
 
+	WRITE_ONCE(tls_offload_ctx_tx(tls_ctx)->resyncs,
+		   tls_offload_ctx_tx(tls_ctx)->resyncs + 1);
+	TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSTXDEVICERESYNC);
 	clear_bit_unlock(TLS_TX_SYNC_SCHED, &tls_ctx->flags);
 }
 
@@ -707,6 +710,7 @@ static void tls_device_resync_rx(struct tls_context *tls_ctx,
 		netdev->tlsdev_ops->tls_dev_resync(netdev, sk, seq, rcd_sn,
 						   TLS_OFFLOAD_CTX_DIR_RX);
 	rcu_read_unlock();
+	WRITE_ONCE(rx_ctx->resyncs, rx_ctx->resyncs + 1);
 	TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXDEVICERESYNC);
 }
 
@@ -417,6 +417,13 @@ static struct sk_buff *tls_sw_fallback(struct sock *sk, struct sk_buff *skb)
 	}
 
 	nskb = tls_enc_skb(tls_ctx, sg_out, sg_in, skb, sync_size, rcd_sn);
+	if (nskb) {
+		/* may run on several Tx queues at once, these are estimates */
+		WRITE_ONCE(ctx->fallback_pkts, ctx->fallback_pkts + 1);
+		WRITE_ONCE(ctx->fallback_bytes,
+			   ctx->fallback_bytes + payload_len);
+		TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSTXDEVICEFALLBACK);
+	}
 
 put_sg:
 	while (resync_sgs)
@@ -1011,6 +1011,37 @@ static u16 tls_user_config(struct tls_context *ctx, bool tx)
 	return 0;
 }
 
+static int tls_get_offload_info(struct tls_context *ctx, struct sk_buff *skb)
+{
+#ifdef CONFIG_TLS_DEVICE
+	int err;
+
+	if (ctx->tx_conf == TLS_HW) {
+		struct tls_offload_context_tx *tx = tls_offload_ctx_tx(ctx);
+
+		err = nla_put_uint(skb, TLS_INFO_TX_FALLBACK_PKTS,
+				   READ_ONCE(tx->fallback_pkts));
+		if (err)
+			return err;
+		err = nla_put_uint(skb, TLS_INFO_TX_FALLBACK_BYTES,
+				   READ_ONCE(tx->fallback_bytes));
+		if (err)
+			return err;
+		err = nla_put_u32(skb, TLS_INFO_TX_RESYNCS,
+				  READ_ONCE(tx->resyncs));
+		if (err)
+			return err;
+	}
+	if (ctx->rx_conf == TLS_HW) {
+		err = nla_put_u32(skb, TLS_INFO_RX_RESYNCS,
+				  READ_ONCE(tls_offload_ctx_rx(ctx)->resyncs));
+		if (err)
+			return err;
+	}
+#endif
+	return 0;
+}
+
 static int tls_get_info(struct sock *sk, struct sk_buff *skb)
 {
 	u16 version, cipher_type;
@@ -1058,6 +1089,9 @@ static int tls_get_info(struct sock *sk, struct sk_buff *skb)
 		if (err)
 			goto nla_failure;
 	}
+	err = tls_get_offload_info(ctx, skb);
+	if (err)
+		goto nla_failure;
 
 	rcu_read_unlock();
 	nla_nest_end(skb, start);
@@ -1080,6 +1114,10 @@ static size_t tls_get_info_size(const struct sock *sk)
 		nla_total_size(sizeof(u16)) +	/* TLS_INFO_TXCONF */
 		nla_total_size(0) +		/* TLS_INFO_ZC_RO_TX */
 		nla_total_size(0) +		/* TLS_INFO_RX_NO_PAD */
+		nla_total_size(sizeof(u64)) +	/* TLS_INFO_TX_FALLBACK_PKTS */
+		nla_total_size(sizeof(u64)) +	/* TLS_INFO_TX_FALLBACK_BYTES */
+		nla_total_size(sizeof(u32)) +	/* TLS_INFO_TX_RESYNCS */
+		nla_total_size(sizeof(u32)) +	/* TLS_INFO_RX_RESYNCS */
 		0;
 
 	return size;
@@ -22,6 +22,10 @@ static const struct snmp_mib tls_mib_list[] = {
 	SNMP_MIB_ITEM("TlsRxDeviceResync", LINUX_MIB_TLSRXDEVICERESYNC),
 	SNMP_MIB_ITEM("TlsDecryptRetry", LINUX_MIB_TLSDECRYPTRETRY),
 	SNMP_MIB_ITEM("TlsRxNoPadViolation", LINUX_MIB_TLSRXNOPADVIOL),
+	SNMP_MIB_ITEM("TlsRxAsync", LINUX_MIB_TLSRXASYNC),
+	SNMP_MIB_ITEM("TlsRxAsyncBusy", LINUX_MIB_TLSRXASYNCBUSY),
+	SNMP_MIB_ITEM("TlsTxDeviceResync", LINUX_MIB_TLSTXDEVICERESYNC),
+	SNMP_MIB_ITEM("TlsTxDeviceFallback", LINUX_MIB_TLSTXDEVICEFALLBACK),
 	SNMP_MIB_SENTINEL
 };
 
@@ -287,10 +287,14 @@ static int tls_do_decryption(struct sock *sk,
 	}
 
 	ret = crypto_aead_decrypt(aead_req);
-	if (ret == -EINPROGRESS)
+	if (ret == -EINPROGRESS) {
+		TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXASYNC);
 		return 0;
+	}
 
 	if (ret == -EBUSY) {
+		/* the backlog drains the whole pipeline, make it visible */
+		TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXASYNCBUSY);
 		ret = tls_decrypt_async_wait(ctx);
 		darg->async_done = true;
 		/* all completions have run, we're not doing async anymore */
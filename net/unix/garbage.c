@@ -532,8 +532,17 @@ static void unix_walk_scc(struct sk_buff_head *hitlist)
 	unix_graph_grouped = true;
 }
 
-static void unix_walk_scc_fast(struct sk_buff_head *hitlist)
+/* The fast path only revisits SCCs grouped by the last full walk, so it
+ * can drop unix_gc_lock between SCCs and let senders add edges.  Once
+ * anyone changes the graph the grouping is stale and the walk is retried.
+ */
+#define UNIX_GC_SCC_BATCH	64
+
+static bool unix_walk_scc_fast(struct sk_buff_head *hitlist)
 {
+	unsigned int nr_scc = 0;
+	bool done = true;
+
 	unix_graph_maybe_cyclic = false;
 
 	while (!list_empty(&unix_unvisited_vertices)) {
@@ -557,16 +566,35 @@ static void unix_walk_scc_fast(struct sk_buff_head *hitlist)
 			unix_graph_maybe_cyclic = unix_scc_cyclic(&scc);
 
 		list_del(&scc);
+
+		if (++nr_scc % UNIX_GC_SCC_BATCH ||
+		    list_empty(&unix_unvisited_vertices))
+			continue;
+
+		spin_unlock(&unix_gc_lock);
+		cond_resched();
+		spin_lock(&unix_gc_lock);
+
+		if (!unix_graph_grouped) {
+			/* unix_update_graph() has set unix_graph_maybe_cyclic */
+			done = false;
+			break;
+		}
 	}
 
-	list_replace_init(&unix_visited_vertices, &unix_unvisited_vertices);
+	list_splice_init(&unix_visited_vertices, &unix_unvisited_vertices);
+
+	return done;
 }
 
 static bool gc_in_progress;
+static void __unix_gc(struct work_struct *work);
+static DECLARE_WORK(unix_gc_work, __unix_gc);
 
 static void __unix_gc(struct work_struct *work)
 {
 	struct sk_buff_head hitlist;
+	bool requeue = false;
 	struct sk_buff *skb;
 
 	spin_lock(&unix_gc_lock);
@@ -579,7 +607,7 @@ static void __unix_gc(struct work_struct *work)
 	__skb_queue_head_init(&hitlist);
 
 	if (unix_graph_grouped)
-		unix_walk_scc_fast(&hitlist);
+		requeue = !unix_walk_scc_fast(&hitlist);
 	else
 		unix_walk_scc(&hitlist);
 
@@ -591,12 +619,16 @@ static void __unix_gc(struct work_struct *work)
 	}
 
 	__skb_queue_purge(&hitlist);
+
+	/* The graph changed under the fast path, regroup it from scratch. */
+	if (requeue) {
+		queue_work(system_unbound_wq, &unix_gc_work);
+		return;
+	}
 skip_gc:
 	WRITE_ONCE(gc_in_progress, false);
 }
 
-static DECLARE_WORK(unix_gc_work, __unix_gc);
-
 void unix_gc(void)
 {
 	WRITE_ONCE(gc_in_progress, true);
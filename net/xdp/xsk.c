@@ -782,13 +782,113 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/* Give the Tx descriptors of not yet sent packets back to user-space. */
+static void xsk_cancel_skbs(struct xdp_sock *xs, struct sk_buff **skbs,
+			    u32 nb_skbs)
+{
+	while (nb_skbs--) {
+		struct sk_buff *skb = skbs[nb_skbs];
+
+		xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
+		xsk_consume_skb(skb);
+	}
+}
+
+/* Hand a batch of complete packets to the driver under a single Tx queue
+ * lock, with xmit_more set on all but the last one like
+ * dev_hard_start_xmit() does. The packets must be the last ones consumed
+ * from the Tx ring so the unsent ones can be rewound for a retry.
+ */
+static int xsk_generic_xmit_batch(struct xdp_sock *xs, struct sk_buff **skbs,
+				  u32 nb_skbs, bool *sent_frame)
+{
+	struct net_device *dev = xs->dev;
+	int ret = NETDEV_TX_BUSY;
+	u32 nb_valid = 0, i = 0;
+	bool again = false;
+
+	if (!nb_skbs)
+		return 0;
+
+	if (likely(netif_running(dev) && netif_carrier_ok(dev))) {
+		for (; nb_valid < nb_skbs; nb_valid++) {
+			struct sk_buff *skb = skbs[nb_valid];
+			struct sk_buff *segs;
+
+			segs = validate_xmit_skb_list(skb, dev, &again);
+			if (segs != skb) {
+				kfree_skb_list(segs);
+				break;
+			}
+			skb_set_queue_mapping(skb, xs->queue_id);
+		}
+	} else {
+		kfree_skb(skbs[0]);
+	}
+
+	if (unlikely(nb_valid < nb_skbs)) {
+		/* SKB completed but not sent */
+		dev_core_stats_tx_dropped_inc(dev);
+		xsk_cancel_skbs(xs, skbs + nb_valid + 1, nb_skbs - nb_valid - 1);
+	}
+
+	if (nb_valid) {
+		struct netdev_queue *txq = skb_get_tx_queue(dev, skbs[0]);
+
+		local_bh_disable();
+		HARD_TX_LOCK(dev, txq, smp_processor_id());
+		if (!netif_xmit_frozen_or_drv_stopped(txq)) {
+			while (i < nb_valid) {
+				ret = netdev_start_xmit(skbs[i], dev, txq,
+							i + 1 < nb_valid);
+				if (ret == NETDEV_TX_BUSY)
+					break;
+				i++;
+				/* Ignore NET_XMIT_CN as packet might have been sent */
+				if (ret == NET_XMIT_DROP)
+					break;
+				if (i < nb_valid && netif_tx_queue_stopped(txq)) {
+					ret = NETDEV_TX_BUSY;
+					break;
+				}
+			}
+		}
+		HARD_TX_UNLOCK(dev, txq);
+		local_bh_enable();
+	}
+
+	if (i)
+		*sent_frame = true;
+
+	if (i < nb_valid) {
+		if (nb_valid == nb_skbs) {
+			xsk_cancel_skbs(xs, skbs + i, nb_valid - i);
+		} else {
+			/* Not at the tail of the Tx ring anymore, drop them */
+			for (; i < nb_valid; i++) {
+				dev_core_stats_tx_dropped_inc(dev);
+				kfree_skb(skbs[i]);
+			}
+		}
+	}
+
+	if (nb_valid < nb_skbs || ret == NET_XMIT_DROP)
+		return -EBUSY;
+	/* Tell user-space to retry the send */
+	if (i < nb_valid)
+		return -EAGAIN;
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
+	struct sk_buff *skbs[TX_BATCH_SIZE];
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
+	u32 nb_skbs = 0;
 	int err = 0;
 
 	mutex_lock(&xs->mutex);
@@ -808,6 +908,17 @@ static int __xsk_generic_xmit(struct sock *sk)
 			goto out;
 		}
 
+		/* Multi-buffer packets are sent on their own, so that a batch
+		 * always covers the last descriptors consumed from the Tx ring.
+		 */
+		if (!xs->skb && xp_mb_desc(&desc) && nb_skbs) {
+			err = xsk_generic_xmit_batch(xs, skbs, nb_skbs,
+						     &sent_frame);
+			nb_skbs = 0;
+			if (err)
+				goto out;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -832,27 +943,30 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
-		}
-
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
+		if (xs->skb) {
+			/* Last descriptor of a multi-buffer packet */
+			err = xsk_generic_xmit_batch(xs, &skb, 1, &sent_frame);
 			xs->skb = NULL;
-			goto out;
+			if (err)
+				goto out;
+			continue;
 		}
 
-		sent_frame = true;
-		xs->skb = NULL;
+		skbs[nb_skbs++] = skb;
+		if (nb_skbs == TX_BATCH_SIZE) {
+			err = xsk_generic_xmit_batch(xs, skbs, nb_skbs,
+						     &sent_frame);
+			nb_skbs = 0;
+			if (err)
+				goto out;
+		}
 	}
 
+	err = xsk_generic_xmit_batch(xs, skbs, nb_skbs, &sent_frame);
+	nb_skbs = 0;
+	if (err)
+		goto out;
+
 	if (xskq_has_descs(xs->tx)) {
 		if (xs->skb)
 			xsk_drop_skb(xs->skb);
@@ -860,6 +974,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (nb_skbs) {
+		int ret = xsk_generic_xmit_batch(xs, skbs, nb_skbs, &sent_frame);
+
+		if (ret)
+			err = ret;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
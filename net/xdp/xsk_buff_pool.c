@@ -623,22 +623,31 @@ static u32 xp_alloc_reused(struct xsk_buff_pool *pool, struct xdp_buff **xdp, u3
 	return nb_entries;
 }
 
-u32 xp_alloc_batch(struct xsk_buff_pool *pool, struct xdp_buff **xdp, u32 max)
+static void xp_alloc_sync_for_device(struct xsk_buff_pool *pool,
+				     struct xdp_buff **xdp, u32 nb_entries)
 {
-	u32 nb_entries1 = 0, nb_entries2;
-
-	if (unlikely(pool->dev && dma_dev_need_sync(pool->dev))) {
-		struct xdp_buff *buff;
+	while (nb_entries--) {
+		struct xdp_buff_xsk *xskb = container_of(*xdp++,
+							 struct xdp_buff_xsk,
+							 xdp);
 
-		/* Slow path */
-		buff = xp_alloc(pool);
-		if (buff)
-			*xdp = buff;
-		return !!buff;
+		xp_dma_sync_for_device(pool, xskb->dma, pool->frame_len);
 	}
+}
 
+u32 xp_alloc_batch(struct xsk_buff_pool *pool, struct xdp_buff **xdp, u32 max)
+{
+	bool need_sync = pool->dev && dma_dev_need_sync(pool->dev);
+	u32 nb_entries1 = 0, nb_entries2;
+
+	/*
+	 * Buffers are still pulled off the fill ring in one batch when the
+	 * device needs DMA syncs, they just get synced one by one afterwards.
+	 */
 	if (unlikely(pool->free_list_cnt)) {
 		nb_entries1 = xp_alloc_reused(pool, xdp, max);
+		if (unlikely(need_sync))
+			xp_alloc_sync_for_device(pool, xdp, nb_entries1);
 		if (nb_entries1 == max)
 			return nb_entries1;
 
@@ -649,6 +658,8 @@ u32 xp_alloc_batch(struct xsk_buff_pool *pool, struct xdp_buff **xdp, u32 max)
 	nb_entries2 = xp_alloc_new_from_fq(pool, xdp, max);
 	if (!nb_entries2)
 		pool->fq->queue_empty_descs++;
+	else if (unlikely(need_sync))
+		xp_alloc_sync_for_device(pool, xdp, nb_entries2);
 
 	return nb_entries1 + nb_entries2;
 }
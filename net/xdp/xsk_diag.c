@@ -78,14 +78,16 @@ static int xsk_diag_put_umem(const struct xdp_sock *xs, struct sk_buff *nlskb)
 
 static int xsk_diag_put_stats(const struct xdp_sock *xs, struct sk_buff *nlskb)
 {
+	struct xsk_queue *fq = xs->pool ? xs->pool->fq : NULL;
 	struct xdp_diag_stats du = {};
 
 	du.n_rx_dropped = xs->rx_dropped;
 	du.n_rx_invalid = xskq_nb_invalid_descs(xs->rx);
 	du.n_rx_full = xs->rx_queue_full;
-	du.n_fill_ring_empty = xs->pool ? xskq_nb_queue_empty_descs(xs->pool->fq) : 0;
+	du.n_fill_ring_empty = xskq_nb_queue_empty_descs(fq);
 	du.n_tx_invalid = xskq_nb_invalid_descs(xs->tx);
 	du.n_tx_ring_empty = xskq_nb_queue_empty_descs(xs->tx);
+	du.n_fill_ring_invalid = xskq_nb_invalid_descs(fq);
 	return nla_put(nlskb, XDP_DIAG_STATS, sizeof(du), &du);
 }
 
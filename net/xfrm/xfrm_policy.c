@@ -150,6 +150,31 @@ struct xfrm_pol_inexact_candidates {
 	struct hlist_head *res[XFRM_POL_CAND_MAX];
 };
 
+#define XFRM_POL_CACHE_SIZE	256
+
+struct xfrm_pol_cache_key {
+	xfrm_address_t		daddr;
+	xfrm_address_t		saddr;
+	u32			mark;
+	u32			if_id;
+	int			oif;
+	__be16			dport;
+	__be16			sport;
+	u16			family;
+	u8			proto;
+	u8			dir;
+};
+
+struct xfrm_pol_cache_entry {
+	struct xfrm_pol_cache_key	key;
+	unsigned int			genid;
+	struct xfrm_policy		*pol;
+};
+
+struct xfrm_pol_cache {
+	struct xfrm_pol_cache_entry	ent[XFRM_POL_CACHE_SIZE];
+};
+
 struct xfrm_flow_keys {
 	struct flow_dissector_key_basic basic;
 	struct flow_dissector_key_control control;
@@ -687,6 +712,15 @@ void xfrm_spd_getinfo(struct net *net, struct xfrmk_spdinfo *si)
 EXPORT_SYMBOL(xfrm_spd_getinfo);
 
 static DEFINE_MUTEX(hash_resize_mutex);
+
+static void xfrm_policy_cache_invalidate(struct net *net)
+{
+	lockdep_assert_held(&net->xfrm.xfrm_policy_lock);
+
+	/* pairs with smp_load_acquire() in xfrm_policy_lookup() */
+	smp_store_release(&net->xfrm.policy_genid, net->xfrm.policy_genid + 1);
+}
+
 static void xfrm_hash_resize(struct work_struct *work)
 {
 	struct net *net = container_of(work, struct net, xfrm.policy_hash_work);
@@ -1375,6 +1409,7 @@ static void xfrm_hash_rebuild(struct work_struct *work)
 
 out_unlock:
 	__xfrm_policy_inexact_flush(net);
+	xfrm_policy_cache_invalidate(net);
 	write_seqcount_end(&net->xfrm.xfrm_policy_hash_generation);
 	spin_unlock_bh(&net->xfrm.xfrm_policy_lock);
 
@@ -2235,9 +2270,9 @@ static struct xfrm_policy *xfrm_policy_lookup_bytype(struct net *net, u8 type,
 	return ret;
 }
 
-static struct xfrm_policy *xfrm_policy_lookup(struct net *net,
-					      const struct flowi *fl,
-					      u16 family, u8 dir, u32 if_id)
+static struct xfrm_policy *__xfrm_policy_lookup(struct net *net,
+						const struct flowi *fl,
+						u16 family, u8 dir, u32 if_id)
 {
 #ifdef CONFIG_XFRM_SUB_POLICY
 	struct xfrm_policy *pol;
@@ -2251,6 +2286,95 @@ static struct xfrm_policy *xfrm_policy_lookup(struct net *net,
 					 dir, if_id);
 }
 
+static bool xfrm_pol_cache_key_init(struct xfrm_pol_cache_key *key,
+				    const struct flowi *fl,
+				    u16 family, u8 dir, u32 if_id)
+{
+	const union flowi_uli *uli;
+
+	switch (family) {
+	case AF_INET:
+		uli = &fl->u.ip4.uli;
+		break;
+	case AF_INET6:
+		uli = &fl->u.ip6.uli;
+		break;
+	default:
+		return false;
+	}
+
+	memset(key, 0, sizeof(*key));
+	xfrm_flowi_addr_get(fl, &key->saddr, &key->daddr, family);
+	key->mark = fl->flowi_mark;
+	key->if_id = if_id;
+	key->oif = fl->flowi_oif;
+	key->dport = xfrm_flowi_dport(fl, uli);
+	key->sport = xfrm_flowi_sport(fl, uli);
+	key->family = family;
+	key->proto = fl->flowi_proto;
+	key->dir = dir;
+	return true;
+}
+
+static struct xfrm_pol_cache_entry *
+xfrm_pol_cache_slot(struct net *net, const struct xfrm_pol_cache_key *key)
+{
+	struct xfrm_pol_cache *c = this_cpu_ptr(net->xfrm.policy_cache);
+	u32 hash = jhash2((const u32 *)key, sizeof(*key) / sizeof(u32), 0);
+
+	return &c->ent[hash & (XFRM_POL_CACHE_SIZE - 1)];
+}
+
+/* Result of the bydst/inexact walk for a flow, including "no policy", is
+ * remembered per cpu until the next policy insert or delete in @net.
+ * Flows carrying a security label and namespaces with labeled policies
+ * bypass the cache, as the LSM verdict is not part of the key.
+ */
+static struct xfrm_policy *xfrm_policy_lookup(struct net *net,
+					      const struct flowi *fl,
+					      u16 family, u8 dir, u32 if_id)
+{
+	struct xfrm_pol_cache_entry *e;
+	struct xfrm_pol_cache_key key;
+	struct xfrm_policy *pol;
+	unsigned int genid;
+
+	if (fl->flowi_secid || READ_ONCE(net->xfrm.policy_sec_count) ||
+	    !xfrm_pol_cache_key_init(&key, fl, family, dir, if_id))
+		return __xfrm_policy_lookup(net, fl, family, dir, if_id);
+
+	rcu_read_lock();
+	genid = smp_load_acquire(&net->xfrm.policy_genid);
+
+	local_bh_disable();
+	e = xfrm_pol_cache_slot(net, &key);
+	if (e->genid == genid && !memcmp(&e->key, &key, sizeof(key))) {
+		pol = e->pol;
+		if (!pol || xfrm_pol_hold_rcu(pol)) {
+			local_bh_enable();
+			rcu_read_unlock();
+			XFRM_INC_STATS(net, LINUX_MIB_XFRMPOLCACHEHIT);
+			return pol;
+		}
+	}
+	local_bh_enable();
+
+	XFRM_INC_STATS(net, LINUX_MIB_XFRMPOLCACHEMISS);
+	pol = __xfrm_policy_lookup(net, fl, family, dir, if_id);
+	if (!IS_ERR(pol)) {
+		/* a stale genid just makes this entry miss next time */
+		local_bh_disable();
+		e = xfrm_pol_cache_slot(net, &key);
+		e->key = key;
+		e->pol = pol;
+		e->genid = genid;
+		local_bh_enable();
+	}
+	rcu_read_unlock();
+
+	return pol;
+}
+
 static struct xfrm_policy *xfrm_sk_policy_lookup(const struct sock *sk, int dir,
 						 const struct flowi *fl,
 						 u16 family, u32 if_id)
@@ -2300,6 +2424,13 @@ static void __xfrm_policy_link(struct xfrm_policy *pol, int dir)
 
 	list_add(&pol->walk.all, &net->xfrm.policy_all);
 	net->xfrm.policy_count[dir]++;
+	/* socket policies are not hashed and never cached */
+	if (dir < XFRM_POLICY_MAX) {
+		if (pol->security)
+			WRITE_ONCE(net->xfrm.policy_sec_count,
+				   net->xfrm.policy_sec_count + 1);
+		xfrm_policy_cache_invalidate(net);
+	}
 	xfrm_pol_hold(pol);
 }
 
@@ -2320,6 +2451,12 @@ static struct xfrm_policy *__xfrm_policy_unlink(struct xfrm_policy *pol,
 
 	list_del_init(&pol->walk.all);
 	net->xfrm.policy_count[dir]--;
+	if (dir < XFRM_POLICY_MAX) {
+		if (pol->security)
+			WRITE_ONCE(net->xfrm.policy_sec_count,
+				   net->xfrm.policy_sec_count - 1);
+		xfrm_policy_cache_invalidate(net);
+	}
 
 	return pol;
 }
@@ -4181,6 +4318,13 @@ static int __net_init xfrm_policy_init(struct net *net)
 		goto out_byidx;
 	net->xfrm.policy_idx_hmask = hmask;
 
+	net->xfrm.policy_cache = alloc_percpu(struct xfrm_pol_cache);
+	if (!net->xfrm.policy_cache)
+		goto out_cache;
+	/* zeroed entries must never look valid */
+	net->xfrm.policy_genid = 1;
+	net->xfrm.policy_sec_count = 0;
+
 	for (dir = 0; dir < XFRM_POLICY_MAX; dir++) {
 		struct xfrm_policy_hash *htab;
 
@@ -4218,6 +4362,8 @@ static int __net_init xfrm_policy_init(struct net *net)
 		htab = &net->xfrm.policy_bydst[dir];
 		xfrm_hash_free(htab->table, sz);
 	}
+	free_percpu(net->xfrm.policy_cache);
+out_cache:
 	xfrm_hash_free(net->xfrm.policy_byidx, sz);
 out_byidx:
 	return -ENOMEM;
@@ -4252,6 +4398,8 @@ static void xfrm_policy_fini(struct net *net)
 	WARN_ON(!hlist_empty(net->xfrm.policy_byidx));
 	xfrm_hash_free(net->xfrm.policy_byidx, sz);
 
+	free_percpu(net->xfrm.policy_cache);
+
 	spin_lock_bh(&net->xfrm.xfrm_policy_lock);
 	list_for_each_entry_safe(b, t, &net->xfrm.inexact_bins, inexact_bins)
 		__xfrm_policy_inexact_prune_bin(b, true);
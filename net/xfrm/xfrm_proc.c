@@ -43,6 +43,8 @@ static const struct snmp_mib xfrm_mib_list[] = {
 	SNMP_MIB_ITEM("XfrmAcquireError", LINUX_MIB_XFRMACQUIREERROR),
 	SNMP_MIB_ITEM("XfrmOutStateDirError", LINUX_MIB_XFRMOUTSTATEDIRERROR),
 	SNMP_MIB_ITEM("XfrmInStateDirError", LINUX_MIB_XFRMINSTATEDIRERROR),
+	SNMP_MIB_ITEM("XfrmPolCacheHit", LINUX_MIB_XFRMPOLCACHEHIT),
+	SNMP_MIB_ITEM("XfrmPolCacheMiss", LINUX_MIB_XFRMPOLCACHEMISS),
 	SNMP_MIB_SENTINEL
 };
 
@@ -677,6 +677,7 @@ struct xfrm_state *xfrm_state_alloc(struct net *net)
 		x->lft.hard_packet_limit = XFRM_INF;
 		x->replay_maxage = 0;
 		x->replay_maxdiff = 0;
+		x->pcpu_num = UINT_MAX;
 		spin_lock_init(&x->lock);
 	}
 	return x;
@@ -1094,7 +1095,7 @@ static void xfrm_hash_grow_check(struct net *net, int have_hash_collision)
 static void xfrm_state_look_at(struct xfrm_policy *pol, struct xfrm_state *x,
 			       const struct flowi *fl, unsigned short family,
 			       struct xfrm_state **best, int *acq_in_progress,
-			       int *error)
+			       int *error, unsigned int pcpu_id)
 {
 	/* Resolution logic:
 	 * 1. There is a valid state with matching selector. Done.
@@ -1106,7 +1107,13 @@ static void xfrm_state_look_at(struct xfrm_policy *pol, struct xfrm_state *x,
 	 *    only session which triggered previous resolution. Key
 	 *    manager will do something to install a state with proper
 	 *    selector.
+	 *
+	 * States pinned to another cpu are ignored, a state pinned to
+	 * this cpu is preferred over an unpinned one.
 	 */
+	if (x->pcpu_num != UINT_MAX && x->pcpu_num != pcpu_id)
+		return;
+
 	if (x->km.state == XFRM_STATE_VALID) {
 		if ((x->sel.family &&
 		     (x->sel.family != family ||
@@ -1116,6 +1123,7 @@ static void xfrm_state_look_at(struct xfrm_policy *pol, struct xfrm_state *x,
 			return;
 
 		if (!*best ||
+		    ((*best)->pcpu_num == UINT_MAX && x->pcpu_num == pcpu_id) ||
 		    (*best)->km.dying > x->km.dying ||
 		    ((*best)->km.dying == x->km.dying &&
 		     (*best)->curlft.add_time < x->curlft.add_time))
@@ -1142,16 +1150,20 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 	static xfrm_address_t saddr_wildcard = { };
 	struct net *net = xp_net(pol);
 	unsigned int h, h_wildcard;
-	struct xfrm_state *x, *x0, *to_put;
+	struct xfrm_state *x, *x0, *to_put, *fallback;
 	int acquire_in_progress = 0;
 	int error = 0;
 	struct xfrm_state *best = NULL;
 	u32 mark = pol->mark.v & pol->mark.m;
 	unsigned short encap_family = tmpl->encap_family;
 	unsigned int sequence;
+	unsigned int pcpu_id;
 	struct km_event c;
 
 	to_put = NULL;
+	fallback = NULL;
+	/* only used as a lookup key, it does not need to stay stable */
+	pcpu_id = raw_smp_processor_id();
 
 	sequence = read_seqcount_begin(&net->xfrm.xfrm_state_hash_generation);
 
@@ -1185,7 +1197,8 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 		    tmpl->id.proto == x->id.proto &&
 		    (tmpl->id.spi == x->id.spi || !tmpl->id.spi))
 			xfrm_state_look_at(pol, x, fl, family,
-					   &best, &acquire_in_progress, &error);
+					   &best, &acquire_in_progress, &error,
+					   pcpu_id);
 	}
 	if (best || acquire_in_progress)
 		goto found;
@@ -1219,11 +1232,20 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 		    tmpl->id.proto == x->id.proto &&
 		    (tmpl->id.spi == x->id.spi || !tmpl->id.spi))
 			xfrm_state_look_at(pol, x, fl, family,
-					   &best, &acquire_in_progress, &error);
+					   &best, &acquire_in_progress, &error,
+					   pcpu_id);
 	}
 
 found:
 	x = best;
+	if (x && (pol->flags & XFRM_POLICY_CPU_ACQUIRE) &&
+	    x->pcpu_num != pcpu_id) {
+		/* Keep using the unpinned SA while the KM negotiates one
+		 * for this cpu.
+		 */
+		fallback = x;
+		x = NULL;
+	}
 	if (!x && !error && !acquire_in_progress) {
 		if (tmpl->id.spi &&
 		    (x0 = __xfrm_state_lookup_all(net, mark, daddr,
@@ -1255,6 +1277,8 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 		xfrm_init_tempstate(x, fl, tmpl, daddr, saddr, family);
 		memcpy(&x->mark, &pol->mark, sizeof(x->mark));
 		x->if_id = if_id;
+		if (pol->flags & XFRM_POLICY_CPU_ACQUIRE)
+			x->pcpu_num = pcpu_id;
 
 		error = security_xfrm_state_alloc_acquire(x, pol->security, fl->flowi_secid);
 		if (error) {
@@ -1336,6 +1360,8 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 		}
 	}
 out:
+	if (fallback && (!x || x->km.state != XFRM_STATE_VALID))
+		x = fallback;
 	if (x) {
 		if (!xfrm_state_hold_rcu(x)) {
 			*err = -EAGAIN;
@@ -1472,6 +1498,8 @@ static void __xfrm_state_bump_genids(struct xfrm_state *xnew)
 		    x->props.reqid	== reqid &&
 		    x->if_id		== if_id &&
 		    (mark & x->mark.m) == x->mark.v &&
+		    (x->pcpu_num == UINT_MAX ||
+		     x->pcpu_num == xnew->pcpu_num) &&
 		    xfrm_addr_equal(&x->id.daddr, &xnew->id.daddr, family) &&
 		    xfrm_addr_equal(&x->props.saddr, &xnew->props.saddr, family))
 			x->genid++;
@@ -1496,7 +1524,7 @@ static struct xfrm_state *__find_acq_core(struct net *net,
 					  u32 reqid, u32 if_id, u8 proto,
 					  const xfrm_address_t *daddr,
 					  const xfrm_address_t *saddr,
-					  int create)
+					  u32 pcpu_num, int create)
 {
 	unsigned int h = xfrm_dst_hash(net, daddr, saddr, reqid, family);
 	struct xfrm_state *x;
@@ -1509,6 +1537,7 @@ static struct xfrm_state *__find_acq_core(struct net *net,
 		    x->km.state     != XFRM_STATE_ACQ ||
 		    x->id.spi       != 0 ||
 		    x->id.proto	    != proto ||
+		    x->pcpu_num	    != pcpu_num ||
 		    (mark & x->mark.m) != x->mark.v ||
 		    !xfrm_addr_equal(&x->id.daddr, daddr, family) ||
 		    !xfrm_addr_equal(&x->props.saddr, saddr, family))
@@ -1608,7 +1637,8 @@ int xfrm_state_add(struct xfrm_state *x)
 	if (use_spi && !x1)
 		x1 = __find_acq_core(net, &x->mark, family, x->props.mode,
 				     x->props.reqid, x->if_id, x->id.proto,
-				     &x->id.daddr, &x->props.saddr, 0);
+				     &x->id.daddr, &x->props.saddr,
+				     x->pcpu_num, 0);
 
 	__xfrm_state_bump_genids(x);
 	__xfrm_state_insert(x);
@@ -1746,6 +1776,7 @@ static struct xfrm_state *xfrm_state_clone(struct xfrm_state *orig,
 	x->new_mapping = 0;
 	x->new_mapping_sport = 0;
 	x->dir = orig->dir;
+	x->pcpu_num = orig->pcpu_num;
 
 	return x;
 
@@ -2013,7 +2044,8 @@ xfrm_find_acq(struct net *net, const struct xfrm_mark *mark, u8 mode, u32 reqid,
 	struct xfrm_state *x;
 
 	spin_lock_bh(&net->xfrm.xfrm_state_lock);
-	x = __find_acq_core(net, mark, family, mode, reqid, if_id, proto, daddr, saddr, create);
+	x = __find_acq_core(net, mark, family, mode, reqid, if_id, proto, daddr,
+			    saddr, UINT_MAX, create);
 	spin_unlock_bh(&net->xfrm.xfrm_state_lock);
 
 	return x;
@@ -431,6 +431,13 @@ static int verify_newsa_info(struct xfrm_usersa_info *p,
 		}
 	}
 
+	if (attrs[XFRMA_SA_PCPU] &&
+	    nla_get_u32(attrs[XFRMA_SA_PCPU]) >= num_possible_cpus()) {
+		NL_SET_ERR_MSG(extack, "pCPU number too big");
+		err = -EINVAL;
+		goto out;
+	}
+
 	if (sa_dir == XFRM_SA_DIR_IN) {
 		if (p->flags & XFRM_STATE_NOPMTUDISC) {
 			NL_SET_ERR_MSG(extack, "Flag NOPMTUDISC should not be set for input SA");
@@ -833,6 +840,9 @@ static struct xfrm_state *xfrm_state_construct(struct net *net,
 	if (attrs[XFRMA_SA_DIR])
 		x->dir = nla_get_u8(attrs[XFRMA_SA_DIR]);
 
+	if (attrs[XFRMA_SA_PCPU])
+		x->pcpu_num = nla_get_u32(attrs[XFRMA_SA_PCPU]);
+
 	err = __xfrm_init_state(x, false, attrs[XFRMA_OFFLOAD_DEV], extack);
 	if (err)
 		goto error;
@@ -1286,8 +1296,13 @@ static int copy_to_user_state_extra(struct xfrm_state *x,
 		if (ret)
 			goto out;
 	}
-	if (x->dir)
+	if (x->dir) {
 		ret = nla_put_u8(skb, XFRMA_SA_DIR, x->dir);
+		if (ret)
+			goto out;
+	}
+	if (x->pcpu_num != UINT_MAX)
+		ret = nla_put_u32(skb, XFRMA_SA_PCPU, x->pcpu_num);
 out:
 	return ret;
 }
@@ -2218,6 +2233,8 @@ static int dump_one_policy(struct xfrm_policy *xp, int dir, int count, void *ptr
 		err = xfrm_if_id_put(skb, xp->if_id);
 	if (!err && xp->xdo.dev)
 		err = copy_user_offload(&xp->xdo, skb);
+	if (!err && x->pcpu_num != UINT_MAX)
+		err = nla_put_u32(skb, XFRMA_SA_PCPU, x->pcpu_num);
 	if (err) {
 		nlmsg_cancel(skb, nlh);
 		return err;
@@ -3165,6 +3182,7 @@ const struct nla_policy xfrma_policy[XFRMA_MAX+1] = {
 	[XFRMA_IF_ID]		= { .type = NLA_U32 },
 	[XFRMA_MTIMER_THRESH]   = { .type = NLA_U32 },
 	[XFRMA_SA_DIR]          = NLA_POLICY_RANGE(NLA_U8, XFRM_SA_DIR_IN, XFRM_SA_DIR_OUT),
+	[XFRMA_SA_PCPU]		= { .type = NLA_U32 },
 };
 EXPORT_SYMBOL_GPL(xfrma_policy);
 
@@ -3474,6 +3492,9 @@ static inline unsigned int xfrm_sa_len(struct xfrm_state *x)
 	if (x->dir)
 		l += nla_total_size(sizeof(x->dir));
 
+	if (x->pcpu_num != UINT_MAX)
+		l += nla_total_size(sizeof(x->pcpu_num));
+
 	return l;
 }
 
@@ -3567,6 +3588,7 @@ static inline unsigned int xfrm_acquire_msgsize(struct xfrm_state *x,
 	       + nla_total_size(sizeof(struct xfrm_user_tmpl) * xp->xfrm_nr)
 	       + nla_total_size(sizeof(struct xfrm_mark))
 	       + nla_total_size(xfrm_user_sec_ctx_size(x->security))
+	       + nla_total_size(sizeof(x->pcpu_num))
 	       + userpolicy_type_attrsize();
 }
 
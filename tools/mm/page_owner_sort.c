@@ -7,6 +7,9 @@
  * ./page_owner_sort page_owner_full.txt sorted_page_owner.txt
  * Or sort by total memory:
  * ./page_owner_sort -m page_owner_full.txt sorted_page_owner.txt
+ * Or aggregate the stacks of a sampling mode kernel (page_owner_sample=N):
+ * cat /sys/kernel/debug/page_owner_stacks/stacks_bin > stacks.bin
+ * ./page_owner_sort -b stacks.bin sorted_stacks.txt
  *
  * See Documentation/mm/page_owner.rst
 */
@@ -103,6 +106,41 @@ static int cull;
 static int filter;
 static bool debug_on;
 
+/* Layout of page_owner_stacks/stacks_bin, see mm/page_owner.c */
+#define STACKS_BIN_MAGIC	0x504f5354
+#define STACKS_BIN_VERSION	1
+#define STACKS_BIN_MAX_ENTRIES	64
+
+struct stacks_bin_hdr {
+	__u32 magic;
+	__u32 version;
+	__u32 sample_interval;
+	__u32 max_entries;
+	__u64 stack_bytes;
+	__u64 stacks_dropped;
+};
+
+struct stacks_bin_rec {
+	__u64 nr_base_pages;
+	__u32 handle;
+	__u32 nr_entries;
+};
+
+struct bin_stack {
+	__u64 nr_base_pages;
+	__u32 handle;
+	__u32 nr_entries;
+	__u64 entries[STACKS_BIN_MAX_ENTRIES];
+};
+
+struct ksym {
+	__u64 addr;
+	char *name;
+};
+
+static struct ksym *ksyms;
+static int nr_ksyms;
+
 static void set_single_cmp(int (*cmp)(const void *, const void *), int sign);
 
 int read_block(char *buf, char *ext_buf, int buf_size, FILE *fin)
@@ -629,12 +667,157 @@ static void print_allocator(FILE *out, int allocator)
 		fprintf(out, "OTHERS ");
 }
 
+static int compare_ksym(const void *p1, const void *p2)
+{
+	const struct ksym *s1 = p1, *s2 = p2;
+
+	return s1->addr < s2->addr ? -1 : s1->addr > s2->addr;
+}
+
+/* Without kallsyms (or with kptr_restrict) the raw addresses get printed */
+static void load_kallsyms(void)
+{
+	char line[512], name[256], type;
+	unsigned long long addr;
+	int max = 0;
+	FILE *f;
+
+	f = fopen("/proc/kallsyms", "r");
+	if (!f)
+		return;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%llx %c %255s", &addr, &type, name) != 3 || !addr)
+			continue;
+		if (nr_ksyms == max) {
+			struct ksym *tmp;
+
+			max = max ? max * 2 : 65536;
+			tmp = realloc(ksyms, max * sizeof(*ksyms));
+			if (!tmp)
+				break;
+			ksyms = tmp;
+		}
+		ksyms[nr_ksyms].addr = addr;
+		ksyms[nr_ksyms].name = strdup(name);
+		if (!ksyms[nr_ksyms].name)
+			break;
+		nr_ksyms++;
+	}
+	fclose(f);
+
+	qsort(ksyms, nr_ksyms, sizeof(*ksyms), compare_ksym);
+}
+
+static void print_ksym(FILE *out, __u64 addr)
+{
+	int lo = 0, hi = nr_ksyms - 1, mid;
+
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		if (ksyms[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	if (hi < 0)
+		fprintf(out, " 0x%llx\n", (unsigned long long)addr);
+	else
+		fprintf(out, " %s+0x%llx\n", ksyms[hi].name,
+			(unsigned long long)(addr - ksyms[hi].addr));
+}
+
+static int compare_bin_pages(const void *p1, const void *p2)
+{
+	const struct bin_stack *s1 = p1, *s2 = p2;
+
+	return s1->nr_base_pages < s2->nr_base_pages ? 1 :
+	       -(s1->nr_base_pages > s2->nr_base_pages);
+}
+
+/*
+ * Aggregate the binary stack stream of page_owner_stacks/stacks_bin: scale
+ * the sampled page counts back up and print the stacks by estimated pages.
+ */
+static int read_stacks_bin(FILE *fin, FILE *fout)
+{
+	struct stacks_bin_hdr hdr;
+	struct stacks_bin_rec rec;
+	struct bin_stack *stacks = NULL, *tmp;
+	unsigned long long total = 0;
+	int i, nr = 0, max = 0;
+	unsigned int j;
+
+	if (fread(&hdr, sizeof(hdr), 1, fin) != 1 ||
+	    hdr.magic != STACKS_BIN_MAGIC || hdr.version != STACKS_BIN_VERSION) {
+		fprintf(stderr, "not a page_owner stacks_bin stream\n");
+		return 1;
+	}
+	if (!hdr.sample_interval)
+		hdr.sample_interval = 1;
+
+	while (fread(&rec, sizeof(rec), 1, fin) == 1) {
+		if (rec.nr_entries > STACKS_BIN_MAX_ENTRIES) {
+			fprintf(stderr, "bad stack of %u entries\n", rec.nr_entries);
+			goto out_free;
+		}
+		if (nr == max) {
+			max = max ? max * 2 : 1024;
+			tmp = realloc(stacks, max * sizeof(*stacks));
+			if (!tmp) {
+				fprintf(stderr, "Out of memory\n");
+				goto out_free;
+			}
+			stacks = tmp;
+		}
+		stacks[nr].nr_base_pages = rec.nr_base_pages * hdr.sample_interval;
+		stacks[nr].handle = rec.handle;
+		stacks[nr].nr_entries = rec.nr_entries;
+		if (fread(stacks[nr].entries, sizeof(__u64), rec.nr_entries, fin) !=
+		    rec.nr_entries) {
+			fprintf(stderr, "truncated stacks_bin stream\n");
+			goto out_free;
+		}
+		total += stacks[nr].nr_base_pages;
+		nr++;
+	}
+
+	printf("loaded %d\n", nr);
+	load_kallsyms();
+	qsort(stacks, nr, sizeof(*stacks), compare_bin_pages);
+
+	fprintf(fout, "%d stacks, ~%llu pages, sampled 1/%u, %llu bytes of stacks, %llu stacks dropped\n\n",
+		nr, total, hdr.sample_interval,
+		(unsigned long long)hdr.stack_bytes,
+		(unsigned long long)hdr.stacks_dropped);
+	for (i = 0; i < nr; i++) {
+		fprintf(fout, "~%llu pages, handle %u:\n",
+			(unsigned long long)stacks[i].nr_base_pages,
+			stacks[i].handle);
+		for (j = 0; j < stacks[i].nr_entries; j++)
+			print_ksym(fout, stacks[i].entries[j]);
+		fprintf(fout, "\n");
+	}
+
+	for (i = 0; i < nr_ksyms; i++)
+		free(ksyms[i].name);
+	free(ksyms);
+	free(stacks);
+	return 0;
+
+out_free:
+	free(stacks);
+	return 1;
+}
+
 #define BUF_SIZE	(128 * 1024)
 
 static void usage(void)
 {
 	printf("Usage: ./page_owner_sort [OPTIONS] <input> <output>\n"
 		"-a\t\t\tSort by memory allocation time.\n"
+		"-b\t\t\tAggregate a page_owner_stacks/stacks_bin stream.\n"
 		"-m\t\t\tSort by total memory.\n"
 		"-n\t\t\tSort by task command name.\n"
 		"-p\t\t\tSort by pid.\n"
@@ -662,6 +845,7 @@ int main(int argc, char **argv)
 	FILE *fin, *fout;
 	char *buf, *ext_buf;
 	int i, count, compare_flag;
+	bool binary = false;
 	struct stat st;
 	int opt;
 	struct option longopts[] = {
@@ -675,11 +859,14 @@ int main(int argc, char **argv)
 
 	compare_flag = COMP_NO_FLAG;
 
-	while ((opt = getopt_long(argc, argv, "admnpstP", longopts, NULL)) != -1)
+	while ((opt = getopt_long(argc, argv, "abdmnpstP", longopts, NULL)) != -1)
 		switch (opt) {
 		case 'a':
 			compare_flag |= COMP_ALLOC;
 			break;
+		case 'b':
+			binary = true;
+			break;
 		case 'd':
 			debug_on = true;
 			break;
@@ -747,6 +934,22 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (binary) {
+		int ret;
+
+		fin = fopen(argv[optind], "rb");
+		fout = fopen(argv[optind + 1], "w");
+		if (!fin || !fout) {
+			usage();
+			perror("open: ");
+			exit(1);
+		}
+		ret = read_stacks_bin(fin, fout);
+		fclose(fin);
+		fclose(fout);
+		return ret;
+	}
+
 	/* Only one compare option is allowed, yet we also want handle the
 	 * default case were no option is provided, but we still want to
 	 * match the behavior of the -t option (compare by number of times
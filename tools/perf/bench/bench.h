@@ -49,6 +49,14 @@ int bench_uprobe_trace_printk(int argc, const char **argv);
 int bench_uprobe_empty_ret(int argc, const char **argv);
 int bench_uprobe_trace_printk_ret(int argc, const char **argv);
 int bench_pmu_scan(int argc, const char **argv);
+int bench_mm_page_alloc(int argc, const char **argv);
+int bench_mm_slab(int argc, const char **argv);
+int bench_mm_vmalloc(int argc, const char **argv);
+int bench_uring_nop(int argc, const char **argv);
+int bench_uring_read(int argc, const char **argv);
+int bench_uring_recv(int argc, const char **argv);
+int bench_packet_tpacket(int argc, const char **argv);
+int bench_packet_xsk(int argc, const char **argv);
 
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
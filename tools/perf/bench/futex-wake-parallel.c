@@ -45,8 +45,14 @@ struct thread_data {
 
 static unsigned int nwakes = 1;
 
-/* all threads will block on the same futex -- hash bucket chaos ;) */
-static u_int32_t futex = 0;
+/*
+ * all threads will block on the same futex -- hash bucket chaos ;)
+ * With --numa the futex value is followed by its node, see FUTEX2_NUMA.
+ */
+static struct {
+	u_int32_t val;
+	int32_t node;
+} futex __attribute__((aligned(8))) = { .val = 0, .node = FUTEX_NO_NODE };
 
 static pthread_t *blocked_worker;
 static bool done = false;
@@ -56,6 +62,7 @@ static pthread_barrier_t barrier;
 static struct stats waketime_stats, wakeup_stats;
 static unsigned int threads_starting;
 static int futex_flag = 0;
+static unsigned int futex2_flag = FUTEX2_SIZE_U32 | FUTEX2_NUMA;
 
 static struct bench_futex_parameters params;
 
@@ -65,6 +72,7 @@ static const struct option options[] = {
 	OPT_BOOLEAN( 's', "silent",  &params.silent, "Silent mode: do not display data/details"),
 	OPT_BOOLEAN( 'S', "shared",  &params.fshared, "Use shared futexes instead of private ones"),
 	OPT_BOOLEAN( 'm', "mlockall", &params.mlockall, "Lock all current and future memory"),
+	OPT_BOOLEAN( 'n', "numa", &params.numa, "Use FUTEX2_NUMA futexes through futex_wait/futex_wake(2)"),
 
 	OPT_END()
 };
@@ -74,6 +82,20 @@ static const char * const bench_futex_wake_parallel_usage[] = {
 	NULL
 };
 
+static int bench_futex_wait(void)
+{
+	if (params.numa)
+		return futex2_wait(&futex, 0, futex2_flag);
+	return futex_wait(&futex.val, 0, NULL, futex_flag);
+}
+
+static int bench_futex_wake(int nr)
+{
+	if (params.numa)
+		return futex2_wake(&futex, nr, futex2_flag);
+	return futex_wake(&futex.val, nr, futex_flag);
+}
+
 static void *waking_workerfn(void *arg)
 {
 	struct thread_data *waker = (struct thread_data *) arg;
@@ -83,7 +105,7 @@ static void *waking_workerfn(void *arg)
 
 	gettimeofday(&start, NULL);
 
-	waker->nwoken = futex_wake(&futex, nwakes, futex_flag);
+	waker->nwoken = bench_futex_wake(nwakes);
 	if (waker->nwoken != nwakes)
 		warnx("couldn't wakeup all tasks (%d/%d)",
 		      waker->nwoken, nwakes);
@@ -137,7 +159,7 @@ static void *blocked_workerfn(void *arg __maybe_unused)
 	mutex_unlock(&thread_lock);
 
 	while (1) { /* handle spurious wakeups */
-		if (futex_wait(&futex, 0, NULL, futex_flag) != EINTR)
+		if (bench_futex_wait() != EINTR)
 			break;
 	}
 
@@ -288,13 +310,15 @@ int bench_futex_wake_parallel(int argc, const char **argv)
 	if (!blocked_worker)
 		err(EXIT_FAILURE, "calloc");
 
-	if (!params.fshared)
+	if (!params.fshared) {
 		futex_flag = FUTEX_PRIVATE_FLAG;
+		futex2_flag |= FUTEX2_PRIVATE;
+	}
 
-	printf("Run summary [PID %d]: blocking on %d threads (at [%s] "
+	printf("Run summary [PID %d]: blocking on %d threads (at [%s%s] "
 	       "futex %p), %d threads waking up %d at a time.\n\n",
 	       getpid(), params.nthreads, params.fshared ? "shared":"private",
-	       &futex, params.nwakes, nwakes);
+	       params.numa ? " numa" : "", &futex, params.nwakes, nwakes);
 
 	init_stats(&wakeup_stats);
 	init_stats(&waketime_stats);
@@ -8,6 +8,7 @@
 #ifndef _FUTEX_H
 #define _FUTEX_H
 
+#include <errno.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -20,6 +21,7 @@ struct bench_futex_parameters {
 	bool multi; /* lock-pi */
 	bool pi; /* requeue-pi */
 	bool broadcast; /* requeue */
+	bool numa; /* wake-parallel */
 	unsigned int runtime; /* seconds*/
 	unsigned int nthreads;
 	unsigned int nfutexes;
@@ -143,4 +145,44 @@ futex_cmp_requeue_pi(u_int32_t *uaddr, u_int32_t val, u_int32_t *uaddr2,
 					val, opflags);
 }
 
+#ifndef FUTEX2_NUMA
+#define FUTEX2_SIZE_U32		0x02
+#define FUTEX2_NUMA		0x04
+#define FUTEX2_PRIVATE		FUTEX_PRIVATE_FLAG
+#endif
+
+#ifndef FUTEX_NO_NODE
+#define FUTEX_NO_NODE		(-1)
+#endif
+
+/**
+ * futex2_wait() - sys_futex_wait wrapper, block on uaddr without timeout
+ * @flags:	FUTEX2_ flags, with FUTEX2_NUMA uaddr is followed by the node
+ */
+static inline int
+futex2_wait(void *uaddr, unsigned long val, unsigned int flags)
+{
+#ifdef __NR_futex_wait
+	return syscall(__NR_futex_wait, uaddr, val, FUTEX_BITSET_MATCH_ANY,
+		       flags, NULL, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * futex2_wake() - sys_futex_wake wrapper, wake up to nr tasks blocked on uaddr
+ */
+static inline int
+futex2_wake(void *uaddr, int nr, unsigned int flags)
+{
+#ifdef __NR_futex_wake
+	return syscall(__NR_futex_wake, uaddr, FUTEX_BITSET_MATCH_ANY, nr, flags);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
 #endif /* _FUTEX_H */
@@ -0,0 +1,649 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * io_uring: submission/completion overhead of the io_uring interface
+ *
+ *  nop:  IORING_OP_NOP, i.e. the ring itself
+ *  read: IORING_OP_READ of --size blocks from a file in the page cache
+ *  recv: IORING_OP_SEND over a connected loopback UDP socket pair and
+ *        IORING_OP_RECV into buffers from a registered buffer ring,
+ *        latency is the time from the submission of a send until its
+ *        datagram completes a receive
+ *
+ * Every thread has its own ring with --depth requests in flight, and
+ * with --sqpoll the submissions are picked up by a kernel SQ thread
+ * instead of io_uring_enter().
+ *
+ * The rings are driven through the raw system calls so that neither the
+ * build nor the numbers depend on a liburing version.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <asm/barrier.h>
+#include <linux/compiler.h>
+#include <linux/io_uring.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <perf/cpumap.h>
+
+#include "../util/mutex.h"
+#include "../util/stat.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "latency.h"
+
+#include <err.h>
+
+#define URING_READ_FILE_SIZE	(64UL << 20)
+#define URING_BGID		0
+
+/* user_data: what completed and for which slot */
+#define URING_UD_SEND		(1ULL << 32)
+#define URING_UD_RECV		(2ULL << 32)
+#define URING_UD_SLOT(ud)	((unsigned int)(ud))
+
+static unsigned int nthreads;
+static unsigned int nsecs = 5;
+static unsigned int depth = 32;
+static unsigned int size = 4096;
+static unsigned int nsamples = 10000;
+static bool sqpoll, silent;
+
+static volatile bool done;
+static int read_fd = -1;
+static struct mutex thread_lock;
+static unsigned int threads_starting;
+static struct cond thread_parent, thread_worker;
+
+struct uring {
+	int fd;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring, *cq_ring;
+	size_t sq_ring_sz, cq_ring_sz, sqes_sz;
+	unsigned int sqe_tail;	/* prepared, not yet visible to the kernel */
+	unsigned int to_submit;
+};
+
+/* the payload of the recv benchmark */
+struct uring_msg {
+	u64 start;
+	u32 slot;
+};
+
+struct worker {
+	int tid;
+	pthread_t thread;
+	struct uring ring;
+	int fd, peer;	/* receiving and sending socket */
+	unsigned int seed;
+	u64 *start;	/* per slot */
+	char *bufs;	/* per slot, for recv the provided and then the send buffers */
+	struct io_uring_buf_ring *br;
+	size_t br_sz;
+	unsigned long ops;
+	unsigned long errors;
+	struct lat_samples lat;
+};
+
+struct uring_bench {
+	const char *name;
+	int (*setup)(struct worker *w);
+	void (*prep)(struct worker *w, unsigned int slot);
+	void (*complete)(struct worker *w, struct io_uring_cqe *cqe, u64 now);
+	void (*cleanup)(struct worker *w);
+};
+
+static const struct uring_bench *bench;
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads, "Specify amount of threads (default: online CPUs)"),
+	OPT_UINTEGER('r', "runtime", &nsecs, "Specify runtime (in seconds)"),
+	OPT_UINTEGER('d', "depth", &depth, "Requests in flight per ring"),
+	OPT_UINTEGER('S', "size", &size, "Bytes per read or per datagram"),
+	OPT_BOOLEAN( 'P', "sqpoll", &sqpoll, "Use a kernel SQ polling thread"),
+	OPT_UINTEGER('n', "samples", &nsamples, "Latency samples kept per thread"),
+	OPT_BOOLEAN( 's', "silent", &silent, "Silent mode: do not display per thread data"),
+	OPT_END()
+};
+
+static const char * const bench_uring_usage[] = {
+	"perf bench uring <nop|read|recv> <options>",
+	NULL
+};
+
+static int uring_setup(struct uring *r, unsigned int entries)
+{
+	struct io_uring_params p;
+	void *ptr;
+
+	memset(&p, 0, sizeof(p));
+	p.cq_entries = entries * 2;
+	p.flags = IORING_SETUP_CQSIZE;
+	if (sqpoll) {
+		p.flags |= IORING_SETUP_SQPOLL;
+		p.sq_thread_idle = 1000;
+	}
+
+	r->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (r->fd < 0)
+		return -1;
+
+	r->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_ring_sz = r->cq_ring_sz = max(r->sq_ring_sz, r->cq_ring_sz);
+	r->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	r->sq_ring = mmap(NULL, r->sq_ring_sz, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED)
+		goto err;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		r->cq_ring = r->sq_ring;
+	} else {
+		r->cq_ring = mmap(NULL, r->cq_ring_sz, PROT_READ | PROT_WRITE,
+				  MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (r->cq_ring == MAP_FAILED)
+			goto err_sq;
+	}
+
+	r->sqes = mmap(NULL, r->sqes_sz, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED)
+		goto err_cq;
+
+	ptr = r->sq_ring;
+	r->sq_head = ptr + p.sq_off.head;
+	r->sq_tail = ptr + p.sq_off.tail;
+	r->sq_mask = ptr + p.sq_off.ring_mask;
+	r->sq_flags = ptr + p.sq_off.flags;
+	r->sq_array = ptr + p.sq_off.array;
+
+	ptr = r->cq_ring;
+	r->cq_head = ptr + p.cq_off.head;
+	r->cq_tail = ptr + p.cq_off.tail;
+	r->cq_mask = ptr + p.cq_off.ring_mask;
+	r->cqes = ptr + p.cq_off.cqes;
+	r->sqe_tail = *r->sq_tail;
+	r->to_submit = 0;
+	return 0;
+
+err_cq:
+	if (r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_ring_sz);
+err_sq:
+	munmap(r->sq_ring, r->sq_ring_sz);
+err:
+	close(r->fd);
+	return -1;
+}
+
+static void uring_exit(struct uring *r)
+{
+	munmap(r->sqes, r->sqes_sz);
+	if (r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_ring_sz);
+	munmap(r->sq_ring, r->sq_ring_sz);
+	close(r->fd);
+}
+
+/* The ring is sized so that the in flight requests always fit */
+static struct io_uring_sqe *uring_get_sqe(struct uring *r)
+{
+	unsigned int idx = r->sqe_tail++ & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	r->sq_array[idx] = idx;
+	r->to_submit++;
+	return sqe;
+}
+
+/* Submit what has been prepared and wait for at least one completion */
+static int uring_submit_and_wait(struct uring *r)
+{
+	unsigned int flags = IORING_ENTER_GETEVENTS, submit = r->to_submit;
+
+	smp_store_release(r->sq_tail, r->sqe_tail);
+	r->to_submit = 0;
+
+	if (sqpoll) {
+		submit = 0;
+		if (READ_ONCE(*r->sq_flags) & IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+		/* the SQ thread may already have completed something */
+		else if (smp_load_acquire(r->cq_tail) != *r->cq_head)
+			return 0;
+	}
+
+	return syscall(__NR_io_uring_enter, r->fd, submit, 1, flags, NULL, 0);
+}
+
+static void uring_nop_prep(struct worker *w, unsigned int slot)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe(&w->ring);
+
+	sqe->opcode = IORING_OP_NOP;
+	sqe->user_data = slot;
+	w->start[slot] = lat_now_ns();
+}
+
+static void uring_op_complete(struct worker *w, struct io_uring_cqe *cqe, u64 now)
+{
+	unsigned int slot = URING_UD_SLOT(cqe->user_data);
+
+	if (cqe->res < 0) {
+		w->errors++;
+	} else {
+		w->ops++;
+		lat_add(&w->lat, now - w->start[slot]);
+	}
+	bench->prep(w, slot);
+}
+
+/* All threads read from the same file, which stays in the page cache */
+static int uring_read_file(void)
+{
+	char path[] = "/tmp/perf-bench-uring.XXXXXX";
+	size_t off;
+	char *buf;
+
+	read_fd = mkstemp(path);
+	if (read_fd < 0)
+		return -1;
+	unlink(path);
+
+	buf = malloc(1UL << 20);
+	if (!buf)
+		return -1;
+	memset(buf, 0xa5, 1UL << 20);
+	for (off = 0; off < URING_READ_FILE_SIZE; off += 1UL << 20) {
+		if (pwrite(read_fd, buf, 1UL << 20, off) != 1UL << 20) {
+			free(buf);
+			return -1;
+		}
+	}
+	free(buf);
+	return 0;
+}
+
+static int uring_read_setup(struct worker *w)
+{
+	if (size > URING_READ_FILE_SIZE)
+		return -1;
+	if (read_fd < 0 && uring_read_file())
+		return -1;
+
+	w->bufs = aligned_alloc(4096, (size_t)depth * size);
+	return w->bufs ? 0 : -1;
+}
+
+static void uring_read_prep(struct worker *w, unsigned int slot)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe(&w->ring);
+	unsigned long nr = URING_READ_FILE_SIZE / size;
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = read_fd;
+	sqe->addr = (unsigned long)(w->bufs + (size_t)slot * size);
+	sqe->len = size;
+	sqe->off = (u64)(rand_r(&w->seed) % nr) * size;
+	sqe->user_data = slot;
+	w->start[slot] = lat_now_ns();
+}
+
+static void uring_read_cleanup(struct worker *w)
+{
+	free(w->bufs);
+}
+
+static void uring_recv_arm(struct worker *w, u64 user_data)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe(&w->ring);
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = w->fd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BGID;
+	sqe->user_data = user_data;
+}
+
+static int uring_recv_setup(struct worker *w)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	socklen_t len = sizeof(addr);
+	struct io_uring_buf_reg reg;
+	int rcvbuf = 4 << 20;
+	unsigned int i;
+
+	if (size < sizeof(struct uring_msg))
+		size = sizeof(struct uring_msg);
+
+	w->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	w->peer = socket(AF_INET, SOCK_DGRAM, 0);
+	if (w->fd < 0 || w->peer < 0)
+		return -1;
+	setsockopt(w->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	if (bind(w->fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    getsockname(w->fd, (struct sockaddr *)&addr, &len) ||
+	    connect(w->peer, (struct sockaddr *)&addr, sizeof(addr)))
+		return -1;
+
+	/* a receive and a send buffer for every datagram in flight */
+	w->bufs = calloc(depth * 2, size);
+	w->br_sz = depth * sizeof(struct io_uring_buf);
+	w->br = mmap(NULL, w->br_sz, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (!w->bufs || w->br == MAP_FAILED)
+		return -1;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (unsigned long)w->br;
+	reg.ring_entries = depth;
+	reg.bgid = URING_BGID;
+	if (syscall(__NR_io_uring_register, w->ring.fd,
+		    IORING_REGISTER_PBUF_RING, &reg, 1))
+		return -1;
+
+	for (i = 0; i < depth; i++) {
+		w->br->bufs[i].addr = (unsigned long)(w->bufs + (size_t)i * size);
+		w->br->bufs[i].len = size;
+		w->br->bufs[i].bid = i;
+	}
+	smp_store_release(&w->br->tail, depth);
+
+	for (i = 0; i < depth; i++)
+		uring_recv_arm(w, URING_UD_RECV | i);
+	return 0;
+}
+
+/*
+ * The slot of a send is free again once its datagram has been received,
+ * the payload says which one that was.
+ */
+static void uring_recv_prep(struct worker *w, unsigned int slot)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe(&w->ring);
+	char *buf = w->bufs + (size_t)(depth + slot) * size;
+	struct uring_msg msg = {
+		.start = lat_now_ns(),
+		.slot = slot,
+	};
+
+	memcpy(buf, &msg, sizeof(msg));
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = w->peer;
+	sqe->addr = (unsigned long)buf;
+	sqe->len = size;
+	sqe->user_data = URING_UD_SEND | slot;
+}
+
+static void uring_recv_complete(struct worker *w, struct io_uring_cqe *cqe, u64 now)
+{
+	struct io_uring_buf *buf;
+	struct uring_msg msg;
+	unsigned int bid;
+
+	if (cqe->user_data & URING_UD_SEND) {
+		/* a lost send would shrink the depth */
+		if (cqe->res < 0) {
+			w->errors++;
+			uring_recv_prep(w, URING_UD_SLOT(cqe->user_data));
+		}
+		return;
+	}
+
+	if (cqe->res < (int)sizeof(msg) || !(cqe->flags & IORING_CQE_F_BUFFER)) {
+		w->errors++;
+		uring_recv_arm(w, cqe->user_data);
+		return;
+	}
+
+	bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	memcpy(&msg, w->bufs + (size_t)bid * size, sizeof(msg));
+	w->ops++;
+	lat_add(&w->lat, now - msg.start);
+
+	/* hand the buffer back, then receive and send again */
+	buf = &w->br->bufs[w->br->tail & (depth - 1)];
+	buf->addr = (unsigned long)(w->bufs + (size_t)bid * size);
+	buf->len = size;
+	buf->bid = bid;
+	smp_store_release(&w->br->tail, w->br->tail + 1);
+
+	uring_recv_arm(w, cqe->user_data);
+	if (msg.slot < depth)
+		uring_recv_prep(w, msg.slot);
+}
+
+static void uring_recv_cleanup(struct worker *w)
+{
+	close(w->fd);
+	close(w->peer);
+	munmap(w->br, w->br_sz);
+	free(w->bufs);
+}
+
+static const struct uring_bench uring_benches[] = {
+	{ "nop",  NULL,		    uring_nop_prep,  uring_op_complete,   NULL },
+	{ "read", uring_read_setup, uring_read_prep, uring_op_complete,   uring_read_cleanup },
+	{ "recv", uring_recv_setup, uring_recv_prep, uring_recv_complete, uring_recv_cleanup },
+};
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = (struct worker *)arg;
+	struct uring *r = &w->ring;
+	unsigned int head, tail, i;
+	u64 now;
+
+	for (i = 0; i < depth; i++)
+		bench->prep(w, i);
+
+	mutex_lock(&thread_lock);
+	threads_starting--;
+	if (!threads_starting)
+		cond_signal(&thread_parent);
+	cond_wait(&thread_worker, &thread_lock);
+	mutex_unlock(&thread_lock);
+
+	do {
+		if (uring_submit_and_wait(r) < 0 && errno != EINTR &&
+		    errno != EAGAIN && errno != EBUSY)
+			err(EXIT_FAILURE, "io_uring_enter");
+
+		head = *r->cq_head;
+		tail = smp_load_acquire(r->cq_tail);
+		now = lat_now_ns();
+		for (; head != tail; head++)
+			bench->complete(w, &r->cqes[head & *r->cq_mask], now);
+		smp_store_release(r->cq_head, head);
+	} while (!done);
+
+	return NULL;
+}
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	/* inform all threads that we're done for the day */
+	done = true;
+	gettimeofday(&bench__end, NULL);
+	timersub(&bench__end, &bench__start, &bench__runtime);
+}
+
+static int bench_uring(int argc, const char **argv, const struct uring_bench *b)
+{
+	struct perf_cpu_map *cpu;
+	struct stats throughput_stats;
+	struct worker *worker;
+	pthread_attr_t thread_attr;
+	struct sigaction act;
+	unsigned long errors = 0;
+	cpu_set_t *cpuset;
+	unsigned int i;
+	int ret, nrcpus;
+	size_t cpusz;
+
+	argc = parse_options(argc, argv, options, bench_uring_usage, 0);
+	if (argc || !depth || !size) {
+		usage_with_options(bench_uring_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	/* the provided buffer ring needs a power of 2 */
+	depth = rounddown_pow_of_two(depth);
+	bench = b;
+
+	cpu = perf_cpu_map__new_online_cpus();
+	if (!cpu)
+		err(EXIT_FAILURE, "perf_cpu_map__new_online_cpus");
+
+	memset(&act, 0, sizeof(act));
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	sigaction(SIGINT, &act, NULL);
+
+	if (!nthreads)
+		nthreads = perf_cpu_map__nr(cpu);
+
+	worker = calloc(nthreads, sizeof(*worker));
+	if (!worker)
+		err(EXIT_FAILURE, "calloc");
+
+	printf("Run summary [PID %d]: %d threads doing io_uring %s with %d requests in flight%s for %d secs.\n\n",
+	       getpid(), nthreads, b->name, depth, sqpoll ? " (SQPOLL)" : "", nsecs);
+
+	for (i = 0; i < nthreads; i++) {
+		worker[i].tid = i;
+		worker[i].seed = i + 1;
+		worker[i].start = calloc(depth, sizeof(u64));
+		if (!worker[i].start || lat_init(&worker[i].lat, nsamples, i + 1))
+			err(EXIT_FAILURE, "calloc");
+		/* the recv benchmark has twice as many requests in flight */
+		if (uring_setup(&worker[i].ring, depth * 2))
+			err(EXIT_FAILURE, "io_uring_setup");
+		if (b->setup && b->setup(&worker[i]))
+			err(EXIT_FAILURE, "%s setup", b->name);
+	}
+
+	init_stats(&throughput_stats);
+	mutex_init(&thread_lock);
+	cond_init(&thread_parent);
+	cond_init(&thread_worker);
+
+	threads_starting = nthreads;
+	pthread_attr_init(&thread_attr);
+
+	nrcpus = perf_cpu_map__nr(cpu);
+	cpuset = CPU_ALLOC(nrcpus);
+	BUG_ON(!cpuset);
+	cpusz = CPU_ALLOC_SIZE(nrcpus);
+
+	for (i = 0; i < nthreads; i++) {
+		CPU_ZERO_S(cpusz, cpuset);
+		CPU_SET_S(perf_cpu_map__cpu(cpu, i % nrcpus).cpu, cpusz, cpuset);
+		ret = pthread_attr_setaffinity_np(&thread_attr, cpusz, cpuset);
+		if (ret) {
+			CPU_FREE(cpuset);
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+		}
+		ret = pthread_create(&worker[i].thread, &thread_attr, workerfn,
+				     &worker[i]);
+		if (ret) {
+			CPU_FREE(cpuset);
+			err(EXIT_FAILURE, "pthread_create");
+		}
+	}
+	CPU_FREE(cpuset);
+	pthread_attr_destroy(&thread_attr);
+
+	mutex_lock(&thread_lock);
+	while (threads_starting)
+		cond_wait(&thread_parent, &thread_lock);
+	gettimeofday(&bench__start, NULL);
+	cond_broadcast(&thread_worker);
+	mutex_unlock(&thread_lock);
+
+	sleep(nsecs);
+	toggle_done(0, NULL, NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+
+	cond_destroy(&thread_parent);
+	cond_destroy(&thread_worker);
+	mutex_destroy(&thread_lock);
+
+	for (i = 0; i < nthreads; i++) {
+		unsigned long t = bench__runtime.tv_sec > 0 ?
+			worker[i].ops / bench__runtime.tv_sec : 0;
+
+		update_stats(&throughput_stats, t);
+		errors += worker[i].errors;
+		if (!silent)
+			printf("[thread %3d] %ld ops/sec, %ld errors\n",
+			       worker[i].tid, t, worker[i].errors);
+	}
+
+	printf("%sAveraged %.0f operations/sec per thread (+- %.2f%%), total secs = %d\n",
+	       !silent ? "\n" : "", avg_stats(&throughput_stats),
+	       rel_stddev_stats(stddev_stats(&throughput_stats),
+				avg_stats(&throughput_stats)),
+	       (int)bench__runtime.tv_sec);
+	if (errors)
+		printf("%lu failed requests\n", errors);
+	lat_print("request", &worker[0].lat, nthreads, sizeof(*worker));
+
+	for (i = 0; i < nthreads; i++) {
+		if (b->cleanup)
+			b->cleanup(&worker[i]);
+		uring_exit(&worker[i].ring);
+		lat_exit(&worker[i].lat);
+		free(worker[i].start);
+	}
+	free(worker);
+	if (read_fd >= 0)
+		close(read_fd);
+	perf_cpu_map__put(cpu);
+	return 0;
+}
+
+int bench_uring_nop(int argc, const char **argv)
+{
+	return bench_uring(argc, argv, &uring_benches[0]);
+}
+
+int bench_uring_read(int argc, const char **argv)
+{
+	return bench_uring(argc, argv, &uring_benches[1]);
+}
+
+int bench_uring_recv(int argc, const char **argv)
+{
+	return bench_uring(argc, argv, &uring_benches[2]);
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Per thread latency sampling for the benchmarks which report percentiles.
+ *
+ * Every thread keeps a bounded reservoir of samples, so that long runs
+ * neither grow without limit nor only keep their first seconds, and the
+ * reservoirs are merged and sorted once the run is over.
+ */
+#ifndef _BENCH_LATENCY_H
+#define _BENCH_LATENCY_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+
+struct lat_samples {
+	u64 *v;
+	unsigned long seen;
+	unsigned int max;
+	unsigned int seed;
+};
+
+static inline u64 lat_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline int lat_init(struct lat_samples *s, unsigned int max,
+			   unsigned int seed)
+{
+	s->seen = 0;
+	s->max = max;
+	s->seed = seed;
+	s->v = calloc(max ?: 1, sizeof(*s->v));
+	return s->v ? 0 : -1;
+}
+
+static inline void lat_exit(struct lat_samples *s)
+{
+	free(s->v);
+	s->v = NULL;
+}
+
+static inline void lat_add(struct lat_samples *s, u64 ns)
+{
+	unsigned long i = s->seen++;
+
+	if (!s->max)
+		return;
+	if (i >= s->max) {
+		i = rand_r(&s->seed) % (i + 1);
+		if (i >= s->max)
+			return;
+	}
+	s->v[i] = ns;
+}
+
+static inline unsigned long lat_nr(const struct lat_samples *s)
+{
+	return min(s->seen, (unsigned long)s->max);
+}
+
+static inline int lat_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Print the percentiles of the @nr reservoirs in @s, which are @stride bytes apart */
+static inline void lat_print(const char *what, const struct lat_samples *s,
+			     unsigned int nr, size_t stride)
+{
+	static const double pcts[] = { 50, 90, 99, 99.9 };
+	const struct lat_samples *t;
+	size_t total = 0, i, n;
+	u64 *all;
+
+	for (i = 0; i < nr; i++) {
+		t = (const void *)s + i * stride;
+		total += lat_nr(t);
+	}
+	if (!total)
+		return;
+
+	all = calloc(total, sizeof(*all));
+	if (!all)
+		return;
+
+	for (i = 0, total = 0; i < nr; i++) {
+		t = (const void *)s + i * stride;
+		n = lat_nr(t);
+		memcpy(all + total, t->v, n * sizeof(*all));
+		total += n;
+	}
+	qsort(all, total, sizeof(*all), lat_cmp);
+
+	printf("Latency per %s (ns):", what);
+	for (i = 0; i < ARRAY_SIZE(pcts); i++)
+		printf(" p%g=%" PRIu64, pcts[i],
+		       all[(size_t)(pcts[i] / 100 * (total - 1))]);
+	printf(" max=%" PRIu64 "\n", all[total - 1]);
+	free(all);
+}
+
+#endif /* _BENCH_LATENCY_H */
@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * mm: drive the kernel allocators from user space
+ *
+ *  page-alloc: mmap + populate + munmap of 2^order pages, i.e. the page
+ *              allocator and the per-cpu page lists (optionally THP)
+ *  slab:       open + close of /dev/null in batches, i.e. kmem_cache
+ *              alloc/free of struct file
+ *  vmalloc:    create + close of a BPF array map larger than what goes to
+ *              kmalloc, i.e. vmalloc/vfree (needs CAP_BPF)
+ *
+ * All of them run from N threads spread over the online CPUs, and so over
+ * the nodes, and report ops/sec plus latency percentiles of a single op.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <linux/bpf.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <perf/cpumap.h>
+
+#include "../util/mutex.h"
+#include "../util/stat.h"
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "latency.h"
+
+#include <err.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE	23
+#endif
+
+#define MM_THP_SIZE		(2UL << 20)
+
+struct bench_mm_parameters {
+	unsigned int nthreads;
+	unsigned int runtime;
+	unsigned int order;
+	unsigned int batch;
+	unsigned int size;	/* KiB */
+	unsigned int samples;
+	bool thp;
+	bool silent;
+};
+
+static struct bench_mm_parameters params = {
+	.runtime = 5,
+	.batch = 1,
+	.size = 64,
+	.samples = 10000,
+};
+
+struct worker {
+	int tid;
+	pthread_t thread;
+	unsigned long ops;
+	unsigned long errors;
+	struct lat_samples lat;		/* ns per op */
+	int *fds;
+};
+
+/* one op, returns the number of allocations it did or -1 */
+typedef int (*mm_op_t)(struct worker *w);
+
+static volatile bool done;
+static struct timeval start, end, runtime;
+static struct mutex thread_lock;
+static unsigned int threads_starting;
+static struct cond thread_parent, thread_worker;
+static size_t page_size;
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &params.nthreads, "Specify amount of threads (default: online CPUs)"),
+	OPT_UINTEGER('r', "runtime", &params.runtime, "Specify runtime (in seconds)"),
+	OPT_UINTEGER('o', "order", &params.order, "page-alloc: 2^order pages per op"),
+	OPT_BOOLEAN( 'H', "thp", &params.thp, "page-alloc: use transparent huge pages"),
+	OPT_UINTEGER('b', "batch", &params.batch, "slab: objects allocated before freeing them"),
+	OPT_UINTEGER('S', "size", &params.size, "vmalloc: KiB per allocation"),
+	OPT_UINTEGER('n', "samples", &params.samples, "Latency samples kept per thread"),
+	OPT_BOOLEAN( 's', "silent", &params.silent, "Silent mode: do not display per thread data"),
+	OPT_END()
+};
+
+static const char * const bench_mm_page_alloc_usage[] = {
+	"perf bench mm page-alloc <options>",
+	NULL
+};
+
+static const char * const bench_mm_slab_usage[] = {
+	"perf bench mm slab <options>",
+	NULL
+};
+
+static const char * const bench_mm_vmalloc_usage[] = {
+	"perf bench mm vmalloc <options>",
+	NULL
+};
+
+static int mm_page_alloc_op(struct worker *w __maybe_unused)
+{
+	size_t len = page_size << params.order;
+	size_t map_len = params.thp ? len + MM_THP_SIZE : len;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	char *map, *p;
+
+	if (!params.thp)
+		flags |= MAP_POPULATE;
+
+	map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (map == MAP_FAILED)
+		return -1;
+
+	if (params.thp) {
+		/* MAP_POPULATE would fault before the madvise */
+		p = (char *)(((unsigned long)map + MM_THP_SIZE - 1) & ~(MM_THP_SIZE - 1));
+		madvise(p, len, MADV_HUGEPAGE);
+		if (madvise(p, len, MADV_POPULATE_WRITE))
+			memset(p, 0, len);
+	}
+
+	munmap(map, map_len);
+	return 1;
+}
+
+static int mm_slab_op(struct worker *w)
+{
+	unsigned int i, n;
+
+	for (n = 0; n < params.batch; n++) {
+		w->fds[n] = open("/dev/null", O_RDONLY);
+		if (w->fds[n] < 0)
+			break;
+	}
+	for (i = 0; i < n; i++)
+		close(w->fds[i]);
+
+	return n == params.batch ? (int)n : -1;
+}
+
+static int mm_vmalloc_op(struct worker *w __maybe_unused)
+{
+	union bpf_attr attr;
+	int fd;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_ARRAY;
+	attr.key_size = sizeof(u32);
+	attr.value_size = 1024;
+	attr.max_entries = params.size;
+
+	fd = syscall(__NR_bpf, BPF_MAP_CREATE, &attr, sizeof(attr));
+	if (fd < 0)
+		return -1;
+
+	close(fd);
+	return 1;
+}
+
+static mm_op_t mm_op;
+
+static void *workerfn(void *arg)
+{
+	struct worker *w = (struct worker *)arg;
+	unsigned long ops = 0, errors = 0;
+	u64 t0, t1;
+	int n;
+
+	mutex_lock(&thread_lock);
+	threads_starting--;
+	if (!threads_starting)
+		cond_signal(&thread_parent);
+	cond_wait(&thread_worker, &thread_lock);
+	mutex_unlock(&thread_lock);
+
+	do {
+		t0 = lat_now_ns();
+		n = mm_op(w);
+		t1 = lat_now_ns();
+		if (n < 0) {
+			errors++;
+			continue;
+		}
+		ops += n;
+		lat_add(&w->lat, (t1 - t0) / n);
+	} while (!done);
+
+	w->ops = ops;
+	w->errors = errors;
+	return NULL;
+}
+
+static void toggle_done(int sig __maybe_unused,
+			siginfo_t *info __maybe_unused,
+			void *uc __maybe_unused)
+{
+	done = true;
+	gettimeofday(&end, NULL);
+	timersub(&end, &start, &runtime);
+}
+
+static int bench_mm_run(int argc, const char **argv, const char * const *usage,
+			mm_op_t op, const char *what)
+{
+	struct perf_cpu_map *cpu;
+	struct stats throughput_stats;
+	struct worker *worker;
+	pthread_attr_t thread_attr;
+	struct sigaction act;
+	unsigned long errors = 0;
+	cpu_set_t *cpuset;
+	unsigned int i;
+	int ret, nrcpus;
+	size_t size;
+
+	argc = parse_options(argc, argv, options, usage, 0);
+	if (argc || !params.batch || !params.size) {
+		usage_with_options(usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	mm_op = op;
+
+	cpu = perf_cpu_map__new_online_cpus();
+	if (!cpu)
+		err(EXIT_FAILURE, "perf_cpu_map__new_online_cpus");
+
+	memset(&act, 0, sizeof(act));
+	sigfillset(&act.sa_mask);
+	act.sa_sigaction = toggle_done;
+	sigaction(SIGINT, &act, NULL);
+
+	if (!params.nthreads) /* default to the number of CPUs */
+		params.nthreads = perf_cpu_map__nr(cpu);
+
+	worker = calloc(params.nthreads, sizeof(*worker));
+	if (!worker)
+		err(EXIT_FAILURE, "calloc");
+
+	printf("Run summary [PID %d]: %d threads doing %s for %d secs.\n\n",
+	       getpid(), params.nthreads, what, params.runtime);
+
+	init_stats(&throughput_stats);
+	mutex_init(&thread_lock);
+	cond_init(&thread_parent);
+	cond_init(&thread_worker);
+
+	threads_starting = params.nthreads;
+	pthread_attr_init(&thread_attr);
+
+	nrcpus = perf_cpu_map__nr(cpu);
+	cpuset = CPU_ALLOC(nrcpus);
+	BUG_ON(!cpuset);
+	size = CPU_ALLOC_SIZE(nrcpus);
+
+	for (i = 0; i < params.nthreads; i++) {
+		worker[i].tid = i;
+		worker[i].fds = calloc(params.batch, sizeof(int));
+		if (lat_init(&worker[i].lat, params.samples, i + 1) || !worker[i].fds)
+			err(EXIT_FAILURE, "calloc");
+
+		CPU_ZERO_S(size, cpuset);
+		CPU_SET_S(perf_cpu_map__cpu(cpu, i % nrcpus).cpu, size, cpuset);
+		ret = pthread_attr_setaffinity_np(&thread_attr, size, cpuset);
+		if (ret) {
+			CPU_FREE(cpuset);
+			err(EXIT_FAILURE, "pthread_attr_setaffinity_np");
+		}
+		ret = pthread_create(&worker[i].thread, &thread_attr, workerfn,
+				     &worker[i]);
+		if (ret) {
+			CPU_FREE(cpuset);
+			err(EXIT_FAILURE, "pthread_create");
+		}
+	}
+	CPU_FREE(cpuset);
+	pthread_attr_destroy(&thread_attr);
+
+	mutex_lock(&thread_lock);
+	while (threads_starting)
+		cond_wait(&thread_parent, &thread_lock);
+	gettimeofday(&start, NULL);
+	cond_broadcast(&thread_worker);
+	mutex_unlock(&thread_lock);
+
+	sleep(params.runtime);
+	toggle_done(0, NULL, NULL);
+
+	for (i = 0; i < params.nthreads; i++) {
+		ret = pthread_join(worker[i].thread, NULL);
+		if (ret)
+			err(EXIT_FAILURE, "pthread_join");
+	}
+
+	cond_destroy(&thread_parent);
+	cond_destroy(&thread_worker);
+	mutex_destroy(&thread_lock);
+
+	for (i = 0; i < params.nthreads; i++) {
+		unsigned long t = runtime.tv_sec > 0 ?
+			worker[i].ops / runtime.tv_sec : 0;
+
+		update_stats(&throughput_stats, t);
+		errors += worker[i].errors;
+		if (!params.silent)
+			printf("[thread %3d] %ld ops/sec, %ld errors\n",
+			       worker[i].tid, t, worker[i].errors);
+	}
+
+	printf("%sAveraged %.0f operations/sec per thread (+- %.2f%%), total secs = %d\n",
+	       !params.silent ? "\n" : "", avg_stats(&throughput_stats),
+	       rel_stddev_stats(stddev_stats(&throughput_stats),
+				avg_stats(&throughput_stats)),
+	       (int)runtime.tv_sec);
+	if (errors)
+		printf("%lu failed ops (%s)\n", errors, strerror(errno));
+	lat_print("op", &worker[0].lat, params.nthreads, sizeof(*worker));
+
+	for (i = 0; i < params.nthreads; i++) {
+		lat_exit(&worker[i].lat);
+		free(worker[i].fds);
+	}
+	free(worker);
+	perf_cpu_map__put(cpu);
+	return 0;
+}
+
+int bench_mm_page_alloc(int argc, const char **argv)
+{
+	return bench_mm_run(argc, argv, bench_mm_page_alloc_usage,
+			    mm_page_alloc_op, "page allocation");
+}
+
+int bench_mm_slab(int argc, const char **argv)
+{
+	return bench_mm_run(argc, argv, bench_mm_slab_usage, mm_slab_op,
+			    "kmem_cache allocation");
+}
+
+int bench_mm_vmalloc(int argc, const char **argv)
+{
+	return bench_mm_run(argc, argv, bench_mm_vmalloc_usage, mm_vmalloc_op,
+			    "vmalloc");
+}
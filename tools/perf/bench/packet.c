@@ -0,0 +1,518 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * packet: packets per second through the loopback device with the mmap()ed
+ * packet interfaces
+ *
+ *  tpacket: a PACKET_TX_RING socket transmits on lo, the frames come back
+ *           through the stack into a PACKET_RX_RING socket
+ *  xsk:     an AF_XDP socket in copy mode transmits on lo, the frames come
+ *           back through generic XDP and an XSKMAP redirect into the same
+ *           socket's RX ring
+ *
+ * Frames carry their transmit time and an experimental ethertype, so that
+ * the latency from queueing a frame on the TX ring until it is seen on the
+ * RX ring can be sampled and so that nothing else on lo is picked up. At
+ * most --depth frames are in flight; a frame which isn't back within a
+ * millisecond is counted as lost.
+ *
+ * One thread does both sides of the loop, busy polling the rings, as lo
+ * only has a single queue. Both need CAP_NET_RAW, xsk also CAP_BPF and
+ * CAP_NET_ADMIN for the XDP program.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <asm/barrier.h>
+#include <linux/bpf.h>
+#include <linux/compiler.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_packet.h>
+#include <linux/if_xdp.h>
+#include <linux/kernel.h>
+
+#include <subcmd/parse-options.h>
+#include "bench.h"
+#include "latency.h"
+
+#include <err.h>
+
+#ifndef AF_XDP
+#define AF_XDP			44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP			283
+#endif
+
+#define PKT_ETH_P		ETH_P_802_EX1
+#define PKT_LOST_NS		1000000ULL
+#define PKT_FRAME_SIZE		2048
+#define PKT_NR_FRAMES		4096
+#define PKT_RING_SIZE		2048
+
+static unsigned int nsecs = 5;
+static unsigned int size = 64;
+static unsigned int batch = 64;
+static unsigned int depth = 256;
+static unsigned int nsamples = 100000;
+
+static volatile bool done;
+
+struct pkt_stats {
+	unsigned long tx, rx, lost, errors;
+	unsigned int inflight;
+	u64 last_rx;
+	struct lat_samples lat;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('r', "runtime", &nsecs, "Specify runtime (in seconds)"),
+	OPT_UINTEGER('S', "size", &size, "Frame size in bytes"),
+	OPT_UINTEGER('b', "batch", &batch, "Frames queued per transmit kick"),
+	OPT_UINTEGER('d', "depth", &depth, "Frames in flight"),
+	OPT_UINTEGER('n', "samples", &nsamples, "Latency samples kept"),
+	OPT_END()
+};
+
+static const char * const bench_packet_usage[] = {
+	"perf bench packet <tpacket|xsk> <options>",
+	NULL
+};
+
+static void toggle_done(int sig __maybe_unused)
+{
+	done = true;
+}
+
+static void pkt_fill(void *data, u64 now)
+{
+	struct ethhdr *eth = data;
+
+	/* lo has an all zero address, so the frames are for us */
+	memset(data, 0, size);
+	eth->h_proto = htons(PKT_ETH_P);
+	memcpy(data + ETH_HLEN, &now, sizeof(now));
+}
+
+static void pkt_received(struct pkt_stats *st, const void *data,
+			 unsigned int len, u64 now)
+{
+	const struct ethhdr *eth = data;
+	u64 sent;
+
+	if (len < ETH_HLEN + sizeof(sent) || eth->h_proto != htons(PKT_ETH_P)) {
+		st->errors++;
+		return;
+	}
+
+	memcpy(&sent, data + ETH_HLEN, sizeof(sent));
+	lat_add(&st->lat, now - sent);
+	st->rx++;
+	st->last_rx = now;
+	if (st->inflight)
+		st->inflight--;
+}
+
+/* How many frames may be queued now */
+static unsigned int pkt_budget(struct pkt_stats *st, u64 now)
+{
+	if (st->inflight && now - st->last_rx > PKT_LOST_NS) {
+		st->lost += st->inflight;
+		st->inflight = 0;
+	}
+	if (!st->inflight)
+		st->last_rx = now;
+
+	return min(batch, depth - st->inflight);
+}
+
+/* TPACKET_V2 rings, one frame per slot */
+struct tpacket_ring {
+	int fd;
+	void *map;
+	size_t map_sz;
+	unsigned int nr, cur;
+};
+
+static int tpacket_ring_setup(struct tpacket_ring *r, int proto, int ring,
+			      int ifindex)
+{
+	struct tpacket_req req = {
+		.tp_block_size	= PKT_RING_SIZE * PKT_FRAME_SIZE / 64,
+		.tp_block_nr	= 64,
+		.tp_frame_size	= PKT_FRAME_SIZE,
+		.tp_frame_nr	= PKT_RING_SIZE,
+	};
+	struct sockaddr_ll sll = {
+		.sll_family	= AF_PACKET,
+		.sll_protocol	= proto,
+		.sll_ifindex	= ifindex,
+	};
+	int ver = TPACKET_V2, one = 1;
+
+	r->fd = socket(AF_PACKET, SOCK_RAW, proto);
+	if (r->fd < 0)
+		return -1;
+
+	if (setsockopt(r->fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver)) ||
+	    setsockopt(r->fd, SOL_PACKET, ring, &req, sizeof(req)))
+		return -1;
+	/* the receiver would see every frame on its way out, too */
+	if (ring == PACKET_RX_RING &&
+	    setsockopt(r->fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one)))
+		return -1;
+
+	r->map_sz = (size_t)req.tp_block_size * req.tp_block_nr;
+	r->map = mmap(NULL, r->map_sz, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, r->fd, 0);
+	if (r->map == MAP_FAILED)
+		return -1;
+	r->nr = req.tp_frame_nr;
+	r->cur = 0;
+
+	return bind(r->fd, (struct sockaddr *)&sll, sizeof(sll));
+}
+
+static struct tpacket2_hdr *tpacket_frame(struct tpacket_ring *r, unsigned int i)
+{
+	return r->map + (size_t)i * PKT_FRAME_SIZE;
+}
+
+static void bench_tpacket_run(struct pkt_stats *st, int ifindex)
+{
+	const size_t tx_off = TPACKET_ALIGN(sizeof(struct tpacket2_hdr));
+	struct tpacket_ring tx, rx;
+	struct tpacket2_hdr *hdr;
+	unsigned int n, i;
+	u64 now, end;
+
+	if (tpacket_ring_setup(&tx, 0, PACKET_TX_RING, ifindex))
+		err(EXIT_FAILURE, "PACKET_TX_RING");
+	if (tpacket_ring_setup(&rx, htons(PKT_ETH_P), PACKET_RX_RING, ifindex))
+		err(EXIT_FAILURE, "PACKET_RX_RING");
+
+	now = lat_now_ns();
+	end = now + nsecs * 1000000000ULL;
+	st->last_rx = now;
+
+	while (!done && now < end) {
+		n = pkt_budget(st, now);
+		for (i = 0; i < n; i++) {
+			hdr = tpacket_frame(&tx, tx.cur);
+			if (READ_ONCE(hdr->tp_status) != TP_STATUS_AVAILABLE)
+				break;
+			pkt_fill((void *)hdr + tx_off, lat_now_ns());
+			hdr->tp_len = size;
+			smp_store_release(&hdr->tp_status, TP_STATUS_SEND_REQUEST);
+			tx.cur = (tx.cur + 1) % tx.nr;
+		}
+		if (i) {
+			if (send(tx.fd, NULL, 0, MSG_DONTWAIT) < 0 && errno != EAGAIN)
+				st->errors++;
+			st->tx += i;
+			st->inflight += i;
+		}
+
+		for (;;) {
+			hdr = tpacket_frame(&rx, rx.cur);
+			if (!(smp_load_acquire(&hdr->tp_status) & TP_STATUS_USER))
+				break;
+			now = lat_now_ns();
+			pkt_received(st, (void *)hdr + hdr->tp_mac, hdr->tp_snaplen, now);
+			smp_store_release(&hdr->tp_status, TP_STATUS_KERNEL);
+			rx.cur = (rx.cur + 1) % rx.nr;
+		}
+		now = lat_now_ns();
+	}
+
+	munmap(tx.map, tx.map_sz);
+	munmap(rx.map, rx.map_sz);
+	close(tx.fd);
+	close(rx.fd);
+}
+
+/* AF_XDP producer/consumer rings */
+struct xsk_ring {
+	u32 *producer, *consumer, *flags;
+	void *desc;
+	void *map;
+	size_t map_sz;
+	u32 mask;
+};
+
+static int xsk_ring_map(struct xsk_ring *r, int fd, const struct xdp_ring_offset *off,
+			size_t desc_sz, off_t pgoff)
+{
+	r->map_sz = off->desc + PKT_RING_SIZE * desc_sz;
+	r->map = mmap(NULL, r->map_sz, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, fd, pgoff);
+	if (r->map == MAP_FAILED)
+		return -1;
+
+	r->producer = r->map + off->producer;
+	r->consumer = r->map + off->consumer;
+	r->flags = r->map + off->flags;
+	r->desc = r->map + off->desc;
+	r->mask = PKT_RING_SIZE - 1;
+	return 0;
+}
+
+static long sys_bpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/*
+ * Redirect our frames to the socket bound to the receive queue, let
+ * everything else through.
+ */
+static int xsk_attach_prog(int xsk, int ifindex, int *map_fd)
+{
+	union bpf_attr attr;
+	int prog_fd, link_fd;
+	u32 key = 0, val = xsk;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(u32);
+	attr.value_size = sizeof(u32);
+	attr.max_entries = 1;
+	*map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+	if (*map_fd < 0)
+		return -1;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = *map_fd;
+	attr.key = (unsigned long)&key;
+	attr.value = (unsigned long)&val;
+	if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr))
+		return -1;
+
+	{
+		struct bpf_insn insns[] = {
+			BPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, data)),
+			BPF_LDX_MEM(BPF_W, BPF_REG_3, BPF_REG_1, offsetof(struct xdp_md, data_end)),
+			BPF_MOV64_REG(BPF_REG_4, BPF_REG_2),
+			BPF_ALU64_IMM(BPF_ADD, BPF_REG_4, ETH_HLEN),
+			BPF_JMP_REG(BPF_JGT, BPF_REG_4, BPF_REG_3, 8),
+			BPF_LDX_MEM(BPF_H, BPF_REG_4, BPF_REG_2, offsetof(struct ethhdr, h_proto)),
+			BPF_JMP_IMM(BPF_JNE, BPF_REG_4, htons(PKT_ETH_P), 6),
+			BPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, rx_queue_index)),
+			BPF_LD_MAP_FD(BPF_REG_1, *map_fd),
+			BPF_MOV64_IMM(BPF_REG_3, XDP_PASS),
+			BPF_EMIT_CALL(BPF_FUNC_redirect_map),
+			BPF_EXIT_INSN(),
+			BPF_MOV64_IMM(BPF_REG_0, XDP_PASS),
+			BPF_EXIT_INSN(),
+		};
+
+		memset(&attr, 0, sizeof(attr));
+		attr.prog_type = BPF_PROG_TYPE_XDP;
+		attr.insns = (unsigned long)insns;
+		attr.insn_cnt = ARRAY_SIZE(insns);
+		attr.license = (unsigned long)"GPL";
+		prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+		if (prog_fd < 0)
+			return -1;
+	}
+
+	/* the link detaches the program when we exit */
+	memset(&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = prog_fd;
+	attr.link_create.target_ifindex = ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+	link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+	close(prog_fd);
+	return link_fd;
+}
+
+static void bench_xsk_run(struct pkt_stats *st, int ifindex)
+{
+	struct xsk_ring fill, comp, rx, tx;
+	struct xdp_mmap_offsets off;
+	struct xdp_umem_reg mr;
+	struct sockaddr_xdp sxdp = {
+		.sxdp_family	= AF_XDP,
+		.sxdp_ifindex	= ifindex,
+		.sxdp_queue_id	= 0,
+		.sxdp_flags	= XDP_COPY | XDP_USE_NEED_WAKEUP,
+	};
+	int fd, map_fd, link_fd, ring_sz = PKT_RING_SIZE;
+	u64 *free_frames, now, end;
+	unsigned int nr_free = 0, n, i;
+	socklen_t optlen = sizeof(off);
+	u32 prod, cons;
+	size_t umem_sz;
+	void *umem;
+
+	fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (fd < 0)
+		err(EXIT_FAILURE, "AF_XDP socket");
+
+	umem_sz = (size_t)PKT_NR_FRAMES * PKT_FRAME_SIZE;
+	umem = mmap(NULL, umem_sz, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	free_frames = calloc(PKT_NR_FRAMES, sizeof(*free_frames));
+	if (umem == MAP_FAILED || !free_frames)
+		err(EXIT_FAILURE, "umem");
+
+	memset(&mr, 0, sizeof(mr));
+	mr.addr = (unsigned long)umem;
+	mr.len = umem_sz;
+	mr.chunk_size = PKT_FRAME_SIZE;
+	if (setsockopt(fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) ||
+	    setsockopt(fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_sz, sizeof(ring_sz)) ||
+	    setsockopt(fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_sz, sizeof(ring_sz)) ||
+	    setsockopt(fd, SOL_XDP, XDP_RX_RING, &ring_sz, sizeof(ring_sz)) ||
+	    setsockopt(fd, SOL_XDP, XDP_TX_RING, &ring_sz, sizeof(ring_sz)) ||
+	    getsockopt(fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen))
+		err(EXIT_FAILURE, "AF_XDP rings");
+
+	if (xsk_ring_map(&fill, fd, &off.fr, sizeof(u64), XDP_UMEM_PGOFF_FILL_RING) ||
+	    xsk_ring_map(&comp, fd, &off.cr, sizeof(u64), XDP_UMEM_PGOFF_COMPLETION_RING) ||
+	    xsk_ring_map(&rx, fd, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) ||
+	    xsk_ring_map(&tx, fd, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING))
+		err(EXIT_FAILURE, "AF_XDP mmap");
+
+	/* the first half of the frames receives, the second half transmits */
+	for (i = 0; i < PKT_RING_SIZE; i++)
+		((u64 *)fill.desc)[i] = (u64)i * PKT_FRAME_SIZE;
+	smp_store_release(fill.producer, PKT_RING_SIZE);
+	for (i = PKT_RING_SIZE; i < PKT_NR_FRAMES; i++)
+		free_frames[nr_free++] = (u64)i * PKT_FRAME_SIZE;
+
+	if (bind(fd, (struct sockaddr *)&sxdp, sizeof(sxdp)))
+		err(EXIT_FAILURE, "AF_XDP bind");
+	link_fd = xsk_attach_prog(fd, ifindex, &map_fd);
+	if (link_fd < 0)
+		err(EXIT_FAILURE, "XDP program");
+
+	now = lat_now_ns();
+	end = now + nsecs * 1000000000ULL;
+	st->last_rx = now;
+
+	while (!done && now < end) {
+		/* transmitted frames can be reused */
+		cons = *comp.consumer;
+		prod = smp_load_acquire(comp.producer);
+		for (; cons != prod; cons++)
+			free_frames[nr_free++] = ((u64 *)comp.desc)[cons & comp.mask];
+		smp_store_release(comp.consumer, cons);
+
+		prod = *tx.producer;
+		n = min(pkt_budget(st, now), nr_free);
+		n = min(n, PKT_RING_SIZE - (prod - smp_load_acquire(tx.consumer)));
+		for (i = 0; i < n; i++) {
+			struct xdp_desc *d = tx.desc + ((prod + i) & tx.mask) * sizeof(*d);
+
+			d->addr = free_frames[--nr_free];
+			d->len = size;
+			d->options = 0;
+			pkt_fill(umem + d->addr, lat_now_ns());
+		}
+		if (n) {
+			smp_store_release(tx.producer, prod + n);
+			/* copy mode always needs a kick */
+			if (sendto(fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0 &&
+			    errno != EAGAIN && errno != EBUSY && errno != ENOBUFS)
+				st->errors++;
+			st->tx += n;
+			st->inflight += n;
+		}
+
+		/* every received frame goes straight back to the fill ring */
+		cons = *rx.consumer;
+		prod = smp_load_acquire(rx.producer);
+		n = 0;
+		for (; cons != prod; cons++, n++) {
+			struct xdp_desc *d = rx.desc + (cons & rx.mask) * sizeof(*d);
+			u32 fp = *fill.producer + n;
+
+			now = lat_now_ns();
+			pkt_received(st, umem + d->addr, d->len, now);
+			((u64 *)fill.desc)[fp & fill.mask] = d->addr;
+		}
+		if (n) {
+			smp_store_release(fill.producer, *fill.producer + n);
+			smp_store_release(rx.consumer, cons);
+		}
+		if (READ_ONCE(*fill.flags) & XDP_RING_NEED_WAKEUP)
+			recvfrom(fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+
+		now = lat_now_ns();
+	}
+
+	close(link_fd);
+	close(map_fd);
+	munmap(fill.map, fill.map_sz);
+	munmap(comp.map, comp.map_sz);
+	munmap(rx.map, rx.map_sz);
+	munmap(tx.map, tx.map_sz);
+	close(fd);
+	munmap(umem, umem_sz);
+	free(free_frames);
+}
+
+static int bench_packet(int argc, const char **argv, const char *name,
+			void (*run)(struct pkt_stats *st, int ifindex))
+{
+	struct pkt_stats st;
+	double secs;
+	int ifindex;
+	u64 start;
+
+	argc = parse_options(argc, argv, options, bench_packet_usage, 0);
+	if (argc || !batch || !depth || !nsecs ||
+	    size < ETH_HLEN + sizeof(u64) || size > PKT_FRAME_SIZE - XDP_PACKET_HEADROOM) {
+		usage_with_options(bench_packet_usage, options);
+		exit(EXIT_FAILURE);
+	}
+
+	ifindex = if_nametoindex("lo");
+	if (!ifindex)
+		err(EXIT_FAILURE, "lo");
+
+	memset(&st, 0, sizeof(st));
+	if (lat_init(&st.lat, nsamples, 1))
+		err(EXIT_FAILURE, "calloc");
+
+	signal(SIGINT, toggle_done);
+
+	printf("Run summary [PID %d]: %s loopback of %u byte frames, %u in flight, for %d secs.\n\n",
+	       getpid(), name, size, depth, nsecs);
+
+	start = lat_now_ns();
+	run(&st, ifindex);
+	secs = (lat_now_ns() - start) / 1e9;
+
+	printf("Transmitted %lu frames: %.0f pps\n", st.tx, st.tx / secs);
+	printf("Received    %lu frames: %.0f pps\n", st.rx, st.rx / secs);
+	if (st.lost || st.errors)
+		printf("Lost %lu frames, %lu errors\n", st.lost, st.errors);
+	lat_print("frame", &st.lat, 1, sizeof(st));
+
+	lat_exit(&st.lat);
+	return 0;
+}
+
+int bench_packet_tpacket(int argc, const char **argv)
+{
+	return bench_packet(argc, argv, "TPACKET_V2", bench_tpacket_run);
+}
+
+int bench_packet_xsk(int argc, const char **argv)
+{
+	return bench_packet(argc, argv, "AF_XDP", bench_xsk_run);
+}
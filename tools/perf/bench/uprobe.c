@@ -15,6 +15,7 @@
 #include <linux/time64.h>
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -24,6 +25,8 @@
 
 #define LOOPS_DEFAULT 1000
 static int loops = LOOPS_DEFAULT;
+static unsigned int nr_threads = 1;
+static unsigned int sleep_usecs = USEC_PER_MSEC;
 
 enum bench_uprobe {
 	BENCH_UPROBE__BASELINE,
@@ -35,6 +38,8 @@ enum bench_uprobe {
 
 static const struct option options[] = {
 	OPT_INTEGER('l', "loop",	&loops,		"Specify number of loops"),
+	OPT_UINTEGER('t', "threads",	&nr_threads,	"Specify number of threads hitting the probe concurrently"),
+	OPT_UINTEGER('s', "sleep",	&sleep_usecs,	"Specify the usleep() argument, 0 to measure the probe overhead"),
 	OPT_END()
 };
 
@@ -143,25 +148,59 @@ static int bench_uprobe_format__default_fprintf(const char *name, const char *un
 	return printed + 1;
 }
 
+static void *bench_uprobe__thread(void *arg __maybe_unused)
+{
+	int i;
+
+	for (i = 0; i < loops; i++)
+		usleep(sleep_usecs);
+
+	return NULL;
+}
+
 static int bench_uprobe(int argc, const char **argv, enum bench_uprobe bench)
 {
-	const char *name = "usleep(1000)", *unit = "usec";
+	const char *unit = "usec";
 	struct timespec start, end;
+	pthread_t *threads;
+	char name[64];
+	unsigned int i;
 	u64 diff;
-	int i;
 
 	argc = parse_options(argc, argv, options, bench_uprobe_usage, 0);
 
-	if (bench != BENCH_UPROBE__BASELINE && bench_uprobe__setup_bpf_skel(bench) < 0)
+	if (!nr_threads)
+		nr_threads = 1;
+	threads = calloc(nr_threads, sizeof(*threads));
+	if (!threads)
+		return -1;
+
+	if (nr_threads > 1)
+		snprintf(name, sizeof(name), "usleep(%u) x %u threads", sleep_usecs, nr_threads);
+	else
+		snprintf(name, sizeof(name), "usleep(%u)", sleep_usecs);
+
+	if (bench != BENCH_UPROBE__BASELINE && bench_uprobe__setup_bpf_skel(bench) < 0) {
+		free(threads);
 		return 0;
+	}
 
-        clock_gettime(CLOCK_REALTIME, &start);
+	clock_gettime(CLOCK_REALTIME, &start);
 
-	for (i = 0; i < loops; i++) {
-		usleep(USEC_PER_MSEC);
+	/* the first one runs here, the others hammer the probe concurrently */
+	for (i = 1; i < nr_threads; i++) {
+		if (pthread_create(&threads[i], NULL, bench_uprobe__thread, NULL)) {
+			fprintf(stderr, "Failed to create thread %u\n", i);
+			nr_threads = i;
+			break;
+		}
 	}
+	bench_uprobe__thread(NULL);
+	for (i = 1; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
 
 	clock_gettime(CLOCK_REALTIME, &end);
+	free(threads);
 
 	diff = end.tv_sec * NSEC_PER_SEC + end.tv_nsec - (start.tv_sec * NSEC_PER_SEC + start.tv_nsec);
 	diff /= NSEC_PER_USEC;